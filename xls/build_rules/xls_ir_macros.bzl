@@ -255,11 +255,15 @@ def xls_ir_cc_library_macro(
         ],
         # The XLS AOT compiler does not currently support cross-compilation.
         deps = [
+            "@com_google_absl//absl/memory",
+            "@com_google_absl//absl/status",
             "@com_google_absl//absl/status:statusor",
             "@com_google_absl//absl/types:span",
             "//xls/ir:events",
             "//xls/ir:value",
             "//xls/jit:aot_runtime",
             "//xls/jit:type_layout",
+            # Kernels called by the lowering of wide arithmetic operations.
+            "//xls/jit:wide_arithmetic",
         ],
     )
@@ -195,6 +195,9 @@ def _optimize_ir(ctx, src):
         "opt_level",
         "convert_array_index_to_select",
         "inline_procs",
+        "opt_threads",
+        "input_format",
+        "output_format",
     )
 
     is_args_valid(opt_ir_args, IR_OPT_FLAGS)
@@ -319,6 +322,7 @@ def get_eval_ir_test_cmd(ctx, src, append_cmd_line_args = True):
         "test_llvm_jit",
         "llvm_opt_level",
         "test_only_inject_jit_result",
+        "input_format",
     )
 
     ir_eval_args = append_default_to_args(
@@ -394,6 +398,7 @@ def get_benchmark_ir_cmd(ctx, src, append_cmd_line_args = True):
         "show_known_bits",
         "delay_model",
         "convert_array_index_to_select",
+        "input_format",
     )
 
     benchmark_ir_args = append_default_to_args(
@@ -0,0 +1,94 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/file/mapped_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/file/file_descriptor.h"
+#include "xls/common/status/error_code_to_status.h"
+
+namespace xls {
+namespace {
+
+absl::Status ErrNoToStatusWithFilename(int errno_value,
+                                       const std::filesystem::path& path) {
+  xabsl::StatusBuilder builder = ErrnoToStatus(errno_value);
+  builder << path.string();
+  return std::move(builder);
+}
+
+}  // namespace
+
+/* static */
+absl::StatusOr<MappedFile> MappedFile::Open(const std::filesystem::path& path) {
+  FileDescriptor fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd.get() == -1) {
+    return ErrNoToStatusWithFilename(errno, path);
+  }
+  struct stat stat_buf;
+  if (fstat(fd.get(), &stat_buf) != 0) {
+    return ErrNoToStatusWithFilename(errno, path);
+  }
+  if (!S_ISREG(stat_buf.st_mode)) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("Cannot map a file which is not a regular file: ",
+                     path.string()));
+  }
+  if (stat_buf.st_size == 0) {
+    return MappedFile(nullptr, 0);
+  }
+  void* data = mmap(nullptr, stat_buf.st_size, PROT_READ, MAP_PRIVATE,
+                    fd.get(), /*offset=*/0);
+  if (data == MAP_FAILED) {
+    return ErrNoToStatusWithFilename(errno, path);
+  }
+  // The contents are read front to back.
+  madvise(data, stat_buf.st_size, MADV_SEQUENTIAL);
+  // The mapping stays valid after the file descriptor is closed.
+  return MappedFile(data, stat_buf.st_size);
+}
+
+MappedFile::~MappedFile() { Unmap(); }
+
+MappedFile::MappedFile(MappedFile&& other)
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+  if (this != &other) {
+    Unmap();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+void MappedFile::Unmap() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+}  // namespace xls
@@ -0,0 +1,61 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_FILE_MAPPED_FILE_H_
+#define XLS_COMMON_FILE_MAPPED_FILE_H_
+
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <string_view>
+
+#include "absl/status/statusor.h"
+
+namespace xls {
+
+// A read-only memory mapping of the contents of a file. The contents are paged
+// in by the operating system on demand so large files can be processed without
+// first copying them into memory. The mapping is released on destruction.
+class MappedFile {
+ public:
+  // Maps the contents of the file at the given path. Returns a
+  // FailedPrecondition error if the path does not name a regular file (e.g., a
+  // pipe) as those cannot be mapped.
+  static absl::StatusOr<MappedFile> Open(const std::filesystem::path& path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other);
+  MappedFile& operator=(MappedFile&& other);
+
+  // Returns the contents of the file. The view is valid for the lifetime of
+  // this object.
+  std::string_view contents() const {
+    return std::string_view(static_cast<const char*>(data_), size_);
+  }
+
+ private:
+  MappedFile(void* data, int64_t size) : data_(data), size_(size) {}
+
+  void Unmap();
+
+  // Null if the file is empty (empty files cannot be mapped).
+  void* data_ = nullptr;
+  int64_t size_ = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_FILE_MAPPED_FILE_H_
@@ -0,0 +1,58 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/file/mapped_file.h"
+
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+TEST(MappedFileTest, MapsContents) {
+  std::string content = "The quick brown fox\njumps over the lazy dog\n";
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent(content));
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile mapped,
+                           MappedFile::Open(temp_file.path()));
+  EXPECT_EQ(mapped.contents(), content);
+
+  // The mapping moves with the object.
+  MappedFile moved = std::move(mapped);
+  EXPECT_EQ(moved.contents(), content);
+}
+
+TEST(MappedFileTest, EmptyFile) {
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file, TempFile::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(MappedFile mapped,
+                           MappedFile::Open(temp_file.path()));
+  EXPECT_TRUE(mapped.contents().empty());
+}
+
+TEST(MappedFileTest, NonexistentFile) {
+  EXPECT_THAT(
+      MappedFile::Open("/does/not/exist"),
+      StatusIs(absl::StatusCode::kNotFound, HasSubstr("/does/not/exist")));
+}
+
+}  // namespace
+}  // namespace xls
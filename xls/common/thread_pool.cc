@@ -0,0 +1,91 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "absl/synchronization/blocking_counter.h"
+
+namespace xls {
+
+ThreadPool::ThreadPool(int64_t thread_count) {
+  for (int64_t i = 0; i < std::max<int64_t>(thread_count, 1); ++i) {
+    threads_.push_back(std::make_unique<Thread>([this]() { WorkerLoop(); }));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutdown_ = true;
+    work_available_.SignalAll();
+  }
+  for (std::unique_ptr<Thread>& thread : threads_) {
+    thread->Join();
+  }
+}
+
+void ThreadPool::Schedule(std::function<void()> fn) {
+  absl::MutexLock lock(&mutex_);
+  work_.push_back(std::move(fn));
+  work_available_.Signal();
+}
+
+void ThreadPool::ParallelFor(int64_t count,
+                             const std::function<void(int64_t)>& fn) {
+  if (count <= 0) {
+    return;
+  }
+  // Each participant claims indices from a shared counter so uneven work is
+  // balanced across threads.
+  std::atomic<int64_t> next_index = 0;
+  auto run = [&]() {
+    for (int64_t i = next_index++; i < count; i = next_index++) {
+      fn(i);
+    }
+  };
+  int64_t helper_count = std::min<int64_t>(thread_count(), count - 1);
+  absl::BlockingCounter helpers_done(helper_count);
+  for (int64_t i = 0; i < helper_count; ++i) {
+    Schedule([&]() {
+      run();
+      helpers_done.DecrementCount();
+    });
+  }
+  run();
+  helpers_done.Wait();
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> fn;
+    {
+      absl::MutexLock lock(&mutex_);
+      while (!shutdown_ && work_.empty()) {
+        work_available_.Wait(&mutex_);
+      }
+      if (work_.empty()) {
+        return;
+      }
+      fn = std::move(work_.front());
+      work_.pop_front();
+    }
+    fn();
+  }
+}
+
+}  // namespace xls
@@ -0,0 +1,70 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_COMMON_THREAD_POOL_H_
+#define XLS_COMMON_THREAD_POOL_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread.h"
+
+namespace xls {
+
+// A fixed-size pool of worker threads which run scheduled closures. The
+// threads persist for the lifetime of the pool so work may be handed to them
+// repeatedly without paying for thread creation each time. ThreadPools are
+// thread-safe.
+class ThreadPool {
+ public:
+  // Creates a pool with `thread_count` worker threads (at least one).
+  explicit ThreadPool(int64_t thread_count);
+
+  // Waits for all scheduled closures to complete and joins the threads.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int64_t thread_count() const { return threads_.size(); }
+
+  // Schedules `fn` to run on one of the worker threads.
+  void Schedule(std::function<void()> fn);
+
+  // Calls `fn(i)` for each i in [0, count) and returns once all calls have
+  // completed. The calls run on the worker threads and the calling thread.
+  // Must not be called from a closure running on this pool.
+  void ParallelFor(int64_t count, const std::function<void(int64_t)>& fn);
+
+ private:
+  // Body of each worker thread. Runs closures until the pool is destroyed.
+  void WorkerLoop();
+
+  absl::Mutex mutex_;
+  // Signaled when work is scheduled or on shutdown.
+  absl::CondVar work_available_;
+  std::deque<std::function<void()>> work_ ABSL_GUARDED_BY(mutex_);
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::vector<std::unique_ptr<Thread>> threads_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_COMMON_THREAD_POOL_H_
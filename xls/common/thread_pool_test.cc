@@ -0,0 +1,57 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/common/thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/blocking_counter.h"
+
+namespace xls {
+namespace {
+
+TEST(ThreadPoolTest, ScheduleRunsAllClosures) {
+  std::atomic<int64_t> sum = 0;
+  {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.thread_count(), 4);
+    absl::BlockingCounter done(100);
+    for (int64_t i = 0; i < 100; ++i) {
+      pool.Schedule([&, i]() {
+        sum += i;
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+  }
+  EXPECT_EQ(sum, 4950);
+}
+
+TEST(ThreadPoolTest, ParallelForVisitsEachIndexOnce) {
+  ThreadPool pool(3);
+  // The pool is reused across calls.
+  for (int64_t count : {0, 1, 2, 10, 1000}) {
+    std::vector<std::atomic<int64_t>> visits(count);
+    pool.ParallelFor(count, [&](int64_t i) { ++visits[i]; });
+    for (int64_t i = 0; i < count; ++i) {
+      EXPECT_EQ(visits[i], 1) << "index " << i << " of " << count;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace xls
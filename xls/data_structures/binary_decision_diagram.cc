@@ -14,8 +14,12 @@
 
 #include "xls/data_structures/binary_decision_diagram.h"
 
+#include <algorithm>
 #include <limits>
+#include <tuple>
+#include <vector>
 
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -26,38 +30,86 @@
 #include "xls/common/logging/vlog_is_on.h"
 
 namespace xls {
+namespace {
 
-BinaryDecisionDiagram::BinaryDecisionDiagram() {
+// The minimum number of entries in the computed table.
+constexpr int64_t kMinIteCacheSize = 1024;
+
+// Sifting a variable in one direction stops once the BDD is this many percent
+// of the smallest size seen.
+constexpr int64_t kMaxSiftGrowthPercent = 120;
+
+// The reference count of free node slots.
+constexpr int32_t kFreeNode = -1;
+
+}  // namespace
+
+BinaryDecisionDiagram::BinaryDecisionDiagram(int64_t max_ite_cache_size)
+    : max_ite_cache_size_(max_ite_cache_size) {
+  XLS_CHECK_GT(max_ite_cache_size, 0);
   // Leaf node 0.
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
                            /*p=*/1));
   // Leaf node 1.
   nodes_.push_back(BddNode(BddVariable(-1), BddNodeIndex(-1), BddNodeIndex(-1),
                            /*p=*/1));
+  // The leaf nodes are never garbage.
+  ref_counts_ = {1, 1};
+  ResizeIteCache(/*clear=*/true);
+}
+
+int32_t BinaryDecisionDiagram::SumPathCounts(BddNodeIndex high,
+                                             BddNodeIndex low) const {
+  // Use int64s to avoid overflowing and saturate at INT32_MAX.
+  return std::min(
+      static_cast<int64_t>(GetNode(low).path_count) + GetNode(high).path_count,
+      static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
 }
 
 BddNodeIndex BinaryDecisionDiagram::GetOrCreateNode(BddVariable var,
                                                     BddNodeIndex high,
                                                     BddNodeIndex low) {
-  NodeKey key = std::make_tuple(var, high, low);
-  auto it = node_map_.find(key);
-  if (it != node_map_.end()) {
-    return it->second;
-  }
   if (low == high) {
     return low;
   }
+  absl::flat_hash_map<NodeKey, BddNodeIndex>& unique_table =
+      unique_tables_[var.value()];
+  NodeKey key = {high, low};
+  auto it = unique_table.find(key);
+  if (it != unique_table.end()) {
+    return it->second;
+  }
   // Compute the number of paths that the new node will have to the terminal
-  // nodes 0 and 1. Use int64s to avoid overflowing and saturate at INT32_MAX.
-  int32_t paths = std::min(
-      static_cast<int64_t>(GetNode(low).path_count) + GetNode(high).path_count,
-      static_cast<int64_t>(std::numeric_limits<int32_t>::max()));
-  nodes_.emplace_back(var, high, low, paths);
-  BddNodeIndex node_index = BddNodeIndex(nodes_.size() - 1);
-  node_map_[key] = node_index;
+  // nodes 0 and 1.
+  BddNode node(var, high, low, SumPathCounts(high, low));
+  BddNodeIndex node_index;
+  if (free_nodes_.empty()) {
+    node_index = BddNodeIndex(nodes_.size());
+    nodes_.push_back(node);
+    ref_counts_.push_back(0);
+  } else {
+    node_index = free_nodes_.back();
+    free_nodes_.pop_back();
+    nodes_[node_index.value()] = node;
+    ref_counts_[node_index.value()] = 0;
+  }
+  ++ref_counts_[high.value()];
+  ++ref_counts_[low.value()];
+  unique_table[key] = node_index;
+  if (2 * ite_cache_.size() <= max_ite_cache_size_ &&
+      size() > 2 * ite_cache_.size()) {
+    ResizeIteCache(/*clear=*/false);
+  }
   return node_index;
 }
 
+int64_t BinaryDecisionDiagram::GetNodeLevel(BddNodeIndex expr) const {
+  if (expr == zero() || expr == one()) {
+    return level_to_var_.size();
+  }
+  return GetVariableLevel(GetNode(expr).variable);
+}
+
 BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
                                              bool value) {
   if (expr == zero() || expr == one()) {
@@ -65,7 +117,7 @@ BddNodeIndex BinaryDecisionDiagram::Restrict(BddNodeIndex expr, BddVariable var,
   }
 
   const BddNode& node = GetNode(expr);
-  XLS_CHECK_LE(var, node.variable);
+  XLS_CHECK_LE(GetVariableLevel(var), GetNodeLevel(expr));
   if (node.variable == var) {
     return value ? node.high : node.low;
   }
@@ -87,25 +139,30 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
   if (if_true == if_false) {
     return if_true;
   }
-  auto key = std::make_tuple(cond, if_true, if_false);
-  auto it = ite_map_.find(key);
-  if (it != ite_map_.end()) {
-    return it->second;
+  auto cache_slot = [&]() -> IteCacheEntry& {
+    size_t hash = absl::Hash<std::tuple<BddNodeIndex, BddNodeIndex,
+                                        BddNodeIndex>>()(
+        std::make_tuple(cond, if_true, if_false));
+    return ite_cache_[hash & (ite_cache_.size() - 1)];
+  };
+  const IteCacheEntry& entry = cache_slot();
+  if (entry.cond == cond && entry.if_true == if_true &&
+      entry.if_false == if_false) {
+    return entry.result;
   }
 
-  // The expression is non-trivial and has not been computed before. Recursively
-  // decompose the expression by peeling away the first variable and performing
-  // a Shannon decomposition.
+  // The expression is non-trivial and has not been computed recently.
+  // Recursively decompose the expression by peeling away the first variable
+  // and performing a Shannon decomposition.
 
-  // First, find the lowest-index variable amongst all expressions. In all paths
-  // through the BDD the variable indices are strictly increasing.
+  // First, find the lowest-level variable amongst all expressions. In all
+  // paths through the BDD the variable levels are strictly increasing. Only
+  // non-leaf nodes (not zero or one) have associated variables.
   BddVariable min_var = GetNode(cond).variable;
-  // Only non-leaf nodes (not zero or one) have associated variables.
-  if (if_true != zero() && if_true != one()) {
-    min_var = std::min(min_var, GetNode(if_true).variable);
-  }
-  if (if_false != zero() && if_false != one()) {
-    min_var = std::min(min_var, GetNode(if_false).variable);
+  for (BddNodeIndex expr : {if_true, if_false}) {
+    if (GetNodeLevel(expr) < GetVariableLevel(min_var)) {
+      min_var = GetNode(expr).variable;
+    }
   }
 
   // Perform a Shannon expansion about the variable where Shannon expansion is
@@ -120,19 +177,241 @@ BddNodeIndex BinaryDecisionDiagram::IfThenElse(BddNodeIndex cond,
                                            Restrict(if_true, min_var, false),
                                            Restrict(if_false, min_var, false));
 
-  if (true_cofactor == false_cofactor) {
-    ite_map_[key] = true_cofactor;
-    return true_cofactor;
-  }
+  // GetOrCreateNode returns the cofactor if both are equal. The computed
+  // table may have been resized by the recursive calls so the slot is looked
+  // up again.
   BddNodeIndex expr = GetOrCreateNode(min_var, true_cofactor, false_cofactor);
-  ite_map_[key] = expr;
+  cache_slot() = IteCacheEntry{
+      .cond = cond, .if_true = if_true, .if_false = if_false, .result = expr};
   return expr;
 }
 
+void BinaryDecisionDiagram::ResizeIteCache(bool clear) {
+  int64_t target_size = std::max(size(), kMinIteCacheSize);
+  int64_t cache_size = 1;
+  while (cache_size < target_size && 2 * cache_size <= max_ite_cache_size_) {
+    cache_size *= 2;
+  }
+  std::vector<IteCacheEntry> old_cache(cache_size);
+  std::swap(ite_cache_, old_cache);
+  if (clear) {
+    return;
+  }
+  for (const IteCacheEntry& entry : old_cache) {
+    if (entry.cond != BddNodeIndex(-1)) {
+      size_t hash =
+          absl::Hash<std::tuple<BddNodeIndex, BddNodeIndex, BddNodeIndex>>()(
+              std::make_tuple(entry.cond, entry.if_true, entry.if_false));
+      ite_cache_[hash & (ite_cache_.size() - 1)] = entry;
+    }
+  }
+}
+
 BddNodeIndex BinaryDecisionDiagram::NewVariable() {
   BddVariable var = next_var_;
   ++next_var_;
-  return GetOrCreateNode(var, one(), zero());
+  unique_tables_.emplace_back();
+  var_to_level_.push_back(level_to_var_.size());
+  level_to_var_.push_back(var);
+  BddNodeIndex node = GetOrCreateNode(var, one(), zero());
+  // Variable base nodes are never garbage.
+  ++ref_counts_[node.value()];
+  base_nodes_.push_back(node);
+  return node;
+}
+
+void BinaryDecisionDiagram::IncRef(BddNodeIndex expr) {
+  XLS_CHECK_GE(ref_counts_.at(expr.value()), 0);
+  ++ref_counts_[expr.value()];
+}
+
+void BinaryDecisionDiagram::DecRef(BddNodeIndex expr) {
+  DecRefInternal(expr, /*free_garbage=*/false);
+}
+
+void BinaryDecisionDiagram::DecRefInternal(BddNodeIndex expr,
+                                           bool free_garbage) {
+  XLS_CHECK_GT(ref_counts_.at(expr.value()), 0);
+  if (--ref_counts_[expr.value()] == 0 && free_garbage) {
+    FreeNode(expr);
+  }
+}
+
+void BinaryDecisionDiagram::FreeNode(BddNodeIndex expr) {
+  std::vector<BddNodeIndex> worklist = {expr};
+  while (!worklist.empty()) {
+    BddNodeIndex node_index = worklist.back();
+    worklist.pop_back();
+    const BddNode& node = GetNode(node_index);
+    unique_tables_[node.variable.value()].erase(NodeKey{node.high, node.low});
+    for (BddNodeIndex child : {node.high, node.low}) {
+      if (--ref_counts_[child.value()] == 0) {
+        worklist.push_back(child);
+      }
+    }
+    ref_counts_[node_index.value()] = kFreeNode;
+    free_nodes_.push_back(node_index);
+  }
+}
+
+int64_t BinaryDecisionDiagram::GarbageCollect() {
+  int64_t original_size = size();
+  for (int64_t i = 0; i < nodes_.size(); ++i) {
+    if (ref_counts_[i] == 0) {
+      FreeNode(BddNodeIndex(i));
+    }
+  }
+  int64_t freed = original_size - size();
+  if (freed > 0) {
+    // Cached results may refer to freed nodes.
+    ResizeIteCache(/*clear=*/true);
+  }
+  XLS_VLOG(3) << absl::StreamFormat(
+      "BDD garbage collection freed %d of %d nodes", freed, original_size);
+  return freed;
+}
+
+void BinaryDecisionDiagram::SwapLevels(int64_t level) {
+  BddVariable x = level_to_var_.at(level);
+  BddVariable y = level_to_var_.at(level + 1);
+  std::swap(level_to_var_[level], level_to_var_[level + 1]);
+  var_to_level_[x.value()] = level + 1;
+  var_to_level_[y.value()] = level;
+
+  auto is_y_node = [&](BddNodeIndex expr) {
+    return expr != zero() && expr != one() && GetNode(expr).variable == y;
+  };
+
+  // Nodes of x which do not depend on y are unaffected. The others are
+  // rewritten in place into nodes of y using the identity
+  //
+  //   x ? (y ? f11 : f10) : (y ? f01 : f00)
+  //     == y ? (x ? f11 : f01) : (x ? f10 : f00)
+  //
+  // which preserves the function of every node index. They are removed from
+  // the unique table of x first so that the new x nodes created below can
+  // only match unaffected nodes.
+  absl::flat_hash_map<NodeKey, BddNodeIndex>& x_table =
+      unique_tables_[x.value()];
+  std::vector<BddNodeIndex> rewritten;
+  for (auto it = x_table.begin(); it != x_table.end();) {
+    const BddNode& node = GetNode(it->second);
+    if (is_y_node(node.high) || is_y_node(node.low)) {
+      rewritten.push_back(it->second);
+      x_table.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+
+  auto cofactors = [&](BddNodeIndex expr) {
+    if (is_y_node(expr)) {
+      return std::make_pair(GetNode(expr).high, GetNode(expr).low);
+    }
+    return std::make_pair(expr, expr);
+  };
+  for (BddNodeIndex node_index : rewritten) {
+    // Copy the node as creating nodes may reallocate the node vector.
+    BddNode node = GetNode(node_index);
+    auto [f11, f10] = cofactors(node.high);
+    auto [f01, f00] = cofactors(node.low);
+    BddNodeIndex high = GetOrCreateNode(x, f11, f01);
+    ++ref_counts_[high.value()];
+    BddNodeIndex low = GetOrCreateNode(x, f10, f00);
+    ++ref_counts_[low.value()];
+    // The original children are freed if this was their last use. At least
+    // one of the new children depends on x so the rewritten node is distinct
+    // from all existing nodes of y.
+    DecRefInternal(node.high, /*free_garbage=*/true);
+    DecRefInternal(node.low, /*free_garbage=*/true);
+    nodes_[node_index.value()] = BddNode(y, high, low, node.path_count);
+    unique_tables_[y.value()][NodeKey{high, low}] = node_index;
+  }
+}
+
+int64_t BinaryDecisionDiagram::SiftVariable(BddVariable var,
+                                            int64_t max_swaps) {
+  int64_t level_count = level_to_var_.size();
+  int64_t level = GetVariableLevel(var);
+  int64_t best_level = level;
+  int64_t best_size = size();
+  int64_t swaps = 0;
+  // Records the size after a swap and returns whether sifting should continue
+  // in the current direction.
+  auto record_size = [&]() {
+    ++swaps;
+    if (size() < best_size) {
+      best_size = size();
+      best_level = level;
+    }
+    return swaps < max_swaps &&
+           100 * size() <= kMaxSiftGrowthPercent * best_size;
+  };
+
+  // Move the variable down to the bottom, then up to the top...
+  while (level + 1 < level_count && swaps < max_swaps) {
+    SwapLevels(level);
+    ++level;
+    if (!record_size()) {
+      break;
+    }
+  }
+  while (level > 0 && swaps < max_swaps) {
+    --level;
+    SwapLevels(level);
+    if (!record_size()) {
+      break;
+    }
+  }
+  // ...and then back to where the BDD was smallest.
+  for (; level < best_level; ++level) {
+    SwapLevels(level);
+    ++swaps;
+  }
+  while (level > best_level) {
+    --level;
+    SwapLevels(level);
+    ++swaps;
+  }
+  return swaps;
+}
+
+void BinaryDecisionDiagram::RecomputePathCounts() {
+  for (int64_t level = level_to_var_.size() - 1; level >= 0; --level) {
+    for (const auto& [children, node_index] :
+         unique_tables_[level_to_var_[level].value()]) {
+      nodes_[node_index.value()].path_count =
+          SumPathCounts(children.first, children.second);
+    }
+  }
+}
+
+int64_t BinaryDecisionDiagram::Reorder(int64_t max_swaps) {
+  GarbageCollect();
+  int64_t original_size = size();
+
+  // Sift the variables with the most nodes first.
+  std::vector<BddVariable> variables = level_to_var_;
+  std::stable_sort(variables.begin(), variables.end(),
+                   [&](BddVariable a, BddVariable b) {
+                     return unique_tables_[a.value()].size() >
+                            unique_tables_[b.value()].size();
+                   });
+  int64_t swaps = 0;
+  for (BddVariable var : variables) {
+    if (swaps >= max_swaps) {
+      break;
+    }
+    swaps += SiftVariable(var, max_swaps - swaps);
+  }
+
+  RecomputePathCounts();
+  // Nodes freed while swapping may be referred to by cached results.
+  ResizeIteCache(/*clear=*/true);
+  XLS_VLOG(2) << absl::StreamFormat(
+      "BDD reordering with %d swaps changed the size from %d to %d nodes",
+      swaps, original_size, size());
+  return size();
 }
 
 BddNodeIndex BinaryDecisionDiagram::Not(BddNodeIndex expr) {
@@ -16,6 +16,9 @@
 #define XLS_DATA_STRUCTURES_BINARY_DECISION_DIAGRAM_H_
 
 #include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
@@ -27,10 +30,24 @@ namespace xls {
 // implementation allows an arbitrary number of expressions over a set of
 // variables to be represented in a single BDD.
 //
+// Memory is managed with reference counts. Nodes which are not (transitively)
+// reachable from a node referenced with IncRef are garbage and are reclaimed
+// by GarbageCollect and Reorder; nodes are never freed otherwise, so clients
+// which never call either of those need not maintain references. Results of
+// if-then-else operations are memoized in a bounded, lossy computed table.
+//
+// The order of the variables in the diagram can be changed by Reorder, which
+// uses sifting to reduce the number of nodes. Reordering preserves the
+// function of every live node index.
+//
 // Based on:
 //   K.S. Brace, R.L. Rudell, and R.E. Bryant,
 //   "Efficient Implementation of a BDD package"
 //   https://ieeexplore.ieee.org/document/114826
+//
+//   R. Rudell, "Dynamic variable ordering for ordered binary decision
+//   diagrams"
+//   https://ieeexplore.ieee.org/document/580029
 
 // For efficiency variables and nodes are referred to by indices into vector
 // data members in the BDD.
@@ -57,9 +74,18 @@ struct BddNode {
 
 class BinaryDecisionDiagram {
  public:
+  // The default maximum number of entries in the if-then-else computed table.
+  static constexpr int64_t kDefaultMaxIteCacheSize = 256 * 1024;
+
+  // The default maximum number of adjacent variable swaps performed by one
+  // call to Reorder.
+  static constexpr int64_t kDefaultMaxReorderSwaps = 64 * 1024;
+
   // Creates an empty BDD. Initialize the BDD contains only the nodes
-  // corresponding to zero and one.
-  BinaryDecisionDiagram();
+  // corresponding to zero and one. The computed table grows with the number
+  // of nodes up to `max_ite_cache_size` entries.
+  explicit BinaryDecisionDiagram(
+      int64_t max_ite_cache_size = kDefaultMaxIteCacheSize);
 
   // Adds a new variable to the BDD and returns the node corresponding the
   // variable's value.
@@ -89,12 +115,48 @@ class BinaryDecisionDiagram {
     return nodes_.at(node_index.value());
   }
 
-  // Returns the number of nodes in the graph.
-  int64_t size() const { return nodes_.size(); }
+  // Returns the number of nodes in the graph, including garbage nodes which
+  // have not yet been collected.
+  int64_t size() const { return nodes_.size() - free_nodes_.size(); }
 
   // Returns the number of variables in the graph.
   int64_t variable_count() const { return next_var_.value(); }
 
+  // Adds/removes an external reference to the given node. A node with no
+  // references which is not a descendant of a referenced node is garbage.
+  // Terminal and variable base nodes are never garbage.
+  void IncRef(BddNodeIndex expr);
+  void DecRef(BddNodeIndex expr);
+
+  // Returns the number of references to the given node, both external ones
+  // and those from parent nodes.
+  int64_t ref_count(BddNodeIndex expr) const {
+    return ref_counts_.at(expr.value());
+  }
+
+  // Frees all garbage nodes and clears the computed table. Returns the number
+  // of nodes freed. Indices of garbage nodes are invalidated and may be
+  // reused by nodes created later.
+  int64_t GarbageCollect();
+
+  // Changes the order of the variables to reduce the number of nodes using
+  // sifting: each variable in turn (starting with the one with the most
+  // nodes) is moved through all positions in the order and then left at the
+  // position where the diagram was smallest. At most `max_swaps` adjacent
+  // variable swaps are performed. Garbage is collected first. Node indices
+  // which are not garbage keep their meaning, but their structure and path
+  // counts may change. Returns the number of nodes after reordering.
+  int64_t Reorder(int64_t max_swaps = kDefaultMaxReorderSwaps);
+
+  // Returns the position of the given variable in the variable order. Paths
+  // through the BDD visit variables in increasing position.
+  int64_t GetVariableLevel(BddVariable variable) const {
+    return var_to_level_.at(variable.value());
+  }
+
+  // Returns the number of entries in the computed table.
+  int64_t ite_cache_size() const { return ite_cache_.size(); }
+
   // Returns the number of paths in the given expression.
   int64_t path_count(BddNodeIndex expr) const {
     return GetNode(expr).path_count;
@@ -123,6 +185,10 @@ class BinaryDecisionDiagram {
   BddNodeIndex GetOrCreateNode(BddVariable var, BddNodeIndex high,
                                BddNodeIndex low);
 
+  // Returns the level of the variable of the given node. Terminal nodes are
+  // below all variables.
+  int64_t GetNodeLevel(BddNodeIndex expr) const;
+
   // Returns the node equal to given expression with the given variable
   // set to the given value.
   BddNodeIndex Restrict(BddNodeIndex expr, BddVariable var, bool value);
@@ -133,27 +199,71 @@ class BinaryDecisionDiagram {
 
   // Returns the node corresponding to the value of the given variable.
   BddNodeIndex GetVariableBaseNode(BddVariable variable) const {
-    return node_map_.at({variable, one(), zero()});
+    return base_nodes_.at(variable.value());
   }
 
+  // Removes a reference held by a parent node or by the reordering code. If
+  // `free_garbage` is true and the node becomes garbage it is freed
+  // immediately along with any descendants which become garbage.
+  void DecRefInternal(BddNodeIndex expr, bool free_garbage);
+
+  // Frees the given garbage node and any descendants which become garbage.
+  void FreeNode(BddNodeIndex expr);
+
+  // Swaps the variables at the given level and the level below it.
+  void SwapLevels(int64_t level);
+
+  // Sifts the given variable to the level where the BDD is smallest. Returns
+  // the number of swaps performed.
+  int64_t SiftVariable(BddVariable var, int64_t max_swaps);
+
+  // Recomputes the path counts of all nodes bottom-up.
+  void RecomputePathCounts();
+
+  // Returns the path count of a node with the given children.
+  int32_t SumPathCounts(BddNodeIndex high, BddNodeIndex low) const;
+
+  // Resizes the computed table for the current number of nodes. If `clear` is
+  // true all entries are dropped, otherwise they are rehashed.
+  void ResizeIteCache(bool clear);
+
   // The numeric id to use for the next created variable. Increments with each
   // call to NewVariable which
   BddVariable next_var_ = BddVariable(0);
 
-  // The vector of all the nodes in the BDD.
+  // The vector of all the nodes in the BDD, indexed by node index. Entries of
+  // freed nodes are listed in `free_nodes_` and reused for new nodes.
   std::vector<BddNode> nodes_;
+  std::vector<BddNodeIndex> free_nodes_;
+
+  // The number of references to each node, indexed by node index.
+  std::vector<int32_t> ref_counts_;
 
-  // A map from BDD node content (variable id, high child, low child) to the
-  // index of the respective node. This map is used to ensure that no duplicate
+  // Per variable, a map from the children (high, low) of a node to the index
+  // of the respective node. These maps are used to ensure that no duplicate
   // nodes are created.
-  using NodeKey = std::tuple<BddVariable, BddNodeIndex, BddNodeIndex>;
-  absl::flat_hash_map<NodeKey, BddNodeIndex> node_map_;
-
-  // A map from if-then-else expression to the node corresponding to that
-  // expression. The key elements are (condition, if-true, if-false). This map
-  // enables fast lookup for expressions.
-  using IteKey = std::tuple<BddNodeIndex, BddNodeIndex, BddNodeIndex>;
-  absl::flat_hash_map<IteKey, BddNodeIndex> ite_map_;
+  using NodeKey = std::pair<BddNodeIndex, BddNodeIndex>;
+  std::vector<absl::flat_hash_map<NodeKey, BddNodeIndex>> unique_tables_;
+
+  // The node corresponding to the value of each variable.
+  std::vector<BddNodeIndex> base_nodes_;
+
+  // The variable order: the level of each variable and the variable at each
+  // level.
+  std::vector<int64_t> var_to_level_;
+  std::vector<BddVariable> level_to_var_;
+
+  // A direct-mapped cache from if-then-else expression (condition, if-true,
+  // if-false) to the node corresponding to that expression. Colliding entries
+  // overwrite each other. The size is a power of two.
+  struct IteCacheEntry {
+    BddNodeIndex cond = BddNodeIndex(-1);
+    BddNodeIndex if_true;
+    BddNodeIndex if_false;
+    BddNodeIndex result;
+  };
+  std::vector<IteCacheEntry> ite_cache_;
+  int64_t max_ite_cache_size_;
 };
 
 }  // namespace xls
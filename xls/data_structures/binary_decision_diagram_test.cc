@@ -14,8 +14,13 @@
 
 #include "xls/data_structures/binary_decision_diagram.h"
 
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/matchers.h"
@@ -306,5 +311,152 @@ TEST(BinaryDecisionDiagramTest, ThreeVariableExhaustive) {
   }
 }
 
+TEST(BinaryDecisionDiagramTest, GarbageCollection) {
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> variables;
+  for (int64_t i = 0; i < 64; ++i) {
+    variables.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex parity = bdd.zero();
+  for (int64_t i = 0; i < 64; ++i) {
+    parity = bdd.Or(bdd.And(parity, bdd.Not(variables[i])),
+                    bdd.And(bdd.Not(parity), variables[i]));
+  }
+  absl::flat_hash_map<BddNodeIndex, bool> values;
+  for (int64_t i = 0; i < 64; ++i) {
+    values[variables[i]] = i % 3 == 0;
+  }
+
+  // Only the nodes of the final parity expression (two per variable except
+  // the first) and the variables and leaves survive.
+  bdd.IncRef(parity);
+  EXPECT_GT(bdd.GarbageCollect(), 0);
+  EXPECT_EQ(bdd.size(), 2 + 64 + 2 * 63);
+  EXPECT_THAT(bdd.Evaluate(parity, values), IsOkAndHolds(false));
+  EXPECT_EQ(bdd.GarbageCollect(), 0);
+
+  // Expressions are still canonical after collection.
+  EXPECT_EQ(bdd.Not(bdd.Not(parity)), parity);
+  EXPECT_EQ(bdd.And(variables[0], variables[1]),
+            bdd.Not(bdd.Or(bdd.Not(variables[1]), bdd.Not(variables[0]))));
+
+  bdd.DecRef(parity);
+  bdd.GarbageCollect();
+  EXPECT_EQ(bdd.size(), 2 + 64);
+}
+
+TEST(BinaryDecisionDiagramTest, BoundedIteCache) {
+  BinaryDecisionDiagram bdd(/*max_ite_cache_size=*/16);
+  std::vector<BddNodeIndex> variables;
+  for (int64_t i = 0; i < 16; ++i) {
+    variables.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex parity = bdd.zero();
+  for (int64_t i = 0; i < 16; ++i) {
+    parity = bdd.Or(bdd.And(parity, bdd.Not(variables[i])),
+                    bdd.And(bdd.Not(parity), variables[i]));
+  }
+  EXPECT_EQ(bdd.ite_cache_size(), 16);
+  EXPECT_EQ(bdd.path_count(parity), 1 << 16);
+
+  absl::flat_hash_map<BddNodeIndex, bool> values;
+  for (int64_t i = 0; i < 16; ++i) {
+    values[variables[i]] = i == 3 || i == 5 || i == 11;
+  }
+  EXPECT_THAT(bdd.Evaluate(parity, values), IsOkAndHolds(true));
+}
+
+TEST(BinaryDecisionDiagramTest, Reorder) {
+  // The expression x0.y0 + x1.y1 + ... has a BDD of exponential size with
+  // all x variables ordered before the y variables and of linear size with
+  // the variables interleaved.
+  BinaryDecisionDiagram bdd;
+  constexpr int64_t kPairs = 8;
+  std::vector<BddNodeIndex> xs;
+  std::vector<BddNodeIndex> ys;
+  for (int64_t i = 0; i < kPairs; ++i) {
+    xs.push_back(bdd.NewVariable());
+  }
+  for (int64_t i = 0; i < kPairs; ++i) {
+    ys.push_back(bdd.NewVariable());
+  }
+  BddNodeIndex expr = bdd.zero();
+  for (int64_t i = 0; i < kPairs; ++i) {
+    expr = bdd.Or(expr, bdd.And(xs[i], ys[i]));
+  }
+  bdd.IncRef(expr);
+  bdd.GarbageCollect();
+  int64_t original_size = bdd.size();
+  int64_t original_path_count = bdd.path_count(expr);
+
+  EXPECT_LT(4 * bdd.Reorder(), original_size);
+  EXPECT_LT(bdd.path_count(expr), original_path_count);
+  for (int64_t i = 0; i < kPairs; ++i) {
+    EXPECT_EQ(std::abs(bdd.GetVariableLevel(bdd.GetNode(xs[i]).variable) -
+                       bdd.GetVariableLevel(bdd.GetNode(ys[i]).variable)),
+              1);
+  }
+
+  // Node indices keep their meaning and expressions remain canonical.
+  for (uint64_t value = 0; value < (1 << (2 * kPairs)); value += 37) {
+    absl::flat_hash_map<BddNodeIndex, bool> values;
+    bool expected = false;
+    for (int64_t i = 0; i < kPairs; ++i) {
+      values[xs[i]] = (value >> i) & 1;
+      values[ys[i]] = (value >> (kPairs + i)) & 1;
+      expected |= values[xs[i]] && values[ys[i]];
+    }
+    EXPECT_THAT(bdd.Evaluate(expr, values), IsOkAndHolds(expected));
+  }
+  BddNodeIndex rebuilt = bdd.zero();
+  for (int64_t i = kPairs - 1; i >= 0; --i) {
+    rebuilt = bdd.Or(bdd.And(ys[i], xs[i]), rebuilt);
+  }
+  EXPECT_EQ(rebuilt, expr);
+}
+
+TEST(BinaryDecisionDiagramTest, ReorderPreservesFunctions) {
+  // Build all three-variable minterms and a few functions over them, reorder,
+  // and verify the truth tables.
+  BinaryDecisionDiagram bdd;
+  std::vector<BddNodeIndex> vars;
+  for (int64_t i = 0; i < 3; ++i) {
+    vars.push_back(bdd.NewVariable());
+  }
+  std::vector<BddNodeIndex> minterms;
+  for (int64_t j = 0; j < 8; ++j) {
+    BddNodeIndex minterm = bdd.one();
+    for (int64_t i = 0; i < 3; ++i) {
+      minterm =
+          bdd.And(minterm, ((j >> i) & 1) ? vars[i] : bdd.Not(vars[i]));
+    }
+    minterms.push_back(minterm);
+  }
+  std::vector<int64_t> truth_tables = {0x01, 0x3c, 0x96, 0xe8, 0xfe};
+  std::vector<BddNodeIndex> funcs;
+  for (int64_t truth_table : truth_tables) {
+    BddNodeIndex func = bdd.zero();
+    for (int64_t j = 0; j < 8; ++j) {
+      if ((truth_table >> j) & 1) {
+        func = bdd.Or(func, minterms[j]);
+      }
+    }
+    bdd.IncRef(func);
+    funcs.push_back(func);
+  }
+
+  for (int64_t iteration = 0; iteration < 2; ++iteration) {
+    bdd.Reorder();
+    for (int64_t f = 0; f < funcs.size(); ++f) {
+      for (int64_t j = 0; j < 8; ++j) {
+        EXPECT_THAT(bdd.Evaluate(funcs[f], {{vars[0], (j & 1) != 0},
+                                            {vars[1], (j & 2) != 0},
+                                            {vars[2], (j & 4) != 0}}),
+                    IsOkAndHolds(((truth_tables[f] >> j) & 1) != 0));
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xls
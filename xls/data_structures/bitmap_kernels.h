@@ -0,0 +1,151 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_DATA_STRUCTURES_BITMAP_KERNELS_H_
+#define XLS_DATA_STRUCTURES_BITMAP_KERNELS_H_
+
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace xls {
+namespace bitmap_kernels {
+
+// Word-parallel kernels over arrays of 64-bit words such as the words backing
+// an InlineBitmap. A kernel is written once as a generic function of the word
+// operations below and applied to the arrays by one of the Apply* drivers,
+// which process four (AVX2) or two (NEON) words per step when the target
+// supports it and one word at a time otherwise and for the remaining words.
+//
+// For example, the following computes out[i] = a[i] & ~b[i]:
+//
+//   ApplyBinary(a, b, out, word_count,
+//               [](auto x, auto y) { return WordAndNot(x, y); });
+
+inline uint64_t WordAnd(uint64_t a, uint64_t b) { return a & b; }
+inline uint64_t WordOr(uint64_t a, uint64_t b) { return a | b; }
+inline uint64_t WordXor(uint64_t a, uint64_t b) { return a ^ b; }
+// Returns a & ~b.
+inline uint64_t WordAndNot(uint64_t a, uint64_t b) { return a & ~b; }
+
+#if defined(__AVX2__)
+#define XLS_BITMAP_KERNELS_VECTORIZED 1
+using VectorWord = __m256i;
+inline constexpr int64_t kWordsPerVector = 4;
+inline VectorWord LoadVector(const uint64_t* p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+inline void StoreVector(uint64_t* p, VectorWord v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+inline VectorWord WordAnd(VectorWord a, VectorWord b) {
+  return _mm256_and_si256(a, b);
+}
+inline VectorWord WordOr(VectorWord a, VectorWord b) {
+  return _mm256_or_si256(a, b);
+}
+inline VectorWord WordXor(VectorWord a, VectorWord b) {
+  return _mm256_xor_si256(a, b);
+}
+inline VectorWord WordAndNot(VectorWord a, VectorWord b) {
+  return _mm256_andnot_si256(b, a);
+}
+#elif defined(__ARM_NEON)
+#define XLS_BITMAP_KERNELS_VECTORIZED 1
+using VectorWord = uint64x2_t;
+inline constexpr int64_t kWordsPerVector = 2;
+inline VectorWord LoadVector(const uint64_t* p) { return vld1q_u64(p); }
+inline void StoreVector(uint64_t* p, VectorWord v) { vst1q_u64(p, v); }
+inline VectorWord WordAnd(VectorWord a, VectorWord b) {
+  return vandq_u64(a, b);
+}
+inline VectorWord WordOr(VectorWord a, VectorWord b) {
+  return vorrq_u64(a, b);
+}
+inline VectorWord WordXor(VectorWord a, VectorWord b) {
+  return veorq_u64(a, b);
+}
+inline VectorWord WordAndNot(VectorWord a, VectorWord b) {
+  return vbicq_u64(a, b);
+}
+#endif
+
+// Sets out[i] = f(a[i]) for i in [0, word_count).
+template <typename F>
+inline void ApplyUnary(const uint64_t* a, uint64_t* out, int64_t word_count,
+                       F f) {
+  int64_t i = 0;
+#ifdef XLS_BITMAP_KERNELS_VECTORIZED
+  for (; i + kWordsPerVector <= word_count; i += kWordsPerVector) {
+    StoreVector(out + i, f(LoadVector(a + i)));
+  }
+#endif
+  for (; i < word_count; ++i) {
+    out[i] = f(a[i]);
+  }
+}
+
+// Sets out[i] = f(a[i], b[i]) for i in [0, word_count). `out` may alias the
+// inputs.
+template <typename F>
+inline void ApplyBinary(const uint64_t* a, const uint64_t* b, uint64_t* out,
+                        int64_t word_count, F f) {
+  int64_t i = 0;
+#ifdef XLS_BITMAP_KERNELS_VECTORIZED
+  for (; i + kWordsPerVector <= word_count; i += kWordsPerVector) {
+    StoreVector(out + i, f(LoadVector(a + i), LoadVector(b + i)));
+  }
+#endif
+  for (; i < word_count; ++i) {
+    out[i] = f(a[i], b[i]);
+  }
+}
+
+// Applies a kernel with two pairs of input words and a pair of output words:
+// f(a0[i], a1[i], b0[i], b1[i], &out0[i], &out1[i]) for i in [0, word_count).
+// Used for values represented as two bit planes (e.g., ternary values). The
+// outputs may alias the inputs.
+template <typename F>
+inline void ApplyPairBinary(const uint64_t* a0, const uint64_t* a1,
+                            const uint64_t* b0, const uint64_t* b1,
+                            uint64_t* out0, uint64_t* out1, int64_t word_count,
+                            F f) {
+  int64_t i = 0;
+#ifdef XLS_BITMAP_KERNELS_VECTORIZED
+  for (; i + kWordsPerVector <= word_count; i += kWordsPerVector) {
+    VectorWord r0;
+    VectorWord r1;
+    f(LoadVector(a0 + i), LoadVector(a1 + i), LoadVector(b0 + i),
+      LoadVector(b1 + i), &r0, &r1);
+    StoreVector(out0 + i, r0);
+    StoreVector(out1 + i, r1);
+  }
+#endif
+  for (; i < word_count; ++i) {
+    uint64_t r0;
+    uint64_t r1;
+    f(a0[i], a1[i], b0[i], b1[i], &r0, &r1);
+    out0[i] = r0;
+    out1[i] = r1;
+  }
+}
+
+}  // namespace bitmap_kernels
+}  // namespace xls
+
+#endif  // XLS_DATA_STRUCTURES_BITMAP_KERNELS_H_
@@ -20,6 +20,8 @@
 
 #include "absl/base/casts.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/types/span.h"
+#include "xls/data_structures/bitmap_kernels.h"
 #include "xls/common/bits_util.h"
 #include "xls/common/endian.h"
 #include "xls/common/logging/logging.h"
@@ -133,8 +135,15 @@ class InlineBitmap {
                        bool value = true) {
     XLS_DCHECK_GE(lower_index, 0);
     XLS_DCHECK_LE(upper_index, bit_count());
-    for (int64_t index = lower_index; index < upper_index; ++index) {
-      Set(index, value);
+    // Set the range a word at a time.
+    int64_t index = lower_index;
+    while (index < upper_index) {
+      int64_t bitno = index % kWordBits;
+      int64_t count = std::min(kWordBits - bitno, upper_index - index);
+      uint64_t mask = Mask(count) << bitno;
+      uint64_t& word = data_[index / kWordBits];
+      word = value ? (word | mask) : (word & ~mask);
+      index += count;
     }
   }
   // Sets all the values of the bitmap to false.
@@ -152,6 +161,16 @@ class InlineBitmap {
     return data_[wordno];
   }
 
+  // Sets the 64-bit word that backs a group of 64 bits. Bits beyond the end
+  // of the bitmap are masked off.
+  void SetWord(int64_t wordno, uint64_t value) {
+    XLS_DCHECK_LT(wordno, word_count());
+    data_[wordno] = value & MaskForWord(wordno);
+  }
+
+  // Returns the number of 64-bit words backing the bitmap.
+  int64_t word_count() const { return data_.size(); }
+
   // Sets a byte in the data underlying the bitmap.
   //
   // Setting byte i as {b_7, b_6, b_5, ..., b_0} sets the bit at i*8 to b_0, the
@@ -231,11 +250,25 @@ class InlineBitmap {
   // Sets this bitmap to the union of this bitmap and `other`.
   void Union(const InlineBitmap& other) {
     XLS_CHECK_EQ(bit_count(), other.bit_count());
-    for (int64_t i = 0; i < data_.size(); ++i) {
-      data_[i] |= other.data_[i];
-    }
+    bitmap_kernels::ApplyBinary(
+        data_.data(), other.data_.data(), data_.data(), word_count(),
+        [](auto a, auto b) { return bitmap_kernels::WordOr(a, b); });
   }
 
+  // Sets this bitmap to the intersection of this bitmap and `other`.
+  void Intersect(const InlineBitmap& other) {
+    XLS_CHECK_EQ(bit_count(), other.bit_count());
+    bitmap_kernels::ApplyBinary(
+        data_.data(), other.data_.data(), data_.data(), word_count(),
+        [](auto a, auto b) { return bitmap_kernels::WordAnd(a, b); });
+  }
+
+  // Returns the words backing the bitmap for use with the word-parallel
+  // kernels in bitmap_kernels.h. Bits of the last word beyond bit_count() are
+  // zero and must be kept zero by writers.
+  absl::Span<const uint64_t> words() const { return data_; }
+  absl::Span<uint64_t> mutable_words() { return absl::MakeSpan(data_); }
+
   int64_t byte_count() const { return CeilOfRatio(bit_count_, int64_t{8}); }
 
   template <typename H>
@@ -248,7 +281,6 @@ class InlineBitmap {
 
   static constexpr int64_t kWordBits = 64;
   static constexpr int64_t kWordBytes = 8;
-  int64_t word_count() const { return data_.size(); }
 
   void MaskLastWord() {
     if (word_count() == 0) {
@@ -91,6 +91,36 @@ TEST(InlineBitmapTest, SetRange) {
   EXPECT_TRUE(b.IsAllOnes());
   b.SetRange(0, 3, false);
   EXPECT_TRUE(b.IsAllZeroes());
+
+  // Ranges spanning several words.
+  InlineBitmap wide(/*bit_count=*/200);
+  wide.SetRange(30, 170);
+  for (int64_t i = 0; i < 200; ++i) {
+    EXPECT_EQ(wide.Get(i), i >= 30 && i < 170) << i;
+  }
+  wide.SetRange(64, 128, false);
+  for (int64_t i = 0; i < 200; ++i) {
+    EXPECT_EQ(wide.Get(i), (i >= 30 && i < 64) || (i >= 128 && i < 170)) << i;
+  }
+}
+
+TEST(InlineBitmapTest, UnionAndIntersect) {
+  // Wide enough to exercise both the vectorized and the scalar loops.
+  constexpr int64_t kBitCount = 64 * 9 + 5;
+  InlineBitmap a(kBitCount);
+  InlineBitmap b(kBitCount);
+  for (int64_t i = 0; i < kBitCount; ++i) {
+    a.Set(i, i % 3 == 0);
+    b.Set(i, i % 5 == 0);
+  }
+  InlineBitmap a_or_b = a;
+  a_or_b.Union(b);
+  InlineBitmap a_and_b = a;
+  a_and_b.Intersect(b);
+  for (int64_t i = 0; i < kBitCount; ++i) {
+    EXPECT_EQ(a_or_b.Get(i), i % 3 == 0 || i % 5 == 0) << i;
+    EXPECT_EQ(a_and_b.Get(i), i % 15 == 0) << i;
+  }
 }
 
 TEST(InlineBitmapTest, SetAllBitsToFalse) {
@@ -249,6 +279,17 @@ TEST(InlineBitmapTest, GetSetBytesAndWords) {
     EXPECT_EQ(b.GetWord(0), 0xff00000000000000) << std::hex << b.GetWord(0);
     EXPECT_EQ(b.GetWord(1), 0x1) << std::hex << b.GetWord(1);
   }
+
+  {
+    InlineBitmap b(/*bit_count=*/100);
+    EXPECT_EQ(b.word_count(), 2);
+    b.SetWord(0, 0x123456789abcdef0);
+    // Bits beyond the end of the bitmap are masked off.
+    b.SetWord(1, 0xffffffffffffffff);
+    EXPECT_EQ(b.GetWord(0), 0x123456789abcdef0) << std::hex << b.GetWord(0);
+    EXPECT_EQ(b.GetWord(1), 0xfffffffff) << std::hex << b.GetWord(1);
+    EXPECT_EQ(b.GetByte(12), 0xf);
+  }
 }
 
 TEST(InlineBitmapTest, FromToBytes) {
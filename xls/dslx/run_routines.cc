@@ -14,8 +14,15 @@
 
 #include "xls/dslx/run_routines.h"
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <limits>
 #include <random>
+#include <thread>  // NOLINT
 
+#include "xls/common/math_util.h"
+#include "xls/common/thread.h"
 #include "xls/dslx/bindings.h"
 #include "xls/dslx/bytecode_cache.h"
 #include "xls/dslx/bytecode_emitter.h"
@@ -31,6 +38,7 @@
 #include "xls/dslx/typecheck.h"
 #include "xls/interpreter/function_interpreter.h"
 #include "xls/interpreter/random_value.h"
+#include "xls/jit/jit_object_cache.h"
 
 namespace xls::dslx {
 namespace {
@@ -39,6 +47,9 @@ namespace {
 constexpr int kUnitSpaces = 7;
 constexpr int kQuickcheckSpaces = 15;
 
+// The number of QuickCheck samples evaluated per batched JIT invocation.
+constexpr int64_t kQuickcheckBatchSize = 1024;
+
 absl::Status RunTestFunction(
     ImportData* import_data, TypeInfo* type_info, Module* module,
     TestFunction* tf, BytecodeInterpreter::PostFnEvalHook post_fn_eval_hook) {
@@ -86,13 +97,26 @@ absl::Status RunTestProc(ImportData* import_data, TypeInfo* type_info,
 }  // namespace
 
 absl::StatusOr<FunctionJit*> RunComparator::GetOrCompileJitFunction(
-    std::string ir_name, xls::Function* ir_function) {
+    std::string ir_name, xls::Function* ir_function, bool batched) {
+  absl::MutexLock lock(&mutex_);
   auto it = jit_cache_.find(ir_name);
   if (it != jit_cache_.end()) {
-    return it->second.get();
+    if (!batched || it->second->has_batched_entry_point()) {
+      return it->second.get();
+    }
+    // Recompile with a batched entry point. Callers may still hold the old
+    // FunctionJit so keep it alive.
+    superseded_jits_.push_back(std::move(it->second));
+  }
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<FunctionJit> jit,
+      FunctionJit::Create(ir_function, /*opt_level=*/3,
+                          /*with_batched_entry_point=*/batched));
+  if (JitObjectCache* object_cache = JitObjectCache::GetDefault();
+      object_cache != nullptr) {
+    XLS_VLOG(1) << "JIT object cache hits: " << object_cache->hit_count()
+                << ", misses: " << object_cache->miss_count();
   }
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<FunctionJit> jit,
-                       FunctionJit::Create(ir_function));
   FunctionJit* result = jit.get();
   jit_cache_[ir_name] = std::move(jit);
   return result;
@@ -190,36 +214,190 @@ static bool TestMatchesFilter(std::string_view test_name,
   return test_name == *test_filter;
 }
 
+std::minstd_rand QuickCheckRng(int64_t seed, int64_t shard) {
+  if (shard == 0) {
+    return std::minstd_rand(seed);
+  }
+  uint64_t useed = static_cast<uint64_t>(seed);
+  uint64_t ushard = static_cast<uint64_t>(shard);
+  std::seed_seq seed_seq{
+      static_cast<uint32_t>(useed), static_cast<uint32_t>(useed >> 32),
+      static_cast<uint32_t>(ushard), static_cast<uint32_t>(ushard >> 32)};
+  return std::minstd_rand(seed_seq);
+}
+
+std::vector<Value> QuickCheckSampleArguments(xls::Function* xls_function,
+                                             int64_t seed,
+                                             int64_t sample_index) {
+  std::minstd_rand rng_engine =
+      QuickCheckRng(seed, sample_index / kQuickCheckShardSize);
+  for (int64_t i = 0; i < sample_index % kQuickCheckShardSize; ++i) {
+    RandomFunctionArguments(xls_function, &rng_engine);
+  }
+  return RandomFunctionArguments(xls_function, &rng_engine);
+}
+
+namespace {
+
+// Lowers `stop_index` to `index` if it is greater.
+void LowerStopIndex(std::atomic<int64_t>* stop_index, int64_t index) {
+  int64_t current = stop_index->load();
+  while (index < current &&
+         !stop_index->compare_exchange_weak(current, index)) {
+  }
+}
+
+// Evaluates the first `num_tests` samples of the given QuickCheck shard and
+// appends them to `results`, stopping after the first falsifying sample.
+// `stop_index` is the lowest index of a sample at which some shard stopped
+// (falsified or failed); it is updated by this shard and the evaluation is
+// abandoned if it drops below the samples being evaluated, as those results
+// would be discarded anyway.
+absl::Status RunQuickCheckShard(xls::Function* xls_function, FunctionJit* jit,
+                                int64_t seed, int64_t shard, int64_t num_tests,
+                                std::atomic<int64_t>* stop_index,
+                                QuickCheckResults* results) {
+  int64_t shard_start = shard * kQuickCheckShardSize;
+  std::minstd_rand rng_engine = QuickCheckRng(seed, shard);
+
+  // Samples are generated in the same order as if evaluated one at a time and
+  // evaluated in batches with the batched JIT entry point.
+  for (int64_t batch_start = 0; batch_start < num_tests;
+       batch_start += kQuickcheckBatchSize) {
+    if (stop_index->load() < shard_start + batch_start) {
+      return absl::OkStatus();
+    }
+    int64_t batch_size =
+        std::min(kQuickcheckBatchSize, num_tests - batch_start);
+    std::vector<std::vector<Value>> arg_sets;
+    arg_sets.reserve(batch_size);
+    for (int64_t i = 0; i < batch_size; ++i) {
+      arg_sets.push_back(RandomFunctionArguments(xls_function, &rng_engine));
+    }
+    // TODO(https://github.com/google/xls/issues/506): 2021-10-15
+    // Assertion failures should work out, but we should consciously decide
+    // if/how we want to dump traces when running QuickChecks (always, for
+    // failures, flag-controlled, ...).
+    absl::StatusOr<InterpreterResult<std::vector<Value>>> batch_results =
+        jit->RunBatched(arg_sets);
+    if (!batch_results.ok()) {
+      LowerStopIndex(stop_index, shard_start + batch_start);
+      return batch_results.status();
+    }
+    // If an assertion failed in the batch then re-evaluate the samples one at
+    // a time so the failure is only reported if it occurs before the predicate
+    // is falsified.
+    bool assertion_failed = !batch_results->events.assert_msgs.empty();
+    for (int64_t i = 0; i < batch_size; ++i) {
+      results->arg_sets.push_back(std::move(arg_sets[i]));
+      xls::Value result;
+      if (assertion_failed) {
+        absl::StatusOr<Value> sample_result =
+            DropInterpreterEvents(jit->Run(results->arg_sets.back()));
+        if (!sample_result.ok()) {
+          LowerStopIndex(stop_index, shard_start + batch_start + i);
+          return sample_result.status();
+        }
+        result = std::move(sample_result).value();
+      } else {
+        result = std::move(batch_results->value[i]);
+      }
+      results->results.push_back(result);
+      if (result.IsAllZeros()) {
+        // We were able to falsify the xls_function (predicate), bail out early
+        // and present this evidence.
+        LowerStopIndex(stop_index, shard_start + batch_start + i);
+        return absl::OkStatus();
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
 absl::StatusOr<QuickCheckResults> DoQuickCheck(xls::Function* xls_function,
                                                std::string ir_name,
                                                RunComparator* run_comparator,
-                                               int64_t seed,
-                                               int64_t num_tests) {
+                                               int64_t seed, int64_t num_tests,
+                                               int64_t num_threads) {
   XLS_ASSIGN_OR_RETURN(FunctionJit * jit,
                        run_comparator->GetOrCompileJitFunction(
-                           std::move(ir_name), xls_function));
+                           std::move(ir_name), xls_function, /*batched=*/true));
 
-  QuickCheckResults results;
-  std::minstd_rand rng_engine(seed);
+  int64_t num_shards =
+      std::max<int64_t>(1, CeilOfRatio(num_tests, kQuickCheckShardSize));
+  if (num_threads <= 0) {
+    num_threads = std::max<int64_t>(1, std::thread::hardware_concurrency());
+  }
+  // Workers claim whole shards, and there are no more shards than test cases,
+  // so extra workers would have nothing to do.
+  num_threads = std::min(num_threads, num_shards);
+
+  std::vector<absl::Status> shard_statuses(num_shards);
+  std::vector<QuickCheckResults> shard_results(num_shards);
+  std::atomic<int64_t> next_shard = 0;
+  std::atomic<int64_t> stop_index = std::numeric_limits<int64_t>::max();
+  auto run_shards = [&](FunctionJit* worker_jit) {
+    for (int64_t shard = next_shard++; shard < num_shards;
+         shard = next_shard++) {
+      int64_t shard_start = shard * kQuickCheckShardSize;
+      if (stop_index.load() < shard_start) {
+        return;
+      }
+      shard_statuses[shard] = RunQuickCheckShard(
+          xls_function, worker_jit, seed, shard,
+          std::min(kQuickCheckShardSize, num_tests - shard_start), &stop_index,
+          &shard_results[shard]);
+    }
+  };
 
-  for (int i = 0; i < num_tests; i++) {
-    results.arg_sets.push_back(
-        RandomFunctionArguments(xls_function, &rng_engine));
-    // TODO(https://github.com/google/xls/issues/506): 2021-10-15
-    // Assertion failures should work out, but we should consciously decide
-    // if/how we want to dump traces when running QuickChecks (always, for
-    // failures, flag-controlled, ...).
-    XLS_ASSIGN_OR_RETURN(
-        xls::Value result,
-        DropInterpreterEvents(jit->Run(results.arg_sets.back())));
-    results.results.push_back(result);
-    if (result.IsAllZeros()) {
-      // We were able to falsify the xls_function (predicate), bail out early
-      // and present this evidence.
+  // The calling thread evaluates shards with the cached JIT function. Each of
+  // the other threads needs its own compiled copy as a FunctionJit may not be
+  // run concurrently. The copies are compiled on the worker threads so the
+  // compilations overlap with each other and with evaluation, and a worker
+  // which finds no shards left skips compiling altogether.
+  std::vector<absl::Status> worker_statuses(num_threads - 1);
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int64_t i = 0; i < num_threads - 1; ++i) {
+    threads.push_back(std::make_unique<Thread>([&, i]() {
+      if (next_shard.load() >= num_shards) {
+        return;
+      }
+      absl::StatusOr<std::unique_ptr<FunctionJit>> worker_jit =
+          FunctionJit::Create(xls_function, /*opt_level=*/3,
+                              /*with_batched_entry_point=*/true);
+      if (!worker_jit.ok()) {
+        worker_statuses[i] = worker_jit.status();
+        return;
+      }
+      run_shards(worker_jit->get());
+    }));
+  }
+  run_shards(jit);
+  for (std::unique_ptr<Thread>& thread : threads) {
+    thread->Join();
+  }
+  for (const absl::Status& status : worker_statuses) {
+    XLS_RETURN_IF_ERROR(status);
+  }
+
+  // Assemble the results in sample order up to the first falsifying sample (or
+  // error), exactly as if the samples had been evaluated one at a time.
+  QuickCheckResults results;
+  for (int64_t shard = 0; shard < num_shards; ++shard) {
+    XLS_RETURN_IF_ERROR(shard_statuses[shard]);
+    QuickCheckResults& shard_result = shard_results[shard];
+    bool falsified = !shard_result.results.empty() &&
+                     shard_result.results.back().IsAllZeros();
+    std::move(shard_result.arg_sets.begin(), shard_result.arg_sets.end(),
+              std::back_inserter(results.arg_sets));
+    std::move(shard_result.results.begin(), shard_result.results.end(),
+              std::back_inserter(results.results));
+    if (falsified) {
       break;
     }
   }
-
   return results;
 }
 
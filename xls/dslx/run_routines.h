@@ -18,6 +18,10 @@
 #ifndef XLS_DSLX_RUN_ROUTINES_H_
 #define XLS_DSLX_RUN_ROUTINES_H_
 
+#include <random>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
 #include "xls/common/test_macros.h"
 #include "xls/dslx/default_dslx_stdlib_path.h"
 #include "xls/dslx/interp_value.h"
@@ -56,19 +60,27 @@ class RunComparator {
 
   // Returns the cached or newly-compiled jit function for ir_name.  ir_name has
   // already been mangled (see MangleDslxName) so it should be unique in the
-  // program and is used as the cache key.
+  // program and is used as the cache key. Functions which are not in the
+  // cache are compiled with FunctionJit::Create which reuses object code from
+  // the persistent JIT object cache (--jit_object_cache_dir), if enabled. If
+  // `batched` is true the returned FunctionJit supports RunBatched.
   //
-  // Note: There is no locking in jit compilation or on the jit function cache
-  // so this function is *not* thread-safe.
+  // This function is thread-safe. However, the returned FunctionJit is not so
+  // it must not be run by multiple threads at the same time.
   absl::StatusOr<FunctionJit*> GetOrCompileJitFunction(
-      std::string ir_name, xls::Function* ir_function);
+      std::string ir_name, xls::Function* ir_function, bool batched = false);
 
  private:
   XLS_FRIEND_TEST(RunRoutinesTest, TestInvokedFunctionDoesJit);
   XLS_FRIEND_TEST(RunRoutinesTest, QuickcheckInvokedFunctionDoesJit);
   XLS_FRIEND_TEST(RunRoutinesTest, NoSeedStillQuickChecks);
 
+  // Protects jit_cache_ and superseded_jits_.
+  absl::Mutex mutex_;
   absl::flat_hash_map<std::string, std::unique_ptr<FunctionJit>> jit_cache_;
+  // Cache entries replaced by a batched recompile, kept alive as callers may
+  // still be using them.
+  std::vector<std::unique_ptr<FunctionJit>> superseded_jits_;
   CompareMode mode_;
 };
 
@@ -121,6 +133,24 @@ struct QuickCheckResults {
   std::vector<Value> results;
 };
 
+// The number of QuickCheck samples in each shard. Samples are generated and
+// evaluated shard by shard with each shard drawing from its own random stream
+// (see QuickCheckRng). The shard size is fixed so the samples generated for a
+// given seed do not depend on the number of threads.
+inline constexpr int64_t kQuickCheckShardSize = 64 * 1024;
+
+// Returns the random number engine which generates the arguments of the
+// samples in the given QuickCheck shard. Shard zero uses `seed` directly; the
+// other shards use streams derived from `seed` and the shard index.
+std::minstd_rand QuickCheckRng(int64_t seed, int64_t shard);
+
+// Returns the arguments of the QuickCheck sample with the given index (i.e.,
+// `arg_sets[sample_index]` of DoQuickCheck results with the same seed). Used to
+// replay a failing sample without rerunning the preceding samples.
+std::vector<Value> QuickCheckSampleArguments(xls::Function* xls_function,
+                                             int64_t seed,
+                                             int64_t sample_index);
+
 // JIT-compiles the given xls_function and invokes it with num_tests randomly
 // generated arguments -- returns `([argset, ...], [results, ...])` (i.e. in
 // structure-of-array style).
@@ -128,10 +158,17 @@ struct QuickCheckResults {
 // xls_function is a predicate we're trying to find evidence to falsify, so if
 // this finds an example that falsifies the predicate, we early-return (i.e. the
 // length of the returned vectors may be < 1000).
+//
+// Shards of samples (see kQuickCheckShardSize) are evaluated in parallel on up
+// to `num_threads` threads (zero means the number of cores), each thread with
+// its own compiled copy of the function. The results are independent of the
+// number of threads: they always end at the first falsifying sample in sample
+// order.
 absl::StatusOr<QuickCheckResults> DoQuickCheck(xls::Function* xls_function,
                                                std::string ir_name,
                                                RunComparator* run_comparator,
-                                               int64_t seed, int64_t num_tests);
+                                               int64_t seed, int64_t num_tests,
+                                               int64_t num_threads = 0);
 
 }  // namespace xls::dslx
 
@@ -251,4 +251,59 @@ TEST(QuickcheckTest, Seeding) {
   EXPECT_EQ(results1, results2);
 }
 
+// The samples (and so the results) of a QuickCheck run spanning several shards
+// are independent of the number of threads evaluating them.
+TEST(QuickcheckTest, ShardedResultsIndependentOfThreadCount) {
+  Package package("rarely_false");
+  std::string ir_text = R"(
+  fn not_huge(x: bits[32]) -> bits[1] {
+    literal.2: bits[32] = literal(value=4294901760)
+    ret ult.3: bits[1] = ult(x, literal.2)
+  }
+  )";
+  int64_t seed = 42;
+  int64_t num_tests = 3 * kQuickCheckShardSize + 5;
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  RunComparator jit_comparator(CompareMode::kJit);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto quickcheck_info1,
+      DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests,
+                   /*num_threads=*/1));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto quickcheck_info4,
+      DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests,
+                   /*num_threads=*/4));
+
+  const auto& [argsets1, results1] = quickcheck_info1;
+  const auto& [argsets4, results4] = quickcheck_info4;
+  EXPECT_EQ(argsets1, argsets4);
+  EXPECT_EQ(results1, results4);
+}
+
+// A sample, in particular the falsifying one, can be replayed from the seed
+// and its index.
+TEST(QuickcheckTest, ReplaySample) {
+  Package package("sometimes_false");
+  std::string ir_text = R"(
+  fn not_all_ones(x: bits[18]) -> bits[1] {
+    literal.2: bits[18] = literal(value=262143)
+    ret ne.3: bits[1] = ne(x, literal.2)
+  }
+  )";
+  int64_t seed = 7;
+  int64_t num_tests = 8 * kQuickCheckShardSize;
+  XLS_ASSERT_OK_AND_ASSIGN(xls::Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  RunComparator jit_comparator(CompareMode::kJit);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto quickcheck_info,
+      DoQuickCheck(function, kFakeIrName, &jit_comparator, seed, num_tests));
+  const auto& [argsets, results] = quickcheck_info;
+  ASSERT_FALSE(argsets.empty());
+  EXPECT_EQ(QuickCheckSampleArguments(function, seed, 0), argsets.front());
+  EXPECT_EQ(QuickCheckSampleArguments(function, seed, argsets.size() - 1),
+            argsets.back());
+}
+
 }  // namespace xls::dslx
@@ -0,0 +1,720 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/compiled_function_base.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/ir_interpreter.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value_helpers.h"
+
+namespace xls {
+namespace {
+
+// Returns the given bits value as a uint64_t value. If the value exceeds
+// upper_limit, then upper_limit is returned.
+uint64_t BitsToBoundedUint64(const Bits& bits, uint64_t upper_limit) {
+  if (Bits::MinBitCountUnsigned(upper_limit) <= bits.bit_count() &&
+      bits_ops::UGreaterThan(bits, UBits(upper_limit, bits.bit_count()))) {
+    return upper_limit;
+  }
+  // Necessarily the bits value fits in a uint64_t so the value() call is safe.
+  return bits.ToUint64().value();
+}
+
+const Value& Operand(const CompiledInstruction& instruction,
+                     const CompiledFrame& frame, int64_t i) {
+  return frame.slots[instruction.operand_slots[i]];
+}
+
+const Bits& BitsOperand(const CompiledInstruction& instruction,
+                        const CompiledFrame& frame, int64_t i) {
+  return Operand(instruction, frame, i).bits();
+}
+
+absl::Status SetResult(const CompiledInstruction& instruction,
+                       CompiledFrame& frame, Value value) {
+  frame.slots[instruction.result_slot] = std::move(value);
+  return absl::OkStatus();
+}
+
+absl::Status SetBitsResult(const CompiledInstruction& instruction,
+                           CompiledFrame& frame, Bits bits) {
+  return SetResult(instruction, frame, Value(std::move(bits)));
+}
+
+// Evaluates a node without a specialized kernel by running the frame's
+// IrInterpreter on the single node with its operand values taken from the
+// frame.
+absl::Status InterpretNodeKernel(const CompiledInstruction& instruction,
+                                 CompiledFrame& frame) {
+  Node* node = instruction.node;
+  if (frame.fallback == nullptr) {
+    frame.fallback = std::make_unique<CompiledFallback>(frame.events);
+  }
+  absl::flat_hash_map<Node*, Value>& node_values = frame.fallback->node_values;
+  // Clearing (rather than discarding) the map keeps its storage for the next
+  // node.
+  node_values.clear();
+  for (int64_t i = 0; i < node->operand_count(); ++i) {
+    node_values[node->operand(i)] = Operand(instruction, frame, i);
+  }
+  XLS_RETURN_IF_ERROR(node->VisitSingleNode(&frame.fallback->interpreter));
+  return SetResult(instruction, frame, std::move(node_values.at(node)));
+}
+
+absl::Status LiteralKernel(const CompiledInstruction& instruction,
+                           CompiledFrame& frame) {
+  return SetResult(instruction, frame, instruction.literal);
+}
+
+absl::Status ParamKernel(const CompiledInstruction& instruction,
+                         CompiledFrame& frame) {
+  if (instruction.immediate >= frame.params.size()) {
+    return absl::InternalError(absl::StrFormat(
+        "Parameter %s at index %d does not exist in args (of length %d)",
+        instruction.node->ToString(), instruction.immediate,
+        frame.params.size()));
+  }
+  return SetResult(instruction, frame, frame.params[instruction.immediate]);
+}
+
+absl::Status IdentityKernel(const CompiledInstruction& instruction,
+                            CompiledFrame& frame) {
+  return SetResult(instruction, frame, Operand(instruction, frame, 0));
+}
+
+absl::Status TokenKernel(const CompiledInstruction& instruction,
+                         CompiledFrame& frame) {
+  return SetResult(instruction, frame, Value::Token());
+}
+
+template <Bits (*kOp)(const Bits&)>
+absl::Status UnaryBitsKernel(const CompiledInstruction& instruction,
+                             CompiledFrame& frame) {
+  return SetBitsResult(instruction, frame,
+                       kOp(BitsOperand(instruction, frame, 0)));
+}
+
+template <Bits (*kOp)(const Bits&, const Bits&)>
+absl::Status BinaryBitsKernel(const CompiledInstruction& instruction,
+                              CompiledFrame& frame) {
+  return SetBitsResult(instruction, frame,
+                       kOp(BitsOperand(instruction, frame, 0),
+                           BitsOperand(instruction, frame, 1)));
+}
+
+// Multiplies and then truncates or extends the product to the result width
+// (given by the immediate).
+template <Bits (*kOp)(const Bits&, const Bits&),
+          Bits (*kExtend)(const Bits&, int64_t)>
+absl::Status MulKernel(const CompiledInstruction& instruction,
+                       CompiledFrame& frame) {
+  Bits product = kOp(BitsOperand(instruction, frame, 0),
+                     BitsOperand(instruction, frame, 1));
+  int64_t width = instruction.immediate;
+  if (product.bit_count() > width) {
+    return SetBitsResult(instruction, frame, product.Slice(0, width));
+  }
+  if (product.bit_count() < width) {
+    return SetBitsResult(instruction, frame, kExtend(product, width));
+  }
+  return SetBitsResult(instruction, frame, std::move(product));
+}
+
+template <bool (*kOp)(const Bits&, const Bits&)>
+absl::Status CompareKernel(const CompiledInstruction& instruction,
+                           CompiledFrame& frame) {
+  bool result = kOp(BitsOperand(instruction, frame, 0),
+                    BitsOperand(instruction, frame, 1));
+  return SetBitsResult(instruction, frame, UBits(result ? 1 : 0, 1));
+}
+
+template <bool kEqual>
+absl::Status EqualityKernel(const CompiledInstruction& instruction,
+                            CompiledFrame& frame) {
+  bool equal = Operand(instruction, frame, 0) == Operand(instruction, frame, 1);
+  return SetBitsResult(instruction, frame, UBits(equal == kEqual ? 1 : 0, 1));
+}
+
+template <Bits (*kOp)(const Bits&, int64_t)>
+absl::Status ShiftKernel(const CompiledInstruction& instruction,
+                         CompiledFrame& frame) {
+  const Bits& input = BitsOperand(instruction, frame, 0);
+  int64_t amount = BitsToBoundedUint64(BitsOperand(instruction, frame, 1),
+                                       input.bit_count());
+  return SetBitsResult(instruction, frame, kOp(input, amount));
+}
+
+absl::Status LogicalKernel(const CompiledInstruction& instruction,
+                           CompiledFrame& frame) {
+  absl::InlinedVector<Bits, 3> operands;
+  operands.reserve(instruction.operand_slots.size());
+  for (int64_t slot : instruction.operand_slots) {
+    operands.push_back(frame.slots[slot].bits());
+  }
+  return SetBitsResult(instruction, frame,
+                       DoLogicalOp(instruction.node->op(), operands));
+}
+
+absl::Status ConcatKernel(const CompiledInstruction& instruction,
+                          CompiledFrame& frame) {
+  absl::InlinedVector<Bits, 3> operands;
+  operands.reserve(instruction.operand_slots.size());
+  for (int64_t slot : instruction.operand_slots) {
+    operands.push_back(frame.slots[slot].bits());
+  }
+  return SetBitsResult(instruction, frame, bits_ops::Concat(operands));
+}
+
+absl::Status BitSliceKernel(const CompiledInstruction& instruction,
+                            CompiledFrame& frame) {
+  return SetBitsResult(instruction, frame,
+                       BitsOperand(instruction, frame, 0)
+                           .Slice(instruction.immediate,
+                                  instruction.immediate2));
+}
+
+template <Bits (*kOp)(const Bits&, int64_t)>
+absl::Status ExtendKernel(const CompiledInstruction& instruction,
+                          CompiledFrame& frame) {
+  return SetBitsResult(
+      instruction, frame,
+      kOp(BitsOperand(instruction, frame, 0), instruction.immediate));
+}
+
+// Operand 0 is the selector, followed by the `immediate` cases and the
+// optional default value.
+absl::Status SelKernel(const CompiledInstruction& instruction,
+                       CompiledFrame& frame) {
+  const Bits& selector = BitsOperand(instruction, frame, 0);
+  int64_t case_count = instruction.immediate;
+  if (bits_ops::UGreaterThanOrEqual(selector, case_count)) {
+    XLS_RET_CHECK_EQ(instruction.operand_slots.size(), case_count + 2);
+    return SetResult(instruction, frame,
+                     Operand(instruction, frame, case_count + 1));
+  }
+  XLS_ASSIGN_OR_RETURN(uint64_t index, selector.ToUint64());
+  return SetResult(instruction, frame, Operand(instruction, frame, index + 1));
+}
+
+absl::Status TupleKernel(const CompiledInstruction& instruction,
+                         CompiledFrame& frame) {
+  std::vector<Value> elements;
+  elements.reserve(instruction.operand_slots.size());
+  for (int64_t slot : instruction.operand_slots) {
+    elements.push_back(frame.slots[slot]);
+  }
+  return SetResult(instruction, frame, Value::TupleOwned(std::move(elements)));
+}
+
+absl::Status TupleIndexKernel(const CompiledInstruction& instruction,
+                              CompiledFrame& frame) {
+  return SetResult(
+      instruction, frame,
+      Operand(instruction, frame, 0).elements().at(instruction.immediate));
+}
+
+absl::Status ArrayIndexKernel(const CompiledInstruction& instruction,
+                              CompiledFrame& frame) {
+  const Value* array = &Operand(instruction, frame, 0);
+  for (int64_t i = 1; i < instruction.operand_slots.size(); ++i) {
+    uint64_t index = BitsToBoundedUint64(BitsOperand(instruction, frame, i),
+                                         array->size() - 1);
+    array = &array->element(index);
+  }
+  return SetResult(instruction, frame, *array);
+}
+
+absl::Status ArrayKernel(const CompiledInstruction& instruction,
+                         CompiledFrame& frame) {
+  std::vector<Value> elements;
+  elements.reserve(instruction.operand_slots.size());
+  for (int64_t slot : instruction.operand_slots) {
+    elements.push_back(frame.slots[slot]);
+  }
+  return SetResult(instruction, frame, Value::ArrayOwned(std::move(elements)));
+}
+
+// Operand 0 is the array and operand 1 the start index. The immediate is the
+// width of the slice. Elements past the end of the array are filled with the
+// last element.
+absl::Status ArraySliceKernel(const CompiledInstruction& instruction,
+                              CompiledFrame& frame) {
+  const Value& array = Operand(instruction, frame, 0);
+  int64_t last = array.size() - 1;
+  int64_t start = BitsToBoundedUint64(BitsOperand(instruction, frame, 1), last);
+  std::vector<Value> elements;
+  elements.reserve(instruction.immediate);
+  for (int64_t i = start; i < start + instruction.immediate; ++i) {
+    elements.push_back(array.element(std::min(i, last)));
+  }
+  return SetResult(instruction, frame, Value::ArrayOwned(std::move(elements)));
+}
+
+// Returns `array` with the element at the multidimensional index given by the
+// operands from `index_operand` onwards replaced by `value`. An out-of-bounds
+// index leaves the array unchanged.
+Value UpdateArrayElement(const CompiledInstruction& instruction,
+                         const CompiledFrame& frame, const Value& array,
+                         int64_t index_operand, const Value& value) {
+  if (index_operand == instruction.operand_slots.size()) {
+    return value;
+  }
+  uint64_t index = BitsToBoundedUint64(
+      BitsOperand(instruction, frame, index_operand), array.size());
+  if (index >= array.size()) {
+    return array;
+  }
+  std::vector<Value> elements(array.elements().begin(),
+                              array.elements().end());
+  elements[index] = UpdateArrayElement(instruction, frame, elements[index],
+                                       index_operand + 1, value);
+  return Value::ArrayOwned(std::move(elements));
+}
+
+// Operand 0 is the array, operand 1 the update value and the remaining
+// operands the indices.
+absl::Status ArrayUpdateKernel(const CompiledInstruction& instruction,
+                               CompiledFrame& frame) {
+  return SetResult(instruction, frame,
+                   UpdateArrayElement(instruction, frame,
+                                      Operand(instruction, frame, 0),
+                                      /*index_operand=*/2,
+                                      Operand(instruction, frame, 1)));
+}
+
+// Returns the OR of the bits-typed leaves of the given values, all of type
+// `type`. Returns the zero value of `type` if `inputs` is empty.
+Value DeepOr(Type* type, absl::Span<const Value* const> inputs) {
+  if (type->IsBits()) {
+    Bits result(type->AsBitsOrDie()->bit_count());
+    for (const Value* input : inputs) {
+      result = bits_ops::Or(result, input->bits());
+    }
+    return Value(std::move(result));
+  }
+  int64_t size = type->IsArray() ? type->AsArrayOrDie()->size()
+                                 : type->AsTupleOrDie()->size();
+  std::vector<Value> elements;
+  elements.reserve(size);
+  std::vector<const Value*> input_elements(inputs.size());
+  for (int64_t i = 0; i < size; ++i) {
+    for (int64_t j = 0; j < inputs.size(); ++j) {
+      input_elements[j] = &inputs[j]->element(i);
+    }
+    Type* element_type = type->IsArray()
+                             ? type->AsArrayOrDie()->element_type()
+                             : type->AsTupleOrDie()->element_type(i);
+    elements.push_back(DeepOr(element_type, input_elements));
+  }
+  return type->IsArray() ? Value::ArrayOwned(std::move(elements))
+                         : Value::TupleOwned(std::move(elements));
+}
+
+// Operand 0 is the selector followed by the cases.
+absl::Status OneHotSelKernel(const CompiledInstruction& instruction,
+                             CompiledFrame& frame) {
+  const Bits& selector = BitsOperand(instruction, frame, 0);
+  absl::InlinedVector<const Value*, 3> selected;
+  for (int64_t i = 0; i < selector.bit_count(); ++i) {
+    if (selector.Get(i)) {
+      selected.push_back(&Operand(instruction, frame, i + 1));
+    }
+  }
+  return SetResult(instruction, frame,
+                   DeepOr(instruction.node->GetType(), selected));
+}
+
+// Operand 0 is the selector followed by the cases.
+absl::Status PrioritySelKernel(const CompiledInstruction& instruction,
+                               CompiledFrame& frame) {
+  const Bits& selector = BitsOperand(instruction, frame, 0);
+  for (int64_t i = 0; i < selector.bit_count(); ++i) {
+    if (selector.Get(i)) {
+      return SetResult(instruction, frame, Operand(instruction, frame, i + 1));
+    }
+  }
+  return SetResult(instruction, frame,
+                   ZeroOfType(instruction.node->GetType()));
+}
+
+// Operand 0 is the value to slice and operand 1 the start index. The immediate
+// is the width of the slice. Bits past the end of the operand are zero.
+absl::Status DynamicBitSliceKernel(const CompiledInstruction& instruction,
+                                   CompiledFrame& frame) {
+  const Bits& operand = BitsOperand(instruction, frame, 0);
+  const Bits& start = BitsOperand(instruction, frame, 1);
+  if (bits_ops::UGreaterThanOrEqual(start, operand.bit_count())) {
+    return SetBitsResult(instruction, frame, Bits(instruction.immediate));
+  }
+  return SetBitsResult(
+      instruction, frame,
+      bits_ops::ShiftRightLogical(operand, start.ToUint64().value())
+          .Slice(0, instruction.immediate));
+}
+
+// The immediate is the result width.
+absl::Status EncodeKernel(const CompiledInstruction& instruction,
+                          CompiledFrame& frame) {
+  const Bits& input = BitsOperand(instruction, frame, 0);
+  uint64_t result = 0;
+  for (int64_t i = 0; i < input.bit_count(); ++i) {
+    if (input.Get(i)) {
+      result |= i;
+    }
+  }
+  return SetBitsResult(instruction, frame,
+                       UBits(result, instruction.immediate));
+}
+
+// The immediate is the result width. Out-of-range inputs produce zero.
+absl::Status DecodeKernel(const CompiledInstruction& instruction,
+                          CompiledFrame& frame) {
+  const Bits& input = BitsOperand(instruction, frame, 0);
+  if (bits_ops::UGreaterThanOrEqual(input, instruction.immediate)) {
+    return SetBitsResult(instruction, frame, Bits(instruction.immediate));
+  }
+  return SetBitsResult(instruction, frame,
+                       Bits::PowerOfTwo(input.ToUint64().value(),
+                                        instruction.immediate));
+}
+
+// Operand 0 is the condition and operand 1 the data.
+absl::Status GateKernel(const CompiledInstruction& instruction,
+                        CompiledFrame& frame) {
+  if (BitsOperand(instruction, frame, 0).IsOne()) {
+    return SetResult(instruction, frame, Operand(instruction, frame, 1));
+  }
+  return SetResult(instruction, frame,
+                   ZeroOfType(instruction.node->GetType()));
+}
+
+// Operand 1 (if present) is the predicate.
+absl::Status ReceiveKernel(const CompiledInstruction& instruction,
+                           CompiledFrame& frame) {
+  Receive* receive = instruction.node->As<Receive>();
+  XLS_RET_CHECK(frame.queue_manager != nullptr);
+  XLS_ASSIGN_OR_RETURN(
+      ChannelQueue * queue,
+      frame.queue_manager->GetQueueById(receive->channel_id()));
+  if (receive->predicate().has_value() &&
+      BitsOperand(instruction, frame, 1).IsZero()) {
+    // If the predicate is false, nothing is read from the channel. Rather the
+    // result of the receive is the zero value of its type.
+    return SetResult(instruction, frame, ZeroOfType(receive->GetType()));
+  }
+  std::optional<Value> value = queue->Read();
+  if (!value.has_value()) {
+    if (receive->is_blocking()) {
+      frame.blocked_channel = queue->channel();
+      return absl::OkStatus();
+    }
+    // A non-blocking receive returns a zero data value with a zero valid bit
+    // if the queue is empty.
+    return SetResult(instruction, frame, ZeroOfType(receive->GetType()));
+  }
+  if (receive->is_blocking()) {
+    return SetResult(instruction, frame,
+                     Value::Tuple({Value::Token(), *value}));
+  }
+  return SetResult(instruction, frame,
+                   Value::Tuple({Value::Token(), *value, Value(UBits(1, 1))}));
+}
+
+// Operand 1 is the data and operand 2 (if present) is the predicate.
+absl::Status SendKernel(const CompiledInstruction& instruction,
+                        CompiledFrame& frame) {
+  Send* send = instruction.node->As<Send>();
+  XLS_RET_CHECK(frame.queue_manager != nullptr);
+  XLS_ASSIGN_OR_RETURN(ChannelQueue * queue,
+                       frame.queue_manager->GetQueueById(send->channel_id()));
+  if (send->predicate().has_value() &&
+      BitsOperand(instruction, frame, 2).IsZero()) {
+    return SetResult(instruction, frame, Value::Token());
+  }
+  frame.sent_channel = queue->channel();
+  XLS_RETURN_IF_ERROR(queue->Write(Operand(instruction, frame, 1)));
+  return SetResult(instruction, frame, Value::Token());
+}
+
+// Chooses the kernel for the given node and sets any immediates it uses.
+absl::Status ChooseKernel(Node* node, CompiledInstruction& instruction) {
+  // Ops on bits which are otherwise typed (e.g., tuple-typed comparisons) fall
+  // back to the interpreter.
+  auto all_bits = [&]() {
+    if (!node->GetType()->IsBits()) {
+      return false;
+    }
+    for (Node* operand : node->operands()) {
+      if (!operand->GetType()->IsBits()) {
+        return false;
+      }
+    }
+    return true;
+  };
+  instruction.kernel = &InterpretNodeKernel;
+  switch (node->op()) {
+    case Op::kLiteral:
+      instruction.kernel = &LiteralKernel;
+      instruction.literal = node->As<Literal>()->value();
+      break;
+    case Op::kParam: {
+      instruction.kernel = &ParamKernel;
+      XLS_ASSIGN_OR_RETURN(instruction.immediate,
+                           node->function_base()->GetParamIndex(
+                               node->As<Param>()));
+      break;
+    }
+    case Op::kIdentity:
+      instruction.kernel = &IdentityKernel;
+      break;
+    case Op::kAfterAll:
+      instruction.kernel = &TokenKernel;
+      break;
+    case Op::kAdd:
+      instruction.kernel = &BinaryBitsKernel<bits_ops::Add>;
+      break;
+    case Op::kSub:
+      instruction.kernel = &BinaryBitsKernel<bits_ops::Sub>;
+      break;
+    case Op::kUDiv:
+      instruction.kernel = &BinaryBitsKernel<bits_ops::UDiv>;
+      break;
+    case Op::kSDiv:
+      instruction.kernel = &BinaryBitsKernel<bits_ops::SDiv>;
+      break;
+    case Op::kUMod:
+      instruction.kernel = &BinaryBitsKernel<bits_ops::UMod>;
+      break;
+    case Op::kSMod:
+      instruction.kernel = &BinaryBitsKernel<bits_ops::SMod>;
+      break;
+    case Op::kUMul:
+      instruction.kernel = &MulKernel<bits_ops::UMul, bits_ops::ZeroExtend>;
+      instruction.immediate = node->BitCountOrDie();
+      break;
+    case Op::kSMul:
+      instruction.kernel = &MulKernel<bits_ops::SMul, bits_ops::SignExtend>;
+      instruction.immediate = node->BitCountOrDie();
+      break;
+    case Op::kNeg:
+      instruction.kernel = &UnaryBitsKernel<bits_ops::Negate>;
+      break;
+    case Op::kNot:
+      instruction.kernel = &UnaryBitsKernel<bits_ops::Not>;
+      break;
+    case Op::kReverse:
+      instruction.kernel = &UnaryBitsKernel<bits_ops::Reverse>;
+      break;
+    case Op::kAndReduce:
+      instruction.kernel = &UnaryBitsKernel<bits_ops::AndReduce>;
+      break;
+    case Op::kOrReduce:
+      instruction.kernel = &UnaryBitsKernel<bits_ops::OrReduce>;
+      break;
+    case Op::kXorReduce:
+      instruction.kernel = &UnaryBitsKernel<bits_ops::XorReduce>;
+      break;
+    case Op::kEncode:
+      instruction.kernel = &EncodeKernel;
+      instruction.immediate = node->BitCountOrDie();
+      break;
+    case Op::kDecode:
+      instruction.kernel = &DecodeKernel;
+      instruction.immediate = node->BitCountOrDie();
+      break;
+    case Op::kAnd:
+    case Op::kOr:
+    case Op::kXor:
+    case Op::kNand:
+    case Op::kNor:
+      if (all_bits()) {
+        instruction.kernel = &LogicalKernel;
+      }
+      break;
+    case Op::kEq:
+      instruction.kernel = &EqualityKernel<true>;
+      break;
+    case Op::kNe:
+      instruction.kernel = &EqualityKernel<false>;
+      break;
+    case Op::kULt:
+      instruction.kernel = &CompareKernel<bits_ops::ULessThan>;
+      break;
+    case Op::kULe:
+      instruction.kernel = &CompareKernel<bits_ops::ULessThanOrEqual>;
+      break;
+    case Op::kUGt:
+      instruction.kernel = &CompareKernel<bits_ops::UGreaterThan>;
+      break;
+    case Op::kUGe:
+      instruction.kernel = &CompareKernel<bits_ops::UGreaterThanOrEqual>;
+      break;
+    case Op::kSLt:
+      instruction.kernel = &CompareKernel<bits_ops::SLessThan>;
+      break;
+    case Op::kSLe:
+      instruction.kernel = &CompareKernel<bits_ops::SLessThanOrEqual>;
+      break;
+    case Op::kSGt:
+      instruction.kernel = &CompareKernel<bits_ops::SGreaterThan>;
+      break;
+    case Op::kSGe:
+      instruction.kernel = &CompareKernel<bits_ops::SGreaterThanOrEqual>;
+      break;
+    case Op::kShll:
+      instruction.kernel = &ShiftKernel<bits_ops::ShiftLeftLogical>;
+      break;
+    case Op::kShrl:
+      instruction.kernel = &ShiftKernel<bits_ops::ShiftRightLogical>;
+      break;
+    case Op::kShra:
+      instruction.kernel = &ShiftKernel<bits_ops::ShiftRightArith>;
+      break;
+    case Op::kConcat:
+      instruction.kernel = &ConcatKernel;
+      break;
+    case Op::kBitSlice:
+      instruction.kernel = &BitSliceKernel;
+      instruction.immediate = node->As<BitSlice>()->start();
+      instruction.immediate2 = node->As<BitSlice>()->width();
+      break;
+    case Op::kZeroExt:
+      instruction.kernel = &ExtendKernel<bits_ops::ZeroExtend>;
+      instruction.immediate = node->As<ExtendOp>()->new_bit_count();
+      break;
+    case Op::kSignExt:
+      instruction.kernel = &ExtendKernel<bits_ops::SignExtend>;
+      instruction.immediate = node->As<ExtendOp>()->new_bit_count();
+      break;
+    case Op::kDynamicBitSlice:
+      instruction.kernel = &DynamicBitSliceKernel;
+      instruction.immediate = node->As<DynamicBitSlice>()->width();
+      break;
+    case Op::kSel:
+      instruction.kernel = &SelKernel;
+      instruction.immediate = node->As<Select>()->cases().size();
+      break;
+    case Op::kOneHotSel:
+      instruction.kernel = &OneHotSelKernel;
+      break;
+    case Op::kPrioritySel:
+      instruction.kernel = &PrioritySelKernel;
+      break;
+    case Op::kGate:
+      instruction.kernel = &GateKernel;
+      break;
+    case Op::kTuple:
+      instruction.kernel = &TupleKernel;
+      break;
+    case Op::kTupleIndex:
+      instruction.kernel = &TupleIndexKernel;
+      instruction.immediate = node->As<TupleIndex>()->index();
+      break;
+    case Op::kArray:
+      instruction.kernel = &ArrayKernel;
+      break;
+    case Op::kArrayIndex:
+      instruction.kernel = &ArrayIndexKernel;
+      break;
+    case Op::kArraySlice:
+      instruction.kernel = &ArraySliceKernel;
+      instruction.immediate = node->As<ArraySlice>()->width();
+      break;
+    case Op::kArrayUpdate:
+      instruction.kernel = &ArrayUpdateKernel;
+      break;
+    case Op::kReceive:
+      instruction.kernel = &ReceiveKernel;
+      break;
+    case Op::kSend:
+      instruction.kernel = &SendKernel;
+      break;
+    default:
+      break;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+/* static */
+absl::StatusOr<std::unique_ptr<CompiledFunctionBase>>
+CompiledFunctionBase::Create(FunctionBase* function_base) {
+  if (!function_base->IsFunction() && !function_base->IsProc()) {
+    return absl::UnimplementedError(absl::StrFormat(
+        "Cannot compile %s for interpretation; only functions and procs are "
+        "supported",
+        function_base->name()));
+  }
+  auto compiled = absl::WrapUnique(new CompiledFunctionBase(function_base));
+  std::vector<Node*> order = TopoSort(function_base).AsVector();
+  compiled->instructions_.reserve(order.size());
+  compiled->slots_.reserve(order.size());
+  for (Node* node : order) {
+    int64_t slot = compiled->slots_.size();
+    compiled->slots_[node] = slot;
+    CompiledInstruction instruction{.node = node, .result_slot = slot};
+    for (Node* operand : node->operands()) {
+      instruction.operand_slots.push_back(compiled->slots_.at(operand));
+    }
+    XLS_RETURN_IF_ERROR(ChooseKernel(node, instruction));
+    compiled->instructions_.push_back(std::move(instruction));
+  }
+  return compiled;
+}
+
+CompiledFrame CompiledFunctionBase::NewFrame(
+    std::vector<Value> params, InterpreterEvents* events,
+    ChannelQueueManager* queue_manager) const {
+  CompiledFrame frame;
+  frame.slots.resize(slots_.size());
+  frame.params = std::move(params);
+  frame.events = events;
+  frame.queue_manager = queue_manager;
+  return frame;
+}
+
+absl::StatusOr<int64_t> CompiledFunctionBase::Execute(CompiledFrame& frame,
+                                                      int64_t start) const {
+  XLS_RET_CHECK_EQ(frame.slots.size(), slots_.size());
+  frame.blocked_channel = std::nullopt;
+  frame.sent_channel = std::nullopt;
+  for (int64_t i = start; i < instructions_.size(); ++i) {
+    const CompiledInstruction& instruction = instructions_[i];
+    XLS_RETURN_IF_ERROR(instruction.kernel(instruction, frame));
+    if (frame.sent_channel.has_value()) {
+      // Resume after the send.
+      return i + 1;
+    }
+    if (frame.blocked_channel.has_value()) {
+      // Resume at (i.e., retry) the blocked receive.
+      return i;
+    }
+  }
+  return instructions_.size();
+}
+
+}  // namespace xls
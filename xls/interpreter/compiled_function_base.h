@@ -0,0 +1,152 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_INTERPRETER_COMPILED_FUNCTION_BASE_H_
+#define XLS_INTERPRETER_COMPILED_FUNCTION_BASE_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/ir_interpreter.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/node.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// State used to evaluate nodes which have no specialized kernel with the
+// IrInterpreter. Operand values are placed in `node_values` for the duration
+// of a single node evaluation.
+struct CompiledFallback {
+  explicit CompiledFallback(InterpreterEvents* events)
+      : interpreter(&node_values, events) {}
+
+  absl::flat_hash_map<Node*, Value> node_values;
+  IrInterpreter interpreter;
+};
+
+// The mutable state of a single evaluation of a CompiledFunctionBase. Every
+// node of the function base owns one dense value slot so operands are read by
+// index rather than looked up by node. A frame may be suspended (e.g., at a
+// blocked receive) and later resumed.
+struct CompiledFrame {
+  // Value slots, indexed by CompiledFunctionBase::GetSlot.
+  std::vector<Value> slots;
+
+  // Values of the parameters of the function base. For procs these are the
+  // token followed by the state elements.
+  std::vector<Value> params;
+
+  // Events (e.g., traces and assertion failures) raised during evaluation.
+  InterpreterEvents* events = nullptr;
+
+  // Channel queues used by send and receive nodes. May be null for functions.
+  ChannelQueueManager* queue_manager = nullptr;
+
+  // Set by a send (receive) instruction when data is sent on (execution is
+  // blocked on) a channel. Execution stops after such an instruction.
+  std::optional<Channel*> blocked_channel;
+  std::optional<Channel*> sent_channel;
+
+  // Created on the first evaluation of a node without a specialized kernel and
+  // reused for the lifetime of the frame. Heap-allocated so the interpreter's
+  // pointer to the value map survives moving the frame.
+  std::unique_ptr<CompiledFallback> fallback;
+};
+
+// A single instruction of a CompiledFunctionBase.
+struct CompiledInstruction;
+using CompiledKernel = absl::Status (*)(const CompiledInstruction& instruction,
+                                        CompiledFrame& frame);
+
+struct CompiledInstruction {
+  // The function which evaluates the instruction.
+  CompiledKernel kernel;
+
+  // The node evaluated by the instruction.
+  Node* node;
+
+  // The slot holding the result of the instruction and the slots holding its
+  // operands (in operand order).
+  int64_t result_slot;
+  absl::InlinedVector<int64_t, 3> operand_slots;
+
+  // Op-specific immediates, e.g., the parameter index of a param, the start
+  // and width of a bit slice, or the value of a literal.
+  int64_t immediate = 0;
+  int64_t immediate2 = 0;
+  Value literal;
+};
+
+// A FunctionBase (function or proc) lowered once into a flat, topologically
+// ordered array of instructions over dense value slots. Each instruction
+// dispatches through a kernel function pointer chosen for its op when the
+// function base is compiled, so repeated evaluation avoids both the per-node
+// hash map of the IrInterpreter and the visitor dispatch. Ops without a
+// specialized kernel (e.g., invoke, map and counted_for) are evaluated by an
+// IrInterpreter owned by the frame, one node at a time.
+//
+// The compiled form refers to the nodes of the function base and must not
+// outlive it, nor be used after the function base is modified. Immutable after
+// construction so it may be shared by concurrent evaluations with distinct
+// frames.
+class CompiledFunctionBase {
+ public:
+  // Compiles the given function or proc. Blocks are not supported.
+  static absl::StatusOr<std::unique_ptr<CompiledFunctionBase>> Create(
+      FunctionBase* function_base);
+
+  // Returns a frame for evaluating the function base with the given parameter
+  // values.
+  CompiledFrame NewFrame(std::vector<Value> params, InterpreterEvents* events,
+                         ChannelQueueManager* queue_manager = nullptr) const;
+
+  // Executes instructions starting at index `start` until all instructions
+  // have executed or an instruction sends on a channel or blocks on a receive
+  // (as recorded in the frame). Returns the index of the instruction at which
+  // to resume execution: the index after a send, the index of a blocked
+  // receive, or instruction_count() upon completion.
+  absl::StatusOr<int64_t> Execute(CompiledFrame& frame, int64_t start) const;
+
+  // Returns the slot holding the value of the given node.
+  int64_t GetSlot(Node* node) const { return slots_.at(node); }
+
+  FunctionBase* function_base() const { return function_base_; }
+  int64_t instruction_count() const { return instructions_.size(); }
+  absl::Span<const CompiledInstruction> instructions() const {
+    return instructions_;
+  }
+
+ private:
+  explicit CompiledFunctionBase(FunctionBase* function_base)
+      : function_base_(function_base) {}
+
+  FunctionBase* function_base_;
+  std::vector<CompiledInstruction> instructions_;
+  absl::flat_hash_map<Node*, int64_t> slots_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_INTERPRETER_COMPILED_FUNCTION_BASE_H_
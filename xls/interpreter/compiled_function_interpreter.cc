@@ -0,0 +1,73 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/compiled_function_interpreter.h"
+
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/keyword_args.h"
+
+namespace xls {
+
+/* static */
+absl::StatusOr<std::unique_ptr<CompiledFunctionInterpreter>>
+CompiledFunctionInterpreter::Create(Function* function) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<CompiledFunctionBase> compiled,
+                       CompiledFunctionBase::Create(function));
+  return absl::WrapUnique(
+      new CompiledFunctionInterpreter(function, std::move(compiled)));
+}
+
+absl::StatusOr<InterpreterResult<Value>> CompiledFunctionInterpreter::Run(
+    absl::Span<const Value> args) const {
+  XLS_VLOG(3) << "Interpreting compiled function " << function_->name();
+  if (args.size() != function_->params().size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Function %s wants %d arguments, got %d.", function_->name(),
+        function_->params().size(), args.size()));
+  }
+  for (int64_t argno = 0; argno < args.size(); ++argno) {
+    Type* param_type = function_->param(argno)->GetType();
+    if (function_->package()->GetTypeForValue(args[argno]) != param_type) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Got argument %s for parameter %d which is not of type %s",
+          args[argno].ToString(), argno, param_type->ToString()));
+    }
+  }
+  InterpreterEvents events;
+  CompiledFrame frame = compiled_->NewFrame(
+      std::vector<Value>(args.begin(), args.end()), &events);
+  XLS_ASSIGN_OR_RETURN(int64_t end, compiled_->Execute(frame, /*start=*/0));
+  XLS_RET_CHECK_EQ(end, compiled_->instruction_count());
+  Value result =
+      std::move(frame.slots[compiled_->GetSlot(function_->return_value())]);
+  XLS_VLOG(2) << "Result = " << result;
+  return InterpreterResult<Value>{std::move(result), std::move(events)};
+}
+
+absl::StatusOr<InterpreterResult<Value>>
+CompiledFunctionInterpreter::RunWithKwargs(
+    const absl::flat_hash_map<std::string, Value>& kwargs) const {
+  XLS_ASSIGN_OR_RETURN(std::vector<Value> positional_args,
+                       KeywordArgsToPositional(*function_, kwargs));
+  return Run(positional_args);
+}
+
+}  // namespace xls
@@ -0,0 +1,61 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_INTERPRETER_COMPILED_FUNCTION_INTERPRETER_H_
+#define XLS_INTERPRETER_COMPILED_FUNCTION_INTERPRETER_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/interpreter/compiled_function_base.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// An interpreter for a function which is lowered into a CompiledFunctionBase
+// once at construction and then evaluated by Run any number of times. Produces
+// the same results and events as InterpretFunction. Thread-safe.
+class CompiledFunctionInterpreter {
+ public:
+  static absl::StatusOr<std::unique_ptr<CompiledFunctionInterpreter>> Create(
+      Function* function);
+
+  // Runs the function with the given positional arguments. Returns both the
+  // result value and any events that happened while running.
+  absl::StatusOr<InterpreterResult<Value>> Run(
+      absl::Span<const Value> args) const;
+
+  // Runs the function with the arguments given by name.
+  absl::StatusOr<InterpreterResult<Value>> RunWithKwargs(
+      const absl::flat_hash_map<std::string, Value>& kwargs) const;
+
+  Function* function() const { return function_; }
+
+ private:
+  CompiledFunctionInterpreter(Function* function,
+                              std::unique_ptr<CompiledFunctionBase> compiled)
+      : function_(function), compiled_(std::move(compiled)) {}
+
+  Function* function_;
+  std::unique_ptr<CompiledFunctionBase> compiled_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_INTERPRETER_COMPILED_FUNCTION_INTERPRETER_H_
@@ -0,0 +1,129 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/compiled_function_interpreter.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/function_interpreter.h"
+#include "xls/interpreter/ir_evaluator_test_base.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+using testing::HasSubstr;
+
+INSTANTIATE_TEST_SUITE_P(
+    CompiledFunctionInterpreterTest, IrEvaluatorTestBase,
+    testing::Values(IrEvaluatorTestParam(
+        [](Function* function, absl::Span<const Value> args)
+            -> absl::StatusOr<InterpreterResult<Value>> {
+          XLS_ASSIGN_OR_RETURN(
+              std::unique_ptr<CompiledFunctionInterpreter> interpreter,
+              CompiledFunctionInterpreter::Create(function));
+          return interpreter->Run(args);
+        },
+        [](Function* function,
+           const absl::flat_hash_map<std::string, Value>& kwargs)
+            -> absl::StatusOr<InterpreterResult<Value>> {
+          XLS_ASSIGN_OR_RETURN(
+              std::unique_ptr<CompiledFunctionInterpreter> interpreter,
+              CompiledFunctionInterpreter::Create(function));
+          return interpreter->RunWithKwargs(kwargs);
+        })));
+
+class CompiledFunctionInterpreterOnlyTest : public IrTestBase {};
+
+TEST_F(CompiledFunctionInterpreterOnlyTest, ReusedAcrossCalls) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue sum = fb.Add(x, y);
+  fb.Tuple({sum, fb.BitSlice(fb.UMul(sum, y), 4, 4), fb.ULt(x, y)});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CompiledFunctionInterpreter> interpreter,
+      CompiledFunctionInterpreter::Create(f));
+  for (int64_t i = 0; i < 16; ++i) {
+    std::vector<Value> args = {Value(UBits(i * 13, 8)), Value(UBits(i, 8))};
+    XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<Value> expected,
+                             InterpretFunction(f, args));
+    EXPECT_THAT(DropInterpreterEvents(interpreter->Run(args)),
+                IsOkAndHolds(expected.value));
+  }
+}
+
+TEST_F(CompiledFunctionInterpreterOnlyTest, MatchesIrInterpreter) {
+  // Covers ops with specialized kernels alongside ops evaluated by the frame's
+  // fallback interpreter (one_hot and bit_slice_update).
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(4));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue array = fb.Array({y, fb.Not(y), fb.Add(y, fb.Literal(UBits(1, 8)))},
+                          p->GetBitsType(8));
+  BValue updated = fb.ArrayUpdate(array, fb.Reverse(y), {x});
+  BValue selector = fb.BitSlice(x, /*start=*/0, /*width=*/3);
+  std::vector<BValue> cases = {y, fb.Not(y), fb.Reverse(y)};
+  fb.Tuple({updated, fb.ArraySlice(updated, x, /*width=*/2),
+            fb.OneHotSelect(selector, cases),
+            fb.PrioritySelect(selector, cases),
+            fb.DynamicBitSlice(y, x, /*width=*/3), fb.AndReduce(y),
+            fb.OrReduce(x), fb.XorReduce(y), fb.Encode(y), fb.Decode(x),
+            fb.Gate(fb.BitSlice(x, /*start=*/0, /*width=*/1), y),
+            fb.OneHot(y, LsbOrMsb::kLsb),
+            fb.BitSliceUpdate(y, x, fb.BitSlice(x, /*start=*/1, /*width=*/2))});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CompiledFunctionInterpreter> interpreter,
+      CompiledFunctionInterpreter::Create(f));
+  for (int64_t i = 0; i < 16; ++i) {
+    std::vector<Value> args = {Value(UBits(i, 4)),
+                               Value(UBits((i * 37) % 256, 8))};
+    XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<Value> expected,
+                             InterpretFunction(f, args));
+    EXPECT_THAT(DropInterpreterEvents(interpreter->Run(args)),
+                IsOkAndHolds(expected.value));
+  }
+}
+
+TEST_F(CompiledFunctionInterpreterOnlyTest, WrongArguments) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  fb.Param("x", p->GetBitsType(8));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<CompiledFunctionInterpreter> interpreter,
+      CompiledFunctionInterpreter::Create(f));
+  EXPECT_THAT(interpreter->Run({}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("wants 1 arguments, got 0")));
+  EXPECT_THAT(interpreter->Run({Value(UBits(0, 4))}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("which is not of type bits[8]")));
+}
+
+}  // namespace
+}  // namespace xls
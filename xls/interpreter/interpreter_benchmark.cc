@@ -0,0 +1,144 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "xls/common/logging/logging.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/compiled_function_interpreter.h"
+#include "xls/interpreter/function_interpreter.h"
+#include "xls/interpreter/proc_evaluator.h"
+#include "xls/interpreter/proc_interpreter.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+// Compares the IrInterpreter, which walks the nodes and stores every result in
+// a hash map on each evaluation, against the compiled interpreters, which
+// lower the function or proc once into an instruction array over dense slots.
+
+// Adds `node_count` nodes to the builder computing on `x` and `y`. Each node
+// uses the previous node and a randomly chosen earlier node. Returns the last
+// node.
+BValue BuildNodes(int64_t node_count, BValue x, BValue y,
+                  BuilderBase* builder) {
+  std::mt19937_64 bitgen(42);
+  std::vector<BValue> values = {x, y};
+  for (int64_t i = 2; i < node_count; ++i) {
+    BValue lhs = values[i - 1];
+    BValue rhs = values[bitgen() % i];
+    switch (i % 4) {
+      case 0:
+        values.push_back(builder->Add(lhs, rhs));
+        break;
+      case 1:
+        values.push_back(builder->Xor(lhs, rhs));
+        break;
+      case 2:
+        values.push_back(builder->Select(
+            builder->ULt(lhs, rhs), /*on_true=*/lhs, /*on_false=*/rhs));
+        break;
+      default:
+        values.push_back(
+            builder->Shrl(lhs, builder->Literal(UBits(i % 7, 32))));
+        break;
+    }
+  }
+  return values.back();
+}
+
+Function* BuildFunction(int64_t node_count, Package* package) {
+  FunctionBuilder fb("f", package);
+  Type* u32 = package->GetBitsType(32);
+  BValue x = fb.Param("x", u32);
+  BValue y = fb.Param("y", u32);
+  return fb.BuildWithReturnValue(BuildNodes(node_count, x, y, &fb)).value();
+}
+
+// Builds a proc with two 32-bit state elements whose next value is computed by
+// `node_count` nodes.
+Proc* BuildProc(int64_t node_count, Package* package) {
+  ProcBuilder pb("p", "tkn", package);
+  BValue x = pb.StateElement("x", Value(UBits(1, 32)));
+  BValue y = pb.StateElement("y", Value(UBits(2, 32)));
+  BValue next = BuildNodes(node_count, x, y, &pb);
+  return pb.Build(pb.GetTokenParam(), {next, x}).value();
+}
+
+static void BM_InterpretFunction(benchmark::State& state) {
+  Package package("benchmark");
+  Function* f = BuildFunction(state.range(0), &package);
+  std::vector<Value> args = {Value(UBits(123, 32)), Value(UBits(456, 32))};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(InterpretFunction(f, args).value());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_CompiledFunctionInterpreter(benchmark::State& state) {
+  Package package("benchmark");
+  Function* f = BuildFunction(state.range(0), &package);
+  std::unique_ptr<CompiledFunctionInterpreter> interpreter =
+      CompiledFunctionInterpreter::Create(f).value();
+  std::vector<Value> args = {Value(UBits(123, 32)), Value(UBits(456, 32))};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interpreter->Run(args).value());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename EvaluatorT>
+std::unique_ptr<ProcEvaluator> CreateEvaluator(
+    Proc* proc, ChannelQueueManager* queue_manager) {
+  if constexpr (std::is_same_v<EvaluatorT, CompiledProcInterpreter>) {
+    return CompiledProcInterpreter::Create(proc, queue_manager).value();
+  } else {
+    return std::make_unique<EvaluatorT>(proc, queue_manager);
+  }
+}
+
+// Ticks a single proc once per iteration with the given evaluator type.
+template <typename EvaluatorT>
+static void BM_ProcTick(benchmark::State& state) {
+  Package package("benchmark");
+  Proc* proc = BuildProc(state.range(0), &package);
+  std::unique_ptr<ChannelQueueManager> queue_manager =
+      ChannelQueueManager::Create(&package).value();
+  std::unique_ptr<ProcEvaluator> evaluator =
+      CreateEvaluator<EvaluatorT>(proc, queue_manager.get());
+  std::unique_ptr<ProcContinuation> continuation =
+      evaluator->NewContinuation();
+  for (auto _ : state) {
+    TickResult result = evaluator->Tick(*continuation).value();
+    XLS_CHECK(result.execution_state == TickExecutionState::kCompleted);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_InterpretFunction)->Range(1 << 4, 1 << 12);
+BENCHMARK(BM_CompiledFunctionInterpreter)->Range(1 << 4, 1 << 12);
+BENCHMARK(BM_ProcTick<ProcInterpreter>)->Range(1 << 4, 1 << 12);
+BENCHMARK(BM_ProcTick<CompiledProcInterpreter>)->Range(1 << 4, 1 << 12);
+
+}  // namespace
+}  // namespace xls
@@ -14,6 +14,9 @@
 
 #include "xls/interpreter/interpreter_proc_runtime.h"
 
+#include <memory>
+#include <vector>
+
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/proc_evaluator.h"
@@ -21,20 +24,42 @@
 #include "xls/ir/proc.h"
 
 namespace xls {
+namespace {
+
+// Creates an interpreter for each proc of the package.
+absl::StatusOr<std::vector<std::unique_ptr<ProcEvaluator>>>
+CreateProcInterpreters(Package* package, ChannelQueueManager* queue_manager,
+                       bool use_compiled_interpreter) {
+  std::vector<std::unique_ptr<ProcEvaluator>> proc_interpreters;
+  for (auto& proc : package->procs()) {
+    if (use_compiled_interpreter) {
+      XLS_ASSIGN_OR_RETURN(
+          std::unique_ptr<CompiledProcInterpreter> proc_interpreter,
+          CompiledProcInterpreter::Create(proc.get(), queue_manager));
+      proc_interpreters.push_back(std::move(proc_interpreter));
+    } else {
+      proc_interpreters.push_back(
+          std::make_unique<ProcInterpreter>(proc.get(), queue_manager));
+    }
+  }
+  return proc_interpreters;
+}
+
+}  // namespace
 
 absl::StatusOr<std::unique_ptr<SerialProcRuntime>>
-CreateInterpreterSerialProcRuntime(Package* package) {
+CreateInterpreterSerialProcRuntime(Package* package,
+                                   bool use_compiled_interpreter) {
   // Create a queue manager for the queues. This factory verifies that there an
   // receive only queue for every receive only channel.
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<ChannelQueueManager> queue_manager,
                        ChannelQueueManager::Create(package));
 
   // Create a ProcInterpreter for each Proc.
-  std::vector<std::unique_ptr<ProcEvaluator>> proc_interpreters;
-  for (auto& proc : package->procs()) {
-    proc_interpreters.push_back(
-        std::make_unique<ProcInterpreter>(proc.get(), queue_manager.get()));
-  }
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<std::unique_ptr<ProcEvaluator>> proc_interpreters,
+      CreateProcInterpreters(package, queue_manager.get(),
+                             use_compiled_interpreter));
 
   // Create a runtime.
   XLS_ASSIGN_OR_RETURN(
@@ -53,4 +78,34 @@ CreateInterpreterSerialProcRuntime(Package* package) {
   return std::move(proc_runtime);
 }
 
+absl::StatusOr<std::unique_ptr<ThreadedProcRuntime>>
+CreateInterpreterThreadedProcRuntime(Package* package, int64_t thread_count,
+                                     bool use_compiled_interpreter) {
+  // ChannelQueues are thread-safe so they may be shared between the workers.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<ChannelQueueManager> queue_manager,
+                       ChannelQueueManager::Create(package));
+
+  // Create a ProcInterpreter for each Proc.
+  XLS_ASSIGN_OR_RETURN(
+      std::vector<std::unique_ptr<ProcEvaluator>> proc_interpreters,
+      CreateProcInterpreters(package, queue_manager.get(),
+                             use_compiled_interpreter));
+
+  // Create a runtime.
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<ThreadedProcRuntime> proc_runtime,
+      ThreadedProcRuntime::Create(package, std::move(proc_interpreters),
+                                  std::move(queue_manager), thread_count));
+
+  // Inject initial values into channels.
+  for (Channel* channel : package->channels()) {
+    ChannelQueue& queue = proc_runtime->queue_manager().GetQueue(channel);
+    for (const Value& value : channel->initial_values()) {
+      XLS_RETURN_IF_ERROR(queue.Write(value));
+    }
+  }
+
+  return std::move(proc_runtime);
+}
+
 }  // namespace xls
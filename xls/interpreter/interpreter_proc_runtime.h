@@ -18,13 +18,26 @@
 #include <memory>
 
 #include "xls/interpreter/serial_proc_runtime.h"
+#include "xls/interpreter/threaded_proc_runtime.h"
 #include "xls/ir/package.h"
 
 namespace xls {
 
-// Create a SerialProcRuntime composed of ProcInterpreters.
+// Create a SerialProcRuntime composed of ProcInterpreters. If
+// `use_compiled_interpreter` is true, CompiledProcInterpreters are used
+// instead, which lower each proc once rather than walking its nodes every
+// tick.
 absl::StatusOr<std::unique_ptr<SerialProcRuntime>>
-CreateInterpreterSerialProcRuntime(Package* package);
+CreateInterpreterSerialProcRuntime(Package* package,
+                                   bool use_compiled_interpreter = false);
+
+// Create a ThreadedProcRuntime composed of ProcInterpreters (or
+// CompiledProcInterpreters if `use_compiled_interpreter` is true).
+// `thread_count` is the number of worker threads (zero selects a default based
+// on the hardware).
+absl::StatusOr<std::unique_ptr<ThreadedProcRuntime>>
+CreateInterpreterThreadedProcRuntime(Package* package, int64_t thread_count = 0,
+                                     bool use_compiled_interpreter = false);
 
 }  // namespace xls
 
@@ -14,6 +14,7 @@
 
 #include "xls/interpreter/proc_interpreter.h"
 
+#include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_join.h"
 #include "xls/interpreter/ir_interpreter.h"
@@ -202,4 +203,81 @@ absl::StatusOr<TickResult> ProcInterpreter::Tick(
                     .progress_made = true};
 }
 
+/* static */
+std::vector<Value> CompiledProcContinuation::ParamValues(
+    absl::Span<const Value> state) {
+  std::vector<Value> params;
+  params.reserve(state.size() + 1);
+  params.push_back(Value::Token());
+  params.insert(params.end(), state.begin(), state.end());
+  return params;
+}
+
+void CompiledProcContinuation::NextTick(std::vector<Value>&& next_state) {
+  instruction_index_ = 0;
+  state_ = next_state;
+  // The slots are reused; every slot is overwritten before it is read.
+  frame_.params = ParamValues(state_);
+}
+
+/* static */
+absl::StatusOr<std::unique_ptr<CompiledProcInterpreter>>
+CompiledProcInterpreter::Create(Proc* proc,
+                                ChannelQueueManager* queue_manager) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<CompiledFunctionBase> compiled,
+                       CompiledFunctionBase::Create(proc));
+  return absl::WrapUnique(
+      new CompiledProcInterpreter(proc, queue_manager, std::move(compiled)));
+}
+
+std::unique_ptr<ProcContinuation> CompiledProcInterpreter::NewContinuation()
+    const {
+  return std::make_unique<CompiledProcContinuation>(proc(), *compiled_,
+                                                    queue_manager_);
+}
+
+absl::StatusOr<TickResult> CompiledProcInterpreter::Tick(
+    ProcContinuation& continuation) const {
+  CompiledProcContinuation* cont =
+      dynamic_cast<CompiledProcContinuation*>(&continuation);
+  XLS_RET_CHECK_NE(cont, nullptr)
+      << "CompiledProcInterpreter requires a continuation of type "
+         "CompiledProcContinuation";
+
+  int64_t starting_index = cont->GetInstructionIndex();
+  CompiledFrame& frame = cont->GetFrame();
+  XLS_ASSIGN_OR_RETURN(int64_t next_index,
+                       compiled_->Execute(frame, starting_index));
+  cont->SetInstructionIndex(next_index);
+  if (frame.sent_channel.has_value()) {
+    XLS_RETURN_IF_ERROR(InterpreterEventsToStatus(cont->GetEvents()));
+    return TickResult{.execution_state = TickExecutionState::kSentOnChannel,
+                      .channel = frame.sent_channel.value(),
+                      .progress_made = next_index != starting_index};
+  }
+  if (frame.blocked_channel.has_value()) {
+    XLS_RETURN_IF_ERROR(InterpreterEventsToStatus(cont->GetEvents()));
+    return TickResult{.execution_state = TickExecutionState::kBlockedOnReceive,
+                      .channel = frame.blocked_channel.value(),
+                      .progress_made = next_index != starting_index};
+  }
+
+  // Proc completed execution of the Tick. Set the next proc state in the
+  // continuation.
+  std::vector<Value> next_state;
+  next_state.reserve(proc()->GetStateElementCount());
+  for (Node* next_node : proc()->NextState()) {
+    next_state.push_back(frame.slots[compiled_->GetSlot(next_node)]);
+  }
+  cont->NextTick(std::move(next_state));
+
+  // Raise a status error if interpreter events indicate failure such as a
+  // failed assert.
+  XLS_RETURN_IF_ERROR(InterpreterEventsToStatus(cont->GetEvents()));
+
+  return TickResult{.execution_state = TickExecutionState::kCompleted,
+                    .channel = std::nullopt,
+                    .progress_made = true};
+}
+
 }  // namespace xls
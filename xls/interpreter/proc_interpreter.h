@@ -24,6 +24,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/compiled_function_base.h"
 #include "xls/interpreter/proc_evaluator.h"
 #include "xls/interpreter/serial_proc_runtime.h"
 #include "xls/ir/events.h"
@@ -100,6 +101,76 @@ class ProcInterpreter : public ProcEvaluator {
   std::vector<Node*> execution_order_;
 };
 
+// A continuation used by the CompiledProcInterpreter.
+class CompiledProcContinuation : public ProcContinuation {
+ public:
+  CompiledProcContinuation(Proc* proc, const CompiledFunctionBase& compiled,
+                           ChannelQueueManager* queue_manager)
+      : compiled_(compiled),
+        state_(proc->InitValues().begin(), proc->InitValues().end()),
+        frame_(compiled.NewFrame(ParamValues(state_), &events_,
+                                 queue_manager)) {}
+
+  ~CompiledProcContinuation() override = default;
+
+  std::vector<Value> GetState() const override { return state_; }
+  const InterpreterEvents& GetEvents() const override { return events_; }
+  InterpreterEvents& GetEvents() override { return events_; }
+  bool AtStartOfTick() const override { return instruction_index_ == 0; }
+
+  // Resets the continuation so it will start executing at the beginning of the
+  // proc with the given state values.
+  void NextTick(std::vector<Value>&& next_state);
+
+  // Gets/sets the index of the instruction of the compiled proc to be executed
+  // next.
+  int64_t GetInstructionIndex() const { return instruction_index_; }
+  void SetInstructionIndex(int64_t index) { instruction_index_ = index; }
+
+  // Returns the frame holding the values computed in the tick so far.
+  CompiledFrame& GetFrame() { return frame_; }
+
+ private:
+  // Returns the values of the proc params: the token followed by the state.
+  static std::vector<Value> ParamValues(absl::Span<const Value> state);
+
+  const CompiledFunctionBase& compiled_;
+  int64_t instruction_index_ = 0;
+  std::vector<Value> state_;
+  InterpreterEvents events_;
+  CompiledFrame frame_;
+};
+
+// An interpreter for an individual proc which lowers the proc into a
+// CompiledFunctionBase once at construction rather than walking the proc nodes
+// on every tick. Behaves identically to ProcInterpreter. Thread-safe if called
+// with different continuations.
+class CompiledProcInterpreter : public ProcEvaluator {
+ public:
+  static absl::StatusOr<std::unique_ptr<CompiledProcInterpreter>> Create(
+      Proc* proc, ChannelQueueManager* queue_manager);
+  CompiledProcInterpreter(const CompiledProcInterpreter&) = delete;
+  CompiledProcInterpreter operator=(const CompiledProcInterpreter&) = delete;
+
+  ~CompiledProcInterpreter() override = default;
+
+  std::unique_ptr<ProcContinuation> NewContinuation() const override;
+  absl::StatusOr<TickResult> Tick(
+      ProcContinuation& continuation) const override;
+  Proc* proc() const override { return proc_; }
+
+ private:
+  CompiledProcInterpreter(Proc* proc, ChannelQueueManager* queue_manager,
+                          std::unique_ptr<CompiledFunctionBase> compiled)
+      : proc_(proc),
+        queue_manager_(queue_manager),
+        compiled_(std::move(compiled)) {}
+
+  Proc* proc_;
+  ChannelQueueManager* queue_manager_;
+  std::unique_ptr<CompiledFunctionBase> compiled_;
+};
+
 }  // namespace xls
 
 #endif  // XLS_INTERPRETER_PROC_INTERPRETER_H_
@@ -37,5 +37,16 @@ INSTANTIATE_TEST_SUITE_P(
           return ChannelQueueManager::Create(package).value();
         })));
 
+INSTANTIATE_TEST_SUITE_P(
+    CompiledProcInterpreterTest, ProcEvaluatorTestBase,
+    testing::Values(ProcEvaluatorTestParam(
+        [](Proc* proc, ChannelQueueManager* queue_manager)
+            -> std::unique_ptr<ProcEvaluator> {
+          return CompiledProcInterpreter::Create(proc, queue_manager).value();
+        },
+        [](Package* package) -> std::unique_ptr<ChannelQueueManager> {
+          return ChannelQueueManager::Create(package).value();
+        })));
+
 }  // namespace
 }  // namespace xls
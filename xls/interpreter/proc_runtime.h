@@ -82,6 +82,11 @@ class ProcRuntime {
   // Reset the state of all of the procs to their initial state.
   void ResetState();
 
+  // Returns the evaluator for a proc in the network.
+  const ProcEvaluator& GetProcEvaluator(Proc* proc) const {
+    return *evaluator_contexts_.at(proc).evaluator;
+  }
+
   // Returns the events for each proc in the network.
   const InterpreterEvents& GetInterpreterEvents(Proc* proc) const {
     return evaluator_contexts_.at(proc).continuation->GetEvents();
@@ -81,6 +81,13 @@ INSTANTIATE_TEST_SUITE_P(
             [](Package* package) -> std::unique_ptr<ProcRuntime> {
               return CreateInterpreterSerialProcRuntime(package).value();
             }),
+        ProcRuntimeTestParam(
+            "compiled_interpreter",
+            [](Package* package) -> std::unique_ptr<ProcRuntime> {
+              return CreateInterpreterSerialProcRuntime(
+                         package, /*use_compiled_interpreter=*/true)
+                  .value();
+            }),
         ProcRuntimeTestParam(
             "jit",
             [](Package* package) -> std::unique_ptr<ProcRuntime> {
@@ -0,0 +1,189 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/threaded_proc_runtime.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT
+
+#include "absl/memory/memory.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+
+namespace xls {
+
+/* static */
+absl::StatusOr<std::unique_ptr<ThreadedProcRuntime>>
+ThreadedProcRuntime::Create(
+    Package* package, std::vector<std::unique_ptr<ProcEvaluator>>&& evaluators,
+    std::unique_ptr<ChannelQueueManager>&& queue_manager,
+    int64_t thread_count) {
+  XLS_RET_CHECK_GE(thread_count, 0);
+  // Verify there exists exactly one evaluator per proc in the package.
+  absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>> evaluator_map;
+  for (std::unique_ptr<ProcEvaluator>& evaluator : evaluators) {
+    Proc* proc = evaluator->proc();
+    auto [it, inserted] = evaluator_map.insert({proc, std::move(evaluator)});
+    XLS_RET_CHECK(inserted) << absl::StreamFormat(
+        "More than one evaluator given for proc `%s`", proc->name());
+  }
+  for (const std::unique_ptr<Proc>& proc : package->procs()) {
+    XLS_RET_CHECK(evaluator_map.contains(proc.get()))
+        << absl::StreamFormat("No evaluator given for proc `%s`", proc->name());
+  }
+  XLS_RET_CHECK_EQ(evaluator_map.size(), package->procs().size())
+      << "More evaluators than procs given.";
+
+  if (thread_count == 0) {
+    thread_count = std::min<int64_t>(
+        std::max<int64_t>(std::thread::hardware_concurrency(), 1),
+        std::max<int64_t>(package->procs().size(), 1));
+  }
+  return absl::WrapUnique(
+      new ThreadedProcRuntime(package, std::move(evaluator_map),
+                              std::move(queue_manager), thread_count));
+}
+
+ThreadedProcRuntime::ThreadedProcRuntime(
+    Package* package,
+    absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>>&& evaluators,
+    std::unique_ptr<ChannelQueueManager>&& queue_manager, int64_t thread_count)
+    : ProcRuntime(package, std::move(evaluators), std::move(queue_manager)) {
+  for (int64_t i = 0; i < thread_count; ++i) {
+    threads_.push_back(std::make_unique<Thread>([this]() { WorkerLoop(); }));
+  }
+}
+
+ThreadedProcRuntime::~ThreadedProcRuntime() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutdown_ = true;
+    work_available_.SignalAll();
+  }
+  // Thread destructors join the workers.
+  threads_.clear();
+}
+
+void ThreadedProcRuntime::WorkerLoop() {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    while (ready_procs_.empty() && !shutdown_) {
+      work_available_.Wait(&mutex_);
+    }
+    if (shutdown_) {
+      return;
+    }
+    Proc* proc = ready_procs_.front();
+    ready_procs_.pop_front();
+    ++running_count_;
+
+    // Each proc is on the ready list at most once and is removed while it is
+    // being ticked so no other worker can touch its continuation.
+    EvaluatorContext& context = evaluator_contexts_.at(proc);
+    mutex_.Unlock();
+    XLS_VLOG(3) << absl::StreamFormat("Ticking proc `%s`", proc->name());
+    absl::StatusOr<TickResult> tick_result =
+        context.evaluator->Tick(*context.continuation);
+    mutex_.Lock();
+
+    --running_count_;
+    if (tick_result.ok()) {
+      XLS_VLOG(3) << "Tick result: " << tick_result.value();
+      HandleTickResult(proc, tick_result.value());
+    } else {
+      if (tick_status_.ok()) {
+        tick_status_ = tick_result.status();
+      }
+      // Drain the ready list so the tick finishes as soon as possible.
+      ready_procs_.clear();
+    }
+    if (TickIsComplete()) {
+      tick_complete_.Signal();
+    }
+  }
+}
+
+void ThreadedProcRuntime::HandleTickResult(Proc* proc,
+                                           const TickResult& tick_result) {
+  progress_made_ |= tick_result.progress_made;
+  if (!tick_status_.ok()) {
+    return;
+  }
+  if (tick_result.execution_state == TickExecutionState::kSentOnChannel) {
+    Channel* channel = tick_result.channel.value();
+    auto it = blocked_procs_.find(channel);
+    if (it != blocked_procs_.end()) {
+      XLS_VLOG(3) << absl::StreamFormat(
+          "Unblocking proc `%s` and adding to ready list", it->second->name());
+      ready_procs_.push_back(it->second);
+      blocked_procs_.erase(it);
+    }
+    // This proc can go back on the ready queue.
+    ready_procs_.push_back(proc);
+    work_available_.SignalAll();
+  } else if (tick_result.execution_state ==
+             TickExecutionState::kBlockedOnReceive) {
+    Channel* channel = tick_result.channel.value();
+    // The sender may have written to the channel after this proc found it
+    // empty but before this result was recorded. Sends are only reported
+    // after the data is in the queue, so checking the queue here under the
+    // lock closes the window.
+    if (!queue_manager_->GetQueue(channel).IsEmpty()) {
+      ready_procs_.push_back(proc);
+      work_available_.Signal();
+      return;
+    }
+    XLS_VLOG(3) << absl::StreamFormat(
+        "Proc `%s` is now blocked on channel `%s`", proc->name(),
+        channel->ToString());
+    blocked_procs_[channel] = proc;
+  }
+}
+
+absl::StatusOr<ThreadedProcRuntime::NetworkTickResult>
+ThreadedProcRuntime::TickInternal() {
+  XLS_VLOG(3) << absl::StreamFormat("TickInternal on package %s",
+                                    package_->name());
+  absl::MutexLock lock(&mutex_);
+  XLS_RET_CHECK(TickIsComplete());
+  blocked_procs_.clear();
+  progress_made_ = false;
+  tick_status_ = absl::OkStatus();
+
+  // Put all procs on the ready list.
+  for (const std::unique_ptr<Proc>& proc : package_->procs()) {
+    ready_procs_.push_back(proc.get());
+  }
+  work_available_.SignalAll();
+  while (!TickIsComplete()) {
+    tick_complete_.Wait(&mutex_);
+  }
+  XLS_RETURN_IF_ERROR(tick_status_);
+
+  std::vector<Channel*> blocked_channels;
+  for (auto [channel, proc] : blocked_procs_) {
+    blocked_channels.push_back(channel);
+  }
+  std::sort(blocked_channels.begin(), blocked_channels.end(),
+            [](Channel* a, Channel* b) { return a->id() < b->id(); });
+  return NetworkTickResult{
+      .progress_made = progress_made_,
+      .blocked_channels = blocked_channels,
+  };
+}
+
+}  // namespace xls
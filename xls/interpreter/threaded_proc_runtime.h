@@ -0,0 +1,110 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_INTERPRETER_THREADED_PROC_RUNTIME_H_
+#define XLS_INTERPRETER_THREADED_PROC_RUNTIME_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/thread.h"
+#include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/proc_evaluator.h"
+#include "xls/interpreter/proc_runtime.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+// Class for interpreting a network of procs on a pool of worker threads. Each
+// network tick, every proc is scheduled on the pool. Procs which block on a
+// receive are parked until another proc sends on the channel they are waiting
+// on, at which point they are rescheduled. A network tick is complete when
+// every proc has either completed its tick or is parked on an empty channel.
+//
+// Procs using only blocking receives produce the same results as under the
+// SerialProcRuntime. Non-blocking receives may observe a different
+// interleaving of data arrival because procs run concurrently.
+//
+// The channel queues held by the queue manager must be thread-safe (e.g., as
+// created by ChannelQueueManager::Create or
+// JitChannelQueueManager::CreateThreadSafe). ThreadedProcRuntimes are
+// thread-compatible, but not thread-safe.
+class ThreadedProcRuntime : public ProcRuntime {
+ public:
+  // Creates and returns a threaded proc network interpreter for the given
+  // package. `thread_count` is the number of worker threads to use. If zero,
+  // the number of threads is the smaller of the number of procs and the number
+  // of hardware threads.
+  static absl::StatusOr<std::unique_ptr<ThreadedProcRuntime>> Create(
+      Package* package,
+      std::vector<std::unique_ptr<ProcEvaluator>>&& evaluators,
+      std::unique_ptr<ChannelQueueManager>&& queue_manager,
+      int64_t thread_count = 0);
+
+  ~ThreadedProcRuntime() override;
+
+  int64_t thread_count() const { return threads_.size(); }
+
+ private:
+  ThreadedProcRuntime(
+      Package* package,
+      absl::flat_hash_map<Proc*, std::unique_ptr<ProcEvaluator>>&& evaluators,
+      std::unique_ptr<ChannelQueueManager>&& queue_manager,
+      int64_t thread_count);
+
+  absl::StatusOr<ThreadedProcRuntime::NetworkTickResult> TickInternal()
+      override;
+
+  // Body of each worker thread. Repeatedly takes procs off the ready list and
+  // ticks them until the runtime is destroyed.
+  void WorkerLoop();
+
+  // Updates the scheduling state given the result of ticking `proc`.
+  void HandleTickResult(Proc* proc, const TickResult& tick_result)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Returns true if the current network tick has no more work to do.
+  bool TickIsComplete() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
+    return ready_procs_.empty() && running_count_ == 0;
+  }
+
+  absl::Mutex mutex_;
+  // Signaled when procs are added to the ready list or on shutdown.
+  absl::CondVar work_available_;
+  // Signaled when the current network tick completes.
+  absl::CondVar tick_complete_;
+
+  // Procs which may be ticked by a worker.
+  std::deque<Proc*> ready_procs_ ABSL_GUARDED_BY(mutex_);
+  // Procs which are blocked and the channels they are blocked on.
+  absl::flat_hash_map<Channel*, Proc*> blocked_procs_ ABSL_GUARDED_BY(mutex_);
+  // Number of procs currently being ticked by a worker.
+  int64_t running_count_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool progress_made_ ABSL_GUARDED_BY(mutex_) = false;
+  // First error encountered during the current network tick.
+  absl::Status tick_status_ ABSL_GUARDED_BY(mutex_);
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::vector<std::unique_ptr<Thread>> threads_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_INTERPRETER_THREADED_PROC_RUNTIME_H_
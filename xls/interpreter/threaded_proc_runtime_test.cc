@@ -0,0 +1,70 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/interpreter/threaded_proc_runtime.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/interpreter/interpreter_proc_runtime.h"
+#include "xls/interpreter/proc_runtime_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/jit/jit_proc_runtime.h"
+
+namespace xls {
+namespace {
+
+// Instantiate and run all the tests in proc_runtime_test_base.cc using a
+// threaded runtime. The single-threaded variants exercise the parking logic
+// when there are fewer workers than procs.
+INSTANTIATE_TEST_SUITE_P(
+    ThreadedProcRuntimeTest, ProcRuntimeTestBase,
+    testing::Values(
+        ProcRuntimeTestParam(
+            "interpreter",
+            [](Package* package) -> std::unique_ptr<ProcRuntime> {
+              return CreateInterpreterThreadedProcRuntime(package).value();
+            }),
+        ProcRuntimeTestParam(
+            "interpreter_one_thread",
+            [](Package* package) -> std::unique_ptr<ProcRuntime> {
+              return CreateInterpreterThreadedProcRuntime(package,
+                                                          /*thread_count=*/1)
+                  .value();
+            }),
+        ProcRuntimeTestParam(
+            "compiled_interpreter",
+            [](Package* package) -> std::unique_ptr<ProcRuntime> {
+              return CreateInterpreterThreadedProcRuntime(
+                         package, /*thread_count=*/0,
+                         /*use_compiled_interpreter=*/true)
+                  .value();
+            }),
+        ProcRuntimeTestParam(
+            "jit",
+            [](Package* package) -> std::unique_ptr<ProcRuntime> {
+              return CreateJitThreadedProcRuntime(package).value();
+            }),
+        ProcRuntimeTestParam(
+            "jit_four_threads",
+            [](Package* package) -> std::unique_ptr<ProcRuntime> {
+              return CreateJitThreadedProcRuntime(package,
+                                                  /*thread_count=*/4)
+                  .value();
+            })),
+    [](const testing::TestParamInfo<ProcRuntimeTestBase::ParamType>& info) {
+      return info.param.name();
+    });
+
+}  // namespace
+}  // namespace xls
@@ -14,25 +14,127 @@
 
 #include "xls/ir/bits_ops.h"
 
+#include <algorithm>
 #include <vector>
 
+#include "absl/base/casts.h"
+#include "absl/types/span.h"
 #include "xls/common/logging/logging.h"
-#include "xls/ir/big_int.h"
+#include "xls/common/math_util.h"
+#include "xls/ir/word_arithmetic.h"
 
 namespace xls {
 namespace bits_ops {
 namespace {
 
-// Converts the given bits value to signed value of the given bit count. Uses
-// truncation or sign-extension to narrow/widen the value.
-Bits TruncateOrSignExtend(const Bits& bits, int64_t bit_count) {
-  if (bits.bit_count() == bit_count) {
-    return bits;
-  } else if (bits.bit_count() < bit_count) {
-    return SignExtend(bits, bit_count);
-  } else {
-    return bits.Slice(0, bit_count);
+// Values wider than 64 bits are held as little-endian vectors of 64-bit words
+// and operated on with the kernels in word_arithmetic.h rather than
+// round-tripping through an arbitrary-precision integer library.
+using Words = std::vector<uint64_t>;
+
+int64_t WordCount(int64_t bit_count) {
+  return CeilOfRatio(bit_count, int64_t{64});
+}
+
+// Returns the value of `bits` as `word_count` words. The value is zero- or
+// sign-extended to fill the words.
+Words ToWords(const Bits& bits, int64_t word_count, bool sign_extend = false) {
+  const InlineBitmap& bitmap = bits.bitmap();
+  bool negative = sign_extend && bits.bit_count() > 0 && bits.msb();
+  Words words(word_count, negative ? ~uint64_t{0} : 0);
+  for (int64_t i = 0; i < bitmap.word_count() && i < word_count; ++i) {
+    words[i] = bitmap.GetWord(i);
+  }
+  if (negative && bits.bit_count() % 64 != 0 &&
+      bitmap.word_count() <= word_count) {
+    words[bitmap.word_count() - 1] |= ~Mask(bits.bit_count() % 64);
+  }
+  return words;
+}
+
+// Returns the value of `words` truncated or zero-extended to `bit_count` bits.
+Bits FromWords(absl::Span<const uint64_t> words, int64_t bit_count) {
+  InlineBitmap bitmap(bit_count);
+  for (int64_t i = 0; i < bitmap.word_count() && i < words.size(); ++i) {
+    bitmap.SetWord(i, words[i]);
+  }
+  return Bits::FromBitmap(std::move(bitmap));
+}
+
+// Negates `words` in place (modulo 2^(64 * words.size())).
+void NegateWords(Words& words) {
+  word_arithmetic::Negate(words.data(), words.size());
+}
+
+// Returns the product of `a` and `b` which has `a.size() + b.size()` words.
+Words MulWords(absl::Span<const uint64_t> a, absl::Span<const uint64_t> b) {
+  Words result(a.size() + b.size());
+  int64_t a_count = word_arithmetic::SignificantWordCount(a.data(), a.size());
+  int64_t b_count = word_arithmetic::SignificantWordCount(b.data(), b.size());
+  if (std::min(a_count, b_count) < word_arithmetic::kKaratsubaMinWordCount) {
+    word_arithmetic::SchoolbookMul(a.data(), a_count, b.data(), b_count,
+                                   result.data());
+    return result;
+  }
+  // Karatsuba requires operands of equal length. Zero-extend the shorter one;
+  // operands of very different lengths are rare in practice.
+  int64_t count = std::max(a_count, b_count);
+  Words a_ext(a.begin(), a.begin() + a_count);
+  Words b_ext(b.begin(), b.begin() + b_count);
+  a_ext.resize(count, 0);
+  b_ext.resize(count, 0);
+  Words product(2 * count);
+  word_arithmetic::KaratsubaMul(a_ext.data(), b_ext.data(), count,
+                                product.data());
+  std::copy(product.begin(), product.begin() + a_count + b_count,
+            result.begin());
+  return result;
+}
+
+// Divides `dividend` by the non-zero `divisor`. The quotient has as many words
+// as the dividend and the remainder as many words as the divisor.
+void DivModWords(absl::Span<const uint64_t> dividend,
+                 absl::Span<const uint64_t> divisor, Words& quotient,
+                 Words& remainder) {
+  quotient.resize(dividend.size());
+  remainder.resize(divisor.size());
+  word_arithmetic::DivMod(dividend.data(), dividend.size(), divisor.data(),
+                          divisor.size(), quotient.data(), remainder.data());
+}
+
+// Returns the magnitude of the signed value `bits` as `word_count` words
+// (which must be enough to hold the sign-extended value). Sets `negative` to
+// whether the value is negative.
+Words SignedMagnitude(const Bits& bits, int64_t word_count, bool& negative) {
+  Words words = ToWords(bits, word_count, /*sign_extend=*/true);
+  negative = bits.bit_count() > 0 && bits.msb();
+  if (negative) {
+    NegateWords(words);
+  }
+  return words;
+}
+
+// Compares `lhs` and `rhs` as signed values. Returns a negative value, zero,
+// or a positive value if `lhs` is less than, equal to, or greater than `rhs`.
+int64_t SCmp(const Bits& lhs, const Bits& rhs) {
+  int64_t word_count =
+      std::max(WordCount(lhs.bit_count()), WordCount(rhs.bit_count()));
+  Words lhs_words = ToWords(lhs, word_count, /*sign_extend=*/true);
+  Words rhs_words = ToWords(rhs, word_count, /*sign_extend=*/true);
+  for (int64_t i = word_count - 1; i >= 0; --i) {
+    if (lhs_words[i] == rhs_words[i]) {
+      continue;
+    }
+    // Only the most significant word carries the sign.
+    if (i == word_count - 1) {
+      return absl::bit_cast<int64_t>(lhs_words[i]) <
+                     absl::bit_cast<int64_t>(rhs_words[i])
+                 ? -1
+                 : 1;
+    }
+    return lhs_words[i] < rhs_words[i] ? -1 : 1;
   }
+  return 0;
 }
 
 }  // namespace
@@ -189,9 +291,12 @@ Bits Add(const Bits& lhs, const Bits& rhs) {
     return UBits(result, lhs.bit_count());
   }
 
-  Bits sum = BigInt::Add(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
-                 .ToSignedBits();
-  return TruncateOrSignExtend(sum, lhs.bit_count());
+  int64_t word_count = WordCount(lhs.bit_count());
+  Words sum = ToWords(lhs, word_count);
+  Words rhs_words = ToWords(rhs, word_count);
+  word_arithmetic::AddInto(sum.data(), word_count, rhs_words.data(),
+                           word_count);
+  return FromWords(sum, lhs.bit_count());
 }
 
 Bits Sub(const Bits& lhs, const Bits& rhs) {
@@ -202,9 +307,12 @@ Bits Sub(const Bits& lhs, const Bits& rhs) {
     uint64_t result = (lhs_int - rhs_int) & Mask(lhs.bit_count());
     return UBits(result, lhs.bit_count());
   }
-  Bits diff = BigInt::Sub(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
-                  .ToSignedBits();
-  return TruncateOrSignExtend(diff, lhs.bit_count());
+  int64_t word_count = WordCount(lhs.bit_count());
+  Words diff = ToWords(lhs, word_count);
+  Words rhs_words = ToWords(rhs, word_count);
+  word_arithmetic::SubtractFrom(diff.data(), word_count, rhs_words.data(),
+                                word_count);
+  return FromWords(diff, lhs.bit_count());
 }
 
 Bits Mul(const Bits& lhs, const Bits& rhs) {
@@ -216,12 +324,12 @@ Bits Mul(const Bits& lhs, const Bits& rhs) {
     return UBits(result, lhs.bit_count());
   }
 
-  BigInt product =
-      BigInt::Mul(BigInt::MakeSigned(SignExtend(lhs, lhs.bit_count())),
-                  BigInt::MakeSigned(SignExtend(rhs, lhs.bit_count())));
-  return product.ToSignedBitsWithBitCount(lhs.bit_count() * 2)
-      .value()
-      .Slice(0, lhs.bit_count());
+  // The low bits of the product are the same for signed and unsigned
+  // operands.
+  int64_t word_count = WordCount(lhs.bit_count());
+  return FromWords(
+      MulWords(ToWords(lhs, word_count), ToWords(rhs, word_count)),
+      lhs.bit_count());
 }
 
 Bits SMul(const Bits& lhs, const Bits& rhs) {
@@ -233,9 +341,17 @@ Bits SMul(const Bits& lhs, const Bits& rhs) {
     return SBits(result, result_width);
   }
 
-  BigInt product =
-      BigInt::Mul(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
-  return product.ToSignedBitsWithBitCount(result_width).value();
+  bool lhs_negative;
+  bool rhs_negative;
+  Words lhs_magnitude = SignedMagnitude(lhs, WordCount(lhs.bit_count()),
+                                        lhs_negative);
+  Words rhs_magnitude = SignedMagnitude(rhs, WordCount(rhs.bit_count()),
+                                        rhs_negative);
+  Words product = MulWords(lhs_magnitude, rhs_magnitude);
+  if (lhs_negative != rhs_negative) {
+    NegateWords(product);
+  }
+  return FromWords(product, result_width);
 }
 
 Bits UMul(const Bits& lhs, const Bits& rhs) {
@@ -247,27 +363,31 @@ Bits UMul(const Bits& lhs, const Bits& rhs) {
     return UBits(result, result_width);
   }
 
-  BigInt product =
-      BigInt::Mul(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
-  return product.ToUnsignedBitsWithBitCount(result_width).value();
+  Words product = MulWords(ToWords(lhs, WordCount(lhs.bit_count())),
+                           ToWords(rhs, WordCount(rhs.bit_count())));
+  return FromWords(product, result_width);
 }
 
 Bits UDiv(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits::AllOnes(lhs.bit_count());
   }
-  BigInt quotient =
-      BigInt::Div(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
-  return ZeroExtend(quotient.ToUnsignedBits(), lhs.bit_count());
+  Words quotient;
+  Words remainder;
+  DivModWords(ToWords(lhs, WordCount(lhs.bit_count())),
+              ToWords(rhs, WordCount(rhs.bit_count())), quotient, remainder);
+  return FromWords(quotient, lhs.bit_count());
 }
 
 Bits UMod(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits(rhs.bit_count());
   }
-  BigInt modulo =
-      BigInt::Mod(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs));
-  return ZeroExtend(modulo.ToUnsignedBits(), rhs.bit_count());
+  Words quotient;
+  Words remainder;
+  DivModWords(ToWords(lhs, WordCount(lhs.bit_count())),
+              ToWords(rhs, WordCount(rhs.bit_count())), quotient, remainder);
+  return FromWords(remainder, rhs.bit_count());
 }
 
 Bits SDiv(const Bits& lhs, const Bits& rhs) {
@@ -285,17 +405,38 @@ Bits SDiv(const Bits& lhs, const Bits& rhs) {
       return ZeroExtend(Bits::AllOnes(lhs.bit_count() - 1), lhs.bit_count());
     }
   }
-  BigInt quotient =
-      BigInt::Div(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
-  return TruncateOrSignExtend(quotient.ToSignedBits(), lhs.bit_count());
+  // Divide the magnitudes. The quotient is rounded toward zero.
+  bool lhs_negative;
+  bool rhs_negative;
+  Words quotient;
+  Words remainder;
+  DivModWords(
+      SignedMagnitude(lhs, WordCount(lhs.bit_count()), lhs_negative),
+      SignedMagnitude(rhs, WordCount(rhs.bit_count()), rhs_negative),
+      quotient, remainder);
+  if (lhs_negative != rhs_negative) {
+    NegateWords(quotient);
+  }
+  return FromWords(quotient, lhs.bit_count());
 }
 
 Bits SMod(const Bits& lhs, const Bits& rhs) {
   if (rhs.IsZero()) {
     return Bits(rhs.bit_count());
   }
-  BigInt modulo = BigInt::Mod(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
-  return TruncateOrSignExtend(modulo.ToSignedBits(), rhs.bit_count());
+  // The remainder has the sign of the dividend.
+  bool lhs_negative;
+  bool rhs_negative;
+  Words quotient;
+  Words remainder;
+  DivModWords(
+      SignedMagnitude(lhs, WordCount(lhs.bit_count()), lhs_negative),
+      SignedMagnitude(rhs, WordCount(rhs.bit_count()), rhs_negative),
+      quotient, remainder);
+  if (lhs_negative) {
+    NegateWords(remainder);
+  }
+  return FromWords(remainder, rhs.bit_count());
 }
 
 bool UEqual(const Bits& lhs, const Bits& rhs) {
@@ -344,7 +485,7 @@ bool ULessThan(const Bits& lhs, int64_t rhs) {
 }
 
 bool SEqual(const Bits& lhs, const Bits& rhs) {
-  return BigInt::MakeSigned(lhs) == BigInt::MakeSigned(rhs);
+  return SCmp(lhs, rhs) == 0;
 }
 
 bool SEqual(const Bits& lhs, int64_t rhs) {
@@ -367,7 +508,7 @@ bool SLessThan(const Bits& lhs, const Bits& rhs) {
   if (lhs.bit_count() <= 64 && rhs.bit_count() <= 64) {
     return lhs.ToInt64().value() < rhs.ToInt64().value();
   }
-  return BigInt::LessThan(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs));
+  return SCmp(lhs, rhs) < 0;
 }
 
 bool SGreaterThanOrEqual(const Bits& lhs, int64_t rhs) {
@@ -419,8 +560,9 @@ Bits Negate(const Bits& bits) {
     return UBits((-bits.ToInt64().value()) & Mask(bits.bit_count()),
                  bits.bit_count());
   }
-  Bits negated = BigInt::Negate(BigInt::MakeSigned(bits)).ToSignedBits();
-  return TruncateOrSignExtend(negated, bits.bit_count());
+  Words negated = ToWords(bits, WordCount(bits.bit_count()));
+  NegateWords(negated);
+  return FromWords(negated, bits.bit_count());
 }
 
 Bits Abs(const Bits& bits) {
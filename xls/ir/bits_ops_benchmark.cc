@@ -0,0 +1,105 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "xls/common/math_util.h"
+#include "xls/ir/big_int.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+
+namespace xls {
+namespace {
+
+// Measures the performance of arithmetic on wide Bits values. The BigInt
+// benchmarks measure the equivalent operations using the arbitrary-precision
+// library bits_ops previously round-tripped through.
+
+Bits RandomBits(int64_t bit_count, std::mt19937_64& bitgen) {
+  std::vector<uint8_t> bytes(CeilOfRatio(bit_count, int64_t{8}));
+  for (uint8_t& byte : bytes) {
+    byte = bitgen();
+  }
+  return Bits::FromBytes(bytes, bit_count);
+}
+
+template <Bits (*kOp)(const Bits&, const Bits&)>
+static void BM_BinaryOp(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  int64_t bit_count = state.range(0);
+  Bits lhs = RandomBits(bit_count, bitgen);
+  // Divide by a value about half as wide as the dividend so long division
+  // does a representative amount of work.
+  Bits rhs = bits_ops::ZeroExtend(RandomBits(bit_count / 2 + 1, bitgen),
+                                  bit_count);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kOp(lhs, rhs));
+  }
+}
+
+static void BM_Negate(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  Bits operand = RandomBits(state.range(0), bitgen);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bits_ops::Negate(operand));
+  }
+}
+
+static void BM_SLessThan(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  Bits lhs = RandomBits(state.range(0), bitgen);
+  Bits rhs = RandomBits(state.range(0), bitgen);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(bits_ops::SLessThan(lhs, rhs));
+  }
+}
+
+template <BigInt (*kOp)(const BigInt&, const BigInt&)>
+static void BM_BigIntBinaryOp(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  int64_t bit_count = state.range(0);
+  Bits lhs = RandomBits(bit_count, bitgen);
+  Bits rhs = bits_ops::ZeroExtend(RandomBits(bit_count / 2 + 1, bitgen),
+                                  bit_count);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        kOp(BigInt::MakeUnsigned(lhs), BigInt::MakeUnsigned(rhs))
+            .ToUnsignedBits());
+  }
+}
+
+// Widths used by our cryptographic designs.
+#define WIDE_BIT_COUNTS \
+  Arg(65)->Arg(128)->Arg(256)->Arg(512)->Arg(1024)->Arg(2048)->Arg(4096)
+
+BENCHMARK_TEMPLATE(BM_BinaryOp, bits_ops::Add)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BinaryOp, bits_ops::Sub)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BinaryOp, bits_ops::UMul)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BinaryOp, bits_ops::SMul)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BinaryOp, bits_ops::UDiv)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BinaryOp, bits_ops::UMod)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BinaryOp, bits_ops::SDiv)->WIDE_BIT_COUNTS;
+BENCHMARK(BM_Negate)->WIDE_BIT_COUNTS;
+BENCHMARK(BM_SLessThan)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BigIntBinaryOp, BigInt::Add)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BigIntBinaryOp, BigInt::Mul)->WIDE_BIT_COUNTS;
+BENCHMARK_TEMPLATE(BM_BigIntBinaryOp, BigInt::Div)->WIDE_BIT_COUNTS;
+
+}  // namespace
+}  // namespace xls
+
+BENCHMARK_MAIN();
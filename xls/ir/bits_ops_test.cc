@@ -14,11 +14,15 @@
 
 #include "xls/ir/bits_ops.h"
 
+#include <random>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/container/inlined_vector.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/matchers.h"
+#include "xls/ir/big_int.h"
 #include "xls/ir/number_parser.h"
 #include "xls/ir/value.h"
 
@@ -828,5 +832,108 @@ TEST(BitsOpsTest, LongestCommonPrefixLSBMoreThan2) {
   EXPECT_EQ(bits_ops::LongestCommonPrefixLSB({x, y, z}), expected);
 }
 
+// Returns the given value truncated or sign-extended to `bit_count` bits.
+Bits TruncateOrSignExtend(const BigInt& value, int64_t bit_count) {
+  Bits bits = value.ToSignedBits();
+  return bits.bit_count() >= bit_count
+             ? bits.Slice(0, bit_count)
+             : bits_ops::SignExtend(bits, bit_count);
+}
+
+// Compares the word-level arithmetic on wide values against BigInt.
+TEST(BitsOpsTest, WideArithmeticMatchesBigInt) {
+  std::mt19937_64 bitgen(42);
+  // Returns a random value of the given width with a random number of
+  // significant bits.
+  auto random_bits = [&](int64_t bit_count) {
+    std::vector<uint8_t> bytes(CeilOfRatio(bit_count, int64_t{8}));
+    for (uint8_t& byte : bytes) {
+      byte = bitgen();
+    }
+    Bits bits = Bits::FromBytes(bytes, bit_count);
+    int64_t significant_bits = bitgen() % (bit_count + 1);
+    return bits_ops::ZeroExtend(bits.Slice(0, significant_bits), bit_count);
+  };
+  for (int64_t bit_count : {65, 127, 128, 200, 1000, 2048, 4096}) {
+    for (int64_t i = 0; i < 8; ++i) {
+      Bits lhs = random_bits(bit_count);
+      Bits rhs = random_bits(bit_count);
+      Bits narrow = random_bits(bit_count / 2 + 1);
+      // Exercise negative operands as well.
+      if (i % 2 == 1) {
+        lhs = bits_ops::Not(lhs);
+      }
+      int64_t narrow_bit_count = narrow.bit_count();
+      BigInt slhs = BigInt::MakeSigned(lhs);
+      BigInt srhs = BigInt::MakeSigned(rhs);
+      BigInt snarrow = BigInt::MakeSigned(narrow);
+      BigInt ulhs = BigInt::MakeUnsigned(lhs);
+      BigInt unarrow = BigInt::MakeUnsigned(narrow);
+
+      EXPECT_EQ(bits_ops::Add(lhs, rhs),
+                TruncateOrSignExtend(BigInt::Add(slhs, srhs), bit_count));
+      EXPECT_EQ(bits_ops::Sub(lhs, rhs),
+                TruncateOrSignExtend(BigInt::Sub(slhs, srhs), bit_count));
+      EXPECT_EQ(bits_ops::Negate(lhs),
+                TruncateOrSignExtend(BigInt::Negate(slhs), bit_count));
+      EXPECT_EQ(bits_ops::UMul(lhs, narrow),
+                BigInt::Mul(ulhs, unarrow)
+                    .ToUnsignedBitsWithBitCount(bit_count + narrow_bit_count)
+                    .value());
+      EXPECT_EQ(bits_ops::SMul(lhs, narrow),
+                BigInt::Mul(slhs, snarrow)
+                    .ToSignedBitsWithBitCount(bit_count + narrow_bit_count)
+                    .value());
+      EXPECT_EQ(bits_ops::SLessThan(lhs, narrow),
+                BigInt::LessThan(slhs, snarrow));
+      EXPECT_EQ(bits_ops::SEqual(lhs, rhs), slhs == srhs);
+      if (narrow.IsZero()) {
+        continue;
+      }
+      EXPECT_EQ(bits_ops::UDiv(lhs, narrow),
+                bits_ops::ZeroExtend(
+                    BigInt::Div(ulhs, unarrow).ToUnsignedBits(), bit_count));
+      EXPECT_EQ(bits_ops::UMod(lhs, narrow),
+                bits_ops::ZeroExtend(
+                    BigInt::Mod(ulhs, unarrow).ToUnsignedBits(),
+                    narrow_bit_count));
+      EXPECT_EQ(bits_ops::SDiv(lhs, narrow),
+                TruncateOrSignExtend(BigInt::Div(slhs, snarrow), bit_count));
+      EXPECT_EQ(bits_ops::SMod(lhs, narrow),
+                TruncateOrSignExtend(BigInt::Mod(slhs, snarrow),
+                                     narrow_bit_count));
+    }
+  }
+}
+
+TEST(BitsOpsTest, SameWidthWideMulMatchesBigInt) {
+  // Operands of 32 or more significant words take the Karatsuba path.
+  std::mt19937_64 bitgen(42);
+  auto random_full_width_bits = [&](int64_t bit_count) {
+    std::vector<uint8_t> bytes(CeilOfRatio(bit_count, int64_t{8}));
+    for (uint8_t& byte : bytes) {
+      byte = bitgen();
+    }
+    // Set the most significant byte so every word is significant.
+    bytes.front() |= 0x80;
+    return Bits::FromBytes(bytes, bit_count);
+  };
+  for (int64_t bit_count : {2048, 4096}) {
+    for (int64_t i = 0; i < 4; ++i) {
+      Bits lhs = random_full_width_bits(bit_count);
+      Bits rhs = random_full_width_bits(bit_count);
+      EXPECT_EQ(bits_ops::UMul(lhs, rhs),
+                BigInt::Mul(BigInt::MakeUnsigned(lhs),
+                            BigInt::MakeUnsigned(rhs))
+                    .ToUnsignedBitsWithBitCount(2 * bit_count)
+                    .value());
+      EXPECT_EQ(bits_ops::SMul(lhs, rhs),
+                BigInt::Mul(BigInt::MakeSigned(lhs), BigInt::MakeSigned(rhs))
+                    .ToSignedBitsWithBitCount(2 * bit_count)
+                    .value());
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xls
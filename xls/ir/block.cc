@@ -228,6 +228,8 @@ std::string Block::DumpIr() const {
 }
 
 absl::Status Block::SetPortNameExactly(std::string_view name, Node* node) {
+  MarkStructureChanged();
+  SaveStateForUndo();
   // TODO(https://github.com/google/xls/issues/477): If this name is an invalid
   // Verilog identifier then an error should be returned.
   XLS_RET_CHECK(node->Is<InputPort>() || node->Is<OutputPort>());
@@ -337,6 +339,8 @@ absl::StatusOr<OutputPort*> Block::AddOutputPort(std::string_view name,
 
 absl::StatusOr<Register*> Block::AddRegister(std::string_view name, Type* type,
                                              std::optional<Reset> reset) {
+  MarkStructureChanged();
+  SaveStateForUndo();
   if (registers_.contains(name)) {
     return absl::InvalidArgumentError(
         absl::StrFormat("Register already exists with name %s", name));
@@ -358,6 +362,8 @@ absl::StatusOr<Register*> Block::AddRegister(std::string_view name, Type* type,
 }
 
 absl::Status Block::RemoveRegister(Register* reg) {
+  MarkStructureChanged();
+  SaveStateForUndo();
   if (!IsOwned(reg)) {
     return absl::InvalidArgumentError("Register is not owned by block.");
   }
@@ -387,6 +393,8 @@ absl::StatusOr<Register*> Block::GetRegister(std::string_view name) const {
 }
 
 absl::Status Block::AddClockPort(std::string_view name) {
+  MarkStructureChanged();
+  SaveStateForUndo();
   if (clock_port_.has_value()) {
     return absl::InternalError("Block already has clock");
   }
@@ -435,8 +443,8 @@ static absl::Status AddToMapOfNodeVectors(
   return absl::OkStatus();
 }
 
-Node* Block::AddNodeInternal(std::unique_ptr<Node> node) {
-  Node* ptr = FunctionBase::AddNodeInternal(std::move(node));
+Node* Block::AddNodeInternal(Node* node, int64_t arena_size) {
+  Node* ptr = FunctionBase::AddNodeInternal(node, arena_size);
   if (RegisterRead* reg_read = dynamic_cast<RegisterRead*>(ptr)) {
     XLS_CHECK_OK(AddToMapOfNodeVectors(reg_read->GetRegister(), reg_read,
                                        &register_reads_));
@@ -535,6 +543,8 @@ absl::StatusOr<RegisterWrite*> Block::GetRegisterWrite(Register* reg) const {
 }
 
 absl::Status Block::ReorderPorts(absl::Span<const std::string> port_names) {
+  MarkStructureChanged();
+  SaveStateForUndo();
   absl::flat_hash_map<std::string, int64_t> port_order;
   for (int64_t i = 0; i < port_names.size(); ++i) {
     port_order[port_names[i]] = i;
@@ -564,6 +574,8 @@ absl::Status Block::ReorderPorts(absl::Span<const std::string> port_names) {
 
 absl::StatusOr<BlockInstantiation*> Block::AddBlockInstantiation(
     std::string_view name, Block* instantiated_block) {
+  MarkStructureChanged();
+  SaveStateForUndo();
   if (instantiations_.contains(name)) {
     return absl::InvalidArgumentError(
         absl::StrFormat("Instantiation already exists with name %s", name));
@@ -582,6 +594,8 @@ absl::StatusOr<BlockInstantiation*> Block::AddBlockInstantiation(
 }
 
 absl::Status Block::RemoveInstantiation(Instantiation* instantiation) {
+  MarkStructureChanged();
+  SaveStateForUndo();
   if (!IsOwned(instantiation)) {
     return absl::InvalidArgumentError("Instantiation is not owned by block.");
   }
@@ -31,15 +31,11 @@
 #include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/type.h"
-#include "xls/ir/unwrapping_iterator.h"
 #include "xls/ir/verifier.h"
 
 namespace xls {
 
 class Function : public FunctionBase {
- private:
-  using NodeList = std::list<std::unique_ptr<Node>>;
-
  public:
   Function(std::string_view name, Package* package)
       : FunctionBase(name, package) {}
@@ -53,6 +49,11 @@ class Function : public FunctionBase {
     XLS_RET_CHECK_EQ(n->function_base(), this) << absl::StreamFormat(
         "Return value node %s is not in this function %s (is in function %s)",
         n->GetName(), name(), n->function_base()->name());
+    if (return_value_ == nullptr || return_value_->GetType() != n->GetType()) {
+      // The signature changed.
+      MarkStructureChanged();
+    }
+    SaveStateForUndo();
     return_value_ = n;
     return absl::OkStatus();
   }
@@ -85,6 +86,8 @@ class Function : public FunctionBase {
   }
 
  private:
+  friend class PackageSnapshot;
+
   Node* return_value_ = nullptr;
 };
 
@@ -25,9 +25,80 @@
 #include "xls/ir/ir_scanner.h"
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/package.h"
+#include "xls/ir/package_snapshot.h"
 #include "xls/ir/proc.h"
 
 namespace xls {
+namespace {
+
+// Empty node slots are compacted away once there are more of them than this
+// and they outnumber the live nodes.
+constexpr int64_t kMinRemovedNodesToCompact = 64;
+
+// Returns true if the given node is part of the token network of a proc, the
+// connectivity of which is checked over the whole proc.
+bool IsProcTokenNode(Node* node) {
+  return TypeHasToken(node->GetType()) && node->function_base()->IsProc();
+}
+
+// Returns true if the addition, removal, or rewiring of the given node can
+// affect invariants which the verifier only checks over the whole function
+// base.
+bool IsStructuralNode(Node* node) {
+  switch (node->op()) {
+    case Op::kParam:
+    case Op::kInputPort:
+    case Op::kOutputPort:
+    case Op::kRegisterRead:
+    case Op::kRegisterWrite:
+    case Op::kInstantiationInput:
+    case Op::kInstantiationOutput:
+    case Op::kSend:
+    case Op::kReceive:
+      return true;
+    default:
+      return IsProcTokenNode(node);
+  }
+}
+
+}  // namespace
+
+FunctionBase::NodeIterator::NodeIterator(const std::vector<NodeSlot>* slots,
+                                         int64_t index, int64_t* active_count)
+    : slots_(slots), index_(index), active_count_(active_count) {
+  if (active_count_ != nullptr) {
+    ++*active_count_;
+  }
+  SkipRemoved();
+}
+
+FunctionBase::NodeIterator& FunctionBase::NodeIterator::operator=(
+    const NodeIterator& other) {
+  if (other.active_count_ != nullptr) {
+    ++*other.active_count_;
+  }
+  if (active_count_ != nullptr) {
+    --*active_count_;
+  }
+  slots_ = other.slots_;
+  index_ = other.index_;
+  active_count_ = other.active_count_;
+  return *this;
+}
+
+FunctionBase::NodeIterator::~NodeIterator() {
+  if (active_count_ != nullptr) {
+    --*active_count_;
+  }
+}
+
+FunctionBase::~FunctionBase() {
+  for (const NodeSlot& slot : nodes_) {
+    if (slot.node != nullptr) {
+      DestroyNode(slot);
+    }
+  }
+}
 
 absl::StatusOr<Param*> FunctionBase::GetParamByName(
     std::string_view param_name) const {
@@ -58,8 +129,10 @@ absl::Status FunctionBase::MoveParamToIndex(Param* param, int64_t index) {
         "Given param is not a member of this function base: " +
         param->ToString());
   }
+  SaveStateForUndo();
   params_.erase(it);
   params_.insert(params_.begin() + index, param);
+  structure_changed_ = true;
   return absl::OkStatus();
 }
 
@@ -82,6 +155,7 @@ absl::StatusOr<Node*> FunctionBase::GetNode(
 absl::Status FunctionBase::RemoveNode(Node* node) {
   XLS_RET_CHECK(node->users().empty()) << node->GetName();
   XLS_RET_CHECK(!HasImplicitUse(node)) << node->GetName();
+  SaveStateForUndo();
   std::vector<Node*> unique_operands;
   for (Node* operand : node->operands()) {
     if (!absl::c_linear_search(unique_operands, operand)) {
@@ -95,13 +169,72 @@ absl::Status FunctionBase::RemoveNode(Node* node) {
     params_.erase(std::remove(params_.begin(), params_.end(), node),
                   params_.end());
   }
-  auto node_it = node_iterators_.find(node);
-  XLS_RET_CHECK(node_it != node_iterators_.end());
-  nodes_.erase(node_it->second);
-  node_iterators_.erase(node_it);
+  if (IsStructuralNode(node)) {
+    structure_changed_ = true;
+  }
+  DropNodeChange(node);
+  int64_t index = node->slot_index_;
+  XLS_RET_CHECK(index >= 0 && index < nodes_.size() &&
+                nodes_[index].node == node)
+      << node->GetName();
+  NodeSlot slot = nodes_[index];
+  nodes_[index].node = nullptr;
+  ++removed_node_count_;
+  PackageSnapshot* snapshot = package_->active_snapshot();
+  // Nodes which existed when the snapshot was taken are kept alive by the
+  // snapshot so that they can be restored.
+  if (snapshot == nullptr || !snapshot->SaveRemovedNode(node, slot)) {
+    DestroyNode(slot);
+  }
+  // Compaction would invalidate the slot indices recorded by the snapshot.
+  if (removed_node_count_ > kMinRemovedNodesToCompact &&
+      removed_node_count_ > node_count() && active_iterator_count_ == 0 &&
+      snapshot == nullptr) {
+    CompactNodes();
+  }
   return absl::OkStatus();
 }
 
+void FunctionBase::DropNodeChange(Node* node) {
+  if (node->change_index_ < 0) {
+    return;
+  }
+  // Move the last entry into the place of the dropped one.
+  int64_t change_index = node->change_index_;
+  node_changes_[change_index] = node_changes_.back();
+  node_changes_[change_index].node->change_index_ = change_index;
+  node_changes_.pop_back();
+  node->change_index_ = -1;
+}
+
+void FunctionBase::SaveStateForUndo() {
+  if (PackageSnapshot* snapshot = package_->active_snapshot();
+      snapshot != nullptr) {
+    snapshot->SaveFunctionBase(this);
+  }
+}
+
+void FunctionBase::DestroyNode(const NodeSlot& slot) {
+  if (slot.arena_size == 0) {
+    delete slot.node;
+    return;
+  }
+  slot.node->~Node();
+  node_arena_.Deallocate(slot.node, slot.arena_size);
+}
+
+void FunctionBase::CompactNodes() {
+  int64_t live = 0;
+  for (const NodeSlot& slot : nodes_) {
+    if (slot.node != nullptr) {
+      slot.node->slot_index_ = live;
+      nodes_[live++] = slot;
+    }
+  }
+  nodes_.resize(live);
+  removed_node_count_ = 0;
+}
+
 absl::Status FunctionBase::Accept(DfsVisitor* visitor) {
   for (Node* node : nodes()) {
     if (node->users().empty()) {
@@ -157,15 +290,42 @@ Block* FunctionBase::AsBlockOrDie() {
   return down_cast<Block*>(this);
 }
 
-Node* FunctionBase::AddNodeInternal(std::unique_ptr<Node> node) {
+Node* FunctionBase::AddNodeInternal(Node* node, int64_t arena_size) {
   XLS_VLOG(4) << absl::StrFormat("Adding node %s to FunctionBase %s",
                                  node->GetName(), name());
+  SaveStateForUndo();
   if (node->Is<Param>()) {
     params_.push_back(node->As<Param>());
   }
-  Node* ptr = node.get();
-  node_iterators_[ptr] = nodes_.insert(nodes_.end(), std::move(node));
-  return ptr;
+  node->slot_index_ = nodes_.size();
+  nodes_.push_back(NodeSlot{.node = node, .arena_size = arena_size});
+  RecordNodeChange(node, /*operands_changed=*/true);
+  return node;
+}
+
+void FunctionBase::RecordNodeChange(Node* node, bool operands_changed) {
+  if (node->slot_index_ < 0) {
+    return;
+  }
+  if (!structure_changed_ &&
+      (operands_changed ? IsStructuralNode(node) : IsProcTokenNode(node))) {
+    structure_changed_ = true;
+  }
+  if (node->change_index_ >= 0) {
+    node_changes_[node->change_index_].operands_changed |= operands_changed;
+    return;
+  }
+  node->change_index_ = node_changes_.size();
+  node_changes_.push_back(
+      NodeChange{.node = node, .operands_changed = operands_changed});
+}
+
+void FunctionBase::ClearChanges() {
+  for (const NodeChange& change : node_changes_) {
+    change.node->change_index_ = -1;
+  }
+  node_changes_.clear();
+  structure_changed_ = false;
 }
 
 /*static*/ std::vector<std::string> FunctionBase::GetIrReservedWords() {
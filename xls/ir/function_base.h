@@ -15,22 +15,29 @@
 #ifndef XLS_IR_FUNCTION_BASE_H_
 #define XLS_IR_FUNCTION_BASE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xls/common/iterator_range.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/ir/dfs_visitor.h"
 #include "xls/ir/name_uniquer.h"
 #include "xls/ir/node.h"
+#include "xls/ir/node_arena.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
 #include "xls/ir/type.h"
-#include "xls/ir/unwrapping_iterator.h"
 #include "xls/ir/verifier.h"
 
 namespace xls {
@@ -41,13 +48,83 @@ class Proc;
 // Base class for Functions and Procs. A holder of a set of nodes.
 class FunctionBase {
  protected:
-  using NodeList = std::list<std::unique_ptr<Node>>;
+  // A slot in the node storage of the function. Slots stay in insertion
+  // order, but compaction (see RemoveNode) drops empty slots and renumbers the
+  // slot indices of the remaining nodes, so slot indices must not be held
+  // across node removals. `arena_size` is the size of the block holding the
+  // node in the node arena, or zero if the node was allocated on the heap
+  // (see AddNode). Removed nodes leave an empty slot (nullptr node) behind.
+  struct NodeSlot {
+    Node* node;
+    int64_t arena_size;
+  };
 
  public:
+  // Iterator over the nodes of a function in the order they were added.
+  // Yields Node* and skips the slots of removed nodes. Nodes may be added and
+  // removed (other than the node currently pointed to) during iteration;
+  // added nodes are visited. While an iterator obtained from the non-const
+  // nodes() is alive the node storage is never compacted.
+  class NodeIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Node*;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Node* const*;
+    using reference = Node*;
+
+    NodeIterator() = default;
+    NodeIterator(const std::vector<NodeSlot>* slots, int64_t index,
+                 int64_t* active_count);
+    NodeIterator(const NodeIterator& other)
+        : NodeIterator(other.slots_, other.index_, other.active_count_) {}
+    NodeIterator& operator=(const NodeIterator& other);
+    ~NodeIterator();
+
+    Node* operator*() const { return (*slots_)[index_].node; }
+    NodeIterator& operator++() {
+      ++index_;
+      SkipRemoved();
+      return *this;
+    }
+    NodeIterator operator++(int) {
+      NodeIterator result = *this;
+      ++*this;
+      return result;
+    }
+    bool operator==(const NodeIterator& other) const {
+      return AtEnd() ? other.AtEnd()
+                     : (!other.AtEnd() && index_ == other.index_);
+    }
+    bool operator!=(const NodeIterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    // The end iterator is at this index so it stays at the end when nodes are
+    // added during iteration.
+    static constexpr int64_t kEndIndex = std::numeric_limits<int64_t>::max();
+
+    bool AtEnd() const { return slots_ == nullptr || index_ >= slots_->size(); }
+    void SkipRemoved() {
+      while (!AtEnd() && (*slots_)[index_].node == nullptr) {
+        ++index_;
+      }
+    }
+
+    const std::vector<NodeSlot>* slots_ = nullptr;
+    int64_t index_ = 0;
+    // Count of live iterators which block compaction, or nullptr if this
+    // iterator does not block compaction.
+    int64_t* active_count_ = nullptr;
+
+    friend class FunctionBase;
+  };
+
   FunctionBase(std::string_view name, Package* package)
       : name_(name),
         package_(package) {}
-  virtual ~FunctionBase() = default;
+  virtual ~FunctionBase();
 
   Package* package() const { return package_; }
   const std::string& name() const { return name_; }
@@ -73,25 +150,37 @@ class FunctionBase {
   // Moves the given param to the given index in the parameter list.
   absl::Status MoveParamToIndex(Param* param, int64_t index);
 
-  int64_t node_count() const { return nodes_.size(); }
+  int64_t node_count() const { return nodes_.size() - removed_node_count_; }
 
   // Expose Nodes, so that transformation passes can operate
   // on this function.
-  xabsl::iterator_range<UnwrappingIterator<NodeList::iterator>> nodes() {
-    return xabsl::make_range(MakeUnwrappingIterator(nodes_.begin()),
-                             MakeUnwrappingIterator(nodes_.end()));
+  xabsl::iterator_range<NodeIterator> nodes() {
+    return xabsl::make_range(
+        NodeIterator(&nodes_, 0, &active_iterator_count_),
+        NodeIterator(&nodes_, NodeIterator::kEndIndex, nullptr));
   }
-  xabsl::iterator_range<UnwrappingIterator<NodeList::const_iterator>> nodes()
-      const {
-    return xabsl::make_range(MakeUnwrappingIterator(nodes_.begin()),
-                             MakeUnwrappingIterator(nodes_.end()));
+  xabsl::iterator_range<NodeIterator> nodes() const {
+    return xabsl::make_range(
+        NodeIterator(&nodes_, 0, nullptr),
+        NodeIterator(&nodes_, NodeIterator::kEndIndex, nullptr));
   }
 
-  // Adds a node to the set owned by this function.
+  // Adds a heap-allocated node to the set owned by this function.
   template <typename T>
   T* AddNode(std::unique_ptr<T> n) {
-    T* ptr = n.get();
-    AddNodeInternal(std::move(n));
+    T* ptr = n.release();
+    AddNodeInternal(ptr, /*arena_size=*/0);
+    return ptr;
+  }
+
+  // Constructs a node of type NodeT in the node arena of this function with
+  // the given constructor arguments and adds it to the function. Nodes which
+  // are created together are adjacent in memory.
+  template <typename NodeT, typename... Args>
+  NodeT* EmplaceNode(Args&&... args) {
+    void* memory = node_arena_.Allocate(sizeof(NodeT));
+    NodeT* ptr = new (memory) NodeT(std::forward<Args>(args)...);
+    AddNodeInternal(ptr, sizeof(NodeT));
     return ptr;
   }
 
@@ -102,16 +191,15 @@ class FunctionBase {
   // to the newly constructed node.
   template <typename NodeT, typename... Args>
   absl::StatusOr<NodeT*> MakeNode(Args&&... args) {
-    NodeT* new_node = AddNode(std::make_unique<NodeT>(
-        std::forward<Args>(args)..., /*name=*/"", this));
+    NodeT* new_node =
+        EmplaceNode<NodeT>(std::forward<Args>(args)..., /*name=*/"", this);
     XLS_RETURN_IF_ERROR(VerifyNode(new_node));
     return new_node;
   }
 
   template <typename NodeT, typename... Args>
   absl::StatusOr<NodeT*> MakeNodeWithName(Args&&... args) {
-    NodeT* new_node =
-        AddNode(std::make_unique<NodeT>(std::forward<Args>(args)..., this));
+    NodeT* new_node = EmplaceNode<NodeT>(std::forward<Args>(args)..., this);
     XLS_RETURN_IF_ERROR(VerifyNode(new_node));
     return new_node;
   }
@@ -149,13 +237,62 @@ class FunctionBase {
   // procs.
   virtual bool HasImplicitUse(Node* node) const = 0;
 
+  // A node which changed since the last checkpoint (see ClearChanges).
+  struct NodeChange {
+    Node* node;
+    // Whether the node was added or had its operands replaced, as opposed to
+    // only having its set of users change.
+    bool operands_changed;
+  };
+
+  // Returns the nodes which were added, had operands replaced, or gained or
+  // lost users since the last checkpoint. Removed nodes are not included. Used
+  // by the incremental verifier (VerifyChangedNodes in verifier.h).
+  absl::Span<const NodeChange> node_changes() const { return node_changes_; }
+
+  // Returns true if a change since the last checkpoint may affect invariants
+  // which are only checked over the function base as a whole (parameters,
+  // ports, registers, instantiations, channel operations, the token network of
+  // a proc, or the signature). Newly created function bases start with this
+  // set.
+  bool structure_changed() const { return structure_changed_; }
+  void MarkStructureChanged() { structure_changed_ = true; }
+
+  // Clears the recorded changes, making the current state the checkpoint.
+  void ClearChanges();
+
  protected:
+  // Node records changes to its operands and users.
+  friend class Node;
+  friend class PackageSnapshot;
+
   FunctionBase(const FunctionBase& other) = delete;
   void operator=(const FunctionBase& other) = delete;
 
-  // Internal virtual helper for adding a node. Returns a pointer to the newly
-  // added node.
-  virtual Node* AddNodeInternal(std::unique_ptr<Node> node);
+  // Internal virtual helper for adding a node which is owned by the function
+  // from here on. `arena_size` is the size of the node's block in the node
+  // arena or zero if the node was allocated on the heap. Returns a pointer to
+  // the newly added node.
+  virtual Node* AddNodeInternal(Node* node, int64_t arena_size);
+
+  // Records that the given node changed. Nodes which are still being
+  // constructed are ignored; they are recorded when added to the function.
+  void RecordNodeChange(Node* node, bool operands_changed);
+
+  // Removes the given node from the changed nodes, if present.
+  void DropNodeChange(Node* node);
+
+  // Records the state of this function base which is not held in its nodes
+  // (node list, parameters, return value, proc state) in the active snapshot
+  // of the package, if any. Must be called before any such state is changed.
+  void SaveStateForUndo();
+
+  // Runs the destructor of the node in the given slot and releases its memory.
+  void DestroyNode(const NodeSlot& slot);
+
+  // Removes the empty slots left behind by removed nodes, updating the slot
+  // indices of the remaining nodes. Preserves the order of the nodes.
+  void CompactNodes();
 
   // Returns a vector containing the reserved words in the IR.
   static std::vector<std::string> GetIrReservedWords();
@@ -163,14 +300,26 @@ class FunctionBase {
   std::string name_;
   Package* package_;
 
-  // Store Nodes in std::list as they can be added and removed arbitrarily and
-  // we want a stable iteration order. Keep a map from instruction pointer to
-  // location in the list for fast lookup.
-  NodeList nodes_;
-  absl::flat_hash_map<const Node*, NodeList::iterator> node_iterators_;
+  // Nodes are stored in a vector of slots in the order they were added, which
+  // gives a stable iteration order over contiguous memory. Each node records
+  // its slot index so removal is constant time; removal empties the slot and
+  // the empty slots are compacted away once they outnumber the live nodes.
+  // Most nodes are allocated in `node_arena_`; the destructor destroys all
+  // nodes before the arena releases its memory.
+  NodeArena node_arena_;
+  std::vector<NodeSlot> nodes_;
+  int64_t removed_node_count_ = 0;
+  // Number of live iterators from the non-const nodes() method. Compaction is
+  // deferred while this is non-zero.
+  int64_t active_iterator_count_ = 0;
 
   std::vector<Param*> params_;
 
+  // Changes since the last checkpoint. Each changed node records its index in
+  // `node_changes_` so removal of a node drops its entry in constant time.
+  std::vector<NodeChange> node_changes_;
+  bool structure_changed_ = true;
+
   NameUniquer node_name_uniquer_ =
       NameUniquer(/*separator=*/"__", GetIrReservedWords());
 };
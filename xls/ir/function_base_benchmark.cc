@@ -0,0 +1,158 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "xls/common/logging/logging.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+// Measures the cost of building, parsing, iterating over, and removing the
+// nodes of large functions, which is dominated by node allocation and the
+// layout of the node storage in FunctionBase.
+
+// Adds a function with `node_count` nodes to the package. Each node uses the
+// previous node and a randomly chosen earlier node so the nodes have a mix of
+// user counts.
+Function* BuildFunction(int64_t node_count, Package* package) {
+  std::mt19937_64 bitgen(42);
+  FunctionBuilder fb("f", package);
+  Type* u32 = package->GetBitsType(32);
+  std::vector<BValue> values = {fb.Param("x", u32), fb.Param("y", u32)};
+  for (int64_t i = 2; i < node_count; ++i) {
+    BValue lhs = values[i - 1];
+    BValue rhs = values[bitgen() % i];
+    switch (i % 3) {
+      case 0:
+        values.push_back(fb.Add(lhs, rhs));
+        break;
+      case 1:
+        values.push_back(fb.Xor(lhs, rhs));
+        break;
+      default:
+        values.push_back(fb.And(lhs, rhs));
+        break;
+    }
+  }
+  return fb.Build().value();
+}
+
+static void BM_BuildFunction(benchmark::State& state) {
+  for (auto _ : state) {
+    Package package("benchmark");
+    benchmark::DoNotOptimize(BuildFunction(state.range(0), &package));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ParsePackage(benchmark::State& state) {
+  Package package("benchmark");
+  BuildFunction(state.range(0), &package);
+  std::string ir = package.DumpIr();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Parser::ParsePackage(ir).value());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IterateNodes(benchmark::State& state) {
+  Package package("benchmark");
+  Function* f = BuildFunction(state.range(0), &package);
+  for (auto _ : state) {
+    int64_t edge_count = 0;
+    for (Node* node : f->nodes()) {
+      edge_count += node->users().size();
+    }
+    benchmark::DoNotOptimize(edge_count);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_IterateUsers(benchmark::State& state) {
+  Package package("benchmark");
+  Function* f = BuildFunction(state.range(0), &package);
+  for (auto _ : state) {
+    int64_t id_sum = 0;
+    for (Node* node : f->nodes()) {
+      for (Node* user : node->users()) {
+        id_sum += user->id();
+      }
+    }
+    benchmark::DoNotOptimize(id_sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Builds a function and removes every node other than the parameters and the
+// return value, users first.
+static void BM_BuildAndRemoveNodes(benchmark::State& state) {
+  for (auto _ : state) {
+    Package package("benchmark");
+    Function* f = BuildFunction(state.range(0), &package);
+    XLS_CHECK_OK(f->set_return_value(f->param(0)));
+    std::vector<Node*> nodes(f->nodes().begin(), f->nodes().end());
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+      if (!(*it)->Is<Param>()) {
+        XLS_CHECK_OK(f->RemoveNode(*it));
+      }
+    }
+    benchmark::DoNotOptimize(f->node_count());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Builds a function in which one parameter has `range(0)` users, moves all of
+// them to the other parameter and removes them in the order they were added,
+// which exercises adding and removing users of high-fanout nodes.
+static void BM_HighFanoutUsers(benchmark::State& state) {
+  for (auto _ : state) {
+    Package package("benchmark");
+    FunctionBuilder fb("f", &package);
+    Type* u32 = package.GetBitsType(32);
+    BValue x = fb.Param("x", u32);
+    BValue y = fb.Param("y", u32);
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      fb.Not(x);
+    }
+    Function* f = fb.BuildWithReturnValue(x).value();
+    std::vector<Node*> users(x.node()->users().begin(),
+                             x.node()->users().end());
+    XLS_CHECK_OK(x.node()->ReplaceUsesWith(y.node()));
+    for (Node* user : users) {
+      XLS_CHECK_OK(f->RemoveNode(user));
+    }
+    benchmark::DoNotOptimize(f->node_count());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_BuildFunction)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_ParsePackage)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_IterateNodes)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_IterateUsers)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_BuildAndRemoveNodes)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_HighFanoutUsers)->Range(1 << 4, 1 << 16);
+
+}  // namespace
+}  // namespace xls
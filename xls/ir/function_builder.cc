@@ -82,8 +82,8 @@ BValue BuilderBase::CreateBValue(Node* node, const SourceInfo& loc) {
 
 template <typename NodeT, typename... Args>
 BValue BuilderBase::AddNode(const SourceInfo& loc, Args&&... args) {
-  last_node_ = function_->AddNode<NodeT>(std::make_unique<NodeT>(
-      loc, std::forward<Args>(args)..., function_.get()));
+  last_node_ = function_->EmplaceNode<NodeT>(loc, std::forward<Args>(args)...,
+                                             function_.get());
   return CreateBValue(last_node_, loc);
 }
 
@@ -220,6 +220,61 @@ TEST_F(FunctionTest, MoveParams) {
   EXPECT_EQ(func->params()[2]->GetName(), "y");
 }
 
+TEST_F(FunctionTest, RemoveManyNodesPreservesOrder) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  BValue x = b.Param("x", p->GetBitsType(32));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, b.BuildWithReturnValue(x));
+
+  std::vector<Node*> literals;
+  for (int64_t i = 0; i < 1000; ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        Literal * literal,
+        func->MakeNode<Literal>(SourceInfo(), Value(UBits(i, 32))));
+    literals.push_back(literal);
+  }
+  // Remove most of the nodes so the node storage is compacted along the way.
+  std::vector<Node*> expected = {x.node()};
+  for (int64_t i = 0; i < literals.size(); ++i) {
+    if (i % 10 == 3) {
+      expected.push_back(literals[i]);
+    } else {
+      XLS_ASSERT_OK(func->RemoveNode(literals[i]));
+    }
+  }
+  EXPECT_EQ(func->node_count(), expected.size());
+  EXPECT_EQ(std::vector<Node*>(func->nodes().begin(), func->nodes().end()),
+            expected);
+
+  // The remaining nodes can still be removed.
+  for (int64_t i = 1; i < expected.size(); ++i) {
+    XLS_ASSERT_OK(func->RemoveNode(expected[i]));
+  }
+  EXPECT_THAT(func->nodes(), ElementsAre(x.node()));
+}
+
+TEST_F(FunctionTest, NodesAddedDuringIterationAreVisited) {
+  auto p = CreatePackage();
+  FunctionBuilder b("f", p.get());
+  BValue x = b.Param("x", p->GetBitsType(32));
+  BValue neg = b.Negate(x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * func, b.BuildWithReturnValue(x));
+
+  std::vector<Node*> visited;
+  for (Node* node : func->nodes()) {
+    visited.push_back(node);
+    if (node == x.node()) {
+      // Removing a later node and adding a new one while iterating.
+      XLS_ASSERT_OK(func->RemoveNode(neg.node()));
+      XLS_ASSERT_OK(
+          func->MakeNode<UnOp>(SourceInfo(), x.node(), Op::kNot).status());
+    }
+  }
+  ASSERT_EQ(visited.size(), 2);
+  EXPECT_EQ(visited[0], x.node());
+  EXPECT_EQ(visited[1]->op(), Op::kNot);
+}
+
 TEST_F(FunctionTest, MakeInvalidNode) {
   Package p(TestName());
   XLS_ASSERT_OK_AND_ASSIGN(Function * func, ParseFunction(R"(
@@ -0,0 +1,489 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/ir_binary_format.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/casts.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/block.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/format_strings.h"
+#include "xls/ir/function.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/register.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+using binary_ir::FunctionBaseTag;
+using binary_ir::TypeTag;
+
+class BinaryIrWriter {
+ public:
+  explicit BinaryIrWriter(const Package& package) : package_(package) {}
+
+  absl::StatusOr<std::string> Write();
+
+ private:
+  void WriteUnsigned(uint64_t value) {
+    while (value >= 0x80) {
+      out_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out_.push_back(static_cast<char>(value));
+  }
+  void WriteSigned(int64_t value) {
+    WriteUnsigned((static_cast<uint64_t>(value) << 1) ^
+                  static_cast<uint64_t>(value >> 63));
+  }
+  void WriteBool(bool value) { WriteUnsigned(value ? 1 : 0); }
+  void WriteString(std::string_view s) {
+    WriteUnsigned(s.size());
+    out_.append(s);
+  }
+
+  // Adds the given type and all of its element types to the type table.
+  void CollectType(Type* type);
+  void WriteType(Type* type) { WriteUnsigned(type_indices_.at(type)); }
+  void WriteTypeTable();
+
+  // Values are written without type information; the reader recovers the
+  // structure from the (already known) type of the value.
+  void WriteValue(const Value& value);
+  void WriteSourceInfo(const SourceInfo& loc);
+
+  void WriteChannel(Channel* channel);
+  absl::Status WriteFunctionBase(FunctionBase* function_base);
+  absl::Status WriteNodes(FunctionBase* function_base);
+  absl::Status WriteNode(Node* node);
+  void WriteValueIndex(Node* node) { WriteUnsigned(value_indices_.at(node)); }
+  // Writes the index of the given function base. Function bases may only
+  // refer to function bases written before them.
+  absl::Status WriteFunctionBaseIndex(const FunctionBase* function_base);
+  void AddValue(Node* node) {
+    int64_t index = value_indices_.size();
+    value_indices_[node] = index;
+  }
+
+  const Package& package_;
+  std::string out_;
+
+  std::vector<Type*> types_;
+  absl::flat_hash_map<Type*, int64_t> type_indices_;
+  absl::flat_hash_map<const FunctionBase*, int64_t> function_base_indices_;
+
+  // State of the function base currently being written.
+  absl::flat_hash_map<Node*, int64_t> value_indices_;
+  absl::flat_hash_map<Register*, int64_t> register_indices_;
+  absl::flat_hash_map<Instantiation*, int64_t> instantiation_indices_;
+};
+
+void BinaryIrWriter::CollectType(Type* type) {
+  if (type_indices_.contains(type)) {
+    return;
+  }
+  if (type->IsTuple()) {
+    for (Type* element_type : type->AsTupleOrDie()->element_types()) {
+      CollectType(element_type);
+    }
+  } else if (type->IsArray()) {
+    CollectType(type->AsArrayOrDie()->element_type());
+  }
+  type_indices_[type] = types_.size();
+  types_.push_back(type);
+}
+
+void BinaryIrWriter::WriteTypeTable() {
+  WriteUnsigned(types_.size());
+  for (Type* type : types_) {
+    switch (type->kind()) {
+      case TypeKind::kBits:
+        WriteUnsigned(static_cast<uint8_t>(TypeTag::kBits));
+        WriteUnsigned(type->AsBitsOrDie()->bit_count());
+        break;
+      case TypeKind::kTuple:
+        WriteUnsigned(static_cast<uint8_t>(TypeTag::kTuple));
+        WriteUnsigned(type->AsTupleOrDie()->size());
+        for (Type* element_type : type->AsTupleOrDie()->element_types()) {
+          WriteType(element_type);
+        }
+        break;
+      case TypeKind::kArray:
+        WriteUnsigned(static_cast<uint8_t>(TypeTag::kArray));
+        WriteUnsigned(type->AsArrayOrDie()->size());
+        WriteType(type->AsArrayOrDie()->element_type());
+        break;
+      case TypeKind::kToken:
+        WriteUnsigned(static_cast<uint8_t>(TypeTag::kToken));
+        break;
+    }
+  }
+}
+
+void BinaryIrWriter::WriteValue(const Value& value) {
+  if (value.IsBits()) {
+    std::vector<uint8_t> bytes = value.bits().ToBytes();
+    out_.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  } else if (value.IsTuple() || value.IsArray()) {
+    for (const Value& element : value.elements()) {
+      WriteValue(element);
+    }
+  }
+}
+
+void BinaryIrWriter::WriteSourceInfo(const SourceInfo& loc) {
+  WriteUnsigned(loc.locations.size());
+  for (const SourceLocation& location : loc.locations) {
+    WriteSigned(location.fileno().value());
+    WriteSigned(location.lineno().value());
+    WriteSigned(location.colno().value());
+  }
+}
+
+void BinaryIrWriter::WriteChannel(Channel* channel) {
+  WriteUnsigned(static_cast<uint8_t>(channel->kind()));
+  WriteString(channel->name());
+  WriteSigned(channel->id());
+  WriteUnsigned(static_cast<uint8_t>(channel->supported_ops()));
+  WriteType(channel->type());
+  WriteUnsigned(channel->initial_values().size());
+  for (const Value& value : channel->initial_values()) {
+    WriteValue(value);
+  }
+  WriteString(channel->metadata().SerializeAsString());
+  if (channel->kind() == ChannelKind::kStreaming) {
+    auto* streaming_channel = down_cast<StreamingChannel*>(channel);
+    WriteUnsigned(
+        static_cast<uint8_t>(streaming_channel->GetFlowControl()));
+    std::optional<int64_t> fifo_depth = streaming_channel->GetFifoDepth();
+    WriteBool(fifo_depth.has_value());
+    if (fifo_depth.has_value()) {
+      WriteSigned(fifo_depth.value());
+    }
+  }
+}
+
+absl::Status BinaryIrWriter::WriteFunctionBaseIndex(
+    const FunctionBase* function_base) {
+  auto it = function_base_indices_.find(function_base);
+  if (it == function_base_indices_.end()) {
+    return absl::UnimplementedError(absl::StrFormat(
+        "Binary IR requires `%s` to be defined before its uses",
+        function_base->name()));
+  }
+  WriteUnsigned(it->second);
+  return absl::OkStatus();
+}
+
+absl::Status BinaryIrWriter::WriteNode(Node* node) {
+  WriteUnsigned(static_cast<int64_t>(node->op()));
+  WriteSigned(node->id());
+  WriteString(node->HasAssignedName() ? node->GetName() : "");
+  WriteType(node->GetType());
+  WriteSourceInfo(node->loc());
+  WriteUnsigned(node->operand_count());
+  for (Node* operand : node->operands()) {
+    WriteValueIndex(operand);
+  }
+
+  // Attributes which are not implied by the type or operands of the node.
+  switch (node->op()) {
+    case Op::kBitSlice:
+      WriteSigned(node->As<BitSlice>()->start());
+      WriteSigned(node->As<BitSlice>()->width());
+      break;
+    case Op::kDynamicBitSlice:
+      WriteSigned(node->As<DynamicBitSlice>()->width());
+      break;
+    case Op::kArraySlice:
+      WriteSigned(node->As<ArraySlice>()->width());
+      break;
+    case Op::kTupleIndex:
+      WriteSigned(node->As<TupleIndex>()->index());
+      break;
+    case Op::kLiteral:
+      WriteValue(node->As<Literal>()->value());
+      break;
+    case Op::kMap:
+      XLS_RETURN_IF_ERROR(
+          WriteFunctionBaseIndex(node->As<Map>()->to_apply()));
+      break;
+    case Op::kInvoke:
+      XLS_RETURN_IF_ERROR(
+          WriteFunctionBaseIndex(node->As<Invoke>()->to_apply()));
+      break;
+    case Op::kCountedFor:
+      WriteSigned(node->As<CountedFor>()->trip_count());
+      WriteSigned(node->As<CountedFor>()->stride());
+      XLS_RETURN_IF_ERROR(
+          WriteFunctionBaseIndex(node->As<CountedFor>()->body()));
+      break;
+    case Op::kDynamicCountedFor:
+      XLS_RETURN_IF_ERROR(
+          WriteFunctionBaseIndex(node->As<DynamicCountedFor>()->body()));
+      break;
+    case Op::kOneHot:
+      WriteBool(node->As<OneHot>()->priority() == LsbOrMsb::kLsb);
+      break;
+    case Op::kSel:
+      WriteBool(node->As<Select>()->default_value().has_value());
+      break;
+    case Op::kReceive:
+      WriteSigned(node->As<Receive>()->channel_id());
+      WriteBool(node->As<Receive>()->is_blocking());
+      break;
+    case Op::kSend:
+      WriteSigned(node->As<Send>()->channel_id());
+      break;
+    case Op::kAssert: {
+      WriteString(node->As<Assert>()->message());
+      std::optional<std::string> label = node->As<Assert>()->label();
+      WriteBool(label.has_value());
+      if (label.has_value()) {
+        WriteString(label.value());
+      }
+      break;
+    }
+    case Op::kTrace:
+      WriteString(StepsToXlsFormatString(node->As<Trace>()->format()));
+      break;
+    case Op::kCover:
+      WriteString(node->As<Cover>()->label());
+      break;
+    case Op::kRegisterRead:
+      WriteUnsigned(
+          register_indices_.at(node->As<RegisterRead>()->GetRegister()));
+      break;
+    case Op::kRegisterWrite: {
+      RegisterWrite* reg_write = node->As<RegisterWrite>();
+      WriteUnsigned(register_indices_.at(reg_write->GetRegister()));
+      WriteBool(reg_write->load_enable().has_value());
+      WriteBool(reg_write->reset().has_value());
+      break;
+    }
+    case Op::kInstantiationInput:
+      WriteUnsigned(instantiation_indices_.at(
+          node->As<InstantiationInput>()->instantiation()));
+      WriteString(node->As<InstantiationInput>()->port_name());
+      break;
+    case Op::kInstantiationOutput:
+      WriteUnsigned(instantiation_indices_.at(
+          node->As<InstantiationOutput>()->instantiation()));
+      WriteString(node->As<InstantiationOutput>()->port_name());
+      break;
+    default:
+      break;
+  }
+  AddValue(node);
+  return absl::OkStatus();
+}
+
+absl::Status BinaryIrWriter::WriteNodes(FunctionBase* function_base) {
+  // Parameters are written as part of the signature.
+  std::vector<Node*> nodes;
+  nodes.reserve(function_base->node_count());
+  for (Node* node : TopoSort(function_base)) {
+    if (!node->Is<Param>()) {
+      nodes.push_back(node);
+    }
+  }
+  WriteUnsigned(nodes.size());
+  for (Node* node : nodes) {
+    XLS_RETURN_IF_ERROR(WriteNode(node));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status BinaryIrWriter::WriteFunctionBase(FunctionBase* function_base) {
+  value_indices_.clear();
+  register_indices_.clear();
+  instantiation_indices_.clear();
+  WriteString(function_base->name());
+
+  if (function_base->IsFunction()) {
+    Function* function = function_base->AsFunctionOrDie();
+    WriteUnsigned(function->params().size());
+    for (Param* param : function->params()) {
+      WriteString(param->GetName());
+      WriteType(param->GetType());
+      WriteSigned(param->id());
+      WriteSourceInfo(param->loc());
+      AddValue(param);
+    }
+    XLS_RETURN_IF_ERROR(WriteNodes(function));
+    Node* return_value = function->return_value();
+    WriteUnsigned(return_value == nullptr
+                      ? 0
+                      : value_indices_.at(return_value) + 1);
+    return absl::OkStatus();
+  }
+
+  if (function_base->IsProc()) {
+    Proc* proc = function_base->AsProcOrDie();
+    WriteString(proc->TokenParam()->GetName());
+    WriteSigned(proc->TokenParam()->id());
+    AddValue(proc->TokenParam());
+    WriteUnsigned(proc->GetStateElementCount());
+    for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+      Param* param = proc->GetStateParam(i);
+      WriteString(param->GetName());
+      WriteType(param->GetType());
+      WriteSigned(param->id());
+      WriteValue(proc->GetInitValueElement(i));
+      AddValue(param);
+    }
+    XLS_RETURN_IF_ERROR(WriteNodes(proc));
+    WriteValueIndex(proc->NextToken());
+    for (Node* next_state : proc->NextState()) {
+      WriteValueIndex(next_state);
+    }
+    return absl::OkStatus();
+  }
+
+  XLS_RET_CHECK(function_base->IsBlock());
+  Block* block = function_base->AsBlockOrDie();
+  WriteUnsigned(block->GetRegisters().size());
+  for (Register* reg : block->GetRegisters()) {
+    int64_t index = register_indices_.size();
+    register_indices_[reg] = index;
+    WriteString(reg->name());
+    WriteType(reg->type());
+    WriteBool(reg->reset().has_value());
+    if (reg->reset().has_value()) {
+      WriteValue(reg->reset()->reset_value);
+      WriteBool(reg->reset()->asynchronous);
+      WriteBool(reg->reset()->active_low);
+    }
+  }
+  WriteUnsigned(block->GetInstantiations().size());
+  for (Instantiation* instantiation : block->GetInstantiations()) {
+    if (instantiation->kind() != InstantiationKind::kBlock) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "Binary IR does not support instantiation `%s` of kind %s",
+          instantiation->name(),
+          InstantiationKindToString(instantiation->kind())));
+    }
+    int64_t index = instantiation_indices_.size();
+    instantiation_indices_[instantiation] = index;
+    WriteString(instantiation->name());
+    XLS_RETURN_IF_ERROR(WriteFunctionBaseIndex(
+        down_cast<BlockInstantiation*>(instantiation)->instantiated_block()));
+  }
+  XLS_RETURN_IF_ERROR(WriteNodes(block));
+  WriteUnsigned(block->GetPorts().size());
+  for (const Block::Port& port : block->GetPorts()) {
+    WriteBool(std::holds_alternative<Block::ClockPort*>(port));
+    WriteString(Block::PortName(port));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> BinaryIrWriter::Write() {
+  out_.append(kBinaryIrMagic);
+  WriteUnsigned(kBinaryIrVersion);
+  WriteUnsigned(kOpLimit);
+  for (int64_t i = 0; i < kOpLimit; ++i) {
+    WriteString(OpToString(static_cast<Op>(i)));
+  }
+  WriteString(package_.name());
+  WriteSigned(package_.next_node_id());
+
+  // Emit the file table sorted by file number so the output is deterministic.
+  std::vector<std::pair<Fileno, std::string_view>> files(
+      package_.fileno_to_name().begin(), package_.fileno_to_name().end());
+  std::sort(files.begin(), files.end());
+  WriteUnsigned(files.size());
+  for (const auto& [fileno, filename] : files) {
+    WriteSigned(fileno.value());
+    WriteString(filename);
+  }
+
+  std::vector<FunctionBase*> function_bases;
+  for (const std::unique_ptr<Function>& function : package_.functions()) {
+    function_bases.push_back(function.get());
+  }
+  for (const std::unique_ptr<Proc>& proc : package_.procs()) {
+    function_bases.push_back(proc.get());
+  }
+  for (const std::unique_ptr<Block>& block : package_.blocks()) {
+    function_bases.push_back(block.get());
+  }
+
+  for (Channel* channel : package_.channels()) {
+    CollectType(channel->type());
+  }
+  for (FunctionBase* function_base : function_bases) {
+    for (Node* node : function_base->nodes()) {
+      CollectType(node->GetType());
+    }
+    if (function_base->IsBlock()) {
+      for (Register* reg : function_base->AsBlockOrDie()->GetRegisters()) {
+        CollectType(reg->type());
+      }
+    }
+  }
+  WriteTypeTable();
+
+  WriteUnsigned(package_.channels().size());
+  for (Channel* channel : package_.channels()) {
+    WriteChannel(channel);
+  }
+
+  WriteUnsigned(function_bases.size());
+  for (FunctionBase* function_base : function_bases) {
+    FunctionBaseTag tag = function_base->IsFunction()
+                              ? FunctionBaseTag::kFunction
+                          : function_base->IsProc() ? FunctionBaseTag::kProc
+                                                    : FunctionBaseTag::kBlock;
+    WriteUnsigned(static_cast<uint8_t>(tag));
+    XLS_RETURN_IF_ERROR(WriteFunctionBase(function_base));
+    int64_t index = function_base_indices_.size();
+    function_base_indices_[function_base] = index;
+  }
+
+  std::optional<FunctionBase*> top = package_.GetTop();
+  WriteUnsigned(top.has_value() ? function_base_indices_.at(top.value()) + 1
+                                : 0);
+  return std::move(out_);
+}
+
+}  // namespace
+
+bool IsBinaryIr(std::string_view data) {
+  return data.substr(0, kBinaryIrMagic.size()) == kBinaryIrMagic;
+}
+
+absl::StatusOr<std::string> PackageToBinary(const Package& package) {
+  return BinaryIrWriter(package).Write();
+}
+
+}  // namespace xls
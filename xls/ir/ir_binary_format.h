@@ -0,0 +1,68 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_IR_BINARY_FORMAT_H_
+#define XLS_IR_IR_BINARY_FORMAT_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+// A compact binary serialization of a Package which is much faster to load
+// than the text IR. The format is versioned: readers reject data written with
+// a different kBinaryIrVersion. Strings and literal bytes are stored inline so
+// a reader can decode directly out of a memory-mapped file.
+//
+// All integers are LEB128 varints (signed integers are zigzag encoded) and
+// strings are a varint length followed by the bytes. A package is laid out
+// as:
+//
+//   magic (kBinaryIrMagic), version
+//   op table: count, op name*       -- maps serialized op numbers to Ops
+//   package name, next node id
+//   file table: count, (fileno, filename)*
+//   type table: count, type*        -- types refer to earlier types by index
+//   channels: count, channel*
+//   function bases: count, function base*
+//   top: function base index plus one, or zero if the package has no top
+//
+// Function bases are emitted functions first, then procs, then blocks in
+// package order, so any function base referred to by a node (e.g., the
+// target of an invoke or an instantiated block) precedes its users. Nodes are
+// emitted in topological order and refer to their operands by index into the
+// values of the enclosing function base (parameters first, then nodes).
+inline constexpr std::string_view kBinaryIrMagic = "XLSIRBIN";
+inline constexpr int64_t kBinaryIrVersion = 1;
+
+// Returns true if the given data begins with the binary IR magic number.
+bool IsBinaryIr(std::string_view data);
+
+// Returns the binary serialization of the given package.
+absl::StatusOr<std::string> PackageToBinary(const Package& package);
+
+namespace binary_ir {
+
+// Tags used in the binary serialization.
+enum class TypeTag : uint8_t { kBits, kTuple, kArray, kToken };
+enum class FunctionBaseTag : uint8_t { kFunction, kProc, kBlock };
+
+}  // namespace binary_ir
+}  // namespace xls
+
+#endif  // XLS_IR_IR_BINARY_FORMAT_H_
@@ -0,0 +1,929 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/ir_binary_parser.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/math_util.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/block.h"
+#include "xls/ir/channel.h"
+#include "xls/ir/channel.pb.h"
+#include "xls/ir/channel_ops.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/instantiation.h"
+#include "xls/ir/ir_binary_format.h"
+#include "xls/ir/lsb_or_msb.h"
+#include "xls/ir/node.h"
+#include "xls/ir/op.h"
+#include "xls/ir/proc.h"
+#include "xls/ir/register.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+#include "xls/ir/verifier.h"
+
+namespace xls {
+namespace {
+
+using binary_ir::FunctionBaseTag;
+using binary_ir::TypeTag;
+
+constexpr int64_t kVariadic = std::numeric_limits<int64_t>::max();
+
+class BinaryIrReader {
+ public:
+  explicit BinaryIrReader(std::string_view data) : data_(data) {}
+
+  absl::StatusOr<std::unique_ptr<Package>> Read();
+
+ private:
+  absl::Status Error(std::string_view message) const {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Malformed binary IR at offset %d: %s", offset_, message));
+  }
+
+  absl::StatusOr<uint64_t> ReadUnsigned();
+  absl::StatusOr<int64_t> ReadSigned();
+  absl::StatusOr<bool> ReadBool();
+  absl::StatusOr<std::string_view> ReadString();
+  // Reads an index which must be less than `limit`.
+  absl::StatusOr<int64_t> ReadIndex(int64_t limit, std::string_view what);
+
+  absl::Status ReadTypeTable();
+  absl::StatusOr<Type*> ReadType();
+  absl::StatusOr<Value> ReadValue(Type* type);
+  absl::StatusOr<SourceInfo> ReadSourceInfo();
+  absl::StatusOr<Function*> ReadFunctionRef();
+  absl::StatusOr<BValue> ReadValueRef();
+
+  absl::Status ReadChannel();
+  absl::StatusOr<FunctionBase*> ReadFunction();
+  absl::StatusOr<FunctionBase*> ReadProc();
+  absl::StatusOr<FunctionBase*> ReadBlock();
+  absl::Status ReadNodes(BuilderBase* builder);
+  absl::StatusOr<BValue> ReadNode(BuilderBase* builder);
+
+  std::string_view data_;
+  int64_t offset_ = 0;
+
+  std::unique_ptr<Package> package_;
+  std::vector<std::optional<Op>> ops_;
+  std::vector<Type*> types_;
+  std::vector<FunctionBase*> function_bases_;
+
+  // State of the function base currently being read. `values_` is indexed by
+  // the value indices used in the serialization.
+  std::vector<BValue> values_;
+  std::vector<Register*> registers_;
+  std::vector<Instantiation*> instantiations_;
+};
+
+absl::StatusOr<uint64_t> BinaryIrReader::ReadUnsigned() {
+  uint64_t result = 0;
+  for (int64_t shift = 0; shift < 64; shift += 7) {
+    if (offset_ >= data_.size()) {
+      return Error("unexpected end of data");
+    }
+    uint8_t byte = static_cast<uint8_t>(data_[offset_++]);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return result;
+    }
+  }
+  return Error("varint is too long");
+}
+
+absl::StatusOr<int64_t> BinaryIrReader::ReadSigned() {
+  XLS_ASSIGN_OR_RETURN(uint64_t value, ReadUnsigned());
+  return static_cast<int64_t>((value >> 1) ^ -(value & 1));
+}
+
+absl::StatusOr<bool> BinaryIrReader::ReadBool() {
+  XLS_ASSIGN_OR_RETURN(uint64_t value, ReadUnsigned());
+  if (value > 1) {
+    return Error("invalid boolean");
+  }
+  return value == 1;
+}
+
+absl::StatusOr<std::string_view> BinaryIrReader::ReadString() {
+  XLS_ASSIGN_OR_RETURN(uint64_t size, ReadUnsigned());
+  if (size > data_.size() - offset_) {
+    return Error("string extends past end of data");
+  }
+  std::string_view result = data_.substr(offset_, size);
+  offset_ += size;
+  return result;
+}
+
+absl::StatusOr<int64_t> BinaryIrReader::ReadIndex(int64_t limit,
+                                                  std::string_view what) {
+  XLS_ASSIGN_OR_RETURN(uint64_t index, ReadUnsigned());
+  if (index >= limit) {
+    return Error(absl::StrFormat("%s index %d out of range", what, index));
+  }
+  return static_cast<int64_t>(index);
+}
+
+absl::Status BinaryIrReader::ReadTypeTable() {
+  XLS_ASSIGN_OR_RETURN(uint64_t count, ReadUnsigned());
+  for (uint64_t i = 0; i < count; ++i) {
+    XLS_ASSIGN_OR_RETURN(uint64_t tag, ReadUnsigned());
+    switch (static_cast<TypeTag>(tag)) {
+      case TypeTag::kBits: {
+        XLS_ASSIGN_OR_RETURN(uint64_t bit_count, ReadUnsigned());
+        if (bit_count > std::numeric_limits<int64_t>::max()) {
+          return Error("bit count out of range");
+        }
+        types_.push_back(package_->GetBitsType(bit_count));
+        break;
+      }
+      case TypeTag::kTuple: {
+        XLS_ASSIGN_OR_RETURN(uint64_t size, ReadUnsigned());
+        std::vector<Type*> element_types;
+        for (uint64_t j = 0; j < size; ++j) {
+          XLS_ASSIGN_OR_RETURN(Type * element_type, ReadType());
+          element_types.push_back(element_type);
+        }
+        types_.push_back(package_->GetTupleType(element_types));
+        break;
+      }
+      case TypeTag::kArray: {
+        XLS_ASSIGN_OR_RETURN(uint64_t size, ReadUnsigned());
+        XLS_ASSIGN_OR_RETURN(Type * element_type, ReadType());
+        if (size > std::numeric_limits<int64_t>::max()) {
+          return Error("array size out of range");
+        }
+        types_.push_back(package_->GetArrayType(size, element_type));
+        break;
+      }
+      case TypeTag::kToken:
+        types_.push_back(package_->GetTokenType());
+        break;
+      default:
+        return Error(absl::StrFormat("invalid type tag %d", tag));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Type*> BinaryIrReader::ReadType() {
+  XLS_ASSIGN_OR_RETURN(int64_t index, ReadIndex(types_.size(), "type"));
+  return types_[index];
+}
+
+absl::StatusOr<Value> BinaryIrReader::ReadValue(Type* type) {
+  switch (type->kind()) {
+    case TypeKind::kBits: {
+      int64_t bit_count = type->AsBitsOrDie()->bit_count();
+      int64_t byte_count = CeilOfRatio(bit_count, int64_t{8});
+      if (byte_count > data_.size() - offset_) {
+        return Error("value extends past end of data");
+      }
+      Bits bits = Bits::FromBytes(
+          absl::MakeConstSpan(
+              reinterpret_cast<const uint8_t*>(data_.data() + offset_),
+              byte_count),
+          bit_count);
+      offset_ += byte_count;
+      return Value(std::move(bits));
+    }
+    case TypeKind::kTuple: {
+      std::vector<Value> elements;
+      elements.reserve(type->AsTupleOrDie()->size());
+      for (Type* element_type : type->AsTupleOrDie()->element_types()) {
+        XLS_ASSIGN_OR_RETURN(Value element, ReadValue(element_type));
+        elements.push_back(std::move(element));
+      }
+      return Value::TupleOwned(std::move(elements));
+    }
+    case TypeKind::kArray: {
+      std::vector<Value> elements;
+      elements.reserve(type->AsArrayOrDie()->size());
+      for (int64_t i = 0; i < type->AsArrayOrDie()->size(); ++i) {
+        XLS_ASSIGN_OR_RETURN(Value element,
+                             ReadValue(type->AsArrayOrDie()->element_type()));
+        elements.push_back(std::move(element));
+      }
+      return Value::ArrayOwned(std::move(elements));
+    }
+    case TypeKind::kToken:
+      return Value::Token();
+  }
+  return Error(absl::StrFormat("unsupported value type %s", type->ToString()));
+}
+
+absl::StatusOr<SourceInfo> BinaryIrReader::ReadSourceInfo() {
+  XLS_ASSIGN_OR_RETURN(uint64_t count, ReadUnsigned());
+  SourceInfo loc;
+  for (uint64_t i = 0; i < count; ++i) {
+    XLS_ASSIGN_OR_RETURN(int64_t fileno, ReadSigned());
+    XLS_ASSIGN_OR_RETURN(int64_t lineno, ReadSigned());
+    XLS_ASSIGN_OR_RETURN(int64_t colno, ReadSigned());
+    loc.locations.push_back(
+        SourceLocation(Fileno(static_cast<int32_t>(fileno)),
+                       Lineno(static_cast<int32_t>(lineno)),
+                       Colno(static_cast<int32_t>(colno))));
+  }
+  return loc;
+}
+
+absl::StatusOr<Function*> BinaryIrReader::ReadFunctionRef() {
+  XLS_ASSIGN_OR_RETURN(int64_t index,
+                       ReadIndex(function_bases_.size(), "function"));
+  if (!function_bases_[index]->IsFunction()) {
+    return Error(absl::StrFormat("%s is not a function",
+                                 function_bases_[index]->name()));
+  }
+  return function_bases_[index]->AsFunctionOrDie();
+}
+
+absl::StatusOr<BValue> BinaryIrReader::ReadValueRef() {
+  XLS_ASSIGN_OR_RETURN(int64_t index, ReadIndex(values_.size(), "value"));
+  return values_[index];
+}
+
+absl::Status BinaryIrReader::ReadChannel() {
+  XLS_ASSIGN_OR_RETURN(uint64_t kind, ReadUnsigned());
+  XLS_ASSIGN_OR_RETURN(std::string_view name, ReadString());
+  XLS_ASSIGN_OR_RETURN(int64_t id, ReadSigned());
+  XLS_ASSIGN_OR_RETURN(uint64_t supported_ops, ReadUnsigned());
+  if (supported_ops > static_cast<uint64_t>(ChannelOps::kSendReceive)) {
+    return Error(absl::StrFormat("invalid channel ops %d", supported_ops));
+  }
+  XLS_ASSIGN_OR_RETURN(Type * type, ReadType());
+  XLS_ASSIGN_OR_RETURN(uint64_t initial_value_count, ReadUnsigned());
+  std::vector<Value> initial_values;
+  for (uint64_t i = 0; i < initial_value_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(Value value, ReadValue(type));
+    initial_values.push_back(std::move(value));
+  }
+  XLS_ASSIGN_OR_RETURN(std::string_view metadata_bytes, ReadString());
+  ChannelMetadataProto metadata;
+  if (!metadata.ParseFromArray(metadata_bytes.data(),
+                               metadata_bytes.size())) {
+    return Error(absl::StrFormat("invalid metadata for channel %s", name));
+  }
+
+  switch (static_cast<ChannelKind>(kind)) {
+    case ChannelKind::kStreaming: {
+      XLS_ASSIGN_OR_RETURN(uint64_t flow_control, ReadUnsigned());
+      if (flow_control > static_cast<uint64_t>(FlowControl::kReadyValid)) {
+        return Error(absl::StrFormat("invalid flow control %d", flow_control));
+      }
+      XLS_ASSIGN_OR_RETURN(bool has_fifo_depth, ReadBool());
+      std::optional<int64_t> fifo_depth;
+      if (has_fifo_depth) {
+        XLS_ASSIGN_OR_RETURN(fifo_depth, ReadSigned());
+      }
+      return package_
+          ->CreateStreamingChannel(
+              name, static_cast<ChannelOps>(supported_ops), type,
+              initial_values, fifo_depth,
+              static_cast<FlowControl>(flow_control), metadata, id)
+          .status();
+    }
+    case ChannelKind::kSingleValue:
+      if (!initial_values.empty()) {
+        return Error(absl::StrFormat(
+            "single value channel %s cannot have initial value(s)", name));
+      }
+      return package_
+          ->CreateSingleValueChannel(
+              name, static_cast<ChannelOps>(supported_ops), type, metadata, id)
+          .status();
+  }
+  return Error(absl::StrFormat("invalid channel kind %d", kind));
+}
+
+absl::StatusOr<BValue> BinaryIrReader::ReadNode(BuilderBase* builder) {
+  XLS_ASSIGN_OR_RETURN(int64_t op_number, ReadIndex(ops_.size(), "op"));
+  if (!ops_[op_number].has_value()) {
+    return Error(absl::StrFormat("unknown op number %d", op_number));
+  }
+  Op op = ops_[op_number].value();
+  XLS_ASSIGN_OR_RETURN(int64_t id, ReadSigned());
+  XLS_ASSIGN_OR_RETURN(std::string_view name, ReadString());
+  XLS_ASSIGN_OR_RETURN(Type * type, ReadType());
+  XLS_ASSIGN_OR_RETURN(SourceInfo loc, ReadSourceInfo());
+  XLS_ASSIGN_OR_RETURN(uint64_t operand_count, ReadUnsigned());
+  if (operand_count > values_.size()) {
+    return Error(absl::StrFormat("too many operands (%d) for %s",
+                                 operand_count, OpToString(op)));
+  }
+  std::vector<BValue> operands;
+  operands.reserve(operand_count);
+  for (uint64_t i = 0; i < operand_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(BValue operand, ReadValueRef());
+    operands.push_back(operand);
+  }
+
+  auto expect_operands = [&](int64_t min,
+                             int64_t max = -1) -> absl::Status {
+    if (max < 0) {
+      max = min;
+    }
+    if (operands.size() < min || operands.size() > max) {
+      return Error(absl::StrFormat("%s has invalid operand count %d",
+                                   OpToString(op), operands.size()));
+    }
+    return absl::OkStatus();
+  };
+  auto bit_count = [&]() -> absl::StatusOr<int64_t> {
+    if (!type->IsBits()) {
+      return Error(absl::StrFormat("%s must have bits type, has %s",
+                                   OpToString(op), type->ToString()));
+    }
+    return type->AsBitsOrDie()->bit_count();
+  };
+  auto operand_span = [&](int64_t start, int64_t end) {
+    return absl::MakeConstSpan(operands).subspan(start, end - start);
+  };
+  auto block_builder = [&]() -> absl::StatusOr<BlockBuilder*> {
+    if (!builder->function()->IsBlock()) {
+      return Error(absl::StrFormat("%s is only supported in blocks",
+                                   OpToString(op)));
+    }
+    return static_cast<BlockBuilder*>(builder);
+  };
+  auto proc_builder = [&]() -> absl::StatusOr<ProcBuilder*> {
+    if (!builder->function()->IsProc()) {
+      return Error(absl::StrFormat("%s is only supported in procs",
+                                   OpToString(op)));
+    }
+    return static_cast<ProcBuilder*>(builder);
+  };
+  auto channel = [&](int64_t channel_id) -> absl::StatusOr<Channel*> {
+    if (!package_->HasChannelWithId(channel_id)) {
+      return Error(absl::StrFormat("no such channel with channel ID %d",
+                                   channel_id));
+    }
+    return package_->GetChannel(channel_id);
+  };
+
+  BValue bvalue;
+  switch (op) {
+    case Op::kParam:
+      return Error("parameters must be declared in the signature");
+    case Op::kBitSlice: {
+      XLS_RETURN_IF_ERROR(expect_operands(1));
+      XLS_ASSIGN_OR_RETURN(int64_t start, ReadSigned());
+      XLS_ASSIGN_OR_RETURN(int64_t width, ReadSigned());
+      bvalue = builder->BitSlice(operands[0], start, width, loc, name);
+      break;
+    }
+    case Op::kDynamicBitSlice: {
+      XLS_RETURN_IF_ERROR(expect_operands(2));
+      XLS_ASSIGN_OR_RETURN(int64_t width, ReadSigned());
+      bvalue = builder->DynamicBitSlice(operands[0], operands[1], width, loc,
+                                        name);
+      break;
+    }
+    case Op::kArraySlice: {
+      XLS_RETURN_IF_ERROR(expect_operands(2));
+      XLS_ASSIGN_OR_RETURN(int64_t width, ReadSigned());
+      bvalue =
+          builder->ArraySlice(operands[0], operands[1], width, loc, name);
+      break;
+    }
+    case Op::kTupleIndex: {
+      XLS_RETURN_IF_ERROR(expect_operands(1));
+      XLS_ASSIGN_OR_RETURN(int64_t index, ReadSigned());
+      bvalue = builder->TupleIndex(operands[0], index, loc, name);
+      break;
+    }
+    case Op::kLiteral: {
+      XLS_RETURN_IF_ERROR(expect_operands(0));
+      XLS_ASSIGN_OR_RETURN(Value value, ReadValue(type));
+      bvalue = builder->Literal(std::move(value), loc, name);
+      break;
+    }
+    case Op::kMap: {
+      XLS_RETURN_IF_ERROR(expect_operands(1));
+      XLS_ASSIGN_OR_RETURN(Function * to_apply, ReadFunctionRef());
+      bvalue = builder->Map(operands[0], to_apply, loc, name);
+      break;
+    }
+    case Op::kInvoke: {
+      XLS_ASSIGN_OR_RETURN(Function * to_apply, ReadFunctionRef());
+      bvalue = builder->Invoke(operands, to_apply, loc, name);
+      break;
+    }
+    case Op::kCountedFor: {
+      XLS_RETURN_IF_ERROR(expect_operands(1, kVariadic));
+      XLS_ASSIGN_OR_RETURN(int64_t trip_count, ReadSigned());
+      XLS_ASSIGN_OR_RETURN(int64_t stride, ReadSigned());
+      XLS_ASSIGN_OR_RETURN(Function * body, ReadFunctionRef());
+      bvalue = builder->CountedFor(operands[0], trip_count, stride, body,
+                                   operand_span(1, operands.size()), loc,
+                                   name);
+      break;
+    }
+    case Op::kDynamicCountedFor: {
+      XLS_RETURN_IF_ERROR(expect_operands(3, kVariadic));
+      XLS_ASSIGN_OR_RETURN(Function * body, ReadFunctionRef());
+      bvalue = builder->DynamicCountedFor(
+          operands[0], operands[1], operands[2], body,
+          operand_span(3, operands.size()), loc, name);
+      break;
+    }
+    case Op::kOneHot: {
+      XLS_RETURN_IF_ERROR(expect_operands(1));
+      XLS_ASSIGN_OR_RETURN(bool lsb_prio, ReadBool());
+      bvalue = builder->OneHot(operands[0],
+                               lsb_prio ? LsbOrMsb::kLsb : LsbOrMsb::kMsb,
+                               loc, name);
+      break;
+    }
+    case Op::kOneHotSel:
+      XLS_RETURN_IF_ERROR(expect_operands(2, kVariadic));
+      bvalue = builder->OneHotSelect(
+          operands[0], operand_span(1, operands.size()), loc, name);
+      break;
+    case Op::kPrioritySel:
+      XLS_RETURN_IF_ERROR(expect_operands(2, kVariadic));
+      bvalue = builder->PrioritySelect(
+          operands[0], operand_span(1, operands.size()), loc, name);
+      break;
+    case Op::kSel: {
+      XLS_ASSIGN_OR_RETURN(bool has_default, ReadBool());
+      XLS_RETURN_IF_ERROR(expect_operands(has_default ? 2 : 1, kVariadic));
+      int64_t cases_end = operands.size() - (has_default ? 1 : 0);
+      std::optional<BValue> default_value;
+      if (has_default) {
+        default_value = operands.back();
+      }
+      bvalue = builder->Select(operands[0], operand_span(1, cases_end),
+                               default_value, loc, name);
+      break;
+    }
+    case Op::kTuple:
+      bvalue = builder->Tuple(operands, loc, name);
+      break;
+    case Op::kAfterAll:
+      bvalue = builder->AfterAll(operands, loc, name);
+      break;
+    case Op::kArray:
+      if (!type->IsArray()) {
+        return Error(absl::StrFormat("array must have array type, has %s",
+                                     type->ToString()));
+      }
+      bvalue = builder->Array(operands, type->AsArrayOrDie()->element_type(),
+                              loc, name);
+      break;
+    case Op::kArrayIndex:
+      XLS_RETURN_IF_ERROR(expect_operands(1, kVariadic));
+      bvalue = builder->ArrayIndex(operands[0],
+                                   operand_span(1, operands.size()), loc, name);
+      break;
+    case Op::kArrayUpdate:
+      XLS_RETURN_IF_ERROR(expect_operands(2, kVariadic));
+      bvalue = builder->ArrayUpdate(operands[0], operands[1],
+                                    operand_span(2, operands.size()), loc,
+                                    name);
+      break;
+    case Op::kArrayConcat:
+      bvalue = builder->ArrayConcat(operands, loc, name);
+      break;
+    case Op::kConcat:
+      bvalue = builder->Concat(operands, loc, name);
+      break;
+    case Op::kZeroExt:
+    case Op::kSignExt: {
+      XLS_RETURN_IF_ERROR(expect_operands(1));
+      XLS_ASSIGN_OR_RETURN(int64_t new_bit_count, bit_count());
+      bvalue = op == Op::kZeroExt
+                   ? builder->ZeroExtend(operands[0], new_bit_count, loc, name)
+                   : builder->SignExtend(operands[0], new_bit_count, loc, name);
+      break;
+    }
+    case Op::kEncode:
+      XLS_RETURN_IF_ERROR(expect_operands(1));
+      bvalue = builder->Encode(operands[0], loc, name);
+      break;
+    case Op::kDecode: {
+      XLS_RETURN_IF_ERROR(expect_operands(1));
+      XLS_ASSIGN_OR_RETURN(int64_t width, bit_count());
+      bvalue = builder->Decode(operands[0], width, loc, name);
+      break;
+    }
+    case Op::kSMul:
+    case Op::kUMul: {
+      XLS_RETURN_IF_ERROR(expect_operands(2));
+      XLS_ASSIGN_OR_RETURN(int64_t width, bit_count());
+      bvalue =
+          builder->AddArithOp(op, operands[0], operands[1], width, loc, name);
+      break;
+    }
+    case Op::kSMulp:
+    case Op::kUMulp: {
+      XLS_RETURN_IF_ERROR(expect_operands(2));
+      if (!type->IsTuple() || type->AsTupleOrDie()->size() != 2 ||
+          !type->AsTupleOrDie()->element_type(0)->IsBits()) {
+        return Error(absl::StrFormat("%s has invalid type %s", OpToString(op),
+                                     type->ToString()));
+      }
+      bvalue = builder->AddPartialProductOp(
+          op, operands[0], operands[1],
+          type->AsTupleOrDie()->element_type(0)->GetFlatBitCount(), loc, name);
+      break;
+    }
+    case Op::kReceive: {
+      XLS_RETURN_IF_ERROR(expect_operands(1, 2));
+      XLS_ASSIGN_OR_RETURN(ProcBuilder * pb, proc_builder());
+      XLS_ASSIGN_OR_RETURN(int64_t channel_id, ReadSigned());
+      XLS_ASSIGN_OR_RETURN(bool is_blocking, ReadBool());
+      XLS_ASSIGN_OR_RETURN(Channel * ch, channel(channel_id));
+      if (operands.size() == 2) {
+        bvalue = is_blocking ? pb->ReceiveIf(ch, operands[0], operands[1],
+                                             loc, name)
+                             : pb->ReceiveIfNonBlocking(ch, operands[0],
+                                                        operands[1], loc, name);
+      } else {
+        bvalue = is_blocking
+                     ? pb->Receive(ch, operands[0], loc, name)
+                     : pb->ReceiveNonBlocking(ch, operands[0], loc, name);
+      }
+      break;
+    }
+    case Op::kSend: {
+      XLS_RETURN_IF_ERROR(expect_operands(2, 3));
+      XLS_ASSIGN_OR_RETURN(ProcBuilder * pb, proc_builder());
+      XLS_ASSIGN_OR_RETURN(int64_t channel_id, ReadSigned());
+      XLS_ASSIGN_OR_RETURN(Channel * ch, channel(channel_id));
+      bvalue = operands.size() == 3
+                   ? pb->SendIf(ch, operands[0], operands[2], operands[1], loc,
+                                name)
+                   : pb->Send(ch, operands[0], operands[1], loc, name);
+      break;
+    }
+    case Op::kAssert: {
+      XLS_RETURN_IF_ERROR(expect_operands(2));
+      XLS_ASSIGN_OR_RETURN(std::string_view message, ReadString());
+      XLS_ASSIGN_OR_RETURN(bool has_label, ReadBool());
+      std::optional<std::string> label;
+      if (has_label) {
+        XLS_ASSIGN_OR_RETURN(std::string_view label_view, ReadString());
+        label = std::string(label_view);
+      }
+      bvalue = builder->Assert(operands[0], operands[1], message, label, loc,
+                               name);
+      break;
+    }
+    case Op::kTrace: {
+      XLS_RETURN_IF_ERROR(expect_operands(2, kVariadic));
+      XLS_ASSIGN_OR_RETURN(std::string_view format, ReadString());
+      bvalue = builder->Trace(operands[0], operands[1],
+                              operand_span(2, operands.size()), format, loc,
+                              name);
+      break;
+    }
+    case Op::kCover: {
+      XLS_RETURN_IF_ERROR(expect_operands(2));
+      XLS_ASSIGN_OR_RETURN(std::string_view label, ReadString());
+      bvalue = builder->Cover(operands[0], operands[1], label, loc, name);
+      break;
+    }
+    case Op::kBitSliceUpdate:
+      XLS_RETURN_IF_ERROR(expect_operands(3));
+      bvalue = builder->BitSliceUpdate(operands[0], operands[1], operands[2],
+                                       loc, name);
+      break;
+    case Op::kGate:
+      XLS_RETURN_IF_ERROR(expect_operands(2));
+      bvalue = builder->Gate(operands[0], operands[1], loc, name);
+      break;
+    case Op::kInputPort: {
+      XLS_RETURN_IF_ERROR(expect_operands(0));
+      XLS_ASSIGN_OR_RETURN(BlockBuilder * bb, block_builder());
+      bvalue = bb->InputPort(name, type, loc);
+      break;
+    }
+    case Op::kOutputPort: {
+      XLS_RETURN_IF_ERROR(expect_operands(1));
+      XLS_ASSIGN_OR_RETURN(BlockBuilder * bb, block_builder());
+      bvalue = bb->OutputPort(name, operands[0], loc);
+      break;
+    }
+    case Op::kRegisterRead: {
+      XLS_RETURN_IF_ERROR(expect_operands(0));
+      XLS_ASSIGN_OR_RETURN(BlockBuilder * bb, block_builder());
+      XLS_ASSIGN_OR_RETURN(int64_t reg, ReadIndex(registers_.size(),
+                                                  "register"));
+      bvalue = bb->RegisterRead(registers_[reg], loc, name);
+      break;
+    }
+    case Op::kRegisterWrite: {
+      XLS_ASSIGN_OR_RETURN(BlockBuilder * bb, block_builder());
+      XLS_ASSIGN_OR_RETURN(int64_t reg, ReadIndex(registers_.size(),
+                                                  "register"));
+      XLS_ASSIGN_OR_RETURN(bool has_load_enable, ReadBool());
+      XLS_ASSIGN_OR_RETURN(bool has_reset, ReadBool());
+      XLS_RETURN_IF_ERROR(expect_operands(1 + has_load_enable + has_reset));
+      std::optional<BValue> load_enable;
+      std::optional<BValue> reset;
+      if (has_load_enable) {
+        load_enable = operands[1];
+      }
+      if (has_reset) {
+        reset = operands.back();
+      }
+      bvalue = bb->RegisterWrite(registers_[reg], operands[0], load_enable,
+                                 reset, loc, name);
+      break;
+    }
+    case Op::kInstantiationInput:
+    case Op::kInstantiationOutput: {
+      XLS_RETURN_IF_ERROR(
+          expect_operands(op == Op::kInstantiationInput ? 1 : 0));
+      XLS_ASSIGN_OR_RETURN(BlockBuilder * bb, block_builder());
+      XLS_ASSIGN_OR_RETURN(
+          int64_t instantiation,
+          ReadIndex(instantiations_.size(), "instantiation"));
+      XLS_ASSIGN_OR_RETURN(std::string_view port_name, ReadString());
+      bvalue = op == Op::kInstantiationInput
+                   ? bb->InstantiationInput(instantiations_[instantiation],
+                                            port_name, operands[0], loc, name)
+                   : bb->InstantiationOutput(instantiations_[instantiation],
+                                             port_name, loc, name);
+      break;
+    }
+    default:
+      if (IsOpClass<BinOp>(op) || IsOpClass<CompareOp>(op)) {
+        XLS_RETURN_IF_ERROR(expect_operands(2));
+        bvalue = IsOpClass<BinOp>(op)
+                     ? builder->AddBinOp(op, operands[0], operands[1], loc,
+                                         name)
+                     : builder->AddCompareOp(op, operands[0], operands[1], loc,
+                                             name);
+      } else if (IsOpClass<UnOp>(op)) {
+        XLS_RETURN_IF_ERROR(expect_operands(1));
+        bvalue = builder->AddUnOp(op, operands[0], loc, name);
+      } else if (IsOpClass<BitwiseReductionOp>(op)) {
+        XLS_RETURN_IF_ERROR(expect_operands(1));
+        bvalue = builder->AddBitwiseReductionOp(op, operands[0], loc, name);
+      } else if (IsOpClass<NaryOp>(op)) {
+        bvalue = builder->AddNaryOp(op, operands, loc, name);
+      } else {
+        return Error(absl::StrFormat("unsupported op %s", OpToString(op)));
+      }
+  }
+
+  // The builder records the first error and returns invalid values from then
+  // on. The error is reported when the function base is built.
+  if (bvalue.valid()) {
+    Node* node = bvalue.node();
+    if (node->GetType() != type) {
+      return Error(absl::StrFormat("declared type %s of %s does not match %s",
+                                   type->ToString(), node->GetName(),
+                                   node->GetType()->ToString()));
+    }
+    node->SetId(id);
+  }
+  return bvalue;
+}
+
+absl::Status BinaryIrReader::ReadNodes(BuilderBase* builder) {
+  XLS_ASSIGN_OR_RETURN(uint64_t count, ReadUnsigned());
+  if (count > data_.size() - offset_) {
+    return Error("node count exceeds the size of the data");
+  }
+  values_.reserve(values_.size() + count);
+  for (uint64_t i = 0; i < count; ++i) {
+    XLS_ASSIGN_OR_RETURN(BValue bvalue, ReadNode(builder));
+    values_.push_back(bvalue);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<FunctionBase*> BinaryIrReader::ReadFunction() {
+  XLS_ASSIGN_OR_RETURN(std::string_view name, ReadString());
+  // Like the text parser, defer verification to the end of parsing.
+  FunctionBuilder fb(name, package_.get(), /*should_verify=*/false);
+  XLS_ASSIGN_OR_RETURN(uint64_t param_count, ReadUnsigned());
+  for (uint64_t i = 0; i < param_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(std::string_view param_name, ReadString());
+    XLS_ASSIGN_OR_RETURN(Type * type, ReadType());
+    XLS_ASSIGN_OR_RETURN(int64_t id, ReadSigned());
+    XLS_ASSIGN_OR_RETURN(SourceInfo loc, ReadSourceInfo());
+    BValue param = fb.Param(param_name, type, loc);
+    if (param.valid()) {
+      param.node()->SetId(id);
+    }
+    values_.push_back(param);
+  }
+  XLS_RETURN_IF_ERROR(ReadNodes(&fb));
+  XLS_ASSIGN_OR_RETURN(uint64_t return_index, ReadUnsigned());
+  if (return_index == 0 || return_index > values_.size()) {
+    return Error(absl::StrFormat("invalid return value for function %s",
+                                 name));
+  }
+  return fb.BuildWithReturnValue(values_[return_index - 1]);
+}
+
+absl::StatusOr<FunctionBase*> BinaryIrReader::ReadProc() {
+  XLS_ASSIGN_OR_RETURN(std::string_view name, ReadString());
+  XLS_ASSIGN_OR_RETURN(std::string_view token_name, ReadString());
+  XLS_ASSIGN_OR_RETURN(int64_t token_id, ReadSigned());
+  ProcBuilder pb(name, token_name, package_.get(), /*should_verify=*/false);
+  pb.GetTokenParam().node()->SetId(token_id);
+  values_.push_back(pb.GetTokenParam());
+  XLS_ASSIGN_OR_RETURN(uint64_t state_count, ReadUnsigned());
+  for (uint64_t i = 0; i < state_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(std::string_view state_name, ReadString());
+    XLS_ASSIGN_OR_RETURN(Type * type, ReadType());
+    XLS_ASSIGN_OR_RETURN(int64_t id, ReadSigned());
+    XLS_ASSIGN_OR_RETURN(Value init_value, ReadValue(type));
+    BValue state = pb.StateElement(state_name, init_value);
+    if (state.valid()) {
+      state.node()->SetId(id);
+    }
+    values_.push_back(state);
+  }
+  XLS_RETURN_IF_ERROR(ReadNodes(&pb));
+  XLS_ASSIGN_OR_RETURN(BValue next_token, ReadValueRef());
+  std::vector<BValue> next_state;
+  for (uint64_t i = 0; i < state_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(BValue next, ReadValueRef());
+    next_state.push_back(next);
+  }
+  return pb.Build(next_token, next_state);
+}
+
+absl::StatusOr<FunctionBase*> BinaryIrReader::ReadBlock() {
+  XLS_ASSIGN_OR_RETURN(std::string_view name, ReadString());
+  BlockBuilder bb(name, package_.get(), /*should_verify=*/false);
+  XLS_ASSIGN_OR_RETURN(uint64_t register_count, ReadUnsigned());
+  for (uint64_t i = 0; i < register_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(std::string_view register_name, ReadString());
+    XLS_ASSIGN_OR_RETURN(Type * type, ReadType());
+    XLS_ASSIGN_OR_RETURN(bool has_reset, ReadBool());
+    std::optional<Reset> reset;
+    if (has_reset) {
+      XLS_ASSIGN_OR_RETURN(Value reset_value, ReadValue(type));
+      XLS_ASSIGN_OR_RETURN(bool asynchronous, ReadBool());
+      XLS_ASSIGN_OR_RETURN(bool active_low, ReadBool());
+      reset = Reset{.reset_value = std::move(reset_value),
+                    .asynchronous = asynchronous,
+                    .active_low = active_low};
+    }
+    XLS_ASSIGN_OR_RETURN(Register * reg,
+                         bb.block()->AddRegister(register_name, type, reset));
+    registers_.push_back(reg);
+  }
+  XLS_ASSIGN_OR_RETURN(uint64_t instantiation_count, ReadUnsigned());
+  for (uint64_t i = 0; i < instantiation_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(std::string_view instantiation_name, ReadString());
+    XLS_ASSIGN_OR_RETURN(int64_t index,
+                         ReadIndex(function_bases_.size(), "block"));
+    if (!function_bases_[index]->IsBlock()) {
+      return Error(absl::StrFormat("%s is not a block",
+                                   function_bases_[index]->name()));
+    }
+    XLS_ASSIGN_OR_RETURN(
+        Instantiation * instantiation,
+        bb.block()->AddBlockInstantiation(
+            instantiation_name, function_bases_[index]->AsBlockOrDie()));
+    instantiations_.push_back(instantiation);
+  }
+  XLS_RETURN_IF_ERROR(ReadNodes(&bb));
+  XLS_ASSIGN_OR_RETURN(Block * block, bb.Build());
+
+  XLS_ASSIGN_OR_RETURN(uint64_t port_count, ReadUnsigned());
+  std::vector<std::string> port_names;
+  for (uint64_t i = 0; i < port_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(bool is_clock, ReadBool());
+    XLS_ASSIGN_OR_RETURN(std::string_view port_name, ReadString());
+    if (is_clock) {
+      XLS_RETURN_IF_ERROR(block->AddClockPort(port_name));
+    }
+    port_names.push_back(std::string(port_name));
+  }
+  XLS_RETURN_IF_ERROR(block->ReorderPorts(port_names));
+  return block;
+}
+
+absl::StatusOr<std::unique_ptr<Package>> BinaryIrReader::Read() {
+  if (!IsBinaryIr(data_)) {
+    return absl::InvalidArgumentError("Data is not in the binary IR format");
+  }
+  offset_ = kBinaryIrMagic.size();
+  XLS_ASSIGN_OR_RETURN(uint64_t version, ReadUnsigned());
+  if (version != kBinaryIrVersion) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported binary IR version %d (expected %d)",
+                        version, kBinaryIrVersion));
+  }
+  XLS_ASSIGN_OR_RETURN(uint64_t op_count, ReadUnsigned());
+  for (uint64_t i = 0; i < op_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(std::string_view op_name, ReadString());
+    absl::StatusOr<Op> op = StringToOp(op_name);
+    ops_.push_back(op.ok() ? std::make_optional(op.value()) : std::nullopt);
+  }
+
+  XLS_ASSIGN_OR_RETURN(std::string_view package_name, ReadString());
+  package_ = std::make_unique<Package>(package_name);
+  XLS_ASSIGN_OR_RETURN(int64_t next_node_id, ReadSigned());
+
+  XLS_ASSIGN_OR_RETURN(uint64_t file_count, ReadUnsigned());
+  for (uint64_t i = 0; i < file_count; ++i) {
+    XLS_ASSIGN_OR_RETURN(int64_t fileno, ReadSigned());
+    XLS_ASSIGN_OR_RETURN(std::string_view filename, ReadString());
+    package_->SetFileno(Fileno(static_cast<int32_t>(fileno)), filename);
+  }
+
+  XLS_RETURN_IF_ERROR(ReadTypeTable());
+
+  XLS_ASSIGN_OR_RETURN(uint64_t channel_count, ReadUnsigned());
+  for (uint64_t i = 0; i < channel_count; ++i) {
+    XLS_RETURN_IF_ERROR(ReadChannel());
+  }
+
+  XLS_ASSIGN_OR_RETURN(uint64_t function_base_count, ReadUnsigned());
+  for (uint64_t i = 0; i < function_base_count; ++i) {
+    values_.clear();
+    registers_.clear();
+    instantiations_.clear();
+    XLS_ASSIGN_OR_RETURN(uint64_t tag, ReadUnsigned());
+    FunctionBase* function_base;
+    switch (static_cast<FunctionBaseTag>(tag)) {
+      case FunctionBaseTag::kFunction: {
+        XLS_ASSIGN_OR_RETURN(function_base, ReadFunction());
+        break;
+      }
+      case FunctionBaseTag::kProc: {
+        XLS_ASSIGN_OR_RETURN(function_base, ReadProc());
+        break;
+      }
+      case FunctionBaseTag::kBlock: {
+        XLS_ASSIGN_OR_RETURN(function_base, ReadBlock());
+        break;
+      }
+      default:
+        return Error(absl::StrFormat("invalid function base tag %d", tag));
+    }
+    function_bases_.push_back(function_base);
+  }
+
+  XLS_ASSIGN_OR_RETURN(uint64_t top_index, ReadUnsigned());
+  if (top_index > function_bases_.size()) {
+    return Error("top index out of range");
+  }
+  if (top_index > 0) {
+    XLS_RETURN_IF_ERROR(package_->SetTop(function_bases_[top_index - 1]));
+  }
+  if (offset_ != data_.size()) {
+    return Error("trailing data");
+  }
+  package_->set_next_node_id(std::max(package_->next_node_id(), next_node_id));
+  return std::move(package_);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<Package>> ParsePackageBinaryNoVerify(
+    std::string_view data, std::optional<std::string_view> filename) {
+  std::string filename_str =
+      filename.has_value() ? std::string(filename.value()) : "<unknown file>";
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       BinaryIrReader(data).Read(),
+                       _ << "@ " << filename_str);
+  return package;
+}
+
+absl::StatusOr<std::unique_ptr<Package>> ParsePackageBinary(
+    std::string_view data, std::optional<std::string_view> filename) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       ParsePackageBinaryNoVerify(data, filename));
+  XLS_RETURN_IF_ERROR(VerifyPackage(package.get()));
+  return package;
+}
+
+}  // namespace xls
@@ -0,0 +1,42 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_IR_BINARY_PARSER_H_
+#define XLS_IR_IR_BINARY_PARSER_H_
+
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+
+// Parses a package serialized in the binary IR format (see
+// ir_binary_format.h and Package::ToBinary) and verifies it. `filename` is
+// only used in error messages. The data is decoded in place so it may point
+// into a memory-mapped file.
+absl::StatusOr<std::unique_ptr<Package>> ParsePackageBinary(
+    std::string_view data,
+    std::optional<std::string_view> filename = std::nullopt);
+
+// As above but the package is not verified.
+absl::StatusOr<std::unique_ptr<Package>> ParsePackageBinaryNoVerify(
+    std::string_view data,
+    std::optional<std::string_view> filename = std::nullopt);
+
+}  // namespace xls
+
+#endif  // XLS_IR_IR_BINARY_PARSER_H_
@@ -0,0 +1,244 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/ir_binary_parser.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_binary_format.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/ir/source_location.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+// Parses the given IR text, serializes it to the binary format and back, and
+// checks that the result dumps to the same text.
+void CheckRoundTrip(std::string_view ir) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(ir));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary, package->ToBinary());
+  EXPECT_TRUE(IsBinaryIr(binary));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> round_tripped,
+                           ParsePackageBinary(binary));
+  EXPECT_EQ(round_tripped->DumpIr(), package->DumpIr());
+  EXPECT_EQ(round_tripped->next_node_id(), package->next_node_id());
+}
+
+TEST(IrBinaryParserTest, RoundTripFunctions) {
+  CheckRoundTrip(R"(package test
+
+fn body(i: bits[4], acc: bits[11], inv: bits[11]) -> bits[11] {
+  zero_ext.1: bits[11] = zero_ext(i, new_bit_count=11, id=1)
+  add.2: bits[11] = add(zero_ext.1, acc, id=2)
+  ret xor.3: bits[11] = xor(add.2, inv, id=3)
+}
+
+fn negate(x: bits[8]) -> bits[8] {
+  ret neg.4: bits[8] = neg(x, id=4)
+}
+
+top fn main(x: bits[8], y: bits[32], a: bits[8][4], t: (bits[8], bits[32]), s: bits[2]) -> (bits[8], bits[11], bits[8][4], bits[32], bits[64]) {
+  literal.10: bits[11] = literal(value=1234, id=10, pos=[(0,1,3), (1,2,4)])
+  inv: bits[11] = literal(value=7, id=11)
+  counted_for.12: bits[11] = counted_for(literal.10, trip_count=7, stride=2, body=body, invariant_args=[inv], id=12)
+  map.13: bits[8][4] = map(a, to_apply=negate, id=13)
+  invoke.14: bits[8] = invoke(x, to_apply=negate, id=14)
+  tuple_index.15: bits[32] = tuple_index(t, index=1, id=15)
+  bit_slice.16: bits[8] = bit_slice(y, start=3, width=8, id=16)
+  dynamic_bit_slice.17: bits[8] = dynamic_bit_slice(y, x, width=8, id=17)
+  sel.18: bits[8] = sel(s, cases=[x, invoke.14, bit_slice.16], default=dynamic_bit_slice.17, id=18)
+  one_hot.19: bits[3] = one_hot(s, lsb_prio=false, id=19)
+  one_hot_sel.20: bits[8] = one_hot_sel(s, cases=[x, invoke.14], id=20)
+  priority_sel.21: bits[8] = priority_sel(s, cases=[x, sel.18], id=21)
+  array_index.22: bits[8] = array_index(map.13, indices=[s], id=22)
+  array_update.23: bits[8][4] = array_update(a, one_hot_sel.20, indices=[s], id=23)
+  umul.24: bits[64] = umul(y, tuple_index.15, id=24)
+  smulp.25: (bits[32], bits[32]) = smulp(y, y, id=25)
+  tuple_index.26: bits[32] = tuple_index(smulp.25, index=0, id=26)
+  decode.27: bits[4] = decode(s, width=4, id=27)
+  encode.28: bits[2] = encode(decode.27, id=28)
+  sign_ext.29: bits[32] = sign_ext(encode.28, new_bit_count=32, id=29)
+  concat.30: bits[64] = concat(sign_ext.29, tuple_index.26, id=30)
+  add.31: bits[64] = add(concat.30, umul.24, id=31)
+  and_reduce.32: bits[1] = and_reduce(add.31, id=32)
+  array.33: bits[8][4] = array(priority_sel.21, array_index.22, x, x, id=33)
+  array_slice.34: bits[8][4] = array_slice(array.33, s, width=4, id=34)
+  bit_slice_update.35: bits[32] = bit_slice_update(y, s, x, id=35)
+  gate.36: bits[32] = gate(and_reduce.32, bit_slice_update.35, id=36)
+  ret tuple.37: (bits[8], bits[11], bits[8][4], bits[32], bits[64]) = tuple(priority_sel.21, counted_for.12, array_slice.34, gate.36, add.31)
+}
+)");
+}
+
+TEST(IrBinaryParserTest, RoundTripProc) {
+  CheckRoundTrip(R"(package test
+
+chan in(bits[32], id=0, kind=streaming, ops=receive_only, flow_control=ready_valid, metadata="""""")
+chan out(bits[32], initial_values={1, 2}, id=1, kind=streaming, ops=send_only, flow_control=none, fifo_depth=3, metadata="""""")
+chan in2(bits[32], id=2, kind=streaming, ops=receive_only, flow_control=ready_valid, metadata="""""")
+chan config((bits[8], bits[1]), id=7, kind=single_value, ops=receive_only, metadata="""""")
+
+top proc my_proc(tkn: token, st: bits[32], arr: bits[4][2], init={42, [1, 2]}) {
+  receive.1: (token, bits[32]) = receive(tkn, channel_id=0, id=1)
+  tuple_index.2: token = tuple_index(receive.1, index=0, id=2)
+  tuple_index.3: bits[32] = tuple_index(receive.1, index=1, id=3)
+  receive.4: (token, (bits[8], bits[1])) = receive(tuple_index.2, channel_id=7, id=4)
+  tuple_index.5: token = tuple_index(receive.4, index=0, id=5)
+  literal.6: bits[1] = literal(value=1, id=6)
+  receive.7: (token, bits[32], bits[1]) = receive(tuple_index.5, predicate=literal.6, blocking=false, channel_id=2, id=7)
+  tuple_index.8: token = tuple_index(receive.7, index=0, id=8)
+  add.9: bits[32] = add(st, tuple_index.3, id=9)
+  send.10: token = send(tuple_index.8, add.9, predicate=literal.6, channel_id=1, id=10)
+  assert.11: token = assert(send.10, literal.6, message="st overflowed", label="st_assert", id=11)
+  trace.12: token = trace(assert.11, literal.6, format="st is {:x}", data_operands=[st], id=12)
+  cover.13: token = cover(trace.12, literal.6, label="st_cover", id=13)
+  after_all.14: token = after_all(cover.13, tkn, id=14)
+  next (after_all.14, add.9, arr)
+}
+)");
+}
+
+TEST(IrBinaryParserTest, RoundTripBlocks) {
+  CheckRoundTrip(R"(package test
+
+block sub_block(in: bits[38], out: bits[32]) {
+  in: bits[38] = input_port(name=in, id=1)
+  zero: bits[32] = literal(value=0, id=2)
+  out: () = output_port(zero, name=out, id=3)
+}
+
+top block my_block(clk: clock, rst: bits[1], x: bits[38], le: bits[1], y: bits[32]) {
+  reg foo(bits[32], reset_value=42, asynchronous=true, active_low=false)
+  reg bar(bits[32])
+  instantiation inst(block=sub_block, kind=block)
+  rst: bits[1] = input_port(name=rst, id=4)
+  x: bits[38] = input_port(name=x, id=5)
+  le: bits[1] = input_port(name=le, id=6)
+  inst_in: () = instantiation_input(x, instantiation=inst, port_name=in, id=7)
+  inst_out: bits[32] = instantiation_output(instantiation=inst, port_name=out, id=8)
+  foo_d: () = register_write(inst_out, register=foo, load_enable=le, reset=rst, id=9)
+  foo_q: bits[32] = register_read(register=foo, id=10)
+  bar_d: () = register_write(foo_q, register=bar, id=11)
+  bar_q: bits[32] = register_read(register=bar, id=12)
+  y: () = output_port(bar_q, name=y, id=13)
+}
+)");
+}
+
+TEST(IrBinaryParserTest, RoundTripFileNames) {
+  Package package("test");
+  Fileno fileno = package.GetOrCreateFileno("foo/bar.x");
+  FunctionBuilder fb("f", &package);
+  fb.Not(fb.Param("x", package.GetBitsType(8)),
+         SourceInfo(SourceLocation(fileno, Lineno(3), Colno(5))));
+  XLS_ASSERT_OK(fb.Build().status());
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary, package.ToBinary());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> round_tripped,
+                           ParsePackageBinary(binary));
+  EXPECT_EQ(round_tripped->DumpIr(), package.DumpIr());
+  EXPECT_EQ(round_tripped->GetFilename(fileno), "foo/bar.x");
+}
+
+TEST(IrBinaryParserTest, ParsePackageFileDetectsBinary) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package test
+
+top fn f(x: bits[8]) -> bits[8] {
+  ret neg.1: bits[8] = neg(x, id=1)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary, package->ToBinary());
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent(binary, ".irb"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> from_file,
+                           Parser::ParsePackageFile(temp_file.path()));
+  EXPECT_EQ(from_file->DumpIr(), package->DumpIr());
+}
+
+TEST(IrBinaryParserTest, ParsePackageFileChecksFormat) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package test
+
+top fn f(x: bits[8]) -> bits[8] {
+  ret neg.1: bits[8] = neg(x, id=1)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary, package->ToBinary());
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile binary_file,
+                           TempFile::CreateWithContent(binary, ".irb"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      TempFile text_file,
+      TempFile::CreateWithContent(package->DumpIr(), ".ir"));
+
+  XLS_EXPECT_OK(
+      Parser::ParsePackageFile(binary_file.path(), /*binary=*/true).status());
+  XLS_EXPECT_OK(
+      Parser::ParsePackageFile(text_file.path(), /*binary=*/false).status());
+  EXPECT_THAT(
+      Parser::ParsePackageFile(binary_file.path(), /*binary=*/false).status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Expected text IR")));
+  EXPECT_THAT(
+      Parser::ParsePackageFile(text_file.path(), /*binary=*/true).status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Expected binary IR")));
+}
+
+TEST(IrBinaryParserTest, MalformedInput) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackage(R"(package test
+
+top fn f(x: bits[8], y: bits[8]) -> bits[8] {
+  ret add.1: bits[8] = add(x, y, id=1)
+}
+)"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::string binary, package->ToBinary());
+
+  EXPECT_THAT(ParsePackageBinary("package test"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("not in the binary IR format")));
+
+  std::string bad_version = binary;
+  bad_version[kBinaryIrMagic.size()] = 0x7f;
+  EXPECT_THAT(ParsePackageBinary(bad_version),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Unsupported binary IR version 127")));
+
+  // Every proper prefix of the data is rejected.
+  for (int64_t size = kBinaryIrMagic.size(); size < binary.size(); ++size) {
+    EXPECT_THAT(ParsePackageBinary(binary.substr(0, size)),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Malformed binary IR")))
+        << size;
+  }
+
+  EXPECT_THAT(ParsePackageBinary(binary + "x"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("trailing data")));
+}
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,165 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/ir_interner.h"
+
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+
+IrInterner::IrInterner() {
+  for (std::atomic<BitsType*>& type : small_bits_types_) {
+    type.store(nullptr, std::memory_order_relaxed);
+  }
+  owned_types_.insert(&token_type_);
+}
+
+BitsType* IrInterner::GetBitsType(int64_t bit_count) {
+  bool is_small = bit_count >= 0 && bit_count < kSmallBitsTypeCount;
+  if (is_small) {
+    BitsType* type =
+        small_bits_types_[bit_count].load(std::memory_order_acquire);
+    if (type != nullptr) {
+      return type;
+    }
+  }
+  BitsType* type;
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = bit_count_to_type_.find(bit_count);
+    type = it == bit_count_to_type_.end() ? nullptr : &it->second;
+  }
+  if (type == nullptr) {
+    absl::MutexLock lock(&mutex_);
+    auto [it, inserted] = bit_count_to_type_.try_emplace(bit_count, bit_count);
+    type = &it->second;
+    owned_types_.insert(type);
+  }
+  if (is_small) {
+    small_bits_types_[bit_count].store(type, std::memory_order_release);
+  }
+  return type;
+}
+
+ArrayType* IrInterner::GetArrayType(int64_t size, Type* element_type) {
+  ArrayKey key{size, element_type};
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = array_types_.find(key);
+    if (it != array_types_.end()) {
+      return &it->second;
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  XLS_CHECK(owned_types_.contains(element_type))
+      << "Type is not owned by package: " << *element_type;
+  auto [it, inserted] = array_types_.try_emplace(key, size, element_type);
+  owned_types_.insert(&it->second);
+  return &it->second;
+}
+
+TupleType* IrInterner::GetTupleType(absl::Span<Type* const> element_types) {
+  TypeVec key(element_types.begin(), element_types.end());
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = tuple_types_.find(key);
+    if (it != tuple_types_.end()) {
+      return &it->second;
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  for (const Type* element_type : element_types) {
+    XLS_CHECK(owned_types_.contains(element_type))
+        << "Type is not owned by package: " << *element_type;
+  }
+  auto [it, inserted] = tuple_types_.try_emplace(key, element_types);
+  owned_types_.insert(&it->second);
+  return &it->second;
+}
+
+FunctionType* IrInterner::GetFunctionType(absl::Span<Type* const> args_types,
+                                          Type* return_type) {
+  std::string key = FunctionType(args_types, return_type).ToString();
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = function_types_.find(key);
+    if (it != function_types_.end()) {
+      return &it->second;
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  for (Type* t : args_types) {
+    XLS_CHECK(owned_types_.contains(t))
+        << "Parameter type is not owned by package: " << t->ToString();
+  }
+  auto [it, inserted] =
+      function_types_.try_emplace(key, args_types, return_type);
+  owned_function_types_.insert(&it->second);
+  return &it->second;
+}
+
+bool IrInterner::IsOwnedType(const Type* type) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return owned_types_.contains(type);
+}
+
+bool IrInterner::IsOwnedFunctionType(
+    const FunctionType* function_type) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return owned_function_types_.contains(function_type);
+}
+
+std::shared_ptr<const Value> IrInterner::InternValue(const Value& value) {
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = values_.find(&value);
+    if (it != values_.end()) {
+      if (std::shared_ptr<const Value> interned = it->second.lock()) {
+        return interned;
+      }
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  auto it = values_.find(&value);
+  if (it != values_.end()) {
+    if (std::shared_ptr<const Value> interned = it->second.lock()) {
+      return interned;
+    }
+    // The last reference was dropped but the deleter has not run yet. Replace
+    // the entry; the pending deleter leaves the live entry alone.
+    values_.erase(it);
+  }
+  std::shared_ptr<const Value> interned(
+      new Value(value), [this](const Value* v) { ReleaseValue(v); });
+  values_.emplace(interned.get(), interned);
+  return interned;
+}
+
+void IrInterner::ReleaseValue(const Value* value) {
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = values_.find(value);
+    if (it != values_.end() && it->second.expired()) {
+      values_.erase(it);
+    }
+  }
+  delete value;
+}
+
+int64_t IrInterner::interned_value_count() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return values_.size();
+}
+
+}  // namespace xls
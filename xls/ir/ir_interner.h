@@ -0,0 +1,133 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_IR_INTERNER_H_
+#define XLS_IR_IR_INTERNER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// Thread-safe, hash-consed storage for the types and literal values of a
+// package. Each distinct type and value is stored exactly once so equal types
+// (and equal interned values) have equal pointers. Types are never removed
+// and their addresses are stable for the lifetime of the interner. Interned
+// values are reference counted and removed when the last reference is dropped.
+//
+// Lookups of existing entries only take the lock in shared mode and bits types
+// of small widths are looked up without locking at all, so concurrent passes
+// or parsers, which almost always find the type they ask for, do not
+// serialize on the interner.
+class IrInterner {
+ public:
+  IrInterner();
+
+  IrInterner(const IrInterner& other) = delete;
+  IrInterner& operator=(const IrInterner& other) = delete;
+
+  // Returns the interned type with the given structure. Element, parameter,
+  // and return types must be owned by this interner.
+  BitsType* GetBitsType(int64_t bit_count);
+  ArrayType* GetArrayType(int64_t size, Type* element_type);
+  TupleType* GetTupleType(absl::Span<Type* const> element_types);
+  TokenType* GetTokenType() { return &token_type_; }
+  FunctionType* GetFunctionType(absl::Span<Type* const> args_types,
+                                Type* return_type);
+
+  // Returns whether the given type was created by this interner.
+  bool IsOwnedType(const Type* type) const;
+  bool IsOwnedFunctionType(const FunctionType* function_type) const;
+
+  // Returns the interned copy of the given value. Equal values return the
+  // same pointer while any reference to the interned copy is alive. The
+  // interner must outlive all returned references.
+  std::shared_ptr<const Value> InternValue(const Value& value);
+
+  // Returns the number of distinct values currently interned by InternValue.
+  int64_t interned_value_count() const;
+
+ private:
+  // Bits types narrower than this are cached in `small_bits_types_`.
+  static constexpr int64_t kSmallBitsTypeCount = 129;
+
+  using ArrayKey = std::pair<int64_t, const Type*>;
+  using TypeVec = absl::InlinedVector<const Type*, 4>;
+
+  // Hash and equality of interned values by pointee.
+  struct ValuePtrHash {
+    size_t operator()(const Value* value) const {
+      return absl::Hash<Value>()(*value);
+    }
+  };
+  struct ValuePtrEq {
+    bool operator()(const Value* a, const Value* b) const { return *a == *b; }
+  };
+
+  // Deleter of interned values. Removes the value from `values_` unless it
+  // has been re-interned since the last reference was dropped.
+  void ReleaseValue(const Value* value);
+
+  mutable absl::Mutex mutex_;
+
+  // Set of owned types.
+  absl::flat_hash_set<const Type*> owned_types_ ABSL_GUARDED_BY(mutex_);
+
+  // Set of owned function types.
+  absl::flat_hash_set<const FunctionType*> owned_function_types_
+      ABSL_GUARDED_BY(mutex_);
+
+  // Mappings from the structure of a type to the owned type. Use node_hash_map
+  // for pointer stability.
+  absl::node_hash_map<int64_t, BitsType> bit_count_to_type_
+      ABSL_GUARDED_BY(mutex_);
+  absl::node_hash_map<ArrayKey, ArrayType> array_types_
+      ABSL_GUARDED_BY(mutex_);
+  absl::node_hash_map<TypeVec, TupleType> tuple_types_ ABSL_GUARDED_BY(mutex_);
+
+  // Mapping from FunctionType::ToString to the owned function type.
+  absl::node_hash_map<std::string, FunctionType> function_types_
+      ABSL_GUARDED_BY(mutex_);
+
+  // Lock-free cache of the bits types with fewer than kSmallBitsTypeCount
+  // bits. Entries are filled in on first use.
+  std::array<std::atomic<BitsType*>, kSmallBitsTypeCount> small_bits_types_;
+
+  // Owned token type.
+  TokenType token_type_;
+
+  // Interned values keyed by the value owned by the shared pointer.
+  absl::flat_hash_map<const Value*, std::weak_ptr<const Value>, ValuePtrHash,
+                      ValuePtrEq>
+      values_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_IR_INTERNER_H_
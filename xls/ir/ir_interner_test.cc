@@ -0,0 +1,165 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/ir_interner.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/common/thread.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+class IrInternerTest : public IrTestBase {};
+
+TEST_F(IrInternerTest, TypesAreHashConsed) {
+  IrInterner interner;
+  BitsType* u8 = interner.GetBitsType(8);
+  EXPECT_EQ(interner.GetBitsType(8), u8);
+  EXPECT_NE(interner.GetBitsType(9), u8);
+  EXPECT_EQ(interner.GetBitsType(1000), interner.GetBitsType(1000));
+
+  ArrayType* array = interner.GetArrayType(4, u8);
+  EXPECT_EQ(interner.GetArrayType(4, u8), array);
+  EXPECT_NE(interner.GetArrayType(5, u8), array);
+
+  TupleType* tuple = interner.GetTupleType({u8, array});
+  EXPECT_EQ(interner.GetTupleType({u8, array}), tuple);
+  EXPECT_NE(interner.GetTupleType({array, u8}), tuple);
+
+  FunctionType* function_type = interner.GetFunctionType({u8, u8}, tuple);
+  EXPECT_EQ(interner.GetFunctionType({u8, u8}, tuple), function_type);
+
+  EXPECT_TRUE(interner.IsOwnedType(u8));
+  EXPECT_TRUE(interner.IsOwnedType(array));
+  EXPECT_TRUE(interner.IsOwnedType(tuple));
+  EXPECT_TRUE(interner.IsOwnedType(interner.GetTokenType()));
+  EXPECT_TRUE(interner.IsOwnedFunctionType(function_type));
+
+  IrInterner other_interner;
+  EXPECT_FALSE(other_interner.IsOwnedType(u8));
+  EXPECT_NE(other_interner.GetBitsType(8), u8);
+}
+
+TEST_F(IrInternerTest, ValuesAreDeduplicated) {
+  IrInterner interner;
+  std::shared_ptr<const Value> a = interner.InternValue(Value(UBits(42, 32)));
+  EXPECT_EQ(interner.InternValue(Value(UBits(42, 32))), a);
+  std::shared_ptr<const Value> b = interner.InternValue(Value(UBits(42, 33)));
+  EXPECT_NE(b, a);
+  EXPECT_EQ(*a, Value(UBits(42, 32)));
+
+  std::shared_ptr<const Value> tuple = interner.InternValue(
+      Value::Tuple({Value(UBits(1, 8)), Value::Token()}));
+  EXPECT_EQ(interner.InternValue(
+                Value::Tuple({Value(UBits(1, 8)), Value::Token()})),
+            tuple);
+  EXPECT_EQ(interner.interned_value_count(), 3);
+}
+
+TEST_F(IrInternerTest, ValuesAreReleased) {
+  IrInterner interner;
+  std::shared_ptr<const Value> a = interner.InternValue(Value(UBits(42, 32)));
+  std::shared_ptr<const Value> b = interner.InternValue(Value(UBits(42, 32)));
+  EXPECT_EQ(interner.interned_value_count(), 1);
+
+  a.reset();
+  EXPECT_EQ(interner.interned_value_count(), 1);
+  b.reset();
+  EXPECT_EQ(interner.interned_value_count(), 0);
+
+  a = interner.InternValue(Value(UBits(42, 32)));
+  EXPECT_EQ(*a, Value(UBits(42, 32)));
+  EXPECT_EQ(interner.interned_value_count(), 1);
+}
+
+TEST_F(IrInternerTest, LiteralsShareValues) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Literal(UBits(0x63, 8));
+  BValue y = fb.Literal(UBits(0x63, 8));
+  BValue z = fb.Literal(UBits(0x7c, 8));
+  fb.Concat({x, y, z});
+  XLS_ASSERT_OK(fb.Build().status());
+
+  EXPECT_EQ(&x.node()->As<Literal>()->value(),
+            &y.node()->As<Literal>()->value());
+  EXPECT_NE(&x.node()->As<Literal>()->value(),
+            &z.node()->As<Literal>()->value());
+  EXPECT_TRUE(x.node()->IsDefinitelyEqualTo(y.node()));
+}
+
+TEST_F(IrInternerTest, RemovedLiteralsReleaseValues) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Literal(UBits(0x63, 8));
+  BValue y = fb.Literal(UBits(0x63, 8));
+  BValue z = fb.Literal(UBits(0x7c, 8));
+  BValue w = fb.Literal(UBits(0x7c, 8));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(w));
+  EXPECT_EQ(p->interned_value_count(), 2);
+
+  XLS_ASSERT_OK(f->RemoveNode(x.node()));
+  EXPECT_EQ(p->interned_value_count(), 2);
+  XLS_ASSERT_OK(f->RemoveNode(y.node()));
+  EXPECT_EQ(p->interned_value_count(), 1);
+  XLS_ASSERT_OK(f->RemoveNode(z.node()));
+  EXPECT_EQ(p->interned_value_count(), 1);
+
+  XLS_ASSERT_OK(p->RemoveFunction(f));
+  EXPECT_EQ(p->interned_value_count(), 0);
+}
+
+TEST_F(IrInternerTest, ConcurrentLookups) {
+  IrInterner interner;
+  constexpr int64_t kThreadCount = 8;
+  constexpr int64_t kWidthCount = 300;
+  std::vector<std::vector<Type*>> types(kThreadCount);
+  std::vector<std::vector<std::shared_ptr<const Value>>> values(kThreadCount);
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int64_t t = 0; t < kThreadCount; ++t) {
+      threads.push_back(std::make_unique<Thread>([&, t]() {
+        for (int64_t width = 1; width <= kWidthCount; ++width) {
+          BitsType* bits_type = interner.GetBitsType(width);
+          types[t].push_back(bits_type);
+          types[t].push_back(interner.GetArrayType(2, bits_type));
+          types[t].push_back(interner.GetTupleType({bits_type, bits_type}));
+          values[t].push_back(interner.InternValue(Value(UBits(0, width))));
+        }
+      }));
+    }
+    for (std::unique_ptr<Thread>& thread : threads) {
+      thread->Join();
+    }
+  }
+  for (int64_t t = 1; t < kThreadCount; ++t) {
+    EXPECT_EQ(types[t], types[0]);
+    EXPECT_EQ(values[t], values[0]);
+  }
+  EXPECT_EQ(interner.interned_value_count(), kWidthCount);
+}
+
+}  // namespace
+}  // namespace xls
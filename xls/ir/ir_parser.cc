@@ -19,11 +19,15 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "google/protobuf/text_format.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/mapped_file.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/common/visitor.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/channel.pb.h"
+#include "xls/ir/ir_binary_format.h"
+#include "xls/ir/ir_binary_parser.h"
 #include "xls/ir/node.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/number_parser.h"
@@ -43,7 +47,7 @@ absl::Status Parser::ParseKeywordArguments(
     XLS_ASSIGN_OR_RETURN(Token name,
                          scanner_.PopKeywordOrIdentToken("argument"));
     XLS_RETURN_IF_ERROR(scanner_.DropTokenOrError(LexicalTokenType::kEquals));
-    if (!seen_keywords.insert(name.value()).second) {
+    if (!seen_keywords.insert(std::string(name.value())).second) {
       return absl::InvalidArgumentError(
           absl::StrFormat("Duplicate keyword argument `%s` @ %s", name.value(),
                           name.pos().ToHumanString()));
@@ -85,7 +89,7 @@ absl::StatusOr<std::vector<Parser::TypedArgument>> Parser::ParseTypedArguments(
                            scanner_.PopTokenOrError(LexicalTokenType::kIdent));
       XLS_RETURN_IF_ERROR(scanner_.DropTokenOrError(LexicalTokenType::kColon));
       XLS_ASSIGN_OR_RETURN(Type * type, ParseType(package));
-      args.push_back(TypedArgument{name.value(), type, name});
+      args.push_back(TypedArgument{std::string(name.value()), type, name});
     } while (scanner_.TryDropToken(LexicalTokenType::kComma));
   }
   return args;
@@ -352,7 +356,7 @@ absl::StatusOr<std::string> Parser::ParseIdentifier(TokenPos* pos) {
   if (pos != nullptr) {
     *pos = token.pos();
   }
-  return token.value();
+  return std::string(token.value());
 }
 
 absl::StatusOr<std::string> Parser::ParseQuotedString(TokenPos* pos) {
@@ -361,7 +365,7 @@ absl::StatusOr<std::string> Parser::ParseQuotedString(TokenPos* pos) {
   if (pos != nullptr) {
     *pos = token.pos();
   }
-  return token.value();
+  return std::string(token.value());
 }
 
 absl::StatusOr<BValue> Parser::ParseAndResolveIdentifier(
@@ -657,7 +661,8 @@ absl::StatusOr<BValue> Parser::ParseNode(
   // should be given when constructing the node as the name is autogenerated
   // (the node has no meaningful given name). Otherwise, output_name is the
   // name of the node.
-  std::string node_name = split_name.has_value() ? "" : output_name.value();
+  std::string node_name =
+      split_name.has_value() ? "" : std::string(output_name.value());
 
   std::vector<BValue> operands;
   switch (op) {
@@ -1622,7 +1627,7 @@ absl::StatusOr<Parser::BlockSignature> Parser::ParseBlockSignature(
     if (!scanner_.TryDropKeyword("clock")) {
       XLS_ASSIGN_OR_RETURN(type, ParseType(package));
     }
-    signature.ports.push_back(Port{port_name.value(), type});
+    signature.ports.push_back(Port{std::string(port_name.value()), type});
     must_end = !scanner_.TryDropToken(LexicalTokenType::kComma);
   }
 
@@ -1637,7 +1642,7 @@ absl::StatusOr<std::string> Parser::ParsePackageName() {
   XLS_ASSIGN_OR_RETURN(
       Token package_name,
       scanner_.PopTokenOrError(LexicalTokenType::kIdent, "package name"));
-  return package_name.value();
+  return std::string(package_name.value());
 }
 
 absl::Status Parser::ParseFileNumber(Package* package) {
@@ -1874,8 +1879,8 @@ absl::StatusOr<Channel*> Parser::ParseChannel(Package* package) {
         Token metadata_token,
         scanner_.PopTokenOrError(LexicalTokenType::kQuotedString));
     ChannelMetadataProto proto;
-    bool success =
-        google::protobuf::TextFormat::ParseFromString(metadata_token.value(), &proto);
+    bool success = google::protobuf::TextFormat::ParseFromString(
+        std::string(metadata_token.value()), &proto);
     if (!success) {
       return absl::InvalidArgumentError(
           absl::StrFormat("Invalid channel metadata @ %s",
@@ -1975,14 +1980,19 @@ absl::StatusOr<FunctionType*> Parser::ParseFunctionType(Package* package) {
     std::string_view input_string, Package* package) {
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
   Parser p(std::move(scanner));
-  return p.ParseFunctionType(package);
+  XLS_ASSIGN_OR_RETURN(FunctionType * function_type,
+                       p.ParseFunctionType(package));
+  XLS_RETURN_IF_ERROR(p.scanner_.CheckRemainingText());
+  return function_type;
 }
 
 /* static */ absl::StatusOr<Type*> Parser::ParseType(
     std::string_view input_string, Package* package) {
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
   Parser p(std::move(scanner));
-  return p.ParseType(package);
+  XLS_ASSIGN_OR_RETURN(Type * type, p.ParseType(package));
+  XLS_RETURN_IF_ERROR(p.scanner_.CheckRemainingText());
+  return type;
 }
 
 // Verifies the given package. Replaces InternalError status codes with
@@ -2002,6 +2012,7 @@ absl::StatusOr<Function*> Parser::ParseFunction(std::string_view input_string,
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
   Parser p(std::move(scanner));
   XLS_ASSIGN_OR_RETURN(Function * function, p.ParseFunction(package));
+  XLS_RETURN_IF_ERROR(p.scanner_.CheckRemainingText());
 
   if (verify_function_only) {
     XLS_RETURN_IF_ERROR(VerifyFunction(function));
@@ -2020,6 +2031,7 @@ absl::StatusOr<Proc*> Parser::ParseProc(std::string_view input_string,
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
   Parser p(std::move(scanner));
   XLS_ASSIGN_OR_RETURN(Proc * proc, p.ParseProc(package));
+  XLS_RETURN_IF_ERROR(p.scanner_.CheckRemainingText());
 
   // Verify the whole package because the addition of the proc may break
   // package-scoped invariants (eg, duplicate proc name).
@@ -2033,6 +2045,7 @@ absl::StatusOr<Block*> Parser::ParseBlock(std::string_view input_string,
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
   Parser p(std::move(scanner));
   XLS_ASSIGN_OR_RETURN(Block * proc, p.ParseBlock(package));
+  XLS_RETURN_IF_ERROR(p.scanner_.CheckRemainingText());
 
   // Verify the whole package because the addition of the block may break
   // package-scoped invariants (eg, duplicate block name).
@@ -2045,7 +2058,9 @@ absl::StatusOr<Channel*> Parser::ParseChannel(std::string_view input_string,
                                               Package* package) {
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
   Parser p(std::move(scanner));
-  return p.ParseChannel(package);
+  XLS_ASSIGN_OR_RETURN(Channel * channel, p.ParseChannel(package));
+  XLS_RETURN_IF_ERROR(p.scanner_.CheckRemainingText());
+  return channel;
 }
 
 /* static */
@@ -2058,6 +2073,31 @@ absl::StatusOr<std::unique_ptr<Package>> Parser::ParsePackage(
   return package;
 }
 
+/* static */
+absl::StatusOr<std::unique_ptr<Package>> Parser::ParsePackageFile(
+    const std::filesystem::path& path, std::optional<bool> binary) {
+  auto parse = [&](std::string_view contents)
+      -> absl::StatusOr<std::unique_ptr<Package>> {
+    bool is_binary = IsBinaryIr(contents);
+    if (binary.has_value() && *binary != is_binary) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Expected %s IR but %s is %sin the binary IR format",
+          *binary ? "binary" : "text", path.string(), is_binary ? "" : "not "));
+    }
+    if (is_binary) {
+      return ParsePackageBinary(contents, path.string());
+    }
+    return ParsePackage(contents, path.string());
+  };
+  absl::StatusOr<MappedFile> mapped_file = MappedFile::Open(path);
+  if (absl::IsFailedPrecondition(mapped_file.status())) {
+    XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
+    return parse(contents);
+  }
+  XLS_RETURN_IF_ERROR(mapped_file.status());
+  return parse(mapped_file->contents());
+}
+
 /* static */
 absl::StatusOr<std::unique_ptr<Package>> Parser::ParsePackageWithEntry(
     std::string_view input_string, std::string_view entry,
@@ -2080,14 +2120,19 @@ absl::StatusOr<Value> Parser::ParseValue(std::string_view input_string,
                                          Type* expected_type) {
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
   Parser p(std::move(scanner));
-  return p.ParseValueInternal(expected_type);
+  XLS_ASSIGN_OR_RETURN(Value value, p.ParseValueInternal(expected_type));
+  XLS_RETURN_IF_ERROR(p.scanner_.CheckRemainingText());
+  return value;
 }
 
 /* static */
 absl::StatusOr<Value> Parser::ParseTypedValue(std::string_view input_string) {
   XLS_ASSIGN_OR_RETURN(auto scanner, Scanner::Create(input_string));
   Parser p(std::move(scanner));
-  return p.ParseValueInternal(/*expected_type=*/absl::nullopt);
+  XLS_ASSIGN_OR_RETURN(Value value,
+                       p.ParseValueInternal(/*expected_type=*/absl::nullopt));
+  XLS_RETURN_IF_ERROR(p.scanner_.CheckRemainingText());
+  return value;
 }
 
 }  // namespace xls
@@ -22,6 +22,7 @@
 #ifndef XLS_IR_IR_PARSER_H_
 #define XLS_IR_IR_PARSER_H_
 
+#include <filesystem>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -53,6 +54,16 @@ class Parser {
       std::string_view input_string,
       std::optional<std::string_view> filename = absl::nullopt);
 
+  // Parses the package in the file at the given path. Regular files are memory
+  // mapped and parsed in a single streaming pass so the text is never copied
+  // into memory; other files (e.g., /dev/stdin) are read first. Files in the
+  // binary IR format (see ir_binary_format.h) are detected and parsed with
+  // ParsePackageBinary. If `binary` is given, the file must be in the binary
+  // IR format (true) or the text format (false).
+  static absl::StatusOr<std::unique_ptr<Package>> ParsePackageFile(
+      const std::filesystem::path& path,
+      std::optional<bool> binary = std::nullopt);
+
   // As above, but sets the entry function to be the given name in the returned
   // package.
   static absl::StatusOr<std::unique_ptr<Package>> ParsePackageWithEntry(
@@ -118,7 +129,7 @@ class Parser {
  private:
   friend class ArgParser;
 
-  explicit Parser(Scanner scanner) : scanner_(scanner) {}
+  explicit Parser(Scanner scanner) : scanner_(std::move(scanner)) {}
 
   // Parse a function starting at the current scanner position.
   absl::StatusOr<Function*> ParseFunction(Package* package);
@@ -368,6 +379,8 @@ absl::StatusOr<std::unique_ptr<PackageT>> Parser::ParseDerivedPackageNoVerify(
                         "got %s @ %s",
                         peek.value(), peek.pos().ToHumanString()));
   }
+  // The scanner reports a tokenization error as EOF.
+  XLS_RETURN_IF_ERROR(parser.scanner_.status()) << "@ " << filename_str;
 
   // Verify the given entry function exists in the package.
   if (entry.has_value()) {
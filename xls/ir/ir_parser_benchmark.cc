@@ -0,0 +1,144 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "absl/strings/str_cat.h"
+#include "xls/common/file/temp_file.h"
+#include "xls/common/logging/logging.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_binary_parser.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/ir_scanner.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+// Measures the throughput of the IR scanner and parser on a large synthetic
+// package, both from a string in memory and from a (memory mapped) file, and
+// of the binary IR reader on the same package.
+
+// Returns the IR text of a package with `function_count` functions of
+// `nodes_per_function` nodes each. The functions use a mix of operations,
+// widths and literals to resemble IR emitted by the frontends.
+std::string MakeSyntheticPackageIr(int64_t function_count,
+                                   int64_t nodes_per_function) {
+  std::mt19937_64 bitgen(42);
+  Package package("synthetic");
+  Type* u32 = package.GetBitsType(32);
+  for (int64_t f = 0; f < function_count; ++f) {
+    FunctionBuilder fb(absl::StrCat("f", f), &package);
+    std::vector<BValue> values = {fb.Param("x", u32), fb.Param("y", u32)};
+    for (int64_t i = values.size(); i < nodes_per_function; ++i) {
+      BValue lhs = values[i - 1];
+      BValue rhs = values[bitgen() % i];
+      switch (bitgen() % 6) {
+        case 0:
+          values.push_back(fb.Add(lhs, rhs));
+          break;
+        case 1:
+          values.push_back(fb.Xor(lhs, rhs));
+          break;
+        case 2:
+          values.push_back(fb.Select(fb.ULt(lhs, rhs), lhs, rhs));
+          break;
+        case 3:
+          values.push_back(
+              fb.Concat({fb.BitSlice(lhs, 0, 16), fb.BitSlice(rhs, 16, 16)}));
+          break;
+        case 4:
+          values.push_back(fb.Shrl(lhs, fb.Literal(UBits(bitgen() % 32, 5))));
+          break;
+        default:
+          values.push_back(fb.And(lhs, fb.Literal(UBits(bitgen(), 32))));
+          break;
+      }
+    }
+    XLS_CHECK_OK(fb.Build().status());
+  }
+  return package.DumpIr();
+}
+
+// Arguments are the number of functions and the number of nodes per function.
+void PackageSizes(benchmark::internal::Benchmark* b) {
+  b->Args({16, 1024});
+  b->Args({64, 4096});
+}
+
+static void BM_Scan(benchmark::State& state) {
+  std::string ir = MakeSyntheticPackageIr(state.range(0), state.range(1));
+  for (auto _ : state) {
+    Scanner scanner = Scanner::Create(ir).value();
+    int64_t token_count = 0;
+    while (!scanner.AtEof()) {
+      scanner.PopToken();
+      ++token_count;
+    }
+    benchmark::DoNotOptimize(token_count);
+  }
+  state.SetBytesProcessed(state.iterations() * ir.size());
+}
+
+static void BM_ParsePackage(benchmark::State& state) {
+  std::string ir = MakeSyntheticPackageIr(state.range(0), state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Parser::ParsePackage(ir).value());
+  }
+  state.SetBytesProcessed(state.iterations() * ir.size());
+}
+
+static void BM_ParsePackageFile(benchmark::State& state) {
+  std::string ir = MakeSyntheticPackageIr(state.range(0), state.range(1));
+  TempFile temp_file = TempFile::CreateWithContent(ir, ".ir").value();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        Parser::ParsePackageFile(temp_file.path()).value());
+  }
+  state.SetBytesProcessed(state.iterations() * ir.size());
+}
+
+static void BM_ParsePackageBinary(benchmark::State& state) {
+  std::string ir = MakeSyntheticPackageIr(state.range(0), state.range(1));
+  std::string binary = Parser::ParsePackage(ir).value()->ToBinary().value();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ParsePackageBinary(binary).value());
+  }
+  state.SetBytesProcessed(state.iterations() * binary.size());
+}
+
+static void BM_ParsePackageBinaryFile(benchmark::State& state) {
+  std::string ir = MakeSyntheticPackageIr(state.range(0), state.range(1));
+  std::string binary = Parser::ParsePackage(ir).value()->ToBinary().value();
+  TempFile temp_file = TempFile::CreateWithContent(binary, ".irb").value();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        Parser::ParsePackageFile(temp_file.path()).value());
+  }
+  state.SetBytesProcessed(state.iterations() * binary.size());
+}
+
+BENCHMARK(BM_Scan)->Apply(PackageSizes);
+BENCHMARK(BM_ParsePackage)->Apply(PackageSizes);
+BENCHMARK(BM_ParsePackageFile)->Apply(PackageSizes);
+BENCHMARK(BM_ParsePackageBinary)->Apply(PackageSizes);
+BENCHMARK(BM_ParsePackageBinaryFile)->Apply(PackageSizes);
+
+}  // namespace
+}  // namespace xls
@@ -18,6 +18,7 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/strings/substitute.h"
+#include "xls/common/file/temp_file.h"
 #include "xls/common/source_location.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/bits_ops.h"
@@ -949,6 +950,113 @@ TEST(IrParserTest, ParseEmptyStringAsPackage) {
                        HasSubstr("Expected token, but found EOF")));
 }
 
+TEST(IrParserTest, ParsePackageFile) {
+  const std::string input = R"(package foo
+
+fn bar(x: bits[32], y: bits[32]) -> bits[32] {
+  ret add.1: bits[32] = add(x, y, id=1)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(TempFile temp_file,
+                           TempFile::CreateWithContent(input, ".ir"));
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> package,
+                           Parser::ParsePackageFile(temp_file.path()));
+  ExpectStringsSimilar(package->DumpIr(), input);
+
+  EXPECT_THAT(Parser::ParsePackageFile("/does/not/exist.ir").status(),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterFunction) {
+  const std::string input = R"(package foo
+
+fn bar(x: bits[32]) -> bits[32] {
+  ret x: bits[32] = param(name=x)
+}
+$
+)";
+  EXPECT_THAT(Parser::ParsePackage(input).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\" @ 6:1")));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterValue) {
+  Package p("my_package");
+  EXPECT_THAT(Parser::ParseValue("5 $", p.GetBitsType(8)).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\"")));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterTypedValue) {
+  EXPECT_THAT(Parser::ParseTypedValue("bits[8]:5 $").status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\"")));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterType) {
+  Package p("my_package");
+  EXPECT_THAT(Parser::ParseType("bits[8] $", &p).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\"")));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterFunctionType) {
+  Package p("my_package");
+  EXPECT_THAT(
+      Parser::ParseFunctionType("(bits[8]) -> bits[8] $", &p).status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Invalid character in IR text \"$\"")));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterFunctionOnly) {
+  const std::string input = R"(fn bar(x: bits[32]) -> bits[32] {
+  ret x: bits[32] = param(name=x)
+}
+$
+)";
+  Package p("my_package");
+  EXPECT_THAT(Parser::ParseFunction(input, &p).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\" @ 4:1")));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterProc) {
+  const std::string input =
+      R"(proc my_proc(my_token: token, my_state: bits[32], init={42}) {
+  next (my_token, my_state)
+}
+$
+)";
+  Package p("my_package");
+  EXPECT_THAT(Parser::ParseProc(input, &p).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\" @ 4:1")));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterBlock) {
+  const std::string input = R"(block my_block(a: bits[32], out: bits[32]) {
+  a: bits[32] = input_port(name=a, id=1)
+  out: () = output_port(a, name=out, id=2)
+}
+$
+)";
+  Package p("my_package");
+  EXPECT_THAT(Parser::ParseBlock(input, &p).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\" @ 5:1")));
+}
+
+TEST(IrParserTest, InvalidCharacterAfterChannel) {
+  Package p("my_package");
+  EXPECT_THAT(
+      Parser::ParseChannel(
+          R"(chan foo(bits[32], id=0, kind=streaming, ops=send_only, flow_control=none, metadata="""""") $)",
+          &p)
+          .status(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Invalid character in IR text \"$\"")));
+}
+
 TEST(IrParserTest, ParsePackageWithMissingPackageLine) {
   std::string input = R"(fn two_plus_two() -> bits[32] {
   literal.1: bits[32] = literal(value=2, id=1)
@@ -14,6 +14,8 @@
 
 #include "xls/ir/ir_scanner.h"
 
+#include <memory>
+#include <optional>
 #include <utility>
 
 #include "absl/status/statusor.h"
@@ -112,119 +114,27 @@ std::string Token::ToString() const {
                          pos_.ToHumanString());
 }
 
-namespace {
-
-// Helper class for tokenizing a string.
-// TODO(meheff): This could be combined into Scanner class and made lazy at the
-// same time.
+// Helper class for tokenizing a string one token at a time.
 class Tokenizer {
  public:
+  explicit Tokenizer(std::string_view str) : str_(str) {}
+
   // Tokenizes the given string and returns the vector of Tokens.
   static absl::StatusOr<std::vector<Token>> TokenizeString(
       std::string_view str) {
     Tokenizer tokenizer(str);
-    return tokenizer.Tokenize();
-  }
-
- private:
-  // Drops all whitespace starting at current index. Returns true if any
-  // whitespace was dropped.
-  bool DropWhiteSpace() {
-    int64_t old_index = index();
-    while (!EndOfString() && absl::ascii_isspace(current())) {
-      Advance();
-    }
-    return old_index != index();
-  }
-
-  // Tries to drop an end of line comment starting with "//" at the current
-  // index up to the newline. Returns true an end of line comment was found.
-  bool DropEndOfLineComment() {
-    if (MatchSubstring("//")) {
-      Advance(2);
-      while (!EndOfString() && current() != '\n') {
-        Advance(1);
-      }
-      return true;
-    }
-    return false;
-  }
-
-  // Returns true if the given string matches the substring starting at the
-  // current index in the tokenized string.
-  bool MatchSubstring(std::string_view substr) {
-    return index_ + substr.size() <= str_.size() &&
-           substr == std::string_view(str_.data() + index_, substr.size());
-  }
-
-  // Tries to match a quoted string with the given quote character sequence
-  // (e.g., """). Returns the contents of the quoted string or nullopt if no
-  // quoted string was matched. allow_multine indicates whether a newline
-  // character is allowed in the quoted string.
-  absl::StatusOr<std::optional<std::string_view>> MatchQuotedString(
-      std::string_view quote, bool allow_multiline) {
-    if (!MatchSubstring(quote)) {
-      return absl::nullopt;
-    }
-    int64_t start_colno = colno();
-    int64_t start_lineno = lineno();
-    Advance(quote.size());
-    int64_t content_start = index();
-    while (!EndOfString()) {
-      if (MatchSubstring(quote)) {
-        std::string_view content = std::string_view(
-            str_.data() + content_start, index() - content_start);
-        Advance(quote.size());
-        return content;
-      }
-      if (!allow_multiline && current() == '\n') {
-        break;
-      }
-      Advance();
-    }
-    return absl::InvalidArgumentError(
-        absl::StrFormat("Unterminated quoted string starting at %s",
-                        TokenPos{start_lineno, start_colno}.ToHumanString()));
-  }
-
-  // Advances the current index into the tokenized string by the given
-  // amount. Updates column and line numbers.
-  int64_t Advance(int64_t amount = 1) {
-    XLS_CHECK_LE(index_ + amount, str_.size());
-    for (int64_t i = 0; i < amount; ++i) {
-      if (current() == '\t') {
-        colno_ += 2;
-      } else if (current() == '\n') {
-        colno_ = 0;
-        ++lineno_;
-      } else {
-        ++colno_;
+    std::vector<Token> tokens;
+    while (true) {
+      XLS_ASSIGN_OR_RETURN(std::optional<Token> token, tokenizer.Next());
+      if (!token.has_value()) {
+        return tokens;
       }
-      ++index_;
-    }
-    return index_;
-  }
-
-  // Returns whether the current index is at the end of the string.
-  bool EndOfString() const { return index_ >= str_.size(); }
-
-  // Returns the sequence of all characters which satisfy the given test
-  // starting at the current index. Current index is updated to one past the
-  // last matching character. min_chars is the minimum number of characters
-  // which are unconditionally captured.
-  std::string_view CaptureWhile(std::function<bool(char)> test_f,
-                                 int64_t min_chars = 0) {
-    int64_t start = index();
-    while (!EndOfString() &&
-           ((index() < min_chars + start) || test_f(current()))) {
-      Advance();
+      tokens.push_back(*token);
     }
-    return std::string_view(str_.data() + start, index_ - start);
   }
 
-  // Tokenizes the internal string.
-  absl::StatusOr<std::vector<Token>> Tokenize() {
-    std::vector<Token> tokens;
+  // Returns the next token in the string or nullopt at the end of the string.
+  absl::StatusOr<std::optional<Token>> Next() {
     while (!EndOfString()) {
       if (DropWhiteSpace() || DropEndOfLineComment()) {
         continue;
@@ -243,26 +153,22 @@ class Tokenizer {
         std::string_view value = CaptureWhile(
             [](char c) { return absl::ascii_isalnum(c) || c == '_'; },
             /*min_chars=*/1);
-        tokens.push_back(Token(LexicalTokenType::kLiteral, value, start_lineno,
-                               start_colno));
-        continue;
+        return Token(LexicalTokenType::kLiteral, value, start_lineno,
+                     start_colno);
       }
 
       if (isalpha(current()) || current() == '_') {
         std::string_view value = CaptureWhile([](char c) {
           return isalpha(c) || c == '_' || c == '.' || isdigit(c);
         });
-        tokens.push_back(
-            Token::MakeIdentOrKeyword(value, start_lineno, start_colno));
-        continue;
+        return Token::MakeIdentOrKeyword(value, start_lineno, start_colno);
       }
 
       // Look for multi-character tokens.
       if (MatchSubstring("->")) {
-        tokens.push_back(Token(LexicalTokenType::kRightArrow, "->",
-                               start_lineno, start_colno));
         Advance(2);
-        continue;
+        return Token(LexicalTokenType::kRightArrow, "->", start_lineno,
+                     start_colno);
       }
 
       // Match quoted strings. Double-quoted strings (e.g., "foo") and
@@ -272,16 +178,14 @@ class Tokenizer {
       XLS_ASSIGN_OR_RETURN(
           content, MatchQuotedString("\"\"\"", /*allow_multiline=*/true));
       if (content.has_value()) {
-        tokens.push_back(Token(LexicalTokenType::kQuotedString, content.value(),
-                               start_lineno, start_colno));
-        continue;
+        return Token(LexicalTokenType::kQuotedString, content.value(),
+                     start_lineno, start_colno);
       }
       XLS_ASSIGN_OR_RETURN(content,
                            MatchQuotedString("\"", /*allow_multiline=*/false));
       if (content.has_value()) {
-        tokens.push_back(Token(LexicalTokenType::kQuotedString, content.value(),
-                               start_lineno, start_colno));
-        continue;
+        return Token(LexicalTokenType::kQuotedString, content.value(),
+                     start_lineno, start_colno);
       }
 
       // Handle single-character tokens.
@@ -334,15 +238,112 @@ class Tokenizer {
           std::string char_str = absl::ascii_iscntrl(current())
                                      ? absl::StrFormat("\\x%02x", current())
                                      : std::string(1, current());
-          XLS_LOG(ERROR) << "IR text with error: " << str_;
+          XLS_LOG(ERROR) << "IR text line with error: " << CurrentLine();
           return absl::InvalidArgumentError(absl::StrFormat(
               "Invalid character in IR text \"%s\" @ %s", char_str,
               TokenPos{lineno(), colno()}.ToHumanString()));
       }
-      tokens.push_back(Token(token_type, lineno(), colno()));
+      Token token(token_type, lineno(), colno());
+      Advance();
+      return token;
+    }
+    return std::nullopt;
+  }
+
+ private:
+  // Drops all whitespace starting at current index. Returns true if any
+  // whitespace was dropped.
+  bool DropWhiteSpace() {
+    int64_t old_index = index();
+    while (!EndOfString() && absl::ascii_isspace(current())) {
+      Advance();
+    }
+    return old_index != index();
+  }
+
+  // Tries to drop an end of line comment starting with "//" at the current
+  // index up to the newline. Returns true an end of line comment was found.
+  bool DropEndOfLineComment() {
+    if (MatchSubstring("//")) {
+      Advance(2);
+      while (!EndOfString() && current() != '\n') {
+        Advance(1);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  // Returns true if the given string matches the substring starting at the
+  // current index in the tokenized string.
+  bool MatchSubstring(std::string_view substr) {
+    return index_ + substr.size() <= str_.size() &&
+           substr == std::string_view(str_.data() + index_, substr.size());
+  }
+
+  // Tries to match a quoted string with the given quote character sequence
+  // (e.g., """). Returns the contents of the quoted string or nullopt if no
+  // quoted string was matched. allow_multine indicates whether a newline
+  // character is allowed in the quoted string.
+  absl::StatusOr<std::optional<std::string_view>> MatchQuotedString(
+      std::string_view quote, bool allow_multiline) {
+    if (!MatchSubstring(quote)) {
+      return absl::nullopt;
+    }
+    int64_t start_colno = colno();
+    int64_t start_lineno = lineno();
+    Advance(quote.size());
+    int64_t content_start = index();
+    while (!EndOfString()) {
+      if (MatchSubstring(quote)) {
+        std::string_view content = std::string_view(
+            str_.data() + content_start, index() - content_start);
+        Advance(quote.size());
+        return content;
+      }
+      if (!allow_multiline && current() == '\n') {
+        break;
+      }
+      Advance();
+    }
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unterminated quoted string starting at %s",
+                        TokenPos{start_lineno, start_colno}.ToHumanString()));
+  }
+
+  // Advances the current index into the tokenized string by the given
+  // amount. Updates column and line numbers.
+  int64_t Advance(int64_t amount = 1) {
+    XLS_CHECK_LE(index_ + amount, str_.size());
+    for (int64_t i = 0; i < amount; ++i) {
+      if (current() == '\t') {
+        colno_ += 2;
+      } else if (current() == '\n') {
+        colno_ = 0;
+        ++lineno_;
+      } else {
+        ++colno_;
+      }
+      ++index_;
+    }
+    return index_;
+  }
+
+  // Returns whether the current index is at the end of the string.
+  bool EndOfString() const { return index_ >= str_.size(); }
+
+  // Returns the sequence of all characters which satisfy the given test
+  // starting at the current index. Current index is updated to one past the
+  // last matching character. min_chars is the minimum number of characters
+  // which are unconditionally captured.
+  template <typename TestF>
+  std::string_view CaptureWhile(TestF test_f, int64_t min_chars = 0) {
+    int64_t start = index();
+    while (!EndOfString() &&
+           ((index() < min_chars + start) || test_f(current()))) {
       Advance();
     }
-    return tokens;
+    return std::string_view(str_.data() + start, index_ - start);
   }
 
   // Returns the character at the current index.
@@ -365,7 +366,17 @@ class Tokenizer {
   int64_t colno() const { return colno_; }
 
  private:
-  explicit Tokenizer(std::string_view str) : str_(str) {}
+  // Returns the line of the string containing the current index.
+  std::string_view CurrentLine() const {
+    int64_t start = index_;
+    while (start > 0 && str_[start - 1] != '\n') {
+      --start;
+    }
+    int64_t end = str_.find('\n', index_);
+    return str_.substr(start, end == std::string_view::npos
+                                  ? std::string_view::npos
+                                  : end - start);
+  }
 
   // The string being tokenized.
   std::string_view str_;
@@ -378,30 +389,64 @@ class Tokenizer {
   int64_t colno_ = 0;
 };
 
-}  // namespace
-
 absl::StatusOr<std::vector<Token>> TokenizeString(std::string_view str) {
   return Tokenizer::TokenizeString(str);
 }
 
+Scanner::Scanner(std::string_view text)
+    : tokenizer_(std::make_unique<Tokenizer>(text)) {}
+
+Scanner::Scanner(Scanner&& other) = default;
+Scanner& Scanner::operator=(Scanner&& other) = default;
+Scanner::~Scanner() = default;
+
 absl::StatusOr<Scanner> Scanner::Create(std::string_view text) {
-  XLS_ASSIGN_OR_RETURN(auto tokens, TokenizeString(text));
-  return Scanner(std::move(tokens));
+  return Scanner(text);
+}
+
+bool Scanner::FillLookahead(int64_t n) const {
+  while (lookahead_.size() <= n) {
+    if (!status_.ok()) {
+      return false;
+    }
+    absl::StatusOr<std::optional<Token>> token = tokenizer_->Next();
+    if (!token.ok()) {
+      status_ = token.status();
+      return false;
+    }
+    if (!token->has_value()) {
+      return false;
+    }
+    lookahead_.push_back(**token);
+  }
+  return true;
+}
+
+absl::Status Scanner::CheckRemainingText() const {
+  while (FillLookahead(lookahead_.size())) {
+  }
+  return status_;
+}
+
+absl::Status Scanner::EofError(std::string_view message) const {
+  if (!status_.ok()) {
+    return status_;
+  }
+  return absl::InvalidArgumentError(message);
 }
 
 absl::StatusOr<Token> Scanner::PeekToken() const {
   if (AtEof()) {
-    return absl::InvalidArgumentError("Expected token, but found EOF.");
+    return EofError("Expected token, but found EOF.");
   }
-  return tokens_[token_idx_];
+  return lookahead_.front();
 }
 
 absl::StatusOr<Token> Scanner::PopTokenOrError(std::string_view context) {
   if (AtEof()) {
     std::string context_str =
         context.empty() ? std::string("") : absl::StrCat(" in ", context);
-    return absl::InvalidArgumentError("Expected token" + context_str +
-                                      ", but found EOF.");
+    return EofError("Expected token" + context_str + ", but found EOF.");
   }
   return PopToken();
 }
@@ -419,7 +464,7 @@ absl::Status Scanner::DropTokenOrError(LexicalTokenType target,
   if (AtEof()) {
     std::string context_str =
         context.empty() ? std::string("") : absl::StrCat(" in ", context);
-    return absl::InvalidArgumentError(
+    return EofError(
         absl::StrFormat("Expected token of type %s%s; found EOF.",
                         LexicalTokenTypeToString(target), context_str));
   }
@@ -459,6 +504,9 @@ absl::StatusOr<Token> Scanner::PopKeywordOrIdentToken(
 absl::Status Scanner::DropKeywordOrError(std::string_view keyword) {
   absl::StatusOr<Token> popped_status = PopTokenOrError();
   if (!popped_status.ok()) {
+    if (!status_.ok()) {
+      return status_;
+    }
     return absl::InvalidArgumentError(
         absl::StrFormat("Expected keyword '%s': %s", keyword,
                         popped_status.status().message()));
@@ -16,7 +16,11 @@
 #define XLS_IR_IR_SCANNER_H_
 
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
@@ -90,7 +94,9 @@ class Token {
       : type_(type), value_(value), pos_({lineno, colno}) {}
 
   LexicalTokenType type() const { return type_; }
-  const std::string& value() const { return value_; }
+  // The text of the token. Refers into the text being scanned, which must
+  // outlive the token.
+  std::string_view value() const { return value_; }
   const TokenPos& pos() const { return pos_; }
 
   // Returns the token as a (u)int64_t value. Token must be a literal. The
@@ -114,7 +120,7 @@ class Token {
 
  private:
   LexicalTokenType type_;
-  std::string value_;
+  std::string_view value_;
   TokenPos pos_;
 };
 
@@ -124,15 +130,27 @@ inline std::ostream& operator<<(std::ostream& os, const Token& token) {
 }
 
 // Tokenizes the given string and returns the tokens. It maintains precise
-// source location information.  Right now this is a eager implementation - it
-// tokenizes the whole input. This can be easily changed later to a more demand
-// driven tokenization.
+// source location information. The values of the tokens refer into `str`.
 absl::StatusOr<std::vector<Token>> TokenizeString(std::string_view str);
 
+class Tokenizer;
+
+// Scanner over the tokens of IR text. Tokens are produced on demand as the
+// parser consumes them, so only a few tokens of lookahead are held in memory
+// at any time and the values of the tokens refer directly into the text. The
+// text must outlive the scanner and the tokens it returns.
+//
+// Tokenization errors are reported when the parser reaches the offending
+// text: the scanner then behaves as if at EOF and the methods which return a
+// status return the tokenization error.
 class Scanner {
  public:
   static absl::StatusOr<Scanner> Create(std::string_view text);
 
+  Scanner(Scanner&& other);
+  Scanner& operator=(Scanner&& other);
+  ~Scanner();
+
   // Peeks at the next token in the token stream, or returns an error if we're
   // at EOF and no more tokens are available.
   absl::StatusOr<Token> PeekToken() const;
@@ -140,7 +158,7 @@ class Scanner {
   // Return the current token.
   const Token& PeekTokenOrDie() const {
     XLS_CHECK(!AtEof());
-    return tokens_[token_idx_];
+    return lookahead_.front();
   }
 
   // Returns true if the next token is the given type.
@@ -151,14 +169,16 @@ class Scanner {
   // Returns true if the nth next token is the given type. If `n` is zero this
   // peeks at the immediate next token.
   bool PeekNthTokenIs(int64_t n, LexicalTokenType target) const {
-    return (token_idx_ + n < tokens_.size()) &&
-           tokens_[token_idx_ + n].type() == target;
+    return FillLookahead(n) && lookahead_[n].type() == target;
   }
 
   // Pop the current token, advance token pointer to next token.
   Token PopToken() {
-    XLS_VLOG(6) << "Popping token: " << tokens_[token_idx_];
-    return tokens_.at(token_idx_++);
+    XLS_CHECK(!AtEof());
+    XLS_VLOG(6) << "Popping token: " << lookahead_.front();
+    Token token = lookahead_.front();
+    lookahead_.pop_front();
+    return token;
   }
 
   // Same as PopToken() but returns a status error if we are at EOF (in which
@@ -205,13 +225,34 @@ class Scanner {
   absl::Status DropKeywordOrError(std::string_view keyword);
 
   // Check if more tokens are available.
-  bool AtEof() const { return token_idx_ >= tokens_.size(); }
+  bool AtEof() const { return !FillLookahead(0); }
+
+  // Returns the error encountered while tokenizing, if any. Once this is an
+  // error no more tokens are produced.
+  const absl::Status& status() const { return status_; }
+
+  // Tokenizes the remaining text and returns the tokenization error if there
+  // is one. Used by parse entry points which may not consume all of the text
+  // so that invalid characters after the parsed construct are still reported.
+  // The tokens remain available.
+  absl::Status CheckRemainingText() const;
 
  private:
-  explicit Scanner(std::vector<Token> tokens) : tokens_(tokens) {}
+  explicit Scanner(std::string_view text);
+
+  // Tokenizes ahead until the lookahead buffer holds at least `n` + 1 tokens.
+  // Returns false if the text (or the tokens before a tokenization error) ran
+  // out first.
+  bool FillLookahead(int64_t n) const;
+
+  // Returns the tokenization error if there is one, otherwise an
+  // InvalidArgument error with the given message. Used for reporting EOF.
+  absl::Status EofError(std::string_view message) const;
 
-  int64_t token_idx_ = 0;
-  std::vector<Token> tokens_;
+  // Tokenizing is logically const: it only fills the lookahead buffer.
+  mutable std::unique_ptr<Tokenizer> tokenizer_;
+  mutable std::deque<Token> lookahead_;
+  mutable absl::Status status_;
 };
 
 }  // namespace xls
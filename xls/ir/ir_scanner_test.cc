@@ -32,7 +32,7 @@ using testing::HasSubstr;
 std::vector<std::string> TokensToStrings(absl::Span<const Token> tokens) {
   std::vector<std::string> strs;
   for (const Token& token : tokens) {
-    strs.push_back(token.value());
+    strs.push_back(std::string(token.value()));
   }
   return strs;
 }
@@ -176,5 +176,21 @@ TEST(IrScannerTest, UnterminatedTripleQuotedStrings) {
                HasSubstr("Unterminated quoted string starting at 1:1")));
 }
 
+TEST(IrScannerTest, ScannerProducesTokensLazily) {
+  // The invalid character is only reported once the scanner reaches it.
+  XLS_ASSERT_OK_AND_ASSIGN(Scanner scanner, Scanner::Create("fn foo $"));
+  EXPECT_TRUE(scanner.PeekNthTokenIs(1, LexicalTokenType::kIdent));
+  XLS_ASSERT_OK(scanner.DropKeywordOrError("fn"));
+  XLS_ASSERT_OK_AND_ASSIGN(Token foo, scanner.PopTokenOrError());
+  EXPECT_EQ(foo.value(), "foo");
+  XLS_EXPECT_OK(scanner.status());
+  EXPECT_TRUE(scanner.AtEof());
+  EXPECT_THAT(scanner.PopTokenOrError(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid character in IR text \"$\" @ 1:8")));
+  EXPECT_THAT(scanner.status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 }  // namespace
 }  // namespace xls
@@ -21,6 +21,7 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
@@ -29,6 +30,7 @@
 #include "xls/ir/instantiation.h"
 #include "xls/ir/nodes.h"
 #include "xls/ir/package.h"
+#include "xls/ir/package_snapshot.h"
 #include "xls/ir/proc.h"
 #include "xls/ir/register.h"
 #include "xls/ir/verifier.h"
@@ -47,6 +49,7 @@ Node::Node(Op op, Type* type, const SourceInfo& loc, std::string_view name,
 void Node::AddOperand(Node* operand) {
   XLS_VLOG(3) << " Adding operand " << operand->GetName() << " as #"
               << operands_.size() << " operand of " << GetName();
+  SaveStateForUndo();
   operands_.push_back(operand);
   operand->AddUser(this);
   XLS_VLOG(3) << " " << operand->GetName()
@@ -72,10 +75,101 @@ absl::Status Node::AddNodeToFunctionAndReplace(
   return ReplaceUsesWith(replacement_ptr);
 }
 
-void Node::AddUser(Node* user) { users_.insert(user); }
+void Node::AddUser(Node* user) {
+  if (user_index_ == nullptr) {
+    auto it = absl::c_lower_bound(users_, user, NodeIdLessThan());
+    if (it != users_.end() && *it == user) {
+      return;
+    }
+    SaveStateForUndo();
+    users_.insert(it, user);
+    if (users_.size() >= kUserIndexThreshold) {
+      RebuildUserIndex();
+    }
+  } else {
+    if (user_index_->contains(user)) {
+      return;
+    }
+    SaveStateForUndo();
+    if (!users_.empty() && !NodeIdLessThan()(users_.back(), user)) {
+      users_sorted_.store(false, std::memory_order_relaxed);
+    }
+    user_index_->emplace(user, users_.size());
+    users_.push_back(user);
+  }
+  function_base_->RecordNodeChange(this, /*operands_changed=*/false);
+}
 
 void Node::RemoveUser(Node* user) {
-  XLS_CHECK_EQ(users_.erase(user), 1) << GetName();
+  XLS_CHECK(HasUser(user)) << GetName();
+  SaveStateForUndo();
+  EraseUser(user);
+  function_base_->RecordNodeChange(this, /*operands_changed=*/false);
+}
+
+void Node::EraseUser(Node* user) {
+  if (user_index_ == nullptr) {
+    auto it = absl::c_lower_bound(users_, user, NodeIdLessThan());
+    if (it != users_.end() && *it == user) {
+      users_.erase(it);
+    }
+    return;
+  }
+  auto it = user_index_->find(user);
+  if (it == user_index_->end()) {
+    return;
+  }
+  // Move the last user into the vacated position rather than shifting the
+  // tail of the vector. This may leave the users unsorted.
+  int64_t index = it->second;
+  user_index_->erase(it);
+  if (index != static_cast<int64_t>(users_.size()) - 1) {
+    users_[index] = users_.back();
+    (*user_index_)[users_[index]] = index;
+    users_sorted_.store(false, std::memory_order_relaxed);
+  }
+  users_.pop_back();
+  if (users_.size() < kUserIndexThreshold / 2) {
+    RebuildUserIndex();
+  }
+}
+
+void Node::RebuildUserIndex() {
+  absl::c_sort(users_, NodeIdLessThan());
+  users_sorted_.store(true, std::memory_order_relaxed);
+  if (users_.size() < kUserIndexThreshold / 2) {
+    user_index_.reset();
+    return;
+  }
+  if (user_index_ == nullptr) {
+    user_index_ = std::make_unique<absl::flat_hash_map<Node*, int64_t>>();
+  }
+  user_index_->clear();
+  for (int64_t i = 0; i < users_.size(); ++i) {
+    user_index_->emplace(users_[i], i);
+  }
+}
+
+void Node::SortUsers() const {
+  // Concurrent readers of the same node may race to sort. Writers are
+  // already required to have exclusive access to the node.
+  static absl::Mutex mutex(absl::kConstInit);
+  absl::MutexLock lock(&mutex);
+  if (users_sorted_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  absl::c_sort(users_, NodeIdLessThan());
+  for (int64_t i = 0; i < users_.size(); ++i) {
+    (*user_index_)[users_[i]] = i;
+  }
+  users_sorted_.store(true, std::memory_order_release);
+}
+
+void Node::SaveStateForUndo() {
+  if (PackageSnapshot* snapshot = package()->active_snapshot();
+      snapshot != nullptr) {
+    snapshot->SaveNode(this);
+  }
 }
 
 absl::Status Node::VisitSingleNode(DfsVisitor* visitor) {
@@ -394,15 +488,20 @@ std::string Node::GetName() const {
 }
 
 void Node::SetName(std::string_view name) {
+  SaveStateForUndo();
   name_ = function_base()->UniquifyNodeName(name);
 }
 
 void Node::ClearName() {
   XLS_CHECK(!Is<Param>());
+  SaveStateForUndo();
   name_ = "";
 }
 
-void Node::SetLoc(const SourceInfo& loc) { loc_ = loc; }
+void Node::SetLoc(const SourceInfo& loc) {
+  SaveStateForUndo();
+  loc_ = loc;
+}
 
 std::string Node::ToStringInternal(bool include_operand_types) const {
   std::string ret = absl::StrCat(GetName(), ": ", GetType()->ToString(), " = ",
@@ -627,11 +726,15 @@ std::string Node::GetOperandsString() const {
 }
 
 std::string Node::GetUsersString() const {
-  return absl::StrFormat("[%s]", absl::StrJoin(users_, ", ", NodeFormatter));
+  return absl::StrFormat("[%s]", absl::StrJoin(users(), ", ", NodeFormatter));
 }
 
 bool Node::HasUser(const Node* target) const {
-  return users_.contains(const_cast<Node*>(target));
+  if (user_index_ != nullptr) {
+    return user_index_->contains(const_cast<Node*>(target));
+  }
+  auto it = absl::c_lower_bound(users_, target, NodeIdLessThan());
+  return it != users_.end() && *it == target;
 }
 
 bool Node::IsDead() const {
@@ -659,17 +762,21 @@ int64_t Node::OperandInstanceCount(const Node* target) const {
 }
 
 void Node::SetId(int64_t id) {
-  // The data structure (btree) containing the users of each node is sorted by
-  // node id. To avoid violating invariants of the data structure, remove this
-  // node from all users lists, change id, then read to users list.
+  // The users of each node are sorted by node id. To avoid violating this
+  // invariant, remove this node from all users lists, change id, then re-add
+  // it to the users lists.
+  SaveStateForUndo();
   for (Node* operand : operands()) {
-    operand->users_.erase(this);
+    operand->SaveStateForUndo();
+    operand->EraseUser(this);
   }
   id_ = id;
   for (Node* operand : operands()) {
-    operand->users_.insert(this);
+    operand->AddUser(this);
   }
   package()->set_next_node_id(std::max(id + 1, package()->next_node_id()));
+  // Id uniqueness is only checked over the whole function base.
+  function_base_->MarkStructureChanged();
 }
 
 bool Node::ReplaceOperand(Node* old_operand, Node* new_operand) {
@@ -688,6 +795,7 @@ bool Node::ReplaceOperand(Node* old_operand, Node* new_operand) {
   bool did_replace = false;
   for (int64_t i = 0; i < operand_count(); ++i) {
     if (operands_[i] == old_operand) {
+      SaveStateForUndo();
       if (!did_replace && new_operand != nullptr) {
         // Now we know we're definitely using this new operand.
         new_operand->AddUser(this);
@@ -697,6 +805,9 @@ bool Node::ReplaceOperand(Node* old_operand, Node* new_operand) {
     }
   }
   old_operand->RemoveUser(this);
+  if (did_replace) {
+    function_base_->RecordNodeChange(this, /*operands_changed=*/true);
+  }
   return did_replace;
 }
 
@@ -712,7 +823,9 @@ absl::Status Node::ReplaceOperandNumber(int64_t operand_no, Node* new_operand,
   // AddUser is idempotent so even if the new operand is already used by this
   // node in another operand slot, it is safe to call.
   new_operand->AddUser(this);
+  SaveStateForUndo();
   operands_[operand_no] = new_operand;
+  function_base_->RecordNodeChange(this, /*operands_changed=*/true);
 
   for (Node* operand : operands()) {
     if (operand == old_operand) {
@@ -744,6 +857,7 @@ absl::Status Node::ReplaceUsesWith(Node* replacement) {
   if (!Is<Param>() && HasAssignedName() && !replacement->HasAssignedName()) {
     // Do not use SetName because we do not want the name to be uniqued which
     // would add a suffix because (clearly) the name already exists.
+    replacement->SaveStateForUndo();
     replacement->name_ = name_;
     ClearName();
   }
@@ -15,13 +15,16 @@
 #ifndef XLS_IR_NODE_H_
 #define XLS_IR_NODE_H_
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -122,6 +125,7 @@ class Node {
   // Swaps the operands at indices 'a' and 'b' in the operands sequence.
   void SwapOperands(int64_t a, int64_t b) {
     // Operand/user chains already set up properly.
+    SaveStateForUndo();
     std::swap(operands_[a], operands_[b]);
   }
 
@@ -200,7 +204,12 @@ class Node {
   };
 
   // Returns the unique set of users of this node sorted by id.
-  const absl::btree_set<Node*, NodeIdLessThan>& users() const { return users_; }
+  absl::Span<Node* const> users() const {
+    if (!users_sorted_.load(std::memory_order_acquire)) {
+      SortUsers();
+    }
+    return users_;
+  }
 
   // Helper for querying whether "target" is a user of this node.
   bool HasUser(const Node* target) const;
@@ -253,6 +262,7 @@ class Node {
   // Block needs to be a friend to strongly name ports (guarantee name has no
   // uniquifying prefix).
   friend class Block;
+  friend class PackageSnapshot;
 
   Node(Op op, Type* type, const SourceInfo& loc, std::string_view name,
        FunctionBase* function);
@@ -279,6 +289,25 @@ class Node {
   void AddUser(Node* user);
   void RemoveUser(Node* user);
 
+  // Nodes with at least this many users index them in `user_index_`.
+  static constexpr int64_t kUserIndexThreshold = 16;
+
+  // Removes `user` from the users if present without recording the change.
+  void EraseUser(Node* user);
+
+  // Sorts `users_` and creates, updates or drops `user_index_` according to
+  // the number of users.
+  void RebuildUserIndex();
+
+  // Sorts `users_` after removals or out-of-order additions to an indexed
+  // user set.
+  void SortUsers() const;
+
+  // Records the state of this node in the active snapshot of the package, if
+  // any. Must be called before the operands, users, name, id, or location of
+  // the node are changed.
+  void SaveStateForUndo();
+
   FunctionBase* function_base_;
   int64_t id_;
   Op op_;
@@ -288,8 +317,23 @@ class Node {
 
   std::vector<Node*> operands_;
 
-  // Set of users sorted by node_id for stability.
-  absl::btree_set<Node*, NodeIdLessThan> users_;
+  // Set of users sorted by node_id for stability. Most nodes have very few
+  // users so these are kept inline in a sorted vector. Nodes with many users
+  // additionally map each user to its position in `user_index_` so adding and
+  // removing users takes constant time; the vector is then sorted lazily by
+  // users() and `users_sorted_` is false until it is.
+  mutable absl::InlinedVector<Node*, 2> users_;
+  mutable std::atomic<bool> users_sorted_{true};
+  mutable std::unique_ptr<absl::flat_hash_map<Node*, int64_t>> user_index_;
+
+  // Index of the slot holding this node in the node storage of
+  // function_base_. Maintained by FunctionBase.
+  int64_t slot_index_ = -1;
+
+  // Index of this node in the list of changed nodes of function_base_ (see
+  // FunctionBase::node_changes), or -1 if the node has not changed since the
+  // last checkpoint. Maintained by FunctionBase.
+  int64_t change_index_ = -1;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Node& node) {
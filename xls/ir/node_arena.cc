@@ -0,0 +1,60 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/node_arena.h"
+
+#include <algorithm>
+
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+
+void* NodeArena::Allocate(int64_t size) {
+  size = RoundUpSize(std::max<int64_t>(size, sizeof(FreeBlock)));
+  auto it = free_lists_.find(size);
+  if (it != free_lists_.end() && it->second != nullptr) {
+    FreeBlock* block = it->second;
+    it->second = block->next;
+    return block;
+  }
+  if (size > remaining_) {
+    // Oversized blocks get a slab of their own so the current slab keeps
+    // serving small allocations.
+    int64_t slab_size = std::max(size, kSlabSize);
+    slabs_.push_back(std::make_unique<std::max_align_t[]>(
+        slab_size / sizeof(std::max_align_t)));
+    bytes_reserved_ += slab_size;
+    uint8_t* slab = reinterpret_cast<uint8_t*>(slabs_.back().get());
+    if (slab_size > kSlabSize) {
+      return slab;
+    }
+    next_ = slab;
+    remaining_ = slab_size;
+  }
+  void* result = next_;
+  next_ += size;
+  remaining_ -= size;
+  return result;
+}
+
+void NodeArena::Deallocate(void* ptr, int64_t size) {
+  XLS_DCHECK(ptr != nullptr);
+  size = RoundUpSize(std::max<int64_t>(size, sizeof(FreeBlock)));
+  FreeBlock*& head = free_lists_[size];
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  block->next = head;
+  head = block;
+}
+
+}  // namespace xls
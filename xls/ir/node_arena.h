@@ -0,0 +1,69 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_NODE_ARENA_H_
+#define XLS_IR_NODE_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace xls {
+
+// A slab allocator for the nodes of a single FunctionBase. Blocks are carved
+// sequentially out of large slabs so nodes created together are adjacent in
+// memory. Freed blocks are kept on per-size free lists and handed out again by
+// later allocations of the same size. All memory is released when the arena is
+// destroyed; the arena does not run destructors. Not thread-safe.
+class NodeArena {
+ public:
+  NodeArena() = default;
+  NodeArena(const NodeArena&) = delete;
+  NodeArena& operator=(const NodeArena&) = delete;
+
+  // Returns a block of at least `size` bytes aligned for any node type.
+  void* Allocate(int64_t size);
+
+  // Returns a block previously returned by Allocate(size) to the arena.
+  void Deallocate(void* ptr, int64_t size);
+
+  // Returns the total number of bytes of slab memory held by the arena.
+  int64_t bytes_reserved() const { return bytes_reserved_; }
+
+ private:
+  static constexpr int64_t kAlignment = alignof(std::max_align_t);
+  static constexpr int64_t kSlabSize = 64 * 1024;
+
+  // Freed blocks are threaded through their first word.
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static int64_t RoundUpSize(int64_t size) {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  std::vector<std::unique_ptr<std::max_align_t[]>> slabs_;
+  uint8_t* next_ = nullptr;
+  int64_t remaining_ = 0;
+  int64_t bytes_reserved_ = 0;
+  absl::flat_hash_map<int64_t, FreeBlock*> free_lists_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_NODE_ARENA_H_
@@ -0,0 +1,74 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/node_arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
+
+namespace xls {
+namespace {
+
+TEST(NodeArenaTest, AllocationsAreDistinctAndAligned) {
+  NodeArena arena;
+  absl::flat_hash_set<void*> blocks;
+  for (int64_t i = 0; i < 10000; ++i) {
+    int64_t size = 8 + (i % 13) * 24;
+    void* block = arena.Allocate(size);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t),
+              0);
+    // The whole block must be writable.
+    std::memset(block, 0xab, size);
+    EXPECT_TRUE(blocks.insert(block).second);
+  }
+}
+
+TEST(NodeArenaTest, DeallocatedBlocksAreReused) {
+  NodeArena arena;
+  void* a = arena.Allocate(100);
+  void* b = arena.Allocate(100);
+  EXPECT_NE(a, b);
+  arena.Deallocate(a, 100);
+  EXPECT_EQ(arena.Allocate(100), a);
+  // A block of a different size is not reused.
+  arena.Deallocate(b, 100);
+  EXPECT_NE(arena.Allocate(200), b);
+  EXPECT_EQ(arena.Allocate(100), b);
+}
+
+TEST(NodeArenaTest, ConsecutiveAllocationsAreAdjacent) {
+  NodeArena arena;
+  uint8_t* a = static_cast<uint8_t*>(arena.Allocate(64));
+  uint8_t* b = static_cast<uint8_t*>(arena.Allocate(64));
+  EXPECT_EQ(b, a + 64);
+}
+
+TEST(NodeArenaTest, LargeAllocations) {
+  NodeArena arena;
+  void* small = arena.Allocate(32);
+  int64_t size = 1024 * 1024;
+  void* large = arena.Allocate(size);
+  std::memset(large, 0, size);
+  EXPECT_GE(arena.bytes_reserved(), size);
+  // Small allocations continue in the existing slab.
+  EXPECT_EQ(static_cast<uint8_t*>(arena.Allocate(32)),
+            static_cast<uint8_t*>(small) + 32);
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,6 +14,9 @@
 
 #include "xls/ir/node.h"
 
+#include <cstdint>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "xls/common/status/matchers.h"
@@ -27,6 +30,8 @@ namespace {
 
 using status_testing::IsOkAndHolds;
 using status_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::HasSubstr;
 using ::testing::UnorderedElementsAre;
 
@@ -368,6 +373,44 @@ fn ReplaceUses(x: bits[8], y: bits[8]) -> bits[8] {
   EXPECT_TRUE(FindNode("and.1", f)->users().empty());
 }
 
+TEST_F(NodeTest, HighFanoutUsers) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  std::vector<Node*> nots;
+  for (int64_t i = 0; i < 100; ++i) {
+    nots.push_back(fb.Not(x).node());
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(y));
+  EXPECT_THAT(x.node()->users(), ElementsAreArray(nots));
+
+  // Remove every third user and a run of users in the middle, then check that
+  // the users are still unique and sorted by id.
+  std::vector<Node*> remaining;
+  for (int64_t i = 0; i < nots.size(); ++i) {
+    if (i % 3 == 0 || (i >= 40 && i < 60)) {
+      XLS_ASSERT_OK(f->RemoveNode(nots[i]));
+    } else {
+      remaining.push_back(nots[i]);
+    }
+  }
+  EXPECT_THAT(x.node()->users(), ElementsAreArray(remaining));
+  EXPECT_TRUE(x.node()->HasUser(remaining.front()));
+  EXPECT_FALSE(x.node()->HasUser(nots.front()));
+
+  XLS_ASSERT_OK(x.node()->ReplaceUsesWith(y.node()));
+  EXPECT_TRUE(x.node()->users().empty());
+  EXPECT_THAT(y.node()->users(), ElementsAreArray(remaining));
+
+  // Removing most users drops back to the small representation.
+  for (int64_t i = 0; i + 2 < remaining.size(); ++i) {
+    XLS_ASSERT_OK(f->RemoveNode(remaining[i]));
+  }
+  EXPECT_THAT(y.node()->users(),
+              ElementsAre(remaining[remaining.size() - 2], remaining.back()));
+}
+
 TEST_F(NodeTest, ReplaceUsesReturnValue) {
   auto p = CreatePackage();
   XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
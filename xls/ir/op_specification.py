@@ -186,6 +186,24 @@ class ValueAttribute(Attribute):
         name, cpp_type='Value', return_cpp_type='const Value&')
 
 
+class InternedValueAttribute(Attribute):
+  """A Value attribute stored as a pointer to the package-wide interned copy.
+
+  Equal values within a package share storage (see Package::InternValue). The
+  interned copy is released when the last node referring to it is destroyed.
+  """
+
+  def __init__(self, name):
+    super(InternedValueAttribute, self).__init__(
+        name,
+        cpp_type='std::shared_ptr<const Value>',
+        arg_cpp_type='Value',
+        return_cpp_type='const Value&',
+        equals_tmpl='*{lhs} == *{rhs}',
+        init_args=['function->package()->InternValue(' + name + ')'])
+    self.method.expression = '*' + self.data_member.name
+
+
 class StringAttribute(Attribute):
 
   def __init__(self, name):
@@ -742,7 +760,7 @@ OpClass.kinds['LITERAL'] = OpClass(
     op='Op::kLiteral',
     operands=[],
     xls_type_expression='function->package()->GetTypeForValue(value)',
-    attributes=[ValueAttribute('value')],
+    attributes=[InternedValueAttribute('value')],
     extra_methods=[Method('IsZero', 'bool',
                           'value().IsBits() && value().bits().IsZero()')],
 )
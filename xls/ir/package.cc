@@ -26,6 +26,8 @@
 #include "xls/ir/block.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/function.h"
+#include "xls/ir/ir_binary_format.h"
+#include "xls/ir/package_snapshot.h"
 #include "xls/ir/proc.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
@@ -33,9 +35,7 @@
 
 namespace xls {
 
-Package::Package(std::string_view name) : name_(name) {
-  owned_types_.insert(&token_type_);
-}
+Package::Package(std::string_view name) : name_(name) {}
 
 Package::~Package() {}
 
@@ -214,14 +214,17 @@ absl::Status Package::RemoveFunction(Function* function) {
         "Cannot remove function: %s. The function is the top entity.",
         function->name()));
   }
-  auto it = std::remove_if(
+  auto it = std::find_if(
       functions_.begin(), functions_.end(),
       [&](const std::unique_ptr<Function>& f) { return f.get() == function; });
   if (it == functions_.end()) {
     return absl::NotFoundError(absl::StrFormat(
         "`%s` is not a function in package `%s`", function->name(), name()));
   }
-  functions_.erase(it, functions_.end());
+  if (active_snapshot_ != nullptr) {
+    active_snapshot_->SaveRemovedFunctionBase(std::move(*it));
+  }
+  functions_.erase(it);
   return absl::OkStatus();
 }
 
@@ -230,14 +233,17 @@ absl::Status Package::RemoveProc(Proc* proc) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Cannot remove proc: %s. The proc is the top entity.", proc->name()));
   }
-  auto it = std::remove_if(
+  auto it = std::find_if(
       procs_.begin(), procs_.end(),
       [&](const std::unique_ptr<Proc>& f) { return f.get() == proc; });
   if (it == procs_.end()) {
     return absl::NotFoundError(absl::StrFormat(
         "`%s` is not a proc in package `%s`", proc->name(), name()));
   }
-  procs_.erase(it, procs_.end());
+  if (active_snapshot_ != nullptr) {
+    active_snapshot_->SaveRemovedFunctionBase(std::move(*it));
+  }
+  procs_.erase(it);
   return absl::OkStatus();
 }
 
@@ -247,14 +253,17 @@ absl::Status Package::RemoveBlock(Block* block) {
         absl::StrFormat("Cannot remove block: %s. The block is the top entity.",
                         block->name()));
   }
-  auto it = std::remove_if(
+  auto it = std::find_if(
       blocks_.begin(), blocks_.end(),
       [&](const std::unique_ptr<Block>& f) { return f.get() == block; });
   if (it == blocks_.end()) {
     return absl::NotFoundError(absl::StrFormat(
         "`%s` is not a block in package `%s`", block->name(), name()));
   }
-  blocks_.erase(it, blocks_.end());
+  if (active_snapshot_ != nullptr) {
+    active_snapshot_->SaveRemovedFunctionBase(std::move(*it));
+  }
+  blocks_.erase(it);
   return absl::OkStatus();
 }
 
@@ -309,62 +318,6 @@ absl::StatusOr<Type*> Package::MapTypeFromOtherPackage(
   }
 }
 
-BitsType* Package::GetBitsType(int64_t bit_count) {
-  if (bit_count_to_type_.find(bit_count) != bit_count_to_type_.end()) {
-    return &bit_count_to_type_.at(bit_count);
-  }
-  auto it = bit_count_to_type_.emplace(bit_count, BitsType(bit_count));
-  BitsType* new_type = &(it.first->second);
-  owned_types_.insert(new_type);
-  return new_type;
-}
-
-ArrayType* Package::GetArrayType(int64_t size, Type* element_type) {
-  ArrayKey key{size, element_type};
-  if (array_types_.find(key) != array_types_.end()) {
-    return &array_types_.at(key);
-  }
-  XLS_CHECK(IsOwnedType(element_type))
-      << "Type is not owned by package: " << *element_type;
-  auto it = array_types_.emplace(key, ArrayType(size, element_type));
-  ArrayType* new_type = &(it.first->second);
-  owned_types_.insert(new_type);
-  return new_type;
-}
-
-TupleType* Package::GetTupleType(absl::Span<Type* const> element_types) {
-  TypeVec key(element_types.begin(), element_types.end());
-  if (tuple_types_.find(key) != tuple_types_.end()) {
-    return &tuple_types_.at(key);
-  }
-  for (const Type* element_type : element_types) {
-    XLS_CHECK(IsOwnedType(element_type))
-        << "Type is not owned by package: " << *element_type;
-  }
-  auto it = tuple_types_.emplace(key, TupleType(element_types));
-  TupleType* new_type = &(it.first->second);
-  owned_types_.insert(new_type);
-  return new_type;
-}
-
-TokenType* Package::GetTokenType() { return &token_type_; }
-
-FunctionType* Package::GetFunctionType(absl::Span<Type* const> args_types,
-                                       Type* return_type) {
-  std::string key = FunctionType(args_types, return_type).ToString();
-  if (function_types_.find(key) != function_types_.end()) {
-    return &function_types_.at(key);
-  }
-  for (Type* t : args_types) {
-    XLS_CHECK(IsOwnedType(t))
-        << "Parameter type is not owned by package: " << t->ToString();
-  }
-  auto it = function_types_.emplace(key, FunctionType(args_types, return_type));
-  FunctionType* new_type = &(it.first->second);
-  owned_function_types_.insert(new_type);
-  return new_type;
-}
-
 absl::StatusOr<Type*> Package::GetTypeFromProto(const TypeProto& proto) {
   if (!proto.has_type_enum()) {
     return absl::InvalidArgumentError("Missing type_enum field in TypeProto.");
@@ -554,6 +507,10 @@ std::string Package::DumpIr() const {
   return out;
 }
 
+absl::StatusOr<std::string> Package::ToBinary() const {
+  return PackageToBinary(*this);
+}
+
 std::ostream& operator<<(std::ostream& os, const Package& package) {
   os << package.DumpIr();
   return os;
@@ -647,6 +604,11 @@ absl::Status Package::RemoveChannel(Channel* channel) {
     }
   }
 
+  if (active_snapshot_ != nullptr) {
+    active_snapshot_->RecordUnrecordedChange(
+        absl::StrFormat("channel %s was removed", channel->name()));
+  }
+
   // Remove from channel vector.
   channel_vec_.erase(it);
 
@@ -687,6 +649,10 @@ absl::Status Package::AddChannel(std::unique_ptr<Channel> channel) {
             [](Channel* a, Channel* b) { return a->id() < b->id(); });
 
   next_channel_id_ = std::max(next_channel_id_, id + 1);
+  if (active_snapshot_ != nullptr) {
+    active_snapshot_->RecordUnrecordedChange(
+        absl::StrFormat("channel %s was added", channel_ptr->name()));
+  }
   return absl::OkStatus();
 }
 
@@ -15,21 +15,20 @@
 #ifndef XLS_IR_PACKAGE_H_
 #define XLS_IR_PACKAGE_H_
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
-#include "absl/container/flat_hash_set.h"
-#include "absl/container/inlined_vector.h"
-#include "absl/container/node_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/channel.pb.h"
 #include "xls/ir/channel_ops.h"
 #include "xls/ir/fileno.h"
+#include "xls/ir/ir_interner.h"
 #include "xls/ir/source_location.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
@@ -40,6 +39,7 @@ class Block;
 class Channel;
 class Function;
 class FunctionBase;
+class PackageSnapshot;
 class Proc;
 class SingleValueChannel;
 class StreamingChannel;
@@ -74,20 +74,39 @@ class Package {
   absl::StatusOr<FunctionBase*> GetFunctionBaseByName(std::string_view name);
 
   // Returns whether the given type is one of the types owned by this package.
-  bool IsOwnedType(const Type* type) {
-    return owned_types_.find(type) != owned_types_.end();
-  }
+  bool IsOwnedType(const Type* type) { return interner_.IsOwnedType(type); }
   bool IsOwnedFunctionType(const FunctionType* function_type) {
-    return owned_function_types_.find(function_type) !=
-           owned_function_types_.end();
+    return interner_.IsOwnedFunctionType(function_type);
   }
 
-  BitsType* GetBitsType(int64_t bit_count);
-  ArrayType* GetArrayType(int64_t size, Type* element_type);
-  TupleType* GetTupleType(absl::Span<Type* const> element_types);
-  TokenType* GetTokenType();
+  // Types are hash-consed so types with the same structure are represented by
+  // the same pointer. These methods are thread-safe.
+  BitsType* GetBitsType(int64_t bit_count) {
+    return interner_.GetBitsType(bit_count);
+  }
+  ArrayType* GetArrayType(int64_t size, Type* element_type) {
+    return interner_.GetArrayType(size, element_type);
+  }
+  TupleType* GetTupleType(absl::Span<Type* const> element_types) {
+    return interner_.GetTupleType(element_types);
+  }
+  TokenType* GetTokenType() { return interner_.GetTokenType(); }
   FunctionType* GetFunctionType(absl::Span<Type* const> args_types,
-                                Type* return_type);
+                                Type* return_type) {
+    return interner_.GetFunctionType(args_types, return_type);
+  }
+
+  // Returns the package-wide copy of the given value. Literals hold interned
+  // values so equal constants are stored once per package; the copy is freed
+  // when the last reference is dropped. Thread-safe.
+  std::shared_ptr<const Value> InternValue(const Value& value) {
+    return interner_.InternValue(value);
+  }
+
+  // Returns the number of distinct values currently interned in this package.
+  int64_t interned_value_count() const {
+    return interner_.interned_value_count();
+  }
 
   // Returns a pointer to a type owned by this package that is of the same
   // type as 'other_package_type', which may be owned by another package.
@@ -148,7 +167,8 @@ class Package {
   std::string SourceLocationToString(const SourceLocation loc);
 
   // Retrieves the next node ID to assign to a node in the package and
-  // increments the next node counter. For use in node construction.
+  // increments the next node counter. For use in node construction. Thread-safe
+  // so that nodes may be created in different function bases concurrently.
   int64_t GetNextNodeId() { return next_node_id_++; }
 
   // Adds a file to the file-number table and returns its corresponding number.
@@ -162,6 +182,11 @@ class Package {
   // Get the filename corresponding to the given `Fileno`.
   std::optional<std::string> GetFilename(Fileno file_number) const;
 
+  // Returns the mapping from `Fileno` to filename.
+  const absl::flat_hash_map<Fileno, std::string>& fileno_to_name() const {
+    return fileno_to_filename_;
+  }
+
   // Returns the total number of nodes in the graph. Traverses the functions and
   // sums the node counts.
   int64_t GetNodeCount() const;
@@ -199,6 +224,10 @@ class Package {
   // Dumps the IR in a parsable text format.
   std::string DumpIr() const;
 
+  // Serializes the package in the binary IR format (see ir_binary_format.h).
+  // The result can be read with ParsePackageBinary.
+  absl::StatusOr<std::string> ToBinary() const;
+
   std::vector<std::string> GetFunctionNames() const;
 
   // Returns whether this package contains a function with the "target" name.
@@ -209,6 +238,10 @@ class Package {
   // Intended for use by the parser when node ids are suggested by the IR text.
   void set_next_node_id(int64_t value) { next_node_id_ = value; }
 
+  // Returns the snapshot recording changes to this package, or nullptr if
+  // there is none (see package_snapshot.h).
+  PackageSnapshot* active_snapshot() const { return active_snapshot_; }
+
   // Create a channel. Channels are used with send/receive nodes in communicate
   // between procs or between procs and external (to XLS) components. If no
   // channel ID is specified, a unique channel ID will be automatically
@@ -249,6 +282,7 @@ class Package {
   absl::Status AddChannel(std::unique_ptr<Channel> channel);
 
   friend class FunctionBuilder;
+  friend class PackageSnapshot;
 
   std::optional<FunctionBase*> top_;
 
@@ -260,40 +294,16 @@ class Package {
   std::string name_;
 
   // Ordinal to assign to the next node created in this package.
-  int64_t next_node_id_ = 1;
+  std::atomic<int64_t> next_node_id_ = 1;
+
+  // Owner of the types and interned literal values of this package. Declared
+  // before the functions so it outlives the nodes which refer to it.
+  IrInterner interner_;
 
   std::vector<std::unique_ptr<Function>> functions_;
   std::vector<std::unique_ptr<Proc>> procs_;
   std::vector<std::unique_ptr<Block>> blocks_;
 
-  // Set of owned types in this package.
-  absl::flat_hash_set<const Type*> owned_types_;
-
-  // Set of owned function types in this package.
-  absl::flat_hash_set<const FunctionType*> owned_function_types_;
-
-  // Mapping from bit count to the owned "bits" type with that many bits. Use
-  // node_hash_map for pointer stability.
-  absl::node_hash_map<int64_t, BitsType> bit_count_to_type_;
-
-  // Mapping from the size and element type of an array type to the owned
-  // ArrayType. Use node_hash_map for pointer stability.
-  using ArrayKey = std::pair<int64_t, const Type*>;
-  absl::node_hash_map<ArrayKey, ArrayType> array_types_;
-
-  // Mapping from elements to the owned tuple type.
-  //
-  // Uses node_hash_map for pointer stability.
-  using TypeVec = absl::InlinedVector<const Type*, 4>;
-  absl::node_hash_map<TypeVec, TupleType> tuple_types_;
-
-  // Owned token type.
-  TokenType token_type_;
-
-  // Mapping from Type:ToString to the owned function type. Use
-  // node_hash_map for pointer stability.
-  absl::node_hash_map<std::string, FunctionType> function_types_;
-
   // The largest `Fileno` used in this `Package`.
   std::optional<Fileno> maximum_fileno_;
 
@@ -313,6 +323,8 @@ class Package {
 
   // The next channel ID to assign.
   int64_t next_channel_id_ = 0;
+
+  PackageSnapshot* active_snapshot_ = nullptr;
 };
 
 std::ostream& operator<<(std::ostream& os, const Package& package);
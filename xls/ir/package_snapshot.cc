@@ -0,0 +1,265 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/package_snapshot.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/ir/block.h"
+#include "xls/ir/function.h"
+#include "xls/ir/node.h"
+#include "xls/ir/package.h"
+#include "xls/ir/proc.h"
+
+namespace xls {
+namespace {
+
+// Moves the function bases of type T in `owned` into a vector in the order
+// given by `order`.
+template <typename T>
+std::vector<std::unique_ptr<T>> TakeInOrder(
+    absl::Span<T* const> order,
+    absl::flat_hash_map<FunctionBase*, std::unique_ptr<FunctionBase>>* owned) {
+  std::vector<std::unique_ptr<T>> result;
+  result.reserve(order.size());
+  for (T* function_base : order) {
+    auto it = owned->find(function_base);
+    XLS_CHECK(it != owned->end()) << function_base->name();
+    it->second.release();
+    result.push_back(absl::WrapUnique(function_base));
+    owned->erase(it);
+  }
+  return result;
+}
+
+}  // namespace
+
+/* static */
+absl::StatusOr<std::unique_ptr<PackageSnapshot>> PackageSnapshot::Create(
+    Package* package) {
+  if (package->active_snapshot() != nullptr) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "Package %s already has an active snapshot", package->name()));
+  }
+  auto snapshot = absl::WrapUnique(new PackageSnapshot(package));
+  package->active_snapshot_ = snapshot.get();
+  return snapshot;
+}
+
+PackageSnapshot::PackageSnapshot(Package* package)
+    : package_(package), next_node_id_(package->next_node_id()) {
+  SavePackage();
+}
+
+PackageSnapshot::~PackageSnapshot() {
+  if (active_) {
+    Commit();
+  }
+}
+
+bool PackageSnapshot::IsNewFunctionBase(FunctionBase* function_base) const {
+  return !saved_package_.function_bases.contains(function_base);
+}
+
+void PackageSnapshot::SaveNode(Node* node) {
+  // Nodes which are still under construction have no state to restore.
+  if (node->slot_index_ < 0 || saved_nodes_.contains(node)) {
+    return;
+  }
+  FunctionBaseState* function_base_state =
+      SaveFunctionBase(node->function_base());
+  if (function_base_state == nullptr ||
+      node->slot_index_ >= function_base_state->node_slot_count) {
+    // The node is new and is simply destroyed on rollback.
+    return;
+  }
+  saved_nodes_.emplace(node, NodeState{.id = node->id_,
+                                       .name = node->name_,
+                                       .loc = node->loc_,
+                                       .operands = node->operands_,
+                                       .users = node->users_});
+}
+
+PackageSnapshot::FunctionBaseState* PackageSnapshot::SaveFunctionBase(
+    FunctionBase* function_base) {
+  if (IsNewFunctionBase(function_base)) {
+    return nullptr;
+  }
+  auto [it, inserted] =
+      saved_function_bases_.try_emplace(function_base, FunctionBaseState());
+  FunctionBaseState& state = it->second;
+  if (!inserted) {
+    return &state;
+  }
+  if (function_base->IsBlock()) {
+    RecordUnrecordedChange(
+        absl::StrFormat("block %s was changed", function_base->name()));
+  }
+  state.node_slot_count = function_base->nodes_.size();
+  state.removed_node_count = function_base->removed_node_count_;
+  state.params = function_base->params_;
+  if (function_base->IsFunction()) {
+    state.return_value = function_base->AsFunctionOrDie()->return_value_;
+  } else if (function_base->IsProc()) {
+    Proc* proc = function_base->AsProcOrDie();
+    state.next_token = proc->next_token_;
+    state.next_state = proc->next_state_;
+    state.init_values = proc->init_values_;
+  }
+  return &state;
+}
+
+void PackageSnapshot::SavePackage() {
+  PackageState& state = saved_package_;
+  for (const std::unique_ptr<Function>& function : package_->functions()) {
+    state.functions.push_back(function.get());
+    state.function_bases.insert(function.get());
+  }
+  for (const std::unique_ptr<Proc>& proc : package_->procs()) {
+    state.procs.push_back(proc.get());
+    state.function_bases.insert(proc.get());
+  }
+  for (const std::unique_ptr<Block>& block : package_->blocks()) {
+    state.blocks.push_back(block.get());
+    state.function_bases.insert(block.get());
+  }
+  state.top = package_->top_;
+}
+
+bool PackageSnapshot::SaveRemovedNode(Node* node,
+                                      const FunctionBase::NodeSlot& slot) {
+  FunctionBaseState* state = SaveFunctionBase(node->function_base());
+  if (state == nullptr || node->slot_index_ >= state->node_slot_count) {
+    return false;
+  }
+  state->removed_nodes.push_back({node->slot_index_, slot});
+  return true;
+}
+
+void PackageSnapshot::SaveRemovedFunctionBase(
+    std::unique_ptr<FunctionBase> function_base) {
+  removed_function_bases_.push_back(std::move(function_base));
+}
+
+void PackageSnapshot::RecordUnrecordedChange(std::string description) {
+  if (unrecorded_change_.empty()) {
+    unrecorded_change_ = std::move(description);
+  }
+}
+
+absl::Status PackageSnapshot::Rollback() {
+  XLS_RET_CHECK(active_) << "Snapshot is no longer active";
+  if (!CanRollback()) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "Cannot roll back package %s: %s", package_->name(),
+        unrecorded_change_));
+  }
+
+  // Collect all function bases. The ones remaining after the saved lists are
+  // restored were added after the snapshot was taken and are destroyed on
+  // return.
+  absl::flat_hash_map<FunctionBase*, std::unique_ptr<FunctionBase>> owned;
+  for (std::unique_ptr<Function>& function : package_->functions_) {
+    owned[function.get()] = std::move(function);
+  }
+  for (std::unique_ptr<Proc>& proc : package_->procs_) {
+    owned[proc.get()] = std::move(proc);
+  }
+  for (std::unique_ptr<Block>& block : package_->blocks_) {
+    owned[block.get()] = std::move(block);
+  }
+  for (std::unique_ptr<FunctionBase>& function_base : removed_function_bases_) {
+    owned[function_base.get()] = std::move(function_base);
+  }
+  removed_function_bases_.clear();
+  package_->functions_ =
+      TakeInOrder<Function>(saved_package_.functions, &owned);
+  package_->procs_ = TakeInOrder<Proc>(saved_package_.procs, &owned);
+  package_->blocks_ = TakeInOrder<Block>(saved_package_.blocks, &owned);
+  package_->top_ = saved_package_.top;
+
+  for (auto& [function_base, state] : saved_function_bases_) {
+    std::vector<FunctionBase::NodeSlot>& nodes = function_base->nodes_;
+    for (int64_t i = state.node_slot_count; i < nodes.size(); ++i) {
+      if (nodes[i].node != nullptr) {
+        function_base->DropNodeChange(nodes[i].node);
+        function_base->DestroyNode(nodes[i]);
+      }
+    }
+    nodes.resize(state.node_slot_count);
+    for (const auto& [index, slot] : state.removed_nodes) {
+      nodes[index] = slot;
+    }
+    function_base->removed_node_count_ = state.removed_node_count;
+    function_base->params_ = std::move(state.params);
+    if (function_base->IsFunction()) {
+      function_base->AsFunctionOrDie()->return_value_ = state.return_value;
+    } else if (function_base->IsProc()) {
+      Proc* proc = function_base->AsProcOrDie();
+      proc->next_token_ = state.next_token;
+      proc->next_state_ = std::move(state.next_state);
+      proc->init_values_ = std::move(state.init_values);
+    }
+    // Conservatively have the verifier check the whole function base.
+    function_base->MarkStructureChanged();
+  }
+
+  for (auto& [node, state] : saved_nodes_) {
+    node->id_ = state.id;
+    node->name_ = std::move(state.name);
+    node->loc_ = std::move(state.loc);
+    node->operands_ = std::move(state.operands);
+    node->users_ = std::move(state.users);
+  }
+  // Users are sorted by id so re-sort once all ids are restored.
+  for (auto& [node, state] : saved_nodes_) {
+    node->RebuildUserIndex();
+  }
+  package_->next_node_id_ = next_node_id_;
+
+  saved_function_bases_.clear();
+  saved_nodes_.clear();
+  Release();
+  return absl::OkStatus();
+}
+
+void PackageSnapshot::Commit() {
+  XLS_CHECK(active_) << "Snapshot is no longer active";
+  Release();
+}
+
+void PackageSnapshot::Release() {
+  for (auto& [function_base, state] : saved_function_bases_) {
+    for (const auto& [index, slot] : state.removed_nodes) {
+      function_base->DestroyNode(slot);
+    }
+  }
+  saved_function_bases_.clear();
+  saved_nodes_.clear();
+  removed_function_bases_.clear();
+  saved_package_ = PackageState();
+  package_->active_snapshot_ = nullptr;
+  active_ = false;
+}
+
+}  // namespace xls
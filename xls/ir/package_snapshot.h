@@ -0,0 +1,193 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_PACKAGE_SNAPSHOT_H_
+#define XLS_IR_PACKAGE_SNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/ir/function_base.h"
+#include "xls/ir/source_location.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+class Block;
+class Function;
+class Node;
+class Package;
+class Param;
+class Proc;
+
+// A snapshot of a package which allows speculative changes to the package to
+// be undone. While the snapshot is active, the IR mutators record the state of
+// each node, function base, and the package itself in an undo log before
+// changing it for the first time, and removed nodes and function bases are
+// kept alive. Rollback restores the recorded state in time proportional to
+// the number of changed objects rather than the size of the package, which
+// makes it much cheaper than cloning or reparsing a large package for each
+// attempted transformation.
+//
+// Taking a snapshot costs time proportional to the number of function bases
+// in the package. Changes to functions and procs, and adding or removing
+// function bases, are recorded. Changes to blocks and channels are not; if
+// any are made the snapshot can no longer be rolled back (see CanRollback).
+// New names are not returned to the node name uniquer on rollback so nodes
+// created after a rollback may get different (still unique) names than they
+// would otherwise.
+//
+// Example:
+//
+//   XLS_ASSIGN_OR_RETURN(std::unique_ptr<PackageSnapshot> snapshot,
+//                        PackageSnapshot::Create(package));
+//   XLS_ASSIGN_OR_RETURN(bool changed, TryTransformation(package));
+//   if (!IsImprovement(package)) {
+//     XLS_RETURN_IF_ERROR(snapshot->Rollback());
+//   }
+//
+// At most one snapshot of a package may be active at a time. The snapshot
+// must be destroyed before the package.
+class PackageSnapshot {
+ public:
+  // Takes a snapshot of the current state of the given package.
+  static absl::StatusOr<std::unique_ptr<PackageSnapshot>> Create(
+      Package* package);
+
+  // Commits the changes if the snapshot is still active.
+  ~PackageSnapshot();
+
+  PackageSnapshot(const PackageSnapshot&) = delete;
+  PackageSnapshot& operator=(const PackageSnapshot&) = delete;
+
+  // Returns whether the snapshot has not yet been committed or rolled back.
+  bool active() const { return active_; }
+
+  // Returns false if unrecorded changes (to blocks or channels) were made to
+  // the package since the snapshot was taken.
+  bool CanRollback() const { return unrecorded_change_.empty(); }
+
+  // Restores the package to its state when the snapshot was taken and ends
+  // the snapshot. All pointers to nodes and function bases created since the
+  // snapshot was taken are invalidated. Returns an error without changing
+  // the package if CanRollback is false.
+  absl::Status Rollback();
+
+  // Keeps the changes made since the snapshot was taken and ends the
+  // snapshot, releasing the removed nodes and function bases.
+  void Commit();
+
+  // Returns the number of nodes and function bases whose state has been
+  // recorded in the undo log.
+  int64_t saved_node_count() const { return saved_nodes_.size(); }
+  int64_t saved_function_base_count() const {
+    return saved_function_bases_.size();
+  }
+
+ private:
+  // The IR mutators record state through the Save* methods below.
+  friend class FunctionBase;
+  friend class Node;
+  friend class Package;
+
+  struct NodeState {
+    int64_t id;
+    std::string name;
+    SourceInfo loc;
+    std::vector<Node*> operands;
+    absl::InlinedVector<Node*, 2> users;
+  };
+
+  struct FunctionBaseState {
+    // Number of node slots. Nodes in later slots were added after the
+    // snapshot was taken.
+    int64_t node_slot_count;
+    int64_t removed_node_count;
+    std::vector<Param*> params;
+    // Nodes removed after the snapshot was taken, indexed by slot.
+    std::vector<std::pair<int64_t, FunctionBase::NodeSlot>> removed_nodes;
+
+    // State specific to functions and procs.
+    Node* return_value = nullptr;
+    Node* next_token = nullptr;
+    std::vector<Node*> next_state;
+    std::vector<Value> init_values;
+  };
+
+  struct PackageState {
+    std::vector<Function*> functions;
+    std::vector<Proc*> procs;
+    std::vector<Block*> blocks;
+    std::optional<FunctionBase*> top;
+    absl::flat_hash_set<FunctionBase*> function_bases;
+  };
+
+  explicit PackageSnapshot(Package* package);
+
+  // Records the state of the given node if it has not been recorded yet.
+  void SaveNode(Node* node);
+
+  // Records the state of the given function base if it has not been recorded
+  // yet. Returns nullptr if the function base was created after the snapshot
+  // was taken.
+  FunctionBaseState* SaveFunctionBase(FunctionBase* function_base);
+
+  // Records the list of function bases in the package and the top. This is
+  // done when the snapshot is taken so that function bases created later
+  // (including ones still being built) are known to be new.
+  void SavePackage();
+
+  // Takes ownership of a node removed from its function base. Returns false
+  // (and does not take ownership) if the node was created after the snapshot
+  // was taken in which case it can be destroyed immediately.
+  bool SaveRemovedNode(Node* node, const FunctionBase::NodeSlot& slot);
+
+  // Takes ownership of a function base removed from the package.
+  void SaveRemovedFunctionBase(std::unique_ptr<FunctionBase> function_base);
+
+  // Records that a change was made which cannot be rolled back.
+  void RecordUnrecordedChange(std::string description);
+
+  // Returns whether the function base was added after the snapshot was taken.
+  bool IsNewFunctionBase(FunctionBase* function_base) const;
+
+  // Destroys the removed nodes and function bases and detaches from the
+  // package.
+  void Release();
+
+  Package* package_;
+  bool active_ = true;
+  int64_t next_node_id_;
+
+  absl::flat_hash_map<Node*, NodeState> saved_nodes_;
+  absl::flat_hash_map<FunctionBase*, FunctionBaseState> saved_function_bases_;
+  PackageState saved_package_;
+  std::vector<std::unique_ptr<FunctionBase>> removed_function_bases_;
+
+  // Description of the first change which was not recorded, if any.
+  std::string unrecorded_change_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_PACKAGE_SNAPSHOT_H_
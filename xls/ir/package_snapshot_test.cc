@@ -0,0 +1,220 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/package_snapshot.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_matcher.h"
+#include "xls/ir/ir_test_base.h"
+
+namespace m = ::xls::op_matchers;
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+class PackageSnapshotTest : public IrTestBase {};
+
+TEST_F(PackageSnapshotTest, RollbackRestoresFunction) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+fn f(x: bits[32], y: bits[32], z: bits[32]) -> bits[32] {
+  add.4: bits[32] = add(x, y)
+  ret sub: bits[32] = sub(add.4, x)
+}
+)",
+                                                       p.get()));
+  std::string original_ir = p->DumpIr();
+  int64_t next_node_id = p->next_node_id();
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageSnapshot> snapshot,
+                           PackageSnapshot::Create(p.get()));
+  Node* sub = f->return_value();
+  Node* add = sub->operand(0);
+  XLS_ASSERT_OK(sub->ReplaceUsesWithNew<Literal>(Value(UBits(0, 32))).status());
+  XLS_ASSERT_OK(f->RemoveNode(sub));
+  XLS_ASSERT_OK(f->RemoveNode(add));
+  XLS_ASSERT_OK(f->RemoveNode(FindNode("z", f)));
+  EXPECT_THAT(f->return_value(), m::Literal(0));
+  EXPECT_EQ(f->params().size(), 2);
+  EXPECT_NE(p->DumpIr(), original_ir);
+
+  XLS_ASSERT_OK(snapshot->Rollback());
+  EXPECT_FALSE(snapshot->active());
+  EXPECT_EQ(p->active_snapshot(), nullptr);
+  EXPECT_EQ(p->DumpIr(), original_ir);
+  EXPECT_EQ(p->next_node_id(), next_node_id);
+  EXPECT_THAT(f->return_value(), m::Sub(m::Add(m::Param("x"), m::Param("y")),
+                                        m::Param("x")));
+  EXPECT_EQ(f->params().size(), 3);
+  EXPECT_EQ(f->node_count(), 5);
+
+  // The restored function can be changed again.
+  XLS_ASSERT_OK(f->return_value()->ReplaceOperandNumber(1, FindNode("z", f)));
+  EXPECT_THAT(f->return_value(), m::Sub(m::Add(), m::Param("z")));
+}
+
+TEST_F(PackageSnapshotTest, CommitKeepsChanges) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  fb.Not(fb.Not(x));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageSnapshot> snapshot,
+                             PackageSnapshot::Create(p.get()));
+    Node* outer_not = f->return_value();
+    XLS_ASSERT_OK(outer_not->ReplaceUsesWith(x.node()));
+    XLS_ASSERT_OK(f->RemoveNode(outer_not));
+    // Only the nodes whose state changed are recorded.
+    EXPECT_EQ(snapshot->saved_node_count(), 1);
+    EXPECT_EQ(snapshot->saved_function_base_count(), 1);
+    snapshot->Commit();
+    EXPECT_FALSE(snapshot->active());
+  }
+  EXPECT_EQ(p->active_snapshot(), nullptr);
+  EXPECT_THAT(f->return_value(), m::Param("x"));
+  EXPECT_EQ(f->node_count(), 2);
+}
+
+TEST_F(PackageSnapshotTest, RollbackRestoresFunctionBases) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedPackage> package,
+                           ParsePackage(R"(
+package test
+
+fn callee(x: bits[32]) -> bits[32] {
+  ret neg.2: bits[32] = neg(x)
+}
+
+top fn main(x: bits[32]) -> bits[32] {
+  ret x: bits[32] = param(name=x)
+}
+)"));
+  std::string original_ir = package->DumpIr();
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageSnapshot> snapshot,
+                           PackageSnapshot::Create(package.get()));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * callee, package->GetFunction("callee"));
+  XLS_ASSERT_OK(package->RemoveFunction(callee));
+  FunctionBuilder fb("added", package.get());
+  fb.Literal(UBits(1, 1));
+  XLS_ASSERT_OK(fb.Build().status());
+  EXPECT_EQ(package->GetFunctionNames(),
+            (std::vector<std::string>{"main", "added"}));
+
+  XLS_ASSERT_OK(snapshot->Rollback());
+  EXPECT_EQ(package->DumpIr(), original_ir);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * restored,
+                           package->GetFunction("callee"));
+  EXPECT_EQ(restored, callee);
+  EXPECT_THAT(restored->return_value(), m::Neg(m::Param("x")));
+}
+
+TEST_F(PackageSnapshotTest, RollbackRestoresProcState) {
+  auto p = CreatePackage();
+  ProcBuilder pb("p", "tkn", p.get());
+  BValue state = pb.StateElement("st", Value(UBits(42, 32)));
+  BValue add = pb.Add(pb.Literal(UBits(1, 32)), state);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build(pb.GetTokenParam(), {add}));
+  std::string original_ir = p->DumpIr();
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageSnapshot> snapshot,
+                           PackageSnapshot::Create(p.get()));
+  XLS_ASSERT_OK(proc->SetNextStateElement(0, proc->GetStateParam(0)));
+  XLS_ASSERT_OK(proc->RemoveNode(add.node()));
+  XLS_ASSERT_OK(proc->AppendStateElement("other", Value(UBits(1, 8))).status());
+  EXPECT_EQ(proc->GetStateElementCount(), 2);
+
+  XLS_ASSERT_OK(snapshot->Rollback());
+  EXPECT_EQ(p->DumpIr(), original_ir);
+  EXPECT_EQ(proc->GetStateElementCount(), 1);
+  EXPECT_THAT(proc->GetNextStateElement(0), m::Add());
+  EXPECT_EQ(proc->GetInitValueElement(0), Value(UBits(42, 32)));
+}
+
+TEST_F(PackageSnapshotTest, RollbackOfManyRemovedNodes) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(32));
+  BValue value = x;
+  for (int64_t i = 0; i < 200; ++i) {
+    value = fb.Negate(value);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  std::string original_ir = p->DumpIr();
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageSnapshot> snapshot,
+                           PackageSnapshot::Create(p.get()));
+  // Removing most of the nodes would ordinarily compact the node storage.
+  XLS_ASSERT_OK(f->set_return_value(x.node()));
+  while (f->node_count() > 1) {
+    Node* dead = nullptr;
+    for (Node* node : f->nodes()) {
+      if (node != x.node() && node->users().empty()) {
+        dead = node;
+        break;
+      }
+    }
+    XLS_ASSERT_OK(f->RemoveNode(dead));
+  }
+
+  XLS_ASSERT_OK(snapshot->Rollback());
+  EXPECT_EQ(p->DumpIr(), original_ir);
+  EXPECT_EQ(f->node_count(), 201);
+}
+
+TEST_F(PackageSnapshotTest, BlockChangesCannotBeRolledBack) {
+  auto p = CreatePackage();
+  BlockBuilder bb(TestName(), p.get());
+  bb.OutputPort("out", bb.InputPort("in", p->GetBitsType(32)));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, bb.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageSnapshot> snapshot,
+                           PackageSnapshot::Create(p.get()));
+  EXPECT_TRUE(snapshot->CanRollback());
+  XLS_ASSERT_OK(block->AddClockPort("clk"));
+  EXPECT_FALSE(snapshot->CanRollback());
+  EXPECT_THAT(snapshot->Rollback(),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("was changed")));
+  snapshot->Commit();
+  EXPECT_TRUE(block->GetClockPort().has_value());
+}
+
+TEST_F(PackageSnapshotTest, OnlyOneActiveSnapshot) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PackageSnapshot> snapshot,
+                           PackageSnapshot::Create(p.get()));
+  EXPECT_EQ(p->active_snapshot(), snapshot.get());
+  EXPECT_THAT(PackageSnapshot::Create(p.get()),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("already has an active snapshot")));
+  snapshot.reset();
+  EXPECT_EQ(p->active_snapshot(), nullptr);
+  XLS_EXPECT_OK(PackageSnapshot::Create(p.get()).status());
+}
+
+}  // namespace
+}  // namespace xls
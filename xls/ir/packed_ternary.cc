@@ -0,0 +1,241 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/packed_ternary.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/numeric/bits.h"
+#include "xls/common/bits_util.h"
+#include "xls/common/logging/logging.h"
+#include "xls/data_structures/bitmap_kernels.h"
+
+namespace xls {
+namespace {
+
+using bitmap_kernels::WordAnd;
+using bitmap_kernels::WordAndNot;
+using bitmap_kernels::WordOr;
+using bitmap_kernels::WordXor;
+
+constexpr int64_t kWordBits = 64;
+
+// Returns the 64 bits of `bitmap` starting at bit `offset`. Bits beyond the
+// end of the bitmap are zero.
+uint64_t GetBitsAt(const InlineBitmap& bitmap, int64_t offset) {
+  absl::Span<const uint64_t> words = bitmap.words();
+  int64_t wordno = offset / kWordBits;
+  int64_t shift = offset % kWordBits;
+  uint64_t lo = wordno < words.size() ? words[wordno] : 0;
+  if (shift == 0) {
+    return lo;
+  }
+  uint64_t hi = wordno + 1 < words.size() ? words[wordno + 1] : 0;
+  return (lo >> shift) | (hi << (kWordBits - shift));
+}
+
+// ORs the low `count` bits of `bits` into `bitmap` starting at bit `offset`.
+void OrBitsAt(InlineBitmap* bitmap, int64_t offset, uint64_t bits,
+              int64_t count) {
+  absl::Span<uint64_t> words = bitmap->mutable_words();
+  bits &= Mask(count);
+  int64_t wordno = offset / kWordBits;
+  int64_t shift = offset % kWordBits;
+  words[wordno] |= bits << shift;
+  if (shift != 0 && shift + count > kWordBits) {
+    words[wordno + 1] |= bits >> (kWordBits - shift);
+  }
+}
+
+// ORs `count` bits of `src` starting at `src_offset` into `dst` starting at
+// `dst_offset`, a word at a time.
+void OrBitRange(const InlineBitmap& src, int64_t src_offset, int64_t count,
+                InlineBitmap* dst, int64_t dst_offset) {
+  for (int64_t i = 0; i < count; i += kWordBits) {
+    OrBitsAt(dst, dst_offset + i, GetBitsAt(src, src_offset + i),
+             std::min(kWordBits, count - i));
+  }
+}
+
+// Applies the given two-bit-plane kernel to the operands.
+template <typename F>
+PackedTernaryVector ApplyBinaryKernel(const PackedTernaryVector& a,
+                                      const PackedTernaryVector& b, F f) {
+  XLS_CHECK_EQ(a.bit_count(), b.bit_count());
+  InlineBitmap known(a.bit_count());
+  InlineBitmap value(a.bit_count());
+  bitmap_kernels::ApplyPairBinary(
+      a.known().words().data(), a.value().words().data(),
+      b.known().words().data(), b.value().words().data(),
+      known.mutable_words().data(), value.mutable_words().data(),
+      known.word_count(), f);
+  return PackedTernaryVector::FromBitPlanes(std::move(known), std::move(value));
+}
+
+}  // namespace
+
+/* static */ PackedTernaryVector PackedTernaryVector::FromBits(
+    const Bits& bits) {
+  return PackedTernaryVector(InlineBitmap(bits.bit_count(), /*fill=*/true),
+                             bits.bitmap());
+}
+
+/* static */ PackedTernaryVector PackedTernaryVector::FromKnownBits(
+    const Bits& known_bits, const Bits& known_bits_values) {
+  XLS_CHECK_EQ(known_bits.bit_count(), known_bits_values.bit_count());
+  InlineBitmap value = known_bits_values.bitmap();
+  value.Intersect(known_bits.bitmap());
+  return PackedTernaryVector(known_bits.bitmap(), std::move(value));
+}
+
+/* static */ PackedTernaryVector PackedTernaryVector::FromBitPlanes(
+    InlineBitmap known, InlineBitmap value) {
+  XLS_CHECK_EQ(known.bit_count(), value.bit_count());
+  for (int64_t i = 0; i < known.word_count(); ++i) {
+    XLS_DCHECK_EQ(value.GetWord(i) & ~known.GetWord(i), 0)
+        << "Unknown bits must have a zero value";
+  }
+  return PackedTernaryVector(std::move(known), std::move(value));
+}
+
+/* static */ PackedTernaryVector PackedTernaryVector::FromTernaryVector(
+    const TernaryVector& vector) {
+  PackedTernaryVector result(vector.size());
+  for (int64_t i = 0; i < vector.size(); ++i) {
+    result.Set(i, vector[i]);
+  }
+  return result;
+}
+
+TernaryVector PackedTernaryVector::ToTernaryVector() const {
+  TernaryVector result(bit_count());
+  for (int64_t i = 0; i < bit_count(); ++i) {
+    result[i] = Get(i);
+  }
+  return result;
+}
+
+int64_t PackedTernaryVector::NumberOfKnownBits() const {
+  int64_t count = 0;
+  for (uint64_t word : known_.words()) {
+    count += absl::popcount(word);
+  }
+  return count;
+}
+
+std::string PackedTernaryVector::ToString() const {
+  return xls::ToString(ToTernaryVector());
+}
+
+namespace packed_ternary_ops {
+
+PackedTernaryVector And(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  // The result is known if both operands are known or either is known zero.
+  return ApplyBinaryKernel(
+      a, b, [](auto ka, auto va, auto kb, auto vb, auto* k, auto* v) {
+        *v = WordAnd(va, vb);
+        *k = WordOr(WordAnd(ka, kb),
+                    WordOr(WordAndNot(ka, va), WordAndNot(kb, vb)));
+      });
+}
+
+PackedTernaryVector Or(const PackedTernaryVector& a,
+                       const PackedTernaryVector& b) {
+  // The result is known if both operands are known or either is known one.
+  return ApplyBinaryKernel(
+      a, b, [](auto ka, auto va, auto kb, auto vb, auto* k, auto* v) {
+        *v = WordOr(va, vb);
+        *k = WordOr(WordAnd(ka, kb), *v);
+      });
+}
+
+PackedTernaryVector Xor(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b) {
+  return ApplyBinaryKernel(
+      a, b, [](auto ka, auto va, auto kb, auto vb, auto* k, auto* v) {
+        *k = WordAnd(ka, kb);
+        *v = WordAnd(WordXor(va, vb), *k);
+      });
+}
+
+PackedTernaryVector Not(const PackedTernaryVector& a) {
+  InlineBitmap value(a.bit_count());
+  bitmap_kernels::ApplyBinary(
+      a.known().words().data(), a.value().words().data(),
+      value.mutable_words().data(), value.word_count(),
+      [](auto k, auto v) { return WordAndNot(k, v); });
+  return PackedTernaryVector::FromBitPlanes(a.known(), std::move(value));
+}
+
+PackedTernaryVector Concat(absl::Span<const PackedTernaryVector> inputs) {
+  int64_t bit_count = 0;
+  for (const PackedTernaryVector& input : inputs) {
+    bit_count += input.bit_count();
+  }
+  InlineBitmap known(bit_count);
+  InlineBitmap value(bit_count);
+  int64_t offset = bit_count;
+  for (const PackedTernaryVector& input : inputs) {
+    offset -= input.bit_count();
+    OrBitRange(input.known(), 0, input.bit_count(), &known, offset);
+    OrBitRange(input.value(), 0, input.bit_count(), &value, offset);
+  }
+  return PackedTernaryVector::FromBitPlanes(std::move(known), std::move(value));
+}
+
+PackedTernaryVector BitSlice(const PackedTernaryVector& a, int64_t start,
+                             int64_t width) {
+  XLS_CHECK_GE(start, 0);
+  XLS_CHECK_LE(start + width, a.bit_count());
+  InlineBitmap known(width);
+  InlineBitmap value(width);
+  OrBitRange(a.known(), start, width, &known, 0);
+  OrBitRange(a.value(), start, width, &value, 0);
+  return PackedTernaryVector::FromBitPlanes(std::move(known), std::move(value));
+}
+
+std::optional<PackedTernaryVector> Meet(const PackedTernaryVector& a,
+                                        const PackedTernaryVector& b) {
+  XLS_CHECK_EQ(a.bit_count(), b.bit_count());
+  absl::Span<const uint64_t> a_known = a.known().words();
+  absl::Span<const uint64_t> a_value = a.value().words();
+  absl::Span<const uint64_t> b_known = b.known().words();
+  absl::Span<const uint64_t> b_value = b.value().words();
+  uint64_t conflicts = 0;
+  for (int64_t i = 0; i < a_known.size(); ++i) {
+    conflicts |= a_known[i] & b_known[i] & (a_value[i] ^ b_value[i]);
+  }
+  if (conflicts != 0) {
+    return std::nullopt;
+  }
+  return ApplyBinaryKernel(
+      a, b, [](auto ka, auto va, auto kb, auto vb, auto* k, auto* v) {
+        *k = WordOr(ka, kb);
+        *v = WordOr(va, vb);
+      });
+}
+
+PackedTernaryVector Join(const PackedTernaryVector& a,
+                         const PackedTernaryVector& b) {
+  return ApplyBinaryKernel(
+      a, b, [](auto ka, auto va, auto kb, auto vb, auto* k, auto* v) {
+        *k = WordAndNot(WordAnd(ka, kb), WordXor(va, vb));
+        *v = WordAnd(va, *k);
+      });
+}
+
+}  // namespace packed_ternary_ops
+}  // namespace xls
@@ -0,0 +1,140 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_PACKED_TERNARY_H_
+#define XLS_IR_PACKED_TERNARY_H_
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "absl/types/span.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/ternary.h"
+
+namespace xls {
+
+// A vector of ternary values stored as two bit planes: `known` has a one for
+// each bit whose value is known, and `value` holds the values of the known
+// bits (and is zero for unknown bits). Unlike TernaryVector, which stores one
+// TernaryValue per bit, the bitwise operations in packed_ternary_ops process
+// a word of bits at a time, vectorized where the target supports it (see
+// bitmap_kernels.h).
+class PackedTernaryVector {
+ public:
+  // Creates a vector of `bit_count` unknown bits.
+  explicit PackedTernaryVector(int64_t bit_count)
+      : known_(bit_count), value_(bit_count) {}
+
+  // Creates a fully known vector with the given value.
+  static PackedTernaryVector FromBits(const Bits& bits);
+
+  // Creates a vector with the bits set in `known_bits` known to have the
+  // corresponding value in `known_bits_values`.
+  static PackedTernaryVector FromKnownBits(const Bits& known_bits,
+                                           const Bits& known_bits_values);
+
+  // Creates a vector from the given bit planes. `value` must be zero wherever
+  // `known` is zero.
+  static PackedTernaryVector FromBitPlanes(InlineBitmap known,
+                                           InlineBitmap value);
+
+  static PackedTernaryVector FromTernaryVector(const TernaryVector& vector);
+  TernaryVector ToTernaryVector() const;
+
+  int64_t bit_count() const { return known_.bit_count(); }
+
+  TernaryValue Get(int64_t index) const {
+    if (!known_.Get(index)) {
+      return TernaryValue::kUnknown;
+    }
+    return value_.Get(index) ? TernaryValue::kKnownOne
+                             : TernaryValue::kKnownZero;
+  }
+  void Set(int64_t index, TernaryValue value) {
+    known_.Set(index, value != TernaryValue::kUnknown);
+    value_.Set(index, value == TernaryValue::kKnownOne);
+  }
+
+  const InlineBitmap& known() const { return known_; }
+  const InlineBitmap& value() const { return value_; }
+
+  // Returns a Bits with a one for each known bit (known one bit).
+  Bits ToKnownBits() const { return Bits::FromBitmap(known_); }
+  Bits ToKnownBitsValues() const { return Bits::FromBitmap(value_); }
+
+  bool IsFullyKnown() const { return known_.IsAllOnes(); }
+  bool AllUnknown() const { return known_.IsAllZeroes(); }
+  int64_t NumberOfKnownBits() const;
+
+  // Format is the same as for TernaryVector, for example: 0b10XX1
+  std::string ToString() const;
+
+  bool operator==(const PackedTernaryVector& other) const {
+    return known_ == other.known_ && value_ == other.value_;
+  }
+  bool operator!=(const PackedTernaryVector& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  PackedTernaryVector(InlineBitmap known, InlineBitmap value)
+      : known_(std::move(known)), value_(std::move(value)) {}
+
+  InlineBitmap known_;
+  InlineBitmap value_;
+};
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const PackedTernaryVector& vector) {
+  os << vector.ToString();
+  return os;
+}
+
+namespace packed_ternary_ops {
+
+// Bitwise ternary logic. The operands must have the same width.
+PackedTernaryVector And(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+PackedTernaryVector Or(const PackedTernaryVector& a,
+                       const PackedTernaryVector& b);
+PackedTernaryVector Xor(const PackedTernaryVector& a,
+                        const PackedTernaryVector& b);
+PackedTernaryVector Not(const PackedTernaryVector& a);
+
+// Concatenates the given vectors. As with bits_ops::Concat, the zero-th
+// element is the most significant.
+PackedTernaryVector Concat(absl::Span<const PackedTernaryVector> inputs);
+
+// Returns the `width` bits of `a` starting at bit `start`.
+PackedTernaryVector BitSlice(const PackedTernaryVector& a, int64_t start,
+                             int64_t width);
+
+// Returns the combined knowledge of `a` and `b`: each bit known in either is
+// known. Returns std::nullopt if `a` and `b` have conflicting known values.
+std::optional<PackedTernaryVector> Meet(const PackedTernaryVector& a,
+                                        const PackedTernaryVector& b);
+
+// Returns the knowledge common to `a` and `b`: a bit is known only if it is
+// known with the same value in both. This is the value of a select between
+// `a` and `b` with an unknown selector.
+PackedTernaryVector Join(const PackedTernaryVector& a,
+                         const PackedTernaryVector& b);
+
+}  // namespace packed_ternary_ops
+}  // namespace xls
+
+#endif  // XLS_IR_PACKED_TERNARY_H_
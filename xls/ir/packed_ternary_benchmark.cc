@@ -0,0 +1,145 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "xls/ir/packed_ternary.h"
+#include "xls/ir/ternary.h"
+
+namespace xls {
+namespace {
+
+// Compares the throughput of the word-parallel ternary operations on
+// PackedTernaryVector with the equivalent per-bit operations on TernaryVector
+// (as performed by the TernaryEvaluator) on wide datapaths.
+
+TernaryVector RandomTernaryVector(int64_t bit_count, std::mt19937_64& bitgen) {
+  TernaryVector result(bit_count);
+  for (TernaryValue& value : result) {
+    value = static_cast<TernaryValue>(bitgen() % 3);
+  }
+  return result;
+}
+
+void Widths(benchmark::internal::Benchmark* b) {
+  for (int64_t width : {64, 256, 1024, 8192}) {
+    b->Arg(width);
+  }
+}
+
+static void BM_PerBitAnd(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  TernaryVector a = RandomTernaryVector(state.range(0), bitgen);
+  TernaryVector b = RandomTernaryVector(state.range(0), bitgen);
+  for (auto _ : state) {
+    TernaryVector result(a.size());
+    for (int64_t i = 0; i < a.size(); ++i) {
+      result[i] = ternary_ops::And(a[i], b[i]);
+    }
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PerBitAnd)->Apply(Widths);
+
+static void BM_PackedAnd(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  PackedTernaryVector a = PackedTernaryVector::FromTernaryVector(
+      RandomTernaryVector(state.range(0), bitgen));
+  PackedTernaryVector b = PackedTernaryVector::FromTernaryVector(
+      RandomTernaryVector(state.range(0), bitgen));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(packed_ternary_ops::And(a, b));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PackedAnd)->Apply(Widths);
+
+static void BM_PackedOr(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  PackedTernaryVector a = PackedTernaryVector::FromTernaryVector(
+      RandomTernaryVector(state.range(0), bitgen));
+  PackedTernaryVector b = PackedTernaryVector::FromTernaryVector(
+      RandomTernaryVector(state.range(0), bitgen));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(packed_ternary_ops::Or(a, b));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PackedOr)->Apply(Widths);
+
+static void BM_PackedXor(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  PackedTernaryVector a = PackedTernaryVector::FromTernaryVector(
+      RandomTernaryVector(state.range(0), bitgen));
+  PackedTernaryVector b = PackedTernaryVector::FromTernaryVector(
+      RandomTernaryVector(state.range(0), bitgen));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(packed_ternary_ops::Xor(a, b));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PackedXor)->Apply(Widths);
+
+static void BM_PerBitConcatAndSlice(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  TernaryVector a = RandomTernaryVector(state.range(0), bitgen);
+  TernaryVector b = RandomTernaryVector(state.range(0), bitgen);
+  for (auto _ : state) {
+    // TernaryVector is least significant bit first.
+    TernaryVector concat = b;
+    concat.insert(concat.end(), a.begin(), a.end());
+    TernaryVector slice(concat.begin() + 3, concat.begin() + 3 + a.size());
+    benchmark::DoNotOptimize(slice);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PerBitConcatAndSlice)->Apply(Widths);
+
+static void BM_PackedConcatAndSlice(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  std::vector<PackedTernaryVector> operands = {
+      PackedTernaryVector::FromTernaryVector(
+          RandomTernaryVector(state.range(0), bitgen)),
+      PackedTernaryVector::FromTernaryVector(
+          RandomTernaryVector(state.range(0), bitgen))};
+  for (auto _ : state) {
+    // An unaligned slice exercises the shifting word copies.
+    PackedTernaryVector concat = packed_ternary_ops::Concat(operands);
+    benchmark::DoNotOptimize(
+        packed_ternary_ops::BitSlice(concat, 3, state.range(0)));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PackedConcatAndSlice)->Apply(Widths);
+
+static void BM_PackedMeet(benchmark::State& state) {
+  std::mt19937_64 bitgen(42);
+  PackedTernaryVector a = PackedTernaryVector::FromTernaryVector(
+      RandomTernaryVector(state.range(0), bitgen));
+  PackedTernaryVector b = packed_ternary_ops::Join(
+      a, PackedTernaryVector::FromTernaryVector(
+             RandomTernaryVector(state.range(0), bitgen)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(packed_ternary_ops::Meet(a, b));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PackedMeet)->Apply(Widths);
+
+}  // namespace
+}  // namespace xls
@@ -0,0 +1,146 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/packed_ternary.h"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/ternary.h"
+
+namespace xls {
+namespace {
+
+TernaryValue Xor(TernaryValue a, TernaryValue b) {
+  if (a == TernaryValue::kUnknown || b == TernaryValue::kUnknown) {
+    return TernaryValue::kUnknown;
+  }
+  return a == b ? TernaryValue::kKnownZero : TernaryValue::kKnownOne;
+}
+
+TernaryVector RandomTernaryVector(int64_t bit_count, std::mt19937_64& bitgen) {
+  TernaryVector result(bit_count);
+  for (TernaryValue& value : result) {
+    value = static_cast<TernaryValue>(bitgen() % 3);
+  }
+  return result;
+}
+
+PackedTernaryVector FromString(std::string_view s) {
+  return PackedTernaryVector::FromTernaryVector(
+      StringToTernaryVector(s).value());
+}
+
+TEST(PackedTernaryTest, Conversions) {
+  TernaryVector vector = StringToTernaryVector("0b1101X1X001").value();
+  PackedTernaryVector packed = PackedTernaryVector::FromTernaryVector(vector);
+  EXPECT_EQ(packed.bit_count(), 10);
+  EXPECT_EQ(packed.ToTernaryVector(), vector);
+  EXPECT_EQ(packed.ToString(), "0b1101X1X001");
+  EXPECT_EQ(packed.NumberOfKnownBits(), 8);
+  EXPECT_EQ(packed.ToKnownBits(), UBits(0b1111010111, 10));
+  EXPECT_EQ(packed.ToKnownBitsValues(), UBits(0b1101010001, 10));
+  EXPECT_EQ(packed, PackedTernaryVector::FromKnownBits(
+                        UBits(0b1111010111, 10), UBits(0b1101010001, 10)));
+  EXPECT_EQ(packed.Get(1), TernaryValue::kUnknown);
+  EXPECT_EQ(packed.Get(4), TernaryValue::kKnownOne);
+
+  EXPECT_TRUE(PackedTernaryVector(100).AllUnknown());
+  EXPECT_TRUE(PackedTernaryVector::FromBits(UBits(42, 100)).IsFullyKnown());
+  EXPECT_TRUE(PackedTernaryVector(0).IsFullyKnown());
+  EXPECT_TRUE(PackedTernaryVector(0).AllUnknown());
+}
+
+TEST(PackedTernaryTest, BitwiseOps) {
+  EXPECT_EQ(packed_ternary_ops::And(FromString("0b01X01X01X"),
+                                    FromString("0b000111XXX")),
+            FromString("0b00001X0XX"));
+  EXPECT_EQ(packed_ternary_ops::Or(FromString("0b01X01X01X"),
+                                   FromString("0b000111XXX")),
+            FromString("0b01X111X1X"));
+  EXPECT_EQ(packed_ternary_ops::Xor(FromString("0b01X01X01X"),
+                                    FromString("0b000111XXX")),
+            FromString("0b01X10XXXX"));
+  EXPECT_EQ(packed_ternary_ops::Not(FromString("0b01X")), FromString("0b10X"));
+}
+
+TEST(PackedTernaryTest, ConcatAndBitSlice) {
+  EXPECT_EQ(packed_ternary_ops::Concat({FromString("0b1X"), FromString("0b0"),
+                                        FromString("0bX01")}),
+            FromString("0b1X0X01"));
+  EXPECT_EQ(packed_ternary_ops::BitSlice(FromString("0b1X0X01"), 1, 3),
+            FromString("0b0X0"));
+  EXPECT_EQ(packed_ternary_ops::BitSlice(FromString("0b1X0X01"), 0, 0),
+            PackedTernaryVector(0));
+}
+
+TEST(PackedTernaryTest, MeetAndJoin) {
+  EXPECT_EQ(
+      packed_ternary_ops::Meet(FromString("0b1X0X"), FromString("0bX00X")),
+      FromString("0b100X"));
+  EXPECT_EQ(
+      packed_ternary_ops::Meet(FromString("0b1X0X"), FromString("0b0XXX")),
+      std::nullopt);
+  EXPECT_EQ(
+      packed_ternary_ops::Join(FromString("0b1101"), FromString("0b1X00")),
+      FromString("0b1X0X"));
+}
+
+// Compares the word-parallel operations with the per-bit ternary logic on
+// wide vectors with widths which are not a multiple of the vector size.
+TEST(PackedTernaryTest, WideOpsMatchPerBitOps) {
+  std::mt19937_64 bitgen(42);
+  for (int64_t bit_count : {1, 63, 64, 65, 255, 257, 1000, 4099}) {
+    TernaryVector a = RandomTernaryVector(bit_count, bitgen);
+    TernaryVector b = RandomTernaryVector(bit_count, bitgen);
+    TernaryVector expected_and(bit_count);
+    TernaryVector expected_or(bit_count);
+    TernaryVector expected_xor(bit_count);
+    for (int64_t i = 0; i < bit_count; ++i) {
+      expected_and[i] = ternary_ops::And(a[i], b[i]);
+      expected_or[i] = ternary_ops::Or(a[i], b[i]);
+      expected_xor[i] = Xor(a[i], b[i]);
+    }
+    PackedTernaryVector packed_a = PackedTernaryVector::FromTernaryVector(a);
+    PackedTernaryVector packed_b = PackedTernaryVector::FromTernaryVector(b);
+    EXPECT_EQ(packed_ternary_ops::And(packed_a, packed_b).ToTernaryVector(),
+              expected_and);
+    EXPECT_EQ(packed_ternary_ops::Or(packed_a, packed_b).ToTernaryVector(),
+              expected_or);
+    EXPECT_EQ(packed_ternary_ops::Xor(packed_a, packed_b).ToTernaryVector(),
+              expected_xor);
+
+    // Concatenate then slice the operands back out at unaligned offsets.
+    PackedTernaryVector concat =
+        packed_ternary_ops::Concat({packed_a, packed_b, packed_a});
+    EXPECT_EQ(packed_ternary_ops::BitSlice(concat, 0, bit_count), packed_a);
+    EXPECT_EQ(packed_ternary_ops::BitSlice(concat, bit_count, bit_count),
+              packed_b);
+    EXPECT_EQ(packed_ternary_ops::BitSlice(concat, 2 * bit_count, bit_count),
+              packed_a);
+
+    std::optional<PackedTernaryVector> meet =
+        packed_ternary_ops::Meet(packed_a, packed_ternary_ops::Join(packed_a,
+                                                                    packed_b));
+    EXPECT_EQ(meet, packed_a);
+  }
+}
+
+}  // namespace
+}  // namespace xls
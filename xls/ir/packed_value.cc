@@ -0,0 +1,242 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/packed_value.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/ir/value_helpers.h"
+
+namespace xls {
+namespace {
+
+constexpr int64_t kWordBits = 64;
+
+uint64_t LowMask(int64_t width) {
+  return width >= kWordBits ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+}
+
+// Returns the `width` (at most 64) bits of `bitmap` starting at `offset`.
+uint64_t ReadChunk(const InlineBitmap& bitmap, int64_t offset, int64_t width) {
+  int64_t word = offset / kWordBits;
+  int64_t shift = offset % kWordBits;
+  uint64_t result = bitmap.GetWord(word) >> shift;
+  if (shift != 0 && shift + width > kWordBits) {
+    result |= bitmap.GetWord(word + 1) << (kWordBits - shift);
+  }
+  return result & LowMask(width);
+}
+
+// Sets the `width` (at most 64) bits of `bitmap` starting at `offset` to the
+// low bits of `value`.
+void WriteChunk(InlineBitmap& bitmap, int64_t offset, int64_t width,
+                uint64_t value) {
+  int64_t word = offset / kWordBits;
+  int64_t shift = offset % kWordBits;
+  uint64_t mask = LowMask(width);
+  value &= mask;
+  bitmap.SetWord(word,
+                 (bitmap.GetWord(word) & ~(mask << shift)) | (value << shift));
+  if (shift + width > kWordBits) {
+    uint64_t high_mask = LowMask(shift + width - kWordBits);
+    bitmap.SetWord(word + 1, (bitmap.GetWord(word + 1) & ~high_mask) |
+                                 (value >> (kWordBits - shift)));
+  }
+}
+
+// Copies `count` bits of `src` starting at `src_offset` into `dst` starting at
+// `dst_offset`, a word at a time.
+void CopyBits(const InlineBitmap& src, int64_t src_offset, int64_t count,
+              InlineBitmap& dst, int64_t dst_offset) {
+  for (int64_t i = 0; i < count; i += kWordBits) {
+    int64_t width = std::min(kWordBits, count - i);
+    WriteChunk(dst, dst_offset + i, width,
+               ReadChunk(src, src_offset + i, width));
+  }
+}
+
+// Returns the offset of the i-th element within the flattened layout of the
+// given tuple or array type. Tuple element 0 occupies the most significant
+// bits while array element 0 occupies the least significant bits.
+int64_t ElementOffset(Type* type, int64_t i) {
+  if (type->IsArray()) {
+    const ArrayType* array_type = type->AsArrayOrDie();
+    XLS_CHECK_LT(i, array_type->size());
+    return i * array_type->element_type()->GetFlatBitCount();
+  }
+  const TupleType* tuple_type = type->AsTupleOrDie();
+  XLS_CHECK_LT(i, tuple_type->size());
+  int64_t offset = 0;
+  for (int64_t j = tuple_type->size() - 1; j > i; --j) {
+    offset += tuple_type->element_type(j)->GetFlatBitCount();
+  }
+  return offset;
+}
+
+Type* ElementType(Type* type, int64_t i) {
+  if (type->IsArray()) {
+    return type->AsArrayOrDie()->element_type();
+  }
+  return type->AsTupleOrDie()->element_type(i);
+}
+
+void PackInto(const Value& value, Type* type, InlineBitmap& bitmap,
+              int64_t offset) {
+  switch (value.kind()) {
+    case ValueKind::kBits: {
+      const InlineBitmap& bits = value.bits().bitmap();
+      CopyBits(bits, 0, bits.bit_count(), bitmap, offset);
+      return;
+    }
+    case ValueKind::kTuple: {
+      // Walk the elements from last (least significant) to first to avoid
+      // recomputing element offsets.
+      const TupleType* tuple_type = type->AsTupleOrDie();
+      for (int64_t i = tuple_type->size() - 1; i >= 0; --i) {
+        Type* element_type = tuple_type->element_type(i);
+        PackInto(value.element(i), element_type, bitmap, offset);
+        offset += element_type->GetFlatBitCount();
+      }
+      return;
+    }
+    case ValueKind::kArray: {
+      Type* element_type = type->AsArrayOrDie()->element_type();
+      int64_t element_bits = element_type->GetFlatBitCount();
+      for (const Value& element : value.elements()) {
+        PackInto(element, element_type, bitmap, offset);
+        offset += element_bits;
+      }
+      return;
+    }
+    case ValueKind::kToken:
+      return;
+    default:
+      XLS_LOG(FATAL) << "Invalid value kind: " << value.kind();
+  }
+}
+
+}  // namespace
+
+int64_t PackedValueView::size() const {
+  if (type_->IsArray()) {
+    return type_->AsArrayOrDie()->size();
+  }
+  return type_->AsTupleOrDie()->size();
+}
+
+PackedValueView PackedValueView::element(int64_t i) const {
+  return PackedValueView(ElementType(type_, i), bitmap_,
+                         bit_offset_ + ElementOffset(type_, i));
+}
+
+Bits PackedValueView::ToBits() const {
+  InlineBitmap result(bit_count());
+  CopyBits(*bitmap_, bit_offset_, result.bit_count(), result, 0);
+  return Bits::FromBitmap(std::move(result));
+}
+
+Value PackedValueView::ToValue() const {
+  switch (type_->kind()) {
+    case TypeKind::kBits:
+      return Value(ToBits());
+    case TypeKind::kTuple: {
+      const TupleType* tuple_type = type_->AsTupleOrDie();
+      std::vector<Value> elements(tuple_type->size());
+      int64_t offset = bit_offset_;
+      for (int64_t i = tuple_type->size() - 1; i >= 0; --i) {
+        Type* element_type = tuple_type->element_type(i);
+        elements[i] =
+            PackedValueView(element_type, bitmap_, offset).ToValue();
+        offset += element_type->GetFlatBitCount();
+      }
+      return Value::TupleOwned(std::move(elements));
+    }
+    case TypeKind::kArray: {
+      const ArrayType* array_type = type_->AsArrayOrDie();
+      Type* element_type = array_type->element_type();
+      int64_t element_bits = element_type->GetFlatBitCount();
+      std::vector<Value> elements;
+      elements.reserve(array_type->size());
+      for (int64_t i = 0; i < array_type->size(); ++i) {
+        elements.push_back(
+            PackedValueView(element_type, bitmap_,
+                            bit_offset_ + i * element_bits)
+                .ToValue());
+      }
+      return Value::ArrayOwned(std::move(elements));
+    }
+    case TypeKind::kToken:
+      return Value::Token();
+  }
+  XLS_LOG(FATAL) << "Invalid type: " << type_->ToString();
+}
+
+bool PackedValueView::operator==(const PackedValueView& other) const {
+  if (type_ != other.type_) {
+    return false;
+  }
+  int64_t count = bit_count();
+  for (int64_t i = 0; i < count; i += kWordBits) {
+    int64_t width = std::min(kWordBits, count - i);
+    if (ReadChunk(*bitmap_, bit_offset_ + i, width) !=
+        ReadChunk(*other.bitmap_, other.bit_offset_ + i, width)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* static */
+absl::StatusOr<PackedValue> PackedValue::Create(const Value& value,
+                                                Type* type) {
+  if (!ValueConformsToType(value, type)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Value %s is not of type %s", value.ToString(),
+                        type->ToString()));
+  }
+  PackedValue result(type);
+  PackInto(value, type, result.bitmap_, 0);
+  return result;
+}
+
+/* static */
+absl::StatusOr<PackedValue> PackedValue::FromBits(const Bits& bits,
+                                                  Type* type) {
+  if (bits.bit_count() != type->GetFlatBitCount()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Cannot unflatten input. Has %d bits, expected %d bits",
+                        bits.bit_count(), type->GetFlatBitCount()));
+  }
+  return PackedValue(type, bits.bitmap());
+}
+
+void PackedValue::SetElement(int64_t i, const PackedValueView& element) {
+  XLS_CHECK_EQ(element.type(), ElementType(type_, i));
+  if (element.bitmap_ != &bitmap_) {
+    CopyBits(*element.bitmap_, element.bit_offset_, element.bit_count(),
+             bitmap_, ElementOffset(type_, i));
+    return;
+  }
+  // The element is a view of this value so copy it out first in case the
+  // source and destination overlap.
+  Bits source = element.ToBits();
+  CopyBits(source.bitmap(), 0, source.bit_count(), bitmap_,
+           ElementOffset(type_, i));
+}
+
+}  // namespace xls
@@ -0,0 +1,117 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_PACKED_VALUE_H_
+#define XLS_IR_PACKED_VALUE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "xls/data_structures/inline_bitmap.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/type.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+
+// A non-owning view of a value of a particular type stored in the flattened
+// bit layout (see FlattenValueToBits) inside an InlineBitmap. Element access
+// returns views of the same storage so traversing an aggregate never
+// allocates. The underlying storage must outlive the view.
+class PackedValueView {
+ public:
+  PackedValueView(Type* type, const InlineBitmap* bitmap, int64_t bit_offset)
+      : type_(type), bitmap_(bitmap), bit_offset_(bit_offset) {}
+
+  Type* type() const { return type_; }
+  int64_t bit_count() const { return type_->GetFlatBitCount(); }
+
+  // Returns the number of elements of the tuple or array value.
+  int64_t size() const;
+
+  // Returns a view of the i-th element of the tuple or array value.
+  PackedValueView element(int64_t i) const;
+
+  // Returns the bits of the value in the flattened layout. For bits-typed
+  // values this is simply the value.
+  Bits ToBits() const;
+
+  // Returns the value as a (boxed) Value.
+  Value ToValue() const;
+
+  // Returns whether the views are of the same type and hold the same bits.
+  bool operator==(const PackedValueView& other) const;
+  bool operator!=(const PackedValueView& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  friend class PackedValue;
+
+  Type* type_;
+  const InlineBitmap* bitmap_;
+  int64_t bit_offset_;
+};
+
+// A value of a particular type stored contiguously in the flattened bit layout
+// (see FlattenValueToBits). Unlike Value, whose tuples and arrays are trees of
+// separately allocated elements, an aggregate PackedValue is a single
+// allocation (or none for values of at most 64 bits), so copying or moving it
+// is cheap regardless of its shape.
+class PackedValue {
+ public:
+  // Creates a packed value of the given type with all bits zero.
+  explicit PackedValue(Type* type)
+      : type_(type), bitmap_(type->GetFlatBitCount()) {}
+
+  // Packs the given value which must be of the given type.
+  static absl::StatusOr<PackedValue> Create(const Value& value, Type* type);
+
+  // Creates a packed value from bits in the flattened layout of the given
+  // type (as produced by FlattenValueToBits).
+  static absl::StatusOr<PackedValue> FromBits(const Bits& bits, Type* type);
+
+  Type* type() const { return type_; }
+  int64_t bit_count() const { return bitmap_.bit_count(); }
+  const InlineBitmap& bitmap() const { return bitmap_; }
+
+  PackedValueView view() const { return PackedValueView(type_, &bitmap_, 0); }
+  int64_t size() const { return view().size(); }
+  PackedValueView element(int64_t i) const { return view().element(i); }
+  Bits ToBits() const { return Bits::FromBitmap(bitmap_); }
+  Value ToValue() const { return view().ToValue(); }
+
+  // Overwrites the i-th element of the tuple or array value with the given
+  // value of the element type.
+  void SetElement(int64_t i, const PackedValueView& element);
+
+  std::string ToString() const { return ToValue().ToString(); }
+
+  bool operator==(const PackedValue& other) const {
+    return type_ == other.type_ && bitmap_ == other.bitmap_;
+  }
+  bool operator!=(const PackedValue& other) const { return !(*this == other); }
+
+ private:
+  PackedValue(Type* type, InlineBitmap bitmap)
+      : type_(type), bitmap_(std::move(bitmap)) {}
+
+  Type* type_;
+  InlineBitmap bitmap_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_IR_PACKED_VALUE_H_
@@ -0,0 +1,108 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/packed_value.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/codegen/flattening.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/bits_ops.h"
+#include "xls/ir/package.h"
+#include "xls/ir/value.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+using ::testing::HasSubstr;
+
+class PackedValueTest : public ::testing::Test {
+ protected:
+  Package package_{"packed_value_test"};
+};
+
+TEST_F(PackedValueTest, ZeroValue) {
+  Type* array_type = package_.GetArrayType(2, package_.GetBitsType(70));
+  Type* type = package_.GetTupleType({package_.GetBitsType(3), array_type});
+  PackedValue value(type);
+  EXPECT_EQ(value.type(), type);
+  EXPECT_EQ(value.bit_count(), 143);
+  Value zero_array = Value::ArrayOrDie({Value(Bits(70)), Value(Bits(70))});
+  EXPECT_EQ(value.ToValue(), Value::Tuple({Value(UBits(0, 3)), zero_array}));
+}
+
+TEST_F(PackedValueTest, RoundTripsAndMatchesFlattenedLayout) {
+  Type* element_type = package_.GetTupleType(
+      {package_.GetBitsType(7), package_.GetTokenType(),
+       package_.GetBitsType(90)});
+  Type* type = package_.GetArrayType(3, element_type);
+  auto element = [](int64_t i) {
+    Bits wide = bits_ops::Concat({UBits(i + 1, 26), UBits(0xabcdef0123, 64)});
+    return Value::Tuple({Value(UBits(i, 7)), Value::Token(), Value(wide)});
+  };
+  Value value = Value::ArrayOrDie({element(1), element(2), element(3)});
+
+  XLS_ASSERT_OK_AND_ASSIGN(PackedValue packed,
+                           PackedValue::Create(value, type));
+  EXPECT_EQ(packed.ToValue(), value);
+  EXPECT_EQ(packed.ToBits(), FlattenValueToBits(value));
+  XLS_ASSERT_OK_AND_ASSIGN(PackedValue from_bits,
+                           PackedValue::FromBits(packed.ToBits(), type));
+  EXPECT_EQ(from_bits, packed);
+
+  ASSERT_EQ(packed.size(), 3);
+  for (int64_t i = 0; i < 3; ++i) {
+    PackedValueView view = packed.element(i);
+    EXPECT_EQ(view.type(), element_type);
+    EXPECT_EQ(view.ToValue(), element(i + 1));
+    EXPECT_EQ(view.element(0).ToBits(), UBits(i + 1, 7));
+    EXPECT_EQ(view.element(2).ToValue(), element(i + 1).element(2));
+  }
+  EXPECT_EQ(packed.element(0), packed.element(0));
+  EXPECT_NE(packed.element(0), packed.element(1));
+}
+
+TEST_F(PackedValueTest, SetElement) {
+  Type* type = package_.GetArrayType(4, package_.GetBitsType(33));
+  XLS_ASSERT_OK_AND_ASSIGN(Value value, Value::UBitsArray({1, 2, 3, 4}, 33));
+  XLS_ASSERT_OK_AND_ASSIGN(PackedValue packed,
+                           PackedValue::Create(value, type));
+  XLS_ASSERT_OK_AND_ASSIGN(PackedValue element,
+                           PackedValue::Create(Value(UBits(0x1ffffffff, 33)),
+                                               package_.GetBitsType(33)));
+
+  PackedValue copy = packed;
+  copy.SetElement(1, element.view());
+  copy.SetElement(3, copy.element(0));
+  XLS_ASSERT_OK_AND_ASSIGN(Value expected,
+                           Value::UBitsArray({1, 0x1ffffffff, 3, 1}, 33));
+  EXPECT_EQ(copy.ToValue(), expected);
+  // The original is unaffected.
+  EXPECT_EQ(packed.ToValue(), value);
+}
+
+TEST_F(PackedValueTest, Errors) {
+  Type* type = package_.GetTupleType({package_.GetBitsType(8)});
+  EXPECT_THAT(PackedValue::Create(Value(UBits(0, 8)), type),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("is not of type (bits[8])")));
+  EXPECT_THAT(PackedValue::FromBits(UBits(0, 9), type),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Has 9 bits, expected 8 bits")));
+}
+
+}  // namespace
+}  // namespace xls
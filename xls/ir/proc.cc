@@ -81,7 +81,9 @@ absl::Status Proc::SetNextToken(Node* next) {
         "Cannot set next token to \"%s\", expected token type but has type %s",
         next->GetName(), next->GetType()->ToString()));
   }
+  SaveStateForUndo();
   next_token_ = next;
+  MarkStructureChanged();
   return absl::OkStatus();
 }
 
@@ -115,6 +117,7 @@ absl::Status Proc::SetNextStateElement(int64_t index, Node* next) {
         index, next->GetName(), next->GetType()->ToString(),
         GetStateElementType(index)->ToString()));
   }
+  SaveStateForUndo();
   next_state_[index] = next;
   return absl::OkStatus();
 }
@@ -173,6 +176,7 @@ absl::StatusOr<Param*> Proc::ReplaceStateElement(
 
 absl::Status Proc::RemoveStateElement(int64_t index) {
   XLS_RET_CHECK_LT(index, GetStateElementCount());
+  SaveStateForUndo();
   next_state_.erase(next_state_.begin() + index);
   if (!StateParams()[index]->users().empty()) {
     return absl::InvalidArgumentError(
@@ -197,6 +201,7 @@ absl::StatusOr<Param*> Proc::InsertStateElement(
     int64_t index, std::string_view state_param_name, const Value& init_value,
     std::optional<Node*> next_state) {
   XLS_RET_CHECK_LE(index, GetStateElementCount());
+  SaveStateForUndo();
   XLS_ASSIGN_OR_RETURN(
       Param * param,
       MakeNodeWithName<Param>(SourceInfo(), state_param_name,
@@ -150,6 +150,8 @@ class Proc : public FunctionBase {
   std::string DumpIr() const override;
 
  private:
+  friend class PackageSnapshot;
+
   std::vector<Value> init_values_;
 
   // The nodes representing the token/state values for the next iteration of the
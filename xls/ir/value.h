@@ -15,6 +15,10 @@
 #ifndef XLS_IR_VALUE_H_
 #define XLS_IR_VALUE_H_
 
+#include <utility>
+#include <variant>
+#include <vector>
+
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "absl/types/variant.h"
@@ -156,6 +160,19 @@ class Value {
   bool operator==(const Value& other) const;
   bool operator!=(const Value& other) const { return !(*this == other); }
 
+  template <typename H>
+  friend H AbslHashValue(H h, const Value& value) {
+    h = H::combine(std::move(h), value.kind_);
+    if (value.IsBits()) {
+      return H::combine(std::move(h), value.bits());
+    }
+    if (std::holds_alternative<std::vector<Value>>(value.payload_)) {
+      return H::combine(std::move(h),
+                        std::get<std::vector<Value>>(value.payload_));
+    }
+    return h;
+  }
+
  private:
   Value(ValueKind kind, absl::Span<const Value> elements)
       : kind_(kind),
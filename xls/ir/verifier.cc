@@ -1672,6 +1672,136 @@ absl::Status VerifyChannels(Package* package, bool codegen) {
   return absl::OkStatus();
 }
 
+
+// Verifies function, proc, and block names are unique among
+// functions/procs/blocks of the package.
+absl::Status VerifyFunctionBaseNamesUnique(Package* package) {
+  absl::flat_hash_set<FunctionBase*> function_bases;
+  absl::flat_hash_set<std::string> function_names;
+  absl::flat_hash_set<std::string> proc_names;
+  absl::flat_hash_set<std::string> block_names;
+  for (FunctionBase* function_base : package->GetFunctionBases()) {
+    absl::flat_hash_set<std::string>* name_set;
+    if (function_base->IsFunction()) {
+      name_set = &function_names;
+    } else if (function_base->IsProc()) {
+      name_set = &proc_names;
+    } else {
+      XLS_RET_CHECK(function_base->IsBlock());
+      name_set = &block_names;
+    }
+    XLS_RET_CHECK(!name_set->contains(function_base->name()))
+        << "Function/proc/block with name " << function_base->name()
+        << " is not unique within package " << package->name();
+    name_set->insert(function_base->name());
+
+    XLS_RET_CHECK(!function_bases.contains(function_base))
+        << "Function or proc with name " << function_base->name()
+        << " appears more than once in within package" << package->name();
+    function_bases.insert(function_base);
+  }
+  return absl::OkStatus();
+}
+
+// Verifies the parameters, state elements, and next token of the given proc
+// are consistent.
+absl::Status VerifyProcState(Proc* proc) {
+  // A Proc has a single token parameter and zero or more state paramers.
+  XLS_RET_CHECK_EQ(proc->params().size(), proc->GetStateElementCount() + 1);
+
+  XLS_RET_CHECK_EQ(proc->param(0), proc->TokenParam());
+  XLS_RET_CHECK_EQ(proc->param(0)->GetType(), proc->package()->GetTokenType())
+      << absl::StreamFormat("Parameter 0 of a proc %s is not token type, is %s",
+                            proc->name(),
+                            proc->param(1)->GetType()->ToString());
+
+  XLS_RET_CHECK_EQ(proc->GetStateElementCount(), proc->InitValues().size());
+  XLS_RET_CHECK_EQ(proc->GetStateElementCount(), proc->NextState().size());
+  for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+    // Verify that the order of parameters matches the state element order.
+    XLS_RET_CHECK_EQ(proc->param(i + 1), proc->GetStateParam(i));
+
+    // Verify type of state param matches type of the corresponding initial
+    // value and next state element.
+    XLS_RET_CHECK_EQ(proc->GetStateParam(i)->GetType(),
+                     proc->GetNextStateElement(i)->GetType())
+        << absl::StreamFormat(
+               "State parameter %d of proc %s does not match next state type "
+               "%s, is %s",
+               i, proc->name(),
+               proc->GetNextStateElement(i)->GetType()->ToString(),
+               proc->GetStateParam(i)->GetType()->ToString());
+
+    XLS_RET_CHECK(ValueConformsToType(proc->GetInitValueElement(i),
+                                      proc->GetStateParam(i)->GetType()));
+  }
+
+  // Next token must be token type.
+  XLS_RET_CHECK(proc->NextToken()->GetType()->IsToken());
+
+  return absl::OkStatus();
+}
+
+// Verifies that there are no cycles in the node graph passing through a node
+// whose operands changed since the last checkpoint. Any cycle introduced by
+// the recorded changes passes through such a node, so only the operand cones
+// of these nodes need to be searched.
+absl::Status VerifyNoCyclesThroughChangedNodes(FunctionBase* function_base) {
+  // Maps each visited node to whether it is on the DFS stack.
+  absl::flat_hash_map<Node*, bool> on_stack;
+  // DFS stack holding nodes and the index of the next operand to visit.
+  std::vector<std::pair<Node*, int64_t>> stack;
+  for (const FunctionBase::NodeChange& change : function_base->node_changes()) {
+    if (!change.operands_changed || on_stack.contains(change.node)) {
+      continue;
+    }
+    on_stack[change.node] = true;
+    stack.push_back({change.node, 0});
+    while (!stack.empty()) {
+      Node* node = stack.back().first;
+      int64_t operand_no = stack.back().second++;
+      if (operand_no == node->operand_count()) {
+        on_stack[node] = false;
+        stack.pop_back();
+        continue;
+      }
+      Node* operand = node->operand(operand_no);
+      auto [it, inserted] = on_stack.insert({operand, true});
+      if (inserted) {
+        stack.push_back({operand, 0});
+      } else if (it->second) {
+        std::vector<std::string> cycle_names;
+        auto cycle_start = absl::c_find_if(
+            stack, [&](const auto& entry) { return entry.first == operand; });
+        for (auto entry = cycle_start; entry != stack.end(); ++entry) {
+          cycle_names.push_back(entry->first->GetName());
+        }
+        cycle_names.push_back(operand->GetName());
+        return absl::InternalError(absl::StrFormat(
+            "Cycle detected: [%s]", absl::StrJoin(cycle_names, " -> ")));
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Returns the function called by the given node, or nullptr if the node does
+// not call a function.
+Function* GetCalledFunction(Node* node) {
+  switch (node->op()) {
+    case Op::kInvoke:
+      return node->As<Invoke>()->to_apply();
+    case Op::kMap:
+      return node->As<Map>()->to_apply();
+    case Op::kCountedFor:
+      return node->As<CountedFor>()->body();
+    case Op::kDynamicCountedFor:
+      return node->As<DynamicCountedFor>()->body();
+    default:
+      return nullptr;
+  }
+}
+
 }  // namespace
 
 absl::Status VerifyPackage(Package* package, bool codegen) {
@@ -1710,31 +1840,7 @@ absl::Status VerifyPackage(Package* package, bool codegen) {
   }
   XLS_RET_CHECK_GT(package->next_node_id(), max_id_seen);
 
-  // Verify function, proc, block names are unique among functions/procs/blocks.
-  absl::flat_hash_set<FunctionBase*> function_bases;
-  absl::flat_hash_set<std::string> function_names;
-  absl::flat_hash_set<std::string> proc_names;
-  absl::flat_hash_set<std::string> block_names;
-  for (FunctionBase* function_base : package->GetFunctionBases()) {
-    absl::flat_hash_set<std::string>* name_set;
-    if (function_base->IsFunction()) {
-      name_set = &function_names;
-    } else if (function_base->IsProc()) {
-      name_set = &proc_names;
-    } else {
-      XLS_RET_CHECK(function_base->IsBlock());
-      name_set = &block_names;
-    }
-    XLS_RET_CHECK(!name_set->contains(function_base->name()))
-        << "Function/proc/block with name " << function_base->name()
-        << " is not unique within package " << package->name();
-    name_set->insert(function_base->name());
-
-    XLS_RET_CHECK(!function_bases.contains(function_base))
-        << "Function or proc with name " << function_base->name()
-        << " appears more than once in within package" << package->name();
-    function_bases.insert(function_base);
-  }
+  XLS_RETURN_IF_ERROR(VerifyFunctionBaseNamesUnique(package));
 
   XLS_RETURN_IF_ERROR(VerifyChannels(package, codegen));
 
@@ -1769,38 +1875,7 @@ absl::Status VerifyProc(Proc* proc, bool codegen) {
 
   XLS_RETURN_IF_ERROR(VerifyFunctionBase(proc));
 
-  // A Proc has a single token parameter and zero or more state paramers.
-  XLS_RET_CHECK_EQ(proc->params().size(), proc->GetStateElementCount() + 1);
-
-  XLS_RET_CHECK_EQ(proc->param(0), proc->TokenParam());
-  XLS_RET_CHECK_EQ(proc->param(0)->GetType(), proc->package()->GetTokenType())
-      << absl::StreamFormat("Parameter 0 of a proc %s is not token type, is %s",
-                            proc->name(),
-                            proc->param(1)->GetType()->ToString());
-
-  XLS_RET_CHECK_EQ(proc->GetStateElementCount(), proc->InitValues().size());
-  XLS_RET_CHECK_EQ(proc->GetStateElementCount(), proc->NextState().size());
-  for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
-    // Verify that the order of parameters matches the state element order.
-    XLS_RET_CHECK_EQ(proc->param(i + 1), proc->GetStateParam(i));
-
-    // Verify type of state param matches type of the corresponding initial
-    // value and next state element.
-    XLS_RET_CHECK_EQ(proc->GetStateParam(i)->GetType(),
-                     proc->GetNextStateElement(i)->GetType())
-        << absl::StreamFormat(
-               "State parameter %d of proc %s does not match next state type "
-               "%s, is %s",
-               i, proc->name(),
-               proc->GetNextStateElement(i)->GetType()->ToString(),
-               proc->GetStateParam(i)->GetType()->ToString());
-
-    XLS_RET_CHECK(ValueConformsToType(proc->GetInitValueElement(i),
-                                      proc->GetStateParam(i)->GetType()));
-  }
-
-  // Next token must be token type.
-  XLS_RET_CHECK(proc->NextToken()->GetType()->IsToken());
+  XLS_RETURN_IF_ERROR(VerifyProcState(proc));
 
   // Verify that all side-effecting operations which produce tokens are
   // connected to the token parameter and the return value via paths of tokens.
@@ -2032,4 +2107,90 @@ absl::Status VerifyNode(Node* node, bool codegen) {
   return node->VisitSingleNode(&node_checker);
 }
 
+// Verifies the changes recorded in the given function base without clearing
+// them.
+static absl::Status VerifyRecordedChanges(FunctionBase* function_base,
+                                          bool codegen) {
+  if (function_base->structure_changed()) {
+    if (function_base->IsFunction()) {
+      return VerifyFunction(function_base->AsFunctionOrDie(), codegen);
+    }
+    if (function_base->IsProc()) {
+      return VerifyProc(function_base->AsProcOrDie(), codegen);
+    }
+    return VerifyBlock(function_base->AsBlockOrDie(), codegen);
+  }
+
+  XLS_VLOG(2) << absl::StreamFormat(
+      "Verifying %d changed nodes of function %s:",
+      function_base->node_changes().size(), function_base->name());
+  Package* package = function_base->package();
+  for (const FunctionBase::NodeChange& change :
+       function_base->node_changes()) {
+    Node* node = change.node;
+    XLS_RET_CHECK(package->IsOwnedType(node->GetType()));
+    XLS_RET_CHECK(node->package() == package);
+    XLS_RET_CHECK_LT(node->id(), package->next_node_id());
+    XLS_RETURN_IF_ERROR(VerifyNode(node, codegen));
+  }
+  XLS_RETURN_IF_ERROR(VerifyNoCyclesThroughChangedNodes(function_base));
+  if (function_base->IsProc()) {
+    XLS_RETURN_IF_ERROR(VerifyProcState(function_base->AsProcOrDie()));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status VerifyChangedNodes(FunctionBase* function_base, bool codegen) {
+  XLS_RETURN_IF_ERROR(VerifyRecordedChanges(function_base, codegen));
+  function_base->ClearChanges();
+  return absl::OkStatus();
+}
+
+absl::Status VerifyChangedNodes(Package* package, bool codegen) {
+  std::vector<FunctionBase*> function_bases = package->GetFunctionBases();
+  absl::flat_hash_set<FunctionBase*> structure_changed;
+  for (FunctionBase* function_base : function_bases) {
+    XLS_RET_CHECK(function_base->package() == package);
+    if (function_base->structure_changed()) {
+      structure_changed.insert(function_base);
+    }
+    XLS_RETURN_IF_ERROR(VerifyRecordedChanges(function_base, codegen));
+  }
+
+  if (!structure_changed.empty()) {
+    // Recheck the uses of function bases whose signature or ports may have
+    // changed from function bases which were not verified in full.
+    for (FunctionBase* function_base : function_bases) {
+      if (structure_changed.contains(function_base)) {
+        continue;
+      }
+      for (Node* node : function_base->nodes()) {
+        Function* callee = GetCalledFunction(node);
+        if (callee != nullptr && structure_changed.contains(callee)) {
+          XLS_RETURN_IF_ERROR(VerifyNode(node));
+        }
+      }
+      if (function_base->IsBlock()) {
+        Block* block = function_base->AsBlockOrDie();
+        for (Instantiation* instantiation : block->GetInstantiations()) {
+          if (instantiation->kind() == InstantiationKind::kBlock &&
+              structure_changed.contains(
+                  down_cast<BlockInstantiation*>(instantiation)
+                      ->instantiated_block())) {
+            XLS_RETURN_IF_ERROR(VerifyBlockInstantiation(
+                down_cast<BlockInstantiation*>(instantiation), block));
+          }
+        }
+      }
+    }
+    XLS_RETURN_IF_ERROR(VerifyFunctionBaseNamesUnique(package));
+    XLS_RETURN_IF_ERROR(VerifyChannels(package, codegen));
+  }
+
+  for (FunctionBase* function_base : function_bases) {
+    function_base->ClearChanges();
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace xls
@@ -20,6 +20,7 @@
 namespace xls {
 
 class Node;
+class FunctionBase;
 class Function;
 class Proc;
 class Block;
@@ -33,6 +34,18 @@ absl::Status VerifyProc(Proc* Proc, bool codegen = false);
 absl::Status VerifyBlock(Block* Block, bool codegen = false);
 absl::Status VerifyNode(Node* Node, bool codegen = false);
 
+// Incrementally verifies the changes recorded since the last checkpoint (see
+// FunctionBase::node_changes). Only the changed nodes are checked unless a
+// change affects invariants of the function base as a whole (see
+// FunctionBase::structure_changed), in which case the function base is
+// verified in full along with the package-level invariants which depend on
+// it. Invariants which no recorded change can affect, such as uniqueness of
+// node ids across the package, are left to VerifyPackage. Clears the recorded
+// changes on success.
+absl::Status VerifyChangedNodes(Package* package, bool codegen = false);
+absl::Status VerifyChangedNodes(FunctionBase* function_base,
+                                bool codegen = false);
+
 }  // namespace xls
 
 #endif  // XLS_IR_VERIFIER_H_
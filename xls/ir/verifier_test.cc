@@ -550,5 +550,114 @@ block my_block(a: bits[32], b: bits[32], out: bits[32]) {
   XLS_ASSERT_OK(VerifyBlock(FindBlock("my_block", p.get())));
 }
 
+TEST_F(VerifierTest, ChangedNodesAreRecorded) {
+  std::string input = R"(
+package ChangedNodes
+
+fn graph(p: bits[42], q: bits[42]) -> bits[42] {
+  and.1: bits[42] = and(p, q)
+  add.2: bits[42] = add(and.1, q)
+  ret sub.3: bits[42] = sub(add.2, add.2)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackageNoVerify(input));
+  Function* f = FindFunction("graph", p.get());
+  EXPECT_TRUE(f->structure_changed());
+  XLS_ASSERT_OK(VerifyChangedNodes(p.get()));
+  EXPECT_FALSE(f->structure_changed());
+  EXPECT_TRUE(f->node_changes().empty());
+
+  auto changed_nodes = [&]() {
+    std::vector<Node*> nodes;
+    for (const FunctionBase::NodeChange& change : f->node_changes()) {
+      nodes.push_back(change.node);
+    }
+    return nodes;
+  };
+
+  // Adding a node records the node and its operands (which gained a user).
+  Node* and1 = FindNode("and.1", f);
+  Node* q = FindNode("q", f);
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * neg, f->MakeNode<UnOp>(SourceInfo(), and1, Op::kNeg));
+  EXPECT_THAT(changed_nodes(), ::testing::UnorderedElementsAre(neg, and1));
+
+  // Replacing an operand records the user and both the old and new operand.
+  Node* add2 = FindNode("add.2", f);
+  XLS_ASSERT_OK(add2->ReplaceOperandNumber(1, neg));
+  EXPECT_THAT(changed_nodes(),
+              ::testing::UnorderedElementsAre(neg, and1, add2, q));
+  EXPECT_FALSE(f->structure_changed());
+  XLS_ASSERT_OK(VerifyChangedNodes(p.get()));
+  EXPECT_TRUE(f->node_changes().empty());
+
+  // Removed nodes are dropped from the changed nodes.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * not_node, f->MakeNode<UnOp>(SourceInfo(), q, Op::kNot));
+  XLS_ASSERT_OK(f->RemoveNode(not_node));
+  EXPECT_THAT(changed_nodes(), ::testing::UnorderedElementsAre(q));
+
+  // Adding a parameter changes the signature of the function.
+  XLS_ASSERT_OK(
+      f->MakeNodeWithName<Param>(SourceInfo(), "r", p->GetBitsType(8))
+          .status());
+  EXPECT_TRUE(f->structure_changed());
+  XLS_ASSERT_OK(VerifyChangedNodes(p.get()));
+  EXPECT_FALSE(f->structure_changed());
+}
+
+TEST_F(VerifierTest, ChangedNodesCycle) {
+  std::string input = R"(
+package ChangedNodesCycle
+
+fn graph(p: bits[42], q: bits[42]) -> bits[42] {
+  and.1: bits[42] = and(p, q)
+  add.2: bits[42] = add(and.1, q)
+  ret sub.3: bits[42] = sub(add.2, add.2)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackageNoVerify(input));
+  Function* f = FindFunction("graph", p.get());
+  XLS_ASSERT_OK(VerifyChangedNodes(p.get()));
+
+  XLS_ASSERT_OK(
+      FindNode("and.1", f)->ReplaceOperandNumber(0, FindNode("sub.3", f)));
+  EXPECT_THAT(VerifyChangedNodes(f),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("Cycle detected: [and.1 -> sub.3 -> add.2 "
+                                 "-> and.1]")));
+  EXPECT_FALSE(f->node_changes().empty());
+}
+
+TEST_F(VerifierTest, ChangedNodesCallee) {
+  std::string input = R"(
+package ChangedNodesCallee
+
+fn callee(x: bits[8]) -> bits[8] {
+  ret neg.1: bits[8] = neg(x)
+}
+
+fn caller(y: bits[8]) -> bits[8] {
+  ret invoke.2: bits[8] = invoke(y, to_apply=callee)
+}
+)";
+  XLS_ASSERT_OK_AND_ASSIGN(auto p, ParsePackageNoVerify(input));
+  Function* callee = FindFunction("callee", p.get());
+  XLS_ASSERT_OK(VerifyChangedNodes(p.get()));
+
+  // Changing the signature of the callee invalidates the invoke in the
+  // (otherwise unchanged) caller.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * wide, callee->MakeNode<ExtendOp>(SourceInfo(),
+                                               FindNode("neg.1", callee),
+                                               /*new_bit_count=*/16,
+                                               Op::kZeroExt));
+  XLS_ASSERT_OK(callee->set_return_value(wide));
+  EXPECT_TRUE(callee->structure_changed());
+  EXPECT_THAT(VerifyChangedNodes(p.get()),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("invoke.2")));
+}
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,240 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/ir/word_arithmetic.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/numeric/int128.h"
+#include "xls/common/logging/logging.h"
+
+namespace xls {
+namespace word_arithmetic {
+
+uint64_t AddInto(uint64_t* r, int64_t r_count, const uint64_t* a,
+                 int64_t a_count) {
+  uint64_t carry = 0;
+  for (int64_t i = 0; i < r_count && (i < a_count || carry != 0); ++i) {
+    absl::uint128 sum =
+        absl::uint128{r[i]} + (i < a_count ? a[i] : 0) + carry;
+    r[i] = absl::Uint128Low64(sum);
+    carry = absl::Uint128High64(sum);
+  }
+  return carry;
+}
+
+uint64_t SubtractFrom(uint64_t* r, int64_t r_count, const uint64_t* a,
+                      int64_t a_count) {
+  uint64_t borrow = 0;
+  for (int64_t i = 0; i < r_count && (i < a_count || borrow != 0); ++i) {
+    absl::uint128 difference =
+        absl::uint128{r[i]} - (i < a_count ? a[i] : 0) - borrow;
+    r[i] = absl::Uint128Low64(difference);
+    borrow = absl::Uint128High64(difference) != 0 ? 1 : 0;
+  }
+  return borrow;
+}
+
+void Negate(uint64_t* r, int64_t count) {
+  uint64_t carry = 1;
+  for (int64_t i = 0; i < count; ++i) {
+    absl::uint128 sum = absl::uint128{~r[i]} + carry;
+    r[i] = absl::Uint128Low64(sum);
+    carry = absl::Uint128High64(sum);
+  }
+}
+
+int64_t SignificantWordCount(const uint64_t* a, int64_t count) {
+  while (count > 0 && a[count - 1] == 0) {
+    --count;
+  }
+  return count;
+}
+
+void SchoolbookMul(const uint64_t* a, int64_t a_count, const uint64_t* b,
+                   int64_t b_count, uint64_t* r) {
+  std::fill(r, r + a_count + b_count, 0);
+  for (int64_t i = 0; i < a_count; ++i) {
+    if (a[i] == 0) {
+      continue;
+    }
+    uint64_t carry = 0;
+    for (int64_t j = 0; j < b_count; ++j) {
+      absl::uint128 t = absl::uint128{a[i]} * b[j] + r[i + j] + carry;
+      r[i + j] = absl::Uint128Low64(t);
+      carry = absl::Uint128High64(t);
+    }
+    r[i + b_count] = carry;
+  }
+}
+
+void KaratsubaMul(const uint64_t* a, const uint64_t* b, int64_t count,
+                  uint64_t* r) {
+  if (count < kKaratsubaMinWordCount) {
+    SchoolbookMul(a, count, b, count, r);
+    return;
+  }
+  // Split the operands into low halves of `low` words and high halves of
+  // `high` words:
+  //
+  //   a * b = z0 + (z1 - z0 - z2) * B^low + z2 * B^(2 * low)
+  //
+  // where z0 = a0 * b0, z2 = a1 * b1 and z1 = (a0 + a1) * (b0 + b1).
+  int64_t low = count / 2;
+  int64_t high = count - low;
+  std::vector<uint64_t> z0(2 * low);
+  std::vector<uint64_t> z2(2 * high);
+  KaratsubaMul(a, b, low, z0.data());
+  KaratsubaMul(a + low, b + low, high, z2.data());
+
+  std::vector<uint64_t> a_sum(a + low, a + count);
+  std::vector<uint64_t> b_sum(b + low, b + count);
+  a_sum.push_back(AddInto(a_sum.data(), high, a, low));
+  b_sum.push_back(AddInto(b_sum.data(), high, b, low));
+  std::vector<uint64_t> z1(2 * (high + 1));
+  KaratsubaMul(a_sum.data(), b_sum.data(), high + 1, z1.data());
+  SubtractFrom(z1.data(), z1.size(), z0.data(), z0.size());
+  SubtractFrom(z1.data(), z1.size(), z2.data(), z2.size());
+
+  std::copy(z0.begin(), z0.end(), r);
+  std::copy(z2.begin(), z2.end(), r + 2 * low);
+  // The middle term is less than B^(2 * high + 1) so its top word is zero.
+  AddInto(r + low, 2 * count - low, z1.data(), 2 * high + 1);
+}
+
+void TruncatedMul(const uint64_t* a, const uint64_t* b, int64_t count,
+                  uint64_t* r) {
+  if (count < kKaratsubaMinWordCount) {
+    std::fill(r, r + count, 0);
+    for (int64_t i = 0; i < count; ++i) {
+      if (a[i] == 0) {
+        continue;
+      }
+      uint64_t carry = 0;
+      for (int64_t j = 0; i + j < count; ++j) {
+        absl::uint128 t = absl::uint128{a[i]} * b[j] + r[i + j] + carry;
+        r[i + j] = absl::Uint128Low64(t);
+        carry = absl::Uint128High64(t);
+      }
+    }
+    return;
+  }
+  // With low halves of `low` >= count / 2 words, the product of the high
+  // halves is shifted entirely out of the result and only the low `high` words
+  // of the cross terms contribute:
+  //
+  //   a * b mod B^count = a0 * b0 + (a0 * b1 + a1 * b0 mod B^high) * B^low
+  int64_t high = count / 2;
+  int64_t low = count - high;
+  std::vector<uint64_t> z0(2 * low);
+  KaratsubaMul(a, b, low, z0.data());
+  std::copy(z0.begin(), z0.begin() + count, r);
+  std::vector<uint64_t> cross(high);
+  TruncatedMul(a, b + low, high, cross.data());
+  AddInto(r + low, high, cross.data(), high);
+  TruncatedMul(a + low, b, high, cross.data());
+  AddInto(r + low, high, cross.data(), high);
+}
+
+void DivMod(const uint64_t* dividend, int64_t dividend_count,
+            const uint64_t* divisor, int64_t divisor_count, uint64_t* quotient,
+            uint64_t* remainder) {
+  std::fill(quotient, quotient + dividend_count, 0);
+  std::fill(remainder, remainder + divisor_count, 0);
+  int64_t n = SignificantWordCount(divisor, divisor_count);
+  int64_t m = SignificantWordCount(dividend, dividend_count);
+  XLS_CHECK_GT(n, 0) << "Division by zero";
+  if (m < n) {
+    std::copy(dividend, dividend + m, remainder);
+    return;
+  }
+  if (n == 1) {
+    absl::uint128 rem = 0;
+    for (int64_t i = m - 1; i >= 0; --i) {
+      absl::uint128 current =
+          absl::MakeUint128(absl::Uint128Low64(rem), dividend[i]);
+      quotient[i] = absl::Uint128Low64(current / divisor[0]);
+      rem = current % divisor[0];
+    }
+    remainder[0] = absl::Uint128Low64(rem);
+    return;
+  }
+
+  // Knuth's Algorithm D (TAOCP Vol. 2, 4.3.1). Normalize so the most
+  // significant word of the divisor has its high bit set.
+  int shift = absl::countl_zero(divisor[n - 1]);
+  auto shifted_word = [shift](const uint64_t* a, int64_t i) {
+    uint64_t lo = i > 0 && shift != 0 ? a[i - 1] >> (64 - shift) : 0;
+    return (a[i] << shift) | lo;
+  };
+  std::vector<uint64_t> v(n);
+  for (int64_t i = 0; i < n; ++i) {
+    v[i] = shifted_word(divisor, i);
+  }
+  std::vector<uint64_t> u(m + 1);
+  for (int64_t i = 0; i < m; ++i) {
+    u[i] = shifted_word(dividend, i);
+  }
+  u[m] = shift == 0 ? 0 : dividend[m - 1] >> (64 - shift);
+
+  for (int64_t j = m - n; j >= 0; --j) {
+    // Estimate the quotient word from the top two words of the partial
+    // remainder; the estimate is at most one too large after the correction
+    // loop.
+    absl::uint128 numerator = absl::MakeUint128(u[j + n], u[j + n - 1]);
+    absl::uint128 qhat = numerator / v[n - 1];
+    absl::uint128 rhat = numerator % v[n - 1];
+    while (absl::Uint128High64(qhat) != 0 ||
+           qhat * v[n - 2] >
+               absl::MakeUint128(absl::Uint128Low64(rhat), u[j + n - 2])) {
+      --qhat;
+      rhat += v[n - 1];
+      if (absl::Uint128High64(rhat) != 0) {
+        break;
+      }
+    }
+
+    // Multiply and subtract.
+    uint64_t carry = 0;
+    uint64_t borrow = 0;
+    for (int64_t i = 0; i < n; ++i) {
+      absl::uint128 product = qhat * v[i] + carry;
+      carry = absl::Uint128High64(product);
+      absl::uint128 difference = absl::uint128{u[i + j]} -
+                                 absl::Uint128Low64(product) - borrow;
+      u[i + j] = absl::Uint128Low64(difference);
+      borrow = absl::Uint128High64(difference) != 0 ? 1 : 0;
+    }
+    absl::uint128 difference = absl::uint128{u[j + n]} - carry - borrow;
+    u[j + n] = absl::Uint128Low64(difference);
+    quotient[j] = absl::Uint128Low64(qhat);
+
+    if (absl::Uint128High64(difference) != 0) {
+      // The estimate was one too large. Add back the divisor.
+      --quotient[j];
+      u[j + n] += AddInto(&u[j], n, v.data(), n);
+    }
+  }
+
+  // Unnormalize the remainder.
+  for (int64_t i = 0; i < n; ++i) {
+    uint64_t hi = shift == 0 ? 0 : u[i + 1] << (64 - shift);
+    remainder[i] = (u[i] >> shift) | hi;
+  }
+}
+
+}  // namespace word_arithmetic
+}  // namespace xls
@@ -0,0 +1,72 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_IR_WORD_ARITHMETIC_H_
+#define XLS_IR_WORD_ARITHMETIC_H_
+
+#include <cstdint>
+
+// Kernels for unsigned arithmetic on wide values held as arrays of 64-bit
+// words in little-endian word order. Used by bits_ops and by the JIT's
+// runtime support for wide operations. Unless noted otherwise, output buffers
+// may not alias the inputs.
+namespace xls {
+namespace word_arithmetic {
+
+// Operands with at least this many words are multiplied with Karatsuba's
+// algorithm rather than the schoolbook algorithm.
+inline constexpr int64_t kKaratsubaMinWordCount = 32;
+
+// Adds the `a_count` words of `a` into the `r_count` words of `r` (`a_count`
+// <= `r_count`). Returns the carry out of the most significant word.
+uint64_t AddInto(uint64_t* r, int64_t r_count, const uint64_t* a,
+                 int64_t a_count);
+
+// Subtracts the `a_count` words of `a` from the `r_count` words of `r`
+// (`a_count` <= `r_count`). Returns the borrow out of the most significant
+// word.
+uint64_t SubtractFrom(uint64_t* r, int64_t r_count, const uint64_t* a,
+                      int64_t a_count);
+
+// Negates the `count` words of `r` in place (modulo 2^(64 * count)).
+void Negate(uint64_t* r, int64_t count);
+
+// Returns the number of significant words in the `count` words of `a`.
+int64_t SignificantWordCount(const uint64_t* a, int64_t count);
+
+// Sets the `a_count + b_count` words of `r` to the product of `a` and `b`.
+void SchoolbookMul(const uint64_t* a, int64_t a_count, const uint64_t* b,
+                   int64_t b_count, uint64_t* r);
+
+// Sets the `2 * count` words of `r` to the product of the `count` words of `a`
+// and `b`.
+void KaratsubaMul(const uint64_t* a, const uint64_t* b, int64_t count,
+                  uint64_t* r);
+
+// Sets the `count` words of `r` to the product of the `count` words of `a` and
+// `b` truncated to `count` words.
+void TruncatedMul(const uint64_t* a, const uint64_t* b, int64_t count,
+                  uint64_t* r);
+
+// Divides the `dividend_count` words of `dividend` by the `divisor_count` words
+// of `divisor`, which must be non-zero. Sets the `dividend_count` words of
+// `quotient` and the `divisor_count` words of `remainder`.
+void DivMod(const uint64_t* dividend, int64_t dividend_count,
+            const uint64_t* divisor, int64_t divisor_count, uint64_t* quotient,
+            uint64_t* remainder);
+
+}  // namespace word_arithmetic
+}  // namespace xls
+
+#endif  // XLS_IR_WORD_ARITHMETIC_H_
@@ -15,11 +15,23 @@
 // Driver for the XLS AOT compilation process.
 // Uses the JIT to produce and object file, creates a header file and source to
 // wrap (i.e., simplify) execution of the generated code, and writes the trio to
-// disk.
+// disk. The top may be a function or a proc. Procs are wrapped in a class
+// deriving from xls::aot_compile::AotProc which owns the proc state and the
+// channel queues.
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/flags/flag.h"
 #include "absl/status/status.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
@@ -28,17 +40,22 @@
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/channel.h"
 #include "xls/ir/function.h"
 #include "xls/ir/ir_parser.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/proc.h"
 #include "xls/jit/function_jit.h"
 #include "xls/jit/llvm_type_converter.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/proc_jit.h"
 
 ABSL_FLAG(std::string, input, "", "Path to the IR to compile.");
 ABSL_FLAG(std::string, top, "",
-          "IR function to compile. "
-          "If unspecified, the package top function will be used - "
+          "IR function or proc to compile. "
+          "If unspecified, the package top will be used - "
           "in that case, the package-scoping mangling will be removed.");
 ABSL_FLAG(std::string, namespaces, "",
           "Comma-separated list of namespaces into which to place the "
@@ -249,6 +266,294 @@ absl::StatusOr<::xls::Value> {{wrapper_fn_name}}({{wrapper_params}}) {
   return absl::StrReplaceAll(kTemplate, substitution_map);
 }
 
+// Returns the open/close namespace substitutions for the given namespaces.
+void AddNamespaceSubstitutions(
+    const std::vector<std::string>& namespaces,
+    absl::flat_hash_map<std::string, std::string>& substitution_map) {
+  if (namespaces.empty()) {
+    substitution_map["{{open_ns}}"] = "";
+    substitution_map["{{close_ns}}"] = "";
+  } else {
+    substitution_map["{{open_ns}}"] =
+        absl::StrFormat("namespace %s {", absl::StrJoin(namespaces, "::"));
+    substitution_map["{{close_ns}}"] =
+        absl::StrFormat("}  // namespace %s", absl::StrJoin(namespaces, "::"));
+  }
+}
+
+// Returns the name of the class wrapping `proc`: the proc name with the
+// package prefix removed converted to CamelCase, e.g., `__pkg__my_proc`
+// becomes `MyProc`.
+std::string ProcClassName(Proc* proc) {
+  std::string package_prefix =
+      absl::StrCat("__", proc->package()->name(), "__");
+  std::string name;
+  bool capitalize = true;
+  for (char c : absl::StripPrefix(proc->name(), package_prefix)) {
+    if (c == '_') {
+      capitalize = true;
+      continue;
+    }
+    name.push_back(capitalize ? absl::ascii_toupper(c) : c);
+    capitalize = false;
+  }
+  return name;
+}
+
+// Returns the channels used by `proc` ordered by channel id.
+absl::StatusOr<std::vector<Channel*>> GetProcChannels(Proc* proc) {
+  std::vector<Channel*> channels;
+  absl::flat_hash_set<int64_t> seen;
+  for (Node* node : proc->nodes()) {
+    std::optional<int64_t> channel_id;
+    if (node->Is<Send>()) {
+      channel_id = node->As<Send>()->channel_id();
+    } else if (node->Is<Receive>()) {
+      channel_id = node->As<Receive>()->channel_id();
+    }
+    if (channel_id.has_value() && seen.insert(*channel_id).second) {
+      XLS_ASSIGN_OR_RETURN(Channel * channel,
+                           proc->package()->GetChannel(*channel_id));
+      channels.push_back(channel);
+    }
+  }
+  std::sort(channels.begin(), channels.end(),
+            [](Channel* a, Channel* b) { return a->id() < b->id(); });
+  return channels;
+}
+
+// Returns a C++ expression for an array of bytes holding `bytes`. The array
+// is declared (with the given name) in `decls` if it is not empty.
+std::string ByteSpan(std::string_view name, absl::Span<const uint8_t> bytes,
+                     std::vector<std::string>& decls) {
+  if (bytes.empty()) {
+    return "absl::Span<const uint8_t>()";
+  }
+  std::vector<std::string> elements;
+  for (uint8_t byte : bytes) {
+    elements.push_back(absl::StrFormat("0x%02x", byte));
+  }
+  decls.push_back(absl::StrFormat("const uint8_t %s[] = {%s};", name,
+                                  absl::StrJoin(elements, ", ")));
+  return absl::StrFormat("absl::MakeConstSpan(%s)", name);
+}
+
+// Produces a header declaring a class wrapping the AOT-compiled proc.
+absl::StatusOr<std::string> GenerateProcHeader(
+    Proc* proc, const std::vector<std::string>& namespaces) {
+  constexpr std::string_view kTemplate =
+      R"(// AUTO-GENERATED FILE! DO NOT EDIT!
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "xls/jit/aot_runtime.h"
+
+{{open_ns}}
+
+// Ahead-of-time compiled instance of proc `{{proc_name}}`.
+class {{class_name}} : public ::xls::aot_compile::AotProc {
+ public:
+  // Returns a new instance of the proc in its initial state.
+  static absl::StatusOr<std::unique_ptr<{{class_name}}>> Create();
+
+ private:
+  {{class_name}}() = default;
+};
+
+{{close_ns}}
+)";
+  absl::flat_hash_map<std::string, std::string> substitution_map;
+  substitution_map["{{proc_name}}"] = proc->name();
+  substitution_map["{{class_name}}"] = ProcClassName(proc);
+  AddNamespaceSubstitutions(namespaces, substitution_map);
+  return absl::StrReplaceAll(kTemplate, substitution_map);
+}
+
+// Generates the source file for the class wrapping the AOT-compiled proc. As
+// with functions the native layouts of the proc parameters and channel types
+// are embedded as text protos. The initial state is converted to the native
+// layout at compile time.
+absl::StatusOr<std::string> GenerateProcWrapperSource(
+    Proc* proc, const ProcJitObjectCode& object_code,
+    const std::string& header_path,
+    const std::vector<std::string>& namespaces) {
+  constexpr std::string_view kTemplate =
+      R"~(// AUTO-GENERATED FILE! DO NOT EDIT!
+#include "{{header_path}}"
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "xls/ir/events.h"
+#include "xls/jit/aot_runtime.h"
+
+extern "C" {
+int64_t {{extern_fn}}(const uint8_t* const* inputs,
+                      uint8_t* const* outputs,
+                      void* temp_buffer,
+                      ::xls::InterpreterEvents* events,
+                      void* user_data,
+                      void* jit_runtime,
+                      int64_t continuation_point);
+}
+
+{{open_ns}}
+
+namespace {
+
+const char* kParamLayouts = R"|({{param_layouts_proto}})|";
+
+{{decls}}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<{{class_name}}>> {{class_name}}::Create() {
+  static const ::xls::aot_compile::AotProcDescription kDescription = {
+      .name = "{{proc_name}}",
+      .function = &{{extern_fn}},
+      .param_layouts = kParamLayouts,
+      .initial_params = {{initial_params}},
+      .temp_buffer_size = {{temp_buffer_size}},
+      .channels = {{channels}},
+      .continuation_points = {{continuation_points}},
+  };
+  auto proc = absl::WrapUnique(new {{class_name}}());
+  absl::Status status = proc->Init(kDescription);
+  if (!status.ok()) {
+    return status;
+  }
+  return proc;
+}
+
+{{close_ns}}
+)~";
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<OrcJit> orc_jit, OrcJit::Create());
+  XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
+                       orc_jit->CreateDataLayout());
+  LlvmTypeConverter type_converter(orc_jit->GetContext(), data_layout);
+
+  // Parameter layouts and the initial parameter values in native layout.
+  TypeLayoutsProto layouts_proto;
+  std::vector<uint8_t> initial_params;
+  XLS_RET_CHECK_EQ(object_code.param_buffer_sizes.size(),
+                   proc->params().size());
+  for (int64_t i = 0; i < proc->params().size(); ++i) {
+    TypeLayout layout =
+        type_converter.CreateTypeLayout(proc->param(i)->GetType());
+    XLS_RET_CHECK_EQ(layout.size(), object_code.param_buffer_sizes[i]);
+    *layouts_proto.add_layouts() = layout.ToProto();
+    Value initial_value =
+        i == 0 ? Value::Token() : proc->GetInitValueElement(i - 1);
+    std::vector<uint8_t> buffer(layout.size());
+    layout.ValueToNativeLayout(initial_value, buffer.data());
+    initial_params.insert(initial_params.end(), buffer.begin(), buffer.end());
+  }
+  std::string param_layouts_text;
+  XLS_RET_CHECK(google::protobuf::TextFormat::PrintToString(
+      layouts_proto, &param_layouts_text));
+
+  std::vector<std::string> decls;
+  absl::flat_hash_map<std::string, std::string> substitution_map;
+  substitution_map["{{initial_params}}"] =
+      ByteSpan("kInitialParams", initial_params, decls);
+
+  XLS_ASSIGN_OR_RETURN(std::vector<Channel*> channels, GetProcChannels(proc));
+  if (channels.empty()) {
+    substitution_map["{{channels}}"] =
+        "absl::Span<const ::xls::aot_compile::AotChannelDescription>()";
+  } else {
+    std::vector<std::string> channel_entries;
+    for (Channel* channel : channels) {
+      std::string layout_text;
+      XLS_RET_CHECK(google::protobuf::TextFormat::PrintToString(
+          type_converter.CreateTypeLayout(channel->type()).ToProto(),
+          &layout_text));
+      channel_entries.push_back(absl::StrFormat(
+          "    {.id = %d, .name = \"%s\", .layout = R\"|(%s)|\"},",
+          channel->id(), channel->name(), layout_text));
+    }
+    decls.push_back(absl::StrFormat(
+        "const ::xls::aot_compile::AotChannelDescription kChannels[] = {\n"
+        "%s\n};",
+        absl::StrJoin(channel_entries, "\n")));
+    substitution_map["{{channels}}"] = "absl::MakeConstSpan(kChannels)";
+  }
+
+  // Continuation points in a deterministic order.
+  std::vector<std::pair<int64_t, Node*>> continuation_points(
+      object_code.continuation_points.begin(),
+      object_code.continuation_points.end());
+  std::sort(continuation_points.begin(), continuation_points.end());
+  if (continuation_points.empty()) {
+    substitution_map["{{continuation_points}}"] =
+        "absl::Span<const ::xls::aot_compile::AotContinuationPoint>()";
+  } else {
+    std::vector<std::string> point_entries;
+    for (const auto& [point, node] : continuation_points) {
+      XLS_RET_CHECK(node->Is<Send>() || node->Is<Receive>()) << node;
+      int64_t channel_id = node->Is<Send>()
+                               ? node->As<Send>()->channel_id()
+                               : node->As<Receive>()->channel_id();
+      point_entries.push_back(absl::StrFormat(
+          "    {.continuation_point = %d, .channel_id = %d, .is_send = %s},",
+          point, channel_id, node->Is<Send>() ? "true" : "false"));
+    }
+    decls.push_back(absl::StrFormat(
+        "const ::xls::aot_compile::AotContinuationPoint "
+        "kContinuationPoints[] = {\n%s\n};",
+        absl::StrJoin(point_entries, "\n")));
+    substitution_map["{{continuation_points}}"] =
+        "absl::MakeConstSpan(kContinuationPoints)";
+  }
+
+  substitution_map["{{header_path}}"] = header_path;
+  substitution_map["{{extern_fn}}"] = object_code.function_name;
+  substitution_map["{{proc_name}}"] = proc->name();
+  substitution_map["{{class_name}}"] = ProcClassName(proc);
+  substitution_map["{{param_layouts_proto}}"] = param_layouts_text;
+  substitution_map["{{temp_buffer_size}}"] =
+      absl::StrCat(object_code.temp_buffer_size);
+  substitution_map["{{decls}}"] = absl::StrJoin(decls, "\n\n");
+  AddNamespaceSubstitutions(namespaces, substitution_map);
+  return absl::StrReplaceAll(kTemplate, substitution_map);
+}
+
+// Compiles `proc` and writes the object code, header and wrapper source.
+absl::Status CompileProc(Proc* proc, const std::string& output_object_path,
+                         const std::string& output_header_path,
+                         const std::string& output_source_path,
+                         const std::string& header_include_path,
+                         const std::vector<std::string>& namespaces) {
+  // Traces, asserts and covers embed host addresses in the generated code so
+  // they cannot be compiled ahead of time.
+  for (Node* node : proc->nodes()) {
+    if (node->Is<Trace>() || node->Is<Assert>() || node->Is<Cover>()) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "AOT compilation of procs containing %s operations is not "
+          "supported: %s",
+          OpToString(node->op()), node->GetName()));
+    }
+  }
+  XLS_ASSIGN_OR_RETURN(ProcJitObjectCode object_code,
+                       ProcJit::CreateObjectCode(proc));
+  XLS_RETURN_IF_ERROR(SetFileContents(
+      output_object_path, std::string(object_code.object_code.begin(),
+                                      object_code.object_code.end())));
+
+  XLS_ASSIGN_OR_RETURN(std::string header_text,
+                       GenerateProcHeader(proc, namespaces));
+  XLS_RETURN_IF_ERROR(SetFileContents(output_header_path, header_text));
+
+  XLS_ASSIGN_OR_RETURN(std::string source_text,
+                       GenerateProcWrapperSource(proc, object_code,
+                                                 header_include_path,
+                                                 namespaces));
+  return SetFileContents(output_source_path, source_text);
+}
+
 absl::Status RealMain(const std::string& input_ir_path, std::string top,
                       const std::string& output_object_path,
                       const std::string& output_header_path,
@@ -262,7 +567,17 @@ absl::Status RealMain(const std::string& input_ir_path, std::string top,
   Function* f;
   std::string package_prefix = absl::StrCat("__", package->name(), "__");
   if (top.empty()) {
+    std::optional<FunctionBase*> package_top = package->GetTop();
+    if (package_top.has_value() && (*package_top)->IsProc()) {
+      return CompileProc((*package_top)->AsProcOrDie(), output_object_path,
+                         output_header_path, output_source_path,
+                         header_include_path, namespaces);
+    }
     XLS_ASSIGN_OR_RETURN(f, package->GetTopAsFunction());
+  } else if (package->GetProc(top).ok()) {
+    return CompileProc(package->GetProc(top).value(), output_object_path,
+                       output_header_path, output_source_path,
+                       header_include_path, namespaces);
   } else {
     XLS_ASSIGN_OR_RETURN(f, package->GetFunction(top));
   }
@@ -12,12 +12,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+#include <optional>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "xls/common/status/matchers.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/value.h"
+#include "xls/jit/accumulator_proc_cc.h"
+#include "xls/jit/aot_runtime.h"
 #include "xls/jit/compound_type_cc.h"
 #include "xls/jit/null_function_cc.h"
 #include "xls/modules/fp/fp32_add_2_cc.h"
@@ -29,6 +34,9 @@
 namespace xls {
 namespace {
 
+using status_testing::IsOkAndHolds;
+using status_testing::StatusIs;
+
 Value F32Value(bool sign, uint8_t exp, uint32_t frac) {
   return Value::Tuple({Value(UBits(static_cast<uint64_t>(sign), 1)),
                        Value(UBits(exp, 8)), Value(UBits(frac, 23))});
@@ -71,6 +79,45 @@ TEST(AotCompileTest, CompoundType) {
   EXPECT_EQ(result, Value::Tuple({b, Value(UBits(43, 32)), c}));
 }
 
+TEST(AotCompileTest, Proc) {
+  using aot_compile::AotTickResult;
+  using aot_compile::AotTickState;
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Accumulator> proc,
+                           Accumulator::Create());
+  EXPECT_THAT(proc->GetState(), testing::ElementsAre(Value(UBits(10, 32))));
+
+  // The tick blocks until input is available.
+  AotTickResult result = proc->Tick();
+  EXPECT_EQ(result.state, AotTickState::kBlockedOnReceive);
+  EXPECT_EQ(result.channel, "in");
+  EXPECT_FALSE(proc->Tick().progress_made);
+
+  XLS_ASSERT_OK(proc->Send("in", Value(UBits(5, 32))));
+  result = proc->Tick();
+  EXPECT_EQ(result.state, AotTickState::kSentOnChannel);
+  EXPECT_EQ(result.channel, "out");
+  EXPECT_THAT(proc->Receive("out"),
+              IsOkAndHolds(std::optional<Value>(Value(UBits(15, 32)))));
+  EXPECT_EQ(proc->Tick().state, AotTickState::kCompleted);
+  EXPECT_THAT(proc->GetState(), testing::ElementsAre(Value(UBits(15, 32))));
+
+  XLS_ASSERT_OK(proc->Send("in", Value(UBits(7, 32))));
+  EXPECT_EQ(proc->Tick().state, AotTickState::kSentOnChannel);
+  EXPECT_EQ(proc->Tick().state, AotTickState::kCompleted);
+  EXPECT_THAT(proc->Receive("out"),
+              IsOkAndHolds(std::optional<Value>(Value(UBits(22, 32)))));
+  EXPECT_THAT(proc->Receive("out"), IsOkAndHolds(std::nullopt));
+  EXPECT_THAT(proc->GetState(), testing::ElementsAre(Value(UBits(22, 32))));
+
+  proc->Reset();
+  EXPECT_THAT(proc->GetState(), testing::ElementsAre(Value(UBits(10, 32))));
+
+  EXPECT_THAT(proc->Send("in", Value(UBits(1, 8))),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(proc->Send("bogus", Value(UBits(1, 32))),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
 #ifndef NDEBUG
 // In non-opt mode, argument values are type-checked using DCHECK.
 TEST(AotCompileTest, InvalidTypes) {
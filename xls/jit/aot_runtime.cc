@@ -13,8 +13,14 @@
 // limitations under the License.
 #include "xls/jit/aot_runtime.h"
 
+#include <cstring>
+#include <utility>
+
+#include "absl/strings/str_format.h"
 #include "google/protobuf/text_format.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/value_helpers.h"
 
 namespace xls::aot_compile {
 
@@ -50,4 +56,180 @@ FunctionTypeLayout::Create(std::string_view serialized_arg_layouts,
                                                  std::move(result_layout)));
 }
 
+void AotFifoChannelQueue::WriteRaw(const uint8_t* data) {
+  elements_.emplace_back(data, data + element_size_);
+}
+
+bool AotFifoChannelQueue::ReadRaw(uint8_t* buffer) {
+  if (elements_.empty()) {
+    return false;
+  }
+  if (element_size_ > 0) {
+    std::memcpy(buffer, elements_.front().data(), element_size_);
+  }
+  elements_.pop_front();
+  return true;
+}
+
+absl::Status AotProc::Init(const AotProcDescription& description) {
+  description_ = description;
+  package_ = std::make_unique<Package>("__aot_compiler");
+
+  TypeLayoutsProto param_layouts_proto;
+  if (!google::protobuf::TextFormat::ParseFromString(
+          std::string(description.param_layouts), &param_layouts_proto)) {
+    return absl::InvalidArgumentError(
+        "Unable to parse TypeLayoutsProto for proc parameters");
+  }
+  int64_t initial_params_size = 0;
+  for (const TypeLayoutProto& layout_proto : param_layouts_proto.layouts()) {
+    XLS_ASSIGN_OR_RETURN(TypeLayout layout,
+                         TypeLayout::FromProto(layout_proto, package_.get()));
+    initial_params_size += layout.size();
+    param_buffers_.push_back(std::vector<uint8_t>(layout.size()));
+    next_param_buffers_.push_back(std::vector<uint8_t>(layout.size()));
+    param_layouts_.push_back(std::move(layout));
+  }
+  XLS_RET_CHECK_EQ(initial_params_size, description.initial_params.size());
+  for (int64_t i = 0; i < param_layouts_.size(); ++i) {
+    param_ptrs_.push_back(param_buffers_[i].data());
+    next_param_ptrs_.push_back(next_param_buffers_[i].data());
+  }
+  temp_buffer_.resize(description.temp_buffer_size);
+
+  for (const AotChannelDescription& channel : description.channels) {
+    TypeLayoutProto layout_proto;
+    if (!google::protobuf::TextFormat::ParseFromString(
+            std::string(channel.layout), &layout_proto)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Unable to parse TypeLayoutProto for channel `%s`", channel.name));
+    }
+    XLS_ASSIGN_OR_RETURN(TypeLayout layout,
+                         TypeLayout::FromProto(layout_proto, package_.get()));
+    auto queue = std::make_unique<AotFifoChannelQueue>(layout.size());
+    XLS_RET_CHECK(channel_ids_.insert({channel.name, channel.id}).second);
+    channels_.insert({channel.id, Channel{.name = channel.name,
+                                          .layout = std::move(layout),
+                                          .queue = std::move(queue)}});
+  }
+  for (const AotContinuationPoint& point : description.continuation_points) {
+    XLS_RET_CHECK(channels_.contains(point.channel_id));
+    continuation_points_[point.continuation_point] = point;
+  }
+  callbacks_ = ProcChannelCallbacks{.receive = &AotProc::ReceiveCallback,
+                                    .send = &AotProc::SendCallback,
+                                    .context = this};
+  Reset();
+  return absl::OkStatus();
+}
+
+/* static */ bool AotProc::ReceiveCallback(void* context, int64_t channel_id,
+                                           uint8_t* buffer) {
+  AotProc* proc = static_cast<AotProc*>(context);
+  return proc->channels_.at(channel_id).queue->ReadRaw(buffer);
+}
+
+/* static */ void AotProc::SendCallback(void* context, int64_t channel_id,
+                                        const uint8_t* data) {
+  AotProc* proc = static_cast<AotProc*>(context);
+  proc->channels_.at(channel_id).queue->WriteRaw(data);
+}
+
+AotTickResult AotProc::Tick() {
+  int64_t start_continuation_point = continuation_point_;
+  continuation_point_ = description_.function(
+      param_ptrs_.data(), next_param_ptrs_.data(), temp_buffer_.data(),
+      &events_, &callbacks_, /*jit_runtime=*/nullptr, continuation_point_);
+  if (continuation_point_ == 0) {
+    // The tick completed; the next state becomes the current state.
+    std::swap(param_buffers_, next_param_buffers_);
+    std::swap(param_ptrs_, next_param_ptrs_);
+    return AotTickResult{.state = AotTickState::kCompleted,
+                         .channel = std::nullopt,
+                         .progress_made = true};
+  }
+  const AotContinuationPoint& point =
+      continuation_points_.at(continuation_point_);
+  return AotTickResult{
+      .state = point.is_send ? AotTickState::kSentOnChannel
+                             : AotTickState::kBlockedOnReceive,
+      .channel = channels_.at(point.channel_id).name,
+      .progress_made = continuation_point_ != start_continuation_point};
+}
+
+std::vector<Value> AotProc::GetState() const {
+  // The first parameter is the token.
+  std::vector<Value> state;
+  for (int64_t i = 1; i < param_layouts_.size(); ++i) {
+    state.push_back(
+        param_layouts_[i].NativeLayoutToValue(param_buffers_[i].data()));
+  }
+  return state;
+}
+
+void AotProc::Reset() {
+  const uint8_t* initial_param = description_.initial_params.data();
+  for (int64_t i = 0; i < param_layouts_.size(); ++i) {
+    int64_t size = param_layouts_[i].size();
+    if (size > 0) {
+      std::memcpy(param_buffers_[i].data(), initial_param, size);
+    }
+    initial_param += size;
+  }
+  continuation_point_ = 0;
+}
+
+absl::StatusOr<AotProc::Channel*> AotProc::GetChannel(std::string_view name) {
+  auto it = channel_ids_.find(name);
+  if (it == channel_ids_.end()) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Proc `%s` has no channel named `%s`", description_.name, name));
+  }
+  return &channels_.at(it->second);
+}
+
+absl::Status AotProc::Send(std::string_view channel, const Value& value) {
+  XLS_ASSIGN_OR_RETURN(Channel * ch, GetChannel(channel));
+  if (!ValueConformsToType(value, ch->layout.type())) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Value %s sent on channel `%s` is not of type %s", value.ToString(),
+        channel, ch->layout.type()->ToString()));
+  }
+  std::vector<uint8_t> buffer(ch->layout.size());
+  ch->layout.ValueToNativeLayout(value, buffer.data());
+  ch->queue->WriteRaw(buffer.data());
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::optional<Value>> AotProc::Receive(
+    std::string_view channel) {
+  XLS_ASSIGN_OR_RETURN(Channel * ch, GetChannel(channel));
+  std::vector<uint8_t> buffer(ch->layout.size());
+  if (!ch->queue->ReadRaw(buffer.data())) {
+    return std::nullopt;
+  }
+  return ch->layout.NativeLayoutToValue(buffer.data());
+}
+
+absl::StatusOr<AotChannelQueue*> AotProc::GetQueue(std::string_view channel) {
+  XLS_ASSIGN_OR_RETURN(Channel * ch, GetChannel(channel));
+  return ch->queue.get();
+}
+
+absl::Status AotProc::SetQueue(std::string_view channel,
+                               std::unique_ptr<AotChannelQueue> queue) {
+  XLS_RET_CHECK(queue != nullptr);
+  XLS_ASSIGN_OR_RETURN(Channel * ch, GetChannel(channel));
+  ch->queue = std::move(queue);
+  return absl::OkStatus();
+}
+
+std::vector<std::string_view> AotProc::GetChannelNames() const {
+  std::vector<std::string_view> names;
+  for (const AotChannelDescription& channel : description_.channels) {
+    names.push_back(channel.name);
+  }
+  return names;
+}
+
 }  // namespace xls::aot_compile
@@ -18,12 +18,21 @@
 #ifndef XLS_JIT_AOT_RUNTIME_H_
 #define XLS_JIT_AOT_RUNTIME_H_
 
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "xls/ir/events.h"
 #include "xls/ir/package.h"
+#include "xls/jit/proc_channel_callbacks.h"
 #include "xls/jit/type_layout.h"
 #include "xls/jit/type_layout.pb.h"
 
@@ -72,6 +81,187 @@ class FunctionTypeLayout {
   TypeLayout result_layout_;
 };
 
+// Signature of the function implementing an ahead-of-time compiled proc. See
+// JitFunctionType in function_base_jit.h for a description of the arguments.
+// `user_data` must point to a ProcChannelCallbacks and the JIT runtime is
+// unused.
+using AotProcFunctionType = int64_t (*)(const uint8_t* const* inputs,
+                                        uint8_t* const* outputs,
+                                        void* temp_buffer,
+                                        InterpreterEvents* events,
+                                        void* user_data, void* jit_runtime,
+                                        int64_t continuation_point);
+
+// Queue holding the data of a channel of an ahead-of-time compiled proc.
+// Elements are in the native data layout of the channel type.
+class AotChannelQueue {
+ public:
+  virtual ~AotChannelQueue() = default;
+
+  // Writes `data` to the back of the queue.
+  virtual void WriteRaw(const uint8_t* data) = 0;
+
+  // Reads the element at the front of the queue into `buffer` and returns
+  // true. Returns false if the queue is empty.
+  virtual bool ReadRaw(uint8_t* buffer) = 0;
+};
+
+// An unbounded FIFO queue. The default queue of each channel.
+class AotFifoChannelQueue : public AotChannelQueue {
+ public:
+  explicit AotFifoChannelQueue(int64_t element_size)
+      : element_size_(element_size) {}
+
+  void WriteRaw(const uint8_t* data) override;
+  bool ReadRaw(uint8_t* buffer) override;
+
+  int64_t size() const { return elements_.size(); }
+  bool empty() const { return elements_.empty(); }
+
+ private:
+  int64_t element_size_;
+  std::deque<std::vector<uint8_t>> elements_;
+};
+
+// Description of a channel used by an ahead-of-time compiled proc.
+struct AotChannelDescription {
+  int64_t id;
+  std::string_view name;
+  // Text serialization of the TypeLayoutProto of the channel type.
+  std::string_view layout;
+};
+
+// Description of a point at which the execution of a tick of an ahead-of-time
+// compiled proc may be interrupted.
+struct AotContinuationPoint {
+  int64_t continuation_point;
+  int64_t channel_id;
+  // Whether execution is interrupted after a send (true) or because a
+  // receive is blocked (false).
+  bool is_send;
+};
+
+// Description of an ahead-of-time compiled proc. Emitted by the AOT compiler.
+struct AotProcDescription {
+  std::string_view name;
+  AotProcFunctionType function;
+  // Text serialization of a TypeLayoutsProto holding the layouts of the proc
+  // parameters (the token followed by the state elements).
+  std::string_view param_layouts;
+  // The initial values of the parameters in native layout, concatenated.
+  absl::Span<const uint8_t> initial_params;
+  int64_t temp_buffer_size;
+  absl::Span<const AotChannelDescription> channels;
+  absl::Span<const AotContinuationPoint> continuation_points;
+};
+
+// Possible outcomes of a call to AotProc::Tick.
+enum class AotTickState {
+  // The tick completed and the state was updated.
+  kCompleted,
+  // Execution is blocked on a receive from an empty channel. The next call to
+  // Tick resumes at the receive.
+  kBlockedOnReceive,
+  // Execution stopped after sending data on a channel. The next call to Tick
+  // resumes after the send.
+  kSentOnChannel,
+};
+
+struct AotTickResult {
+  AotTickState state;
+  // The channel received from or sent on if the tick did not complete.
+  std::optional<std::string_view> channel;
+  // Whether any progress was made (i.e., any nodes executed).
+  bool progress_made;
+};
+
+// An instance of an ahead-of-time compiled proc. Holds the proc state, the
+// point at which an interrupted tick resumes, and a queue for each channel
+// used by the proc. Classes generated by the AOT compiler derive from this
+// class. Not thread-safe.
+class AotProc {
+ public:
+  virtual ~AotProc() = default;
+
+  // Executes the proc until the tick completes, a send executes, or a receive
+  // blocks. A blocked receive is retried by the next call to Tick.
+  AotTickResult Tick();
+
+  // Returns the current state of the proc (the state at the beginning of the
+  // current tick).
+  std::vector<Value> GetState() const;
+
+  // Resets the proc to its initial state at the start of a tick. Does not
+  // affect the channel queues.
+  void Reset();
+
+  // Enqueues `value` on the queue of the given channel.
+  absl::Status Send(std::string_view channel, const Value& value);
+
+  // Dequeues a value from the queue of the given channel. Returns std::nullopt
+  // if the queue is empty.
+  absl::StatusOr<std::optional<Value>> Receive(std::string_view channel);
+
+  // Returns the queue of the given channel.
+  absl::StatusOr<AotChannelQueue*> GetQueue(std::string_view channel);
+
+  // Replaces the queue of the given channel, e.g., with one connected to
+  // another model.
+  absl::Status SetQueue(std::string_view channel,
+                        std::unique_ptr<AotChannelQueue> queue);
+
+  // Returns the names of the channels used by the proc.
+  std::vector<std::string_view> GetChannelNames() const;
+
+  // Events (e.g., traces) recorded during execution. Accumulated across ticks.
+  const InterpreterEvents& events() const { return events_; }
+  InterpreterEvents& events() { return events_; }
+
+  std::string_view name() const { return description_.name; }
+
+ protected:
+  AotProc() = default;
+
+  // Initializes the proc from the given description which must outlive the
+  // proc.
+  absl::Status Init(const AotProcDescription& description);
+
+ private:
+  struct Channel {
+    std::string_view name;
+    TypeLayout layout;
+    std::unique_ptr<AotChannelQueue> queue;
+  };
+
+  absl::StatusOr<Channel*> GetChannel(std::string_view name);
+
+  static bool ReceiveCallback(void* context, int64_t channel_id,
+                              uint8_t* buffer);
+  static void SendCallback(void* context, int64_t channel_id,
+                           const uint8_t* data);
+
+  AotProcDescription description_;
+
+  // Dummy package used for owning Types required by the TypeLayout data
+  // structures.
+  std::unique_ptr<Package> package_;
+  std::vector<TypeLayout> param_layouts_;
+
+  // Buffers holding the current and next values of the proc parameters.
+  std::vector<std::vector<uint8_t>> param_buffers_;
+  std::vector<std::vector<uint8_t>> next_param_buffers_;
+  std::vector<uint8_t*> param_ptrs_;
+  std::vector<uint8_t*> next_param_ptrs_;
+  std::vector<uint8_t> temp_buffer_;
+  int64_t continuation_point_ = 0;
+  InterpreterEvents events_;
+
+  absl::flat_hash_map<int64_t, Channel> channels_;
+  absl::flat_hash_map<std::string_view, int64_t> channel_ids_;
+  absl::flat_hash_map<int64_t, AotContinuationPoint> continuation_points_;
+  ProcChannelCallbacks callbacks_;
+};
+
 }  // namespace xls::aot_compile
 
 #endif  // XLS_JIT_AOT_RUNTIME_H_
@@ -0,0 +1,212 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/block_jit.h"
+
+#include <cstring>
+
+#include "absl/flags/flag.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "xls/common/math_util.h"
+#include "xls/common/status/ret_check.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/value_helpers.h"
+#include "xls/jit/jit_object_cache.h"
+
+namespace xls {
+namespace {
+
+// The alignment of each register within the packed register state buffers.
+constexpr int64_t kRegisterAlignment = 16;
+
+}  // namespace
+
+/* static */
+absl::StatusOr<std::unique_ptr<BlockJit>> BlockJit::Create(Block* block,
+                                                           int64_t opt_level) {
+  auto jit = absl::WrapUnique(new BlockJit(block));
+  XLS_ASSIGN_OR_RETURN(
+      jit->orc_jit_,
+      OrcJit::Create(opt_level, /*emit_object_code=*/false,
+                     JitObjectCache::GetDefault(),
+                     absl::GetFlag(FLAGS_jit_compile_threads)));
+  XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
+                       OrcJit::CreateDataLayout());
+  jit->jit_runtime_ = std::make_unique<JitRuntime>(data_layout);
+  XLS_ASSIGN_OR_RETURN(jit->jitted_function_base_,
+                       BuildBlockFunction(block, *jit->orc_jit_));
+
+  const JittedFunctionBase& jitted = jit->jitted_function_base_;
+  int64_t input_port_count = block->GetInputPorts().size();
+  int64_t output_port_count = block->GetOutputPorts().size();
+  int64_t register_count = block->GetRegisters().size();
+  XLS_RET_CHECK_EQ(jitted.input_buffer_sizes.size(),
+                   input_port_count + register_count);
+  XLS_RET_CHECK_EQ(jitted.output_buffer_sizes.size(),
+                   output_port_count + register_count);
+
+  // Lay out the registers in the packed state buffers.
+  int64_t register_state_size = 0;
+  for (int64_t i = 0; i < register_count; ++i) {
+    jit->register_offsets_.push_back(register_state_size);
+    register_state_size += RoundUpToNearest<int64_t>(
+        jitted.input_buffer_sizes[input_port_count + i], kRegisterAlignment);
+  }
+  jit->register_state_.resize(register_state_size);
+  jit->next_register_state_.resize(register_state_size);
+
+  // Pre-allocate port and temporary buffers and assemble the pointer arrays
+  // passed to the jitted function.
+  for (int64_t i = 0; i < input_port_count; ++i) {
+    jit->input_port_buffers_.push_back(
+        std::vector<uint8_t>(jitted.input_buffer_sizes[i]));
+    jit->input_ptrs_.push_back(jit->input_port_buffers_.back().data());
+  }
+  for (int64_t i = 0; i < register_count; ++i) {
+    jit->input_ptrs_.push_back(jit->register_state_.data() +
+                               jit->register_offsets_[i]);
+  }
+  for (int64_t i = 0; i < output_port_count; ++i) {
+    jit->output_port_buffers_.push_back(
+        std::vector<uint8_t>(jitted.output_buffer_sizes[i]));
+    jit->output_ptrs_.push_back(jit->output_port_buffers_.back().data());
+  }
+  for (int64_t i = 0; i < register_count; ++i) {
+    jit->output_ptrs_.push_back(jit->next_register_state_.data() +
+                                jit->register_offsets_[i]);
+  }
+  jit->temp_buffer_.resize(jitted.temp_buffer_size);
+
+  // Registers start out as zero.
+  absl::flat_hash_map<std::string, Value> reg_state;
+  for (Register* reg : block->GetRegisters()) {
+    reg_state[reg->name()] = ZeroOfType(reg->type());
+  }
+  XLS_RETURN_IF_ERROR(jit->SetRegisters(reg_state));
+
+  return jit;
+}
+
+absl::Status BlockJit::SetInputs(
+    const absl::flat_hash_map<std::string, Value>& inputs) {
+  absl::Span<InputPort* const> ports = block_->GetInputPorts();
+  if (inputs.size() != ports.size()) {
+    for (const auto& [name, value] : inputs) {
+      if (!block_->GetInputPort(name).ok()) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Block has no input port '%s'", name));
+      }
+    }
+  }
+  for (int64_t i = 0; i < ports.size(); ++i) {
+    InputPort* port = ports[i];
+    auto it = inputs.find(port->GetName());
+    if (it == inputs.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Missing input for port '%s'", port->GetName()));
+    }
+    if (!ValueConformsToType(it->second, port->GetType())) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Got value %s for input port '%s' which is not of type %s",
+          it->second.ToString(), port->GetName(),
+          port->GetType()->ToString()));
+    }
+    jit_runtime_->BlitValueToBuffer(it->second, port->GetType(),
+                                    absl::MakeSpan(input_port_buffers_[i]));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status BlockJit::SetRegisters(
+    const absl::flat_hash_map<std::string, Value>& reg_state) {
+  absl::Span<Register* const> registers = block_->GetRegisters();
+  if (reg_state.size() != registers.size()) {
+    for (const auto& [name, value] : reg_state) {
+      if (!block_->GetRegister(name).ok()) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Block has no register '%s'", name));
+      }
+    }
+  }
+  int64_t input_port_count = block_->GetInputPorts().size();
+  for (int64_t i = 0; i < registers.size(); ++i) {
+    Register* reg = registers[i];
+    auto it = reg_state.find(reg->name());
+    if (it == reg_state.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Missing value for register '%s'", reg->name()));
+    }
+    if (!ValueConformsToType(it->second, reg->type())) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Got value %s for register '%s' which is not of type %s",
+          it->second.ToString(), reg->name(), reg->type()->ToString()));
+    }
+    jit_runtime_->BlitValueToBuffer(
+        it->second, reg->type(),
+        absl::MakeSpan(register_state_.data() + register_offsets_[i],
+                       jitted_function_base_.input_buffer_sizes.at(
+                           input_port_count + i)));
+  }
+  if (!register_state_.empty()) {
+    std::memcpy(next_register_state_.data(), register_state_.data(),
+                register_state_.size());
+  }
+  return absl::OkStatus();
+}
+
+void BlockJit::Tick() {
+  events_ = InterpreterEvents();
+  jitted_function_base_.function(
+      input_ptrs_.data(), output_ptrs_.data(), temp_buffer_.data(), &events_,
+      /*user_data=*/nullptr, runtime(), /*continuation_point=*/0);
+  // Clock the registers. Afterwards both state buffers hold the new values.
+  if (!register_state_.empty()) {
+    std::memcpy(register_state_.data(), next_register_state_.data(),
+                register_state_.size());
+  }
+}
+
+absl::flat_hash_map<std::string, Value> BlockJit::GetOutputs() const {
+  absl::flat_hash_map<std::string, Value> outputs;
+  absl::Span<OutputPort* const> ports = block_->GetOutputPorts();
+  for (int64_t i = 0; i < ports.size(); ++i) {
+    outputs[ports[i]->GetName()] = jit_runtime_->UnpackBuffer(
+        output_port_buffers_[i].data(), ports[i]->operand(0)->GetType());
+  }
+  return outputs;
+}
+
+absl::flat_hash_map<std::string, Value> BlockJit::GetRegisters() const {
+  absl::flat_hash_map<std::string, Value> reg_state;
+  absl::Span<Register* const> registers = block_->GetRegisters();
+  for (int64_t i = 0; i < registers.size(); ++i) {
+    reg_state[registers[i]->name()] = jit_runtime_->UnpackBuffer(
+        register_state_.data() + register_offsets_[i], registers[i]->type());
+  }
+  return reg_state;
+}
+
+absl::StatusOr<BlockRunResult> BlockJit::Run(
+    const absl::flat_hash_map<std::string, Value>& inputs,
+    const absl::flat_hash_map<std::string, Value>& reg_state) {
+  XLS_RETURN_IF_ERROR(SetRegisters(reg_state));
+  XLS_RETURN_IF_ERROR(SetInputs(inputs));
+  Tick();
+  return BlockRunResult{.outputs = GetOutputs(), .reg_state = GetRegisters()};
+}
+
+}  // namespace xls
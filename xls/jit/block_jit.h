@@ -0,0 +1,115 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_BLOCK_JIT_H_
+#define XLS_JIT_BLOCK_JIT_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xls/interpreter/block_interpreter.h"
+#include "xls/ir/block.h"
+#include "xls/ir/events.h"
+#include "xls/ir/value.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/jit_runtime.h"
+#include "xls/jit/orc_jit.h"
+
+namespace xls {
+
+// This class provides a facility to simulate XLS blocks cycle-by-cycle (on the
+// host) by compiling each clock cycle of the block into a native function. The
+// block state is held between cycles in a single packed buffer containing all
+// register values in the native LLVM data layout. Not thread-safe.
+class BlockJit {
+ public:
+  // Returns an object containing a host-compiled version of the specified
+  // block. Blocks with instantiations are not supported.
+  static absl::StatusOr<std::unique_ptr<BlockJit>> Create(
+      Block* block, int64_t opt_level = 3);
+
+  // Sets the values driven on the input ports for the next cycle. `inputs`
+  // must contain a value for each input port of the block.
+  absl::Status SetInputs(const absl::flat_hash_map<std::string, Value>& inputs);
+
+  // Sets the current register values. `reg_state` must contain a value for
+  // each register of the block.
+  absl::Status SetRegisters(
+      const absl::flat_hash_map<std::string, Value>& reg_state);
+
+  // Runs a single clock cycle of the block with the current input and register
+  // values. The output port values computed during the cycle may be retrieved
+  // with GetOutputs. The registers are updated to their next values. As with
+  // BlockRun, failed assertions do not stop the simulation; they are recorded
+  // in the events returned by GetEvents.
+  void Tick();
+
+  // Returns the output port values computed by the most recent Tick.
+  absl::flat_hash_map<std::string, Value> GetOutputs() const;
+
+  // Returns the current register values.
+  absl::flat_hash_map<std::string, Value> GetRegisters() const;
+
+  // Returns the events (e.g., traces and assertion failures) recorded during
+  // the most recent Tick.
+  const InterpreterEvents& GetEvents() const { return events_; }
+
+  // Runs a single cycle of the block with the given register values and input
+  // values. This has the same semantics as the BlockRun interpreter function:
+  // returns the values driven on the output ports and the next register state.
+  absl::StatusOr<BlockRunResult> Run(
+      const absl::flat_hash_map<std::string, Value>& inputs,
+      const absl::flat_hash_map<std::string, Value>& reg_state);
+
+  Block* block() const { return block_; }
+
+  JitRuntime* runtime() const { return jit_runtime_.get(); }
+
+ private:
+  explicit BlockJit(Block* block) : block_(block) {}
+
+  Block* block_;
+  std::unique_ptr<OrcJit> orc_jit_;
+  std::unique_ptr<JitRuntime> jit_runtime_;
+  JittedFunctionBase jitted_function_base_;
+
+  // Buffers holding the input port values and output port values in the
+  // native LLVM data layout.
+  std::vector<std::vector<uint8_t>> input_port_buffers_;
+  std::vector<std::vector<uint8_t>> output_port_buffers_;
+
+  // Packed buffers holding the current and next register values. Each register
+  // is at a fixed offset within the buffer. Between cycles both buffers hold
+  // the same contents so the jitted function sees the current value of
+  // registers which are not loaded during a cycle.
+  std::vector<uint8_t> register_state_;
+  std::vector<uint8_t> next_register_state_;
+  std::vector<int64_t> register_offsets_;
+
+  // Arrays of pointers to the input and output buffers passed to the jitted
+  // function.
+  std::vector<const uint8_t*> input_ptrs_;
+  std::vector<uint8_t*> output_ptrs_;
+
+  std::vector<uint8_t> temp_buffer_;
+  InterpreterEvents events_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_BLOCK_JIT_H_
@@ -0,0 +1,319 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/block_jit.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/interpreter/block_interpreter.h"
+#include "xls/interpreter/random_value.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/value_helpers.h"
+
+namespace xls {
+namespace {
+
+using status_testing::StatusIs;
+using testing::HasSubstr;
+using testing::Pair;
+using testing::UnorderedElementsAre;
+
+Value U32(uint64_t value) { return Value(UBits(value, 32)); }
+
+class BlockJitTest : public IrTestBase {
+ protected:
+  // Runs the block for a sequence of cycles with the given bits-typed inputs
+  // and returns the output port values of each cycle. Registers start at zero.
+  std::vector<absl::flat_hash_map<std::string, Value>> RunSequence(
+      BlockJit* jit,
+      absl::Span<const absl::flat_hash_map<std::string, uint64_t>> inputs) {
+    std::vector<absl::flat_hash_map<std::string, Value>> outputs;
+    for (const absl::flat_hash_map<std::string, uint64_t>& cycle_inputs :
+         inputs) {
+      absl::flat_hash_map<std::string, Value> input_values;
+      for (const auto& [name, value] : cycle_inputs) {
+        InputPort* port = jit->block()->GetInputPort(name).value();
+        input_values[name] =
+            Value(UBits(value, port->GetType()->GetFlatBitCount()));
+      }
+      XLS_CHECK_OK(jit->SetInputs(input_values));
+      jit->Tick();
+      outputs.push_back(jit->GetOutputs());
+    }
+    return outputs;
+  }
+};
+
+TEST_F(BlockJitTest, SumAndDifferenceBlock) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  BValue y = b.InputPort("y", package->GetBitsType(32));
+  b.OutputPort("sum", b.Add(x, y));
+  b.OutputPort("diff", b.Subtract(x, y));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  XLS_ASSERT_OK(jit->SetInputs({{"x", U32(42)}, {"y", U32(10)}}));
+  jit->Tick();
+  EXPECT_THAT(jit->GetOutputs(),
+              UnorderedElementsAre(Pair("sum", U32(52)), Pair("diff", U32(32))));
+}
+
+TEST_F(BlockJitTest, PassThroughAndLiteralOutputs) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  BValue x = b.InputPort("x", package->GetBitsType(8));
+  b.OutputPort("out0", x);
+  b.OutputPort("out1", x);
+  b.OutputPort("wide", b.Literal(Value(Bits::AllOnes(100))));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  XLS_ASSERT_OK(jit->SetInputs({{"x", Value(UBits(7, 8))}}));
+  jit->Tick();
+  EXPECT_THAT(jit->GetOutputs(),
+              UnorderedElementsAre(Pair("out0", Value(UBits(7, 8))),
+                                   Pair("out1", Value(UBits(7, 8))),
+                                   Pair("wide", Value(Bits::AllOnes(100)))));
+}
+
+TEST_F(BlockJitTest, InputErrors) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  b.InputPort("x", package->GetBitsType(32));
+  b.InputPort("y", package->GetTupleType({}));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  EXPECT_THAT(jit->SetInputs({{"a", Value(UBits(42, 32))},
+                              {"x", Value(UBits(42, 32))},
+                              {"y", Value::Tuple({})}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Block has no input port 'a'")));
+  EXPECT_THAT(jit->SetInputs({{"x", Value(UBits(10, 32))}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Missing input for port 'y'")));
+  EXPECT_THAT(
+      jit->SetInputs({{"x", Value(UBits(10, 16))}, {"y", Value::Tuple({})}}),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("which is not of type bits[32]")));
+  EXPECT_THAT(jit->SetRegisters({{"r", Value(UBits(10, 16))}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Block has no register 'r'")));
+}
+
+TEST_F(BlockJitTest, PipelinedAdder) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK(b.block()->AddClockPort("clk"));
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  BValue y = b.InputPort("y", package->GetBitsType(32));
+  BValue x_d = b.InsertRegister("x_d", x);
+  BValue y_d = b.InsertRegister("y_d", y);
+  BValue x_plus_y_d = b.InsertRegister("x_plus_y_d", b.Add(x_d, y_d));
+  b.OutputPort("out", x_plus_y_d);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  std::vector<absl::flat_hash_map<std::string, Value>> outputs =
+      RunSequence(jit.get(), {{{"x", 1}, {"y", 2}},
+                              {{"x", 42}, {"y", 100}},
+                              {{"x", 0}, {"y", 0}},
+                              {{"x", 0}, {"y", 0}},
+                              {{"x", 0}, {"y", 0}}});
+  ASSERT_EQ(outputs.size(), 5);
+  EXPECT_THAT(outputs[0], UnorderedElementsAre(Pair("out", U32(0))));
+  EXPECT_THAT(outputs[1], UnorderedElementsAre(Pair("out", U32(0))));
+  EXPECT_THAT(outputs[2], UnorderedElementsAre(Pair("out", U32(3))));
+  EXPECT_THAT(outputs[3], UnorderedElementsAre(Pair("out", U32(142))));
+  EXPECT_THAT(outputs[4], UnorderedElementsAre(Pair("out", U32(0))));
+}
+
+TEST_F(BlockJitTest, RegisterWithResetAndLoadEnable) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK(b.block()->AddClockPort("clk"));
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  BValue rst_n = b.InputPort("rst_n", package->GetBitsType(1));
+  BValue le = b.InputPort("le", package->GetBitsType(1));
+  BValue x_d =
+      b.InsertRegister("x_d", x, rst_n,
+                       Reset{Value(UBits(42, 32)), /*asynchronous=*/false,
+                             /*active_low=*/true},
+                       le);
+  b.OutputPort("out", x_d);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  std::vector<absl::flat_hash_map<std::string, Value>> outputs =
+      RunSequence(jit.get(), {{{"rst_n", 1}, {"le", 0}, {"x", 1}},
+                              {{"rst_n", 0}, {"le", 0}, {"x", 2}},
+                              {{"rst_n", 0}, {"le", 1}, {"x", 3}},
+                              {{"rst_n", 1}, {"le", 1}, {"x", 4}},
+                              {{"rst_n", 1}, {"le", 0}, {"x", 5}}});
+  ASSERT_EQ(outputs.size(), 5);
+  EXPECT_THAT(outputs[0], UnorderedElementsAre(Pair("out", U32(0))));
+  EXPECT_THAT(outputs[1], UnorderedElementsAre(Pair("out", U32(0))));
+  EXPECT_THAT(outputs[2], UnorderedElementsAre(Pair("out", U32(42))));
+  EXPECT_THAT(outputs[3], UnorderedElementsAre(Pair("out", U32(42))));
+  EXPECT_THAT(outputs[4], UnorderedElementsAre(Pair("out", U32(4))));
+  EXPECT_THAT(jit->GetRegisters(),
+              UnorderedElementsAre(Pair("x_d", Value(UBits(4, 32)))));
+}
+
+TEST_F(BlockJitTest, AccumulatorRegister) {
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK(b.block()->AddClockPort("clk"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Register * reg,
+      b.block()->AddRegister("accum", package->GetBitsType(32)));
+  BValue x = b.InputPort("x", package->GetBitsType(32));
+  BValue accum = b.RegisterRead(reg);
+  BValue next_accum = b.Add(x, accum);
+  b.RegisterWrite(reg, next_accum);
+  b.OutputPort("out", next_accum);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  XLS_ASSERT_OK(jit->SetRegisters({{"accum", Value(UBits(100, 32))}}));
+  std::vector<absl::flat_hash_map<std::string, Value>> outputs = RunSequence(
+      jit.get(), {{{"x", 1}}, {{"x", 2}}, {{"x", 3}}, {{"x", 4}}, {{"x", 5}}});
+  ASSERT_EQ(outputs.size(), 5);
+  EXPECT_THAT(outputs[0], UnorderedElementsAre(Pair("out", U32(101))));
+  EXPECT_THAT(outputs[1], UnorderedElementsAre(Pair("out", U32(103))));
+  EXPECT_THAT(outputs[2], UnorderedElementsAre(Pair("out", U32(106))));
+  EXPECT_THAT(outputs[3], UnorderedElementsAre(Pair("out", U32(110))));
+  EXPECT_THAT(outputs[4], UnorderedElementsAre(Pair("out", U32(115))));
+}
+
+TEST_F(BlockJitTest, SwappingRegisters) {
+  // Each register is written with the value of the other register. The next
+  // register values must be computed from the current values of both.
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK(b.block()->AddClockPort("clk"));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Register * a, b.block()->AddRegister("a", package->GetBitsType(16)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Register * c, b.block()->AddRegister("c", package->GetBitsType(16)));
+  BValue a_value = b.RegisterRead(a);
+  BValue c_value = b.RegisterRead(c);
+  b.RegisterWrite(a, c_value);
+  b.RegisterWrite(c, a_value);
+  b.OutputPort("a_out", a_value);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BlockRunResult result,
+      jit->Run({}, {{"a", Value(UBits(1, 16))}, {"c", Value(UBits(2, 16))}}));
+  EXPECT_THAT(result.outputs,
+              UnorderedElementsAre(Pair("a_out", Value(UBits(1, 16)))));
+  EXPECT_THAT(result.reg_state,
+              UnorderedElementsAre(Pair("a", Value(UBits(2, 16))),
+                                   Pair("c", Value(UBits(1, 16)))));
+}
+
+TEST_F(BlockJitTest, MatchesInterpreterOnLargeBlock) {
+  // Build a block large enough to be split into several partitions in the JIT
+  // with aggregate-typed registers and compare against the interpreter.
+  auto package = CreatePackage();
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK(b.block()->AddClockPort("clk"));
+  BValue x = b.InputPort("x", package->GetBitsType(64));
+  BValue rst = b.InputPort("rst", package->GetBitsType(1));
+  Type* tuple_type =
+      package->GetTupleType({package->GetBitsType(64),
+                             package->GetArrayType(3, package->GetBitsType(7))});
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Register * state,
+      b.block()->AddRegister(
+          "state", tuple_type,
+          Reset{ZeroOfType(tuple_type), /*asynchronous=*/false,
+                /*active_low=*/false}));
+  BValue state_value = b.RegisterRead(state);
+  BValue acc = b.TupleIndex(state_value, 0);
+  BValue v = x;
+  for (int64_t i = 0; i < 300; ++i) {
+    v = b.Xor(b.Add(v, acc), b.Shll(v, b.Literal(UBits(i % 7, 64))));
+  }
+  BValue array = b.TupleIndex(state_value, 1);
+  BValue new_array = b.ArrayUpdate(array, b.BitSlice(v, 0, 7),
+                                   {b.BitSlice(v, 7, 2)});
+  b.RegisterWrite(state, b.Tuple({v, new_array}), /*load_enable=*/std::nullopt,
+                  rst);
+  BValue v_d = b.InsertRegister("v_d", v);
+  b.OutputPort("out", v_d);
+  b.OutputPort("array_out", array);
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<BlockJit> jit,
+                           BlockJit::Create(block));
+  absl::flat_hash_map<std::string, Value> reg_state;
+  for (Register* reg : block->GetRegisters()) {
+    reg_state[reg->name()] = ZeroOfType(reg->type());
+  }
+  XLS_ASSERT_OK(jit->SetRegisters(reg_state));
+
+  std::minstd_rand rng_engine;
+  for (int64_t cycle = 0; cycle < 20; ++cycle) {
+    absl::flat_hash_map<std::string, Value> inputs = {
+        {"x", RandomValue(package->GetBitsType(64), &rng_engine)},
+        {"rst", Value(UBits(cycle == 0 ? 1 : 0, 1))}};
+    XLS_ASSERT_OK_AND_ASSIGN(BlockRunResult expected,
+                             BlockRun(inputs, reg_state, block));
+    XLS_ASSERT_OK(jit->SetInputs(inputs));
+    jit->Tick();
+    EXPECT_EQ(jit->GetOutputs(), expected.outputs) << "cycle " << cycle;
+    EXPECT_EQ(jit->GetRegisters(), expected.reg_state) << "cycle " << cycle;
+    reg_state = std::move(expected.reg_state);
+  }
+}
+
+TEST_F(BlockJitTest, InstantiationsUnsupported) {
+  auto package = CreatePackage();
+  BlockBuilder sub_builder("sub", package.get());
+  sub_builder.OutputPort("out", sub_builder.Literal(UBits(1, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * sub, sub_builder.Build());
+
+  BlockBuilder b(TestName(), package.get());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BlockInstantiation * instantiation,
+      b.block()->AddBlockInstantiation("sub_inst", sub));
+  b.OutputPort("out", b.InstantiationOutput(instantiation, "out"));
+  XLS_ASSERT_OK_AND_ASSIGN(Block * block, b.Build());
+
+  EXPECT_THAT(BlockJit::Create(block),
+              StatusIs(absl::StatusCode::kUnimplemented,
+                       HasSubstr("instantiations")));
+}
+
+}  // namespace
+}  // namespace xls
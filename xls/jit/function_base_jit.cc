@@ -25,7 +25,9 @@
 #include "xls/ir/function_base.h"
 #include "xls/ir/node.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
 #include "xls/jit/ir_builder_visitor.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/llvm_type_converter.h"
 
 namespace xls {
@@ -57,6 +59,8 @@ void UnpoisonBuffer(llvm::Value* buffer, int64_t size,
                     llvm::IRBuilder<>* builder) {
 #ifdef ABSL_HAVE_MEMORY_SANITIZER
   llvm::LLVMContext& context = builder->getContext();
+  JitObjectCache::MarkEmbedsHostAddresses(
+      *builder->GetInsertBlock()->getModule());
   llvm::ConstantInt* fn_addr =
       llvm::ConstantInt::get(llvm::Type::getInt64Ty(context),
                              absl::bit_cast<uint64_t>(&__msan_unpoison));
@@ -642,6 +646,17 @@ absl::Status AllocateBuffers(absl::Span<const Partition> partitions,
 // Returns the nodes which comprise the inputs to a jitted function implementing
 // `function_base`. These nodes are passed in via the `inputs` argument.
 std::vector<Node*> GetJittedFunctionInputs(FunctionBase* function_base) {
+  if (function_base->IsBlock()) {
+    // The inputs of a block are the input ports followed by the current values
+    // of the registers.
+    Block* block = function_base->AsBlockOrDie();
+    std::vector<Node*> inputs(block->GetInputPorts().begin(),
+                              block->GetInputPorts().end());
+    for (Register* reg : block->GetRegisters()) {
+      inputs.push_back(block->GetRegisterRead(reg).value());
+    }
+    return inputs;
+  }
   std::vector<Node*> inputs(function_base->params().begin(),
                             function_base->params().end());
   return inputs;
@@ -655,6 +670,20 @@ std::vector<Node*> GetJittedFunctionOutputs(FunctionBase* function_base) {
     Function* f = function_base->AsFunctionOrDie();
     return {f->return_value()};
   }
+  if (function_base->IsBlock()) {
+    // The outputs of a block are the values driving the output ports followed
+    // by the register writes. The buffer of a register write holds the next
+    // value of the register.
+    Block* block = function_base->AsBlockOrDie();
+    std::vector<Node*> outputs;
+    for (OutputPort* port : block->GetOutputPorts()) {
+      outputs.push_back(port->operand(0));
+    }
+    for (Register* reg : block->GetRegisters()) {
+      outputs.push_back(block->GetRegisterWrite(reg).value());
+    }
+    return outputs;
+  }
   XLS_CHECK(function_base->IsProc());
   // The outputs of a proc are the next state values.
   Proc* proc = function_base->AsProcOrDie();
@@ -665,6 +694,16 @@ std::vector<Node*> GetJittedFunctionOutputs(FunctionBase* function_base) {
   return outputs;
 }
 
+// Returns the type of the value held in the buffer of the given input or output
+// node of a jitted function. This is the type of the node except for register
+// writes whose buffers hold the next value of the register.
+Type* GetJittedFunctionBufferType(Node* node) {
+  if (node->Is<RegisterWrite>()) {
+    return node->As<RegisterWrite>()->GetRegister()->type();
+  }
+  return node->GetType();
+}
+
 // Build an llvm::Function implementing the given FunctionBase. The jitted
 // function contains a sequence of calls to partition functions where each
 // partition only implements a subset of the FunctionBase's nodes. This
@@ -801,10 +840,10 @@ absl::StatusOr<PartitionedFunction> BuildFunctionInternal(
       int64_t index = wrapper.GetOutputArgIndices(output).front();
       llvm::Value* output_buffer = LoadPointerFromPointerArray(
           index, wrapper.GetOutputsArg(), builder.get());
-      UnpoisonBuffer(
-          output_buffer,
-          jit_context.type_converter().GetTypeByteSize(output->GetType()),
-          builder.get());
+      UnpoisonBuffer(output_buffer,
+                     jit_context.type_converter().GetTypeByteSize(
+                         GetJittedFunctionBufferType(output)),
+                     builder.get());
     }
   }
   // Return zero indicating that the execution of the FunctionBase completed.
@@ -1135,11 +1174,114 @@ absl::StatusOr<llvm::Function*> BuildPackedWrapper(
   return wrapper.function();
 }
 
+// Builds a wrapper around the jitted function `callee` which evaluates it on a
+// batch of samples (see JitBatchedFunctionType). The loop over the samples is
+// emitted in LLVM IR so that `callee` may be inlined into the loop body and
+// the computation vectorized across samples.
+absl::StatusOr<llvm::Function*> BuildBatchedWrapper(
+    FunctionBase* xls_function, llvm::Function* callee,
+    JitBuilderContext& jit_context) {
+  llvm::LLVMContext* context = &jit_context.context();
+  llvm::Type* int64_type = llvm::Type::getInt64Ty(*context);
+  std::vector<Node*> inputs = GetJittedFunctionInputs(xls_function);
+  std::vector<Node*> outputs = GetJittedFunctionOutputs(xls_function);
+  LlvmFunctionWrapper wrapper = LlvmFunctionWrapper::Create(
+      absl::StrFormat("%s_batched", xls_function->name()), inputs, outputs,
+      int64_type, jit_context,
+      LlvmFunctionWrapper::FunctionArg{.name = "count", .type = int64_type});
+  llvm::IRBuilder<>& entry_builder = wrapper.entry_builder();
+  llvm::Value* count = wrapper.GetExtraArg().value();
+
+  // The arrays of pointers to the input and output buffers of the sample being
+  // evaluated, passed on to the wrapped function.
+  llvm::Type* pointer_array_type =
+      llvm::ArrayType::get(llvm::Type::getInt8PtrTy(*context), 0);
+  llvm::Value* input_arg_array = entry_builder.CreateAlloca(
+      llvm::ArrayType::get(llvm::PointerType::get(*context, 0), inputs.size()));
+  llvm::Value* output_arg_array =
+      entry_builder.CreateAlloca(llvm::ArrayType::get(
+          llvm::PointerType::get(*context, 0), outputs.size()));
+
+  // The base pointers of the structure-of-arrays buffers and the stride of the
+  // values within them.
+  struct BatchBuffer {
+    llvm::Value* base;
+    int64_t stride;
+  };
+  std::vector<BatchBuffer> input_buffers;
+  for (int64_t i = 0; i < inputs.size(); ++i) {
+    input_buffers.push_back(BatchBuffer{
+        .base = LoadPointerFromPointerArray(i, wrapper.GetInputsArg(),
+                                            &entry_builder),
+        .stride = jit_context.type_converter().GetTypeByteSize(
+            inputs[i]->GetType())});
+  }
+  std::vector<BatchBuffer> output_buffers;
+  for (int64_t i = 0; i < outputs.size(); ++i) {
+    output_buffers.push_back(BatchBuffer{
+        .base = LoadPointerFromPointerArray(i, wrapper.GetOutputsArg(),
+                                            &entry_builder),
+        .stride = jit_context.type_converter().GetTypeByteSize(
+            GetJittedFunctionBufferType(outputs[i]))});
+  }
+
+  llvm::BasicBlock* loop_block =
+      llvm::BasicBlock::Create(*context, "loop", wrapper.function());
+  llvm::BasicBlock* exit_block =
+      llvm::BasicBlock::Create(*context, "exit", wrapper.function());
+  llvm::Value* zero = llvm::ConstantInt::get(int64_type, 0);
+  entry_builder.CreateCondBr(entry_builder.CreateICmpSGT(count, zero),
+                             loop_block, exit_block);
+
+  llvm::IRBuilder<> loop_builder(loop_block);
+  llvm::PHINode* index = loop_builder.CreatePHI(int64_type, 2, "index");
+  index->addIncoming(zero, entry_builder.GetInsertBlock());
+  auto set_sample_pointers = [&](absl::Span<const BatchBuffer> buffers,
+                                 llvm::Value* arg_array) {
+    for (int64_t i = 0; i < buffers.size(); ++i) {
+      llvm::Value* offset = loop_builder.CreateMul(
+          index, llvm::ConstantInt::get(int64_type, buffers[i].stride));
+      llvm::Value* sample_buffer = loop_builder.CreateGEP(
+          llvm::Type::getInt8Ty(*context), buffers[i].base, offset);
+      llvm::Value* gep = loop_builder.CreateGEP(
+          pointer_array_type, arg_array,
+          {
+              llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), 0),
+              llvm::ConstantInt::get(llvm::Type::getInt32Ty(*context), i),
+          });
+      loop_builder.CreateStore(sample_buffer, gep);
+    }
+  };
+  set_sample_pointers(input_buffers, input_arg_array);
+  set_sample_pointers(output_buffers, output_arg_array);
+
+  std::vector<llvm::Value*> args;
+  args.push_back(input_arg_array);
+  args.push_back(output_arg_array);
+  args.push_back(wrapper.GetTempBufferArg());
+  args.push_back(wrapper.GetInterpreterEventsArg());
+  args.push_back(wrapper.GetUserDataArg());
+  args.push_back(wrapper.GetJitRuntimeArg());
+  args.push_back(zero);
+  loop_builder.CreateCall(callee, args);
+
+  llvm::Value* next_index =
+      loop_builder.CreateAdd(index, llvm::ConstantInt::get(int64_type, 1));
+  index->addIncoming(next_index, loop_block);
+  loop_builder.CreateCondBr(loop_builder.CreateICmpSLT(next_index, count),
+                            loop_block, exit_block);
+
+  llvm::IRBuilder<> exit_builder(exit_block);
+  exit_builder.CreateRet(zero);
+
+  return wrapper.function();
+}
+
 // Jits a function implementing `xls_function`. Also jits all transitively
 // dependent xls::Functions which may be called by `xls_function`.
 absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
     FunctionBase* xls_function, JitBuilderContext& jit_context,
-    bool build_packed_wrapper) {
+    bool build_packed_wrapper, bool build_batched_wrapper) {
   std::vector<FunctionBase*> functions = GetDependentFunctions(xls_function);
   BufferAllocator allocator(&jit_context.type_converter());
   llvm::Function* top_function = nullptr;
@@ -1165,6 +1307,13 @@ absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
         BuildPackedWrapper(xls_function, top_function, jit_context));
     packed_wrapper_name = packed_wrapper_function->getName().str();
   }
+  std::string batched_wrapper_name;
+  if (build_batched_wrapper) {
+    XLS_ASSIGN_OR_RETURN(
+        llvm::Function * batched_wrapper_function,
+        BuildBatchedWrapper(xls_function, top_function, jit_context));
+    batched_wrapper_name = batched_wrapper_function->getName().str();
+  }
 
   XLS_RETURN_IF_ERROR(
       jit_context.orc_jit().CompileModule(jit_context.ConsumeModule()));
@@ -1184,17 +1333,27 @@ absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
         absl::bit_cast<JitFunctionType>(packed_fn_address);
   }
 
+  if (build_batched_wrapper) {
+    jitted_function.batched_function_name = batched_wrapper_name;
+    XLS_ASSIGN_OR_RETURN(
+        auto batched_fn_address,
+        jit_context.orc_jit().LoadSymbol(batched_wrapper_name));
+    jitted_function.batched_function =
+        absl::bit_cast<JitBatchedFunctionType>(batched_fn_address);
+  }
+
   for (const Node* input : GetJittedFunctionInputs(xls_function)) {
     jitted_function.input_buffer_sizes.push_back(
         jit_context.type_converter().GetTypeByteSize(input->GetType()));
     jitted_function.packed_input_buffer_sizes.push_back(
         jit_context.type_converter().GetPackedTypeByteSize(input->GetType()));
   }
-  for (const Node* output : GetJittedFunctionOutputs(xls_function)) {
+  for (Node* output : GetJittedFunctionOutputs(xls_function)) {
+    Type* output_type = GetJittedFunctionBufferType(output);
     jitted_function.output_buffer_sizes.push_back(
-        jit_context.type_converter().GetTypeByteSize(output->GetType()));
+        jit_context.type_converter().GetTypeByteSize(output_type));
     jitted_function.packed_output_buffer_sizes.push_back(
-        jit_context.type_converter().GetPackedTypeByteSize(output->GetType()));
+        jit_context.type_converter().GetPackedTypeByteSize(output_type));
   }
   jitted_function.temp_buffer_size = allocator.size();
 
@@ -1213,17 +1372,36 @@ absl::StatusOr<JittedFunctionBase> BuildFunctionAndDependencies(
 }  // namespace
 
 absl::StatusOr<JittedFunctionBase> BuildFunction(Function* xls_function,
-                                                 OrcJit& orc_jit) {
+                                                 OrcJit& orc_jit,
+                                                 bool build_batched_wrapper) {
   JitBuilderContext jit_context(orc_jit);
   return BuildFunctionAndDependencies(xls_function, jit_context,
-                                      /*build_packed_wrapper=*/true);
+                                      /*build_packed_wrapper=*/true,
+                                      build_batched_wrapper);
 }
 
 absl::StatusOr<JittedFunctionBase> BuildProcFunction(
     Proc* proc, JitChannelQueueManager* queue_mgr, OrcJit& orc_jit) {
-  JitBuilderContext jit_context(orc_jit, queue_mgr);
+  JitBuilderContext jit_context(
+      orc_jit, queue_mgr == nullptr
+                   ? std::nullopt
+                   : std::optional<JitChannelQueueManager*>(queue_mgr));
   return BuildFunctionAndDependencies(proc, jit_context,
-                                      /*build_packed_wrapper=*/false);
+                                      /*build_packed_wrapper=*/false,
+                                      /*build_batched_wrapper=*/false);
+}
+
+absl::StatusOr<JittedFunctionBase> BuildBlockFunction(Block* block,
+                                                      OrcJit& orc_jit) {
+  if (!block->GetInstantiations().empty()) {
+    return absl::UnimplementedError(absl::StrFormat(
+        "Block `%s` has instantiations which are not supported by the JIT",
+        block->name()));
+  }
+  JitBuilderContext jit_context(orc_jit);
+  return BuildFunctionAndDependencies(block, jit_context,
+                                      /*build_packed_wrapper=*/false,
+                                      /*build_batched_wrapper=*/false);
 }
 
 }  // namespace xls
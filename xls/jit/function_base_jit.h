@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "xls/ir/block.h"
 #include "xls/ir/events.h"
 #include "xls/ir/function.h"
 #include "xls/ir/proc.h"
@@ -28,9 +29,11 @@ namespace xls {
 
 // Type alias for the jitted functions implementing XLS FunctionBases. Argument
 // descriptions:
-//   inputs: array of pointers to input buffers (e.g., parameter values).
+//   inputs: array of pointers to input buffers (e.g., parameter values, block
+//        input port values and register values).
 //   outputs: array of pointers to output buffers (e.g., function return value,
-//        proc next state values)
+//        proc next state values, block output port values and next register
+//        values)
 //   temp_buffer: heap-allocated scratch space for the JITed funcion. This
 //       buffer hold temporary node values which cannot be stack allocated via
 //       allocas.
@@ -52,6 +55,23 @@ using JitFunctionType = int64_t (*)(const uint8_t* const* inputs,
                                     JitRuntime* jit_runtime,
                                     int64_t continuation_point);
 
+// Type alias for the batched wrapper of a jitted XLS function which evaluates
+// the function on `count` independent samples in a single call. The arguments
+// are as for JitFunctionType except:
+//   inputs: array of pointers to input buffers in structure-of-arrays form.
+//        The i-th buffer holds `count` values of the i-th parameter in native
+//        LLVM format, each at a stride of the parameter's buffer size.
+//   outputs: array of pointers to output buffers in the same form.
+//   count: the number of samples.
+// Events of all samples are recorded in `events`. Always returns 0.
+using JitBatchedFunctionType = int64_t (*)(const uint8_t* const* inputs,
+                                           uint8_t* const* outputs,
+                                           void* temp_buffer,
+                                           InterpreterEvents* events,
+                                           void* user_data,
+                                           JitRuntime* jit_runtime,
+                                           int64_t count);
+
 // Abstraction holding function pointers and metadata about a jitted function
 // implementing a XLS Function, Proc, etc.
 struct JittedFunctionBase {
@@ -69,6 +89,12 @@ struct JittedFunctionBase {
   std::optional<std::string> packed_function_name;
   std::optional<JitFunctionType> packed_function;
 
+  // Name and function pointer for the jitted function which evaluates a batch
+  // of samples with arguments/results in LLVM native format. Only exists for
+  // JITted xls::Functions, not procs.
+  std::optional<std::string> batched_function_name;
+  std::optional<JitBatchedFunctionType> batched_function;
+
   // Sizes of the inputs/outputs in native LLVM format for `function_base`.
   std::vector<int64_t> input_buffer_sizes;
   std::vector<int64_t> output_buffer_sizes;
@@ -86,15 +112,30 @@ struct JittedFunctionBase {
 };
 
 // Builds and returns an LLVM IR function implementing the given XLS
-// function.
-absl::StatusOr<JittedFunctionBase> BuildFunction(Function* xls_function,
-                                                 OrcJit& orc_jit);
+// function. If `build_batched_wrapper` is true, also builds the entry point
+// which evaluates many samples in one call (`batched_function`).
+absl::StatusOr<JittedFunctionBase> BuildFunction(
+    Function* xls_function, OrcJit& orc_jit,
+    bool build_batched_wrapper = false);
 
 // Builds and returns an LLVM IR function implementing the given XLS
-// proc.
+// proc. Channel operations access the queues of `queue_mgr` directly. If
+// `queue_mgr` is null, the generated code instead accesses channels through the
+// aot_compile::ProcChannelCallbacks passed as the `user_data` argument and
+// embeds no host addresses so it may be compiled ahead of time.
 absl::StatusOr<JittedFunctionBase> BuildProcFunction(
     Proc* proc, JitChannelQueueManager* queue_mgr, OrcJit& orc_jit);
 
+// Builds and returns an LLVM IR function implementing a single clock cycle of
+// the given XLS block. The inputs of the jitted function are the input ports
+// (in order) followed by the current register values (in the order of
+// Block::GetRegisters). The outputs are the values of the output ports
+// followed by the next register values. On entry the next register value
+// buffers must hold the current register values as registers which are not
+// loaded in the cycle are not written.
+absl::StatusOr<JittedFunctionBase> BuildBlockFunction(Block* block,
+                                                      OrcJit& orc_jit);
+
 }  // namespace xls
 
 #endif  // XLS_JIT_FUNCTION_BASE_JIT_H_
@@ -14,32 +14,48 @@
 
 #include "xls/jit/function_jit.h"
 
+#include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/ir/format_preference.h"
 #include "xls/ir/keyword_args.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_helpers.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/jit_runtime.h"
 
 namespace xls {
 
 absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::Create(
-    Function* xls_function, int64_t opt_level) {
-  return CreateInternal(xls_function, opt_level, /*emit_object_code=*/false);
+    Function* xls_function, int64_t opt_level, bool with_batched_entry_point) {
+  return CreateInternal(xls_function, opt_level, /*emit_object_code=*/false,
+                        JitObjectCache::GetDefault(),
+                        absl::GetFlag(FLAGS_jit_compile_threads),
+                        /*tiering=*/std::nullopt, with_batched_entry_point);
+}
+
+absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateTiered(
+    Function* xls_function, const JitTieringOptions& options) {
+  return CreateInternal(xls_function, options.initial_opt_level,
+                        /*emit_object_code=*/false,
+                        JitObjectCache::GetDefault(),
+                        absl::GetFlag(FLAGS_jit_compile_threads), options);
 }
 
 absl::StatusOr<JitObjectCode> FunctionJit::CreateObjectCode(
     Function* xls_function, int64_t opt_level) {
   XLS_ASSIGN_OR_RETURN(
       std::unique_ptr<FunctionJit> jit,
-      CreateInternal(xls_function, opt_level, /*emit_object_code=*/true));
+      CreateInternal(xls_function, opt_level, /*emit_object_code=*/true,
+                     /*object_cache=*/nullptr, /*compile_threads=*/1));
   return JitObjectCode{
       .function_name = std::string{jit->GetJittedFunctionName()},
       .object_code = jit->orc_jit_->GetObjectCode(),
@@ -50,15 +66,25 @@ absl::StatusOr<JitObjectCode> FunctionJit::CreateObjectCode(
 }
 
 absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateInternal(
-    Function* xls_function, int64_t opt_level, bool emit_object_code) {
+    Function* xls_function, int64_t opt_level, bool emit_object_code,
+    JitObjectCache* object_cache, int64_t compile_threads,
+    std::optional<JitTieringOptions> tiering, bool with_batched_entry_point) {
   auto jit = absl::WrapUnique(new FunctionJit(xls_function));
   XLS_ASSIGN_OR_RETURN(jit->orc_jit_,
-                       OrcJit::Create(opt_level, emit_object_code));
+                       OrcJit::Create(opt_level, emit_object_code,
+                                      object_cache, compile_threads));
   XLS_ASSIGN_OR_RETURN(llvm::DataLayout data_layout,
                        OrcJit::CreateDataLayout());
   jit->jit_runtime_ = std::make_unique<JitRuntime>(data_layout);
+  absl::Time start = absl::Now();
   XLS_ASSIGN_OR_RETURN(jit->jitted_function_base_,
-                       BuildFunction(xls_function, *jit->orc_jit_));
+                       BuildFunction(xls_function, *jit->orc_jit_,
+                                     with_batched_entry_point));
+  jit->tiered_jit_ = TieredJit::Create(
+      &jit->jitted_function_base_, opt_level, absl::Now() - start, tiering,
+      [xls_function, with_batched_entry_point](OrcJit& orc_jit) {
+        return BuildFunction(xls_function, orc_jit, with_batched_entry_point);
+      });
 
   // Pre-allocate argument, result, and temporary buffers.
   for (int64_t i = 0; i < xls_function->params().size(); ++i) {
@@ -71,8 +97,7 @@ absl::StatusOr<std::unique_ptr<FunctionJit>> FunctionJit::CreateInternal(
   return jit;
 }
 
-absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
-    absl::Span<const Value> args) {
+absl::Status FunctionJit::CheckArgs(absl::Span<const Value> args) const {
   absl::Span<Param* const> params = xls_function_->params();
   if (args.size() != params.size()) {
     return absl::InvalidArgumentError(absl::StrFormat(
@@ -87,6 +112,12 @@ absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
           args[i].ToString(), i, params[i]->GetType()->ToString()));
     }
   }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<InterpreterResult<Value>> FunctionJit::Run(
+    absl::Span<const Value> args) {
+  XLS_RETURN_IF_ERROR(CheckArgs(args));
 
   std::vector<Type*> param_types;
   for (const Param* param : xls_function_->params()) {
@@ -132,11 +163,82 @@ absl::Status FunctionJit::RunWithViews(absl::Span<uint8_t* const> args,
   return absl::OkStatus();
 }
 
+absl::Status FunctionJit::RunBatched(
+    absl::Span<const uint8_t* const> args_soa, int64_t count,
+    absl::Span<uint8_t> results_soa, InterpreterEvents* events) {
+  if (!has_batched_entry_point()) {
+    return absl::FailedPreconditionError(absl::StrFormat(
+        "FunctionJit for `%s` was created without a batched entry point",
+        xls_function_->name()));
+  }
+  const JittedFunctionBase& jitted_function = tiered_jit_->Invoke();
+  if (args_soa.size() != xls_function_->params().size()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Arg list has the wrong size: %d vs expected %d.",
+                        args_soa.size(), xls_function_->params().size()));
+  }
+  if (count < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid sample count: %d", count));
+  }
+  if (results_soa.size() < count * GetReturnTypeSize()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Result buffer too small - must be at least %d bytes!",
+        count * GetReturnTypeSize()));
+  }
+
+  uint8_t* output_buffers[1] = {results_soa.data()};
+  jitted_function.batched_function.value()(
+      args_soa.data(), output_buffers, temp_buffer_.data(), events,
+      /*user_data=*/nullptr, runtime(), count);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<InterpreterResult<std::vector<Value>>> FunctionJit::RunBatched(
+    absl::Span<const std::vector<Value>> args_batch) {
+  absl::Span<Param* const> params = xls_function_->params();
+  int64_t count = args_batch.size();
+
+  // Transpose the argument lists into structure-of-arrays buffers.
+  std::vector<std::vector<uint8_t>> arg_buffers;
+  std::vector<const uint8_t*> arg_buffer_ptrs;
+  for (int64_t i = 0; i < params.size(); ++i) {
+    arg_buffers.push_back(std::vector<uint8_t>(count * GetArgTypeSize(i)));
+    arg_buffer_ptrs.push_back(arg_buffers.back().data());
+  }
+  for (int64_t sample = 0; sample < count; ++sample) {
+    absl::Span<const Value> args = args_batch[sample];
+    XLS_RETURN_IF_ERROR(CheckArgs(args));
+    for (int64_t i = 0; i < params.size(); ++i) {
+      int64_t size = GetArgTypeSize(i);
+      jit_runtime_->BlitValueToBuffer(
+          args[i], params[i]->GetType(),
+          absl::MakeSpan(arg_buffers[i].data() + sample * size, size));
+    }
+  }
+
+  int64_t result_size = GetReturnTypeSize();
+  std::vector<uint8_t> result_buffer(count * result_size);
+  InterpreterEvents events;
+  XLS_RETURN_IF_ERROR(RunBatched(arg_buffer_ptrs, count,
+                                 absl::MakeSpan(result_buffer), &events));
+
+  std::vector<Value> results;
+  results.reserve(count);
+  for (int64_t sample = 0; sample < count; ++sample) {
+    results.push_back(jit_runtime_->UnpackBuffer(
+        result_buffer.data() + sample * result_size,
+        xls_function_->return_value()->GetType()));
+  }
+  return InterpreterResult<std::vector<Value>>{std::move(results),
+                                               std::move(events)};
+}
+
 void FunctionJit::InvokeJitFunction(absl::Span<uint8_t* const> arg_buffers,
                                     uint8_t* output_buffer,
                                     InterpreterEvents* events) {
   uint8_t* output_buffers[1] = {output_buffer};
-  jitted_function_base_.function(
+  tiered_jit_->Invoke().function(
       arg_buffers.data(), output_buffers, temp_buffer_.data(), events,
       /*user_data=*/nullptr, runtime(), /*continuation_point=*/0);
 }
@@ -15,6 +15,8 @@
 #ifndef XLS_JIT_FUNCTION_JIT_H_
 #define XLS_JIT_FUNCTION_JIT_H_
 
+#include <optional>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
@@ -24,8 +26,10 @@
 #include "xls/ir/value.h"
 #include "xls/ir/value_view.h"
 #include "xls/jit/function_base_jit.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/tiered_jit.h"
 
 namespace xls {
 
@@ -51,9 +55,22 @@ struct JitObjectCode {
 class FunctionJit {
  public:
   // Returns an object containing a host-compiled version of the specified XLS
-  // function.
+  // function. The compiled code is taken from (or added to) the object cache
+  // given by --jit_object_cache_dir, if any. Large functions are compiled on
+  // the number of threads given by --jit_compile_threads. RunBatched may only
+  // be called if `with_batched_entry_point` is true as building the batched
+  // entry point adds to the compile time.
   static absl::StatusOr<std::unique_ptr<FunctionJit>> Create(
-      Function* xls_function, int64_t opt_level = 3);
+      Function* xls_function, int64_t opt_level = 3,
+      bool with_batched_entry_point = false);
+
+  // As Create but the function is compiled at `options.initial_opt_level` for
+  // a quick startup and recompiled at `options.optimized_opt_level` in the
+  // background once it has been invoked `options.invocation_threshold` times.
+  // The optimized code is used as soon as it is ready.
+  static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateTiered(
+      Function* xls_function,
+      const JitTieringOptions& options = JitTieringOptions());
 
   // Returns the bytes of an object file containing the compiled XLS function.
   static absl::StatusOr<JitObjectCode> CreateObjectCode(Function* xls_function,
@@ -82,6 +99,25 @@ class FunctionJit {
                             absl::Span<uint8_t> result_buffer,
                             InterpreterEvents* events);
 
+  // Executes the compiled function on `count` samples in a single call. The
+  // arguments and results are in structure-of-arrays form: `args_soa[i]`
+  // points to `count` values of the i-th parameter in the native LLVM data
+  // layout, each at a stride of GetArgTypeSize(i) bytes, and the results are
+  // written to `results_soa` at a stride of GetReturnTypeSize() bytes. The
+  // loop over the samples is part of the jitted code which avoids the per-call
+  // overhead of RunWithViews and lets LLVM vectorize across samples. Events
+  // of all samples are accumulated in `events`. Requires the FunctionJit to
+  // have been created with a batched entry point.
+  absl::Status RunBatched(absl::Span<const uint8_t* const> args_soa,
+                          int64_t count, absl::Span<uint8_t> results_soa,
+                          InterpreterEvents* events);
+
+  // Convenience wrapper around the above which evaluates the function on each
+  // of the given argument lists and returns the results in order. The events
+  // of all samples are accumulated in the returned events.
+  absl::StatusOr<InterpreterResult<std::vector<Value>>> RunBatched(
+      absl::Span<const std::vector<Value>> args_batch);
+
   // Similar to RunWithViews(), except the arguments here are _packed_views_ -
   // views whose data elements are tightly packed, with no padding bits or bytes
   // between them. The function return value is specified as the last arg - its
@@ -103,7 +139,8 @@ class FunctionJit {
   // TODO(rspringer): Add user data support here.
   template <typename... ArgsT>
   absl::Status RunWithPackedViews(ArgsT... args) {
-    XLS_RET_CHECK(jitted_function_base_.packed_function.has_value());
+    const JittedFunctionBase& jitted_function = tiered_jit_->Invoke();
+    XLS_RET_CHECK(jitted_function.packed_function.has_value());
     uint8_t* arg_buffers[sizeof...(ArgsT)];
     uint8_t* result_buffer;
     // Walk the type tree to get each arg's data buffer into our view/arg list.
@@ -111,7 +148,7 @@ class FunctionJit {
 
     InterpreterEvents events;
     uint8_t* output_buffers[1] = {result_buffer};
-    jitted_function_base_.packed_function.value()(
+    jitted_function.packed_function.value()(
         arg_buffers, output_buffers, temp_buffer_.data(), &events,
         /*user_data=*/nullptr, runtime(), /*continuation_point=*/0);
 
@@ -121,6 +158,11 @@ class FunctionJit {
   // Returns the function that the JIT executes.
   Function* function() { return xls_function_; }
 
+  // Returns whether RunBatched may be called.
+  bool has_batched_entry_point() const {
+    return jitted_function_base_.batched_function.has_value();
+  }
+
   // Gets the size of the compiled function's arguments (or return value) in the
   // native LLVM data layout (not the packed layout).
   int64_t GetArgTypeSize(int arg_index) const {
@@ -153,11 +195,25 @@ class FunctionJit {
 
   JitRuntime* runtime() const { return jit_runtime_.get(); }
 
+  // Returns the optimization level of the code currently used and the
+  // compilation times.
+  JitStats GetJitStats() const { return tiered_jit_->GetStats(); }
+
+  // Blocks until the background optimized build of a function created with
+  // CreateTiered (if started) has completed.
+  void WaitForOptimizedBuild() { tiered_jit_->WaitForOptimizedBuild(); }
+
  private:
   explicit FunctionJit(Function* xls_function) : xls_function_(xls_function) {}
 
+  // Returns an error if `args` do not match the parameters of the function.
+  absl::Status CheckArgs(absl::Span<const Value> args) const;
+
   static absl::StatusOr<std::unique_ptr<FunctionJit>> CreateInternal(
-      Function* xls_function, int64_t opt_level, bool emit_object_code);
+      Function* xls_function, int64_t opt_level, bool emit_object_code,
+      JitObjectCache* object_cache, int64_t compile_threads,
+      std::optional<JitTieringOptions> tiering = std::nullopt,
+      bool with_batched_entry_point = false);
 
   // Builds a function which wraps the natively compiled XLS function `callee`
   // (as built by xls::BuildFunction) with another function which accepts the
@@ -215,6 +271,11 @@ class FunctionJit {
 
   JittedFunctionBase jitted_function_base_;
   std::unique_ptr<JitRuntime> jit_runtime_;
+
+  // Selects between `jitted_function_base_` and its optimized build, if tiered.
+  // Declared last so a background build completes before the other members are
+  // destroyed.
+  std::unique_ptr<TieredJit> tiered_jit_;
 };
 
 }  // namespace xls
@@ -19,15 +19,20 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
 #include "absl/random/random.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/substitute.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread.h"
 #include "xls/interpreter/channel_queue.h"
+#include "xls/interpreter/function_interpreter.h"
 #include "xls/interpreter/ir_evaluator_test_base.h"
 #include "xls/interpreter/random_value.h"
 #include "xls/ir/function_builder.h"
+#include "xls/jit/ir_builder_visitor.h"
 #include "re2/re2.h"
 
 namespace xls {
@@ -703,5 +708,273 @@ TEST(FunctionJitTest, CompoundTokenCompareError) {
               StatusIs(absl::StatusCode::kInvalidArgument,
                        testing::HasSubstr("Tokens are incomparable")));
 }
+
+TEST(FunctionJitTest, RunBatched) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[8], y: bits[8]) -> bits[8] {
+    umul.1: bits[8] = umul(x, y)
+    ret xor.2: bits[8] = xor(umul.1, x)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit, FunctionJit::Create(function, /*opt_level=*/3,
+                                    /*with_batched_entry_point=*/true));
+  ASSERT_EQ(jit->GetArgTypeSize(0), 1);
+  ASSERT_EQ(jit->GetArgTypeSize(1), 1);
+  ASSERT_EQ(jit->GetReturnTypeSize(), 1);
+
+  constexpr int64_t kCount = 1000;
+  std::vector<uint8_t> xs(kCount);
+  std::vector<uint8_t> ys(kCount);
+  for (int64_t i = 0; i < kCount; ++i) {
+    xs[i] = i;
+    ys[i] = 3 * i + 1;
+  }
+  std::vector<uint8_t> results(kCount);
+  InterpreterEvents events;
+  XLS_ASSERT_OK(jit->RunBatched({xs.data(), ys.data()}, kCount,
+                                absl::MakeSpan(results), &events));
+  for (int64_t i = 0; i < kCount; ++i) {
+    EXPECT_EQ(results[i], static_cast<uint8_t>((xs[i] * ys[i]) ^ xs[i]));
+  }
+
+  // An empty batch does nothing.
+  XLS_EXPECT_OK(jit->RunBatched({xs.data(), ys.data()}, 0,
+                                absl::Span<uint8_t>(), &events));
+
+  EXPECT_THAT(jit->RunBatched({xs.data()}, kCount, absl::MakeSpan(results),
+                              &events),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       testing::HasSubstr("Arg list has the wrong size")));
+  EXPECT_THAT(jit->RunBatched({xs.data(), ys.data()}, kCount + 1,
+                              absl::MakeSpan(results), &events),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       testing::HasSubstr("Result buffer too small")));
+
+  // The batched entry point is only built on request.
+  XLS_ASSERT_OK_AND_ASSIGN(auto unbatched_jit, FunctionJit::Create(function));
+  EXPECT_FALSE(unbatched_jit->has_batched_entry_point());
+  EXPECT_THAT(unbatched_jit->RunBatched({xs.data(), ys.data()}, kCount,
+                                        absl::MakeSpan(results), &events),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       testing::HasSubstr("without a batched entry point")));
+}
+
+TEST(FunctionJitTest, RunBatchedValuesMatchesRun) {
+  Package package("my_package");
+  std::string ir_text = R"(
+  fn f(x: bits[17], y: (bits[65], bits[3][2])) -> (bits[65], bits[17]) {
+    tuple_index.1: bits[65] = tuple_index(y, index=0)
+    tuple_index.2: bits[3][2] = tuple_index(y, index=1)
+    literal.3: bits[1] = literal(value=1)
+    array_index.4: bits[3] = array_index(tuple_index.2, indices=[literal.3])
+    zero_ext.5: bits[65] = zero_ext(x, new_bit_count=65)
+    add.6: bits[65] = add(tuple_index.1, zero_ext.5)
+    zero_ext.7: bits[17] = zero_ext(array_index.4, new_bit_count=17)
+    sub.8: bits[17] = sub(x, zero_ext.7)
+    ret tuple.9: (bits[65], bits[17]) = tuple(add.6, sub.8)
+  }
+  )";
+  XLS_ASSERT_OK_AND_ASSIGN(Function * function,
+                           Parser::ParseFunction(ir_text, &package));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit, FunctionJit::Create(function, /*opt_level=*/3,
+                                    /*with_batched_entry_point=*/true));
+
+  std::minstd_rand bitgen;
+  std::vector<std::vector<Value>> args_batch;
+  for (int64_t i = 0; i < 100; ++i) {
+    args_batch.push_back(RandomFunctionArguments(function, &bitgen));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<std::vector<Value>> results,
+                           jit->RunBatched(args_batch));
+  ASSERT_EQ(results.value.size(), args_batch.size());
+  for (int64_t i = 0; i < args_batch.size(); ++i) {
+    EXPECT_THAT(RunJitNoEvents(jit.get(), args_batch[i]),
+                IsOkAndHolds(results.value[i]));
+  }
+
+  XLS_ASSERT_OK_AND_ASSIGN(results, jit->RunBatched({}));
+  EXPECT_TRUE(results.value.empty());
+
+  EXPECT_THAT(jit->RunBatched({{Value(UBits(0, 17))}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       testing::HasSubstr("has the wrong size")));
+}
+
+TEST(FunctionJitTest, RunBatchedAccumulatesEvents) {
+  Package p("assert_test");
+  FunctionBuilder b("fun", &p);
+  BValue x = b.Param("x", p.GetBitsType(8));
+  BValue assertion = b.Assert(b.AfterAll({}), b.ULt(x, b.Literal(UBits(5, 8))),
+                              "x is too big");
+  b.Trace(assertion, b.Literal(UBits(1, 1)), {x}, "x is {}");
+  b.Identity(x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit, FunctionJit::Create(f, /*opt_level=*/3,
+                                    /*with_batched_entry_point=*/true));
+
+  std::vector<std::vector<Value>> args_batch;
+  for (int64_t i = 0; i < 8; ++i) {
+    args_batch.push_back({Value(UBits(i, 8))});
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(InterpreterResult<std::vector<Value>> results,
+                           jit->RunBatched(args_batch));
+  EXPECT_EQ(results.value.size(), 8);
+  EXPECT_EQ(results.events.trace_msgs.size(), 8);
+  EXPECT_EQ(results.events.trace_msgs.front(), "x is 0");
+  EXPECT_EQ(results.events.trace_msgs.back(), "x is 7");
+  EXPECT_THAT(results.events.assert_msgs,
+              testing::ElementsAre("x is too big", "x is too big",
+                                   "x is too big"));
+}
+
+TEST(FunctionJitTest, ConcurrentCompile) {
+  Package p("concurrent_compile");
+  // A callee invoked by the top-level function.
+  FunctionBuilder callee_builder("callee", &p);
+  {
+    BValue x = callee_builder.Param("x", p.GetBitsType(32));
+    BValue y = callee_builder.Param("y", p.GetBitsType(32));
+    callee_builder.Add(callee_builder.UMul(x, y), y);
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * callee, callee_builder.Build());
+
+  // A top-level function large enough to be split into many partitions.
+  FunctionBuilder b("top", &p);
+  BValue x = b.Param("x", p.GetBitsType(32));
+  BValue y = b.Param("y", p.GetBitsType(32));
+  BValue acc = x;
+  for (int64_t i = 0; i < 1000; ++i) {
+    acc = b.Xor(b.Add(acc, b.Literal(UBits(i, 32))), y);
+    if (i % 100 == 0) {
+      acc = b.Invoke({acc, y}, callee);
+    }
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+
+  XLS_ASSERT_OK_AND_ASSIGN(auto serial_jit, FunctionJit::Create(f));
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_jit_compile_threads, 4);
+  XLS_ASSERT_OK_AND_ASSIGN(auto concurrent_jit, FunctionJit::Create(f));
+
+  std::minstd_rand bitgen;
+  for (int64_t i = 0; i < 16; ++i) {
+    std::vector<Value> args = RandomFunctionArguments(f, &bitgen);
+    XLS_ASSERT_OK_AND_ASSIGN(Value expected,
+                             RunJitNoEvents(serial_jit.get(), args));
+    EXPECT_THAT(RunJitNoEvents(concurrent_jit.get(), args),
+                IsOkAndHolds(expected));
+  }
+}
+
+TEST(FunctionJitTest, TieredCompilation) {
+  Package p("tiered");
+  FunctionBuilder b("f", &p);
+  BValue x = b.Param("x", p.GetBitsType(32));
+  BValue y = b.Param("y", p.GetBitsType(32));
+  b.Add(b.UMul(x, y), y);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit, FunctionJit::CreateTiered(
+                    f, JitTieringOptions{.initial_opt_level = 0,
+                                         .optimized_opt_level = 3,
+                                         .invocation_threshold = 2}));
+  std::vector<Value> args = {Value(UBits(6, 32)), Value(UBits(7, 32))};
+
+  EXPECT_THAT(RunJitNoEvents(jit.get(), args),
+              IsOkAndHolds(Value(UBits(49, 32))));
+  JitStats stats = jit->GetJitStats();
+  EXPECT_EQ(stats.opt_level, 0);
+  EXPECT_EQ(stats.invocation_count, 1);
+  EXPECT_FALSE(stats.optimized_compile_time.has_value());
+
+  // The second invocation starts the optimized build.
+  EXPECT_THAT(RunJitNoEvents(jit.get(), args),
+              IsOkAndHolds(Value(UBits(49, 32))));
+  jit->WaitForOptimizedBuild();
+  stats = jit->GetJitStats();
+  EXPECT_EQ(stats.opt_level, 3);
+  EXPECT_EQ(stats.invocation_count, 2);
+  EXPECT_TRUE(stats.optimized_compile_time.has_value());
+
+  EXPECT_THAT(RunJitNoEvents(jit.get(), args),
+              IsOkAndHolds(Value(UBits(49, 32))));
+  EXPECT_EQ(jit->GetJitStats().invocation_count, 3);
+}
+
+TEST(FunctionJitTest, WaitForOptimizedBuildFromOtherThreads) {
+  Package p("tiered");
+  FunctionBuilder b("f", &p);
+  BValue x = b.Param("x", p.GetBitsType(32));
+  b.Negate(x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+  XLS_ASSERT_OK_AND_ASSIGN(
+      auto jit, FunctionJit::CreateTiered(
+                    f, JitTieringOptions{.initial_opt_level = 0,
+                                         .optimized_opt_level = 1,
+                                         .invocation_threshold = 1}));
+  // The waiting threads race with the invocation which starts the optimized
+  // build.
+  std::vector<std::unique_ptr<Thread>> waiters;
+  for (int64_t i = 0; i < 4; ++i) {
+    waiters.push_back(std::make_unique<Thread>([&jit]() {
+      while (jit->GetJitStats().opt_level != 1) {
+        jit->WaitForOptimizedBuild();
+      }
+    }));
+  }
+  EXPECT_THAT(RunJitNoEvents(jit.get(), {Value(UBits(1, 32))}),
+              IsOkAndHolds(Value(UBits(0xffffffff, 32))));
+  for (std::unique_ptr<Thread>& waiter : waiters) {
+    waiter->Join();
+  }
+  EXPECT_EQ(jit->GetJitStats().opt_level, 1);
+}
+
+TEST(FunctionJitTest, WideArithmetic) {
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_jit_wide_arithmetic, true);
+  // Widths which are lowered with word-level code. 3000 bits is wide enough to
+  // use Karatsuba multiplication.
+  for (int64_t width : {200, 256, 3000}) {
+    Package p("wide_arithmetic");
+    FunctionBuilder b("f", &p);
+    BValue x = b.Param("x", p.GetBitsType(width));
+    BValue y = b.Param("y", p.GetBitsType(width));
+    BValue narrow = b.Param("narrow", p.GetBitsType(70));
+    BValue amount = b.Param("amount", p.GetBitsType(16));
+    BValue wide_narrow = b.ZeroExtend(narrow, width);
+    b.Tuple({b.UMul(x, y), b.SMul(x, y), b.SMul(x, narrow, width),
+             b.UMul(narrow, narrow, width), b.UDiv(x, y),
+             b.UDiv(x, wide_narrow), b.AddBinOp(Op::kUMod, x, y),
+             b.AddBinOp(Op::kUMod, x, wide_narrow), b.Shll(x, amount),
+             b.Shrl(x, amount), b.Shra(x, amount)});
+    XLS_ASSERT_OK_AND_ASSIGN(Function * f, b.Build());
+    XLS_ASSERT_OK_AND_ASSIGN(auto jit, FunctionJit::Create(f));
+
+    std::minstd_rand bitgen;
+    for (int64_t i = 0; i < 32; ++i) {
+      std::vector<Value> args = RandomFunctionArguments(f, &bitgen);
+      if (i == 0) {
+        // Division by zero.
+        args[1] = Value(UBits(0, width));
+        args[2] = Value(UBits(0, 70));
+      } else if (i % 2 == 0) {
+        // Shift amounts within the width of the value.
+        args[3] = Value(UBits(bitgen() % width, 16));
+      }
+      XLS_ASSERT_OK_AND_ASSIGN(
+          Value expected, DropInterpreterEvents(InterpretFunction(f, args)));
+      EXPECT_THAT(RunJitNoEvents(jit.get(), args), IsOkAndHolds(expected))
+          << "width: " << width;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace xls
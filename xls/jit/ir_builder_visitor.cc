@@ -13,16 +13,21 @@
 // limitations under the License.
 #include "xls/jit/ir_builder_visitor.h"
 
+#include <cstddef>
+
 #include "absl/base/config.h"  // IWYU pragma: keep
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/types/span.h"
 #include "llvm/include/llvm/IR/Constants.h"
 #include "llvm/include/llvm/IR/DerivedTypes.h"
 #include "llvm/include/llvm/IR/IRBuilder.h"
 #include "llvm/include/llvm/IR/Instructions.h"
+#include "llvm/include/llvm/IR/Intrinsics.h"
 #include "llvm/include/llvm/IR/LLVMContext.h"
 #include "llvm/include/llvm/IR/Module.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/math_util.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/dfs_visitor.h"
 #include "xls/ir/events.h"
@@ -31,9 +36,17 @@
 #include "xls/ir/nodes.h"
 #include "xls/ir/value_helpers.h"
 #include "xls/jit/jit_channel_queue.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/llvm_type_converter.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/proc_channel_callbacks.h"
+#include "xls/jit/wide_arithmetic.h"
+
+ABSL_FLAG(bool, jit_wide_arithmetic, true,
+          "If true, multiplies, divides and shifts of values wider than 128 "
+          "bits are lowered to word-level code in the JIT rather than to "
+          "LLVM operations on wide integer types.");
 
 namespace xls {
 
@@ -199,6 +212,159 @@ std::vector<std::string> ConcatVectors(absl::Span<const std::string> a,
   return result;
 }
 
+// LLVM integer operations up to this width are lowered by LLVM to efficient
+// word-level code (inline or via compiler-rt). Wider multiplies, divides and
+// variable shifts are expanded generically (e.g., bit-serial division loops or
+// long select chains) so the JIT lowers them to word-level code itself.
+constexpr int64_t kMaxNativeArithmeticBitCount = 128;
+
+// Returns whether an operation on LLVM integers of the given width should use
+// the word-level lowering.
+bool UseWideArithmetic(int64_t llvm_bit_count) {
+  return llvm_bit_count > kMaxNativeArithmeticBitCount &&
+         absl::GetFlag(FLAGS_jit_wide_arithmetic);
+}
+
+// Returns the LLVM integer type holding `word_count` 64-bit words.
+llvm::IntegerType* GetWordsType(int64_t word_count,
+                                llvm::IRBuilder<>* builder) {
+  return builder->getIntNTy(64 * word_count);
+}
+
+// Zero-extends the given integer value to `word_count` 64-bit words and stores
+// it in a newly allocated stack buffer. Returns the buffer.
+llvm::Value* StoreAsWords(llvm::Value* value, int64_t word_count,
+                          llvm::IRBuilder<>* builder) {
+  llvm::Type* words_type = GetWordsType(word_count, builder);
+  llvm::Value* buffer = builder->CreateAlloca(words_type);
+  builder->CreateStore(builder->CreateZExt(value, words_type), buffer);
+  return buffer;
+}
+
+// Emits a call to the wide arithmetic kernel with the given name (see
+// wide_arithmetic.h). The word count is appended to the given pointer
+// arguments.
+void CallWideArithmeticKernel(std::string_view name,
+                              absl::Span<llvm::Value* const> buffers,
+                              int64_t word_count,
+                              llvm::IRBuilder<>* builder) {
+  std::vector<llvm::Type*> params(
+      buffers.size(), llvm::PointerType::get(builder->getContext(), 0));
+  params.push_back(builder->getInt64Ty());
+  llvm::FunctionType* fn_type = llvm::FunctionType::get(
+      builder->getVoidTy(), params, /*isVarArg=*/false);
+  llvm::FunctionCallee kernel =
+      builder->GetInsertBlock()->getModule()->getOrInsertFunction(
+          llvm::StringRef(name.data(), name.size()), fn_type);
+  std::vector<llvm::Value*> args(buffers.begin(), buffers.end());
+  args.push_back(builder->getInt64(word_count));
+  builder->CreateCall(kernel, args);
+}
+
+// Emits a word-level multiply of the given integers which must have the same
+// type. The result is the product truncated to that type.
+llvm::Value* EmitWideMul(llvm::Value* lhs, llvm::Value* rhs,
+                         llvm::IRBuilder<>* builder) {
+  int64_t word_count =
+      CeilOfRatio(int64_t{lhs->getType()->getIntegerBitWidth()}, int64_t{64});
+  llvm::Type* words_type = GetWordsType(word_count, builder);
+  llvm::Value* result = builder->CreateAlloca(words_type);
+  CallWideArithmeticKernel(kWideUMulSymbol,
+                           {StoreAsWords(lhs, word_count, builder),
+                            StoreAsWords(rhs, word_count, builder), result},
+                           word_count, builder);
+  return builder->CreateTrunc(builder->CreateLoad(words_type, result),
+                              lhs->getType());
+}
+
+// Emits a word-level unsigned division of the given integers which must have
+// the same type. Returns the quotient if `is_div` is true and the remainder
+// otherwise. Division by zero has XLS semantics (the quotient is all ones and
+// the remainder is zero).
+llvm::Value* EmitWideUDivMod(llvm::Value* lhs, llvm::Value* rhs, bool is_div,
+                             llvm::IRBuilder<>* builder) {
+  int64_t word_count =
+      CeilOfRatio(int64_t{lhs->getType()->getIntegerBitWidth()}, int64_t{64});
+  llvm::Type* words_type = GetWordsType(word_count, builder);
+  llvm::Value* quotient = builder->CreateAlloca(words_type);
+  llvm::Value* remainder = builder->CreateAlloca(words_type);
+  CallWideArithmeticKernel(
+      kWideUDivModSymbol,
+      {StoreAsWords(lhs, word_count, builder),
+       StoreAsWords(rhs, word_count, builder), quotient, remainder},
+      word_count, builder);
+  return builder->CreateTrunc(
+      builder->CreateLoad(words_type, is_div ? quotient : remainder),
+      lhs->getType());
+}
+
+// Emits a word-level shift of `value` by `amount` which must have the same
+// type, a multiple of 64 bits wide, and `amount` must be less than the width.
+// Each result word is a funnel shift of the two source words selected by the
+// word part of the shift amount. The source words are loaded with a dynamic
+// index from a stack buffer holding the value's words and a word of fill
+// (zero or sign) bits for each shifted-in word.
+llvm::Value* EmitWideShift(Op op, llvm::Value* value, llvm::Value* amount,
+                           llvm::IRBuilder<>* builder) {
+  int64_t bit_count = value->getType()->getIntegerBitWidth();
+  XLS_CHECK_EQ(bit_count % 64, 0);
+  int64_t word_count = bit_count / 64;
+  llvm::Type* word_type = builder->getInt64Ty();
+  llvm::Type* buffer_type = llvm::ArrayType::get(word_type, 2 * word_count);
+  llvm::Value* buffer = builder->CreateAlloca(buffer_type);
+  auto word_ptr = [&](llvm::Value* index) {
+    return builder->CreateGEP(buffer_type, buffer,
+                              {builder->getInt64(0), index});
+  };
+
+  // Left shifts shift in fill words from below the value; right shifts from
+  // above.
+  llvm::Value* fill = builder->getInt64(0);
+  if (op == Op::kShra) {
+    fill = builder->CreateTrunc(builder->CreateAShr(value, bit_count - 1),
+                                word_type);
+  }
+  int64_t value_offset = op == Op::kShll ? word_count : 0;
+  int64_t fill_offset = op == Op::kShll ? 0 : word_count;
+  for (int64_t i = 0; i < word_count; ++i) {
+    builder->CreateStore(
+        builder->CreateTrunc(builder->CreateLShr(value, 64 * i), word_type),
+        word_ptr(builder->getInt64(value_offset + i)));
+    builder->CreateStore(fill, word_ptr(builder->getInt64(fill_offset + i)));
+  }
+
+  llvm::Value* amount_word = builder->CreateTrunc(amount, word_type);
+  llvm::Value* word_shift = builder->CreateLShr(amount_word, 6);
+  llvm::Value* bit_shift = builder->CreateAnd(amount_word, 63);
+  llvm::Value* result = llvm::ConstantInt::get(value->getType(), 0);
+  for (int64_t i = 0; i < word_count; ++i) {
+    llvm::Value* word;
+    if (op == Op::kShll) {
+      llvm::Value* hi_index =
+          builder->CreateSub(builder->getInt64(word_count + i), word_shift);
+      llvm::Value* lo_index =
+          builder->CreateSub(hi_index, builder->getInt64(1));
+      word = builder->CreateIntrinsic(
+          llvm::Intrinsic::fshl, {word_type},
+          {builder->CreateLoad(word_type, word_ptr(hi_index)),
+           builder->CreateLoad(word_type, word_ptr(lo_index)), bit_shift});
+    } else {
+      llvm::Value* lo_index =
+          builder->CreateAdd(builder->getInt64(i), word_shift);
+      llvm::Value* hi_index =
+          builder->CreateAdd(lo_index, builder->getInt64(1));
+      word = builder->CreateIntrinsic(
+          llvm::Intrinsic::fshr, {word_type},
+          {builder->CreateLoad(word_type, word_ptr(hi_index)),
+           builder->CreateLoad(word_type, word_ptr(lo_index)), bit_shift});
+    }
+    result = builder->CreateOr(
+        result, builder->CreateShl(builder->CreateZExt(word, value->getType()),
+                                   64 * i));
+  }
+  return result;
+}
+
 // Emit an LLVM shift operation corresponding to the semantics of the given XLS
 // op.
 llvm::Value* EmitShiftOp(Node* shift, llvm::Value* lhs, llvm::Value* rhs,
@@ -232,9 +398,7 @@ llvm::Value* EmitShiftOp(Node* shift, llvm::Value* lhs, llvm::Value* rhs,
   // (selected in the Select instruction) so correctness is not affected.
   llvm::Value* safe_rhs = builder->CreateSelect(is_overshift, zero, wide_rhs);
 
-  if (op == Op::kShll) {
-    inst = builder->CreateShl(wide_lhs, safe_rhs);
-  } else if (op == Op::kShra) {
+  if (op == Op::kShra) {
     llvm::Value* high_bit = builder->CreateLShr(
         wide_lhs,
         llvm::ConstantInt::get(dest_type,
@@ -243,6 +407,15 @@ llvm::Value* EmitShiftOp(Node* shift, llvm::Value* lhs, llvm::Value* rhs,
         builder->CreateICmpEQ(high_bit, llvm::ConstantInt::get(dest_type, 1));
     overshift_value = builder->CreateSelect(
         high_bit_set, llvm::ConstantInt::getSigned(dest_type, -1), zero);
+  }
+
+  // Shifts by a literal amount are folded by LLVM so only variable shifts
+  // benefit from the word-level lowering.
+  if (UseWideArithmetic(common_width) && !shift->operand(1)->Is<Literal>()) {
+    inst = EmitWideShift(op, wide_lhs, safe_rhs, builder);
+  } else if (op == Op::kShll) {
+    inst = builder->CreateShl(wide_lhs, safe_rhs);
+  } else if (op == Op::kShra) {
     inst = builder->CreateAShr(wide_lhs, safe_rhs);
   } else {
     XLS_CHECK_EQ(op, Op::kShrl);
@@ -415,6 +588,18 @@ llvm::Value* ClampIndexInBounds(llvm::Value* index, ArrayType* array_type,
   return inbounds_index;
 }
 
+// Returns an i64 constant holding the given host address, e.g., of one of the
+// shims below or of a channel queue. Object code containing a host address is
+// only valid in the process which generated it so the module is marked to keep
+// it out of the JIT object cache.
+template <typename T>
+llvm::ConstantInt* HostAddressConstant(T* address,
+                                       llvm::IRBuilder<>* builder) {
+  JitObjectCache::MarkEmbedsHostAddresses(
+      *builder->GetInsertBlock()->getModule());
+  return builder->getInt64(absl::bit_cast<uint64_t>(address));
+}
+
 // This is a shim to let JIT code add a new trace fragment to an existing trace
 // buffer.
 void PerformStringStep(char* step_string, std::string* buffer) {
@@ -437,9 +622,7 @@ absl::Status InvokeStringStepCallback(llvm::IRBuilder<>* builder,
 
   std::vector<llvm::Value*> args = {step_constant, buffer_ptr};
 
-  llvm::ConstantInt* fn_addr =
-      llvm::ConstantInt::get(llvm::Type::getInt64Ty(builder->getContext()),
-                             absl::bit_cast<uint64_t>(&PerformStringStep));
+  llvm::ConstantInt* fn_addr = HostAddressConstant(&PerformStringStep, builder);
   llvm::Value* fn_ptr =
       builder->CreateIntToPtr(fn_addr, llvm::PointerType::get(fn_type, 0));
   builder->CreateCall(fn_type, fn_ptr, args);
@@ -472,7 +655,7 @@ absl::Status InvokeFormatStepCallback(llvm::IRBuilder<>* builder,
   // capturing this type pointer as a value burned into the JIT code, which
   // should always be true.
   llvm::ConstantInt* llvm_operand_type =
-      llvm::ConstantInt::get(i64_type, absl::bit_cast<uint64_t>(operand_type));
+      HostAddressConstant(operand_type, builder);
 
   std::vector<llvm::Type*> params = {
       jit_runtime_ptr->getType(), llvm_operand_type->getType(),
@@ -483,8 +666,7 @@ absl::Status InvokeFormatStepCallback(llvm::IRBuilder<>* builder,
   std::vector<llvm::Value*> args = {jit_runtime_ptr, llvm_operand_type, operand,
                                     llvm_format, buffer_ptr};
 
-  llvm::ConstantInt* fn_addr = llvm::ConstantInt::get(
-      i64_type, absl::bit_cast<uint64_t>(&PerformFormatStep));
+  llvm::ConstantInt* fn_addr = HostAddressConstant(&PerformFormatStep, builder);
   llvm::Value* fn_ptr =
       builder->CreateIntToPtr(fn_addr, llvm::PointerType::get(fn_type, 0));
   builder->CreateCall(fn_type, fn_ptr, args);
@@ -512,9 +694,7 @@ absl::Status InvokeRecordTraceCallback(llvm::IRBuilder<>* builder,
 
   std::vector<llvm::Value*> args = {buffer_ptr, interpreter_events_ptr};
 
-  llvm::ConstantInt* fn_addr =
-      llvm::ConstantInt::get(llvm::Type::getInt64Ty(builder->getContext()),
-                             absl::bit_cast<uint64_t>(&RecordTrace));
+  llvm::ConstantInt* fn_addr = HostAddressConstant(&RecordTrace, builder);
   llvm::Value* fn_ptr =
       builder->CreateIntToPtr(fn_addr, llvm::PointerType::get(fn_type, 0));
   builder->CreateCall(fn_type, fn_ptr, args);
@@ -537,9 +717,7 @@ absl::StatusOr<llvm::Value*> InvokeCreateBufferCallback(
 
   std::vector<llvm::Value*> args;
 
-  llvm::ConstantInt* fn_addr =
-      llvm::ConstantInt::get(llvm::Type::getInt64Ty(builder->getContext()),
-                             absl::bit_cast<uint64_t>(&CreateTraceBuffer));
+  llvm::ConstantInt* fn_addr = HostAddressConstant(&CreateTraceBuffer, builder);
   llvm::Value* fn_ptr =
       builder->CreateIntToPtr(fn_addr, llvm::PointerType::get(fn_type, 0));
   return builder->CreateCall(fn_type, fn_ptr, args);
@@ -570,9 +748,7 @@ absl::Status InvokeAssertCallback(llvm::IRBuilder<>* builder,
 
   std::vector<llvm::Value*> args = {msg_constant, interpreter_events_ptr};
 
-  llvm::ConstantInt* fn_addr =
-      llvm::ConstantInt::get(llvm::Type::getInt64Ty(builder->getContext()),
-                             absl::bit_cast<uint64_t>(&RecordAssertion));
+  llvm::ConstantInt* fn_addr = HostAddressConstant(&RecordAssertion, builder);
   llvm::Value* fn_ptr =
       builder->CreateIntToPtr(fn_addr, llvm::PointerType::get(fn_type, 0));
   builder->CreateCall(fn_type, fn_ptr, args);
@@ -927,8 +1103,10 @@ class IrBuilderVisitor : public DfsVisitorWithDefault {
   absl::Status HandleOneHot(OneHot* one_hot) override;
   absl::Status HandleOneHotSel(OneHotSelect* sel) override;
   absl::Status HandleOrReduce(BitwiseReductionOp* op) override;
+  absl::Status HandleOutputPort(OutputPort* output_port) override;
   absl::Status HandlePrioritySel(PrioritySelect* sel) override;
   absl::Status HandleReceive(Receive* recv) override;
+  absl::Status HandleRegisterWrite(RegisterWrite* reg_write) override;
   absl::Status HandleReverse(UnOp* reverse) override;
   absl::Status HandleSDiv(BinOp* binop) override;
   absl::Status HandleSGe(CompareOp* ge) override;
@@ -1030,6 +1208,23 @@ class IrBuilderVisitor : public DfsVisitorWithDefault {
       llvm::Value* events, llvm::Value* user_data, llvm::Value* runtime,
       llvm::IRBuilder<>& builder);
 
+  // Returns the JIT queue of the given channel or nullptr if the function is
+  // built without a queue manager. In the latter case channels are accessed
+  // through the ProcChannelCallbacks passed as the user data argument (see
+  // aot_runtime.h).
+  JitChannelQueue* GetJitQueue(Channel* channel) {
+    if (!jit_context_.queue_manager().has_value()) {
+      return nullptr;
+    }
+    return &jit_context_.queue_manager().value()->GetJitQueue(channel);
+  }
+
+  // Loads the field at the given byte offset of the ProcChannelCallbacks
+  // pointed to by `user_data`.
+  llvm::Value* LoadChannelCallbacksField(llvm::IRBuilder<>* builder,
+                                         llvm::Value* user_data,
+                                         int64_t offset);
+
   // Invokes the receive callback function. The received data is written into
   // the buffer pointer to be `output_ptr`. Returns an i1 value indicating
   // whether the receive fired.
@@ -1965,6 +2160,11 @@ absl::Status IrBuilderVisitor::HandleSMul(ArithOp* mul) {
   return HandleBinaryOpWithOperandConversion(
       mul,
       [](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
+        // The operands are extended to the result width so the low bits of
+        // the product are the same for signed and unsigned multiplies.
+        if (UseWideArithmetic(lhs->getType()->getIntegerBitWidth())) {
+          return EmitWideMul(lhs, rhs, &b);
+        }
         return b.CreateMul(lhs, rhs);
       },
       /*is_signed=*/true);
@@ -1974,6 +2174,11 @@ absl::Status IrBuilderVisitor::HandleUMul(ArithOp* mul) {
   return HandleBinaryOpWithOperandConversion(
       mul,
       [](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
+        // The operands are extended to the result width so the low bits of
+        // the product are the same for signed and unsigned multiplies.
+        if (UseWideArithmetic(lhs->getType()->getIntegerBitWidth())) {
+          return EmitWideMul(lhs, rhs, &b);
+        }
         return b.CreateMul(lhs, rhs);
       },
       /*is_signed=*/false);
@@ -2330,6 +2535,18 @@ absl::Status IrBuilderVisitor::HandleOrReduce(BitwiseReductionOp* op) {
   });
 }
 
+absl::Status IrBuilderVisitor::HandleOutputPort(OutputPort* output_port) {
+  // The value driving the port is an output of the jitted block function so
+  // the port itself computes nothing. Like register writes, output ports have
+  // empty tuple types.
+  XLS_ASSIGN_OR_RETURN(NodeIrContext node_context,
+                       NewNodeIrContext(output_port, {"operand"}));
+  XLS_ASSIGN_OR_RETURN(llvm::Constant * empty_tuple,
+                       type_converter()->ToLlvmConstant(output_port->GetType(),
+                                                        Value::Tuple({})));
+  return FinalizeNodeIrContextWithValue(std::move(node_context), empty_tuple);
+}
+
 absl::Status IrBuilderVisitor::HandleReverse(UnOp* reverse) {
   return HandleUnaryOp(
       reverse, [&](llvm::Value* operand, llvm::IRBuilder<>& b) {
@@ -2522,6 +2739,9 @@ absl::Status IrBuilderVisitor::HandleTupleIndex(TupleIndex* index) {
 absl::Status IrBuilderVisitor::HandleUDiv(BinOp* binop) {
   return HandleBinaryOp(
       binop, [&](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
+        if (UseWideArithmetic(lhs->getType()->getIntegerBitWidth())) {
+          return EmitWideUDivMod(lhs, rhs, /*is_div=*/true, &b);
+        }
         return EmitDiv(lhs, rhs, binop->BitCountOrDie(), /*is_signed=*/false,
                        type_converter(), &b);
       });
@@ -2530,6 +2750,9 @@ absl::Status IrBuilderVisitor::HandleUDiv(BinOp* binop) {
 absl::Status IrBuilderVisitor::HandleUMod(BinOp* binop) {
   return HandleBinaryOp(
       binop, [&](llvm::Value* lhs, llvm::Value* rhs, llvm::IRBuilder<>& b) {
+        if (UseWideArithmetic(lhs->getType()->getIntegerBitWidth())) {
+          return EmitWideUDivMod(lhs, rhs, /*is_div=*/false, &b);
+        }
         return EmitMod(lhs, rhs, /*is_signed=*/false, &b);
       });
 }
@@ -2731,12 +2954,36 @@ bool QueueReceiveWrapper(JitChannelQueue* queue, uint8_t* buffer) {
   return queue->ReadRaw(buffer);
 }
 
+llvm::Value* IrBuilderVisitor::LoadChannelCallbacksField(
+    llvm::IRBuilder<>* builder, llvm::Value* user_data, int64_t offset) {
+  llvm::Type* ptr_type = llvm::PointerType::get(ctx(), 0);
+  return builder->CreateLoad(
+      ptr_type, builder->CreateConstInBoundsGEP1_64(builder->getInt8Ty(),
+                                                    user_data, offset));
+}
+
 absl::StatusOr<llvm::Value*> IrBuilderVisitor::ReceiveFromQueue(
     llvm::IRBuilder<>* builder, JitChannelQueue* queue, Receive* receive,
     llvm::Value* output_ptr, llvm::Value* user_data) {
   llvm::Type* bool_type = llvm::Type::getInt1Ty(ctx());
   llvm::Type* ptr_type = llvm::PointerType::get(ctx(), 0);
 
+  if (queue == nullptr) {
+    // Call ProcChannelCallbacks::receive.
+    llvm::FunctionType* fn_type = llvm::FunctionType::get(
+        bool_type, {ptr_type, builder->getInt64Ty(), ptr_type},
+        /*isVarArg=*/false);
+    llvm::Value* fn_ptr = LoadChannelCallbacksField(
+        builder, user_data,
+        offsetof(aot_compile::ProcChannelCallbacks, receive));
+    llvm::Value* context = LoadChannelCallbacksField(
+        builder, user_data,
+        offsetof(aot_compile::ProcChannelCallbacks, context));
+    return builder->CreateCall(
+        fn_type, fn_ptr,
+        {context, builder->getInt64(receive->channel_id()), output_ptr});
+  }
+
   // Call the user-provided function of type ProcJit::RecvFnT to receive the
   // value.
   std::vector<llvm::Type*> params = {ptr_type, ptr_type};
@@ -2744,14 +2991,12 @@ absl::StatusOr<llvm::Value*> IrBuilderVisitor::ReceiveFromQueue(
       llvm::FunctionType::get(bool_type, params, /*isVarArg=*/false);
 
   // Call the wrapper to JitChannelQueue::Recv.
-  llvm::Value* queue_address = llvm::ConstantInt::get(
-      llvm::Type::getInt64Ty(ctx()), absl::bit_cast<uint64_t>(queue));
+  llvm::Value* queue_address = HostAddressConstant(queue, builder);
   std::vector<llvm::Value*> args = {
       builder->CreateIntToPtr(queue_address, ptr_type), output_ptr};
 
   llvm::ConstantInt* fn_addr =
-      llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx()),
-                             absl::bit_cast<uint64_t>(&QueueReceiveWrapper));
+      HostAddressConstant(&QueueReceiveWrapper, builder);
   llvm::Value* fn_ptr =
       builder->CreateIntToPtr(fn_addr, llvm::PointerType::get(fn_type, 0));
   llvm::Value* receive_fired = builder->CreateCall(fn_type, fn_ptr, args);
@@ -2768,11 +3013,9 @@ absl::Status IrBuilderVisitor::HandleReceive(Receive* recv) {
                                         /*include_wrapper_args=*/true));
   llvm::Value* user_data = node_context.GetUserDataArg();
 
-  XLS_RET_CHECK(jit_context_.queue_manager().has_value());
   XLS_ASSIGN_OR_RETURN(Channel * channel,
                        recv->package()->GetChannel(recv->channel_id()));
-  JitChannelQueue& queue =
-      jit_context_.queue_manager().value()->GetJitQueue(channel);
+  JitChannelQueue* queue = GetJitQueue(channel);
 
   llvm::Value* output_buffer = node_context.GetOutputPtr(0);
   // The data buffer is element 1 of the output tuple.
@@ -2799,7 +3042,7 @@ absl::Status IrBuilderVisitor::HandleReceive(Receive* recv) {
     llvm::IRBuilder<> true_builder(true_block);
     XLS_ASSIGN_OR_RETURN(
         llvm::Value * true_receive_fired,
-        ReceiveFromQueue(&true_builder, &queue, recv, data_buffer, user_data));
+        ReceiveFromQueue(&true_builder, queue, recv, data_buffer, user_data));
     true_builder.CreateBr(join_block);
 
     // And the same for a false predicate - this will store a zero
@@ -2844,7 +3087,7 @@ absl::Status IrBuilderVisitor::HandleReceive(Receive* recv) {
             : join_builder.getFalse());
   }
   XLS_ASSIGN_OR_RETURN(llvm::Value * receive_fired,
-                       ReceiveFromQueue(&node_context.entry_builder(), &queue,
+                       ReceiveFromQueue(&node_context.entry_builder(), queue,
                                         recv, data_buffer, user_data));
   receive_fired->setName("receive_fired");
   if (!recv->is_blocking()) {
@@ -2866,6 +3109,48 @@ absl::Status IrBuilderVisitor::HandleReceive(Receive* recv) {
           : node_context.entry_builder().getFalse());
 }
 
+absl::Status IrBuilderVisitor::HandleRegisterWrite(RegisterWrite* reg_write) {
+  std::vector<std::string> operand_names = {"data"};
+  if (reg_write->load_enable().has_value()) {
+    operand_names.push_back("load_enable");
+  }
+  if (reg_write->reset().has_value()) {
+    operand_names.push_back("reset");
+  }
+  XLS_ASSIGN_OR_RETURN(NodeIrContext node_context,
+                       NewNodeIrContext(reg_write, operand_names));
+  llvm::IRBuilder<>& b = node_context.entry_builder();
+
+  // The output buffer holds the register value. On entry it contains the
+  // current value of the register so a register which is not loaded this
+  // cycle keeps its value.
+  Register* reg = reg_write->GetRegister();
+  llvm::Value* output_buffer = node_context.GetOutputPtr(0);
+  llvm::Value* next_value = node_context.LoadOperand(0);
+  if (reg_write->load_enable().has_value()) {
+    llvm::Value* current_value = b.CreateLoad(
+        type_converter()->ConvertToLlvmType(reg->type()), output_buffer);
+    next_value = b.CreateSelect(node_context.LoadOperand(1), next_value,
+                                current_value);
+  }
+  if (reg_write->reset().has_value()) {
+    XLS_RET_CHECK(reg->reset().has_value());
+    const Reset& reset = reg->reset().value();
+    XLS_ASSIGN_OR_RETURN(
+        llvm::Constant * reset_value,
+        type_converter()->ToLlvmConstant(reg->type(), reset.reset_value));
+    llvm::Value* reset_signal = node_context.LoadOperand(
+        reg_write->load_enable().has_value() ? 2 : 1);
+    llvm::Value* reset_asserted =
+        reset.active_low ? b.CreateNot(reset_signal) : reset_signal;
+    next_value = b.CreateSelect(reset_asserted, reset_value, next_value);
+  }
+  b.CreateStore(type_converter()->ClearPaddingBits(next_value, reg->type(), b),
+                output_buffer);
+  return FinalizeNodeIrContextWithPointerToValue(std::move(node_context),
+                                                 output_buffer);
+}
+
 void QueueSendWrapper(JitChannelQueue* queue, const uint8_t* data) {
   queue->WriteRaw(data);
 }
@@ -2877,20 +3162,34 @@ absl::Status IrBuilderVisitor::SendToQueue(llvm::IRBuilder<>* builder,
   llvm::Type* void_type = llvm::Type::getVoidTy(ctx());
   llvm::Type* ptr_type = llvm::PointerType::get(ctx(), 0);
 
+  if (queue == nullptr) {
+    // Call ProcChannelCallbacks::send.
+    llvm::FunctionType* fn_type = llvm::FunctionType::get(
+        void_type, {ptr_type, builder->getInt64Ty(), ptr_type},
+        /*isVarArg=*/false);
+    llvm::Value* fn_ptr = LoadChannelCallbacksField(
+        builder, user_data,
+        offsetof(aot_compile::ProcChannelCallbacks, send));
+    llvm::Value* context = LoadChannelCallbacksField(
+        builder, user_data,
+        offsetof(aot_compile::ProcChannelCallbacks, context));
+    builder->CreateCall(
+        fn_type, fn_ptr,
+        {context, builder->getInt64(send->channel_id()), send_data_ptr});
+    return absl::OkStatus();
+  }
+
   // We do the same for sending/writing as we do for receiving/reading
   // above (set up and call an external function).
   std::vector<llvm::Type*> params = {ptr_type, ptr_type};
   llvm::FunctionType* fn_type =
       llvm::FunctionType::get(void_type, params, /*isVarArg=*/false);
 
-  llvm::Value* queue_address = llvm::ConstantInt::get(
-      llvm::Type::getInt64Ty(ctx()), absl::bit_cast<uint64_t>(queue));
+  llvm::Value* queue_address = HostAddressConstant(queue, builder);
   std::vector<llvm::Value*> args = {
       builder->CreateIntToPtr(queue_address, ptr_type), send_data_ptr};
 
-  llvm::ConstantInt* fn_addr =
-      llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx()),
-                             absl::bit_cast<uint64_t>(&QueueSendWrapper));
+  llvm::ConstantInt* fn_addr = HostAddressConstant(&QueueSendWrapper, builder);
   llvm::Value* fn_ptr =
       builder->CreateIntToPtr(fn_addr, llvm::PointerType::get(fn_type, 0));
   builder->CreateCall(fn_type, fn_ptr, args);
@@ -2909,11 +3208,9 @@ absl::Status IrBuilderVisitor::HandleSend(Send* send) {
   llvm::Value* data_ptr = node_context.GetOperandPtr(1);
   llvm::Value* user_data = node_context.GetUserDataArg();
 
-  XLS_RET_CHECK(jit_context_.queue_manager().has_value());
   XLS_ASSIGN_OR_RETURN(Channel * channel,
                        send->package()->GetChannel(send->channel_id()));
-  JitChannelQueue& queue =
-      jit_context_.queue_manager().value()->GetJitQueue(channel);
+  JitChannelQueue* queue = GetJitQueue(channel);
   if (send->predicate().has_value()) {
     llvm::Value* predicate = node_context.LoadOperand(2);
 
@@ -2927,7 +3224,7 @@ absl::Status IrBuilderVisitor::HandleSend(Send* send) {
                                  node_context.llvm_function(), join_block);
     llvm::IRBuilder<> true_builder(true_block);
     XLS_RETURN_IF_ERROR(
-        SendToQueue(&true_builder, &queue, send, data_ptr, user_data));
+        SendToQueue(&true_builder, queue, send, data_ptr, user_data));
     true_builder.CreateBr(join_block);
 
     llvm::BasicBlock* false_block =
@@ -2948,7 +3245,7 @@ absl::Status IrBuilderVisitor::HandleSend(Send* send) {
                                           /*return_value=*/predicate);
   }
   // Unconditional send.
-  XLS_RETURN_IF_ERROR(SendToQueue(&b, &queue, send, data_ptr, user_data));
+  XLS_RETURN_IF_ERROR(SendToQueue(&b, queue, send, data_ptr, user_data));
 
   // The node function should return true if data was sent. This will trigger
   // an early exit from the top-level function.
@@ -16,12 +16,15 @@
 
 #include <vector>
 
+#include "absl/flags/declare.h"
 #include "absl/status/statusor.h"
 #include "llvm/include/llvm/IR/Function.h"
 #include "xls/ir/node.h"
 #include "xls/jit/jit_channel_queue.h"
 #include "xls/jit/orc_jit.h"
 
+ABSL_DECLARE_FLAG(bool, jit_wide_arithmetic);
+
 namespace xls {
 
 // Returns whether the given node should be materialized at is uses rather than
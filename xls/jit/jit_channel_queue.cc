@@ -14,8 +14,11 @@
 
 #include "xls/jit/jit_channel_queue.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/proc.h"
 
 namespace xls {
 namespace {
@@ -83,6 +86,89 @@ void ByteQueue::Resize() {
   }
 }
 
+SpscByteQueue::SpscByteQueue(int64_t channel_element_size, int64_t capacity)
+    : channel_element_size_(channel_element_size),
+      allocated_element_size_(
+          RoundUpToNearest(channel_element_size,
+                           static_cast<int64_t>(alignof(std::max_align_t)))),
+      capacity_(int64_t{1} << CeilOfLog2(std::max(capacity, int64_t{1}))) {
+  // As in ByteQueue, zero-width elements still occupy a byte so each element
+  // has a distinct slot.
+  if (allocated_element_size_ == 0) {
+    allocated_element_size_ = 1;
+  }
+  buffer_.resize(capacity_ * allocated_element_size_);
+}
+
+int64_t SpscByteQueue::WriteN(const uint8_t* data, int64_t count) {
+#ifdef ABSL_HAVE_MEMORY_SANITIZER
+  __msan_unpoison(data, channel_element_size_ * count);
+#endif
+  const int64_t write_count = write_count_.load(std::memory_order_relaxed);
+  if (write_count + count - producer_read_count_ > capacity_) {
+    producer_read_count_ = read_count_.load(std::memory_order_acquire);
+  }
+  int64_t n = std::min(count, capacity_ - (write_count - producer_read_count_));
+  for (int64_t i = 0; i < n; ++i) {
+    memcpy(ElementAt(write_count + i), data + i * channel_element_size_,
+           channel_element_size_);
+  }
+  write_count_.store(write_count + n, std::memory_order_release);
+  return n;
+}
+
+int64_t SpscByteQueue::ReadN(uint8_t* buffer, int64_t count) {
+  const int64_t read_count = read_count_.load(std::memory_order_relaxed);
+  if (read_count + count > consumer_write_count_) {
+    consumer_write_count_ = write_count_.load(std::memory_order_acquire);
+  }
+  int64_t n = std::min(count, consumer_write_count_ - read_count);
+  for (int64_t i = 0; i < n; ++i) {
+    memcpy(buffer + i * channel_element_size_, ElementAt(read_count + i),
+           channel_element_size_);
+  }
+  read_count_.store(read_count + n, std::memory_order_release);
+  return n;
+}
+
+void JitChannelQueue::WriteRawN(const uint8_t* data, int64_t count) {
+  for (int64_t i = 0; i < count; ++i) {
+    WriteRaw(data + i * element_size_);
+  }
+}
+
+int64_t JitChannelQueue::ReadRawN(uint8_t* buffer, int64_t count) {
+  for (int64_t i = 0; i < count; ++i) {
+    if (!ReadRaw(buffer + i * element_size_)) {
+      return i;
+    }
+  }
+  return count;
+}
+
+void ThreadSafeJitChannelQueue::WriteRawN(const uint8_t* data, int64_t count) {
+  absl::MutexLock lock(&mutex_);
+  for (int64_t i = 0; i < count; ++i) {
+    byte_queue_.Write(data + i * element_size_);
+  }
+}
+
+int64_t ThreadSafeJitChannelQueue::ReadRawN(uint8_t* buffer, int64_t count) {
+  absl::MutexLock lock(&mutex_);
+  for (int64_t i = 0; i < count; ++i) {
+    if (generator_.has_value()) {
+      std::optional<Value> generated_value = (*generator_)();
+      if (generated_value.has_value()) {
+        WriteInternal(generated_value.value());
+      }
+    }
+    if (!byte_queue_.Read(buffer + i * element_size_)) {
+      return i;
+    }
+  }
+  return count;
+}
+
 int64_t ThreadSafeJitChannelQueue::GetSizeInternal() const {
   return byte_queue_.size();
 }
@@ -107,6 +193,98 @@ std::optional<Value> ThreadUnsafeJitChannelQueue::ReadInternal() {
   return ReadValueFromQueue(channel()->type(), *jit_runtime_, byte_queue_);
 }
 
+LockFreeJitChannelQueue::LockFreeJitChannelQueue(Channel* channel,
+                                                 JitRuntime* jit_runtime,
+                                                 int64_t capacity)
+    : JitChannelQueue(channel, jit_runtime),
+      byte_queue_(element_size_, capacity),
+      overflow_queue_(element_size_, /*is_single_value=*/false) {
+  XLS_CHECK_EQ(channel->kind(), ChannelKind::kStreaming)
+      << "Lock-free channel queues only support streaming channels: "
+      << channel->name();
+}
+
+void LockFreeJitChannelQueue::WriteRawN(const uint8_t* data, int64_t count) {
+  int64_t written = 0;
+  if (overflow_count_.load(std::memory_order_acquire) == 0) {
+    written = byte_queue_.WriteN(data, count);
+  }
+  if (ABSL_PREDICT_FALSE(written != count)) {
+    WriteOverflow(data + written * element_size_, count - written);
+  }
+}
+
+int64_t LockFreeJitChannelQueue::ReadRawN(uint8_t* buffer, int64_t count) {
+  if (generator_.has_value()) {
+    return JitChannelQueue::ReadRawN(buffer, count);
+  }
+  int64_t read = byte_queue_.ReadN(buffer, count);
+  if (ABSL_PREDICT_FALSE(read != count &&
+                         overflow_count_.load(std::memory_order_acquire) !=
+                             0)) {
+    read += ReadWithOverflow(buffer + read * element_size_, count - read);
+  }
+  return read;
+}
+
+void LockFreeJitChannelQueue::WriteOverflow(const uint8_t* data,
+                                            int64_t count) {
+  absl::MutexLock lock(&overflow_mutex_);
+  if (overflow_count_.load(std::memory_order_relaxed) == 0) {
+    XLS_VLOG(2) << absl::StreamFormat(
+        "Lock-free queue for channel `%s` exceeded its capacity of %d "
+        "elements; spilling to the overflow queue",
+        channel()->name(), byte_queue_.capacity());
+  }
+  for (int64_t i = 0; i < count; ++i) {
+    overflow_queue_.Write(data + i * element_size_);
+  }
+  overflow_count_.fetch_add(count, std::memory_order_release);
+}
+
+int64_t LockFreeJitChannelQueue::ReadOverflow(uint8_t* buffer,
+                                              int64_t count) {
+  absl::MutexLock lock(&overflow_mutex_);
+  int64_t read = 0;
+  while (read < count && overflow_queue_.Read(buffer + read * element_size_)) {
+    ++read;
+  }
+  overflow_count_.fetch_sub(read, std::memory_order_release);
+  return read;
+}
+
+int64_t LockFreeJitChannelQueue::ReadWithOverflow(uint8_t* buffer,
+                                                  int64_t count) {
+  int64_t read = byte_queue_.ReadN(buffer, count);
+  if (read != count) {
+    read += ReadOverflow(buffer + read * element_size_, count - read);
+  }
+  return read;
+}
+
+int64_t LockFreeJitChannelQueue::GetSizeInternal() const {
+  return byte_queue_.size() + overflow_count_.load(std::memory_order_acquire);
+}
+
+void LockFreeJitChannelQueue::WriteInternal(const Value& value) {
+  absl::InlinedVector<uint8_t, ByteQueue::kInitBufferSize> buffer(
+      element_size_);
+  jit_runtime_->BlitValueToBuffer(value, channel()->type(),
+                                  absl::MakeSpan(buffer));
+  WriteRaw(buffer.data());
+}
+
+std::optional<Value> LockFreeJitChannelQueue::ReadInternal() {
+  std::vector<uint8_t> buffer(element_size_);
+  if (!byte_queue_.Read(buffer.data()) &&
+      (overflow_count_.load(std::memory_order_acquire) == 0 ||
+       ReadWithOverflow(buffer.data(), 1) != 1)) {
+    return std::nullopt;
+  }
+  return jit_runtime_->UnpackBuffer(buffer.data(), channel()->type(),
+                                    /*unpoision=*/true);
+}
+
 /* static */ absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
 JitChannelQueueManager::CreateThreadSafe(Package* package) {
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<JitRuntime> runtime,
@@ -133,6 +311,41 @@ JitChannelQueueManager::CreateThreadUnsafe(Package* package) {
                                                      std::move(runtime)));
 }
 
+/* static */ absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
+JitChannelQueueManager::CreateLockFree(Package* package, int64_t capacity) {
+  XLS_RET_CHECK_GT(capacity, 0);
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<JitRuntime> runtime,
+                       JitRuntime::Create());
+  // Lock-free queues are only safe with a single producer and a single
+  // consumer, so find the channels which are sent or received on by more than
+  // one proc. Those fall back to mutex-guarded queues.
+  absl::flat_hash_map<int64_t, absl::flat_hash_set<Proc*>> senders;
+  absl::flat_hash_map<int64_t, absl::flat_hash_set<Proc*>> receivers;
+  for (const std::unique_ptr<Proc>& proc : package->procs()) {
+    for (Node* node : proc->nodes()) {
+      if (node->Is<Send>()) {
+        senders[node->As<Send>()->channel_id()].insert(proc.get());
+      } else if (node->Is<Receive>()) {
+        receivers[node->As<Receive>()->channel_id()].insert(proc.get());
+      }
+    }
+  }
+  std::vector<std::unique_ptr<ChannelQueue>> queues;
+  for (Channel* channel : package->channels()) {
+    if (channel->kind() == ChannelKind::kSingleValue ||
+        senders[channel->id()].size() > 1 ||
+        receivers[channel->id()].size() > 1) {
+      queues.push_back(
+          std::make_unique<ThreadSafeJitChannelQueue>(channel, runtime.get()));
+    } else {
+      queues.push_back(std::make_unique<LockFreeJitChannelQueue>(
+          channel, runtime.get(), capacity));
+    }
+  }
+  return absl::WrapUnique(new JitChannelQueueManager(package, std::move(queues),
+                                                     std::move(runtime)));
+}
+
 JitChannelQueue& JitChannelQueueManager::GetJitQueue(Channel* channel) {
   JitChannelQueue* queue = dynamic_cast<JitChannelQueue*>(&GetQueue(channel));
   XLS_CHECK_NE(queue, nullptr);
@@ -15,16 +15,19 @@
 #define XLS_JIT_JIT_CHANNEL_QUEUE_H_
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+#include "absl/base/optimization.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/ret_check.h"
@@ -114,20 +117,95 @@ class ByteQueue {
   bool is_single_value_;
 };
 
+// A bounded queue of raw bytes which supports one producer and one consumer
+// running concurrently without any locking. The read and write counters live on
+// separate cache lines, and each side keeps a private copy of the other side's
+// counter so the shared counters are only touched when the cached view says the
+// queue is full (producer) or empty (consumer). The capacity is rounded up to a
+// power of two.
+class SpscByteQueue {
+ public:
+  SpscByteQueue(int64_t channel_element_size, int64_t capacity);
+
+  int64_t element_size() const { return channel_element_size_; }
+  int64_t capacity() const { return capacity_; }
+
+  // Writes a single element. Returns false if the queue is full. Must only be
+  // called by the producer.
+  bool Write(const uint8_t* data) { return WriteN(data, 1) == 1; }
+
+  // Reads a single element. Returns false if the queue is empty. Must only be
+  // called by the consumer.
+  bool Read(uint8_t* buffer) { return ReadN(buffer, 1) == 1; }
+
+  // Writes up to `count` elements packed at a stride of `element_size()` bytes
+  // and returns the number of elements written.
+  int64_t WriteN(const uint8_t* data, int64_t count);
+
+  // Reads up to `count` elements into `buffer` packed at a stride of
+  // `element_size()` bytes and returns the number of elements read.
+  int64_t ReadN(uint8_t* buffer, int64_t count);
+
+  // Returns the number of elements in the queue. The value is exact only when
+  // neither side is concurrently accessing the queue.
+  int64_t size() const {
+    return write_count_.load(std::memory_order_acquire) -
+           read_count_.load(std::memory_order_acquire);
+  }
+
+  static constexpr int64_t kDefaultCapacity = 1024;
+
+ private:
+  uint8_t* ElementAt(int64_t count) {
+    return buffer_.data() + (count & (capacity_ - 1)) * allocated_element_size_;
+  }
+
+  // Size of an element in the channel in units of bytes.
+  int64_t channel_element_size_;
+  // Allocated size of an element in the buffer in units of bytes.
+  int64_t allocated_element_size_;
+  // Number of elements the queue can hold. Always a power of two.
+  int64_t capacity_;
+  std::vector<uint8_t> buffer_;
+
+  // Total number of elements ever read. Written only by the consumer.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<int64_t> read_count_ = 0;
+  // The producer's most recently observed value of `read_count_`.
+  int64_t producer_read_count_ = 0;
+
+  // Total number of elements ever written. Written only by the producer.
+  alignas(ABSL_CACHELINE_SIZE) std::atomic<int64_t> write_count_ = 0;
+  // The consumer's most recently observed value of `write_count_`.
+  int64_t consumer_write_count_ = 0;
+};
+
 // Abstract base class for channel queues which may be used by the JIT. These
 // queues support reading and writing raw bytes to the queue rather the just
 // xls::Values.
 class JitChannelQueue : public ChannelQueue {
  public:
   JitChannelQueue(Channel* channel, JitRuntime* jit_runtime)
-      : ChannelQueue(channel), jit_runtime_(jit_runtime) {}
+      : ChannelQueue(channel),
+        jit_runtime_(jit_runtime),
+        element_size_(jit_runtime->GetTypeByteSize(channel->type())) {}
   virtual ~JitChannelQueue() = default;
 
   virtual void WriteRaw(const uint8_t* data) = 0;
   virtual bool ReadRaw(uint8_t* buffer) = 0;
 
+  // Batched versions of WriteRaw and ReadRaw. `data` and `buffer` hold `count`
+  // elements packed at a stride of `element_size()` bytes. ReadRawN returns the
+  // number of elements read, which is less than `count` if the queue runs
+  // empty.
+  virtual void WriteRawN(const uint8_t* data, int64_t count);
+  virtual int64_t ReadRawN(uint8_t* buffer, int64_t count);
+
+  // Size in bytes of a single element in the native layout.
+  int64_t element_size() const { return element_size_; }
+
  protected:
   JitRuntime* jit_runtime_;
+  int64_t element_size_;
 };
 
 // A thread-safe version of the JIT channel queue. All accesses are guarded by a
@@ -159,6 +237,10 @@ class ThreadSafeJitChannelQueue : public JitChannelQueue {
     return byte_queue_.Read(buffer);
   }
 
+  // The batched versions acquire the lock once for the whole batch.
+  void WriteRawN(const uint8_t* data, int64_t count) override;
+  int64_t ReadRawN(uint8_t* buffer, int64_t count) override;
+
  protected:
   int64_t GetSizeInternal() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
   void WriteInternal(const Value& value)
@@ -197,6 +279,76 @@ class ThreadUnsafeJitChannelQueue : public JitChannelQueue {
   ByteQueue byte_queue_;
 };
 
+// A JIT channel queue backed by a bounded lock-free SpscByteQueue. Reads and
+// writes take no locks, so it is suitable only when at most one thread sends
+// and at most one thread receives at a time, which holds for streaming
+// channels sent and received by a single proc each. The xls::Value-based
+// Read/Write methods count as the consumer/producer respectively. Elements
+// written while the bounded queue is full spill into a growable mutex-guarded
+// overflow queue, after which all writes go to the overflow queue until the
+// consumer has drained it, preserving FIFO order. Single-value channels are
+// not supported.
+class LockFreeJitChannelQueue : public JitChannelQueue {
+ public:
+  LockFreeJitChannelQueue(
+      Channel* channel, JitRuntime* jit_runtime,
+      int64_t capacity = SpscByteQueue::kDefaultCapacity);
+  virtual ~LockFreeJitChannelQueue() = default;
+
+  void WriteRaw(const uint8_t* data) override {
+    if (ABSL_PREDICT_FALSE(overflow_count_.load(std::memory_order_acquire) !=
+                           0) ||
+        ABSL_PREDICT_FALSE(!byte_queue_.Write(data))) {
+      WriteOverflow(data, 1);
+    }
+  }
+  bool ReadRaw(uint8_t* buffer) override {
+    // A generator is only attached to channels with no sending proc so the
+    // consumer is the only producer in that case.
+    if (generator_.has_value()) {
+      std::optional<Value> generated_value = (*generator_)();
+      if (generated_value.has_value()) {
+        WriteInternal(generated_value.value());
+      }
+    }
+    if (byte_queue_.Read(buffer)) {
+      return true;
+    }
+    return ABSL_PREDICT_FALSE(
+               overflow_count_.load(std::memory_order_acquire) != 0) &&
+           ReadWithOverflow(buffer, 1) == 1;
+  }
+
+  void WriteRawN(const uint8_t* data, int64_t count) override;
+  int64_t ReadRawN(uint8_t* buffer, int64_t count) override;
+
+ protected:
+  int64_t GetSizeInternal() const ABSL_SHARED_LOCKS_REQUIRED(mutex_) override;
+  void WriteInternal(const Value& value) override;
+  std::optional<Value> ReadInternal() override;
+
+  // Slow paths which write/read elements to/from the overflow queue.
+  ABSL_ATTRIBUTE_NOINLINE void WriteOverflow(const uint8_t* data,
+                                             int64_t count);
+  ABSL_ATTRIBUTE_NOINLINE int64_t ReadOverflow(uint8_t* buffer, int64_t count);
+
+  // Reads up to `count` elements after the overflow queue was seen to be
+  // non-empty. The bounded queue may have been refilled between the reader
+  // finding it empty and seeing the overflow queue, and those elements
+  // precede the spilled ones, so the bounded queue is read first. The producer
+  // does not write to the bounded queue while the overflow queue is
+  // non-empty.
+  ABSL_ATTRIBUTE_NOINLINE int64_t ReadWithOverflow(uint8_t* buffer,
+                                                   int64_t count);
+
+  SpscByteQueue byte_queue_;
+
+  absl::Mutex overflow_mutex_;
+  ByteQueue overflow_queue_ ABSL_GUARDED_BY(overflow_mutex_);
+  // The number of elements in `overflow_queue_`. Readable without the lock.
+  std::atomic<int64_t> overflow_count_ = 0;
+};
+
 // A Channel manager which holds exclusively JitChannelQueues.
 class JitChannelQueueManager : public ChannelQueueManager {
  public:
@@ -209,6 +361,17 @@ class JitChannelQueueManager : public ChannelQueueManager {
   static absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
   CreateThreadUnsafe(Package* package);
 
+  // Factory which creates a queue manager with LockFreeJitChannelQueues of the
+  // given capacity for streaming channels which are sent on by at most one
+  // proc and received on by at most one proc. Other channels (including all
+  // single-value channels) use ThreadSafeJitChannelQueues. Values written or
+  // read from outside of the procs count as an additional proc, so they must
+  // not race with a sending (receiving) proc on the same channel. Used by the
+  // threaded JIT proc runtime.
+  static absl::StatusOr<std::unique_ptr<JitChannelQueueManager>>
+  CreateLockFree(Package* package,
+                 int64_t capacity = SpscByteQueue::kDefaultCapacity);
+
   JitChannelQueue& GetJitQueue(Channel* channel);
 
   JitRuntime& runtime() { return *runtime_; }
@@ -12,10 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
+#include <thread>  // NOLINT
+#include <type_traits>
 #include <vector>
 
 #include "include/benchmark/benchmark.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/thread.h"
 #include "xls/ir/channel.h"
 #include "xls/ir/package.h"
 #include "xls/jit/jit_channel_queue.h"
@@ -24,6 +28,18 @@
 namespace xls {
 namespace {
 
+// Creates a queue for the benchmarks. Lock-free queues are bounded so they are
+// given a capacity large enough to hold all elements written in one iteration.
+template <typename QueueT>
+std::unique_ptr<QueueT> CreateQueue(Channel* channel, JitRuntime* jit_runtime,
+                                    int64_t capacity) {
+  if constexpr (std::is_same_v<QueueT, LockFreeJitChannelQueue>) {
+    return std::make_unique<QueueT>(channel, jit_runtime, capacity);
+  } else {
+    return std::make_unique<QueueT>(channel, jit_runtime);
+  }
+}
+
 // Benchmark evaluating writing to the channel then reading from the channel.
 // The number of writes are followed by an equal amount of number of reads.
 // For a FIFO channel queue, it evaluates the enqueing and dequeing mechanism.
@@ -40,9 +56,10 @@ static void BM_QueueWriteThenRead(benchmark::State& state) {
           .CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
                                   package.GetBitsType(8 * element_size_bytes))
           .value();
-  QueueT queue(channel, jit_runtime.get());
-
   int64_t send_count = state.range(1);
+  std::unique_ptr<QueueT> queue_ptr =
+      CreateQueue<QueueT>(channel, jit_runtime.get(), send_count);
+  QueueT& queue = *queue_ptr;
   XLS_CHECK(queue.IsEmpty());
   std::vector<uint8_t> send_buffer(element_size_bytes);
   std::vector<uint8_t> recv_buffer(element_size_bytes);
@@ -57,6 +74,72 @@ static void BM_QueueWriteThenRead(benchmark::State& state) {
   }
 }
 
+// Same as BM_QueueWriteThenRead but using the batched entry points.
+template <typename QueueT,
+          typename std::enable_if<std::is_base_of_v<JitChannelQueue, QueueT>,
+                                  QueueT>::type* = nullptr>
+static void BM_QueueBatchedWriteThenRead(benchmark::State& state) {
+  int64_t element_size_bytes = state.range(0);
+
+  Package package("benchmark");
+  std::unique_ptr<JitRuntime> jit_runtime = JitRuntime::Create().value();
+  Channel* channel =
+      package
+          .CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                  package.GetBitsType(8 * element_size_bytes))
+          .value();
+  int64_t send_count = state.range(1);
+  std::unique_ptr<QueueT> queue =
+      CreateQueue<QueueT>(channel, jit_runtime.get(), send_count);
+  XLS_CHECK(queue->IsEmpty());
+  std::vector<uint8_t> send_buffer(queue->element_size() * send_count, 42);
+  std::vector<uint8_t> recv_buffer(queue->element_size() * send_count);
+  for (auto _ : state) {
+    queue->WriteRawN(send_buffer.data(), send_count);
+    XLS_CHECK_EQ(queue->ReadRawN(recv_buffer.data(), send_count), send_count);
+  }
+}
+
+// Benchmark evaluating a producer and a consumer accessing the channel
+// concurrently from different threads. Each iteration the consumer thread
+// reads `send_count` elements while the benchmark thread writes them. The
+// iteration time includes starting and joining the consumer thread.
+template <typename QueueT,
+          typename std::enable_if<std::is_base_of_v<JitChannelQueue, QueueT>,
+                                  QueueT>::type* = nullptr>
+static void BM_QueueContendedWriteAndRead(benchmark::State& state) {
+  int64_t element_size_bytes = state.range(0);
+
+  Package package("benchmark");
+  std::unique_ptr<JitRuntime> jit_runtime = JitRuntime::Create().value();
+  Channel* channel =
+      package
+          .CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                  package.GetBitsType(8 * element_size_bytes))
+          .value();
+  int64_t send_count = state.range(1);
+  std::unique_ptr<QueueT> queue =
+      CreateQueue<QueueT>(channel, jit_runtime.get(), send_count);
+  std::vector<uint8_t> send_buffer(element_size_bytes, 42);
+  for (auto _ : state) {
+    Thread consumer([&]() {
+      std::vector<uint8_t> recv_buffer(element_size_bytes);
+      for (int64_t i = 0; i < send_count;) {
+        if (queue->ReadRaw(recv_buffer.data())) {
+          ++i;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+    for (int64_t i = 0; i < send_count; ++i) {
+      queue->WriteRaw(send_buffer.data());
+    }
+    consumer.Join();
+  }
+  state.SetItemsProcessed(state.iterations() * send_count);
+}
+
 // For the following benchmark, the first element in the pair denotes the buffer
 // size written/read from the channel queue. The second element in the pair
 // denotes the number of writes and/or reads to the channel queue.
@@ -80,6 +163,38 @@ BENCHMARK(BM_QueueWriteThenRead<ThreadUnsafeJitChannelQueue>)
     ->ArgPair(2048, 1)
     ->ArgPair(2048, 128);
 
+BENCHMARK(BM_QueueWriteThenRead<LockFreeJitChannelQueue>)
+    ->ArgPair(1, 1)
+    ->ArgPair(1, 128)
+    ->ArgPair(8, 1)
+    ->ArgPair(8, 128)
+    ->ArgPair(32, 1)
+    ->ArgPair(32, 128)
+    ->ArgPair(2048, 1)
+    ->ArgPair(2048, 128);
+
+BENCHMARK(BM_QueueBatchedWriteThenRead<ThreadSafeJitChannelQueue>)
+    ->ArgPair(8, 128)
+    ->ArgPair(32, 128)
+    ->ArgPair(2048, 128);
+
+BENCHMARK(BM_QueueBatchedWriteThenRead<LockFreeJitChannelQueue>)
+    ->ArgPair(8, 128)
+    ->ArgPair(32, 128)
+    ->ArgPair(2048, 128);
+
+BENCHMARK(BM_QueueContendedWriteAndRead<ThreadSafeJitChannelQueue>)
+    ->ArgPair(8, 1024)
+    ->ArgPair(8, 65536)
+    ->ArgPair(2048, 1024)
+    ->UseRealTime();
+
+BENCHMARK(BM_QueueContendedWriteAndRead<LockFreeJitChannelQueue>)
+    ->ArgPair(8, 1024)
+    ->ArgPair(8, 65536)
+    ->ArgPair(2048, 1024)
+    ->UseRealTime();
+
 BENCHMARK_MAIN();
 
 }  // namespace
@@ -14,10 +14,12 @@
 
 #include "xls/jit/jit_channel_queue.h"
 
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/types/span.h"
 #include "xls/common/status/matchers.h"
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/channel_queue_test_base.h"
@@ -50,11 +52,26 @@ INSTANTIATE_TEST_SUITE_P(
                                                            GetJitRuntime());
     })));
 
+INSTANTIATE_TEST_SUITE_P(
+    LockFreeJitChannelQueueTest, ChannelQueueTestBase,
+    testing::Values(
+        ChannelQueueTestParam([](Channel* channel)
+                                  -> std::unique_ptr<ChannelQueue> {
+          // Lock-free queues only support streaming channels.
+          if (channel->kind() == ChannelKind::kSingleValue) {
+            return std::make_unique<ThreadSafeJitChannelQueue>(channel,
+                                                               GetJitRuntime());
+          }
+          return std::make_unique<LockFreeJitChannelQueue>(channel,
+                                                           GetJitRuntime());
+        })));
+
 template <typename QueueT>
 class JitChannelQueueTest : public ::testing::Test {};
 
 using QueueTypes =
-    ::testing::Types<ThreadSafeJitChannelQueue, ThreadUnsafeJitChannelQueue>;
+    ::testing::Types<ThreadSafeJitChannelQueue, ThreadUnsafeJitChannelQueue,
+                     LockFreeJitChannelQueue>;
 TYPED_TEST_SUITE(JitChannelQueueTest, QueueTypes);
 
 // An empty tuple represents a zero width.
@@ -155,5 +172,154 @@ TYPED_TEST(JitChannelQueueTest, IotaGeneratorWithRawApi) {
                                  "a generator function")));
 }
 
+TYPED_TEST(JitChannelQueueTest, BatchedAccess) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  TypeParam queue(channel, GetJitRuntime());
+  ASSERT_EQ(queue.element_size(), 4);
+
+  std::vector<uint32_t> send_buffer = {1, 2, 3, 4, 5};
+  queue.WriteRawN(reinterpret_cast<const uint8_t*>(send_buffer.data()),
+                  send_buffer.size());
+  EXPECT_EQ(queue.GetSize(), 5);
+
+  std::vector<uint32_t> recv_buffer(8);
+  EXPECT_EQ(queue.ReadRawN(reinterpret_cast<uint8_t*>(recv_buffer.data()), 3),
+            3);
+  EXPECT_THAT(absl::MakeSpan(recv_buffer).subspan(0, 3),
+              ::testing::ElementsAre(1, 2, 3));
+  // Only two elements remain.
+  EXPECT_EQ(queue.ReadRawN(reinterpret_cast<uint8_t*>(recv_buffer.data()), 8),
+            2);
+  EXPECT_THAT(absl::MakeSpan(recv_buffer).subspan(0, 2),
+              ::testing::ElementsAre(4, 5));
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(SpscByteQueueTest, BoundedCapacity) {
+  SpscByteQueue queue(/*channel_element_size=*/8, /*capacity=*/3);
+  // Capacity is rounded up to a power of two.
+  EXPECT_EQ(queue.capacity(), 4);
+
+  std::vector<uint64_t> data = {10, 11, 12, 13, 14, 15};
+  EXPECT_EQ(queue.WriteN(reinterpret_cast<const uint8_t*>(data.data()), 6), 4);
+  EXPECT_EQ(queue.size(), 4);
+  EXPECT_FALSE(queue.Write(reinterpret_cast<const uint8_t*>(&data[4])));
+
+  uint64_t value;
+  EXPECT_TRUE(queue.Read(reinterpret_cast<uint8_t*>(&value)));
+  EXPECT_EQ(value, 10);
+  EXPECT_TRUE(queue.Write(reinterpret_cast<const uint8_t*>(&data[4])));
+
+  std::vector<uint64_t> result(6);
+  EXPECT_EQ(queue.ReadN(reinterpret_cast<uint8_t*>(result.data()), 6), 4);
+  EXPECT_THAT(absl::MakeSpan(result).subspan(0, 4),
+              ::testing::ElementsAre(11, 12, 13, 14));
+  EXPECT_EQ(queue.size(), 0);
+  EXPECT_FALSE(queue.Read(reinterpret_cast<uint8_t*>(&value)));
+}
+
+TEST(LockFreeJitChannelQueueTest, OverflowPreservesOrder) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  LockFreeJitChannelQueue queue(channel, GetJitRuntime(), /*capacity=*/4);
+
+  // Overfill the bounded queue, read a couple of elements and then write more.
+  // Later writes must stay behind the spilled elements.
+  std::vector<uint32_t> data = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  queue.WriteRawN(reinterpret_cast<const uint8_t*>(data.data()), 6);
+  EXPECT_EQ(queue.GetSize(), 6);
+  uint32_t value;
+  EXPECT_TRUE(queue.ReadRaw(reinterpret_cast<uint8_t*>(&value)));
+  EXPECT_EQ(value, 0);
+  EXPECT_TRUE(queue.ReadRaw(reinterpret_cast<uint8_t*>(&value)));
+  EXPECT_EQ(value, 1);
+  for (int64_t i = 6; i < 10; ++i) {
+    queue.WriteRaw(reinterpret_cast<const uint8_t*>(&data[i]));
+  }
+  EXPECT_EQ(queue.GetSize(), 8);
+
+  std::vector<uint32_t> result(10);
+  EXPECT_EQ(queue.ReadRawN(reinterpret_cast<uint8_t*>(result.data()), 10), 8);
+  EXPECT_THAT(absl::MakeSpan(result).subspan(0, 8),
+              ::testing::ElementsAre(2, 3, 4, 5, 6, 7, 8, 9));
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_FALSE(queue.ReadRaw(reinterpret_cast<uint8_t*>(&value)));
+}
+
+TEST(LockFreeJitChannelQueueTest, ConcurrentOverflowPreservesOrder) {
+  Package package("test");
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Channel * channel,
+      package.CreateStreamingChannel("my_channel", ChannelOps::kSendReceive,
+                                     package.GetBitsType(32)));
+  LockFreeJitChannelQueue queue(channel, GetJitRuntime(), /*capacity=*/4);
+
+  // The producer never waits so the small bounded queue repeatedly spills into
+  // the overflow queue and drains again while the consumer is reading.
+  constexpr uint32_t kCount = 200000;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < kCount; ++i) {
+      queue.WriteRaw(reinterpret_cast<const uint8_t*>(&i));
+    }
+  });
+
+  uint32_t expected = 0;
+  std::vector<uint32_t> values(3);
+  while (expected < kCount) {
+    // Alternate between single and batched reads to cover both paths.
+    int64_t read =
+        expected % 2 == 0
+            ? queue.ReadRawN(reinterpret_cast<uint8_t*>(values.data()),
+                             values.size())
+            : static_cast<int64_t>(
+                  queue.ReadRaw(reinterpret_cast<uint8_t*>(values.data())));
+    if (read == 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (int64_t i = 0; i < read; ++i) {
+      ASSERT_EQ(values[i], expected);
+      ++expected;
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(SpscByteQueueTest, ConcurrentProducerAndConsumer) {
+  constexpr int64_t kCount = 100000;
+  SpscByteQueue queue(/*channel_element_size=*/8, /*capacity=*/64);
+
+  std::thread producer([&]() {
+    for (uint64_t i = 0; i < kCount;) {
+      if (queue.Write(reinterpret_cast<const uint8_t*>(&i))) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint64_t expected = 0;
+  while (expected < kCount) {
+    uint64_t value;
+    if (queue.Read(reinterpret_cast<uint8_t*>(&value))) {
+      ASSERT_EQ(value, expected);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_EQ(queue.size(), 0);
+}
+
 }  // namespace
 }  // namespace xls
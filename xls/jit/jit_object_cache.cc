@@ -0,0 +1,205 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/jit_object_cache.h"
+
+#include <unistd.h>
+
+#include <array>
+#include <system_error>  // NOLINT
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/flags/flag.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "llvm/include/llvm/ADT/StringExtras.h"
+#include "llvm/include/llvm/Config/llvm-config.h"
+#include "llvm/include/llvm/Support/SHA256.h"
+#include "llvm/include/llvm/Support/raw_ostream.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+
+ABSL_FLAG(std::string, jit_object_cache_dir, "",
+          "If non-empty, JIT-compiled object code is cached in this "
+          "directory and reused by later compilations of identical code, "
+          "including in other processes.");
+
+namespace xls {
+namespace {
+
+// Keys are the hex encoding of a SHA-256 digest.
+constexpr int64_t kKeyLength = 64;
+
+// Name of the named metadata which marks modules embedding host addresses.
+constexpr std::string_view kHostAddressesMetadata = "xls.host_addresses";
+
+}  // namespace
+
+/* static */
+absl::StatusOr<std::unique_ptr<JitObjectCache>> JitObjectCache::Create(
+    const std::filesystem::path& directory) {
+  XLS_RETURN_IF_ERROR(RecursivelyCreateDir(directory));
+  return absl::WrapUnique(new JitObjectCache(directory));
+}
+
+/* static */
+JitObjectCache* JitObjectCache::GetDefault() {
+  std::string directory = absl::GetFlag(FLAGS_jit_object_cache_dir);
+  if (directory.empty()) {
+    return nullptr;
+  }
+  // Caches are never destroyed because OrcJit instances may refer to them
+  // until process exit.
+  static absl::Mutex mutex(absl::kConstInit);
+  static auto* caches =
+      new absl::flat_hash_map<std::string, std::unique_ptr<JitObjectCache>>();
+  absl::MutexLock lock(&mutex);
+  auto it = caches->find(directory);
+  if (it == caches->end()) {
+    absl::StatusOr<std::unique_ptr<JitObjectCache>> cache = Create(directory);
+    if (!cache.ok()) {
+      XLS_LOG(WARNING) << "Unable to create JIT object cache in " << directory
+                       << ": " << cache.status();
+      return nullptr;
+    }
+    it = caches->insert({directory, std::move(cache).value()}).first;
+  }
+  return it->second.get();
+}
+
+/* static */
+std::string JitObjectCache::ComputeKey(
+    const llvm::Module& module, int64_t opt_level,
+    const llvm::TargetMachine& target_machine) {
+  std::string text =
+      absl::StrCat(LLVM_VERSION_STRING, "\n", opt_level, "\n",
+                   target_machine.getTargetTriple().str(), "\n",
+                   target_machine.getTargetCPU().str(), "\n",
+                   target_machine.getTargetFeatureString().str(), "\n");
+  llvm::raw_string_ostream ostream(text);
+  module.print(ostream, nullptr);
+  ostream.flush();
+  std::array<uint8_t, 32> digest = llvm::SHA256::hash(llvm::ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+  return llvm::toHex(digest, /*LowerCase=*/true);
+}
+
+/* static */
+bool JitObjectCache::IsKey(std::string_view module_id) {
+  if (module_id.size() != kKeyLength) {
+    return false;
+  }
+  for (char c : module_id) {
+    if (!absl::ascii_isxdigit(c) || absl::ascii_isupper(c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* static */
+void JitObjectCache::MarkEmbedsHostAddresses(llvm::Module& module) {
+  module.getOrInsertNamedMetadata(llvm::StringRef(
+      kHostAddressesMetadata.data(), kHostAddressesMetadata.size()));
+}
+
+/* static */
+bool JitObjectCache::EmbedsHostAddresses(const llvm::Module& module) {
+  return module.getNamedMetadata(llvm::StringRef(
+             kHostAddressesMetadata.data(), kHostAddressesMetadata.size())) !=
+         nullptr;
+}
+
+bool JitObjectCache::IsCacheable(const llvm::Module& module) {
+  if (EmbedsHostAddresses(module)) {
+    ++uncacheable_count_;
+    XLS_VLOG(2) << "JIT object cache skipping module with host addresses: "
+                << module.getModuleIdentifier();
+    return false;
+  }
+  return true;
+}
+
+std::filesystem::path JitObjectCache::GetPath(std::string_view key) const {
+  return directory_ / absl::StrCat(key, ".o");
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JitObjectCache::Read(
+    std::string_view key) const {
+  absl::StatusOr<std::string> contents = GetFileContents(GetPath(key));
+  if (!contents.ok()) {
+    if (!absl::IsNotFound(contents.status())) {
+      XLS_LOG(WARNING) << "Unable to read JIT object cache entry: "
+                       << contents.status();
+    }
+    return nullptr;
+  }
+  return llvm::MemoryBuffer::getMemBufferCopy(contents.value(),
+                                              std::string{key});
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JitObjectCache::Lookup(
+    std::string_view key) {
+  std::unique_ptr<llvm::MemoryBuffer> object = Read(key);
+  if (object == nullptr) {
+    ++miss_count_;
+    XLS_VLOG(2) << "JIT object cache miss: " << key;
+  } else {
+    ++hit_count_;
+    XLS_VLOG(2) << "JIT object cache hit: " << key;
+  }
+  return object;
+}
+
+void JitObjectCache::notifyObjectCompiled(const llvm::Module* module,
+                                          llvm::MemoryBufferRef object) {
+  const std::string& key = module->getModuleIdentifier();
+  if (!IsKey(key)) {
+    return;
+  }
+  // Write to a temporary file and rename it into place so concurrent readers
+  // (possibly in other processes) never see a partially written entry.
+  std::filesystem::path path = GetPath(key);
+  std::filesystem::path temp_path = directory_ / absl::StrCat(
+      key, ".tmp.", getpid(), ".", write_count_.fetch_add(1));
+  absl::Status status = SetFileContents(
+      temp_path, std::string_view(object.getBufferStart(),
+                                  object.getBufferSize()));
+  if (status.ok()) {
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+      status = absl::InternalError(ec.message());
+      std::filesystem::remove(temp_path, ec);
+    }
+  }
+  if (!status.ok()) {
+    XLS_LOG(WARNING) << "Unable to write JIT object cache entry " << path
+                     << ": " << status;
+  }
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JitObjectCache::getObject(
+    const llvm::Module* module) {
+  const std::string& key = module->getModuleIdentifier();
+  if (!IsKey(key)) {
+    return nullptr;
+  }
+  return Read(key);
+}
+
+}  // namespace xls
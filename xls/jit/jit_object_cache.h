@@ -0,0 +1,115 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_JIT_OBJECT_CACHE_H_
+#define XLS_JIT_JIT_OBJECT_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "absl/flags/declare.h"
+#include "absl/status/statusor.h"
+#include "llvm/include/llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/include/llvm/IR/Module.h"
+#include "llvm/include/llvm/Support/MemoryBuffer.h"
+#include "llvm/include/llvm/Target/TargetMachine.h"
+
+ABSL_DECLARE_FLAG(std::string, jit_object_cache_dir);
+
+namespace xls {
+
+// A persistent cache of JIT-compiled object files stored in a directory on
+// disk. Each object file is stored under a key which is a hash of the
+// unoptimized LLVM module text, the optimization level, and the target
+// (triple, CPU, and features), so a cached object is only reused for an
+// identical compilation on an identical host. Modules which embed host
+// addresses (see MarkEmbedsHostAddresses) are not cached. The cache may be
+// shared by any number of OrcJit instances (and processes). Thread-safe.
+class JitObjectCache : public llvm::ObjectCache {
+ public:
+  // Returns a cache which stores object files in the given directory. The
+  // directory is created if it does not exist.
+  static absl::StatusOr<std::unique_ptr<JitObjectCache>> Create(
+      const std::filesystem::path& directory);
+
+  // Returns the process-wide cache in the directory given by the
+  // --jit_object_cache_dir flag, or nullptr if the flag is empty (or the
+  // directory cannot be created).
+  static JitObjectCache* GetDefault();
+
+  // Returns the key under which the object code of the given module compiled
+  // at the given optimization level for the given target is cached. Must be
+  // called before the module is optimized.
+  static std::string ComputeKey(const llvm::Module& module, int64_t opt_level,
+                                const llvm::TargetMachine& target_machine);
+
+  // Returns whether `module_id` is a key produced by ComputeKey.
+  static bool IsKey(std::string_view module_id);
+
+  // Marks the module as embedding host addresses (e.g., of runtime helper
+  // functions or channel queues) in its code. Such code is only valid in the
+  // process, and for the objects, it was generated for.
+  static void MarkEmbedsHostAddresses(llvm::Module& module);
+  static bool EmbedsHostAddresses(const llvm::Module& module);
+
+  // Returns whether the object code of the given module may be cached, i.e.,
+  // it does not embed host addresses. Updates the uncacheable counter.
+  bool IsCacheable(const llvm::Module& module);
+
+  // Returns the cached object code for the given key or nullptr if it is not
+  // in the cache. Updates the hit/miss counters.
+  std::unique_ptr<llvm::MemoryBuffer> Lookup(std::string_view key);
+
+  // llvm::ObjectCache interface. Modules are associated with cache entries
+  // through their module identifier which must be a key returned by
+  // ComputeKey; other modules are ignored. getObject does not update the
+  // hit/miss counters.
+  void notifyObjectCompiled(const llvm::Module* module,
+                            llvm::MemoryBufferRef object) override;
+  std::unique_ptr<llvm::MemoryBuffer> getObject(
+      const llvm::Module* module) override;
+
+  // Returns the number of lookups which found (did not find) an entry in the
+  // cache.
+  int64_t hit_count() const { return hit_count_.load(); }
+  int64_t miss_count() const { return miss_count_.load(); }
+
+  // Returns the number of modules which were not cached because they embed
+  // host addresses.
+  int64_t uncacheable_count() const { return uncacheable_count_.load(); }
+
+  const std::filesystem::path& directory() const { return directory_; }
+
+ private:
+  explicit JitObjectCache(const std::filesystem::path& directory)
+      : directory_(directory) {}
+
+  std::filesystem::path GetPath(std::string_view key) const;
+  std::unique_ptr<llvm::MemoryBuffer> Read(std::string_view key) const;
+
+  std::filesystem::path directory_;
+  std::atomic<int64_t> hit_count_ = 0;
+  std::atomic<int64_t> miss_count_ = 0;
+  std::atomic<int64_t> uncacheable_count_ = 0;
+  // Used to give temporary files written by this process unique names.
+  std::atomic<int64_t> write_count_ = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_JIT_OBJECT_CACHE_H_
@@ -0,0 +1,191 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/jit_object_cache.h"
+
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/temp_directory.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/orc_jit.h"
+#include "llvm/include/llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/include/llvm/IR/LLVMContext.h"
+#include "llvm/include/llvm/IR/Module.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+class JitObjectCacheTest : public IrTestBase {
+ protected:
+  Function* BuildAdd(Package* p) {
+    FunctionBuilder fb(TestName(), p);
+    BValue x = fb.Param("x", p->GetBitsType(32));
+    BValue y = fb.Param("y", p->GetBitsType(32));
+    fb.Add(fb.UMul(x, y), y);
+    return fb.Build().value();
+  }
+};
+
+TEST_F(JitObjectCacheTest, NoDefaultCacheWithoutFlag) {
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_jit_object_cache_dir, "");
+  EXPECT_EQ(JitObjectCache::GetDefault(), nullptr);
+}
+
+TEST_F(JitObjectCacheTest, DefaultCacheFromFlag) {
+  absl::FlagSaver flag_saver;
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  std::filesystem::path cache_dir = temp_dir.path() / "cache";
+  absl::SetFlag(&FLAGS_jit_object_cache_dir, cache_dir.string());
+  JitObjectCache* cache = JitObjectCache::GetDefault();
+  ASSERT_NE(cache, nullptr);
+  EXPECT_EQ(cache->directory(), cache_dir);
+  XLS_EXPECT_OK(FileExists(cache_dir));
+  EXPECT_EQ(JitObjectCache::GetDefault(), cache);
+}
+
+TEST_F(JitObjectCacheTest, KeysDependOnModuleAndOptLevel) {
+  // Initializes the native LLVM target.
+  XLS_ASSERT_OK(OrcJit::CreateDataLayout().status());
+  auto target_builder = llvm::orc::JITTargetMachineBuilder::detectHost();
+  ASSERT_TRUE(static_cast<bool>(target_builder));
+  auto target_machine = target_builder->createTargetMachine();
+  ASSERT_TRUE(static_cast<bool>(target_machine));
+
+  llvm::LLVMContext context;
+  llvm::Module module("a_module", context);
+  llvm::Module other_module("other_module", context);
+  std::string key = JitObjectCache::ComputeKey(module, 3, **target_machine);
+  EXPECT_TRUE(JitObjectCache::IsKey(key));
+  EXPECT_EQ(JitObjectCache::ComputeKey(module, 3, **target_machine), key);
+  EXPECT_NE(JitObjectCache::ComputeKey(module, 0, **target_machine), key);
+  EXPECT_NE(JitObjectCache::ComputeKey(other_module, 3, **target_machine),
+            key);
+
+  EXPECT_FALSE(JitObjectCache::IsKey("a_module"));
+  EXPECT_FALSE(JitObjectCache::IsKey(std::string(64, 'X')));
+}
+
+TEST_F(JitObjectCacheTest, FunctionJitReusesCachedObjectCode) {
+  absl::FlagSaver flag_saver;
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  absl::SetFlag(&FLAGS_jit_object_cache_dir, temp_dir.path().string());
+  JitObjectCache* cache = JitObjectCache::GetDefault();
+  ASSERT_NE(cache, nullptr);
+
+  auto p = CreatePackage();
+  Function* f = BuildAdd(p.get());
+  std::vector<Value> args = {Value(UBits(6, 32)), Value(UBits(7, 32))};
+  {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> jit,
+                             FunctionJit::Create(f));
+    EXPECT_EQ(cache->hit_count(), 0);
+    EXPECT_EQ(cache->miss_count(), 1);
+    EXPECT_THAT(DropInterpreterEvents(jit->Run(args)),
+                IsOkAndHolds(Value(UBits(49, 32))));
+  }
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<std::filesystem::path> entries,
+                           GetDirectoryEntries(temp_dir.path()));
+  EXPECT_EQ(entries.size(), 1);
+
+  // A second compilation of the same function (as would happen in another
+  // process) loads the object code from the cache.
+  {
+    XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> jit,
+                             FunctionJit::Create(f));
+    EXPECT_EQ(cache->hit_count(), 1);
+    EXPECT_EQ(cache->miss_count(), 1);
+    EXPECT_THAT(DropInterpreterEvents(jit->Run(args)),
+                IsOkAndHolds(Value(UBits(49, 32))));
+  }
+
+  // Compiling at a different optimization level does not hit the cache.
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<FunctionJit> jit,
+                           FunctionJit::Create(f, /*opt_level=*/1));
+  EXPECT_EQ(cache->hit_count(), 1);
+  EXPECT_EQ(cache->miss_count(), 2);
+  EXPECT_THAT(DropInterpreterEvents(jit->Run(args)),
+              IsOkAndHolds(Value(UBits(49, 32))));
+}
+
+TEST_F(JitObjectCacheTest, ModulesWithHostAddressesAreNotCached) {
+  llvm::LLVMContext context;
+  llvm::Module module("a_module", context);
+  EXPECT_FALSE(JitObjectCache::EmbedsHostAddresses(module));
+  JitObjectCache::MarkEmbedsHostAddresses(module);
+  EXPECT_TRUE(JitObjectCache::EmbedsHostAddresses(module));
+
+  // Assertions call back into the runtime through a host address.
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  fb.Assert(fb.AfterAll({}), fb.ULt(x, fb.Literal(UBits(5, 8))), "x >= 5");
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(x));
+
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<JitObjectCache> cache,
+                           JitObjectCache::Create(temp_dir.path()));
+  for (int64_t i = 0; i < 2; ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<OrcJit> orc_jit,
+        OrcJit::Create(/*opt_level=*/3, /*emit_object_code=*/false,
+                       cache.get()));
+    XLS_ASSERT_OK(BuildFunction(f, *orc_jit).status());
+  }
+  EXPECT_EQ(cache->hit_count(), 0);
+  EXPECT_EQ(cache->miss_count(), 0);
+  EXPECT_EQ(cache->uncacheable_count(), 2);
+  XLS_ASSERT_OK_AND_ASSIGN(std::vector<std::filesystem::path> entries,
+                           GetDirectoryEntries(temp_dir.path()));
+  EXPECT_TRUE(entries.empty());
+}
+
+TEST_F(JitObjectCacheTest, CachedObjectCodeIsEmitted) {
+  auto p = CreatePackage();
+  Function* f = BuildAdd(p.get());
+  XLS_ASSERT_OK_AND_ASSIGN(TempDirectory temp_dir, TempDirectory::Create());
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<JitObjectCache> cache,
+                           JitObjectCache::Create(temp_dir.path()));
+
+  std::vector<std::vector<uint8_t>> object_code;
+  for (int64_t i = 0; i < 2; ++i) {
+    XLS_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<OrcJit> orc_jit,
+        OrcJit::Create(/*opt_level=*/3, /*emit_object_code=*/true,
+                       cache.get()));
+    XLS_ASSERT_OK(BuildFunction(f, *orc_jit).status());
+    object_code.push_back(orc_jit->GetObjectCode());
+  }
+  EXPECT_EQ(cache->hit_count(), 1);
+  EXPECT_EQ(cache->miss_count(), 1);
+  EXPECT_FALSE(object_code[0].empty());
+  EXPECT_FALSE(object_code[1].empty());
+}
+
+}  // namespace
+}  // namespace xls
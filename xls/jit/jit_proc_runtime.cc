@@ -26,8 +26,22 @@
 
 namespace xls {
 
+namespace {
+
+absl::StatusOr<std::unique_ptr<ProcJit>> CreateProcJit(
+    Proc* proc, JitChannelQueueManager* queue_manager,
+    const std::optional<JitTieringOptions>& tiering) {
+  if (tiering.has_value()) {
+    return ProcJit::CreateTiered(proc, &queue_manager->runtime(),
+                                 queue_manager, *tiering);
+  }
+  return ProcJit::Create(proc, &queue_manager->runtime(), queue_manager);
+}
+
+}  // namespace
+
 absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
-    Package* package) {
+    Package* package, std::optional<JitTieringOptions> tiering) {
   // Create a queue manager for the queues. This factory verifies that there an
   // receive only queue for every receive only channel.
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<JitChannelQueueManager> queue_manager,
@@ -36,9 +50,9 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
   // Create a ProcJit for each Proc.
   std::vector<std::unique_ptr<ProcEvaluator>> proc_jits;
   for (auto& proc : package->procs()) {
-    XLS_ASSIGN_OR_RETURN(std::unique_ptr<ProcJit> proc_jit,
-                         ProcJit::Create(proc.get(), &queue_manager->runtime(),
-                                         queue_manager.get()));
+    XLS_ASSIGN_OR_RETURN(
+        std::unique_ptr<ProcJit> proc_jit,
+        CreateProcJit(proc.get(), queue_manager.get(), tiering));
     proc_jits.push_back(std::move(proc_jit));
   }
 
@@ -58,4 +72,38 @@ absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
   return std::move(proc_runtime);
 }
 
+absl::StatusOr<std::unique_ptr<ThreadedProcRuntime>>
+CreateJitThreadedProcRuntime(Package* package, int64_t thread_count,
+                             std::optional<JitTieringOptions> tiering) {
+  // Procs run concurrently so the queues must be thread-safe. Channels with a
+  // single sending and a single receiving proc use lock-free queues.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<JitChannelQueueManager> queue_manager,
+                       JitChannelQueueManager::CreateLockFree(package));
+
+  // Create a ProcJit for each Proc.
+  std::vector<std::unique_ptr<ProcEvaluator>> proc_jits;
+  for (auto& proc : package->procs()) {
+    XLS_ASSIGN_OR_RETURN(
+        std::unique_ptr<ProcJit> proc_jit,
+        CreateProcJit(proc.get(), queue_manager.get(), tiering));
+    proc_jits.push_back(std::move(proc_jit));
+  }
+
+  // Create a runtime.
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<ThreadedProcRuntime> proc_runtime,
+      ThreadedProcRuntime::Create(package, std::move(proc_jits),
+                                  std::move(queue_manager), thread_count));
+
+  // Inject initial values into channels.
+  for (Channel* channel : package->channels()) {
+    ChannelQueue& queue = proc_runtime->queue_manager().GetQueue(channel);
+    for (const Value& value : channel->initial_values()) {
+      XLS_RETURN_IF_ERROR(queue.Write(value));
+    }
+  }
+
+  return std::move(proc_runtime);
+}
+
 }  // namespace xls
@@ -16,16 +16,27 @@
 #define XLS_JIT_JIT_PROC_RUNTIME_H_
 
 #include <memory>
+#include <optional>
 
 #include "absl/status/statusor.h"
 #include "xls/interpreter/serial_proc_runtime.h"
+#include "xls/interpreter/threaded_proc_runtime.h"
 #include "xls/ir/package.h"
+#include "xls/jit/tiered_jit.h"
 
 namespace xls {
 
-// Create a SerialProcRuntime composed of ProcJits.
+// Create a SerialProcRuntime composed of ProcJits. If `tiering` is given the
+// ProcJits use tiered compilation (see ProcJit::CreateTiered).
 absl::StatusOr<std::unique_ptr<SerialProcRuntime>> CreateJitSerialProcRuntime(
-    Package* package);
+    Package* package, std::optional<JitTieringOptions> tiering = std::nullopt);
+
+// Create a ThreadedProcRuntime composed of ProcJits. `thread_count` is the
+// number of worker threads (zero selects a default based on the hardware).
+absl::StatusOr<std::unique_ptr<ThreadedProcRuntime>>
+CreateJitThreadedProcRuntime(
+    Package* package, int64_t thread_count = 0,
+    std::optional<JitTieringOptions> tiering = std::nullopt);
 
 }  // namespace xls
 
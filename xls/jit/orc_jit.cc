@@ -14,12 +14,15 @@
 
 #include "xls/jit/orc_jit.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <system_error>  // NOLINT
+#include <thread>        // NOLINT
 
+#include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -30,25 +33,39 @@
 #include "llvm/include/llvm/ADT/StringExtras.h"
 #include "llvm/include/llvm/Analysis/CGSCCPassManager.h"
 #include "llvm/include/llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/include/llvm/Bitcode/BitcodeReader.h"
+#include "llvm/include/llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/ExecutionUtils.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/ExecutorProcessControl.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/include/llvm/ExecutionEngine/Orc/Mangling.h"
+#include "llvm/include/llvm/ExecutionEngine/Orc/TaskDispatch.h"
 #include "llvm/include/llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/include/llvm/IR/LegacyPassManager.h"
 #include "llvm/include/llvm/IR/PassManager.h"
 #include "llvm/include/llvm/Passes/OptimizationLevel.h"
 #include "llvm/include/llvm/Passes/PassBuilder.h"
 #include "llvm/include/llvm/Support/CodeGen.h"
+#include "llvm/include/llvm/Transforms/Utils/SplitModule.h"
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/logging/vlog_is_on.h"
 #include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/jit/wide_arithmetic.h"
+
+ABSL_FLAG(int64_t, jit_compile_threads, 1,
+          "Number of threads used to compile large JIT modules. Zero means "
+          "the number of cores.");
 
 namespace xls {
 namespace {
 
+// Modules with fewer LLVM instructions than this are not split for concurrent
+// compilation as the splitting overhead would dominate.
+constexpr int64_t kMinConcurrentCompileInstructions = 4096;
+
 absl::once_flag once;
 void OnceInit() {
   LLVMInitializeNativeTarget();
@@ -87,16 +104,29 @@ char BadOptLevelError::ID;
 
 }  // namespace
 
-OrcJit::OrcJit(int64_t opt_level, bool emit_object_code)
+OrcJit::OrcJit(int64_t opt_level, bool emit_object_code,
+               JitObjectCache* object_cache, int64_t compile_threads)
     : context_(std::make_unique<llvm::LLVMContext>()),
+      // In concurrent mode materialization tasks (optimization and
+      // compilation of modules) are dispatched to separate threads.
       execution_session_(
-          std::make_unique<llvm::orc::UnsupportedExecutorProcessControl>()),
+          std::make_unique<llvm::orc::UnsupportedExecutorProcessControl>(
+              /*SSP=*/nullptr,
+              compile_threads == 1
+                  ? nullptr
+                  : std::make_unique<
+                        llvm::orc::DynamicThreadPoolTaskDispatcher>())),
       object_layer_(
           execution_session_,
           []() { return std::make_unique<llvm::SectionMemoryManager>(); }),
       dylib_(execution_session_.createBareJITDylib("main")),
       opt_level_(opt_level),
       emit_object_code_(emit_object_code),
+      object_cache_(object_cache),
+      compile_threads_(compile_threads == 0
+                           ? std::max<int64_t>(
+                                 1, std::thread::hardware_concurrency())
+                           : compile_threads),
       data_layout_("") {}
 
 OrcJit::~OrcJit() {
@@ -155,6 +185,11 @@ llvm::Expected<llvm::orc::ThreadSafeModule> OrcJit::Optimizer(
   XLS_VLOG_LINES(2, DumpLlvmModuleToString(bare_module));
 
   if (XLS_VLOG_IS_ON(3)) {
+    // Modules may be optimized concurrently so use a separate target machine
+    // to generate the assembly.
+    absl::StatusOr<std::unique_ptr<llvm::TargetMachine>> target_machine =
+        CreateTargetMachine();
+    XLS_CHECK_OK(target_machine.status());
     // The ostream and its buffer must be declared before the
     // module_pass_manager because the destrutor of the pass manager calls flush
     // on the ostream so these must be destructed *after* the pass manager. C++
@@ -163,8 +198,9 @@ llvm::Expected<llvm::orc::ThreadSafeModule> OrcJit::Optimizer(
     llvm::SmallVector<char, 0> stream_buffer;
     llvm::raw_svector_ostream ostream(stream_buffer);
     llvm::legacy::PassManager mpm;
-    if (target_machine_->addPassesToEmitFile(mpm, ostream, nullptr,
-                                             llvm::CGFT_AssemblyFile)) {
+    if ((*target_machine)
+            ->addPassesToEmitFile(mpm, ostream, nullptr,
+                                  llvm::CGFT_AssemblyFile)) {
       XLS_VLOG(3) << "Could not create ASM generation pass!";
     }
     mpm.run(*bare_module);
@@ -175,11 +211,13 @@ llvm::Expected<llvm::orc::ThreadSafeModule> OrcJit::Optimizer(
   return module;
 }
 
-absl::StatusOr<std::unique_ptr<OrcJit>> OrcJit::Create(int64_t opt_level,
-                                                       bool emit_object_code) {
+absl::StatusOr<std::unique_ptr<OrcJit>> OrcJit::Create(
+    int64_t opt_level, bool emit_object_code, JitObjectCache* object_cache,
+    int64_t compile_threads) {
+  XLS_RET_CHECK_GE(compile_threads, 0);
   absl::call_once(once, OnceInit);
-  std::unique_ptr<OrcJit> jit =
-      absl::WrapUnique(new OrcJit(opt_level, emit_object_code));
+  std::unique_ptr<OrcJit> jit = absl::WrapUnique(new OrcJit(
+      opt_level, emit_object_code, object_cache, compile_threads));
   XLS_RETURN_IF_ERROR(jit->Init());
   return std::move(jit);
 }
@@ -191,8 +229,8 @@ absl::StatusOr<std::unique_ptr<OrcJit>> OrcJit::Create(int64_t opt_level,
   return target_machine->createDataLayout();
 }
 
-/* static */ absl::StatusOr<std::unique_ptr<llvm::TargetMachine>>
-OrcJit::CreateTargetMachine() {
+/* static */ absl::StatusOr<llvm::orc::JITTargetMachineBuilder>
+OrcJit::CreateTargetMachineBuilder() {
   auto error_or_target_builder =
       llvm::orc::JITTargetMachineBuilder::detectHost();
   if (!error_or_target_builder) {
@@ -202,7 +240,14 @@ OrcJit::CreateTargetMachine() {
   }
 
   error_or_target_builder->setRelocationModel(llvm::Reloc::Model::PIC_);
-  auto error_or_target_machine = error_or_target_builder->createTargetMachine();
+  return std::move(error_or_target_builder.get());
+}
+
+/* static */ absl::StatusOr<std::unique_ptr<llvm::TargetMachine>>
+OrcJit::CreateTargetMachine() {
+  XLS_ASSIGN_OR_RETURN(llvm::orc::JITTargetMachineBuilder target_builder,
+                       CreateTargetMachineBuilder());
+  auto error_or_target_machine = target_builder.createTargetMachine();
   if (!error_or_target_machine) {
     return absl::InternalError(
         absl::StrCat("Unable to create target machine: ",
@@ -222,7 +267,35 @@ absl::Status OrcJit::Init() {
             data_layout_.getGlobalPrefix())));
   });
 
-  auto compiler = std::make_unique<llvm::orc::SimpleCompiler>(*target_machine_);
+  // Define the kernels called by the lowering of wide arithmetic operations.
+  llvm::orc::MangleAndInterner mangle(execution_session_, data_layout_);
+  llvm::orc::SymbolMap wide_arithmetic_symbols;
+  for (const auto& [name, address] : GetWideArithmeticSymbols()) {
+    wide_arithmetic_symbols[mangle(llvm::StringRef(name.data(), name.size()))] =
+        llvm::JITEvaluatedSymbol(llvm::pointerToJITTargetAddress(address),
+                                 llvm::JITSymbolFlags::Exported);
+  }
+  llvm::Error error = dylib_.define(
+      llvm::orc::absoluteSymbols(std::move(wide_arithmetic_symbols)));
+  if (error) {
+    return absl::InternalError(
+        absl::StrCat("Unable to define wide arithmetic symbols: ",
+                     llvm::toString(std::move(error))));
+  }
+
+  // On a cache miss the compiler stores the object code of the module in the
+  // cache (see CompileModule). A TargetMachine may not be used by multiple
+  // threads so in concurrent mode the compiler creates one per module.
+  std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler> compiler;
+  if (compile_threads_ == 1) {
+    compiler = std::make_unique<llvm::orc::SimpleCompiler>(*target_machine_,
+                                                           object_cache_);
+  } else {
+    XLS_ASSIGN_OR_RETURN(llvm::orc::JITTargetMachineBuilder target_builder,
+                         CreateTargetMachineBuilder());
+    compiler = std::make_unique<llvm::orc::ConcurrentIRCompiler>(
+        std::move(target_builder), object_cache_);
+  }
   compile_layer_ = std::make_unique<llvm::orc::IRCompileLayer>(
       execution_session_, object_layer_, std::move(compiler));
 
@@ -309,10 +382,33 @@ absl::Status VerifyModule(const llvm::Module& module) {
 
 }  // namespace
 
-absl::Status OrcJit::CompileModule(std::unique_ptr<llvm::Module>&& module) {
-  XLS_RETURN_IF_ERROR(VerifyModule(*module));
+absl::Status OrcJit::AddModule(std::unique_ptr<llvm::Module> module,
+                              llvm::orc::ThreadSafeContext context) {
+  if (object_cache_ != nullptr && object_cache_->IsCacheable(*module)) {
+    std::string key =
+        JitObjectCache::ComputeKey(*module, opt_level_, *target_machine_);
+    std::unique_ptr<llvm::MemoryBuffer> object = object_cache_->Lookup(key);
+    if (object != nullptr) {
+      // Bypass the optimizer and compiler and link the cached object code
+      // directly.
+      if (emit_object_code_) {
+        object_code_ = std::vector<uint8_t>(object->getBufferStart(),
+                                            object->getBufferEnd());
+      }
+      llvm::Error error = object_layer_.add(dylib_, std::move(object));
+      if (error) {
+        return absl::UnknownError(
+            absl::StrFormat("Error loading cached object code: %s",
+                            llvm::toString(std::move(error))));
+      }
+      return absl::OkStatus();
+    }
+    // The compiler stores the object code in the cache under the module
+    // identifier.
+    module->setModuleIdentifier(key);
+  }
   llvm::Error error = transform_layer_->add(
-      dylib_, llvm::orc::ThreadSafeModule(std::move(module), context_));
+      dylib_, llvm::orc::ThreadSafeModule(std::move(module), context));
   if (error) {
     return absl::UnknownError(absl::StrFormat(
         "Error compiling converted IR: %s", llvm::toString(std::move(error))));
@@ -320,6 +416,76 @@ absl::Status OrcJit::CompileModule(std::unique_ptr<llvm::Module>&& module) {
   return absl::OkStatus();
 }
 
+absl::Status OrcJit::CompileModuleConcurrently(
+    std::unique_ptr<llvm::Module> module) {
+  // Split the module. Local symbols (e.g., node functions) are kept in the
+  // same module as their users so they can still be inlined.
+  std::vector<std::unique_ptr<llvm::Module>> parts;
+  llvm::SplitModule(
+      *module, compile_threads_,
+      [&](std::unique_ptr<llvm::Module> part) {
+        parts.push_back(std::move(part));
+      },
+      /*PreserveLocals=*/true);
+  XLS_VLOG(1) << absl::StreamFormat(
+      "Compiling module with %d instructions as %d modules",
+      module->getInstructionCount(), parts.size());
+  module.reset();
+
+  // The parts share the context of the original module. Move each into a
+  // context of its own by round-tripping through bitcode so the parts can be
+  // optimized and compiled concurrently.
+  llvm::orc::SymbolLookupSet symbols;
+  for (std::unique_ptr<llvm::Module>& part : parts) {
+    for (const llvm::Function& function : part->functions()) {
+      if (!function.isDeclaration() && !function.hasLocalLinkage()) {
+        symbols.add(execution_session_.intern(function.getName()));
+      }
+    }
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream ostream(bitcode);
+    llvm::WriteBitcodeToFile(*part, ostream);
+    std::string name = part->getModuleIdentifier();
+    part.reset();
+
+    llvm::orc::ThreadSafeContext part_context(
+        std::make_unique<llvm::LLVMContext>());
+    llvm::Expected<std::unique_ptr<llvm::Module>> part_module =
+        llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(
+                llvm::StringRef(bitcode.data(), bitcode.size()), name),
+            *part_context.getContext());
+    if (!part_module) {
+      return absl::InternalError(
+          absl::StrFormat("Unable to split module: %s",
+                          llvm::toString(part_module.takeError())));
+    }
+    XLS_RETURN_IF_ERROR(
+        AddModule(std::move(part_module.get()), std::move(part_context)));
+  }
+
+  // Look up every symbol defined by the parts. The materialization (i.e.,
+  // optimization and compilation) of each part is dispatched to its own
+  // thread.
+  llvm::Expected<llvm::orc::SymbolMap> symbol_map = execution_session_.lookup(
+      llvm::orc::makeJITDylibSearchOrder(&dylib_), std::move(symbols));
+  if (!symbol_map) {
+    return absl::UnknownError(
+        absl::StrFormat("Error compiling converted IR: %s",
+                        llvm::toString(symbol_map.takeError())));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status OrcJit::CompileModule(std::unique_ptr<llvm::Module>&& module) {
+  XLS_RETURN_IF_ERROR(VerifyModule(*module));
+  if (compile_threads_ > 1 && !emit_object_code_ &&
+      module->getInstructionCount() >= kMinConcurrentCompileInstructions) {
+    return CompileModuleConcurrently(std::move(module));
+  }
+  return AddModule(std::move(module), context_);
+}
+
 absl::StatusOr<llvm::JITTargetAddress> OrcJit::LoadSymbol(
     std::string_view function_name) {
   llvm::Expected<llvm::JITEvaluatedSymbol> symbol =
@@ -15,15 +15,20 @@
 #ifndef XLS_JIT_ORC_JIT_H_
 #define XLS_JIT_ORC_JIT_H_
 
+#include "absl/flags/declare.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/IRTransformLayer.h"
+#include "llvm/include/llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/include/llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
 #include "llvm/include/llvm/IR/DataLayout.h"
 #include "llvm/include/llvm/Target/TargetMachine.h"
+#include "xls/jit/jit_object_cache.h"
+
+ABSL_DECLARE_FLAG(int64_t, jit_compile_threads);
 
 namespace xls {
 
@@ -34,14 +39,27 @@ class OrcJit {
   ~OrcJit();
   // Create an LLVM ORC JIT instance which compiles at the given optimization
   // level. If `emit_object_code` is true then `GetObjectCode` can be called
-  // after compilation to get the object code.
+  // after compilation to get the object code. If `object_cache` is non-null
+  // then compiled modules are looked up in (and added to) the cache, and
+  // optimization and code generation are skipped on a hit. `object_cache` must
+  // outlive the returned object.
+  //
+  // If `compile_threads` is not one then large modules are split into up to
+  // `compile_threads` modules (zero means the number of cores) which are
+  // optimized and compiled concurrently, each in its own LLVM context. This
+  // trades some cross-function optimization for compile time. Modules are not
+  // split if `emit_object_code` is true.
   static absl::StatusOr<std::unique_ptr<OrcJit>> Create(
-      int64_t opt_level = 3, bool emit_object_code = false);
+      int64_t opt_level = 3, bool emit_object_code = false,
+      JitObjectCache* object_cache = nullptr, int64_t compile_threads = 1);
 
   // Creates and returns a new LLVM module of the given name.
   std::unique_ptr<llvm::Module> NewModule(std::string_view name);
 
-  // Compiles the given LLVM module into the JIT's execution session.
+  // Compiles the given LLVM module into the JIT's execution session. In
+  // concurrent mode (see `Create`) large modules are compiled eagerly on
+  // multiple threads; otherwise compilation is deferred until the first symbol
+  // lookup.
   absl::Status CompileModule(std::unique_ptr<llvm::Module>&& module);
 
   // Returns the address of the given JIT'ed function.
@@ -59,12 +77,24 @@ class OrcJit {
   static absl::StatusOr<llvm::DataLayout> CreateDataLayout();
 
  private:
-  OrcJit(int64_t opt_level, bool emit_object_code);
+  OrcJit(int64_t opt_level, bool emit_object_code, JitObjectCache* object_cache,
+         int64_t compile_threads);
   absl::Status Init();
 
+  static absl::StatusOr<llvm::orc::JITTargetMachineBuilder>
+  CreateTargetMachineBuilder();
   static absl::StatusOr<std::unique_ptr<llvm::TargetMachine>>
   CreateTargetMachine();
 
+  // Adds the given module to the JIT's dylib, either as cached object code or
+  // as IR to be optimized and compiled when materialized.
+  absl::Status AddModule(std::unique_ptr<llvm::Module> module,
+                         llvm::orc::ThreadSafeContext context);
+
+  // Splits the given module into multiple modules, each in its own context,
+  // and compiles them concurrently.
+  absl::Status CompileModuleConcurrently(std::unique_ptr<llvm::Module> module);
+
   // Method which optimizes the given module. Used within the JIT to form an IR
   // transform layer.
   llvm::Expected<llvm::orc::ThreadSafeModule> Optimizer(
@@ -78,6 +108,8 @@ class OrcJit {
 
   int64_t opt_level_;
   bool emit_object_code_;
+  JitObjectCache* object_cache_;
+  int64_t compile_threads_;
 
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   llvm::DataLayout data_layout_;
@@ -0,0 +1,38 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_PROC_CHANNEL_CALLBACKS_H_
+#define XLS_JIT_PROC_CHANNEL_CALLBACKS_H_
+
+#include <cstdint>
+
+namespace xls::aot_compile {
+
+// Channel interface of a proc compiled without a JitChannelQueueManager (see
+// BuildProcFunction). A pointer to this struct is passed as the user data
+// argument of the compiled proc function which calls the callbacks with
+// `context` and the id of the channel. The data is in the native layout of the
+// channel type.
+struct ProcChannelCallbacks {
+  // Attempts to receive data from the channel into `buffer`. Returns whether
+  // data was received.
+  bool (*receive)(void* context, int64_t channel_id, uint8_t* buffer);
+  // Sends `data` on the channel.
+  void (*send)(void* context, int64_t channel_id, const uint8_t* data);
+  void* context;
+};
+
+}  // namespace xls::aot_compile
+
+#endif  // XLS_JIT_PROC_CHANNEL_CALLBACKS_H_
@@ -14,16 +14,19 @@
 
 #include "xls/jit/proc_jit.h"
 
+#include "absl/flags/flag.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/serial_proc_runtime.h"
 #include "xls/ir/proc.h"
 #include "xls/ir/type.h"
 #include "xls/ir/value.h"
+#include "xls/jit/jit_object_cache.h"
 #include "xls/jit/jit_runtime.h"
 
 namespace xls {
@@ -74,11 +77,52 @@ void ProcJitContinuation::NextTick() {
 
 absl::StatusOr<std::unique_ptr<ProcJit>> ProcJit::Create(
     Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr) {
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<OrcJit> orc_jit, OrcJit::Create());
+  return CreateInternal(proc, jit_runtime, queue_mgr, /*opt_level=*/3,
+                        /*tiering=*/std::nullopt);
+}
+
+absl::StatusOr<std::unique_ptr<ProcJit>> ProcJit::CreateTiered(
+    Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr,
+    const JitTieringOptions& options) {
+  return CreateInternal(proc, jit_runtime, queue_mgr,
+                        options.initial_opt_level, options);
+}
+
+absl::StatusOr<ProcJitObjectCode> ProcJit::CreateObjectCode(
+    Proc* proc, int64_t opt_level) {
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<OrcJit> orc_jit,
+      OrcJit::Create(opt_level, /*emit_object_code=*/true));
+  XLS_ASSIGN_OR_RETURN(
+      JittedFunctionBase jitted_function_base,
+      BuildProcFunction(proc, /*queue_mgr=*/nullptr, *orc_jit));
+  return ProcJitObjectCode{
+      .function_name = jitted_function_base.function_name,
+      .object_code = orc_jit->GetObjectCode(),
+      .param_buffer_sizes = jitted_function_base.input_buffer_sizes,
+      .temp_buffer_size = jitted_function_base.temp_buffer_size,
+      .continuation_points = jitted_function_base.continuation_points,
+  };
+}
+
+absl::StatusOr<std::unique_ptr<ProcJit>> ProcJit::CreateInternal(
+    Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr,
+    int64_t opt_level, std::optional<JitTieringOptions> tiering) {
+  XLS_ASSIGN_OR_RETURN(
+      std::unique_ptr<OrcJit> orc_jit,
+      OrcJit::Create(opt_level, /*emit_object_code=*/false,
+                     JitObjectCache::GetDefault(),
+                     absl::GetFlag(FLAGS_jit_compile_threads)));
   auto jit =
       absl::WrapUnique(new ProcJit(proc, jit_runtime, std::move(orc_jit)));
+  absl::Time start = absl::Now();
   XLS_ASSIGN_OR_RETURN(jit->jitted_function_base_,
                        BuildProcFunction(proc, queue_mgr, jit->GetOrcJit()));
+  jit->tiered_jit_ = TieredJit::Create(
+      &jit->jitted_function_base_, opt_level, absl::Now() - start, tiering,
+      [proc, queue_mgr](OrcJit& orc_jit) {
+        return BuildProcFunction(proc, queue_mgr, orc_jit);
+      });
   return jit;
 }
 
@@ -95,7 +139,7 @@ absl::StatusOr<TickResult> ProcJit::Tick(ProcContinuation& continuation) const {
 
   // The jitted function returns the early exit point at which execution
   // halted. A return value of zero indicates that the tick completed.
-  int64_t next_continuation_point = jitted_function_base_.function(
+  int64_t next_continuation_point = tiered_jit_->Invoke().function(
       cont->GetInputBuffers().data(), cont->GetOutputBuffers().data(),
       cont->GetTempBuffer().data(), &cont->GetEvents(),
       /*user_data=*/nullptr, runtime(), cont->GetContinuationPoint());
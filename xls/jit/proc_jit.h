@@ -15,6 +15,12 @@
 #ifndef XLS_JIT_PROC_JIT_H_
 #define XLS_JIT_PROC_JIT_H_
 
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "xls/common/status/status_macros.h"
@@ -27,6 +33,7 @@
 #include "xls/jit/jit_channel_queue.h"
 #include "xls/jit/jit_runtime.h"
 #include "xls/jit/orc_jit.h"
+#include "xls/jit/tiered_jit.h"
 
 namespace xls {
 
@@ -86,15 +93,50 @@ class ProcJitContinuation : public ProcContinuation {
   std::vector<uint8_t> temp_buffer_;
 };
 
+// Object code of a proc compiled ahead of time along with the metadata needed
+// to call it. The code accesses channels through the
+// aot_compile::ProcChannelCallbacks passed as the user data argument.
+struct ProcJitObjectCode {
+  // Name of the top-level jitted function in the object code.
+  std::string function_name;
+  std::vector<uint8_t> object_code;
+
+  // Sizes of the buffers holding the proc parameters (the token followed by
+  // the state elements). The next state is written to buffers of the same
+  // sizes.
+  std::vector<int64_t> param_buffer_sizes;
+
+  // Minimum size of the temporary buffer passed to the jitted function.
+  int64_t temp_buffer_size;
+
+  // Map from the continuation point returned by the jitted function to the
+  // send or receive node at which execution was interrupted.
+  absl::flat_hash_map<int64_t, Node*> continuation_points;
+};
+
 // This class provides a facility to execute XLS procs (on the host) by
 // converting them to LLVM IR, compiling it, and finally executing it.
 class ProcJit : public ProcEvaluator {
  public:
   // Returns an object containing a host-compiled version of the specified XLS
-  // proc.
+  // proc. The compiled code is taken from (or added to) the object cache given
+  // by --jit_object_cache_dir, if any.
   static absl::StatusOr<std::unique_ptr<ProcJit>> Create(
       Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr);
 
+  // As Create but the proc is compiled at `options.initial_opt_level` for a
+  // low latency to the first tick and recompiled at
+  // `options.optimized_opt_level` in the background once it has been ticked
+  // `options.invocation_threshold` times. The optimized code is used as soon
+  // as it is ready, including by continuations of partially executed ticks.
+  static absl::StatusOr<std::unique_ptr<ProcJit>> CreateTiered(
+      Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr,
+      const JitTieringOptions& options = JitTieringOptions());
+
+  // Returns the object code of the given proc for ahead-of-time compilation.
+  static absl::StatusOr<ProcJitObjectCode> CreateObjectCode(
+      Proc* proc, int64_t opt_level = 3);
+
   virtual ~ProcJit() = default;
 
   std::unique_ptr<ProcContinuation> NewContinuation() const override;
@@ -106,15 +148,32 @@ class ProcJit : public ProcEvaluator {
 
   OrcJit& GetOrcJit() { return *orc_jit_; }
 
+  // Returns the optimization level of the code currently used and the
+  // compilation times.
+  JitStats GetJitStats() const { return tiered_jit_->GetStats(); }
+
+  // Blocks until the background optimized build of a proc created with
+  // CreateTiered (if started) has completed.
+  void WaitForOptimizedBuild() { tiered_jit_->WaitForOptimizedBuild(); }
+
  private:
   explicit ProcJit(Proc* proc, JitRuntime* jit_runtime,
                    std::unique_ptr<OrcJit> orc_jit)
       : proc_(proc), jit_runtime_(jit_runtime), orc_jit_(std::move(orc_jit)) {}
 
+  static absl::StatusOr<std::unique_ptr<ProcJit>> CreateInternal(
+      Proc* proc, JitRuntime* jit_runtime, JitChannelQueueManager* queue_mgr,
+      int64_t opt_level, std::optional<JitTieringOptions> tiering);
+
   Proc* proc_;
   JitRuntime* jit_runtime_;
   std::unique_ptr<OrcJit> orc_jit_;
   JittedFunctionBase jitted_function_base_;
+
+  // Selects between `jitted_function_base_` and its optimized build, if tiered.
+  // Declared last so a background build completes before the other members are
+  // destroyed.
+  std::unique_ptr<TieredJit> tiered_jit_;
 };
 
 }  // namespace xls
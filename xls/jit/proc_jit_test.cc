@@ -50,5 +50,24 @@ INSTANTIATE_TEST_SUITE_P(
           return JitChannelQueueManager::CreateThreadSafe(package).value();
         })));
 
+// As above with tiered compilation. The optimized build starts immediately so
+// it may be swapped in at any point, including in the middle of a tick.
+INSTANTIATE_TEST_SUITE_P(
+    ProcJitTieredTest, ProcEvaluatorTestBase,
+    testing::Values(ProcEvaluatorTestParam(
+        [](Proc* proc, ChannelQueueManager* queue_manager)
+            -> std::unique_ptr<ProcEvaluator> {
+          JitChannelQueueManager* jit_queue_manager =
+              dynamic_cast<JitChannelQueueManager*>(queue_manager);
+          XLS_CHECK(jit_queue_manager != nullptr);
+          return ProcJit::CreateTiered(
+                     proc, GetJitRuntime(), jit_queue_manager,
+                     JitTieringOptions{.invocation_threshold = 0})
+              .value();
+        },
+        [](Package* package) -> std::unique_ptr<ChannelQueueManager> {
+          return JitChannelQueueManager::CreateThreadSafe(package).value();
+        })));
+
 }  // namespace
 }  // namespace xls
@@ -0,0 +1,139 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/tiered_jit.h"
+
+#include "absl/flags/flag.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/jit/jit_object_cache.h"
+
+namespace xls {
+namespace {
+
+// Returns whether the given builds of a function can be used interchangeably
+// with the same buffers and continuations.
+bool HaveSameLayout(const JittedFunctionBase& a, const JittedFunctionBase& b) {
+  return a.input_buffer_sizes == b.input_buffer_sizes &&
+         a.output_buffer_sizes == b.output_buffer_sizes &&
+         a.packed_input_buffer_sizes == b.packed_input_buffer_sizes &&
+         a.packed_output_buffer_sizes == b.packed_output_buffer_sizes &&
+         a.temp_buffer_size == b.temp_buffer_size &&
+         a.continuation_points == b.continuation_points &&
+         a.packed_function.has_value() == b.packed_function.has_value() &&
+         a.batched_function.has_value() == b.batched_function.has_value();
+}
+
+}  // namespace
+
+std::string JitStats::ToString() const {
+  std::string optimized =
+      optimized_compile_time.has_value()
+          ? absl::FormatDuration(*optimized_compile_time)
+          : "none";
+  return absl::StrFormat(
+      "opt level: %d, invocations: %d, compile time: %s, optimized compile "
+      "time: %s",
+      opt_level, invocation_count, absl::FormatDuration(compile_time),
+      optimized);
+}
+
+/* static */
+std::unique_ptr<TieredJit> TieredJit::Create(
+    const JittedFunctionBase* initial, int64_t initial_opt_level,
+    absl::Duration initial_compile_time,
+    std::optional<JitTieringOptions> tiering, BuildFn build_fn) {
+  auto tiered_jit = absl::WrapUnique(
+      new TieredJit(initial, initial_opt_level, initial_compile_time, tiering,
+                    std::move(build_fn)));
+  if (tiering.has_value() && tiering->invocation_threshold <= 0) {
+    tiered_jit->StartOptimizedBuild();
+  }
+  return tiered_jit;
+}
+
+TieredJit::~TieredJit() {
+  WaitForOptimizedBuild();
+  absl::MutexLock lock(&mutex_);
+  if (thread_ != nullptr) {
+    thread_->Join();
+  }
+}
+
+void TieredJit::WaitForOptimizedBuild() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (thread_ == nullptr) {
+      return;
+    }
+  }
+  optimized_build_done_.WaitForNotification();
+}
+
+void TieredJit::StartOptimizedBuild() {
+  absl::MutexLock lock(&mutex_);
+  if (thread_ != nullptr) {
+    return;
+  }
+  thread_ = std::make_unique<Thread>([this]() {
+    BuildOptimized();
+    optimized_build_done_.Notify();
+  });
+}
+
+void TieredJit::BuildOptimized() {
+  absl::Time start = absl::Now();
+  absl::StatusOr<std::unique_ptr<OrcJit>> orc_jit = OrcJit::Create(
+      tiering_->optimized_opt_level, /*emit_object_code=*/false,
+      JitObjectCache::GetDefault(), absl::GetFlag(FLAGS_jit_compile_threads));
+  absl::StatusOr<JittedFunctionBase> optimized =
+      orc_jit.ok() ? build_fn_(**orc_jit) : orc_jit.status();
+  if (!optimized.ok()) {
+    XLS_LOG(WARNING) << "Optimized build of " << initial_->function_name
+                     << " failed; continuing at opt level "
+                     << initial_opt_level_ << ": " << optimized.status();
+    return;
+  }
+  if (!HaveSameLayout(*initial_, *optimized)) {
+    XLS_LOG(WARNING) << "Optimized build of " << initial_->function_name
+                     << " has a different buffer layout; continuing at opt "
+                        "level "
+                     << initial_opt_level_;
+    return;
+  }
+  optimized_orc_jit_ = std::move(orc_jit).value();
+  optimized_ = std::move(optimized).value();
+  optimized_compile_time_ = absl::Now() - start;
+  XLS_VLOG(1) << absl::StreamFormat(
+      "Swapped in optimized build of %s (opt level %d) after %d invocations, "
+      "compiled in %s",
+      optimized_.function_name, tiering_->optimized_opt_level,
+      invocation_count_.load(), absl::FormatDuration(optimized_compile_time_));
+  current_.store(&optimized_, std::memory_order_release);
+}
+
+JitStats TieredJit::GetStats() const {
+  JitStats stats{.opt_level = initial_opt_level_,
+                 .invocation_count = invocation_count_.load(),
+                 .compile_time = initial_compile_time_};
+  if (current_.load(std::memory_order_acquire) == &optimized_) {
+    stats.opt_level = tiering_->optimized_opt_level;
+    stats.optimized_compile_time = optimized_compile_time_;
+  }
+  return stats;
+}
+
+}  // namespace xls
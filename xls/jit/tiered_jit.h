@@ -0,0 +1,153 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_TIERED_JIT_H_
+#define XLS_JIT_TIERED_JIT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "xls/common/thread.h"
+#include "xls/jit/function_base_jit.h"
+#include "xls/jit/orc_jit.h"
+
+namespace xls {
+
+// Options for tiered compilation in which a function is first compiled quickly
+// at a low optimization level and recompiled at a high optimization level in
+// the background once it has proven to be hot.
+struct JitTieringOptions {
+  // Optimization level of the initial build.
+  int64_t initial_opt_level = 0;
+
+  // Optimization level of the build which replaces the initial build.
+  int64_t optimized_opt_level = 3;
+
+  // Number of invocations after which the optimized build is started. If zero
+  // the optimized build is started immediately.
+  int64_t invocation_threshold = 1000;
+};
+
+// Statistics about the compilation and execution of a jitted function.
+struct JitStats {
+  // Optimization level of the code currently being executed.
+  int64_t opt_level;
+
+  // Number of invocations of the jitted function.
+  int64_t invocation_count;
+
+  // Time taken to build the initial code.
+  absl::Duration compile_time;
+
+  // Time taken to build the optimized code, if it has replaced the initial
+  // code.
+  std::optional<absl::Duration> optimized_compile_time;
+
+  std::string ToString() const;
+};
+
+// Tracks the invocations of a jitted FunctionBase and (optionally) swaps in an
+// optimized build of it once it has been invoked a given number of times. The
+// optimized build is compiled on a background thread and replaces the initial
+// build atomically so invocations never wait on compilation. Builds which are
+// replaced are kept alive as they may still be executing on other threads.
+//
+// The jitted function must have the same buffer layout (sizes of inputs,
+// outputs and temporary buffer, and continuation points) at each optimization
+// level. This holds as the layout is determined before LLVM optimization; an
+// optimized build with a different layout is discarded.
+class TieredJit {
+ public:
+  // Builds the given FunctionBase with the given OrcJit. Called on a
+  // background thread; the IR must not be modified while a build is in
+  // progress.
+  using BuildFn = std::function<absl::StatusOr<JittedFunctionBase>(OrcJit&)>;
+
+  // `initial` is the initial build of the function which was compiled at
+  // `initial_opt_level` in `initial_compile_time`. It must outlive this
+  // object. If `tiering` is not set then the initial build is never replaced.
+  static std::unique_ptr<TieredJit> Create(
+      const JittedFunctionBase* initial, int64_t initial_opt_level,
+      absl::Duration initial_compile_time,
+      std::optional<JitTieringOptions> tiering, BuildFn build_fn);
+
+  // Waits for the optimized build, if any, to complete.
+  ~TieredJit();
+
+  // Counts an invocation of the function and returns the build to invoke.
+  // Thread-safe.
+  const JittedFunctionBase& Invoke() {
+    int64_t count =
+        invocation_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (tiering_.has_value() && count == tiering_->invocation_threshold) {
+      StartOptimizedBuild();
+    }
+    return *current_.load(std::memory_order_acquire);
+  }
+
+  // Blocks until the optimized build (if it was started) has completed.
+  // Thread-safe.
+  void WaitForOptimizedBuild();
+
+  JitStats GetStats() const;
+
+ private:
+  TieredJit(const JittedFunctionBase* initial, int64_t initial_opt_level,
+            absl::Duration initial_compile_time,
+            std::optional<JitTieringOptions> tiering, BuildFn build_fn)
+      : initial_(initial),
+        initial_opt_level_(initial_opt_level),
+        initial_compile_time_(initial_compile_time),
+        tiering_(tiering),
+        build_fn_(std::move(build_fn)),
+        current_(initial) {}
+
+  void StartOptimizedBuild();
+  void BuildOptimized();
+
+  const JittedFunctionBase* initial_;
+  int64_t initial_opt_level_;
+  absl::Duration initial_compile_time_;
+  std::optional<JitTieringOptions> tiering_;
+  BuildFn build_fn_;
+
+  std::atomic<int64_t> invocation_count_ = 0;
+  std::atomic<const JittedFunctionBase*> current_;
+
+  // The optimized build. Written by the background thread before `current_` is
+  // updated to point to `optimized_`.
+  std::unique_ptr<OrcJit> optimized_orc_jit_;
+  JittedFunctionBase optimized_;
+  absl::Duration optimized_compile_time_;
+
+  // Background thread running the optimized build, started at most once.
+  // `optimized_build_done_` is notified once the build has finished, whether
+  // or not it succeeded.
+  absl::Mutex mutex_;
+  std::unique_ptr<Thread> thread_ ABSL_GUARDED_BY(mutex_);
+  absl::Notification optimized_build_done_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_JIT_TIERED_JIT_H_
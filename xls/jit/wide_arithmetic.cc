@@ -0,0 +1,52 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/jit/wide_arithmetic.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "xls/ir/word_arithmetic.h"
+
+extern "C" {
+
+void xls_jit_wide_umul(const uint64_t* lhs, const uint64_t* rhs,
+                       uint64_t* result, int64_t word_count) {
+  xls::word_arithmetic::TruncatedMul(lhs, rhs, word_count, result);
+}
+
+void xls_jit_wide_udivmod(const uint64_t* lhs, const uint64_t* rhs,
+                          uint64_t* quotient, uint64_t* remainder,
+                          int64_t word_count) {
+  if (xls::word_arithmetic::SignificantWordCount(rhs, word_count) == 0) {
+    std::fill(quotient, quotient + word_count, ~uint64_t{0});
+    std::fill(remainder, remainder + word_count, 0);
+    return;
+  }
+  xls::word_arithmetic::DivMod(lhs, word_count, rhs, word_count, quotient,
+                               remainder);
+}
+
+}  // extern "C"
+
+namespace xls {
+
+std::vector<std::pair<std::string_view, void*>> GetWideArithmeticSymbols() {
+  return {
+      {kWideUMulSymbol, reinterpret_cast<void*>(&xls_jit_wide_umul)},
+      {kWideUDivModSymbol, reinterpret_cast<void*>(&xls_jit_wide_udivmod)},
+  };
+}
+
+}  // namespace xls
@@ -0,0 +1,56 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_JIT_WIDE_ARITHMETIC_H_
+#define XLS_JIT_WIDE_ARITHMETIC_H_
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Entry points for arithmetic on wide bit vectors which are called from
+// JIT-compiled code. They wrap the kernels in xls/ir/word_arithmetic.h.
+// Operands and results are arrays of `word_count` 64-bit words in
+// little-endian word order, i.e., the native layout of an LLVM integer of width
+// 64 * `word_count` on a little-endian host. Output buffers may not alias the
+// inputs.
+extern "C" {
+
+// Sets `result` to the product of `lhs` and `rhs` truncated to `word_count`
+// words.
+void xls_jit_wide_umul(const uint64_t* lhs, const uint64_t* rhs,
+                       uint64_t* result, int64_t word_count);
+
+// Sets `quotient` and `remainder` to the unsigned quotient and remainder of
+// `lhs` divided by `rhs`. Matching XLS semantics, division by zero produces an
+// all-ones quotient and a zero remainder.
+void xls_jit_wide_udivmod(const uint64_t* lhs, const uint64_t* rhs,
+                          uint64_t* quotient, uint64_t* remainder,
+                          int64_t word_count);
+
+}  // extern "C"
+
+namespace xls {
+
+inline constexpr std::string_view kWideUMulSymbol = "xls_jit_wide_umul";
+inline constexpr std::string_view kWideUDivModSymbol = "xls_jit_wide_udivmod";
+
+// Returns the name and address of each of the kernels above. Used to define
+// the kernels in the JIT's symbol table.
+std::vector<std::pair<std::string_view, void*>> GetWideArithmeticSymbols();
+
+}  // namespace xls
+
+#endif  // XLS_JIT_WIDE_ARITHMETIC_H_
@@ -0,0 +1,138 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the JIT's word-level lowering of wide multiplies, divides and
+// shifts against LLVM's lowering of the same operations on wide integer types
+// (--nojit_wide_arithmetic).
+
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/reflection.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/file/filesystem.h"
+#include "xls/common/file/get_runfile_path.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/interpreter/random_value.h"
+#include "xls/ir/events.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_parser.h"
+#include "xls/ir/package.h"
+#include "xls/jit/function_jit.h"
+#include "xls/jit/ir_builder_visitor.h"
+
+namespace xls {
+namespace {
+
+struct BenchmarkFunction {
+  std::string_view ir_path;
+  // Substring of the name of the function to benchmark. If empty the top
+  // function of the package is used.
+  std::string_view function_name;
+};
+
+constexpr BenchmarkFunction kBenchmarkFunctions[] = {
+    {"xls/modules/fp/fp64_fma.opt.ir", ""},
+    {"xls/modules/aes/aes_gcm.ir", "gf128_mul"},
+};
+
+absl::StatusOr<Function*> GetBenchmarkFunction(
+    Package* package, const BenchmarkFunction& benchmark_function) {
+  if (benchmark_function.function_name.empty()) {
+    return package->GetTopAsFunction();
+  }
+  for (const std::unique_ptr<Function>& function : package->functions()) {
+    if (absl::StrContains(function->name(), benchmark_function.function_name)) {
+      return function.get();
+    }
+  }
+  return absl::NotFoundError(
+      absl::StrFormat("No function named `%s` in %s",
+                      benchmark_function.function_name,
+                      benchmark_function.ir_path));
+}
+
+absl::StatusOr<std::unique_ptr<Package>> LoadPackage(
+    const BenchmarkFunction& benchmark_function) {
+  XLS_ASSIGN_OR_RETURN(std::filesystem::path path,
+                       GetXlsRunfilePath(benchmark_function.ir_path));
+  XLS_ASSIGN_OR_RETURN(std::string ir, GetFileContents(path));
+  return Parser::ParsePackage(ir, path.string());
+}
+
+// Benchmark arguments are the index of the function in kBenchmarkFunctions and
+// whether to use the word-level lowering (1) or LLVM's lowering (0).
+void BM_RunWideArithmetic(benchmark::State& state) {
+  const BenchmarkFunction& benchmark_function =
+      kBenchmarkFunctions[state.range(0)];
+  std::unique_ptr<Package> package = LoadPackage(benchmark_function).value();
+  Function* function =
+      GetBenchmarkFunction(package.get(), benchmark_function).value();
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_jit_wide_arithmetic, state.range(1) != 0);
+  std::unique_ptr<FunctionJit> jit = FunctionJit::Create(function).value();
+  state.SetLabel(function->name());
+
+  // Run on buffers in the native layout so the measurement is not dominated by
+  // the conversion of Values.
+  std::minstd_rand bitgen;
+  std::vector<Value> args = RandomFunctionArguments(function, &bitgen);
+  std::vector<std::vector<uint8_t>> arg_buffers;
+  std::vector<uint8_t*> arg_ptrs;
+  for (int64_t i = 0; i < args.size(); ++i) {
+    arg_buffers.push_back(std::vector<uint8_t>(jit->GetArgTypeSize(i)));
+    jit->runtime()->BlitValueToBuffer(args[i], function->param(i)->GetType(),
+                                      absl::MakeSpan(arg_buffers.back()));
+    arg_ptrs.push_back(arg_buffers.back().data());
+  }
+  std::vector<uint8_t> result_buffer(jit->GetReturnTypeSize());
+  InterpreterEvents events;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        jit->RunWithViews(arg_ptrs, absl::MakeSpan(result_buffer), &events));
+  }
+}
+
+// LLVM's expansion of wide integer operations also affects compile time.
+void BM_CompileWideArithmetic(benchmark::State& state) {
+  const BenchmarkFunction& benchmark_function =
+      kBenchmarkFunctions[state.range(0)];
+  std::unique_ptr<Package> package = LoadPackage(benchmark_function).value();
+  Function* function =
+      GetBenchmarkFunction(package.get(), benchmark_function).value();
+  absl::FlagSaver flag_saver;
+  absl::SetFlag(&FLAGS_jit_wide_arithmetic, state.range(1) != 0);
+  state.SetLabel(function->name());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FunctionJit::Create(function).value());
+  }
+}
+
+BENCHMARK(BM_RunWideArithmetic)->ArgsProduct({{0, 1}, {0, 1}});
+BENCHMARK(BM_CompileWideArithmetic)
+    ->ArgsProduct({{0, 1}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
+
+}  // namespace
+}  // namespace xls
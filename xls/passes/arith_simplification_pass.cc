@@ -1116,10 +1116,9 @@ absl::StatusOr<bool> MatchArithPatterns(int64_t opt_level, Node* n) {
 
 }  // namespace
 
-absl::StatusOr<bool> ArithSimplificationPass::RunOnFunctionBaseInternal(
-    FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  return TransformNodesToFixedPoint(
-      f, [this](Node* n) { return MatchArithPatterns(opt_level_, n); });
+absl::StatusOr<bool> ArithSimplificationPass::RewriteNode(
+    Node* node, const PassOptions& options) const {
+  return MatchArithPatterns(opt_level_, node);
 }
 
 }  // namespace xls
@@ -24,19 +24,18 @@ namespace xls {
 // class ArithSimplificationPass analyzes the IR and finds some
 // simple patterns it can simplify, e.g., things like mul by 1,
 // add of 0, etc.
-class ArithSimplificationPass : public FunctionBasePass {
+class ArithSimplificationPass : public NodeRewritePass {
  public:
   ArithSimplificationPass(int64_t opt_level = kMaxOptLevel)
-      : FunctionBasePass("arith_simp", "Arithmetic Simplifications"),
+      : NodeRewritePass("arith_simp", "Arithmetic Simplifications"),
         opt_level_(opt_level) {}
   ~ArithSimplificationPass() override {}
 
+  absl::StatusOr<bool> RewriteNode(Node* node,
+                                   const PassOptions& options) const override;
+
  protected:
   int64_t opt_level_;
-
-  absl::StatusOr<bool> RunOnFunctionBaseInternal(
-      FunctionBase* f, const PassOptions& options,
-      PassResults* results) const override;
 };
 
 }  // namespace xls
@@ -14,6 +14,7 @@
 
 #include "xls/passes/bdd_function.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
@@ -36,6 +37,15 @@
 namespace xls {
 namespace {
 
+// Garbage in the BDD (intermediate results of the evaluation) is collected
+// once the BDD exceeds this many nodes and after that whenever it has doubled
+// in size since the previous collection.
+constexpr int64_t kMinGarbageCollectionSize = 64 * 1024;
+
+// Similarly, the variables of the BDD are reordered once this many nodes
+// survive a garbage collection and after that whenever that number doubles.
+constexpr int64_t kMinReorderSize = 256 * 1024;
+
 // Construct a BDD-based abstract evaluator. The expressions in the BDD
 // saturates at a particular number of paths from the expression node to the
 // terminal nodes 0 and 1 in the BDD. When the path limit is met, a new BDD
@@ -271,7 +281,10 @@ bool ShouldEvaluate(Node* node) {
   XLS_VLOG_LINES(5, f->DumpIr());
 
   auto bdd_function = absl::WrapUnique(new BddFunction(f));
-  SaturatingBddEvaluator evaluator(path_limit, &bdd_function->bdd());
+  BinaryDecisionDiagram& bdd = bdd_function->bdd();
+  SaturatingBddEvaluator evaluator(path_limit, &bdd);
+  int64_t garbage_collection_size = kMinGarbageCollectionSize;
+  int64_t reorder_size = kMinReorderSize;
 
   // Create and return a vector containing newly defined BDD variables.
   auto create_new_node_vector = [&](Node* n) {
@@ -321,6 +334,23 @@ bool ShouldEvaluate(Node* node) {
         }
       }
     }
+
+    // The values of all nodes are kept so they are referenced. Everything
+    // else is garbage. Reordering reduces the size of the BDD and generally
+    // the number of paths of expressions, so fewer later expressions exceed
+    // the path limit.
+    for (const SaturatingBddNodeIndex& value : values.at(node)) {
+      bdd.IncRef(std::get<BddNodeIndex>(value));
+    }
+    if (bdd.size() > garbage_collection_size) {
+      bdd.GarbageCollect();
+      if (bdd.size() > reorder_size) {
+        bdd.Reorder();
+        reorder_size = std::max(kMinReorderSize, 2 * bdd.size());
+      }
+      garbage_collection_size =
+          std::max(kMinGarbageCollectionSize, 2 * bdd.size());
+    }
     XLS_VLOG(5) << "  " << node->GetName() << ":";
     for (int64_t i = 0; i < node->BitCountOrDie(); ++i) {
       XLS_VLOG(5) << absl::StreamFormat(
@@ -331,6 +361,8 @@ bool ShouldEvaluate(Node* node) {
     }
   }
 
+  bdd.GarbageCollect();
+
   // Copy over the vector and BDD variables into the node map which is exposed
   // via the BddFunction interface. At this point any TooManyPaths sentinel
   // values have been replaced with new Bdd variables.
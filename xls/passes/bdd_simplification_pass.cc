@@ -35,6 +35,7 @@
 #include "xls/ir/nodes.h"
 #include "xls/passes/bdd_query_engine.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/query_engine_cache.h"
 
 namespace xls {
 
@@ -327,18 +328,20 @@ absl::StatusOr<bool> SimplifyNode(Node* node, const QueryEngine& query_engine,
 
 absl::StatusOr<bool> BddSimplificationPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  BddQueryEngine query_engine(BddFunction::kDefaultPathLimit);
-  XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
+  XLS_ASSIGN_OR_RETURN(BddQueryEngine * query_engine,
+                       QueryEngineCache::Get(results).GetBddQueryEngine(
+                           f, BddFunction::kDefaultPathLimit,
+                           /*cheap_nodes_only=*/false));
 
   bool modified = false;
   for (Node* node : TopoSort(f)) {
     XLS_ASSIGN_OR_RETURN(bool node_modified,
-                         SimplifyNode(node, query_engine, opt_level_));
+                         SimplifyNode(node, *query_engine, opt_level_));
     modified |= node_modified;
   }
 
   XLS_ASSIGN_OR_RETURN(bool selects_collapsed,
-                       CollapseSelectChains(f, query_engine));
+                       CollapseSelectChains(f, *query_engine));
 
   return modified || selects_collapsed;
 }
@@ -276,10 +276,9 @@ absl::StatusOr<bool> CanonicalizeNode(Node* n) {
   return false;
 }
 
-absl::StatusOr<bool> CanonicalizationPass::RunOnFunctionBaseInternal(
-    FunctionBase* func, const PassOptions& options,
-    PassResults* results) const {
-  return TransformNodesToFixedPoint(func, CanonicalizeNode);
+absl::StatusOr<bool> CanonicalizationPass::RewriteNode(
+    Node* node, const PassOptions& options) const {
+  return CanonicalizeNode(node);
 }
 
 }  // namespace xls
@@ -28,16 +28,14 @@ namespace xls {
 // between a node and a literal, the literal should only be the
 // 2nd operand. This preprocessing of the IR helps to simplify
 // later passes.
-class CanonicalizationPass : public FunctionBasePass {
+class CanonicalizationPass : public NodeRewritePass {
  public:
   explicit CanonicalizationPass()
-      : FunctionBasePass("canon", "Canonicalization") {}
+      : NodeRewritePass("canon", "Canonicalization") {}
   ~CanonicalizationPass() override {}
 
- protected:
-  absl::StatusOr<bool> RunOnFunctionBaseInternal(
-      FunctionBase* f, const PassOptions& options,
-      PassResults* results) const override;
+  absl::StatusOr<bool> RewriteNode(Node* node,
+                                   const PassOptions& options) const override;
 };
 
 }  // namespace xls
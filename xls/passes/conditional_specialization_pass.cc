@@ -14,12 +14,14 @@
 
 #include "xls/passes/conditional_specialization_pass.h"
 
+#include "absl/container/btree_set.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/node_iterator.h"
 #include "xls/passes/bdd_function.h"
 #include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/query_engine_cache.h"
 
 namespace xls {
 namespace {
@@ -258,11 +260,12 @@ Node* GetSelectedCase(Select* select, const Bits& selector_value) {
 
 absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  std::unique_ptr<BddQueryEngine> query_engine;
+  BddQueryEngine* query_engine = nullptr;
   if (use_bdd_) {
-    query_engine = std::make_unique<BddQueryEngine>(
-        BddFunction::kDefaultPathLimit, IsCheapForBdds);
-    XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
+    XLS_ASSIGN_OR_RETURN(query_engine,
+                         QueryEngineCache::Get(results).GetBddQueryEngine(
+                             f, BddFunction::kDefaultPathLimit,
+                             /*cheap_nodes_only=*/true));
   }
 
   ConditionMap condition_map(f);
@@ -335,7 +338,7 @@ absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
       // First check to see if the condition set directly implies a value for
       // the operand. If so replace with the implied value.
       if (std::optional<Bits> implied_value =
-              ImpliedNodeValue(edge_set, operand, query_engine.get());
+              ImpliedNodeValue(edge_set, operand, query_engine);
           implied_value.has_value()) {
         XLS_VLOG(3) << absl::StreamFormat("Replacing operand %d of %s with %s",
                                           operand_no, node->GetName(),
@@ -376,7 +379,7 @@ absl::StatusOr<bool> ConditionalSpecializationPass::RunOnFunctionBaseInternal(
             break;
           }
           std::optional<Bits> implied_selector = ImpliedNodeValue(
-              edge_set, select->selector(), query_engine.get());
+              edge_set, select->selector(), query_engine);
           if (!implied_selector.has_value()) {
             break;
           }
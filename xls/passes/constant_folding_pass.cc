@@ -27,26 +27,33 @@ absl::StatusOr<bool> ConstantFoldingPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
   bool changed = false;
   for (Node* node : TopoSort(f)) {
-    // Fold any non-side-effecting op with constant paramters. Avoid any types
-    // with tokens because literal tokens are not allowed.
-    // TODO(meheff): 2019/6/26 Consider not folding loops with large trip counts
-    // to avoid hanging at compile time.
-    if (!node->Is<Literal>() && !TypeHasToken(node->GetType()) &&
-        !OpIsSideEffecting(node->op()) &&
-        std::all_of(node->operands().begin(), node->operands().end(),
-                    [](Node* o) { return o->Is<Literal>(); })) {
-      XLS_VLOG(2) << "Folding: " << *node;
-      std::vector<Value> operand_values;
-      for (Node* operand : node->operands()) {
-        operand_values.push_back(operand->As<Literal>()->value());
-      }
-      XLS_ASSIGN_OR_RETURN(Value result, InterpretNode(node, operand_values));
-      XLS_RETURN_IF_ERROR(node->ReplaceUsesWithNew<Literal>(result).status());
-      changed = true;
-    }
+    XLS_ASSIGN_OR_RETURN(bool node_changed, RewriteNode(node, options));
+    changed = changed || node_changed;
   }
 
   return changed;
 }
 
+absl::StatusOr<bool> ConstantFoldingPass::RewriteNode(
+    Node* node, const PassOptions& options) const {
+  // Fold any non-side-effecting op with constant paramters. Avoid any types
+  // with tokens because literal tokens are not allowed.
+  // TODO(meheff): 2019/6/26 Consider not folding loops with large trip counts
+  // to avoid hanging at compile time.
+  if (node->Is<Literal>() || TypeHasToken(node->GetType()) ||
+      OpIsSideEffecting(node->op()) ||
+      !std::all_of(node->operands().begin(), node->operands().end(),
+                   [](Node* o) { return o->Is<Literal>(); })) {
+    return false;
+  }
+  XLS_VLOG(2) << "Folding: " << *node;
+  std::vector<Value> operand_values;
+  for (Node* operand : node->operands()) {
+    operand_values.push_back(operand->As<Literal>()->value());
+  }
+  XLS_ASSIGN_OR_RETURN(Value result, InterpretNode(node, operand_values));
+  XLS_RETURN_IF_ERROR(node->ReplaceUsesWithNew<Literal>(result).status());
+  return true;
+}
+
 }  // namespace xls
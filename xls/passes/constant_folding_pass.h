@@ -23,12 +23,18 @@ namespace xls {
 
 // Pass which performs constant folding. Every op with only literal operands is
 // replaced by a equivalent literal. Runs DCE after constant folding.
-class ConstantFoldingPass : public FunctionBasePass {
+class ConstantFoldingPass : public NodeRewritePass {
  public:
-  ConstantFoldingPass() : FunctionBasePass("const_fold", "Constant folding") {}
+  ConstantFoldingPass() : NodeRewritePass("const_fold", "Constant folding") {}
   ~ConstantFoldingPass() override {}
 
+  // Replaces the node with a literal if all of its operands are literals.
+  absl::StatusOr<bool> RewriteNode(Node* node,
+                                   const PassOptions& options) const override;
+
  protected:
+  // Folds nodes in a single pass in topological order which reaches a fixed
+  // point because folded values are propagated forward.
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
       FunctionBase* f, const PassOptions& options,
       PassResults* results) const override;
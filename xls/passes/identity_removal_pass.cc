@@ -25,12 +25,19 @@ absl::StatusOr<bool> IdentityRemovalPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
   bool changed = false;
   for (Node* node : f->nodes()) {
-    if (node->op() == Op::kIdentity) {
-      XLS_RETURN_IF_ERROR(node->ReplaceUsesWith(node->operand(0)));
-      changed = true;
-    }
+    XLS_ASSIGN_OR_RETURN(bool node_changed, RewriteNode(node, options));
+    changed = changed || node_changed;
   }
   return changed;
 }
 
+absl::StatusOr<bool> IdentityRemovalPass::RewriteNode(
+    Node* node, const PassOptions& options) const {
+  if (node->op() != Op::kIdentity) {
+    return false;
+  }
+  XLS_RETURN_IF_ERROR(node->ReplaceUsesWith(node->operand(0)));
+  return true;
+}
+
 }  // namespace xls
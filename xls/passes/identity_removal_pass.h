@@ -26,12 +26,16 @@ namespace xls {
 // class IdentityRemovalPass eliminates all identity() expressions
 // by forward substituting it's parameters to the uses of the
 // identity's def.
-class IdentityRemovalPass : public FunctionBasePass {
+class IdentityRemovalPass : public NodeRewritePass {
  public:
   IdentityRemovalPass()
-      : FunctionBasePass("ident_remove", "Identity Removal") {}
+      : NodeRewritePass("ident_remove", "Identity Removal") {}
   ~IdentityRemovalPass() override {}
 
+  // Replaces the uses of the node with its operand if it is an identity.
+  absl::StatusOr<bool> RewriteNode(Node* node,
+                                   const PassOptions& options) const override;
+
  protected:
   // Iterate all nodes and eliminate identities.
   absl::StatusOr<bool> RunOnFunctionBaseInternal(
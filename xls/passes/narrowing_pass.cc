@@ -15,6 +15,8 @@
 #include "xls/passes/narrowing_pass.h"
 
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/math_util.h"
 #include "xls/common/status/ret_check.h"
@@ -23,9 +25,11 @@
 #include "xls/ir/node_iterator.h"
 #include "xls/ir/node_util.h"
 #include "xls/ir/op.h"
+#include "xls/ir/proc.h"
 #include "xls/ir/ternary.h"
 #include "xls/ir/value_helpers.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/query_engine_cache.h"
 #include "xls/passes/range_query_engine.h"
 #include "xls/passes/ternary_query_engine.h"
 #include "xls/passes/union_query_engine.h"
@@ -907,32 +911,79 @@ absl::StatusOr<bool> MaybeReplacePreciseWithLiteral(
   return true;
 }
 
+// Narrows the bits-typed state elements of `proc` whose values are known to
+// have leading zeros (the ranges of state parameters computed by range analysis
+// are an invariant of the next-state relation). The element is replaced by one
+// holding only the low bits which is zero-extended at its uses. State elements
+// with a single possible value are replaced by literals.
+static absl::StatusOr<bool> NarrowStateElements(
+    Proc* proc, const QueryEngine& query_engine) {
+  bool modified = false;
+  for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+    Param* param = proc->GetStateParam(i);
+    if (!param->GetType()->IsBits() || param->users().empty() ||
+        !query_engine.IsTracked(param)) {
+      continue;
+    }
+    XLS_ASSIGN_OR_RETURN(bool replaced,
+                         MaybeReplacePreciseWithLiteral(param, query_engine));
+    if (replaced) {
+      modified = true;
+      continue;
+    }
+    int64_t width = param->BitCountOrDie();
+    int64_t narrow_width = width - CountLeadingKnownZeros(param, query_engine);
+    if (narrow_width == width || narrow_width == 0) {
+      continue;
+    }
+    XLS_VLOG(3) << absl::StreamFormat(
+        "Narrowing state element %s of proc %s from %d to %d bits",
+        param->GetName(), proc->name(), width, narrow_width);
+    Value narrow_init(
+        proc->GetInitValueElement(i).bits().Slice(0, narrow_width));
+    XLS_ASSIGN_OR_RETURN(
+        Param * narrow_param,
+        proc->InsertStateElement(i + 1, absl::StrCat(param->name(), "_narrow"),
+                                 narrow_init));
+    XLS_ASSIGN_OR_RETURN(
+        Node * extended,
+        proc->MakeNode<ExtendOp>(param->loc(), narrow_param, width,
+                                 Op::kZeroExt));
+    XLS_RETURN_IF_ERROR(param->ReplaceUsesWith(extended));
+    XLS_ASSIGN_OR_RETURN(
+        Node * narrow_next,
+        proc->MakeNode<BitSlice>(param->loc(), proc->GetNextStateElement(i),
+                                 /*start=*/0, narrow_width));
+    XLS_RETURN_IF_ERROR(proc->SetNextStateElement(i + 1, narrow_next));
+    XLS_RETURN_IF_ERROR(proc->RemoveStateElement(i));
+    modified = true;
+  }
+  return modified;
+}
+
+// Returns a query engine combining the engines for `f` held by the cache. The
+// returned engine is already populated.
 static absl::StatusOr<std::unique_ptr<QueryEngine>> GetQueryEngine(
-    FunctionBase* f, bool use_range_analysis) {
-  std::unique_ptr<QueryEngine> query_engine;
+    FunctionBase* f, bool use_range_analysis, QueryEngineCache& cache) {
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * ternary_query_engine,
+                       cache.GetTernaryQueryEngine(f));
+  std::vector<QueryEngine*> engines = {ternary_query_engine};
   if (use_range_analysis) {
-    auto ternary_query_engine = std::make_unique<TernaryQueryEngine>();
-    auto range_query_engine = std::make_unique<RangeQueryEngine>();
-
+    XLS_ASSIGN_OR_RETURN(RangeQueryEngine * range_query_engine,
+                         cache.GetRangeQueryEngine(f));
     if (XLS_VLOG_IS_ON(3)) {
       RangeAnalysisLog(f, *ternary_query_engine, *range_query_engine);
     }
-
-    std::vector<std::unique_ptr<QueryEngine>> engines;
-    engines.push_back(std::move(ternary_query_engine));
-    engines.push_back(std::move(range_query_engine));
-    query_engine = std::make_unique<UnionQueryEngine>(std::move(engines));
-  } else {
-    query_engine = std::make_unique<TernaryQueryEngine>();
+    engines.push_back(range_query_engine);
   }
-  XLS_RETURN_IF_ERROR(query_engine->Populate(f).status());
-  return std::move(query_engine);
+  return std::make_unique<UnionQueryEngine>(std::move(engines));
 }
 
 absl::StatusOr<bool> NarrowingPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<QueryEngine> query_engine,
-                       GetQueryEngine(f, use_range_analysis_));
+                       GetQueryEngine(f, use_range_analysis_,
+                                      QueryEngineCache::Get(results)));
 
   bool modified = false;
 
@@ -1003,6 +1054,14 @@ absl::StatusOr<bool> NarrowingPass::RunOnFunctionBaseInternal(
     }
     modified |= node_modified;
   }
+
+  // Only range analysis knows anything about proc state.
+  if (use_range_analysis_ && f->IsProc()) {
+    XLS_ASSIGN_OR_RETURN(
+        bool state_modified,
+        NarrowStateElements(f->AsProcOrDie(), *query_engine));
+    modified |= state_modified;
+  }
   return modified;
 }
 
@@ -21,6 +21,7 @@
 #include "xls/ir/function_builder.h"
 #include "xls/ir/ir_matcher.h"
 #include "xls/ir/ir_test_base.h"
+#include "xls/ir/proc.h"
 #include "xls/passes/pass_base.h"
 
 namespace m = ::xls::op_matchers;
@@ -545,6 +546,30 @@ TEST_P(NarrowingPassTest, SideEffectfulButNarrowable) {
   ASSERT_THAT(Run(p.get()), IsOkAndHolds(false));
 }
 
+TEST_P(NarrowingPassTest, NarrowProcState) {
+  auto p = CreatePackage();
+  TokenlessProcBuilder pb(TestName(), "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 32)));
+  BValue next = pb.ZeroExtend(
+      pb.BitSlice(pb.Add(x, pb.Literal(UBits(1, 32))), /*start=*/0,
+                  /*width=*/4),
+      32);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({next}));
+
+  if (/*use_range_analysis=*/GetParam()) {
+    // The state never exceeds 15 so only its low four bits are stored.
+    ASSERT_THAT(Run(p.get()), IsOkAndHolds(true));
+    ASSERT_EQ(proc->GetStateElementCount(), 1);
+    EXPECT_EQ(proc->GetStateElementType(0), p->GetBitsType(4));
+    EXPECT_EQ(proc->GetInitValueElement(0), Value(UBits(0, 4)));
+    EXPECT_THAT(proc->GetNextStateElement(0),
+                m::BitSlice(/*start=*/0, /*width=*/4));
+  } else {
+    ASSERT_THAT(Run(p.get()), IsOkAndHolds(false));
+    EXPECT_EQ(proc->GetStateElementType(0), p->GetBitsType(32));
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
     NarrowingPassTestInstantiation, NarrowingPassTest,
     testing::Values(false, true),
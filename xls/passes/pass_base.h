@@ -33,11 +33,14 @@
 #include "xls/common/logging/log_lines.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread_pool.h"
 #include "xls/ir/function.h"
 #include "xls/ir/package.h"
 
 namespace xls {
 
+class QueryEngineCache;
+
 // This file defines a set of base classes for building XLS compiler passes and
 // pass pipelines. The base classes are templated allowing polymorphism of the
 // data types the pass operates on.
@@ -70,6 +73,15 @@ struct PassOptions {
   // chains of selects. Otherwise, this optimization is skipped, since it can
   // sometimes reduce output quality.
   std::optional<int64_t> convert_array_index_to_select = std::nullopt;
+
+  // Pool of threads with which function-level passes (FunctionBasePass)
+  // process the functions and procs of a package. If null, everything runs on
+  // the calling thread. The pool is shared by every pass in a pipeline so
+  // threads are not created per pass invocation. Each pass invocation is a
+  // barrier so package-level passes always see the whole package in a
+  // consistent state. Node ids (and so generated node names) may differ between
+  // runs when a pool is used.
+  std::shared_ptr<ThreadPool> function_thread_pool;
 };
 
 // An object containing information about the invocation of a pass (single call
@@ -90,6 +102,17 @@ struct PassInvocation {
 struct PassResults {
   // This vector contains and entry for each invocation of each pass.
   std::vector<PassInvocation> invocations;
+
+  // The total number of iterations run by fixed-point compound passes.
+  int64_t fixed_point_iterations = 0;
+
+  // The total number of nodes visited by worklist-driven rewrite passes (see
+  // WorklistRewritePass).
+  int64_t rewrite_node_visits = 0;
+
+  // Query engines shared by the passes of the run. Created on first use by
+  // QueryEngineCache::Get. Results should not be reused for another package.
+  std::shared_ptr<QueryEngineCache> query_engine_cache;
 };
 
 // Base class for all compiler passes. Template parameters:
@@ -145,6 +168,11 @@ class PassBase {
   // Returns true if this is a compound pass.
   virtual bool IsCompound() const { return false; }
 
+  // Returns true if this pass contains other passes which are individually
+  // subject to the `run_only_passes` and `skip_passes` options. Such passes are
+  // not skipped by a containing compound pass because of `run_only_passes`.
+  virtual bool HasNestedPasses() const { return IsCompound(); }
+
  protected:
   // Derived classes should override this function which is invoked from Run.
   virtual absl::StatusOr<bool> RunInternal(IrT* ir, const OptionsT& options,
@@ -275,6 +303,7 @@ class FixedPointCompoundPassBase
     bool local_changed = true;
     bool global_changed = false;
     while (local_changed) {
+      ++results->fixed_point_iterations;
       XLS_ASSIGN_OR_RETURN(
           local_changed,
           (CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
@@ -321,7 +350,7 @@ absl::StatusOr<bool> CompoundPassBase<IrT, OptionsT, ResultsT>::RunNested(
                                       pass->long_name(), pass->short_name(),
                                       ir->name());
 
-    if (!pass->IsCompound() && options.run_only_passes.has_value() &&
+    if (!pass->HasNestedPasses() && options.run_only_passes.has_value() &&
         std::find_if(options.run_only_passes->begin(),
                      options.run_only_passes->end(),
                      [&](const std::string& name) {
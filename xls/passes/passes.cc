@@ -14,11 +14,19 @@
 
 #include "xls/passes/passes.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/ir/call_graph.h"
+#include "xls/passes/query_engine_cache.h"
 
 namespace xls {
 
@@ -41,6 +49,11 @@ absl::StatusOr<bool> FunctionBasePass::RunOnFunctionBase(
 absl::StatusOr<bool> FunctionBasePass::RunInternal(Package* p,
                                                    const PassOptions& options,
                                                    PassResults* results) const {
+  // Snapshots record changes from a single thread.
+  if (options.function_thread_pool != nullptr &&
+      p->active_snapshot() == nullptr) {
+    return RunInParallel(p, options, results);
+  }
   bool changed = false;
   for (FunctionBase* f : p->GetFunctionBases()) {
     XLS_ASSIGN_OR_RETURN(bool function_changed,
@@ -50,6 +63,63 @@ absl::StatusOr<bool> FunctionBasePass::RunInternal(Package* p,
   return changed;
 }
 
+absl::StatusOr<bool> FunctionBasePass::RunInParallel(
+    Package* p, const PassOptions& options, PassResults* results) const {
+  // Group the function bases into levels by their height in the call graph.
+  // Function bases in the same level do not call each other and may be
+  // processed concurrently once the levels below are done.
+  absl::flat_hash_map<FunctionBase*, int64_t> heights;
+  for (FunctionBase* f : FunctionsInPostOrder(p)) {
+    int64_t height = 0;
+    for (Function* callee : CalledFunctions(f)) {
+      auto it = heights.find(callee);
+      if (it != heights.end()) {
+        height = std::max(height, it->second + 1);
+      }
+    }
+    heights[f] = height;
+  }
+  std::vector<std::vector<FunctionBase*>> levels;
+  for (FunctionBase* f : p->GetFunctionBases()) {
+    auto it = heights.find(f);
+    int64_t height = it == heights.end() ? 0 : it->second;
+    if (height >= levels.size()) {
+      levels.resize(height + 1);
+    }
+    levels[height].push_back(f);
+  }
+
+  // The query engine cache is shared by all threads.
+  QueryEngineCache::Get(results);
+  bool changed = false;
+  for (const std::vector<FunctionBase*>& level : levels) {
+    // Each function base gets its own results which are merged in package
+    // order afterwards.
+    std::vector<absl::StatusOr<bool>> level_changed(level.size(), false);
+    std::vector<PassResults> level_results(level.size());
+    for (PassResults& function_results : level_results) {
+      function_results.query_engine_cache = results->query_engine_cache;
+    }
+    options.function_thread_pool->ParallelFor(level.size(), [&](int64_t i) {
+      level_changed[i] =
+          RunOnFunctionBase(level[i], options, &level_results[i]);
+    });
+
+    for (int64_t i = 0; i < level.size(); ++i) {
+      XLS_ASSIGN_OR_RETURN(bool function_changed, level_changed[i]);
+      changed |= function_changed;
+      const PassResults& function_results = level_results[i];
+      results->invocations.insert(results->invocations.end(),
+                                  function_results.invocations.begin(),
+                                  function_results.invocations.end());
+      results->fixed_point_iterations +=
+          function_results.fixed_point_iterations;
+      results->rewrite_node_visits += function_results.rewrite_node_visits;
+    }
+  }
+  return changed;
+}
+
 absl::StatusOr<bool> FunctionBasePass::TransformNodesToFixedPoint(
     FunctionBase* f,
     std::function<absl::StatusOr<bool>(Node*)> simplify_f) const {
@@ -87,6 +157,12 @@ absl::StatusOr<bool> FunctionBasePass::TransformNodesToFixedPoint(
   return changed;
 }
 
+absl::StatusOr<bool> NodeRewritePass::RunOnFunctionBaseInternal(
+    FunctionBase* f, const PassOptions& options, PassResults* results) const {
+  return TransformNodesToFixedPoint(
+      f, [&](Node* node) { return RewriteNode(node, options); });
+}
+
 absl::StatusOr<bool> ProcPass::RunOnProc(Proc* proc, const PassOptions& options,
                                          PassResults* results) const {
   XLS_VLOG(2) << absl::StreamFormat("Running %s on proc %s [pass #%d]",
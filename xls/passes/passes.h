@@ -61,7 +61,8 @@ class FunctionBasePass : public Pass {
 
  protected:
   // Iterates over each function and proc in the package calling
-  // RunOnFunctionBase.
+  // RunOnFunctionBase. If `options.function_thread_pool` is set the function
+  // bases are processed concurrently (see RunInParallel).
   absl::StatusOr<bool> RunInternal(Package* p, const PassOptions& options,
                                    PassResults* results) const override;
 
@@ -79,6 +80,38 @@ class FunctionBasePass : public Pass {
   absl::StatusOr<bool> TransformNodesToFixedPoint(
       FunctionBase* f,
       std::function<absl::StatusOr<bool>(Node*)> simplify_f) const;
+
+ private:
+  // Runs the pass on the function bases of the package on
+  // `options.function_thread_pool`. Function bases are processed bottom-up
+  // over the call graph: a function base is only transformed after all of the
+  // functions it calls have been, so the pass never reads a callee which is
+  // being modified concurrently.
+  absl::StatusOr<bool> RunInParallel(Package* p, const PassOptions& options,
+                                     PassResults* results) const;
+};
+
+// Abstract base class for passes whose transformation is a node-local rewrite.
+// The derived class must define RewriteNode. Run on its own, the pass applies
+// the rewrite to every node in a loop until no further rewrites are possible.
+// Node rewrites may also be registered with a WorklistRewritePass which runs a
+// set of them to a fixed point together, revisiting only nodes near changes.
+class NodeRewritePass : public FunctionBasePass {
+ public:
+  NodeRewritePass(std::string_view short_name, std::string_view long_name)
+      : FunctionBasePass(short_name, long_name) {}
+
+  // Attempts to rewrite the given node and returns true if the IR was changed.
+  // The rewrite may add nodes, change the operands of `node`, and replace uses
+  // of `node`, but must not remove nodes. Nodes which become dead are removed
+  // by the caller.
+  virtual absl::StatusOr<bool> RewriteNode(
+      Node* node, const PassOptions& options) const = 0;
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override;
 };
 
 // Abstract base class for passes operate on procs. The derived
@@ -18,10 +18,12 @@
 #include "gtest/gtest.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
 #include "xls/common/casts.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/status/matchers.h"
 #include "xls/common/status/status_macros.h"
+#include "xls/common/thread_pool.h"
 #include "xls/examples/sample_packages.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
@@ -37,6 +39,7 @@ using status_testing::IsOkAndHolds;
 using status_testing::StatusIs;
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::UnorderedElementsAre;
 
 class DummyPass : public Pass {
  public:
@@ -477,5 +480,68 @@ TEST(PassesTest, TestTransformNodesToFixedPointWhileRemovingNodes) {
               IsOkAndHolds(false));
 }
 
+// Records the names of the function bases it runs on in the order in which they
+// are processed.
+class RecordOrderPass : public FunctionBasePass {
+ public:
+  explicit RecordOrderPass(std::vector<std::string>* order)
+      : FunctionBasePass("record_order", "record order"), order_(order) {}
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override {
+    absl::MutexLock lock(&mutex_);
+    order_->push_back(f->name());
+    return false;
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  std::vector<std::string>* order_;
+};
+
+TEST(PassesTest, ParallelFunctionBasePassRunsCalleesFirst) {
+  XLS_ASSERT_OK_AND_ASSIGN(std::unique_ptr<Package> p, Parser::ParsePackage(R"(
+package p
+
+fn a(x: bits[32]) -> bits[32] {
+  ret neg.1: bits[32] = neg(x)
+}
+
+fn b(x: bits[32]) -> bits[32] {
+  ret not.2: bits[32] = not(x)
+}
+
+fn c(x: bits[32]) -> bits[32] {
+  ret identity.3: bits[32] = identity(x)
+}
+
+fn mid(x: bits[32]) -> bits[32] {
+  invoke.4: bits[32] = invoke(x, to_apply=a)
+  ret invoke.5: bits[32] = invoke(invoke.4, to_apply=b)
+}
+
+fn top(x: bits[32]) -> bits[32] {
+  invoke.6: bits[32] = invoke(x, to_apply=mid)
+  ret invoke.7: bits[32] = invoke(invoke.6, to_apply=c)
+}
+)"));
+  std::vector<std::string> order;
+  PassOptions options;
+  options.function_thread_pool = std::make_shared<ThreadPool>(4);
+  PassResults results;
+  EXPECT_THAT(RecordOrderPass(&order).Run(p.get(), options, &results),
+              IsOkAndHolds(false));
+  ASSERT_THAT(order, UnorderedElementsAre("a", "b", "c", "mid", "top"));
+  auto position = [&](std::string_view name) {
+    return std::find(order.begin(), order.end(), name) - order.begin();
+  };
+  EXPECT_GT(position("mid"), position("a"));
+  EXPECT_GT(position("mid"), position("b"));
+  EXPECT_GT(position("top"), position("mid"));
+  EXPECT_GT(position("top"), position("c"));
+}
+
 }  // namespace
 }  // namespace xls
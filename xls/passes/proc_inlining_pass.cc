@@ -24,6 +24,7 @@
 #include "xls/passes/bdd_function.h"
 #include "xls/passes/bdd_query_engine.h"
 #include "xls/passes/dataflow_visitor.h"
+#include "xls/passes/query_engine_cache.h"
 #include "xls/passes/token_provenance_analysis.h"
 
 namespace xls {
@@ -1667,6 +1668,7 @@ absl::StatusOr<bool> ProcInliningPass::RunInternal(Package* p,
   XLS_RETURN_IF_ERROR(p->SetTop(container_proc));
   std::string top_proc_name = top_func_base->AsProcOrDie()->name();
   for (Proc* proc : procs_to_inline) {
+    QueryEngineCache::Invalidate(results, proc);
     XLS_RETURN_IF_ERROR(p->RemoveProc(proc));
   }
   container_proc->SetName(top_proc_name);
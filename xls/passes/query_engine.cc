@@ -14,6 +14,11 @@
 
 #include "xls/passes/query_engine.h"
 
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "absl/hash/hash.h"
 #include "xls/common/logging/logging.h"
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/ternary.h"
@@ -207,4 +212,15 @@ std::string QueryEngine::ToString(Node* node) const {
   return xls::ToString(GetTernary(node).Get({}));
 }
 
+uint64_t NodeSignature(Node* node) {
+  std::vector<int64_t> operand_ids;
+  operand_ids.reserve(node->operand_count());
+  for (Node* operand : node->operands()) {
+    operand_ids.push_back(operand->id());
+  }
+  return absl::Hash<std::tuple<int64_t, Op, Type*, std::vector<int64_t>>>()(
+      std::make_tuple(node->id(), node->op(), node->GetType(),
+                      std::move(operand_ids)));
+}
+
 }  // namespace xls
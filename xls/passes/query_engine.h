@@ -194,6 +194,12 @@ class QueryEngine {
   std::string ToString(Node* node) const;
 };
 
+// Returns a value identifying the node and its place in the graph: its id, op,
+// type, and the ids of its operands. Query engines which are updated
+// incrementally compare signatures to find the nodes which changed since they
+// were last evaluated.
+uint64_t NodeSignature(Node* node);
+
 }  // namespace xls
 
 #endif  // XLS_PASSES_QUERY_ENGINE_H_
@@ -0,0 +1,132 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/query_engine_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/function_base.h"
+#include "xls/passes/bdd_function.h"
+#include "xls/passes/query_engine.h"
+
+namespace xls {
+
+/* static */
+QueryEngineCache& QueryEngineCache::Get(PassResults* results) {
+  if (results->query_engine_cache == nullptr) {
+    results->query_engine_cache = std::make_shared<QueryEngineCache>();
+  }
+  return *results->query_engine_cache;
+}
+
+QueryEngineCache::Entry& QueryEngineCache::GetEntry(FunctionBase* f) {
+  absl::MutexLock lock(&mutex_);
+  return entries_[f];
+}
+
+template <typename EngineT>
+bool QueryEngineCache::IsUpToDate(FunctionBase* f,
+                                  RecomputedEngine<EngineT>& engine) {
+  std::vector<uint64_t> signatures;
+  signatures.reserve(f->node_count());
+  for (Node* node : f->nodes()) {
+    signatures.push_back(NodeSignature(node));
+  }
+  if (engine.engine != nullptr && signatures == engine.signatures) {
+    return true;
+  }
+  // Drop the stale engine so that it is not reused if recomputing fails.
+  engine.engine = nullptr;
+  engine.signatures = std::move(signatures);
+  return false;
+}
+
+absl::StatusOr<TernaryQueryEngine*> QueryEngineCache::GetTernaryQueryEngine(
+    FunctionBase* f) {
+  Entry& entry = GetEntry(f);
+  if (entry.ternary == nullptr) {
+    entry.ternary = std::make_unique<TernaryQueryEngine>();
+  }
+  XLS_ASSIGN_OR_RETURN(int64_t evaluated_count, entry.ternary->Update(f));
+  XLS_VLOG(3) << "Ternary query engine for " << f->name() << ": evaluated "
+              << evaluated_count << " of " << f->node_count() << " nodes";
+  if (evaluated_count == 0) {
+    ++hit_count_;
+  }
+  evaluated_node_count_ += evaluated_count;
+  return entry.ternary.get();
+}
+
+absl::StatusOr<RangeQueryEngine*> QueryEngineCache::GetRangeQueryEngine(
+    FunctionBase* f) {
+  Entry& entry = GetEntry(f);
+  if (entry.range == nullptr) {
+    entry.range = std::make_unique<RangeQueryEngine>();
+  }
+  XLS_ASSIGN_OR_RETURN(int64_t evaluated_count, entry.range->Update(f));
+  XLS_VLOG(3) << "Range query engine for " << f->name() << ": evaluated "
+              << evaluated_count << " nodes";
+  if (evaluated_count == 0) {
+    ++hit_count_;
+  }
+  evaluated_node_count_ += evaluated_count;
+  return entry.range.get();
+}
+
+absl::StatusOr<BddQueryEngine*> QueryEngineCache::GetBddQueryEngine(
+    FunctionBase* f, int64_t path_limit, bool cheap_nodes_only) {
+  Entry& entry = GetEntry(f);
+  RecomputedEngine<BddQueryEngine>& bdd =
+      entry.bdds[{path_limit, cheap_nodes_only}];
+  if (IsUpToDate(f, bdd)) {
+    ++hit_count_;
+    return bdd.engine.get();
+  }
+  std::unique_ptr<BddQueryEngine> engine;
+  if (cheap_nodes_only) {
+    engine = std::make_unique<BddQueryEngine>(path_limit, IsCheapForBdds);
+  } else {
+    engine = std::make_unique<BddQueryEngine>(path_limit);
+  }
+  XLS_RETURN_IF_ERROR(engine->Populate(f).status());
+  evaluated_node_count_ += f->node_count();
+  bdd.engine = std::move(engine);
+  return bdd.engine.get();
+}
+
+void QueryEngineCache::Invalidate(FunctionBase* f) {
+  absl::MutexLock lock(&mutex_);
+  entries_.erase(f);
+}
+
+/* static */
+void QueryEngineCache::Invalidate(PassResults* results, FunctionBase* f) {
+  if (results->query_engine_cache != nullptr) {
+    results->query_engine_cache->Invalidate(f);
+  }
+}
+
+bool QueryEngineCache::Contains(FunctionBase* f) const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.contains(f);
+}
+
+}  // namespace xls
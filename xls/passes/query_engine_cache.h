@@ -0,0 +1,129 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_QUERY_ENGINE_CACHE_H_
+#define XLS_PASSES_QUERY_ENGINE_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xls/ir/function_base.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/range_query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+
+// A cache of query engines for the function bases of a package which is shared
+// by the passes of a pipeline run (see PassResults::query_engine_cache), so
+// that the dataflow analyses need not be recomputed from scratch by every pass
+// which uses them.
+//
+// Engines are brought up to date lazily when they are requested. Changes are
+// detected by comparing the signatures of the nodes (see NodeSignature) with
+// those recorded when the engine was last computed. The ternary and range query
+// engines are updated incrementally by re-evaluating only the changed nodes and
+// the nodes downstream of them whose operand values changed. The BDD query
+// engines are reused as long as the function base is unchanged and are
+// otherwise recomputed.
+//
+// An engine returned by the cache reflects the function base at the time of
+// the request; a pass which changes the IR should guard its queries on new
+// nodes with IsTracked as with an engine it populated itself, and request the
+// engine again to see its own changes. The engine is owned by the cache and
+// must not be repopulated by the caller. May be used concurrently for
+// different function bases.
+class QueryEngineCache {
+ public:
+  QueryEngineCache() = default;
+
+  // Returns the cache of the given pass results, creating it if necessary.
+  static QueryEngineCache& Get(PassResults* results);
+
+  absl::StatusOr<TernaryQueryEngine*> GetTernaryQueryEngine(FunctionBase* f);
+  absl::StatusOr<RangeQueryEngine*> GetRangeQueryEngine(FunctionBase* f);
+
+  // Returns a BDD query engine with the given path limit (see BddQueryEngine).
+  // If `cheap_nodes_only` is true the BDD only evaluates nodes for which
+  // IsCheapForBdds is true.
+  absl::StatusOr<BddQueryEngine*> GetBddQueryEngine(FunctionBase* f,
+                                                    int64_t path_limit,
+                                                    bool cheap_nodes_only);
+
+  // Drops all cached engines of the given function base. Must be called
+  // before a function base is removed from the package so that the entry is
+  // not reused by a function base later allocated at the same address.
+  void Invalidate(FunctionBase* f);
+
+  // Calls Invalidate on the cache of the given pass results, if any.
+  static void Invalidate(PassResults* results, FunctionBase* f);
+
+  // Returns whether any engines are cached for the given function base.
+  bool Contains(FunctionBase* f) const;
+
+  // Returns the number of requests which were answered without recomputing
+  // any node.
+  int64_t hit_count() const { return hit_count_.load(); }
+
+  // Returns the number of nodes evaluated to update engines, counting a
+  // recomputed engine as evaluating every node of the function base.
+  int64_t evaluated_node_count() const { return evaluated_node_count_.load(); }
+
+ private:
+  // An engine which is recomputed from scratch whenever the function base
+  // changes, along with the signatures of the nodes it was computed for.
+  template <typename EngineT>
+  struct RecomputedEngine {
+    std::unique_ptr<EngineT> engine;
+    std::vector<uint64_t> signatures;
+  };
+
+  struct Entry {
+    std::unique_ptr<TernaryQueryEngine> ternary;
+    std::unique_ptr<RangeQueryEngine> range;
+    // Keyed by path limit and whether only cheap nodes are evaluated.
+    absl::flat_hash_map<std::pair<int64_t, bool>,
+                        RecomputedEngine<BddQueryEngine>>
+        bdds;
+  };
+
+  // Returns the entry for the given function base. The entry is only accessed
+  // by the thread processing the function base so it is not guarded.
+  Entry& GetEntry(FunctionBase* f);
+
+  // Returns whether `engine` was computed for the current state of `f`,
+  // updating its recorded signatures if it was not.
+  template <typename EngineT>
+  bool IsUpToDate(FunctionBase* f, RecomputedEngine<EngineT>& engine);
+
+  mutable absl::Mutex mutex_;
+  // Node hash map for pointer stability of the entries.
+  absl::node_hash_map<FunctionBase*, Entry> entries_ ABSL_GUARDED_BY(mutex_);
+
+  std::atomic<int64_t> hit_count_ = 0;
+  std::atomic<int64_t> evaluated_node_count_ = 0;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_QUERY_ENGINE_CACHE_H_
@@ -0,0 +1,191 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/query_engine_cache.h"
+
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/bits.h"
+#include "xls/ir/function.h"
+#include "xls/ir/function_builder.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/passes/bdd_query_engine.h"
+#include "xls/passes/dfe_pass.h"
+#include "xls/passes/pass_base.h"
+#include "xls/passes/range_query_engine.h"
+#include "xls/passes/ternary_query_engine.h"
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+class QueryEngineCacheTest : public IrTestBase {
+ protected:
+  // Expects the cached engine to give the same results as a freshly populated
+  // engine for every bits-typed node of `f`.
+  void ExpectMatchesFreshEngine(FunctionBase* f,
+                                const TernaryQueryEngine& cached) {
+    TernaryQueryEngine fresh;
+    XLS_ASSERT_OK(fresh.Populate(f).status());
+    for (Node* node : f->nodes()) {
+      if (node->GetType()->IsBits()) {
+        ASSERT_TRUE(cached.IsTracked(node)) << node->GetName();
+        EXPECT_EQ(cached.ToString(node), fresh.ToString(node))
+            << node->GetName();
+      }
+    }
+  }
+};
+
+TEST_F(QueryEngineCacheTest, SharedByPassResults) {
+  PassResults results;
+  QueryEngineCache& cache = QueryEngineCache::Get(&results);
+  EXPECT_EQ(&QueryEngineCache::Get(&results), &cache);
+
+  // Copies of the results (e.g., the per-function results of a parallel run)
+  // share the cache.
+  PassResults copy = results;
+  EXPECT_EQ(&QueryEngineCache::Get(&copy), &cache);
+}
+
+TEST_F(QueryEngineCacheTest, TernaryEngineUpdatedIncrementally) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue y = fb.Param("y", p->GetBitsType(8));
+  BValue masked = fb.And(x, fb.Literal(UBits(0x0f, 8)));
+  BValue sum = fb.Add(masked, fb.Literal(UBits(1, 8)));
+  BValue other = fb.Xor(y, fb.Literal(UBits(0xf0, 8)));
+  fb.Concat({fb.Or(sum, fb.Literal(UBits(0x80, 8))), other});
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  QueryEngineCache cache;
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * engine,
+                           cache.GetTernaryQueryEngine(f));
+  ExpectMatchesFreshEngine(f, *engine);
+  int64_t initial_count = cache.evaluated_node_count();
+  EXPECT_EQ(initial_count, f->node_count());
+
+  // Nothing changed so nothing is evaluated.
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * same_engine,
+                           cache.GetTernaryQueryEngine(f));
+  EXPECT_EQ(same_engine, engine);
+  EXPECT_EQ(cache.hit_count(), 1);
+  EXPECT_EQ(cache.evaluated_node_count(), initial_count);
+
+  // Narrow the mask. Only the and, the add, and the or (plus the new literal
+  // and the concat) are affected; the xor feeding the concat is not.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * narrow_mask,
+      f->MakeNode<Literal>(SourceInfo(), Value(UBits(0x03, 8))));
+  XLS_ASSERT_OK(masked.node()->ReplaceOperandNumber(1, narrow_mask));
+  XLS_ASSERT_OK_AND_ASSIGN(engine, cache.GetTernaryQueryEngine(f));
+  EXPECT_EQ(engine, same_engine);
+  EXPECT_EQ(cache.evaluated_node_count() - initial_count, 5);
+  ExpectMatchesFreshEngine(f, *engine);
+  EXPECT_EQ(engine->ToString(masked.node()), "0b0000_00XX");
+}
+
+TEST_F(QueryEngineCacheTest, RemovedNodesAreDropped) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue dead = fb.Not(x);
+  fb.Negate(x);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  QueryEngineCache cache;
+  XLS_ASSERT_OK_AND_ASSIGN(TernaryQueryEngine * engine,
+                           cache.GetTernaryQueryEngine(f));
+  EXPECT_TRUE(engine->IsTracked(dead.node()));
+  Node* dead_node = dead.node();
+  XLS_ASSERT_OK(f->RemoveNode(dead_node));
+  XLS_ASSERT_OK_AND_ASSIGN(engine, cache.GetTernaryQueryEngine(f));
+  EXPECT_FALSE(engine->IsTracked(dead_node));
+  ExpectMatchesFreshEngine(f, *engine);
+}
+
+TEST_F(QueryEngineCacheTest, RemovedFunctionsAreDropped) {
+  auto p = CreatePackage();
+  FunctionBuilder dead_fb("dead", p.get());
+  dead_fb.Not(dead_fb.Param("x", p->GetBitsType(8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * dead, dead_fb.Build());
+  FunctionBuilder top_fb("top", p.get());
+  top_fb.Negate(top_fb.Param("x", p->GetBitsType(8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * top, top_fb.Build());
+  XLS_ASSERT_OK(p->SetTop(top));
+
+  PassResults results;
+  QueryEngineCache& cache = QueryEngineCache::Get(&results);
+  XLS_ASSERT_OK(cache.GetTernaryQueryEngine(dead).status());
+  XLS_ASSERT_OK(cache.GetTernaryQueryEngine(top).status());
+  EXPECT_TRUE(cache.Contains(dead));
+
+  EXPECT_THAT(DeadFunctionEliminationPass().Run(p.get(), PassOptions(),
+                                                &results),
+              IsOkAndHolds(true));
+  EXPECT_FALSE(cache.Contains(dead));
+  EXPECT_TRUE(cache.Contains(top));
+}
+
+TEST_F(QueryEngineCacheTest, RangeAndBddEnginesReusedUntilChanged) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue shifted = fb.Shrl(x, fb.Literal(UBits(4, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.BuildWithReturnValue(shifted));
+
+  QueryEngineCache cache;
+  XLS_ASSERT_OK_AND_ASSIGN(RangeQueryEngine * range,
+                           cache.GetRangeQueryEngine(f));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BddQueryEngine * bdd,
+      cache.GetBddQueryEngine(f, /*path_limit=*/0, /*cheap_nodes_only=*/false));
+  EXPECT_EQ(cache.hit_count(), 0);
+
+  EXPECT_THAT(cache.GetRangeQueryEngine(f),
+              IsOkAndHolds(range));
+  EXPECT_THAT(cache.GetBddQueryEngine(f, /*path_limit=*/0,
+                                      /*cheap_nodes_only=*/false),
+              IsOkAndHolds(bdd));
+  EXPECT_EQ(cache.hit_count(), 2);
+
+  // An engine with different parameters is separate.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      BddQueryEngine * cheap_bdd,
+      cache.GetBddQueryEngine(f, /*path_limit=*/0, /*cheap_nodes_only=*/true));
+  EXPECT_NE(cheap_bdd, bdd);
+  EXPECT_EQ(cache.hit_count(), 2);
+
+  // After a change the engines are recomputed and reflect the new IR.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * shift_amount,
+      f->MakeNode<Literal>(SourceInfo(), Value(UBits(6, 8))));
+  XLS_ASSERT_OK(shifted.node()->ReplaceOperandNumber(1, shift_amount));
+  XLS_ASSERT_OK_AND_ASSIGN(range, cache.GetRangeQueryEngine(f));
+  XLS_ASSERT_OK_AND_ASSIGN(bdd, cache.GetBddQueryEngine(
+                                    f, /*path_limit=*/0,
+                                    /*cheap_nodes_only=*/false));
+  EXPECT_EQ(cache.hit_count(), 2);
+  EXPECT_EQ(range->ToString(shifted.node()), "0b0000_00XX");
+  EXPECT_EQ(bdd->ToString(shifted.node()), "0b0000_00XX");
+}
+
+}  // namespace
+}  // namespace xls
@@ -14,8 +14,15 @@
 
 #include "xls/passes/range_query_engine.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <limits>
+#include <optional>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -51,6 +58,9 @@ class RangeQueryVisitor : public DfsVisitor {
   // iterated over in an analysis.
   static constexpr int64_t kMaxIterationSize = 1024;
 
+  // The maximum nesting depth of counted for loops whose bodies are analyzed.
+  static constexpr int64_t kMaxLoopDepth = 2;
+
   // Wrapper around GetIntervalSetTree for consistency with the
   // SetIntervalSetTree wrapper.
   IntervalSetTree GetIntervalSetTree(Node* node) const {
@@ -366,12 +376,301 @@ IntervalSet MinimizeIntervals(IntervalSet intervals, int64_t size) {
   return result;
 }
 
+IntervalSet WidenIntervals(const IntervalSet& previous,
+                           const IntervalSet& next) {
+  IntervalSet combined = IntervalSet::Combine(previous, next);
+  if (combined == previous) {
+    return previous;
+  }
+  int64_t bit_count = combined.BitCount();
+  if (bit_count == 0) {
+    return combined;
+  }
+  std::optional<Interval> previous_hull = previous.ConvexHull();
+  std::optional<Interval> hull = combined.ConvexHull();
+  XLS_CHECK(hull.has_value());
+  Bits lower = hull->LowerBound();
+  Bits upper = hull->UpperBound();
+  if (!previous_hull.has_value() ||
+      bits_ops::ULessThan(lower, previous_hull->LowerBound())) {
+    lower = Bits(bit_count);
+  }
+  if (!previous_hull.has_value() ||
+      bits_ops::UGreaterThan(upper, previous_hull->UpperBound())) {
+    int64_t upper_width = bit_count - upper.CountLeadingZeros();
+    upper = bits_ops::ZeroExtend(Bits::AllOnes(upper_width), bit_count);
+  }
+  IntervalSet result(bit_count);
+  result.AddInterval(Interval(lower, upper));
+  result.Normalize();
+  return result;
+}
+
+// Returns the interval sets containing exactly the given value.
+static absl::StatusOr<IntervalSetTree> ValueToIntervalSetTree(
+    const Value& value, Type* type) {
+  XLS_ASSIGN_OR_RETURN(LeafTypeTree<Value> v_ltt,
+                       ValueToLeafTypeTree(value, type));
+  return v_ltt.Map<IntervalSet>([](const Value& value) {
+    IntervalSet interval_set(value.GetFlatBitCount());
+    if (value.IsBits()) {
+      return IntervalSet::Precise(value.bits());
+    }
+    if (value.IsToken()) {
+      return IntervalSet::Precise(Bits(0));
+    }
+    XLS_LOG(FATAL) << "Invalid value kind in ValueToIntervalSetTree";
+  });
+}
+
+// Returns whether each element of `lhs` equals the corresponding element of
+// `rhs`.
+static bool IntervalSetTreesEqual(absl::Span<const IntervalSetTree> lhs,
+                                  absl::Span<const IntervalSetTree> rhs) {
+  for (int64_t i = 0; i < lhs.size(); ++i) {
+    if (!(lhs[i] == rhs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the element-wise union of `lhs` and `rhs`, reducing each interval
+// set to at most `max_interval_set_size` intervals.
+static std::vector<IntervalSetTree> JoinIntervalSetTrees(
+    absl::Span<const IntervalSetTree> lhs,
+    absl::Span<const IntervalSetTree> rhs, int64_t max_interval_set_size) {
+  std::vector<IntervalSetTree> result;
+  for (int64_t i = 0; i < lhs.size(); ++i) {
+    result.push_back(IntervalSetTree::Zip<IntervalSet, IntervalSet>(
+        [&](const IntervalSet& a, const IntervalSet& b) {
+          return MinimizeIntervals(IntervalSet::Combine(a, b),
+                                   max_interval_set_size);
+        },
+        lhs[i], rhs[i]));
+  }
+  return result;
+}
+
+// The ranges of the values carried around a loop.
+struct LoopRanges {
+  // The ranges at the start of every iteration. An inductive invariant: it
+  // contains the initial values and `image`.
+  std::vector<IntervalSetTree> invariant;
+  // The ranges at the end of an iteration which starts in `invariant`.
+  std::vector<IntervalSetTree> image;
+};
+
+// Maps the ranges of the loop-carried values at the start of an iteration to
+// the ranges at the end of the iteration.
+using LoopStepFunction =
+    std::function<absl::StatusOr<std::vector<IntervalSetTree>>(
+        absl::Span<const IntervalSetTree>)>;
+
+// The number of iterations of a loop analysis which join the ranges without
+// widening them. Small loops (e.g., counters with a few values) converge
+// precisely within this many iterations.
+constexpr int64_t kLoopWideningDelay = 8;
+
+// The number of narrowing iterations after a loop analysis has converged.
+constexpr int64_t kLoopNarrowingIterations = 2;
+
+// The maximum number of iterations of a loop analysis. Widening bounds the
+// number of iterations by the total bit width of the loop-carried values so
+// this is only reached for very wide ones, in which case nothing is known.
+constexpr int64_t kMaxLoopIterations = 256;
+
+// Computes the ranges of the values carried around a loop by abstract
+// interpretation: starting from `initial`, the ranges are repeatedly joined
+// with their image under `step` (widened after kLoopWideningDelay iterations)
+// until they are closed under `step`. The resulting invariant is then narrowed
+// by intersecting it with the initial values joined with its image, as long as
+// the narrowed ranges are still closed under `step`.
+static absl::StatusOr<LoopRanges> AnalyzeLoopRanges(
+    absl::Span<const IntervalSetTree> initial, const LoopStepFunction& step,
+    int64_t max_interval_set_size) {
+  LoopRanges ranges;
+  ranges.invariant.assign(initial.begin(), initial.end());
+  for (int64_t i = 0;; ++i) {
+    if (i == kMaxLoopIterations) {
+      for (IntervalSetTree& tree : ranges.invariant) {
+        for (IntervalSet& intervals : tree.elements()) {
+          intervals = IntervalSet::Maximal(intervals.BitCount());
+        }
+      }
+      XLS_ASSIGN_OR_RETURN(ranges.image, step(ranges.invariant));
+      return ranges;
+    }
+    XLS_ASSIGN_OR_RETURN(ranges.image, step(ranges.invariant));
+    std::vector<IntervalSetTree> next = JoinIntervalSetTrees(
+        ranges.invariant, ranges.image, max_interval_set_size);
+    if (IntervalSetTreesEqual(next, ranges.invariant)) {
+      break;
+    }
+    if (i >= kLoopWideningDelay) {
+      for (int64_t j = 0; j < next.size(); ++j) {
+        next[j] = IntervalSetTree::Zip<IntervalSet, IntervalSet>(
+            WidenIntervals, ranges.invariant[j], next[j]);
+      }
+    }
+    ranges.invariant = std::move(next);
+  }
+
+  for (int64_t i = 0; i < kLoopNarrowingIterations; ++i) {
+    std::vector<IntervalSetTree> narrowed =
+        JoinIntervalSetTrees(initial, ranges.image, max_interval_set_size);
+    if (IntervalSetTreesEqual(narrowed, ranges.invariant)) {
+      break;
+    }
+    // The step function need not be monotone (e.g., because of interval set
+    // minimization) so the narrowed ranges are only kept if they are still an
+    // invariant.
+    XLS_ASSIGN_OR_RETURN(std::vector<IntervalSetTree> narrowed_image,
+                         step(narrowed));
+    if (!IntervalSetTreesEqual(
+            JoinIntervalSetTrees(narrowed, narrowed_image,
+                                 max_interval_set_size),
+            narrowed)) {
+      break;
+    }
+    ranges.invariant = std::move(narrowed);
+    ranges.image = std::move(narrowed_image);
+  }
+  return ranges;
+}
+
 absl::StatusOr<ReachedFixpoint> RangeQueryEngine::Populate(FunctionBase* f) {
   RangeQueryVisitor visitor(this);
   XLS_RETURN_IF_ERROR(f->Accept(&visitor));
+  if (f->IsProc()) {
+    std::vector<Node*> topo_order;
+    for (Node* node : TopoSort(f)) {
+      topo_order.push_back(node);
+    }
+    XLS_RETURN_IF_ERROR(SolveProcState(f->AsProcOrDie(), topo_order).status());
+  }
   return visitor.GetReachedFixpoint();
 }
 
+absl::StatusOr<int64_t> RangeQueryEngine::Update(FunctionBase* f) {
+  std::vector<Node*> topo_order;
+  absl::flat_hash_map<Node*, uint64_t> signatures;
+  signatures.reserve(f->node_count());
+  absl::flat_hash_set<Node*> dirty;
+  for (Node* node : TopoSort(f)) {
+    topo_order.push_back(node);
+    uint64_t signature = NodeSignature(node);
+    signatures[node] = signature;
+    auto it = signatures_.find(node);
+    if (it == signatures_.end() || it->second != signature) {
+      dirty.insert(node);
+    }
+  }
+  // Drop the data of removed nodes.
+  auto is_removed = [&](const auto& entry) {
+    return !signatures.contains(entry.first);
+  };
+  absl::erase_if(known_bits_, is_removed);
+  absl::erase_if(known_bit_values_, is_removed);
+  absl::erase_if(interval_sets_, is_removed);
+  signatures_ = std::move(signatures);
+
+  absl::flat_hash_set<Node*> changed;
+  XLS_ASSIGN_OR_RETURN(int64_t evaluated_count,
+                       Reevaluate(topo_order, dirty, changed));
+  if (!f->IsProc()) {
+    return evaluated_count;
+  }
+  // The next state can be changed without changing any node.
+  std::vector<int64_t> next_state_ids;
+  for (Node* next : f->AsProcOrDie()->NextState()) {
+    next_state_ids.push_back(next->id());
+  }
+  if (!dirty.empty() || next_state_ids != next_state_ids_) {
+    next_state_ids_ = std::move(next_state_ids);
+    XLS_ASSIGN_OR_RETURN(int64_t state_evaluated_count,
+                         SolveProcState(f->AsProcOrDie(), topo_order));
+    evaluated_count += state_evaluated_count;
+  }
+  return evaluated_count;
+}
+
+void RangeQueryEngine::ResetNode(Node* node) {
+  known_bits_.erase(node);
+  known_bit_values_.erase(node);
+  interval_sets_.erase(node);
+}
+
+void RangeQueryEngine::SeedNode(Node* node,
+                                const IntervalSetTree& interval_sets) {
+  ResetNode(node);
+  InitializeNode(node);
+  SetIntervalSetTree(node, interval_sets);
+}
+
+absl::StatusOr<int64_t> RangeQueryEngine::Reevaluate(
+    absl::Span<Node* const> topo_order,
+    const absl::flat_hash_set<Node*>& dirty,
+    absl::flat_hash_set<Node*>& changed) {
+  RangeQueryVisitor visitor(this);
+  int64_t evaluated_count = 0;
+  for (Node* node : topo_order) {
+    if (!dirty.contains(node) &&
+        std::none_of(node->operands().begin(), node->operands().end(),
+                     [&](Node* o) { return changed.contains(o); })) {
+      continue;
+    }
+    ++evaluated_count;
+    IntervalSetTree previous = GetIntervalSetTree(node);
+    ResetNode(node);
+    XLS_RETURN_IF_ERROR(node->VisitSingleNode(&visitor));
+    if (!(GetIntervalSetTree(node) == previous)) {
+      changed.insert(node);
+    }
+  }
+  return evaluated_count;
+}
+
+absl::StatusOr<int64_t> RangeQueryEngine::SolveProcState(
+    Proc* proc, absl::Span<Node* const> topo_order) {
+  if (proc->GetStateElementCount() == 0) {
+    return 0;
+  }
+  std::vector<IntervalSetTree> initial;
+  for (int64_t i = 0; i < proc->GetStateElementCount(); ++i) {
+    XLS_ASSIGN_OR_RETURN(
+        IntervalSetTree tree,
+        ValueToIntervalSetTree(proc->GetInitValueElement(i),
+                               proc->GetStateElementType(i)));
+    initial.push_back(std::move(tree));
+  }
+  int64_t evaluated_count = 0;
+  auto step = [&](absl::Span<const IntervalSetTree> state)
+      -> absl::StatusOr<std::vector<IntervalSetTree>> {
+    absl::flat_hash_set<Node*> changed;
+    for (int64_t i = 0; i < state.size(); ++i) {
+      Param* param = proc->GetStateParam(i);
+      if (!IsTracked(param) || !(GetIntervalSetTree(param) == state[i])) {
+        SeedNode(param, state[i]);
+        changed.insert(param);
+      }
+    }
+    XLS_ASSIGN_OR_RETURN(int64_t count, Reevaluate(topo_order, {}, changed));
+    evaluated_count += count;
+    std::vector<IntervalSetTree> next_state;
+    for (int64_t i = 0; i < state.size(); ++i) {
+      next_state.push_back(GetIntervalSetTree(proc->GetNextStateElement(i)));
+    }
+    return next_state;
+  };
+  XLS_ASSIGN_OR_RETURN(
+      LoopRanges ranges,
+      AnalyzeLoopRanges(initial, step, max_interval_set_size_));
+  // Leave the engine with the data for the final invariant.
+  XLS_RETURN_IF_ERROR(step(ranges.invariant).status());
+  return evaluated_count;
+}
+
 IntervalSetTree RangeQueryEngine::GetIntervalSetTree(Node* node) const {
   if (interval_sets_.contains(node)) {
     return interval_sets_.at(node);
@@ -400,6 +699,11 @@ void RangeQueryEngine::SetIntervalSetTree(
   IntervalSetTree new_ist =
       LeafTypeTree<IntervalSet>::Zip<IntervalSet, IntervalSet>(
           IntervalSet::Intersect, old_ist, interval_sets);
+  for (IntervalSet& intervals : new_ist.elements()) {
+    if (intervals.NumberOfIntervals() > max_interval_set_size_) {
+      intervals = MinimizeIntervals(intervals, max_interval_set_size_);
+    }
+  }
   int64_t size = node->GetType()->GetFlatBitCount();
   if (node->GetType()->IsBits()) {
     IntervalSet interval_set = new_ist.Get({});
@@ -508,7 +812,8 @@ absl::Status RangeQueryVisitor::HandleVariadicOp(
     return early_status;
   }
 
-  result_intervals = MinimizeIntervals(result_intervals);
+  result_intervals =
+      MinimizeIntervals(result_intervals, engine_->max_interval_set_size());
 
   LeafTypeTree<IntervalSet> result(op->GetType());
   result.Set({}, result_intervals);
@@ -729,7 +1034,60 @@ absl::Status RangeQueryVisitor::HandleConcat(Concat* concat) {
 
 absl::Status RangeQueryVisitor::HandleCountedFor(CountedFor* counted_for) {
   engine_->InitializeNode(counted_for);
-  return absl::OkStatus();  // TODO(taktoa): implement
+  IntervalSetTree initial = GetIntervalSetTree(counted_for->initial_value());
+  if (counted_for->trip_count() == 0) {
+    SetIntervalSetTree(counted_for, initial);
+    return absl::OkStatus();
+  }
+  // Each iteration of the analysis of a loop analyzes the body, so deeply
+  // nested loops are not analyzed.
+  if (engine_->loop_depth_ >= kMaxLoopDepth) {
+    return absl::OkStatus();
+  }
+
+  // The induction variable takes the values 0, stride, ...,
+  // (trip_count - 1) * stride.
+  Function* body = counted_for->body();
+  Param* index_param = body->param(0);
+  int64_t index_width = index_param->BitCountOrDie();
+  IntervalSetTree index_intervals(index_param->GetType());
+  Bits max_index = bits_ops::UMul(UBits(counted_for->trip_count() - 1, 64),
+                                  UBits(counted_for->stride(), 64));
+  if (max_index.bit_count() - max_index.CountLeadingZeros() <= index_width) {
+    IntervalSet intervals(index_width);
+    intervals.AddInterval(
+        Interval(Bits(index_width),
+                 bits_ops::ZeroExtend(
+                     max_index.Slice(0, std::min(index_width,
+                                                 max_index.bit_count())),
+                     index_width)));
+    intervals.Normalize();
+    index_intervals.Set({}, intervals);
+  } else {
+    index_intervals.Set({}, IntervalSet::Maximal(index_width));
+  }
+
+  auto step = [&](absl::Span<const IntervalSetTree> carry)
+      -> absl::StatusOr<std::vector<IntervalSetTree>> {
+    RangeQueryEngine body_engine(engine_->max_interval_set_size());
+    body_engine.loop_depth_ = engine_->loop_depth_ + 1;
+    body_engine.SeedNode(index_param, index_intervals);
+    body_engine.SeedNode(body->param(1), carry[0]);
+    for (int64_t i = 0; i < counted_for->invariant_args().size(); ++i) {
+      body_engine.SeedNode(
+          body->param(i + 2),
+          GetIntervalSetTree(counted_for->invariant_args()[i]));
+    }
+    XLS_RETURN_IF_ERROR(body_engine.Populate(body).status());
+    return std::vector<IntervalSetTree>{
+        body_engine.GetIntervalSetTree(body->return_value())};
+  };
+  XLS_ASSIGN_OR_RETURN(LoopRanges ranges,
+                       AnalyzeLoopRanges({initial}, step,
+                                         engine_->max_interval_set_size()));
+  // The result is the value at the end of the last iteration.
+  SetIntervalSetTree(counted_for, ranges.image[0]);
+  return absl::OkStatus();
 }
 
 absl::Status RangeQueryVisitor::HandleCover(Cover* cover) {
@@ -839,18 +1197,9 @@ absl::Status RangeQueryVisitor::HandleInvoke(Invoke* invoke) {
 absl::Status RangeQueryVisitor::HandleLiteral(Literal* literal) {
   engine_->InitializeNode(literal);
   XLS_ASSIGN_OR_RETURN(
-      LeafTypeTree<Value> v_ltt,
-      ValueToLeafTypeTree(literal->value(), literal->GetType()));
-  SetIntervalSetTree(literal, v_ltt.Map<IntervalSet>([](const Value& value) {
-    IntervalSet interval_set(value.GetFlatBitCount());
-    if (value.IsBits()) {
-      return IntervalSet::Precise(value.bits());
-    }
-    if (value.IsToken()) {
-      return IntervalSet::Precise(Bits(0));
-    }
-    XLS_LOG(FATAL) << "Invalid value kind in HandleLiteral";
-  }));
+      IntervalSetTree interval_sets,
+      ValueToIntervalSetTree(literal->value(), literal->GetType()));
+  SetIntervalSetTree(literal, interval_sets);
   return absl::OkStatus();
 }
 
@@ -1048,7 +1397,7 @@ absl::Status RangeQueryVisitor::HandlePrioritySel(PrioritySelect* sel) {
     }
   }
   for (IntervalSet& intervals : result.elements()) {
-    intervals = MinimizeIntervals(intervals);
+    intervals = MinimizeIntervals(intervals, engine_->max_interval_set_size());
   }
   SetIntervalSetTree(sel, result);
   return absl::OkStatus();
@@ -1196,7 +1545,7 @@ absl::Status RangeQueryVisitor::HandleSel(Select* sel) {
     combine(sel->default_value().value());
   }
   for (IntervalSet& intervals : result.elements()) {
-    intervals = MinimizeIntervals(intervals);
+    intervals = MinimizeIntervals(intervals, engine_->max_interval_set_size());
   }
   SetIntervalSetTree(sel, result);
   return absl::OkStatus();
@@ -15,10 +15,13 @@
 #ifndef XLS_PASSES_RANGE_QUERY_ENGINE_H_
 #define XLS_PASSES_RANGE_QUERY_ENGINE_H_
 
+#include <cstdint>
 #include <iosfwd>
+#include <vector>
 
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -31,6 +34,7 @@
 #include "xls/ir/interval.h"
 #include "xls/ir/interval_set.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/proc.h"
 #include "xls/passes/query_engine.h"
 
 namespace xls {
@@ -40,15 +44,41 @@ using IntervalSetTree = LeafTypeTree<IntervalSet>;
 class RangeQueryVisitor;
 
 // A query engine which tracks sets of intervals that a value can be in.
+//
+// The state parameters of procs and the loop-carried values of counted for
+// loops are given the ranges of an inductive invariant computed by iterating
+// the next-state (loop body) relation from the initial values, widening the
+// ranges after a few iterations to ensure termination and narrowing them
+// afterwards to recover precision.
 class RangeQueryEngine : public QueryEngine {
  public:
-  // Create a `RangeQueryEngine` that contains no data.
-  RangeQueryEngine() {}
+  // The default bound on the number of intervals in the interval set of a
+  // single value.
+  static constexpr int64_t kDefaultMaxIntervalSetSize = 16;
+
+  // Create a `RangeQueryEngine` that contains no data. Interval sets with more
+  // than `max_interval_set_size` intervals are reduced by merging the intervals
+  // with the smallest gaps between them (see MinimizeIntervals), trading
+  // precision for memory and time.
+  explicit RangeQueryEngine(
+      int64_t max_interval_set_size = kDefaultMaxIntervalSetSize)
+      : max_interval_set_size_(max_interval_set_size) {}
 
   // Populate the data in this `RangeQueryEngine` using the
   // given `FunctionBase*`;
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
+  // Brings the engine up to date with the current state of `f`. Only nodes
+  // which were added or whose operands changed since the previous call, and
+  // nodes downstream of them whose operand ranges changed, are re-evaluated.
+  // If anything in a proc changed, the ranges of its state are recomputed.
+  // Unlike Populate, ranges are not intersected with those from earlier
+  // evaluations, so Update and Populate should not be mixed on one engine.
+  // Returns the number of nodes evaluated.
+  absl::StatusOr<int64_t> Update(FunctionBase* f);
+
+  int64_t max_interval_set_size() const { return max_interval_set_size_; }
+
   bool IsTracked(Node* node) const override {
     return known_bits_.contains(node);
   }
@@ -124,9 +154,37 @@ class RangeQueryEngine : public QueryEngine {
  private:
   friend class RangeQueryVisitor;
 
+  // Removes all data about the given node.
+  void ResetNode(Node* node);
+
+  // Replaces the data about the given node with the given intervals.
+  void SeedNode(Node* node, const IntervalSetTree& interval_sets);
+
+  // Re-evaluates the nodes of `topo_order` which are in `dirty` or have an
+  // operand in `changed`, adding the nodes whose intervals change to
+  // `changed`. Returns the number of nodes evaluated.
+  absl::StatusOr<int64_t> Reevaluate(absl::Span<Node* const> topo_order,
+                                     const absl::flat_hash_set<Node*>& dirty,
+                                     absl::flat_hash_set<Node*>& changed);
+
+  // Computes the ranges of the state parameters of `proc` and of the nodes
+  // which depend on them. Returns the number of nodes evaluated.
+  absl::StatusOr<int64_t> SolveProcState(Proc* proc,
+                                         absl::Span<Node* const> topo_order);
+
+  int64_t max_interval_set_size_;
+  // The number of loop bodies this engine is nested in (see
+  // RangeQueryVisitor::HandleCountedFor).
+  int64_t loop_depth_ = 0;
+
   absl::flat_hash_map<Node*, Bits> known_bits_;
   absl::flat_hash_map<Node*, Bits> known_bit_values_;
   absl::flat_hash_map<Node*, IntervalSetTree> interval_sets_;
+
+  // The signatures (see NodeSignature) of the nodes, and for procs the ids of
+  // the next state nodes, as of the last Update.
+  absl::flat_hash_map<Node*, uint64_t> signatures_;
+  std::vector<int64_t> next_state_ids_;
 };
 
 // Reduce the size of the given `IntervalSet` to the given size.
@@ -135,7 +193,20 @@ class RangeQueryEngine : public QueryEngine {
 // This works by choosing pairs of neighboring intervals that have small gaps
 // and merging them by taking their convex hull, until only `size` intervals
 // remain.
-IntervalSet MinimizeIntervals(IntervalSet intervals, int64_t size = 16);
+IntervalSet MinimizeIntervals(
+    IntervalSet intervals,
+    int64_t size = RangeQueryEngine::kDefaultMaxIntervalSetSize);
+
+// Widens `next`, the ranges of a loop-carried value after an iteration, with
+// respect to `previous`, the ranges before it, so that repeated widening
+// reaches a fixed point in a bounded number of steps. If `next` is contained
+// in `previous` then `previous` is returned. Otherwise the result is a single
+// interval covering both whose lower bound is zero if the lower bound
+// decreased and whose upper bound is one less than a power of two if the upper
+// bound increased. Rounding the upper bound to a power of two (rather than to
+// the maximum) keeps the known leading zeros of bounded values.
+IntervalSet WidenIntervals(const IntervalSet& previous,
+                           const IntervalSet& next);
 
 std::string IntervalSetTreeToString(const IntervalSetTree& tree);
 std::ostream& operator<<(std::ostream& os, const IntervalSetTree& tree);
@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -37,12 +38,15 @@
 #include "xls/ir/ir_test_base.h"
 #include "xls/ir/node.h"
 #include "xls/ir/package.h"
+#include "xls/ir/proc.h"
 #include "xls/ir/type.h"
 #include "xls/passes/query_engine.h"
 
 namespace xls {
 namespace {
 
+using status_testing::IsOkAndHolds;
+
 class RangeQueryEngineTest : public IrTestBase {};
 
 // TODO(taktoa): replace this with a proper property-based testing library
@@ -1307,5 +1311,133 @@ TEST_F(RangeQueryEngineTest, ZeroExtend) {
             BitsLTT(expr.node(), {Interval(UBits(500, 40), UBits(700, 40))}));
 }
 
+TEST_F(RangeQueryEngineTest, WidenIntervals) {
+  IntervalSet previous = CreateIntervalSet(16, {{2, 5}});
+  EXPECT_EQ(WidenIntervals(previous, CreateIntervalSet(16, {{3, 4}})),
+            previous);
+  // A growing upper bound is rounded up to one less than a power of two.
+  EXPECT_EQ(WidenIntervals(previous, CreateIntervalSet(16, {{2, 9}})),
+            CreateIntervalSet(16, {{2, 15}}));
+  // A shrinking lower bound goes to zero.
+  EXPECT_EQ(WidenIntervals(previous, CreateIntervalSet(16, {{1, 5}})),
+            CreateIntervalSet(16, {{0, 5}}));
+  EXPECT_EQ(WidenIntervals(previous, CreateIntervalSet(16, {{0, 0}, {8, 8}})),
+            CreateIntervalSet(16, {{0, 15}}));
+}
+
+TEST_F(RangeQueryEngineTest, MaxIntervalSetSize) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue expr = fb.ZeroExtend(x, 16);
+
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+  RangeQueryEngine engine(/*max_interval_set_size=*/2);
+  engine.SetIntervalSetTree(
+      x.node(), BitsLTT(x.node(), {{0, 1}, {10, 11}, {20, 21}, {100, 101}}));
+  XLS_ASSERT_OK(engine.Populate(f));
+
+  EXPECT_EQ(engine.GetIntervalSetTree(x.node()),
+            BitsLTT(x.node(), {{0, 21}, {100, 101}}));
+  EXPECT_EQ(engine.GetIntervalSetTree(expr.node()),
+            BitsLTT(expr.node(), {{0, 21}, {100, 101}}));
+}
+
+TEST_F(RangeQueryEngineTest, ProcStateAlternates) {
+  auto p = CreatePackage();
+  TokenlessProcBuilder pb(TestName(), "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(3, 8)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb.Build({pb.Subtract(pb.Literal(UBits(8, 8)), x)}));
+
+  RangeQueryEngine engine;
+  XLS_ASSERT_OK(engine.Populate(proc));
+  EXPECT_EQ(engine.GetIntervalSetTree(x.node()),
+            BitsLTT(x.node(), {{3, 3}, {5, 5}}));
+}
+
+TEST_F(RangeQueryEngineTest, ProcStateBounded) {
+  auto p = CreatePackage();
+  TokenlessProcBuilder pb(TestName(), "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 32)));
+  BValue next = pb.ZeroExtend(
+      pb.BitSlice(pb.Add(x, pb.Literal(UBits(1, 32))), /*start=*/0,
+                  /*width=*/4),
+      32);
+  XLS_ASSERT_OK_AND_ASSIGN(Proc * proc, pb.Build({next}));
+
+  RangeQueryEngine engine;
+  XLS_ASSERT_OK(engine.Populate(proc));
+  EXPECT_EQ(engine.GetIntervalSetTree(x.node()), BitsLTT(x.node(), {{0, 15}}));
+  EXPECT_TRUE(engine.IsZero(TreeBitLocation(x.node(), 4)));
+}
+
+TEST_F(RangeQueryEngineTest, ProcStateUnboundedCounter) {
+  auto p = CreatePackage();
+  TokenlessProcBuilder pb(TestName(), "tkn", p.get());
+  BValue x = pb.StateElement("x", Value(UBits(0, 16)));
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Proc * proc, pb.Build({pb.Add(x, pb.Literal(UBits(1, 16)))}));
+
+  // Widening makes the analysis terminate quickly even though the counter
+  // takes every value.
+  RangeQueryEngine engine;
+  XLS_ASSERT_OK(engine.Populate(proc));
+  EXPECT_TRUE(engine.GetIntervalSetTree(x.node()).Get({}).IsMaximal());
+}
+
+TEST_F(RangeQueryEngineTest, CountedFor) {
+  auto p = CreatePackage();
+  FunctionBuilder body_builder("body", p.get());
+  BValue index = body_builder.Param("index", p->GetBitsType(8));
+  body_builder.Param("accumulator", p->GetBitsType(8));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * body,
+                           body_builder.BuildWithReturnValue(index));
+
+  FunctionBuilder fb(TestName(), p.get());
+  BValue loop = fb.CountedFor(fb.Literal(UBits(0, 8)), /*trip_count=*/4,
+                              /*stride=*/2, body);
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  // The result is the induction variable of the last iteration.
+  RangeQueryEngine engine;
+  XLS_ASSERT_OK(engine.Populate(f));
+  EXPECT_EQ(engine.GetIntervalSetTree(loop.node()),
+            BitsLTT(loop.node(), {{0, 6}}));
+}
+
+TEST_F(RangeQueryEngineTest, UpdateIsIncremental) {
+  auto p = CreatePackage();
+  FunctionBuilder fb(TestName(), p.get());
+  BValue x = fb.Param("x", p->GetBitsType(8));
+  BValue sum = fb.Add(fb.ZeroExtend(x, 16), fb.Literal(UBits(100, 16)));
+  BValue compare = fb.ULt(sum, fb.Literal(UBits(50, 16)));
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, fb.Build());
+
+  RangeQueryEngine engine;
+  EXPECT_THAT(engine.Update(f), IsOkAndHolds(f->node_count()));
+  EXPECT_THAT(engine.Update(f), IsOkAndHolds(0));
+  EXPECT_EQ(engine.GetIntervalSetTree(sum.node()),
+            BitsLTT(sum.node(), {{100, 355}}));
+
+  // Only the new literal, the add, and the comparison are evaluated.
+  XLS_ASSERT_OK_AND_ASSIGN(
+      Node * addend, f->MakeNode<Literal>(SourceInfo(), Value(UBits(300, 16))));
+  XLS_ASSERT_OK(sum.node()->ReplaceOperandNumber(1, addend));
+  EXPECT_THAT(engine.Update(f), IsOkAndHolds(3));
+
+  RangeQueryEngine fresh;
+  XLS_ASSERT_OK(fresh.Populate(f));
+  for (Node* node : f->nodes()) {
+    EXPECT_EQ(engine.GetIntervalSetTree(node), fresh.GetIntervalSetTree(node))
+        << node->GetName();
+  }
+  EXPECT_EQ(engine.GetIntervalSetTree(sum.node()),
+            BitsLTT(sum.node(), {{300, 555}}));
+  EXPECT_EQ(engine.GetIntervalSetTree(compare.node()),
+            BitsLTT(compare.node(), {{0, 0}}));
+}
+
 }  // namespace
 }  // namespace xls
@@ -52,6 +52,7 @@
 #include "xls/passes/useless_assert_removal_pass.h"
 #include "xls/passes/useless_io_removal_pass.h"
 #include "xls/passes/verifier_checker.h"
+#include "xls/passes/worklist_rewrite_pass.h"
 
 namespace xls {
 
@@ -59,13 +60,14 @@ class SimplificationPass : public FixedPointCompoundPass {
  public:
   explicit SimplificationPass(int64_t opt_level)
       : FixedPointCompoundPass("simp", "Simplification") {
-    Add<IdentityRemovalPass>();
-    Add<ConstantFoldingPass>();
-    Add<DeadCodeEliminationPass>();
-    Add<CanonicalizationPass>();
-    Add<DeadCodeEliminationPass>();
-    Add<ArithSimplificationPass>(opt_level);
-    Add<DeadCodeEliminationPass>();
+    // Node-local rewrites run together on a worklist which revisits only the
+    // neighborhoods of changed nodes and removes dead nodes as it goes.
+    WorklistRewritePass* rewrites =
+        Add<WorklistRewritePass>("simp_rewrite", "Simplification rewrites");
+    rewrites->Add<IdentityRemovalPass>();
+    rewrites->Add<ConstantFoldingPass>();
+    rewrites->Add<CanonicalizationPass>();
+    rewrites->Add<ArithSimplificationPass>(opt_level);
     Add<ComparisonSimplificationPass>();
     Add<DeadCodeEliminationPass>();
     Add<TableSwitchPass>();
@@ -76,8 +78,8 @@ class SimplificationPass : public FixedPointCompoundPass {
     Add<DeadCodeEliminationPass>();
     Add<ReassociationPass>();
     Add<DeadCodeEliminationPass>();
-    Add<ConstantFoldingPass>();
-    Add<DeadCodeEliminationPass>();
+    Add<WorklistRewritePass>("simp_fold", "Simplification constant folding")
+        ->Add<ConstantFoldingPass>();
     Add<BitSliceSimplificationPass>(opt_level);
     Add<DeadCodeEliminationPass>();
     Add<ConcatSimplificationPass>(opt_level);
@@ -90,8 +92,8 @@ class SimplificationPass : public FixedPointCompoundPass {
     Add<DeadCodeEliminationPass>();
     Add<NarrowingPass>(/*use_range_analysis=*/false, opt_level);
     Add<DeadCodeEliminationPass>();
-    Add<ArithSimplificationPass>(opt_level);
-    Add<DeadCodeEliminationPass>();
+    Add<WorklistRewritePass>("simp_arith", "Simplification arithmetic")
+        ->Add<ArithSimplificationPass>(opt_level);
     Add<BooleanSimplificationPass>();
     Add<DeadCodeEliminationPass>();
     Add<CsePass>();
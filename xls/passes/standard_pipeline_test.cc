@@ -19,6 +19,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/status/matchers.h"
+#include "xls/common/thread_pool.h"
 #include "xls/examples/sample_packages.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
@@ -269,6 +270,56 @@ TEST_F(StandardPipelineTest, LogicCombining) {
   EXPECT_THAT(f->return_value(), m::Param("x"));
 }
 
+TEST_F(StandardPipelineTest, ParallelFunctionsMatchSequential) {
+  constexpr std::string_view kPackage = R"(
+package p
+
+fn double_neg(x: bits[8]) -> bits[8] {
+  neg.1: bits[8] = neg(x)
+  ret neg.2: bits[8] = neg(neg.1)
+}
+
+fn add_zero(x: bits[8]) -> bits[8] {
+  literal.3: bits[8] = literal(value=0)
+  identity.4: bits[8] = identity(x)
+  ret add.5: bits[8] = add(literal.3, identity.4)
+}
+
+fn fold(x: bits[8]) -> bits[8] {
+  literal.6: bits[8] = literal(value=3)
+  literal.7: bits[8] = literal(value=4)
+  umul.8: bits[8] = umul(literal.6, literal.7)
+  ret add.9: bits[8] = add(x, umul.8)
+}
+
+fn caller(x: bits[8]) -> bits[8] {
+  invoke.10: bits[8] = invoke(x, to_apply=double_neg)
+  invoke.11: bits[8] = invoke(invoke.10, to_apply=add_zero)
+  ret invoke.12: bits[8] = invoke(invoke.11, to_apply=fold)
+}
+)";
+  // Optimizes the package with the given number of threads and returns a
+  // summary of each optimized function. The IR text is not compared because
+  // node ids depend on the interleaving of the threads.
+  auto optimize = [&](int64_t threads) -> std::vector<std::string> {
+    std::unique_ptr<Package> p = Parser::ParsePackage(kPackage).value();
+    PassOptions options;
+    if (threads > 1) {
+      options.function_thread_pool = std::make_shared<ThreadPool>(threads);
+    }
+    PassResults results;
+    EXPECT_THAT(CreateStandardPassPipeline()->Run(p.get(), options, &results),
+                IsOkAndHolds(true));
+    std::vector<std::string> functions;
+    for (FunctionBase* f : p->GetFunctionBases()) {
+      functions.push_back(absl::StrFormat(
+          "%s: %d nodes, returns %s", f->name(), f->node_count(),
+          OpToString(f->AsFunctionOrDie()->return_value()->op())));
+    }
+    return functions;
+  };
+  EXPECT_EQ(optimize(/*threads=*/4), optimize(/*threads=*/1));
+}
 
 }  // namespace
 }  // namespace xls
@@ -25,6 +25,7 @@
 #include "xls/ir/node_util.h"
 #include "xls/ir/nodes.h"
 #include "xls/passes/query_engine.h"
+#include "xls/passes/query_engine_cache.h"
 #include "xls/passes/ternary_query_engine.h"
 
 namespace xls {
@@ -336,10 +337,10 @@ absl::StatusOr<bool> StrengthReduceNode(
 
 absl::StatusOr<bool> StrengthReductionPass::RunOnFunctionBaseInternal(
     FunctionBase* f, const PassOptions& options, PassResults* results) const {
-  TernaryQueryEngine query_engine;
-  XLS_RETURN_IF_ERROR(query_engine.Populate(f).status());
+  XLS_ASSIGN_OR_RETURN(TernaryQueryEngine * query_engine,
+                       QueryEngineCache::Get(results).GetTernaryQueryEngine(f));
   XLS_ASSIGN_OR_RETURN(absl::flat_hash_set<Node*> reducible_adds,
-                       FindReducibleAdds(f, query_engine));
+                       FindReducibleAdds(f, *query_engine));
   // Note: because we introduce new nodes into the graph that were not present
   // for the original QueryEngine analysis, we must be careful to guard our
   // bit value tests with "IsKnown" sorts of calls.
@@ -347,11 +348,12 @@ absl::StatusOr<bool> StrengthReductionPass::RunOnFunctionBaseInternal(
   // TODO(leary): 2019-09-05: We can eventually implement incremental
   // recomputation of the bit tracking data for newly introduced nodes so the
   // information is always fresh and precise.
+  //
   bool modified = false;
   for (Node* node : TopoSort(f)) {
     XLS_ASSIGN_OR_RETURN(
         bool node_modified,
-        StrengthReduceNode(node, reducible_adds, query_engine, opt_level_));
+        StrengthReduceNode(node, reducible_adds, *query_engine, opt_level_));
     modified |= node_modified;
   }
   return modified;
@@ -23,6 +23,11 @@
 
 namespace xls {
 
+// An abstract evaluator over ternary values, evaluating one bit at a time.
+// Bitwise operations, concats, and slices of wide values are much faster on
+// the packed representation in packed_ternary.h which the
+// TernaryQueryEngine uses for those operations, falling back to this
+// evaluator for the others.
 class TernaryEvaluator
     : public AbstractEvaluator<TernaryValue, TernaryEvaluator> {
  public:
@@ -15,8 +15,11 @@
 #include "xls/passes/ternary_query_engine.h"
 
 #include <limits>
+#include <optional>
+#include <vector>
 
-#include "absl/container/inlined_vector.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "xls/common/status/status_macros.h"
@@ -25,6 +28,7 @@
 #include "xls/ir/bits_ops.h"
 #include "xls/ir/dfs_visitor.h"
 #include "xls/ir/node_iterator.h"
+#include "xls/ir/packed_ternary.h"
 #include "xls/passes/ternary_evaluator.h"
 
 namespace xls {
@@ -42,76 +46,174 @@ static bool IsExpensiveToEvaluate(Node* node) {
          node->GetType()->GetFlatBitCount() > 256;
 }
 
-Bits TernaryVectorToKnownBits(const TernaryEvaluator::Vector& ternary_vector) {
-  // Use InlinedVector to avoid std::vector<bool> specialization madness.
-  absl::InlinedVector<bool, 1> bits(ternary_vector.size());
-  for (int64_t i = 0; i < bits.size(); ++i) {
-    bits[i] = (ternary_vector[i] == TernaryValue::kKnownOne ||
-               ternary_vector[i] == TernaryValue::kKnownZero);
+// Evaluates the given node directly on the packed ternary values of its
+// operands if the node is one of the (common) operations with a packed
+// implementation. Returns std::nullopt otherwise.
+static std::optional<PackedTernaryVector> EvaluatePacked(
+    Node* node,
+    const absl::flat_hash_map<Node*, PackedTernaryVector>& values) {
+  auto operand = [&](int64_t i) -> const PackedTernaryVector& {
+    return values.at(node->operand(i));
+  };
+  auto fold = [&](auto op) {
+    PackedTernaryVector result = operand(0);
+    for (int64_t i = 1; i < node->operand_count(); ++i) {
+      result = op(result, operand(i));
+    }
+    return result;
+  };
+  switch (node->op()) {
+    case Op::kLiteral:
+      return PackedTernaryVector::FromBits(
+          node->As<Literal>()->value().bits());
+    case Op::kIdentity:
+      return operand(0);
+    case Op::kNot:
+      return packed_ternary_ops::Not(operand(0));
+    case Op::kAnd:
+      return fold(packed_ternary_ops::And);
+    case Op::kOr:
+      return fold(packed_ternary_ops::Or);
+    case Op::kXor:
+      return fold(packed_ternary_ops::Xor);
+    case Op::kNand:
+      return packed_ternary_ops::Not(fold(packed_ternary_ops::And));
+    case Op::kNor:
+      return packed_ternary_ops::Not(fold(packed_ternary_ops::Or));
+    case Op::kConcat: {
+      std::vector<PackedTernaryVector> operand_values;
+      operand_values.reserve(node->operand_count());
+      for (Node* o : node->operands()) {
+        operand_values.push_back(values.at(o));
+      }
+      return packed_ternary_ops::Concat(operand_values);
+    }
+    case Op::kBitSlice:
+      return packed_ternary_ops::BitSlice(operand(0),
+                                          node->As<BitSlice>()->start(),
+                                          node->As<BitSlice>()->width());
+    case Op::kZeroExt: {
+      int64_t extension =
+          node->BitCountOrDie() - node->operand(0)->BitCountOrDie();
+      return packed_ternary_ops::Concat(
+          {PackedTernaryVector::FromBits(Bits(extension)), operand(0)});
+    }
+    default:
+      return std::nullopt;
   }
-  return Bits(bits);
 }
 
-Bits TernaryVectorToValueBits(const TernaryEvaluator::Vector& ternary_vector) {
-  // Use InlinedVector to avoid std::vector<bool> specialization madness.
-  absl::InlinedVector<bool, 1> bits(ternary_vector.size());
-  for (int64_t i = 0; i < bits.size(); ++i) {
-    bits[i] = ternary_vector[i] == TernaryValue::kKnownOne;
+// Evaluates the given bits-typed node using the values of its operands.
+static absl::StatusOr<PackedTernaryVector> EvaluateNode(
+    Node* node, const absl::flat_hash_map<Node*, PackedTernaryVector>& values,
+    TernaryEvaluator* evaluator) {
+  if (IsExpensiveToEvaluate(node) ||
+      std::any_of(node->operands().begin(), node->operands().end(),
+                  [](Node* o) { return !o->GetType()->IsBits(); })) {
+    return PackedTernaryVector(node->BitCountOrDie());
+  }
+
+  std::optional<PackedTernaryVector> packed = EvaluatePacked(node, values);
+  if (packed.has_value()) {
+    return *std::move(packed);
+  }
+
+  // Fall back to bit-at-a-time abstract evaluation for the remaining
+  // operations.
+  std::vector<TernaryEvaluator::Vector> operand_values;
+  for (Node* operand : node->operands()) {
+    operand_values.push_back(values.at(operand).ToTernaryVector());
   }
-  return Bits(bits);
+  auto create_unknown_vector = [](Node* n) {
+    return TernaryEvaluator::Vector(n->BitCountOrDie(), TernaryValue::kUnknown);
+  };
+  XLS_ASSIGN_OR_RETURN(
+      TernaryEvaluator::Vector result,
+      AbstractEvaluate(node, operand_values, evaluator,
+                       /*default_handler=*/create_unknown_vector));
+  return PackedTernaryVector::FromTernaryVector(result);
 }
 
 absl::StatusOr<ReachedFixpoint> TernaryQueryEngine::Populate(FunctionBase* f) {
   TernaryEvaluator evaluator;
-  absl::flat_hash_map<Node*, TernaryEvaluator::Vector> values;
+  absl::flat_hash_map<Node*, PackedTernaryVector> values;
   for (Node* node : TopoSort(f)) {
     if (!node->GetType()->IsBits()) {
       continue;
     }
-    auto create_unknown_vector = [](Node* n) {
-      return TernaryEvaluator::Vector(n->BitCountOrDie(),
-                                      TernaryValue::kUnknown);
-    };
-    if (IsExpensiveToEvaluate(node) ||
-        std::any_of(node->operands().begin(), node->operands().end(),
-                    [](Node* o) { return !o->GetType()->IsBits(); })) {
-      values[node] = create_unknown_vector(node);
-      continue;
-    }
-
-    std::vector<TernaryEvaluator::Vector> operand_values;
-    for (Node* operand : node->operands()) {
-      operand_values.push_back(values.at(operand));
-    }
-    XLS_ASSIGN_OR_RETURN(
-        values[node],
-        AbstractEvaluate(node, operand_values, &evaluator,
-                         /*default_handler=*/create_unknown_vector));
+    XLS_ASSIGN_OR_RETURN(PackedTernaryVector value,
+                         EvaluateNode(node, values, &evaluator));
+    values.insert_or_assign(node, std::move(value));
   }
 
   ReachedFixpoint rf = ReachedFixpoint::Unchanged;
   for (Node* node : f->nodes()) {
     // TODO(meheff): Handle types other than bits.
-    if (node->GetType()->IsBits()) {
-      if (!known_bits_.contains(node)) {
-        known_bits_[node] = Bits(values.at(node).size());
-        bits_values_[node] = Bits(values.at(node).size());
-      }
-      Bits combined_known_bits = bits_ops::Or(
-          known_bits_[node], TernaryVectorToKnownBits(values.at(node)));
-      Bits combined_bits_values = bits_ops::Or(
-          bits_values_[node], TernaryVectorToValueBits(values.at(node)));
-      if ((combined_known_bits != known_bits_[node]) ||
-          (combined_bits_values != bits_values_[node])) {
+    if (!node->GetType()->IsBits()) {
+      continue;
+    }
+    PackedTernaryVector& value = values.at(node);
+    auto it = values_.find(node);
+    if (it == values_.end()) {
+      if (!value.AllUnknown()) {
         rf = ReachedFixpoint::Changed;
       }
-      known_bits_[node] = combined_known_bits;
-      bits_values_[node] = combined_bits_values;
+      values_.emplace(node, std::move(value));
+      continue;
+    }
+    // Combine the knowledge from this and previous evaluations. A conflict is
+    // only possible if the node changed since the previous evaluation in
+    // which case the new value is used.
+    std::optional<PackedTernaryVector> combined =
+        packed_ternary_ops::Meet(it->second, value);
+    PackedTernaryVector& new_value =
+        combined.has_value() ? combined.value() : value;
+    if (new_value != it->second) {
+      rf = ReachedFixpoint::Changed;
+      it->second = std::move(new_value);
     }
   }
   return rf;
 }
 
+absl::StatusOr<int64_t> TernaryQueryEngine::Update(FunctionBase* f) {
+  TernaryEvaluator evaluator;
+  absl::flat_hash_map<Node*, uint64_t> signatures;
+  signatures.reserve(f->node_count());
+  // Nodes whose value differs from the previous update.
+  absl::flat_hash_set<Node*> changed;
+  int64_t evaluated_count = 0;
+  for (Node* node : TopoSort(f)) {
+    if (!node->GetType()->IsBits()) {
+      continue;
+    }
+    uint64_t signature = NodeSignature(node);
+    signatures[node] = signature;
+    // A node whose address was reused by a new node has a different signature
+    // as node ids are never reused.
+    auto it = signatures_.find(node);
+    if (it != signatures_.end() && it->second == signature &&
+        std::none_of(node->operands().begin(), node->operands().end(),
+                     [&](Node* o) { return changed.contains(o); })) {
+      continue;
+    }
+    ++evaluated_count;
+    XLS_ASSIGN_OR_RETURN(PackedTernaryVector value,
+                         EvaluateNode(node, values_, &evaluator));
+    auto value_it = values_.find(node);
+    if (value_it == values_.end() || value_it->second != value) {
+      changed.insert(node);
+      values_.insert_or_assign(node, std::move(value));
+    }
+  }
+  // Drop the values of removed nodes.
+  absl::erase_if(values_, [&](const auto& entry) {
+    return !signatures.contains(entry.first);
+  });
+  signatures_ = std::move(signatures);
+  return evaluated_count;
+}
+
 bool TernaryQueryEngine::AtMostOneTrue(
     absl::Span<TreeBitLocation const> bits) const {
   int64_t maybe_one_count = 0;
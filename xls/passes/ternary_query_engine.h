@@ -20,6 +20,7 @@
 #include "xls/ir/bits.h"
 #include "xls/ir/function.h"
 #include "xls/ir/nodes.h"
+#include "xls/ir/packed_ternary.h"
 #include "xls/passes/query_engine.h"
 
 namespace xls {
@@ -35,8 +36,17 @@ class TernaryQueryEngine : public QueryEngine {
 
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
+  // Brings the engine up to date with the current state of `f`. Only nodes
+  // which were added or whose operands changed since the previous call, and
+  // nodes downstream of them whose operand values changed, are re-evaluated.
+  // The resulting values are the same as those of a fresh engine populated
+  // with `f`. Unlike Populate, values are not combined with those from earlier
+  // evaluations, so Update and Populate should not be mixed on one engine.
+  // Returns the number of nodes evaluated.
+  absl::StatusOr<int64_t> Update(FunctionBase* f);
+
   bool IsTracked(Node* node) const override {
-    return known_bits_.contains(node);
+    return values_.contains(node);
   }
 
   LeafTypeTree<TernaryVector> GetTernary(Node* node) const override {
@@ -48,10 +58,8 @@ class TernaryQueryEngine : public QueryEngine {
                                  TernaryValue::kUnknown);
           });
     }
-    TernaryVector ternary =
-        ternary_ops::FromKnownBits(known_bits_.at(node), bits_values_.at(node));
     LeafTypeTree<TernaryVector> result(node->GetType());
-    result.Set({}, ternary);
+    result.Set({}, values_.at(node).ToTernaryVector());
     return result;
   }
 
@@ -75,13 +83,13 @@ class TernaryQueryEngine : public QueryEngine {
   }
 
  private:
-  // Holds which bits values are known for nodes in the function. A one in a bit
-  // position indications the respective bit value in the respective node is
-  // statically known.
-  absl::flat_hash_map<Node*, Bits> known_bits_;
+  // Holds the known bits and the values of the known bits of the nodes in the
+  // function. Bitwise operations, concats, and slices are evaluated directly on
+  // this packed representation a machine word (or vector) at a time.
+  absl::flat_hash_map<Node*, PackedTernaryVector> values_;
 
-  // Holds the values of statically known bits of nodes in the function.
-  absl::flat_hash_map<Node*, Bits> bits_values_;
+  // The signatures (see NodeSignature) of the nodes as of the last Update.
+  absl::flat_hash_map<Node*, uint64_t> signatures_;
 };
 
 }  // namespace xls
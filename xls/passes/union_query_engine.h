@@ -38,9 +38,18 @@ namespace xls {
 class UnionQueryEngine : public QueryEngine {
  public:
   explicit UnionQueryEngine(std::vector<std::unique_ptr<QueryEngine>> engines) {
-    engines_ = std::move(engines);
+    for (const std::unique_ptr<QueryEngine>& engine : engines) {
+      engines_.push_back(engine.get());
+    }
+    owned_engines_ = std::move(engines);
   }
 
+  // Combines engines which are owned elsewhere (e.g., by a QueryEngineCache)
+  // and must outlive this engine. If the engines are already populated the
+  // union may be queried without calling Populate.
+  explicit UnionQueryEngine(std::vector<QueryEngine*> engines)
+      : engines_(std::move(engines)) {}
+
   absl::StatusOr<ReachedFixpoint> Populate(FunctionBase* f) override;
 
   bool IsTracked(Node* node) const override;
@@ -69,7 +78,8 @@ class UnionQueryEngine : public QueryEngine {
  private:
   absl::flat_hash_map<Node*, Bits> known_bits_;
   absl::flat_hash_map<Node*, Bits> known_bit_values_;
-  std::vector<std::unique_ptr<QueryEngine>> engines_;
+  std::vector<std::unique_ptr<QueryEngine>> owned_engines_;
+  std::vector<QueryEngine*> engines_;
 };
 
 }  // namespace xls
@@ -14,13 +14,30 @@
 
 #include "xls/passes/verifier_checker.h"
 
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/function_base.h"
 #include "xls/ir/verifier.h"
 
 namespace xls {
 
 absl::Status VerifierChecker::Run(Package* p, const PassOptions& options,
                                   PassResults* results) const {
-  return VerifyPackage(p);
+  int64_t check_number = check_count_++;
+  bool full_verification =
+      check_number == 0 || (full_verification_interval_ > 0 &&
+                            check_number % full_verification_interval_ == 0);
+#ifdef DEBUG
+  full_verification = true;
+#endif
+  if (!full_verification) {
+    return VerifyChangedNodes(p);
+  }
+  XLS_RETURN_IF_ERROR(VerifyPackage(p));
+  // The package as a whole is now the checkpoint for later incremental checks.
+  for (FunctionBase* function_base : p->GetFunctionBases()) {
+    function_base->ClearChanges();
+  }
+  return absl::OkStatus();
 }
 
 }  // namespace xls
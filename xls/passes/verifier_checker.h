@@ -15,16 +15,33 @@
 #ifndef XLS_PASSES_VERIFIER_CHECKER_H_
 #define XLS_PASSES_VERIFIER_CHECKER_H_
 
+#include <cstdint>
+
 #include "absl/status/status.h"
 #include "xls/passes/passes.h"
 
 namespace xls {
 
-// Invariant checker which just runs xls::Verifier.
+// Invariant checker which runs xls::Verifier. By default only the IR changed
+// since the previous check is verified (see VerifyChangedNodes) with a full
+// VerifyPackage on the first check and every `full_verification_interval`
+// checks thereafter. A value of zero disables the periodic full checks
+// (other than the first) and a value of one verifies the whole package every
+// time. Debug builds always verify the whole package.
 class VerifierChecker : public InvariantChecker {
  public:
+  static constexpr int64_t kDefaultFullVerificationInterval = 64;
+
+  explicit VerifierChecker(
+      int64_t full_verification_interval = kDefaultFullVerificationInterval)
+      : full_verification_interval_(full_verification_interval) {}
+
   absl::Status Run(Package* p, const PassOptions& options,
                    PassResults* results) const override;
+
+ private:
+  int64_t full_verification_interval_;
+  mutable int64_t check_count_ = 0;
 };
 
 }  // namespace xls
@@ -0,0 +1,174 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/worklist_rewrite_pass.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "xls/common/logging/logging.h"
+#include "xls/common/status/status_macros.h"
+#include "xls/ir/node_iterator.h"
+#include "xls/ir/nodes.h"
+#include "xls/ir/op.h"
+#include "xls/ir/package.h"
+
+namespace xls {
+namespace {
+
+// Returns true if the pass with the given name is enabled by the
+// `run_only_passes` and `skip_passes` options.
+bool IsEnabled(std::string_view name, const PassOptions& options) {
+  auto matches = [&](const std::string& n) { return n == name; };
+  if (options.run_only_passes.has_value() &&
+      std::none_of(options.run_only_passes->begin(),
+                   options.run_only_passes->end(), matches)) {
+    return false;
+  }
+  return std::none_of(options.skip_passes.begin(), options.skip_passes.end(),
+                      matches);
+}
+
+// Returns true if the node may be removed once it has no users. Matches
+// DeadCodeEliminationPass.
+bool IsDeletable(Node* node) {
+  return !node->function_base()->HasImplicitUse(node) &&
+         (!OpIsSideEffecting(node->op()) || node->Is<Gate>());
+}
+
+// A queue of nodes in which each node appears at most once.
+class NodeWorklist {
+ public:
+  void Push(Node* node) {
+    if (queued_.insert(node).second) {
+      nodes_.push_back(node);
+    }
+  }
+
+  Node* Pop() {
+    Node* node = nodes_.front();
+    nodes_.pop_front();
+    queued_.erase(node);
+    return node;
+  }
+
+  bool empty() const { return nodes_.empty(); }
+
+ private:
+  std::deque<Node*> nodes_;
+  absl::flat_hash_set<Node*> queued_;
+};
+
+}  // namespace
+
+absl::StatusOr<bool> WorklistRewritePass::RunOnFunctionBaseInternal(
+    FunctionBase* f, const PassOptions& options, PassResults* results) const {
+  std::vector<const NodeRewritePass*> rewrites;
+  for (const NodeRewritePass* rewrite : rewrite_ptrs_) {
+    if (IsEnabled(rewrite->short_name(), options)) {
+      rewrites.push_back(rewrite);
+    }
+  }
+  if (rewrites.empty()) {
+    return false;
+  }
+
+  NodeWorklist worklist;
+  for (Node* node : TopoSort(f)) {
+    worklist.Push(node);
+  }
+
+  // Queues the given node and, transitively, any of its operands created by
+  // the current rewrite (those with ids of at least `first_new_id`).
+  std::vector<Node*> stack;
+  auto push_with_new_operands = [&](Node* node, int64_t first_new_id) {
+    stack.push_back(node);
+    while (!stack.empty()) {
+      Node* n = stack.back();
+      stack.pop_back();
+      worklist.Push(n);
+      for (Node* operand : n->operands()) {
+        if (operand->id() >= first_new_id) {
+          stack.push_back(operand);
+        }
+      }
+    }
+  };
+
+  bool changed = false;
+  int64_t visit_count = 0;
+  int64_t removed_count = 0;
+  std::vector<Node*> neighbors;
+  while (!worklist.empty()) {
+    Node* node = worklist.Pop();
+    ++visit_count;
+
+    // Remove dead nodes and revisit their operands which may now be dead or
+    // simplifiable because they have fewer users.
+    if (node->users().empty() && IsDeletable(node)) {
+      neighbors.clear();
+      for (Node* operand : node->operands()) {
+        if (std::find(neighbors.begin(), neighbors.end(), operand) ==
+            neighbors.end()) {
+          neighbors.push_back(operand);
+        }
+      }
+      XLS_VLOG(3) << "Worklist removing " << node->ToString();
+      XLS_RETURN_IF_ERROR(f->RemoveNode(node));
+      ++removed_count;
+      changed = true;
+      for (Node* operand : neighbors) {
+        worklist.Push(operand);
+      }
+      continue;
+    }
+
+    // A rewrite may change the operands of the node and the operands of its
+    // users, so save both beforehand.
+    neighbors.assign(node->operands().begin(), node->operands().end());
+    neighbors.insert(neighbors.end(), node->users().begin(),
+                     node->users().end());
+    int64_t first_new_id = f->package()->next_node_id();
+    for (const NodeRewritePass* rewrite : rewrites) {
+      XLS_ASSIGN_OR_RETURN(bool node_changed,
+                           rewrite->RewriteNode(node, options));
+      if (!node_changed) {
+        continue;
+      }
+      XLS_VLOG(3) << absl::StreamFormat("%s rewrote %s", rewrite->short_name(),
+                                        node->GetName());
+      changed = true;
+      // The remaining rewrites are tried when the node is revisited.
+      push_with_new_operands(node, first_new_id);
+      for (Node* neighbor : neighbors) {
+        push_with_new_operands(neighbor, first_new_id);
+      }
+      break;
+    }
+  }
+
+  XLS_VLOG(2) << absl::StreamFormat(
+      "Worklist visited %d nodes and removed %d dead nodes in %s", visit_count,
+      removed_count, f->name());
+  results->rewrite_node_visits += visit_count;
+  return changed;
+}
+
+}  // namespace xls
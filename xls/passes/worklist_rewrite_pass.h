@@ -0,0 +1,77 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef XLS_PASSES_WORKLIST_REWRITE_PASS_H_
+#define XLS_PASSES_WORKLIST_REWRITE_PASS_H_
+
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xls/ir/function.h"
+#include "xls/passes/passes.h"
+
+namespace xls {
+
+// Pass which runs a set of node-local rewrites (NodeRewritePasses) to a fixed
+// point using a worklist. Each node is visited once initially in topological
+// order. When a rewrite changes a node, only the node, its operands and users
+// (before and after the rewrite), and any nodes created by the rewrite are
+// requeued, rather than rerunning every rewrite over the whole function. Nodes
+// which become dead are removed as they are encountered, so rewrites need not
+// be interleaved with dead code elimination.
+//
+// The contained rewrites are individually subject to the `run_only_passes` and
+// `skip_passes` options.
+class WorklistRewritePass : public FunctionBasePass {
+ public:
+  WorklistRewritePass(std::string_view short_name, std::string_view long_name)
+      : FunctionBasePass(short_name, long_name) {}
+  ~WorklistRewritePass() override {}
+
+  // Adds a new rewrite to this pass. Arguments to method are the arguments to
+  // the rewrite pass constructor. Rewrites are tried on each visited node in
+  // the order in which they are added. Example usage:
+  //
+  //  pass->Add<ArithSimplificationPass>(opt_level);
+  //
+  // Returns a pointer to the newly constructed rewrite pass.
+  template <typename T, typename... Args>
+  T* Add(Args&&... args) {
+    auto* rewrite = new T(std::forward<Args>(args)...);
+    rewrites_.emplace_back(rewrite);
+    rewrite_ptrs_.push_back(rewrite);
+    return rewrite;
+  }
+
+  absl::Span<NodeRewritePass* const> rewrites() const { return rewrite_ptrs_; }
+
+  bool HasNestedPasses() const override { return true; }
+
+ protected:
+  absl::StatusOr<bool> RunOnFunctionBaseInternal(
+      FunctionBase* f, const PassOptions& options,
+      PassResults* results) const override;
+
+ private:
+  std::vector<std::unique_ptr<NodeRewritePass>> rewrites_;
+  std::vector<NodeRewritePass*> rewrite_ptrs_;
+};
+
+}  // namespace xls
+
+#endif  // XLS_PASSES_WORKLIST_REWRITE_PASS_H_
@@ -0,0 +1,154 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/passes/worklist_rewrite_pass.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "xls/common/status/matchers.h"
+#include "xls/ir/function.h"
+#include "xls/ir/ir_matcher.h"
+#include "xls/ir/ir_test_base.h"
+#include "xls/ir/package.h"
+#include "xls/passes/arith_simplification_pass.h"
+#include "xls/passes/canonicalization_pass.h"
+#include "xls/passes/constant_folding_pass.h"
+#include "xls/passes/identity_removal_pass.h"
+
+namespace m = ::xls::op_matchers;
+
+namespace xls {
+namespace {
+
+using status_testing::IsOkAndHolds;
+
+class WorklistRewritePassTest : public IrTestBase {
+ protected:
+  WorklistRewritePassTest() : pass_("rewrite", "Rewrite") {
+    pass_.Add<IdentityRemovalPass>();
+    pass_.Add<ConstantFoldingPass>();
+    pass_.Add<CanonicalizationPass>();
+    pass_.Add<ArithSimplificationPass>();
+  }
+
+  absl::StatusOr<bool> Run(FunctionBase* f,
+                           const PassOptions& options = PassOptions()) {
+    return pass_.RunOnFunctionBase(f, options, &results_);
+  }
+
+  WorklistRewritePass pass_;
+  PassResults results_;
+};
+
+TEST_F(WorklistRewritePassTest, RewritesEnableEachOther) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn func(x: bits[32]) -> bits[32] {
+       identity.2: bits[32] = identity(x)
+       literal.3: bits[32] = literal(value=0)
+       literal.4: bits[32] = literal(value=0)
+       add.5: bits[32] = add(literal.3, literal.4)
+       add.6: bits[32] = add(add.5, identity.2)
+       ret identity.7: bits[32] = identity(add.6)
+     }
+  )",
+                                                       p.get()));
+  // Removing the identities, folding the inner add, moving the literal to the
+  // right, and removing the add of zero all happen in a single run with the
+  // dead nodes removed along the way.
+  EXPECT_THAT(Run(f), IsOkAndHolds(true));
+  EXPECT_THAT(f->return_value(), m::Param("x"));
+  EXPECT_EQ(f->node_count(), 1);
+  EXPECT_GE(results_.rewrite_node_visits, 7);
+}
+
+TEST_F(WorklistRewritePassTest, VisitsEachNodeOnceWhenNothingChanges) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn func(x: bits[32], y: bits[32]) -> bits[32] {
+       add.3: bits[32] = add(x, y)
+       ret neg.4: bits[32] = neg(add.3)
+     }
+  )",
+                                                       p.get()));
+  EXPECT_THAT(Run(f), IsOkAndHolds(false));
+  EXPECT_EQ(results_.rewrite_node_visits, 4);
+}
+
+TEST_F(WorklistRewritePassTest, RemovesDeadNodes) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn func(x: bits[32], y: bits[32]) -> bits[32] {
+       add.3: bits[32] = add(x, y)
+       neg.4: bits[32] = neg(add.3)
+       ret sub.5: bits[32] = sub(x, y)
+     }
+  )",
+                                                       p.get()));
+  EXPECT_THAT(Run(f), IsOkAndHolds(true));
+  EXPECT_THAT(f->return_value(), m::Sub(m::Param("x"), m::Param("y")));
+  EXPECT_EQ(f->node_count(), 3);
+}
+
+TEST_F(WorklistRewritePassTest, SkippedRewritesAreNotRun) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn func(x: bits[32]) -> bits[32] {
+       identity.2: bits[32] = identity(x)
+       literal.3: bits[32] = literal(value=2)
+       literal.4: bits[32] = literal(value=3)
+       add.5: bits[32] = add(literal.3, literal.4)
+       ret add.6: bits[32] = add(identity.2, add.5)
+     }
+  )",
+                                                       p.get()));
+  PassOptions options;
+  options.skip_passes = {"const_fold"};
+  EXPECT_THAT(Run(f, options), IsOkAndHolds(true));
+  EXPECT_THAT(f->return_value(),
+              m::Add(m::Param("x"), m::Add(m::Literal(2), m::Literal(3))));
+
+  options.skip_passes = {};
+  options.run_only_passes = std::vector<std::string>{"ident_remove"};
+  EXPECT_THAT(Run(f, options), IsOkAndHolds(false));
+
+  options.run_only_passes = std::vector<std::string>{"const_fold"};
+  EXPECT_THAT(Run(f, options), IsOkAndHolds(true));
+  EXPECT_THAT(f->return_value(), m::Add(m::Param("x"), m::Literal(5)));
+}
+
+TEST_F(WorklistRewritePassTest, RunOnlyNestedRewriteInCompoundPass) {
+  auto p = CreatePackage();
+  XLS_ASSERT_OK_AND_ASSIGN(Function * f, ParseFunction(R"(
+     fn func(x: bits[32]) -> bits[32] {
+       ret identity.2: bits[32] = identity(x)
+     }
+  )",
+                                                       p.get()));
+  CompoundPass compound("compound", "Compound");
+  compound.Add<WorklistRewritePass>("rewrite", "Rewrite")
+      ->Add<IdentityRemovalPass>();
+  PassOptions options;
+  options.run_only_passes = std::vector<std::string>{"ident_remove"};
+  EXPECT_THAT(compound.Run(p.get(), options, &results_), IsOkAndHolds(true));
+  EXPECT_THAT(f->return_value(), m::Param("x"));
+}
+
+}  // namespace
+}  // namespace xls
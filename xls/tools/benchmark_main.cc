@@ -21,7 +21,6 @@
 #include "absl/time/clock.h"
 #include "xls/codegen/module_signature.h"
 #include "xls/codegen/pipeline_generator.h"
-#include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
 #include "xls/common/math_util.h"
@@ -31,7 +30,6 @@
 #include "xls/delay_model/delay_estimators.h"
 #include "xls/interpreter/function_interpreter.h"
 #include "xls/interpreter/random_value.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/node_iterator.h"
 #include "xls/jit/function_jit.h"
 #include "xls/jit/proc_jit.h"
@@ -40,6 +38,7 @@
 #include "xls/passes/standard_pipeline.h"
 #include "xls/scheduling/pipeline_schedule.h"
 #include "xls/scheduling/scheduling_pass_pipeline.h"
+#include "xls/tools/ir_io.h"
 
 const char kUsage[] = R"(
 Prints numerous metrics and other information about an XLS IR file including:
@@ -85,6 +84,9 @@ ABSL_FLAG(int64_t, convert_array_index_to_select, -1,
           "equal to the given number of possible indices (by range analysis) "
           "into chains of selects. Otherwise, this optimization is skipped, "
           "since it can sometimes reduce output quality.");
+ABSL_FLAG(std::string, input_format, "auto",
+          "Format of the input IR file: auto (detect from the contents), "
+          "text or binary.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
 
 namespace xls {
@@ -539,9 +541,11 @@ absl::Status RealMain(std::string_view path,
                       std::optional<int64_t> pipeline_stages,
                       std::optional<int64_t> clock_margin_percent) {
   XLS_VLOG(1) << "Reading contents at path: " << path;
-  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(path));
+  XLS_ASSIGN_OR_RETURN(
+      tools::IrFormat input_format,
+      tools::IrFormatFromString(absl::GetFlag(FLAGS_input_format)));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(contents));
+                       tools::ReadPackageFile(path, input_format));
   if (!absl::GetFlag(FLAGS_top).empty()) {
     XLS_RETURN_IF_ERROR(package->SetTopByName(absl::GetFlag(FLAGS_top)));
   }
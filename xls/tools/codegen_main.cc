@@ -30,11 +30,11 @@
 #include "xls/common/status/status_macros.h"
 #include "xls/delay_model/delay_estimator.h"
 #include "xls/delay_model/delay_estimators.h"
-#include "xls/ir/ir_parser.h"
 #include "xls/ir/verifier.h"
 #include "xls/passes/standard_pipeline.h"
 #include "xls/scheduling/scheduling_pass_pipeline.h"
 #include "xls/tools/codegen_flags.h"
+#include "xls/tools/ir_io.h"
 #include "xls/tools/scheduling_options_flags.h"
 
 const char kUsage[] = R"(
@@ -52,6 +52,13 @@ Emit a feed-forward pipelined module:
        IR_FILE
 )";
 
+ABSL_FLAG(std::string, input_format, "auto",
+          "Format of the input IR file: auto (detect from the contents), "
+          "text or binary.");
+ABSL_FLAG(std::string, output_format, "text",
+          "Format of the block IR written to --output_block_ir_path: text or "
+          "binary.");
+
 namespace xls {
 namespace {
 
@@ -193,9 +200,14 @@ absl::Status RealMain(std::string_view ir_path) {
     ir_path = "/dev/stdin";
   }
 
-  XLS_ASSIGN_OR_RETURN(std::string ir_contents, GetFileContents(ir_path));
+  XLS_ASSIGN_OR_RETURN(
+      tools::IrFormat input_format,
+      tools::IrFormatFromString(absl::GetFlag(FLAGS_input_format)));
+  XLS_ASSIGN_OR_RETURN(
+      tools::IrFormat output_format,
+      tools::IrFormatFromString(absl::GetFlag(FLAGS_output_format)));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> p,
-                       Parser::ParsePackage(ir_contents, ir_path));
+                       tools::ReadPackageFile(ir_path, input_format));
 
   if (!codegen_flags_proto.top().empty()) {
     XLS_RETURN_IF_ERROR(p->SetTopByName(codegen_flags_proto.top()));
@@ -244,8 +256,10 @@ absl::Status RealMain(std::string_view ir_path) {
     XLS_QCHECK_EQ(p->blocks().size(), 1)
         << "There should be exactly one block in the package after generating "
            "module text.";
+    XLS_ASSIGN_OR_RETURN(std::string block_ir,
+                         tools::SerializePackage(*p, output_format));
     XLS_RETURN_IF_ERROR(SetFileContents(
-        codegen_flags_proto.output_block_ir_path(), p->DumpIr()));
+        codegen_flags_proto.output_block_ir_path(), block_ir));
   }
 
   if (!codegen_flags_proto.output_signature_path().empty()) {
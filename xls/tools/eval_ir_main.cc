@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <optional>
 #include <random>
 
 #include "absl/flags/flag.h"
@@ -31,6 +32,7 @@
 #include "xls/dslx/ir_converter.h"
 #include "xls/dslx/mangle.h"
 #include "xls/dslx/parse_and_typecheck.h"
+#include "xls/interpreter/compiled_function_interpreter.h"
 #include "xls/interpreter/function_interpreter.h"
 #include "xls/interpreter/ir_interpreter.h"
 #include "xls/interpreter/random_value.h"
@@ -39,6 +41,7 @@
 #include "xls/jit/function_jit.h"
 #include "xls/passes/passes.h"
 #include "xls/passes/standard_pipeline.h"
+#include "xls/tools/ir_io.h"
 
 const char kUsage[] = R"(
 Evaluates an IR file with user-specified or random inputs using the IR
@@ -115,6 +118,10 @@ ABSL_FLAG(
     "When specified with --optimize_ir, run evaluation after each pass. "
     "A non-zero error status is returned if any of the results do not match.");
 ABSL_FLAG(bool, use_llvm_jit, true, "Use the LLVM IR JIT for execution.");
+ABSL_FLAG(bool, use_compiled_interpreter, false,
+          "When not using the JIT, lower the function once into a flat "
+          "instruction array and evaluate every input with it rather than "
+          "walking the function's nodes for each input.");
 ABSL_FLAG(bool, test_llvm_jit, false,
           "If true, then run the JIT and compare the results against the "
           "interpereter.");
@@ -139,6 +146,9 @@ ABSL_FLAG(
     std::string, test_only_inject_jit_result, "",
     "Test-only flag for injecting the result produced by the JIT. Used to "
     "force mismatches between JIT and interpreter for testing purposed.");
+ABSL_FLAG(std::string, input_format, "auto",
+          "Format of the IR file: auto (detect from the contents), text or "
+          "binary.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
 
 namespace xls {
@@ -168,17 +178,41 @@ absl::StatusOr<std::vector<Value>> Eval(
     std::string_view actual_src = "actual",
     std::string_view expected_src = "expected") {
   std::unique_ptr<FunctionJit> jit;
+  // Results of evaluating all the ArgSets in a single batched JIT invocation.
+  std::optional<std::vector<Value>> batched_jit_results;
   if (use_jit) {
     // No support for procs yet.
     XLS_ASSIGN_OR_RETURN(
-        jit, FunctionJit::Create(f, absl::GetFlag(FLAGS_llvm_opt_level)));
+        jit, FunctionJit::Create(f, absl::GetFlag(FLAGS_llvm_opt_level),
+                                 /*with_batched_entry_point=*/true));
+    if (absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
+      std::vector<std::vector<Value>> args_batch;
+      args_batch.reserve(arg_sets.size());
+      for (const ArgSet& arg_set : arg_sets) {
+        args_batch.push_back(arg_set.args);
+      }
+      absl::StatusOr<InterpreterResult<std::vector<Value>>> jit_results =
+          jit->RunBatched(args_batch);
+      // On an error or assertion failure fall back to evaluating the ArgSets
+      // one at a time to report the failure for the proper input.
+      if (jit_results.ok() && jit_results->events.assert_msgs.empty()) {
+        batched_jit_results = std::move(jit_results->value);
+      }
+    }
+  }
+  std::unique_ptr<CompiledFunctionInterpreter> compiled_interpreter;
+  if (!use_jit && absl::GetFlag(FLAGS_use_compiled_interpreter)) {
+    XLS_ASSIGN_OR_RETURN(compiled_interpreter,
+                         CompiledFunctionInterpreter::Create(f));
   }
 
   std::vector<Value> results;
   for (const ArgSet& arg_set : arg_sets) {
     Value result;
     if (use_jit) {
-      if (absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
+      if (batched_jit_results.has_value()) {
+        result = batched_jit_results->at(results.size());
+      } else if (absl::GetFlag(FLAGS_test_only_inject_jit_result).empty()) {
         XLS_ASSIGN_OR_RETURN(result,
                              DropInterpreterEvents(jit->Run(arg_set.args)));
       } else {
@@ -190,8 +224,14 @@ absl::StatusOr<std::vector<Value>> Eval(
       // resulting events once the JIT fully supports events. Note: This will
       // require rethinking some of the control flow because event comparison
       // only makes sense for certain modes (optimize_ir and test_llvm_jit).
-      XLS_ASSIGN_OR_RETURN(
-          result, DropInterpreterEvents(InterpretFunction(f, arg_set.args)));
+      if (compiled_interpreter != nullptr) {
+        XLS_ASSIGN_OR_RETURN(
+            result,
+            DropInterpreterEvents(compiled_interpreter->Run(arg_set.args)));
+      } else {
+        XLS_ASSIGN_OR_RETURN(
+            result, DropInterpreterEvents(InterpretFunction(f, arg_set.args)));
+      }
     }
     std::cout << result.ToString(FormatPreference::kHex) << std::endl;
 
@@ -392,9 +432,11 @@ absl::Status RealMain(std::string_view input_path,
   if (input_path == "-") {
     input_path = "/dev/stdin";
   }
-  XLS_ASSIGN_OR_RETURN(std::string contents, GetFileContents(input_path));
+  XLS_ASSIGN_OR_RETURN(
+      tools::IrFormat input_format,
+      tools::IrFormatFromString(absl::GetFlag(FLAGS_input_format)));
   XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(contents, input_path));
+                       tools::ReadPackageFile(input_path, input_format));
   if (!absl::GetFlag(FLAGS_top).empty()) {
     XLS_RETURN_IF_ERROR(package->SetTopByName(absl::GetFlag(FLAGS_top)));
   }
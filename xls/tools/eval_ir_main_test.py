@@ -61,6 +61,15 @@ class EvalMainTest(absltest.TestCase):
     ])
     self.assertEqual(result.decode('utf-8').strip(), 'bits[32]:0x165')
 
+  def test_one_input_compiled_interpreter(self):
+    ir_file = self.create_tempfile(content=ADD_IR)
+    result = subprocess.check_output([
+        EVAL_IR_MAIN_PATH, '--input=bits[32]:0x42; bits[32]:0x123',
+        '--use_llvm_jit=false', '--use_compiled_interpreter',
+        ir_file.full_path
+    ])
+    self.assertEqual(result.decode('utf-8').strip(), 'bits[32]:0x165')
+
   def test_one_input_jit_with_vlog(self):
     # Checks that enabling vlog doesn't crash.
     ir_file = self.create_tempfile(content=ADD_IR)
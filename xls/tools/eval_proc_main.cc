@@ -16,6 +16,8 @@
 
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <random>
 #include <string>
@@ -35,16 +37,21 @@
 #include "xls/common/file/filesystem.h"
 #include "xls/common/init_xls.h"
 #include "xls/common/logging/logging.h"
+#include "xls/common/status/ret_check.h"
 #include "xls/common/status/status_macros.h"
 #include "xls/interpreter/block_interpreter.h"
 #include "xls/interpreter/channel_queue.h"
 #include "xls/interpreter/interpreter_proc_runtime.h"
-#include "xls/interpreter/serial_proc_runtime.h"
+#include "xls/interpreter/proc_runtime.h"
 #include "xls/ir/bits.h"
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/value_helpers.h"
+#include "xls/jit/block_jit.h"
 #include "xls/jit/jit_proc_runtime.h"
+#include "xls/jit/proc_jit.h"
+#include "xls/jit/tiered_jit.h"
 #include "xls/tools/eval_helpers.h"
+#include "xls/tools/ir_io.h"
 
 constexpr const char* kUsage = R"(
 Evaluates an IR file containing Procs, or a Block generated from them.
@@ -62,8 +69,20 @@ ABSL_FLAG(std::vector<std::string>, ticks, {},
 ABSL_FLAG(std::string, backend, "serial_jit",
           "Backend to use for evaluation. Valid options are:\n"
           " * serial_jit: JIT-backed single-stepping runtime.\n"
+          " * threaded_jit: JIT-backed runtime which ticks procs concurrently "
+          "on a pool of worker threads.\n"
           " * ir_interpreter: Interpreter at the IR level.\n"
-          " * block_interpreter: Interpret a block generated from a proc.");
+          " * block_interpreter: Interpret a block generated from a proc.\n"
+          " * block_jit: JIT-compile and simulate a block generated from a "
+          "proc.");
+ABSL_FLAG(bool, use_compiled_interpreter, false,
+          "For the ir_interpreter backend, lower each proc once into a flat "
+          "instruction array rather than walking the proc's nodes every "
+          "tick.");
+ABSL_FLAG(int64_t, threads, 0,
+          "Number of worker threads for the threaded_jit backend. If zero, "
+          "a default based on the number of procs and hardware threads is "
+          "used.");
 ABSL_FLAG(std::string, block_signature_proto, "",
           "Path to textproto file containing signature from codegen");
 ABSL_FLAG(int64_t, max_cycles_no_output, 100,
@@ -120,19 +139,47 @@ ABSL_FLAG(int64_t, random_seed, 42, "Random seed");
 ABSL_FLAG(double, prob_input_valid_assert, 1.0,
           "Single-cycle probability of asserting valid with more input ready.");
 ABSL_FLAG(bool, show_trace, false, "Whether or not to print trace messages.");
+ABSL_FLAG(bool, jit_tiering, false,
+          "For the JIT backends, compile procs at -O0 for a low latency to "
+          "the first tick and recompile them at -O3 in the background once "
+          "they have been ticked --jit_tiering_threshold times.");
+ABSL_FLAG(int64_t, jit_tiering_threshold, 1000,
+          "Number of ticks of a proc after which it is recompiled at -O3 "
+          "with --jit_tiering.");
+ABSL_FLAG(bool, show_jit_stats, false,
+          "For the serial_jit and threaded_jit backends, print the "
+          "optimization level and compilation times of each proc after "
+          "evaluation.");
+ABSL_FLAG(std::string, input_format, "auto",
+          "Format of the IR file: auto (detect from the contents), text or "
+          "binary.");
 
 namespace xls {
 
 absl::Status EvaluateProcs(
-    Package* package, bool use_jit, const std::vector<int64_t>& ticks,
+    Package* package, std::string_view backend,
+    const std::vector<int64_t>& ticks,
     absl::flat_hash_map<std::string, std::vector<Value>> inputs_for_channels,
     absl::flat_hash_map<std::string, std::vector<Value>>
         expected_outputs_for_channels) {
-  std::unique_ptr<SerialProcRuntime> runtime;
-  if (use_jit) {
-    XLS_ASSIGN_OR_RETURN(runtime, CreateJitSerialProcRuntime(package));
+  std::unique_ptr<ProcRuntime> runtime;
+  std::optional<JitTieringOptions> tiering;
+  if (absl::GetFlag(FLAGS_jit_tiering)) {
+    tiering = JitTieringOptions{
+        .initial_opt_level = 0,
+        .optimized_opt_level = 3,
+        .invocation_threshold = absl::GetFlag(FLAGS_jit_tiering_threshold)};
+  }
+  if (backend == "serial_jit") {
+    XLS_ASSIGN_OR_RETURN(runtime, CreateJitSerialProcRuntime(package, tiering));
+  } else if (backend == "threaded_jit") {
+    XLS_ASSIGN_OR_RETURN(
+        runtime, CreateJitThreadedProcRuntime(
+                     package, absl::GetFlag(FLAGS_threads), tiering));
   } else {
-    XLS_ASSIGN_OR_RETURN(runtime, CreateInterpreterSerialProcRuntime(package));
+    XLS_ASSIGN_OR_RETURN(
+        runtime, CreateInterpreterSerialProcRuntime(
+                     package, absl::GetFlag(FLAGS_use_compiled_interpreter)));
   }
 
   ChannelQueueManager& queue_manager = runtime->queue_manager();
@@ -180,6 +227,17 @@ absl::Status EvaluateProcs(
     }
   }
 
+  if (absl::GetFlag(FLAGS_show_jit_stats) &&
+      (backend == "serial_jit" || backend == "threaded_jit")) {
+    for (const auto& proc : package->procs()) {
+      const ProcJit* proc_jit =
+          dynamic_cast<const ProcJit*>(&runtime->GetProcEvaluator(proc.get()));
+      XLS_RET_CHECK(proc_jit != nullptr);
+      std::cerr << "Proc " << proc->name()
+                << " JIT stats: " << proc_jit->GetJitStats().ToString() << "\n";
+    }
+  }
+
   bool checked_any_output = false;
   for (const auto& [channel_name, values] : expected_outputs_for_channels) {
     XLS_ASSIGN_OR_RETURN(ChannelQueue * out_queue,
@@ -339,7 +397,8 @@ Value XsForWidth(uint64_t width) {
 Value XsOfType(Type* type) { return AllOnesOfType(type); }
 
 absl::Status RunBlockInterpreter(
-    Package* package, const std::vector<int64_t>& ticks,
+    Package* package, std::string_view backend,
+    const std::vector<int64_t>& ticks,
     const verilog::ModuleSignatureProto& signature,
     const int64_t max_cycles_no_output,
     absl::flat_hash_map<std::string, std::vector<Value>> inputs_for_channels,
@@ -399,6 +458,14 @@ absl::Status RunBlockInterpreter(
     reg_state[reg->name()] = XsOfType(reg->type());
   }
 
+  // With the JIT the register state lives in the JIT's packed state buffer
+  // across cycles rather than in `reg_state`.
+  std::unique_ptr<BlockJit> jit;
+  if (backend == "block_jit") {
+    XLS_ASSIGN_OR_RETURN(jit, BlockJit::Create(block));
+    XLS_RETURN_IF_ERROR(jit->SetRegisters(reg_state));
+  }
+
   int64_t last_output_cycle = 0;
   int64_t matched_outputs = 0;
 
@@ -445,9 +512,17 @@ absl::Status RunBlockInterpreter(
       input_set[info.channel_ready] = xls::Value(xls::UBits(1, 1));
     }
 
-    XLS_ASSIGN_OR_RETURN(xls::BlockRunResult result,
-                         xls::BlockRun(input_set, reg_state, block));
-    reg_state = std::move(result.reg_state);
+    absl::flat_hash_map<std::string, Value> outputs;
+    if (jit != nullptr) {
+      XLS_RETURN_IF_ERROR(jit->SetInputs(input_set));
+      jit->Tick();
+      outputs = jit->GetOutputs();
+    } else {
+      XLS_ASSIGN_OR_RETURN(xls::BlockRunResult result,
+                           xls::BlockRun(input_set, reg_state, block));
+      reg_state = std::move(result.reg_state);
+      outputs = std::move(result.outputs);
+    }
 
     if (resetting) {
       last_output_cycle = cycle;
@@ -463,8 +538,7 @@ absl::Status RunBlockInterpreter(
       }
 
       const bool vld_value = input_set.at(info.channel_valid).bits().Get(0);
-      const bool rdy_value =
-          result.outputs.at(info.channel_ready).bits().Get(0);
+      const bool rdy_value = outputs.at(info.channel_ready).bits().Get(0);
 
       std::queue<Value>& queue = channel_value_queues.at(name);
 
@@ -477,8 +551,7 @@ absl::Status RunBlockInterpreter(
     for (const auto& [name, _] : expected_outputs_for_channels) {
       const ChannelInfo& info = channel_info.at(name);
 
-      const bool vld_value =
-          result.outputs.at(info.channel_valid).bits().Get(0);
+      const bool vld_value = outputs.at(info.channel_valid).bits().Get(0);
       const bool rdy_value = input_set.at(info.channel_ready).bits().Get(0);
 
       std::queue<Value>& queue = channel_value_queues.at(name);
@@ -490,7 +563,7 @@ absl::Status RunBlockInterpreter(
                               "list for channel %s",
                               name));
         }
-        const xls::Value& data_value = result.outputs.at(info.channel_data);
+        const xls::Value& data_value = outputs.at(info.channel_data);
         const Value& match_value = queue.front();
         if (match_value != data_value) {
           return absl::UnknownError(absl::StrFormat(
@@ -585,7 +658,8 @@ GetValuesForEachChannels(
 }
 
 absl::Status RealMain(
-    std::string_view ir_file, std::string_view backend,
+    std::string_view ir_file, tools::IrFormat input_format,
+    std::string_view backend,
     std::string_view block_signature_proto, std::vector<int64_t> ticks,
     const int64_t max_cycles_no_output,
     std::vector<std::string> inputs_for_channels_text,
@@ -626,25 +700,23 @@ absl::Status RealMain(
                                    total_ticks));
   }
 
-  XLS_ASSIGN_OR_RETURN(std::string ir_text, GetFileContents(ir_file));
-  XLS_ASSIGN_OR_RETURN(auto package, Parser::ParsePackage(ir_text));
+  XLS_ASSIGN_OR_RETURN(auto package,
+                       tools::ReadPackageFile(ir_file, input_format));
 
-  if (backend == "serial_jit") {
-    return EvaluateProcs(package.get(), /*use_jit=*/true, ticks,
-                         inputs_for_channels, expected_outputs_for_channels);
-  }
-  if (backend == "ir_interpreter") {
-    return EvaluateProcs(package.get(), /*use_jit=*/false, ticks,
-                         inputs_for_channels, expected_outputs_for_channels);
+  if (backend == "serial_jit" || backend == "threaded_jit" ||
+      backend == "ir_interpreter") {
+    return EvaluateProcs(package.get(), backend, ticks, inputs_for_channels,
+                         expected_outputs_for_channels);
   }
-  if (backend == "block_interpreter") {
+  if (backend == "block_interpreter" || backend == "block_jit") {
     verilog::ModuleSignatureProto proto;
     XLS_CHECK_OK(ParseTextProtoFile(block_signature_proto, &proto));
     return RunBlockInterpreter(
-        package.get(), ticks, proto, max_cycles_no_output, inputs_for_channels,
-        expected_outputs_for_channels, streaming_channel_data_suffix,
-        streaming_channel_ready_suffix, streaming_channel_valid_suffix,
-        idle_channel_name, random_seed, prob_input_valid_assert);
+        package.get(), backend, ticks, proto, max_cycles_no_output,
+        inputs_for_channels, expected_outputs_for_channels,
+        streaming_channel_data_suffix, streaming_channel_ready_suffix,
+        streaming_channel_valid_suffix, idle_channel_name, random_seed,
+        prob_input_valid_assert);
   }
   XLS_LOG(QFATAL) << "Unknown backend type";
 }
@@ -658,15 +730,20 @@ int main(int argc, char* argv[]) {
     XLS_LOG(QFATAL) << "One (and only one) IR file must be given.";
   }
 
+  absl::StatusOr<xls::tools::IrFormat> input_format =
+      xls::tools::IrFormatFromString(absl::GetFlag(FLAGS_input_format));
+  XLS_QCHECK_OK(input_format.status());
+
   std::string backend = absl::GetFlag(FLAGS_backend);
-  if (backend != "serial_jit" && backend != "ir_interpreter" &&
-      backend != "block_interpreter") {
+  if (backend != "serial_jit" && backend != "threaded_jit" &&
+      backend != "ir_interpreter" && backend != "block_interpreter" &&
+      backend != "block_jit") {
     XLS_LOG(QFATAL) << "Unrecognized backend choice.";
   }
 
-  if (backend == "block_interpreter" &&
+  if ((backend == "block_interpreter" || backend == "block_jit") &&
       absl::GetFlag(FLAGS_block_signature_proto).empty()) {
-    XLS_LOG(QFATAL) << "Block interpreter requires --block_signature_proto.";
+    XLS_LOG(QFATAL) << "Block simulation requires --block_signature_proto.";
   }
 
   std::vector<int64_t> ticks;
@@ -695,7 +772,8 @@ int main(int argc, char* argv[]) {
   }
 
   XLS_QCHECK_OK(xls::RealMain(
-      positional_args[0], backend, absl::GetFlag(FLAGS_block_signature_proto),
+      positional_args[0], input_format.value(), backend,
+      absl::GetFlag(FLAGS_block_signature_proto),
       ticks, absl::GetFlag(FLAGS_max_cycles_no_output),
       absl::GetFlag(FLAGS_inputs_for_channels),
       absl::GetFlag(FLAGS_expected_outputs_for_channels),
@@ -388,9 +388,17 @@ class EvalProcTest(absltest.TestCase):
     output = run_command(shared_args + ["--backend", "ir_interpreter"])
     self.assertIn("Proc test_proc", output.stderr)
 
+    output = run_command(
+        shared_args +
+        ["--backend", "ir_interpreter", "--use_compiled_interpreter"])
+    self.assertIn("Proc test_proc", output.stderr)
+
     output = run_command(shared_args + ["--backend", "serial_jit"])
     self.assertIn("Proc test_proc", output.stderr)
 
+    output = run_command(shared_args + ["--backend", "threaded_jit"])
+    self.assertIn("Proc test_proc", output.stderr)
+
   def test_reset_static(self):
     ir_file = self.create_tempfile(content=PROC_IR)
     input_file = self.create_tempfile(
@@ -457,7 +465,7 @@ class EvalProcTest(absltest.TestCase):
     shared_args = [
         EVAL_PROC_MAIN_PATH, ir_file.full_path, "--ticks", "2", "-v=3",
         "--logtostderr", "--block_signature_proto", signature_file.full_path,
-        "--backend", "block_interpreter", "--inputs_for_channels",
+        "--inputs_for_channels",
         "in_ch={infile1},in_ch_2={infile2}".format(
             infile1=input_file.full_path,
             infile2=input_file_2.full_path), "--expected_outputs_for_channels",
@@ -465,7 +473,10 @@ class EvalProcTest(absltest.TestCase):
             outfile=output_file.full_path, outfile2=output_file_2.full_path)
     ]
 
-    output = run_command(shared_args)
+    output = run_command(shared_args + ["--backend", "block_interpreter"])
+    self.assertIn("Cycle[6]: resetting? false", output.stderr)
+
+    output = run_command(shared_args + ["--backend", "block_jit"])
     self.assertIn("Cycle[6]: resetting? false", output.stderr)
 
   def test_block_no_output(self):
@@ -578,12 +589,14 @@ class EvalProcTest(absltest.TestCase):
     shared_args = [
         EVAL_PROC_MAIN_PATH, ir_file.full_path, "--ticks", "2", "-v=3",
         "--logtostderr", "--block_signature_proto", signature_file.full_path,
-        "--backend", "block_interpreter", "--inputs_for_all_channels",
-        input_file.full_path, "--expected_outputs_for_all_channels",
-        output_file.full_path
+        "--inputs_for_all_channels", input_file.full_path,
+        "--expected_outputs_for_all_channels", output_file.full_path
     ]
 
-    output = run_command(shared_args)
+    output = run_command(shared_args + ["--backend", "block_interpreter"])
+    self.assertIn("Cycle[6]: resetting? false", output.stderr)
+
+    output = run_command(shared_args + ["--backend", "block_jit"])
     self.assertIn("Cycle[6]: resetting? false", output.stderr)
 
   def test_output_channels_stdout_display_proc(self):
@@ -0,0 +1,56 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "xls/tools/ir_io.h"
+
+#include <optional>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "xls/ir/ir_parser.h"
+
+namespace xls::tools {
+
+absl::StatusOr<IrFormat> IrFormatFromString(std::string_view s) {
+  if (s == "auto") {
+    return IrFormat::kAuto;
+  }
+  if (s == "text") {
+    return IrFormat::kText;
+  }
+  if (s == "binary") {
+    return IrFormat::kBinary;
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Invalid IR format `%s`; expected auto, text or binary", s));
+}
+
+absl::StatusOr<std::unique_ptr<Package>> ReadPackageFile(
+    const std::filesystem::path& path, IrFormat format) {
+  std::optional<bool> binary;
+  if (format != IrFormat::kAuto) {
+    binary = format == IrFormat::kBinary;
+  }
+  return Parser::ParsePackageFile(path, binary);
+}
+
+absl::StatusOr<std::string> SerializePackage(const Package& package,
+                                             IrFormat format) {
+  if (format == IrFormat::kBinary) {
+    return package.ToBinary();
+  }
+  return package.DumpIr();
+}
+
+}  // namespace xls::tools
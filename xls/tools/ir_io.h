@@ -0,0 +1,55 @@
+// Copyright 2023 The XLS Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Helpers for reading and writing IR packages in the formats supported by the
+// command line tools.
+
+#ifndef XLS_TOOLS_IR_IO_H_
+#define XLS_TOOLS_IR_IO_H_
+
+#include <filesystem>  // NOLINT
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "xls/ir/package.h"
+
+namespace xls::tools {
+
+// Format of an IR file: the textual IR or the binary IR format (see
+// xls/ir/ir_binary_format.h). When reading, kAuto detects the format from the
+// contents; when writing, kAuto produces text.
+enum class IrFormat {
+  kAuto,
+  kText,
+  kBinary,
+};
+
+// Parses the value of an --input_format or --output_format flag: "auto",
+// "text" or "binary".
+absl::StatusOr<IrFormat> IrFormatFromString(std::string_view s);
+
+// Reads and verifies the package in the file at the given path in the given
+// format.
+absl::StatusOr<std::unique_ptr<Package>> ReadPackageFile(
+    const std::filesystem::path& path, IrFormat format = IrFormat::kAuto);
+
+// Returns the given package serialized in the given format.
+absl::StatusOr<std::string> SerializePackage(const Package& package,
+                                             IrFormat format);
+
+}  // namespace xls::tools
+
+#endif  // XLS_TOOLS_IR_IO_H_
@@ -31,6 +31,7 @@
 #include "xls/ir/ir_parser.h"
 #include "xls/ir/node_util.h"
 #include "xls/ir/number_parser.h"
+#include "xls/ir/package_snapshot.h"
 #include "xls/ir/value.h"
 #include "xls/ir/value_helpers.h"
 #include "xls/ir/verifier.h"
@@ -740,6 +741,20 @@ absl::Status CleanUp(FunctionBase* f, bool can_remove_params) {
   return absl::OkStatus();
 }
 
+// Undoes the changes made to the package since the snapshot was taken. If the
+// changes cannot be rolled back the package is discarded instead so that it is
+// reparsed from the IR text of the known failing sample.
+absl::Status Undo(PackageSnapshot* snapshot,
+                  std::unique_ptr<Package>* package) {
+  if (snapshot->CanRollback()) {
+    return snapshot->Rollback();
+  }
+  XLS_VLOG(1) << "Changes cannot be rolled back, reparsing the sample.";
+  snapshot->Commit();
+  package->reset();
+  return absl::OkStatus();
+}
+
 absl::Status RealMain(std::string_view path,
                       const int64_t failed_attempt_limit,
                       const int64_t total_attempt_limit) {
@@ -786,7 +801,12 @@ absl::Status RealMain(std::string_view path,
   // If so, we start simplifying via this seeded RNG.
   std::mt19937 rng;  // Default constructor uses deterministic seed.
 
-  // Smallest version of the function that's known to be failing.
+  // Smallest version of the function that's known to be failing. Each
+  // simplification is attempted on this package under a snapshot and undone
+  // if the sample no longer fails, which avoids reparsing the whole package
+  // for every attempt.
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       ParsePackage(knownf_ir_text));
   int64_t failed_simplification_attempts = 0;
   int64_t total_attempts = 0;
 
@@ -806,8 +826,11 @@ absl::Status RealMain(std::string_view path,
 
     XLS_VLOG(1) << "=== Simplification attempt " << total_attempts;
 
-    XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                         ParsePackage(knownf_ir_text));
+    if (package == nullptr) {
+      XLS_ASSIGN_OR_RETURN(package, ParsePackage(knownf_ir_text));
+    }
+    XLS_ASSIGN_OR_RETURN(std::unique_ptr<PackageSnapshot> snapshot,
+                         PackageSnapshot::Create(package.get()));
     FunctionBase* candidate = package->GetTop().value();
     XLS_VLOG_LINES(2,
                    "=== Candidate for simplification:\n" + candidate->DumpIr());
@@ -829,6 +852,7 @@ absl::Status RealMain(std::string_view path,
     if (simplification == SimplificationResult::kDidNotChange) {
       XLS_VLOG(1) << "Did not change the sample.";
       failed_simplification_attempts++;
+      XLS_RETURN_IF_ERROR(Undo(snapshot.get(), &package));
       continue;
     }
     XLS_LOG(INFO) << "Trying " << which_transform;
@@ -851,6 +875,7 @@ absl::Status RealMain(std::string_view path,
       // That simplification caused it to stop failing, but keep going with the
       // last known failing version and seeing if we can find something else
       // from there.
+      XLS_RETURN_IF_ERROR(Undo(snapshot.get(), &package));
       continue;
     }
 
@@ -869,6 +894,12 @@ absl::Status RealMain(std::string_view path,
               << (candidate->node_count() > 50 ? "" : candidate->DumpIr())
               << "(" << candidate->node_count() << " nodes)" << std::endl;
 
+    // Reparse the new known failing sample so the node order and ids of the
+    // package match its IR text. Simplifications are mostly rejected so this
+    // is rare compared to rolling back.
+    snapshot->Commit();
+    package.reset();
+
     failed_simplification_attempts = 0;
   }
 
@@ -14,6 +14,9 @@
 
 #include "xls/tools/opt.h"
 
+#include <memory>
+
+#include "xls/common/thread_pool.h"
 #include "xls/dslx/ir_converter.h"
 #include "xls/dslx/parse_and_typecheck.h"
 #include "xls/ir/ir_parser.h"
@@ -23,8 +26,8 @@
 
 namespace xls::tools {
 
-absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
-                                             const OptOptions& options) {
+absl::Status OptimizeIrForTop(Package* package, const OptOptions& options,
+                              PassResults* results) {
   if (!options.top.empty()) {
     XLS_VLOG(3) << "OptimizeIrForEntry; top: '" << options.top
                 << "'; opt_level: " << options.opt_level;
@@ -32,8 +35,6 @@ absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
     XLS_VLOG(3) << "OptimizeIrForEntry; opt_level: " << options.opt_level;
   }
 
-  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
-                       Parser::ParsePackage(ir, options.ir_path));
   if (!options.top.empty()) {
     XLS_RETURN_IF_ERROR(package->SetTopByName(options.top));
   }
@@ -51,13 +52,26 @@ absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
       .skip_passes = options.skip_passes,
       .inline_procs = options.inline_procs,
       .convert_array_index_to_select = options.convert_array_index_to_select,
+      .function_thread_pool =
+          options.function_threads > 1
+              ? std::make_shared<ThreadPool>(options.function_threads)
+              : nullptr,
   };
-  PassResults results;
-  XLS_RETURN_IF_ERROR(
-      pipeline->Run(package.get(), pass_options, &results).status());
+  PassResults local_results;
+  if (results == nullptr) {
+    results = &local_results;
+  }
+  XLS_RETURN_IF_ERROR(pipeline->Run(package, pass_options, results).status());
   // If opt returns something that obviously can't be codegenned, that's a bug
   // in opt, not codegen.
-  XLS_RETURN_IF_ERROR(xls::VerifyPackage(package.get(), /*codegen=*/true));
+  return xls::VerifyPackage(package, /*codegen=*/true);
+}
+
+absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
+                                             const OptOptions& options) {
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       Parser::ParsePackage(ir, options.ir_path));
+  XLS_RETURN_IF_ERROR(OptimizeIrForTop(package.get(), options));
   return package->DumpIr();
 }
 
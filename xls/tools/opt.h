@@ -21,8 +21,10 @@
 #include <string>
 #include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "xls/ir/package.h"
 
 // TODO(meheff): 2021-10-04 Remove this header.
 #include "xls/passes/passes.h"
@@ -40,6 +42,9 @@ struct OptOptions {
   std::vector<std::string> skip_passes;
   std::optional<int64_t> convert_array_index_to_select = std::nullopt;
   bool inline_procs;
+  // Number of threads with which functions and procs are optimized
+  // concurrently (see PassOptions::function_thread_pool).
+  int64_t function_threads = 1;
 };
 
 // Helper used in the opt_main tool, optimizes the given IR for a particular
@@ -48,6 +53,12 @@ struct OptOptions {
 absl::StatusOr<std::string> OptimizeIrForTop(std::string_view ir,
                                              const OptOptions& options);
 
+// As above, but optimizes the given package in place. If `results` is given,
+// the metadata of the pass pipeline run (pass invocations, fixed-point
+// iterations, etc.) is written to it.
+absl::Status OptimizeIrForTop(Package* package, const OptOptions& options,
+                              PassResults* results = nullptr);
+
 }  // namespace xls::tools
 
 #endif  // XLS_TOOLS_OPT_H_
@@ -15,6 +15,10 @@
 // Takes in an IR file and produces an IR file that has been run through the
 // standard optimization pipeline.
 
+#include <algorithm>
+#include <iostream>
+#include <thread>  // NOLINT
+
 #include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "xls/common/file/filesystem.h"
@@ -25,13 +29,15 @@
 #include "xls/ir/package.h"
 #include "xls/passes/passes.h"
 #include "xls/passes/standard_pipeline.h"
+#include "xls/tools/ir_io.h"
 #include "xls/tools/opt.h"
 
 const char kUsage[] = R"(
 Takes in an IR file and produces an IR file that has been run through the
 standard optimization pipeline.
 
-Successfully optimized IR is printed to stdout.
+Successfully optimized IR is printed to stdout, as text unless
+--output_format=binary is given.
 
 Expected invocation:
   opt_main <IR file>
@@ -64,7 +70,20 @@ ABSL_FLAG(int64_t, opt_level, xls::kMaxOptLevel,
                           xls::kMaxOptLevel));
 ABSL_FLAG(bool, inline_procs, false,
           "Whether to inline all procs by calling the proc inlining pass. ");
+ABSL_FLAG(std::string, input_format, "auto",
+          "Format of the input IR file: auto (detect from the contents), "
+          "text or binary.");
+ABSL_FLAG(std::string, output_format, "text",
+          "Format of the optimized IR printed to stdout: text or binary.");
+ABSL_FLAG(int64_t, opt_threads, 1,
+          "Number of threads with which independent functions and procs are "
+          "optimized concurrently. Zero uses one thread per core. Node ids in "
+          "the optimized IR may vary between runs with more than one thread.");
 // LINT.ThenChange(//xls/build_rules/xls_ir_rules.bzl)
+ABSL_FLAG(bool, print_pass_stats, false,
+          "If true, print statistics of the optimization run (pass "
+          "invocations, fixed-point iterations, and nodes visited by worklist "
+          "rewrites) to stderr.");
 
 namespace xls::tools {
 namespace {
@@ -73,13 +92,22 @@ absl::Status RealMain(std::string_view input_path) {
   if (input_path == "-") {
     input_path = "/dev/stdin";
   }
-  XLS_ASSIGN_OR_RETURN(std::string ir, GetFileContents(input_path));
+  XLS_ASSIGN_OR_RETURN(IrFormat input_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_input_format)));
+  XLS_ASSIGN_OR_RETURN(IrFormat output_format,
+                       IrFormatFromString(absl::GetFlag(FLAGS_output_format)));
+  XLS_ASSIGN_OR_RETURN(std::unique_ptr<Package> package,
+                       ReadPackageFile(input_path, input_format));
   std::string top = absl::GetFlag(FLAGS_top);
   std::string ir_dump_path = absl::GetFlag(FLAGS_ir_dump_path);
   std::vector<std::string> run_only_passes =
       absl::GetFlag(FLAGS_run_only_passes);
   int64_t convert_array_index_to_select =
       absl::GetFlag(FLAGS_convert_array_index_to_select);
+  int64_t opt_threads = absl::GetFlag(FLAGS_opt_threads);
+  if (opt_threads <= 0) {
+    opt_threads = std::max<int64_t>(1, std::thread::hardware_concurrency());
+  }
   const OptOptions options = {
       .opt_level = absl::GetFlag(FLAGS_opt_level),
       .top = top,
@@ -93,9 +121,25 @@ absl::Status RealMain(std::string_view input_path) {
               ? std::nullopt
               : std::make_optional(convert_array_index_to_select),
       .inline_procs = absl::GetFlag(FLAGS_inline_procs),
+      .function_threads = opt_threads,
   };
+  PassResults results;
+  XLS_RETURN_IF_ERROR(
+      tools::OptimizeIrForTop(package.get(), options, &results));
+  if (absl::GetFlag(FLAGS_print_pass_stats)) {
+    int64_t changed_count = 0;
+    for (const PassInvocation& invocation : results.invocations) {
+      changed_count += invocation.ir_changed ? 1 : 0;
+    }
+    std::cerr << absl::StreamFormat(
+        "Pass invocations: %d (%d changed the IR)\n"
+        "Fixed-point iterations: %d\n"
+        "Worklist node visits: %d\n",
+        results.invocations.size(), changed_count,
+        results.fixed_point_iterations, results.rewrite_node_visits);
+  }
   XLS_ASSIGN_OR_RETURN(std::string opt_ir,
-                       tools::OptimizeIrForTop(ir, options));
+                       SerializePackage(*package, output_format));
   std::cout << opt_ir;
   return absl::OkStatus();
 }
@@ -87,6 +87,20 @@ class OptMainTest(test_base.TestCase):
     # Without running DFE, the dead function should remain in the IR.
     self.assertIn('dead_function', optimized_ir)
 
+  def test_print_pass_stats(self):
+    ir_file = self.create_tempfile(content=ADD_ZERO_IR)
+
+    result = subprocess.run(
+        [OPT_MAIN_PATH, '--print_pass_stats', ir_file.full_path],
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        check=True)
+
+    self.assertIn('ret x', result.stdout.decode('utf-8'))
+    stats = result.stderr.decode('utf-8')
+    self.assertIn('Fixed-point iterations:', stats)
+    self.assertIn('Worklist node visits:', stats)
+
   def test_skip_dfe(self):
     ir_file = self.create_tempfile(content=DEAD_FUNCTION_IR)
 
@@ -128,6 +142,30 @@ class OptMainTest(test_base.TestCase):
     self.assertIn('bits[32] = add', optimized_ir)
     self.assertNotIn('concat', optimized_ir)
 
+  def test_binary_format(self):
+    ir_file = self.create_tempfile(content=ADD_ZERO_IR)
+
+    binary_ir = subprocess.check_output(
+        [OPT_MAIN_PATH, '--output_format=binary', ir_file.full_path])
+    self.assertTrue(binary_ir.startswith(b'XLSIRBIN'))
+    binary_file = self.create_tempfile(content=binary_ir, mode='wb')
+
+    # The binary output is detected automatically and can be read back.
+    for input_format in ('auto', 'binary'):
+      optimized_ir = subprocess.check_output([
+          OPT_MAIN_PATH, f'--input_format={input_format}',
+          binary_file.full_path
+      ]).decode('utf-8')
+      self.assertIn('ret x', optimized_ir)
+
+    # Binary input is rejected when text is requested.
+    comp = subprocess.run(
+        [OPT_MAIN_PATH, '--input_format=text', binary_file.full_path],
+        stderr=subprocess.PIPE,
+        check=False)
+    self.assertNotEqual(comp.returncode, 0)
+    self.assertIn('Expected text IR', comp.stderr.decode('utf-8'))
+
 
 if __name__ == '__main__':
   test_base.main()
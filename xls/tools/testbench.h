@@ -19,10 +19,12 @@
 #include <functional>
 #include <thread>  // NOLINT(build/c++11)
 #include <type_traits>
+#include <vector>
 
 #include "absl/base/internal/sysinfo.h"
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "xls/common/file/filesystem.h"
 #include "xls/tools/testbench_thread.h"
 
@@ -71,6 +73,10 @@ class Testbench : public internal::TestbenchBase<InputT, ResultT, ShardDataT> {
   //                     are considered equivalent.
   //   log_errors      : The function to log errors when compare_results returns
   //                     false.
+  //   compute_actual_batch: Optional. The function to call to calculate the XLS
+  //                     results of a batch of inputs, e.g., with
+  //                     FunctionJit::RunBatched. If given, it is used instead
+  //                     of compute_actual.
   //
   // All lambdas must be thread-safe.
   //
@@ -85,18 +91,23 @@ class Testbench : public internal::TestbenchBase<InputT, ResultT, ShardDataT> {
             std::function<ResultT(ShardDataT*, InputT)> compute_expected,
             std::function<ResultT(ShardDataT*, InputT)> compute_actual,
             std::function<bool(ResultT, ResultT)> compare_results,
-            std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors)
+            std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors,
+            std::function<std::vector<ResultT>(ShardDataT*,
+                                               absl::Span<const InputT>)>
+                compute_actual_batch = nullptr)
       : internal::TestbenchBase<InputT, ResultT, ShardDataT>(
             start, end, num_threads, max_failures, index_to_input,
             compare_results, log_errors),
         create_shard_(create_shard),
         compute_expected_(compute_expected),
-        compute_actual_(compute_actual) {
+        compute_actual_(compute_actual),
+        compute_actual_batch_(compute_actual_batch) {
     this->thread_create_fn_ = [this](uint64_t start, uint64_t end) {
       return std::make_unique<TestbenchThread<InputT, ResultT, ShardDataT>>(
           &this->mutex_, &this->wake_me_, start, end, this->max_failures_,
           this->index_to_input_, create_shard_, compute_expected_,
-          compute_actual_, this->compare_results_, this->log_errors_);
+          compute_actual_, this->compare_results_, this->log_errors_,
+          compute_actual_batch_);
     };
   }
 
@@ -104,6 +115,8 @@ class Testbench : public internal::TestbenchBase<InputT, ResultT, ShardDataT> {
   std::function<std::unique_ptr<ShardDataT>()> create_shard_;
   std::function<ResultT(ShardDataT*, InputT)> compute_expected_;
   std::function<ResultT(ShardDataT*, InputT)> compute_actual_;
+  std::function<std::vector<ResultT>(ShardDataT*, absl::Span<const InputT>)>
+      compute_actual_batch_;
 };
 
 // Shard-data-less implementation.
@@ -118,23 +131,28 @@ class Testbench<InputT, ResultT, ShardDataT,
             std::function<ResultT(InputT)> compute_expected,
             std::function<ResultT(InputT)> compute_actual,
             std::function<bool(ResultT, ResultT)> compare_results,
-            std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors)
+            std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors,
+            std::function<std::vector<ResultT>(absl::Span<const InputT>)>
+                compute_actual_batch = nullptr)
       : internal::TestbenchBase<InputT, ResultT, ShardDataT>(
             start, end, num_threads, max_failures, index_to_input,
             compare_results, log_errors),
         compute_expected_(compute_expected),
-        compute_actual_(compute_actual) {
+        compute_actual_(compute_actual),
+        compute_actual_batch_(compute_actual_batch) {
     this->thread_create_fn_ = [this](uint64_t start, uint64_t end) {
       return std::make_unique<TestbenchThread<InputT, ResultT, ShardDataT>>(
           &this->mutex_, &this->wake_me_, start, end, this->max_failures_,
           this->index_to_input_, compute_expected_, compute_actual_,
-          this->compare_results_, this->log_errors_);
+          this->compare_results_, this->log_errors_, compute_actual_batch_);
     };
   }
 
  private:
   std::function<ResultT(InputT)> compute_expected_;
   std::function<ResultT(InputT)> compute_actual_;
+  std::function<std::vector<ResultT>(absl::Span<const InputT>)>
+      compute_actual_batch_;
 };
 
 // INTERNAL IMPL ---------------------------------
@@ -39,9 +39,11 @@
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <vector>
 
 #include "absl/strings/str_format.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "xls/tools/testbench.h"
 #include "xls/tools/testbench_builder_helpers.h"
 
@@ -54,6 +56,8 @@ class TestbenchBuilder {
  public:
   using CompareResultsFnT = std::function<bool(const ResultT&, const ResultT&)>;
   using ComputeFnT = std::function<ResultT(ShardDataT*, InputT)>;
+  using ComputeBatchFnT = std::function<std::vector<ResultT>(
+      ShardDataT*, absl::Span<const InputT>)>;
   using CreateShardDataFnT = std::function<std::unique_ptr<ShardDataT>()>;
   using IndexToInputFnT = std::function<InputT(int64_t)>;
   using LogErrorsFnT = std::function<void(int64_t, InputT, ResultT, ResultT)>;
@@ -71,6 +75,14 @@ class TestbenchBuilder {
     return *this;
   }
 
+  // Sets a function which computes the actual results of a batch of inputs,
+  // e.g., with FunctionJit::RunBatched. If set, it is used instead of the
+  // compute_actual function given at construction.
+  TestbenchBuilder& SetComputeActualBatchFn(const ComputeBatchFnT& fn) {
+    compute_actual_batch_ = fn;
+    return *this;
+  }
+
   TestbenchBuilder& SetIndexToInputFn(const IndexToInputFnT& fn) {
     index_to_input_ = fn;
     return *this;
@@ -114,6 +126,7 @@ class TestbenchBuilder {
   int64_t max_failures_ = 1;
   ComputeFnT compute_expected_;
   ComputeFnT compute_actual_;
+  ComputeBatchFnT compute_actual_batch_;
   std::optional<CompareResultsFnT> compare_results_;
   CreateShardDataFnT create_shard_data_;
   std::optional<IndexToInputFnT> index_to_input_;
@@ -130,6 +143,8 @@ class TestbenchBuilder<
  public:
   using CompareResultsFnT = std::function<bool(const ResultT&, const ResultT&)>;
   using ComputeFnT = std::function<ResultT(InputT)>;
+  using ComputeBatchFnT =
+      std::function<std::vector<ResultT>(absl::Span<const InputT>)>;
   using IndexToInputFnT = std::function<InputT(int64_t)>;
   using LogErrorsFnT = std::function<void(int64_t, InputT, ResultT, ResultT)>;
   using PrintInputFnT = std::function<std::string(const InputT&)>;
@@ -143,6 +158,14 @@ class TestbenchBuilder<
     return *this;
   }
 
+  // Sets a function which computes the actual results of a batch of inputs,
+  // e.g., with FunctionJit::RunBatched. If set, it is used instead of the
+  // compute_actual function given at construction.
+  TestbenchBuilder& SetComputeActualBatchFn(const ComputeBatchFnT& fn) {
+    compute_actual_batch_ = fn;
+    return *this;
+  }
+
   TestbenchBuilder& SetIndexToInputFn(const IndexToInputFnT& fn) {
     index_to_input_ = fn;
     return *this;
@@ -186,6 +209,7 @@ class TestbenchBuilder<
   int64_t max_failures_ = 1;
   ComputeFnT compute_expected_;
   ComputeFnT compute_actual_;
+  ComputeBatchFnT compute_actual_batch_;
   std::optional<CompareResultsFnT> compare_results_;
   std::optional<IndexToInputFnT> index_to_input_;
   std::optional<PrintInputFnT> print_input_;
@@ -230,7 +254,8 @@ TestbenchBuilder<InputT, ResultT, ShardDataT, EnableT>::Build() {
   return Testbench<InputT, ResultT, ShardDataT>(
       /*start=*/0, this->num_samples_, this->num_threads_, this->max_failures_,
       index_to_input, create_shard_data_, this->compute_expected_,
-      this->compute_actual_, compare_results, log_errors);
+      this->compute_actual_, compare_results, log_errors,
+      this->compute_actual_batch_);
 }
 
 // Non-shard-data-containing Build() implementation.
@@ -270,7 +295,7 @@ Testbench<InputT, ResultT> TestbenchBuilder<
   return Testbench<InputT, ResultT, ShardDataT>(
       /*start=*/0, this->num_samples_, this->num_threads_, this->max_failures_,
       index_to_input, this->compute_expected_, this->compute_actual_,
-      compare_results, log_errors);
+      compare_results, log_errors, this->compute_actual_batch_);
 }
 
 }  // namespace xls
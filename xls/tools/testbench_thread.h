@@ -15,12 +15,15 @@
 #ifndef XLS_TOOLS_TESTBENCH_THREAD_H_
 #define XLS_TOOLS_TESTBENCH_THREAD_H_
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "xls/common/thread.h"
 #include "xls/ir/package.h"
 
@@ -52,6 +55,9 @@ class TestbenchThread
   //  - generate_expected: Given an input, generates the "expected" value.
   //  - generate_actual: Given an input, generates a value from the module
   //                     under test.
+  //  - generate_actual_batch: Optional. Given a batch of inputs, generates the
+  //                           values from the module under test. If given,
+  //                           this is used instead of generate_actual.
   TestbenchThread(
       absl::Mutex* wake_parent_mutex, absl::CondVar* wake_parent,
       uint64_t start_index, uint64_t end_index, uint64_t max_failures,
@@ -60,13 +66,16 @@ class TestbenchThread
       std::function<ResultT(ShardDataT*, InputT)> generate_expected,
       std::function<ResultT(ShardDataT*, InputT)> generate_actual,
       std::function<bool(ResultT, ResultT)> compare_results,
-      std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors)
+      std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors,
+      std::function<std::vector<ResultT>(ShardDataT*, absl::Span<const InputT>)>
+          generate_actual_batch = nullptr)
       : TestbenchThreadBase<InputT, ResultT, ShardDataT>(
             wake_parent_mutex, wake_parent, start_index, end_index,
             max_failures, index_to_input, compare_results, log_errors),
         create_shard_fn_(create_shard),
         generate_expected_(generate_expected),
-        generate_actual_(generate_actual) {
+        generate_actual_(generate_actual),
+        generate_actual_batch_(generate_actual_batch) {
     this->generate_expected_fn_ = [this](InputT& input) {
       return generate_expected_(shard_data_.get(), input);
     };
@@ -74,6 +83,13 @@ class TestbenchThread
     this->generate_actual_fn_ = [this](InputT& input) {
       return generate_actual_(shard_data_.get(), input);
     };
+
+    if (generate_actual_batch_) {
+      this->generate_actual_batch_fn_ =
+          [this](absl::Span<const InputT> inputs) {
+            return generate_actual_batch_(shard_data_.get(), inputs);
+          };
+    }
   }
 
   void Init() override { shard_data_ = create_shard_fn_(); }
@@ -83,6 +99,8 @@ class TestbenchThread
   std::function<std::unique_ptr<ShardDataT>()> create_shard_fn_;
   std::function<ResultT(ShardDataT*, InputT)> generate_expected_;
   std::function<ResultT(ShardDataT*, InputT)> generate_actual_;
+  std::function<std::vector<ResultT>(ShardDataT*, absl::Span<const InputT>)>
+      generate_actual_batch_;
 };
 
 // And the without-shard-data case.
@@ -99,12 +117,15 @@ class TestbenchThread<
       std::function<ResultT(InputT)> generate_expected,
       std::function<ResultT(InputT)> generate_actual,
       std::function<bool(ResultT, ResultT)> compare_results,
-      std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors)
+      std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors,
+      std::function<std::vector<ResultT>(absl::Span<const InputT>)>
+          generate_actual_batch = nullptr)
       : TestbenchThreadBase<InputT, ResultT, ShardDataT>(
             wake_parent_mutex, wake_parent, start_index, end_index,
             max_failures, index_to_input, compare_results, log_errors),
         generate_expected_(generate_expected),
         generate_actual_(generate_actual) {
+    this->generate_actual_batch_fn_ = generate_actual_batch;
     this->generate_expected_fn_ = [this](InputT& input) {
       return generate_expected_(input);
     };
@@ -148,6 +169,10 @@ class TestbenchThreadBase {
 
   virtual ~TestbenchThreadBase() = default;
 
+  // The number of samples passed to each call of the batched result
+  // generation function, if any.
+  static constexpr uint64_t kBatchSize = 1024;
+
   // Starts the thread. Silently returns if it's already running.
   // If the tax of calling index_to_input_ every iter is too high, we can
   // specialize this for simple cases, like uint64_t -> uint64_t.
@@ -173,25 +198,23 @@ class TestbenchThreadBase {
     }
 
     running_.store(true);
-    for (uint64_t i = start_index_; i < end_index_; i++) {
-      // Don't check for cancelled on every iteration; it's a touch slow.
-      if (i % 128 == 0 && cancelled_.load()) {
-        return_status = absl::CancelledError("This thread was cancelled.");
-        break;
-      }
+    if (generate_actual_batch_fn_) {
+      return_status = RunBatches();
+    } else {
+      for (uint64_t i = start_index_; i < end_index_; i++) {
+        // Don't check for cancelled on every iteration; it's a touch slow.
+        if (i % 128 == 0 && cancelled_.load()) {
+          return_status = absl::CancelledError("This thread was cancelled.");
+          break;
+        }
 
-      InputT input = index_to_input_(i);
-      ResultT expected = generate_expected_fn_(input);
-      ResultT actual = generate_actual_fn_(input);
-      if (!compare_results_(expected, actual)) {
-        num_failures_.store(num_failures_.load() + 1);
-        log_errors_(i, input, expected, actual);
-        if (max_failures_ <= num_failures_.load()) {
-          return_status = absl::UnknownError("Maximum error count reached.");
+        InputT input = index_to_input_(i);
+        ResultT expected = generate_expected_fn_(input);
+        ResultT actual = generate_actual_fn_(input);
+        return_status = CheckResult(i, input, expected, actual);
+        if (!return_status.ok()) {
           break;
         }
-      } else {
-        num_passes_.store(num_passes_.load() + 1);
       }
     }
 
@@ -207,6 +230,50 @@ class TestbenchThreadBase {
   // data.
   virtual void Init() {}
 
+  // Evaluates the samples in batches of kBatchSize with
+  // generate_actual_batch_fn_.
+  absl::Status RunBatches() {
+    std::vector<InputT> inputs;
+    for (uint64_t batch_start = start_index_; batch_start < end_index_;
+         batch_start += kBatchSize) {
+      if (cancelled_.load()) {
+        return absl::CancelledError("This thread was cancelled.");
+      }
+      uint64_t batch_end = std::min(batch_start + kBatchSize, end_index_);
+      inputs.clear();
+      for (uint64_t i = batch_start; i < batch_end; i++) {
+        inputs.push_back(index_to_input_(i));
+      }
+      std::vector<ResultT> actuals = generate_actual_batch_fn_(inputs);
+      for (uint64_t i = 0; i < inputs.size(); i++) {
+        ResultT expected = generate_expected_fn_(inputs[i]);
+        absl::Status status =
+            CheckResult(batch_start + i, inputs[i], expected, actuals[i]);
+        if (!status.ok()) {
+          return status;
+        }
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Compares the expected and actual results of the sample with the given
+  // index and updates the bookkeeping. Returns an error if the maximum number
+  // of failures has been reached.
+  absl::Status CheckResult(uint64_t index, InputT& input,
+                           const ResultT& expected, const ResultT& actual) {
+    if (!compare_results_(expected, actual)) {
+      num_failures_.store(num_failures_.load() + 1);
+      log_errors_(index, input, expected, actual);
+      if (max_failures_ <= num_failures_.load()) {
+        return absl::UnknownError("Maximum error count reached.");
+      }
+    } else {
+      num_passes_.store(num_passes_.load() + 1);
+    }
+    return absl::OkStatus();
+  }
+
   void Join() {
     if (thread_) {
       thread_->Join();
@@ -264,6 +331,9 @@ class TestbenchThreadBase {
   std::function<InputT(uint64_t)> index_to_input_;
   std::function<ResultT(InputT&)> generate_expected_fn_;
   std::function<ResultT(InputT&)> generate_actual_fn_;
+  // If set, used instead of generate_actual_fn_ to evaluate batches of inputs.
+  std::function<std::vector<ResultT>(absl::Span<const InputT>)>
+      generate_actual_batch_fn_;
   std::function<bool(ResultT, ResultT)> compare_results_;
   std::function<void(int64_t, InputT, ResultT, ResultT)> log_errors_;
 